@@ -92,6 +92,7 @@ macro(GEN_m4 filename)
       OUTPUT ${dest}
       COMMAND ${NC_M4}
       ARGS ${M4FLAGS} ${CMAKE_CURRENT_SOURCE_DIR}/${filename}.m4 > ${dest}
+      DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/${filename}.m4
       VERBATIM
       )
 
@@ -61,11 +61,31 @@
 /* forward */
 struct NCauth;
 
+/** Counters of the open dataset cache of a file. */
+typedef struct NC_HDF5_DSSTATS {
+   unsigned long long hits;      /* dataset already open when used */
+   unsigned long long opens;     /* datasets opened */
+   unsigned long long reopens;   /* opens of a dataset closed by eviction */
+   unsigned long long evictions; /* datasets closed to stay under the cap */
+   size_t nopen;                 /* datasets open now */
+   size_t maxopen;               /* the cap; 0 => no cap */
+} NC_HDF5_DSSTATS;
+
 /** Struct to hold HDF5-specific info for the file. */
 typedef struct NC_HDF5_FILE_INFO {
    hid_t hdfid;
    unsigned transientid; /* counter for transient ids */
    NCURI* uri; /* Parse of the incoming path, if url */
+   /* Vars whose dataset is open, most recently used first. Kept only
+      if the no. of open datasets is capped; see nc4_hdf5_use_dataset() */
+   struct NC_HDF5_DSCACHE {
+      NC_VAR_INFO_T *mru;
+      NC_VAR_INFO_T *lru;
+      NC_HDF5_DSSTATS stats;
+   } dscache;
+   /* With NC_LAZYGROUPS, true once the ids not stored in the file are
+      handed out above the largest stored one */
+   nc_bool_t stored_dimids_reserved;
 #if defined(NETCDF_ENABLE_BYTERANGE)
    int byterange;
 #endif
@@ -91,12 +111,17 @@ typedef struct  NC_HDF5_ATT_INFO
 typedef struct NC_HDF5_GRP_INFO
 {
     hid_t hdf_grpid;
+    int readstat;   /* Error reading a lazy group, returned on every use */
 } NC_HDF5_GRP_INFO_T;
 
 /* Struct to hold HDF5-specific info for a variable. */
 typedef struct NC_HDF5_VAR_INFO
 {
     hid_t hdf_datasetid;
+    NC_VAR_INFO_T *dsprev;      /* LRU list of open datasets */
+    NC_VAR_INFO_T *dsnext;
+    int dspins;                 /* > 0 => dataset in use, not evicted */
+    nc_bool_t dsevicted;        /* dataset was closed by eviction */
     HDF5_OBJID_T *dimscale_hdf5_objids;
     nc_bool_t dimscale;          /**< True if var is a dimscale. */
     nc_bool_t *dimscale_attached;  /**< Array of flags that are true if dimscale is attached for that dim index. */
@@ -138,6 +163,15 @@ int nc4_adjust_var_cache(NC_GRP_INFO_T *grp, NC_VAR_INFO_T * var);
 /* Open a HDF5 dataset. */
 int nc4_open_var_grp2(NC_GRP_INFO_T *grp, int varid, hid_t *dataset);
 
+/* The cache of open datasets. */
+int nc4_hdf5_open_dataset(NC_VAR_INFO_T *var, hid_t *datasetidp);
+int nc4_hdf5_use_dataset(NC_VAR_INFO_T *var);
+int nc4_hdf5_add_dataset(NC_VAR_INFO_T *var);
+void nc4_hdf5_pin_dataset(NC_VAR_INFO_T *var);
+int nc4_hdf5_unpin_dataset(NC_VAR_INFO_T *var);
+void nc4_hdf5_forget_dataset(NC_VAR_INFO_T *var);
+int nc4_hdf5_get_dataset_stats(int ncid, NC_HDF5_DSSTATS *statsp);
+
 /* Find types. */
 NC_TYPE_INFO_T *nc4_rec_find_hdf_type(NC_FILE_INFO_T* h5,
                                       hid_t target_hdf_typeid);
@@ -208,6 +242,12 @@ int NC4_hdf5_addfilter(NC_VAR_INFO_T* var, unsigned int id, size_t nparams, cons
 int NC4_hdf5_filter_freelist(NC_VAR_INFO_T* var);
 int NC4_hdf5_find_missing_filter(NC_VAR_INFO_T* var, unsigned int* idp);
 
+/* Raw chunk access (H5Dread_chunk/H5Dwrite_chunk); see nc_get_chunk_raw() */
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+int NC4_HDF5_get_chunk_raw(int ncid, int varid, const size_t *startp, unsigned int *filtermaskp, size_t *sizep, void **datap);
+int NC4_HDF5_put_chunk_raw(int ncid, int varid, const size_t *startp, unsigned int filtermask, size_t size, const void *data);
+#endif
+
 /* Add an attribute to the attribute list. */
 int nc4_put_att(NC_GRP_INFO_T* grp, int varid, const char *name, nc_type file_type,
 		size_t len, const void *data, nc_type mem_type, int force);
@@ -27,6 +27,8 @@ typedef struct NC {
 	void* dispatchdata; /*per-'file' data; points to e.g. NC3_INFO data*/
 	char* path;
 	int   mode; /* as provided to nc_open/nc_create */
+	void* lock; /* per-file mutex (NETCDF_ENABLE_THREADSAFE); NULL => use the global lock */
+	struct NCnbqueue* nbqueue; /* pending nonblocking requests (dnonblock.c); NULL => none */
 } NC;
 
 /*
@@ -73,10 +75,45 @@ extern void free_NCList(void);/* reclaim whole list */
 extern int count_NCList(void); /* return # of entries in NClist */
 extern int iterate_NCList(int i,NC**); /* Walk from 0 ...; ERANGE return => stop */
 
+/* Defined in dnonblock.c */
+extern int NC_nbcomplete(NC*); /* complete all pending requests */
+extern void NC_nbdiscard(NC*); /* drop all pending requests */
+
 /* Defined in nc.c */
 extern void free_NC(NC*);
 extern int new_NC(const struct NC_Dispatch*, const char*, int, NC**);
 
+/* Locking for the thread-safe library; see docs/threadsafe.md.
+   The global lock is recursive and protects the state shared
+   by all files (file list, rc info, plugin table, ...); the file
+   lock protects one open file, and is the global lock itself
+   for formats whose implementation is not reentrant.
+   Lock order: file lock, then global lock.
+   Without NETCDF_ENABLE_THREADSAFE, these macros are empty. */
+#ifdef NETCDF_ENABLE_THREADSAFE
+/* Defined in dglobal.c */
+extern void NC_lock(void);
+extern void NC_unlock(void);
+/* Defined in nc.c */
+extern void NC_lockfile(NC*);
+extern void NC_unlockfile(NC*);
+extern void NC_lockfiles(NC*,NC*);
+extern void NC_unlockfiles(NC*,NC*);
+#define NCLOCK() NC_lock()
+#define NCUNLOCK() NC_unlock()
+#define NCLOCKFILE(ncp) NC_lockfile(ncp)
+#define NCUNLOCKFILE(ncp) NC_unlockfile(ncp)
+#define NCLOCKFILES(ncp1,ncp2) NC_lockfiles(ncp1,ncp2)
+#define NCUNLOCKFILES(ncp1,ncp2) NC_unlockfiles(ncp1,ncp2)
+#else
+#define NCLOCK()
+#define NCUNLOCK()
+#define NCLOCKFILE(ncp)
+#define NCUNLOCKFILE(ncp)
+#define NCLOCKFILES(ncp1,ncp2)
+#define NCUNLOCKFILES(ncp1,ncp2)
+#endif
+
 /* Defined in dinstance_intern.c */
 
 /**************************************************/
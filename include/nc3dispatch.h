@@ -172,8 +172,36 @@ extern "C" {
                  const size_t *start, const size_t *count,
                  void *value, nc_type);
 
+    extern int
+    NC3_put_vars(int ncid, int varid,
+                 const size_t *start, const size_t *count,
+                 const ptrdiff_t *stride,
+                 const void *value, nc_type);
+
+    extern int
+    NC3_get_vars(int ncid, int varid,
+                 const size_t *start, const size_t *count,
+                 const ptrdiff_t *stride,
+                 void *value, nc_type);
+
+    extern int
+    NC3_put_varm(int ncid, int varid,
+                 const size_t *start, const size_t *count,
+                 const ptrdiff_t *stride, const ptrdiff_t *imap,
+                 const void *value, nc_type);
+
+    extern int
+    NC3_get_varm(int ncid, int varid,
+                 const size_t *start, const size_t *count,
+                 const ptrdiff_t *stride, const ptrdiff_t *imap,
+                 void *value, nc_type);
+
 /* End _var */
 
+/* Complete a batch of nonblocking requests (see dnonblock.c) */
+    extern int
+    NC3_wait(NC* ncp, size_t nreqs, struct NCnbreq** reqs);
+
     extern int NC3_initialize(void);
     extern int NC3_finalize(void);
 
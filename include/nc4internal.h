@@ -254,6 +254,7 @@ typedef struct NC_GRP_INFO
     struct NC_FILE_INFO *nc4_info; /**< Pointer containing NC_FILE_INFO_T. */
     struct NC_GRP_INFO *parent;  /**< Pointer tp parent group. */
     int atts_read;               /**< True if atts have been read for this group. */
+    nc_bool_t lazy;              /**< True if the contents have not been read yet. */
     NCindex* children;           /**< NCindex<struct NC_GRP_INFO*> */
     NCindex* dim;                /**< NCindex<NC_DIM_INFO_T> * */
     NCindex* att;                /**< NCindex<NC_ATT_INFO_T> * */
@@ -296,6 +297,7 @@ typedef struct NC_FILE_INFO
     NClist *alltypes;  /**< List of all types. */
     NClist *allgroups; /**< List of all groups, including root group. */
     void *format_file_info; /**< Pointer to binary format info for file. */
+    int (*read_grp)(NC_GRP_INFO_T *grp); /**< Reads the contents of a lazy group. */
     NC4_Provenance provenance; /**< File provenence info. */
     struct NC4_Memio
     {
@@ -336,6 +338,7 @@ extern int nc4_find_nc_grp_h5(int ncid, NC **nc, NC_GRP_INFO_T **grp,
                        NC_FILE_INFO_T **h5);
 extern int nc4_find_grp_h5(int ncid, NC_GRP_INFO_T **grp, NC_FILE_INFO_T **h5);
 extern int nc4_find_nc4_grp(int ncid, NC_GRP_INFO_T **grp);
+extern int nc4_read_lazy_grp(NC_GRP_INFO_T *grp);
 extern int nc4_find_dim(NC_GRP_INFO_T *grp, int dimid, NC_DIM_INFO_T **dim,
                  NC_GRP_INFO_T **dim_grp);
 extern int nc4_find_var(NC_GRP_INFO_T *grp, const char *name, NC_VAR_INFO_T **var);
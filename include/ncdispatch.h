@@ -150,6 +150,21 @@ extern char UDF0_magic_number[NC_MAX_MAGIC_NUMBER_LEN + 1];
 extern NC_Dispatch* UDF1_dispatch_table;
 extern char UDF1_magic_number[NC_MAX_MAGIC_NUMBER_LEN + 1];
 
+/* A nonblocking request posted by nc_iput_vara/nc_iget_vara;
+   the data are transferred by nc_wait_all (see dnonblock.c). */
+typedef struct NCnbreq {
+    int reqid;
+    int isput;
+    int ncid; /* as passed by the caller; may be a group id */
+    int varid;
+    nc_type memtype; /* NC_NAT => the type of the variable */
+    size_t* start; /* |ndims|, copied */
+    size_t* count; /* |ndims|, copied */
+    void* value; /* the caller's buffer; not copied */
+    int stat; /* set when the request is completed */
+    int selected; /* scratch mark used by nc_wait_all */
+} NCnbreq;
+
 /* Prototypes. */
 int NC_check_nulls(int ncid, int varid, const size_t *start, size_t **count,
                    ptrdiff_t **stride);
@@ -219,6 +234,8 @@ EXTERNL char* NC_atomictypename(nc_type xtype);
 extern int NC_getshape(int ncid, int varid, int ndims, size_t* shape);
 extern int NC_is_recvar(int ncid, int varid, size_t* nrecs);
 extern int NC_inq_recvar(int ncid, int varid, int* nrecdims, int* is_recdim);
+/* Defined in dchunk.c; as nc_get_chunk_raw, into malloc'd memory */
+extern int NC_get_chunk_raw(int ncid, int varid, const size_t* startp, unsigned int* filtermaskp, size_t* sizep, void** datap);
 
 #define nullstring(s) (s==NULL?"(null)":s)
 
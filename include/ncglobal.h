@@ -16,6 +16,7 @@ struct NCURI;
 struct NCRCinfo;
 struct NCZ_Plugin;
 struct GlobalAWS;
+struct NCthreadpool;
 
 /**************************************************/
 /* Begin to collect global state info in one place (more to do) */
@@ -38,6 +39,11 @@ typedef struct NCglobalstate {
 	   equivalent since very sparse */
 	struct NCZ_Plugin** loaded_plugins; /*[H5Z_FILTER_MAX+1]*/
 	size_t loaded_plugins_max; /* plugin filter id index. 0<loaded_plugins_max<=H5Z_FILTER_MAX */
+	size_t threads; /* # worker threads for concurrent chunk reads; 0 => read serially */
+	size_t maxinflight; /* max bytes of chunk data fetched concurrently; 0 => unlimited */
+	struct NCthreadpool* threadpool; /* created on first use */
+	size_t sharedcache; /* default chunk cache budget shared by all variables of a file; 0 => per-variable caches */
+	size_t metaprefetch; /* max metadata objects read ahead per batch at open; 0 => no read-ahead */
     } zarr;
     struct GlobalAWS { /* AWS S3 specific parameters/defaults */
 	char* default_region;
@@ -51,6 +51,7 @@ typedef struct NCjson {
 	size_t alloc;
 	size_t len;
 	struct NCjson** contents;
+	struct NCjindex* index; /* sort == DICT: hash of the keys, built on demand; see ncjson.c */
     } list; /* sort == DICT|ARRAY */
 } NCjson;
 
@@ -0,0 +1,67 @@
+/*
+Copyright (c) 1998-2018 University Corporation for Atmospheric Research/Unidata
+See COPYRIGHT for license information.
+*/
+
+#ifndef NCPAGECACHE_H
+#define NCPAGECACHE_H
+
+#include "ncexternl.h"
+#include "ncuri.h"
+
+/*
+A read cache of fixed-size pages of a remote object, shared by the
+byte-range readers (httpio and s3io for classic files, H5FDhttp for
+netCDF-4 files). A read is served from the cached pages; each run of
+adjacent missing pages is fetched with a single ranged request, and
+a miss that continues the previous read also fetches a few pages
+ahead. Reads spanning more pages than the cache holds bypass it.
+*/
+
+/* Read exactly count bytes of the object at offset into buf */
+typedef int NCpagefetch(void* state, size64_t offset, size_t count, void* buf);
+
+typedef struct NCpagestats {
+    unsigned long long hits;     /* pages found in the cache */
+    unsigned long long misses;   /* pages fetched on demand */
+    unsigned long long ahead;    /* pages fetched by readahead */
+    unsigned long long requests; /* ranged requests issued */
+    unsigned long long bytes;    /* bytes fetched */
+} NCpagestats;
+
+typedef struct NCpagecache NCpagecache;
+
+/* Page cache defaults; overridden by the environment or .rc,
+   see ncpagecacheparams() */
+#define NCPAGECACHE_PAGESIZE  ((size_t)64*1024)
+#define NCPAGECACHE_MAXPAGES  ((size_t)64)
+#define NCPAGECACHE_READAHEAD ((size_t)4)
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Get the page size, capacity (in pages) and readahead (in pages) from
+   NC_HTTP_PAGESIZE, NC_HTTP_CACHEPAGES and NC_HTTP_READAHEAD, else from
+   the HTTP.BYTERANGE.* .rc keys matching uri, else the defaults above. */
+EXTERNL void ncpagecacheparams(NCURI* uri, size_t* pagesizep, size_t* maxpagesp, size_t* readaheadp);
+
+/* Create a cache for an object of the given size. pagesize or maxpages
+   of 0 creates a cache that passes every read straight to fetch. */
+EXTERNL int ncpagecachenew(size64_t objsize, size_t pagesize, size_t maxpages, size_t readahead,
+                           NCpagefetch* fetch, void* state, NCpagecache** cachep);
+
+/* Read [offset,offset+count), which must lie within the object, into buf */
+EXTERNL int ncpagecacheread(NCpagecache* cache, size64_t offset, size_t count, void* buf);
+
+/* Return the counters accumulated since the cache was created */
+EXTERNL void ncpagecachestats(const NCpagecache* cache, NCpagestats* statsp);
+
+/* Free the cache and its pages */
+EXTERNL void ncpagecachefree(NCpagecache* cache);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /*NCPAGECACHE_H*/
@@ -51,6 +51,8 @@ EXTERNL void ncrc_initialize(void);
 EXTERNL int NC_rcfile_insert(const char* key, const char* hostport, const char* path, const char* value);
 EXTERNL char* NC_rclookup(const char* key, const char* hostport, const char* path);
 EXTERNL char* NC_rclookupx(NCURI* uri, const char* key);
+EXTERNL const char* NC_rclookupenv(NCURI* uri, const char* envkey, const char* rckey);
+EXTERNL size_t NC_rclookupsize(NCURI* uri, const char* envkey, const char* rckey, size_t dfalt);
 
 /* Following are primarily for debugging */
 /* Obtain the count of number of entries */
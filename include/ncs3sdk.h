@@ -70,6 +70,22 @@ typedef struct NCS3INFO {
     NCS3SVC svc;
 } NCS3INFO;
 
+/* A GET or PUT performed asynchronously; see NC_s3sdksubmit() */
+typedef enum NCS3OP {NCS3GET=1, NCS3PUT=2} NCS3OP;
+
+typedef struct NCS3REQ {
+    NCS3OP op;
+    const char* pathkey;
+    unsigned long long start; /* GET: offset of the first byte */
+    unsigned long long count; /* GET: no. of bytes, 0 => whole object; PUT: size of content */
+    void* content;            /* GET of the whole object: set to malloc'd memory */
+    int stat;                 /* result, set when the request completes */
+} NCS3REQ;
+
+/* Default no. of concurrent requests per client; overridden
+   by NC_S3_CONNECTIONS or the S3.CONNECTIONS .rc key */
+#define NCS3_DEFAULT_CONNECTIONS 8
+
 struct AWSentry {
     char* key;
     char* value;
@@ -109,12 +125,20 @@ DECLSPEC int NC_s3sdkbucketcreate(void* s3client, const char* region, const char
 DECLSPEC int NC_s3sdkbucketdelete(void* s3client, NCS3INFO* info, char** errmsgp);
 DECLSPEC int NC_s3sdkinfo(void* client0, const char* bucket, const char* pathkey, unsigned long long* lenp, char** errmsgp);
 DECLSPEC int NC_s3sdkread(void* client0, const char* bucket, const char* pathkey, unsigned long long start, unsigned long long count, void* content, char** errmsgp);
+DECLSPEC int NC_s3sdkreadall(void* client0, const char* bucket, const char* pathkey, unsigned long long* sizep, void** contentp, char** errmsgp);
 DECLSPEC int NC_s3sdkwriteobject(void* client0, const char* bucket, const char* pathkey, unsigned long long count, const void* content, char** errmsgp);
 DECLSPEC int NC_s3sdkclose(void* s3client0, char** errmsgp);
 DECLSPEC int NC_s3sdktruncate(void* s3client0, const char* bucket, const char* prefix, char** errmsgp);
 DECLSPEC int NC_s3sdklist(void* s3client0, const char* bucket, const char* prefix, size_t* nkeysp, char*** keysp, char** errmsgp);
 DECLSPEC int NC_s3sdklistall(void* s3client0, const char* bucket, const char* prefixkey0, size_t* nkeysp, char*** keysp, char** errmsgp);
 DECLSPEC int NC_s3sdkdeletekey(void* client0, const char* bucket, const char* pathkey, char** errmsgp);
+/* Queue a request on the client; the client may start it at once.
+   req and its pathkey and content must stay valid until NC_s3sdkwait() returns. */
+DECLSPEC int NC_s3sdksubmit(void* client0, const char* bucket, NCS3REQ* req, char** errmsgp);
+/* Complete all the requests submitted to the client, setting their stat:
+   a GET returns NC_ENOOBJECT if the object does not exist, and NC_EEDGE
+   if the range extends past its end. */
+DECLSPEC int NC_s3sdkwait(void* client0, char** errmsgp);
 
 /* From ds3util.c */
 DECLSPEC void NC_s3sdkenvironment(void);
@@ -0,0 +1,64 @@
+/*
+Copyright (c) 1998-2018 University Corporation for Atmospheric Research/Unidata
+See COPYRIGHT for license information.
+*/
+
+#ifndef NCTHREADPOOL_H
+#define NCTHREADPOOL_H
+
+#include "ncexternl.h"
+
+/*
+A minimal fixed-size pool of worker threads.
+
+Work is submitted as tasks belonging to a task group; the
+submitter later waits on the group, which returns the first
+error reported by any task in the group. While waiting, the
+calling thread also executes queued tasks, so a pool with
+zero workers degenerates into plain sequential execution.
+
+If the library is built without NETCDF_ENABLE_THREADPOOL,
+the same API is provided, but every task is executed
+immediately inside nctasksubmit().
+
+The pool itself is thread-safe, but the tasks must only
+touch state that is not shared with other tasks.
+*/
+
+typedef struct NCthreadpool NCthreadpool;
+typedef struct NCtaskgroup NCtaskgroup;
+
+/* A task; the return value is a netcdf error code */
+typedef int (*NCtaskfcn)(void* arg);
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Create a pool with nworkers threads; nworkers == 0 => run tasks in the caller */
+EXTERNL int ncthreadpoolnew(size_t nworkers, NCthreadpool** poolp);
+
+/* Finish all queued tasks, then stop the workers and reclaim the pool */
+EXTERNL void ncthreadpoolfree(NCthreadpool* pool);
+
+/* Number of worker threads (excluding the caller) */
+EXTERNL size_t ncthreadpoolsize(const NCthreadpool* pool);
+
+/* Create a task group attached to a pool */
+EXTERNL int nctaskgroupnew(NCthreadpool* pool, NCtaskgroup** groupp);
+
+/* Wait for any outstanding tasks and reclaim the group */
+EXTERNL void nctaskgroupfree(NCtaskgroup* group);
+
+/* Queue fcn(arg) for execution as part of group */
+EXTERNL int nctasksubmit(NCtaskgroup* group, NCtaskfcn fcn, void* arg);
+
+/* Wait for all tasks in the group to complete; return the first
+   error reported by any of them and reset the group for reuse. */
+EXTERNL int nctaskwait(NCtaskgroup* group);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /*NCTHREADPOOL_H*/
@@ -128,6 +128,8 @@ extern "C" {
    All upper 16 bits are unused except
         0x20000
         0x40000
+        0x80000
+        0x100000
 */
 
 /* Lower 16 bits */
@@ -174,6 +176,8 @@ Use this in mode flags for both nc_create() and nc_open(). */
 /* Upper 16 bits */
 #define NC_NOATTCREORD  0x20000 /**< Disable the netcdf-4 (hdf5) attribute creation order tracking */
 #define NC_NODIMSCALE_ATTACH 0x40000 /**< Disable the netcdf-4 (hdf5) attaching of dimscales to variables (#2128) */
+#define NC_URING        0x80000 /**< Access a classic file through io_uring where available (Linux). Mode flag for nc_open() or nc_create() */
+#define NC_LAZYGROUPS   0x100000 /**< Read the groups of a netcdf-4 (hdf5) file when first used. Mode flag for nc_open(), read-only */
 
 #define NC_MAX_MAGIC_NUMBER_LEN 8 /**< Max len of user-defined format magic number. */
 
@@ -1229,6 +1233,28 @@ nc_copy_var(int ncid_in, int varid, int ncid_out);
 #define ncvarcpy(ncid_in, varid, ncid_out) ncvarcopy((ncid_in), (varid), (ncid_out))
 #endif
 
+/* Raw chunks: the chunks of a netCDF-4 or NCZarr variable as they are
+   stored, i.e. after the filters have been applied. */
+
+EXTERNL int
+nc_get_chunk_raw(int ncid, int varid, const size_t *startp,
+                 unsigned int *filtermaskp, size_t *sizep, void *data);
+
+EXTERNL int
+nc_put_chunk_raw(int ncid, int varid, const size_t *startp,
+                 unsigned int filtermask, size_t size, const void *data);
+
+EXTERNL int
+nc_copy_var_raw(int ncid_in, int varid_in, int ncid_out, int varid_out);
+
+/* Sharding: NCZarr stores a block of chunks per object. */
+
+EXTERNL int
+nc_def_var_shard(int ncid, int varid, const size_t *shardp);
+
+EXTERNL int
+nc_inq_var_shard(int ncid, int varid, int *shardedp, size_t *shardp);
+
 /* End _var */
 /* Begin {put,get}_var1 */
 
@@ -1780,6 +1806,128 @@ nc_put_var_string(int ncid, int varid, const char **op);
 EXTERNL int
 nc_get_var_string(int ncid, int varid, char **ip);
 
+/* Begin nonblocking {put,get}_vara */
+
+/* Special request ids; the values match those of PnetCDF. */
+#ifndef NC_REQ_NULL
+#define NC_REQ_NULL -1 /**< A request id that is ignored by nc_wait_all(). */
+#endif
+#ifndef NC_REQ_ALL
+#define NC_REQ_ALL -1 /**< As the count of nc_wait_all(): all pending requests. */
+#endif
+
+EXTERNL int
+nc_iput_vara(int ncid, int varid, const size_t *startp,
+             const size_t *countp, const void *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara(int ncid, int varid, const size_t *startp,
+             const size_t *countp, void *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_text(int ncid, int varid, const size_t *startp,
+                  const size_t *countp, const char *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_text(int ncid, int varid, const size_t *startp,
+                  const size_t *countp, char *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_uchar(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, const unsigned char *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_uchar(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, unsigned char *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_schar(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, const signed char *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_schar(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, signed char *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_short(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, const short *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_short(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, short *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_int(int ncid, int varid, const size_t *startp,
+                 const size_t *countp, const int *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_int(int ncid, int varid, const size_t *startp,
+                 const size_t *countp, int *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_long(int ncid, int varid, const size_t *startp,
+                  const size_t *countp, const long *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_long(int ncid, int varid, const size_t *startp,
+                  const size_t *countp, long *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_float(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, const float *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_float(int ncid, int varid, const size_t *startp,
+                   const size_t *countp, float *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_double(int ncid, int varid, const size_t *startp,
+                    const size_t *countp, const double *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_double(int ncid, int varid, const size_t *startp,
+                    const size_t *countp, double *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_ushort(int ncid, int varid, const size_t *startp,
+                    const size_t *countp, const unsigned short *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_ushort(int ncid, int varid, const size_t *startp,
+                    const size_t *countp, unsigned short *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_uint(int ncid, int varid, const size_t *startp,
+                  const size_t *countp, const unsigned int *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_uint(int ncid, int varid, const size_t *startp,
+                  const size_t *countp, unsigned int *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_longlong(int ncid, int varid, const size_t *startp,
+                      const size_t *countp, const long long *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_longlong(int ncid, int varid, const size_t *startp,
+                      const size_t *countp, long long *ip, int *reqidp);
+
+EXTERNL int
+nc_iput_vara_ulonglong(int ncid, int varid, const size_t *startp,
+                       const size_t *countp, const unsigned long long *op, int *reqidp);
+
+EXTERNL int
+nc_iget_vara_ulonglong(int ncid, int varid, const size_t *startp,
+                       const size_t *countp, unsigned long long *ip, int *reqidp);
+
+EXTERNL int
+nc_wait_all(int ncid, int nreqs, int *reqids, int *statuses);
+
+EXTERNL int
+nc_cancel(int ncid, int nreqs, int *reqids, int *statuses);
+
+/* End nonblocking {put,get}_vara */
+
 /* Begin instance walking functions */
 
 /* When you read an array of string typed instances, the library will allocate
@@ -116,7 +116,10 @@ nc_rename_att(int ncid, int varid, const char *name, const char *newname)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_rename_att);
-   return ncp->dispatch->rename_att(ncid, varid, name, newname);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->rename_att(ncid, varid, name, newname);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -180,7 +183,9 @@ nc_del_att(int ncid, int varid, const char *name)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_del_att);
+   NCLOCKFILE(ncp);
    stat = ncp->dispatch->del_att(ncid, varid, name);
+   NCUNLOCKFILE(ncp);
    return stat;
 }
 /**@}*/  /* End doxygen member group. */
@@ -144,7 +144,10 @@ nc_get_att(int ncid, int varid, const char *name, void *value)
       return stat;
 
    TRACE(nc_get_att);
-   return ncp->dispatch->get_att(ncid, varid, name, value, xtype);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, value, xtype);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -225,7 +228,10 @@ nc_get_att_text(int ncid, int varid, const char *name, char *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_text);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_CHAR);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_CHAR);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -258,7 +264,10 @@ nc_get_att_schar(int ncid, int varid, const char *name, signed char *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_schar);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_BYTE);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_BYTE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -291,7 +300,10 @@ nc_get_att_uchar(int ncid, int varid, const char *name, unsigned char *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_uchar);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UBYTE);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UBYTE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -324,7 +336,10 @@ nc_get_att_short(int ncid, int varid, const char *name, short *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_short);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_SHORT);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_SHORT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -357,7 +372,10 @@ nc_get_att_int(int ncid, int varid, const char *name, int *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_int);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_INT);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_INT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -390,7 +408,10 @@ nc_get_att_long(int ncid, int varid, const char *name, long *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_long);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, longtype);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, longtype);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -423,7 +444,10 @@ nc_get_att_float(int ncid, int varid, const char *name, float *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_float);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_FLOAT);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_FLOAT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -456,7 +480,10 @@ nc_get_att_double(int ncid, int varid, const char *name, double *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_double);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_DOUBLE);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_DOUBLE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -489,7 +516,10 @@ nc_get_att_ubyte(int ncid, int varid, const char *name, unsigned char *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_ubyte);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UBYTE);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UBYTE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -522,7 +552,10 @@ nc_get_att_ushort(int ncid, int varid, const char *name, unsigned short *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_ushort);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_USHORT);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_USHORT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -555,7 +588,10 @@ nc_get_att_uint(int ncid, int varid, const char *name, unsigned int *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_uint);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UINT);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UINT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -588,7 +624,10 @@ nc_get_att_longlong(int ncid, int varid, const char *name, long long *value)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_longlong);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_INT64);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_INT64);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -621,7 +660,10 @@ nc_get_att_ulonglong(int ncid, int varid, const char *name, unsigned long long *
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_get_att_ulonglong);
-   return ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UINT64);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid, varid, name, (void *)value, NC_UINT64);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -714,6 +756,9 @@ nc_get_att_string(int ncid, int varid, const char *name, char **value)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_get_att_string);
-    return ncp->dispatch->get_att(ncid,varid,name,(void*)value, NC_STRING);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->get_att(ncid,varid,name,(void*)value, NC_STRING);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 /**@}*/  /* End doxygen member group. */
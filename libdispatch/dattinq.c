@@ -89,7 +89,10 @@ nc_inq_att(int ncid, int varid, const char *name, nc_type *xtypep,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_att(ncid, varid, name, xtypep, lenp);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_att(ncid, varid, name, xtypep, lenp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -166,7 +169,10 @@ nc_inq_attid(int ncid, int varid, const char *name, int *idp)
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_attid(ncid, varid, name, idp);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_attid(ncid, varid, name, idp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -257,7 +263,10 @@ nc_inq_attname(int ncid, int varid, int attnum, char *name)
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_attname(ncid, varid, attnum, name);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_attname(ncid, varid, attnum, name);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -303,7 +312,10 @@ nc_inq_natts(int ncid, int *nattsp)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    if(nattsp == NULL) return NC_NOERR;
-   return ncp->dispatch->inq(ncid, NULL, NULL, nattsp, NULL);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq(ncid, NULL, NULL, nattsp, NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -360,7 +372,10 @@ nc_inq_atttype(int ncid, int varid, const char *name, nc_type *xtypep)
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_att(ncid, varid, name, xtypep, NULL);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_att(ncid, varid, name, xtypep, NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -426,7 +441,10 @@ nc_inq_attlen(int ncid, int varid, const char *name, size_t *lenp)
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_att(ncid, varid, name, NULL, lenp);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_att(ncid, varid, name, NULL, lenp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /*! \} */  /* End of named group ...*/
@@ -78,8 +78,11 @@ nc_put_att_string(int ncid, int varid, const char *name,
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->put_att(ncid, varid, name, NC_STRING,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->put_att(ncid, varid, name, NC_STRING,
 				  len, (void*)value, NC_STRING);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -156,8 +159,11 @@ int nc_put_att_text(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, NC_CHAR, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, NC_CHAR, len,
 				 (void *)value, NC_CHAR);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -225,8 +231,11 @@ nc_put_att(int ncid, int varid, const char *name, nc_type xtype,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 value, xtype);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -259,8 +268,11 @@ nc_put_att_schar(int ncid, int varid, const char *name,
    NC *ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_BYTE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -293,8 +305,11 @@ nc_put_att_uchar(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_UBYTE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -327,8 +342,11 @@ nc_put_att_short(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_SHORT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -361,8 +379,11 @@ nc_put_att_int(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_INT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -395,8 +416,11 @@ nc_put_att_long(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, longtype);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -429,8 +453,11 @@ nc_put_att_float(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_FLOAT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -463,8 +490,11 @@ nc_put_att_double(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_DOUBLE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -497,8 +527,11 @@ nc_put_att_ubyte(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_UBYTE);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -531,8 +564,11 @@ nc_put_att_ushort(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_USHORT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -565,8 +601,11 @@ nc_put_att_uint(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_UINT);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -600,8 +639,11 @@ nc_put_att_longlong(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_INT64);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -635,8 +677,11 @@ nc_put_att_ulonglong(int ncid, int varid, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->put_att(ncid, varid, name, xtype, len,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->put_att(ncid, varid, name, xtype, len,
 				 (void *)value, NC_UINT64);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**@}*/  /* End doxygen member group. */
@@ -0,0 +1,327 @@
+/* Copyright 2018 University Corporation for Atmospheric
+   Research/Unidata. See COPYRIGHT file for more info. */
+/*! \file
+Raw chunk access.
+
+The chunks of a netCDF-4 (HDF5) or NCZarr variable can be read and
+written as they are stored, that is, after the filters have been
+applied, without decoding or encoding them: through H5Dread_chunk()
+and H5Dwrite_chunk() for HDF5, and by reading and writing the chunk
+object of the map for NCZarr. A chunk is identified by the
+coordinates of its first element.
+
+nc_copy_var_raw() (in dcopy.c) uses these to copy the data of a
+variable to a variable stored in the same way, so that
+re-packaging a compressed file costs I/O time rather than
+decompression and recompression.
+
+nc_def_var_shard() and nc_inq_var_shard() control how NCZarr groups
+the chunks of a variable into shards, each stored as one object.
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "ncdispatch.h"
+
+#ifdef USE_NETCDF4
+#include "nc4internal.h"
+#endif
+
+#if defined(USE_HDF5) && defined(HDF5_SUPPORTS_PAR_FILTERS)
+#include "hdf5internal.h"
+#define RAWHDF5
+#endif
+
+#ifdef NETCDF_ENABLE_NCZARR
+#include "zdispatch.h"
+#endif
+
+/* Return the extended format of ncid if its chunks can be accessed raw */
+static int
+rawformat(int ncid, int* formatxp)
+{
+    int stat;
+    int formatx;
+
+    if((stat = nc_inq_format_extended(ncid,&formatx,NULL))) return stat;
+    switch (formatx) {
+#ifdef RAWHDF5
+    case NC_FORMATX_NC_HDF5: break;
+#elif defined(USE_HDF5)
+    case NC_FORMATX_NC_HDF5: return NC_ENOTBUILT; /* HDF5 is too old */
+#endif
+#ifdef NETCDF_ENABLE_NCZARR
+    case NC_FORMATX_NCZARR: break;
+#endif
+    default: return NC_ENOTNC4;
+    }
+    *formatxp = formatx;
+    return NC_NOERR;
+}
+
+/* Check that the variable has fixed size values and is chunked, and
+   that startp is the first element of one of its chunks. */
+static int
+checkchunk(int ncid, int varid, const size_t* startp)
+{
+    int stat;
+    int ndims, storage, d;
+    int fixedsize = 0;
+    nc_type xtype;
+    int dimids[NC_MAX_VAR_DIMS];
+    size_t chunksizes[NC_MAX_VAR_DIMS];
+    size_t len;
+
+    if((stat = nc_inq_var(ncid,varid,NULL,&xtype,&ndims,dimids,NULL))) return stat;
+#ifdef USE_NETCDF4
+    if((stat = NC4_inq_type_fixed_size(ncid,xtype,&fixedsize))) return stat;
+#endif
+    if(!fixedsize) return NC_EBADTYPE;
+    if((stat = nc_inq_var_chunking(ncid,varid,&storage,chunksizes))) return stat;
+    if(storage != NC_CHUNKED) return NC_EINVAL;
+    if(ndims > 0 && startp == NULL) return NC_EINVALCOORDS;
+    for(d=0;d<ndims;d++) {
+        if((stat = nc_inq_dimlen(ncid,dimids[d],&len))) return stat;
+        if(startp[d] >= len || startp[d] % chunksizes[d] != 0) return NC_EINVALCOORDS;
+    }
+    return NC_NOERR;
+}
+
+/**
+ * @internal As nc_get_chunk_raw(), but the chunk is returned in
+ * memory that the caller must free.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk.
+ * @param filtermaskp Gets the filter mask. Ignored if NULL.
+ * @param sizep Gets the size of the stored chunk.
+ * @param datap Gets the stored chunk.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EEMPTY The chunk has never been written.
+ */
+int
+NC_get_chunk_raw(int ncid, int varid, const size_t* startp,
+                 unsigned int* filtermaskp, size_t* sizep, void** datap)
+{
+    int stat;
+    NC* ncp;
+    int formatx = 0;
+
+    if((stat = NC_check_id(ncid,&ncp))) return stat;
+    if((stat = rawformat(ncid,&formatx))) return stat;
+    if((stat = checkchunk(ncid,varid,startp))) return stat;
+    if(filtermaskp) *filtermaskp = 0;
+    NCLOCKFILE(ncp);
+    switch (formatx) {
+#ifdef RAWHDF5
+    case NC_FORMATX_NC_HDF5:
+        stat = NC4_HDF5_get_chunk_raw(ncid,varid,startp,filtermaskp,sizep,datap);
+        break;
+#endif
+#ifdef NETCDF_ENABLE_NCZARR
+    case NC_FORMATX_NCZARR:
+        stat = NCZ_get_chunk_raw(ncid,varid,startp,sizep,datap);
+        break;
+#endif
+    default: stat = NC_ENOTNC4; break;
+    }
+    NCUNLOCKFILE(ncp);
+    return stat;
+}
+
+/**
+ * Read one chunk of a variable as it is stored in the file, that is,
+ * without undoing the filters (compression, shuffle, checksums,
+ * ...). Only netCDF-4/HDF5 and NCZarr files store chunks.
+ *
+ * To find out how large the chunk is, call with data NULL; then call
+ * again with a buffer that size.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk: a
+ * multiple of the chunk size in each dimension.
+ * @param filtermaskp Gets the HDF5 filter mask of the chunk if data
+ * is not NULL: bit i is set if filter i was skipped when the chunk
+ * was written (always 0 for NCZarr). Ignored if NULL.
+ * @param sizep Gets the size in bytes of the stored chunk.
+ * @param data Gets the stored chunk. Ignored if NULL.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EEMPTY The chunk has never been written; reading it
+ * would give fill values.
+ * @return ::NC_EINVALCOORDS startp is not the start of a chunk.
+ * @return ::NC_EINVAL The variable is not chunked.
+ * @return ::NC_EBADTYPE The values of the variable are not of fixed
+ * size (strings or vlens).
+ * @return ::NC_ENOTNC4 The file does not store chunks.
+ * @return ::NC_ENOTBUILT The HDF5 library is too old.
+ * @ingroup variables
+ */
+int
+nc_get_chunk_raw(int ncid, int varid, const size_t* startp,
+                 unsigned int* filtermaskp, size_t* sizep, void* data)
+{
+    int stat;
+    size_t size = 0;
+    void* chunk = NULL;
+
+    if((stat = NC_get_chunk_raw(ncid,varid,startp,filtermaskp,&size,(data ? &chunk : NULL))))
+        return stat;
+    if(data) {
+        memcpy(data,chunk,size);
+        free(chunk);
+    }
+    if(sizep) *sizep = size;
+    return NC_NOERR;
+}
+
+/**
+ * Write one chunk of a variable as it is to be stored in the file,
+ * that is, already filtered, e.g. as obtained from
+ * nc_get_chunk_raw() for a variable with the same type, chunk sizes
+ * and filters. The chunk must lie within the current shape of the
+ * variable; write a value to extend an unlimited dimension first.
+ * A cached copy of the chunk is discarded.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk: a
+ * multiple of the chunk size in each dimension.
+ * @param filtermask HDF5 filter mask of the chunk; must be 0 for
+ * NCZarr.
+ * @param size Size in bytes of the stored chunk.
+ * @param data The stored chunk.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EPERM The file is read-only.
+ * @return ::NC_EFILTER A filter mask for an NCZarr variable.
+ * @return ::NC_EINVALCOORDS startp is not the start of a chunk.
+ * @return ::NC_EINVAL The variable is not chunked.
+ * @return ::NC_EBADTYPE The values of the variable are not of fixed
+ * size (strings or vlens).
+ * @return ::NC_ENOTNC4 The file does not store chunks.
+ * @return ::NC_ENOTBUILT The HDF5 library is too old.
+ * @ingroup variables
+ */
+int
+nc_put_chunk_raw(int ncid, int varid, const size_t* startp,
+                 unsigned int filtermask, size_t size, const void* data)
+{
+    int stat;
+    NC* ncp;
+    int formatx = 0;
+
+    if((stat = NC_check_id(ncid,&ncp))) return stat;
+    if((stat = rawformat(ncid,&formatx))) return stat;
+    if((stat = checkchunk(ncid,varid,startp))) return stat;
+    if(data == NULL) return NC_EINVAL;
+    NCLOCKFILE(ncp);
+    switch (formatx) {
+#ifdef RAWHDF5
+    case NC_FORMATX_NC_HDF5:
+        stat = NC4_HDF5_put_chunk_raw(ncid,varid,startp,filtermask,size,data);
+        break;
+#endif
+#ifdef NETCDF_ENABLE_NCZARR
+    case NC_FORMATX_NCZARR:
+        if(filtermask != 0) {stat = NC_EFILTER; break;}
+        stat = NCZ_put_chunk_raw(ncid,varid,startp,size,data);
+        break;
+#endif
+    default: stat = NC_ENOTNC4; break;
+    }
+    NCUNLOCKFILE(ncp);
+    return stat;
+}
+
+/**
+ * Store the chunks of an NCZarr variable in shards: each shard is a
+ * block of chunks kept in one object of the storage, preceded by an
+ * index of the offset and size of each chunk. Many small chunks then
+ * cost few objects, and the chunks of a shard are read with few
+ * requests. A chunk remains the unit of compression and caching.
+ * Must be called after nc_def_var() and before nc_enddef().
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param shardp Number of chunks per shard along each dimension;
+ * NULL to store each chunk as its own object (the default).
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EPERM The file is read-only.
+ * @return ::NC_ELATEDEF The variable has already been written.
+ * @return ::NC_EINVAL A scalar variable, a zero count, a pure Zarr
+ * file (which cannot record the sharding) or an HDF5 file.
+ * @return ::NC_ENOTNC4 Not a netCDF-4 or NCZarr file.
+ * @ingroup variables
+ */
+int
+nc_def_var_shard(int ncid, int varid, const size_t* shardp)
+{
+    int stat;
+    NC* ncp;
+    int formatx = 0;
+
+    if((stat = NC_check_id(ncid,&ncp))) return stat;
+    if((stat = nc_inq_format_extended(ncid,&formatx,NULL))) return stat;
+    NCLOCKFILE(ncp);
+    switch (formatx) {
+#ifdef NETCDF_ENABLE_NCZARR
+    case NC_FORMATX_NCZARR:
+        stat = NCZ_def_var_shard(ncid,varid,shardp);
+        break;
+#endif
+    case NC_FORMATX_NC_HDF5: stat = NC_EINVAL; break;
+    default: stat = NC_ENOTNC4; break;
+    }
+    NCUNLOCKFILE(ncp);
+    return stat;
+}
+
+/**
+ * Get the sharding of a variable; see nc_def_var_shard().
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param shardedp Gets 1 if the variable is sharded, else 0. Ignored
+ * if NULL.
+ * @param shardp Gets the number of chunks per shard along each
+ * dimension if the variable is sharded. Ignored if NULL.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_ENOTVAR Invalid variable ID.
+ * @return ::NC_ENOTNC4 Not a netCDF-4 or NCZarr file.
+ * @ingroup variables
+ */
+int
+nc_inq_var_shard(int ncid, int varid, int* shardedp, size_t* shardp)
+{
+    int stat;
+    NC* ncp;
+    int formatx = 0;
+
+    if((stat = NC_check_id(ncid,&ncp))) return stat;
+    if((stat = nc_inq_format_extended(ncid,&formatx,NULL))) return stat;
+    if(formatx == NC_FORMATX_NC_HDF5) {
+        /* HDF5 has no shards */
+        if((stat = nc_inq_varndims(ncid,varid,NULL))) return stat;
+        if(shardedp) *shardedp = 0;
+        return NC_NOERR;
+    }
+    NCLOCKFILE(ncp);
+    switch (formatx) {
+#ifdef NETCDF_ENABLE_NCZARR
+    case NC_FORMATX_NCZARR:
+        stat = NCZ_inq_var_shard(ncid,varid,shardedp,shardp);
+        break;
+#endif
+    default: stat = NC_ENOTNC4; break;
+    }
+    NCUNLOCKFILE(ncp);
+    return stat;
+}
@@ -66,7 +66,10 @@ nc_def_compound(int ncid, size_t size, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->def_compound(ncid,size,name,typeidp);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->def_compound(ncid,size,name,typeidp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /** \ingroup user_types
@@ -102,8 +105,11 @@ nc_insert_compound(int ncid, nc_type xtype, const char *name,
    NC *ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->insert_compound(ncid, xtype, name,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->insert_compound(ncid, xtype, name,
 					 offset, field_typeid);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /** \ingroup user_types
@@ -145,7 +151,10 @@ nc_insert_array_compound(int ncid, nc_type xtype, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->insert_array_compound(ncid,xtype,name,offset,field_typeid,ndims,dim_sizes);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->insert_array_compound(ncid,xtype,name,offset,field_typeid,ndims,dim_sizes);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -292,9 +301,12 @@ nc_inq_compound_field(int ncid, nc_type xtype, int fieldid,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_field(ncid, xtype, fieldid,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_field(ncid, xtype, fieldid,
 					    name, offsetp, field_typeidp,
 					    ndimsp, dim_sizesp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -324,9 +336,12 @@ nc_inq_compound_fieldname(int ncid, nc_type xtype, int fieldid,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_field(ncid, xtype, fieldid,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_field(ncid, xtype, fieldid,
 					    name, NULL, NULL, NULL,
 					    NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -356,7 +371,10 @@ nc_inq_compound_fieldoffset(int ncid, nc_type xtype, int fieldid,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_field(ncid,xtype,fieldid,NULL,offsetp,NULL,NULL,NULL);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_field(ncid,xtype,fieldid,NULL,offsetp,NULL,NULL,NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -386,7 +404,10 @@ nc_inq_compound_fieldtype(int ncid, nc_type xtype, int fieldid,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_field(ncid,xtype,fieldid,NULL,NULL,field_typeidp,NULL,NULL);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_field(ncid,xtype,fieldid,NULL,NULL,field_typeidp,NULL,NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -416,7 +437,10 @@ nc_inq_compound_fieldndims(int ncid, nc_type xtype, int fieldid,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_field(ncid,xtype,fieldid,NULL,NULL,NULL,ndimsp,NULL);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_field(ncid,xtype,fieldid,NULL,NULL,NULL,ndimsp,NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -446,9 +470,12 @@ nc_inq_compound_fielddim_sizes(int ncid, nc_type xtype, int fieldid,
    NC *ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_field(ncid, xtype, fieldid,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_field(ncid, xtype, fieldid,
 					    NULL, NULL, NULL, NULL,
 					    dim_sizesp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**  \ingroup user_types
@@ -478,6 +505,9 @@ nc_inq_compound_fieldindex(int ncid, nc_type xtype, const char *name,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_compound_fieldindex(ncid,xtype,name,fieldidp);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_compound_fieldindex(ncid,xtype,name,fieldidp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 /*! \} */  /* End of named group ...*/
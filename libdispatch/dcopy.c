@@ -11,6 +11,10 @@
 #include "ncdispatch.h"
 #include "nc_logging.h"
 #include "nclist.h"
+#ifdef USE_NETCDF4
+#include "nc4internal.h"
+#include "ncutil.h"
+#endif
 
 static int NC_find_equal_type(int ncid1, nc_type xtype1, int ncid2, nc_type *xtype2);
 
@@ -250,6 +254,365 @@ NC_find_equal_type(int ncid1, nc_type xtype1, int ncid2, nc_type *xtype2)
    return ret;
 }
 
+#ifdef USE_NETCDF4
+/**
+ * @internal Is a dimension unlimited? The dimension may belong to
+ * ncid or to any of its ancestors.
+ *
+ * @param ncid Group ID.
+ * @param dimid Dimension ID.
+ * @param unlimp Pointer that gets 1 if the dimension is unlimited.
+ *
+ * @return ::NC_NOERR No error.
+*/
+static int
+NC_is_unlimited(int ncid, int dimid, int *unlimp)
+{
+   int ret, nunlim, i;
+   int *unlimids = NULL;
+
+   *unlimp = 0;
+   while (!*unlimp)
+   {
+      if ((ret = nc_inq_unlimdims(ncid, &nunlim, NULL)))
+         return ret;
+      if (nunlim > 0)
+      {
+         if (!(unlimids = malloc((size_t)nunlim * sizeof(int))))
+            return NC_ENOMEM;
+         if (!(ret = nc_inq_unlimdims(ncid, &nunlim, unlimids)))
+            for (i = 0; i < nunlim; i++)
+               if (unlimids[i] == dimid)
+                  *unlimp = 1;
+         free(unlimids);
+         if (ret)
+            return ret;
+      }
+      if (nc_inq_grp_parent(ncid, &ncid) != NC_NOERR)
+         break; /* root group */
+   }
+   return NC_NOERR;
+}
+
+/**
+ * @internal Do two variables have the same filter chain, with the
+ * same parameters?
+ *
+ * @param ncid1 File ID.
+ * @param varid1 Variable ID.
+ * @param ncid2 File ID.
+ * @param varid2 Variable ID.
+ * @param equalp Pointer that gets 1 if the filters are the same.
+ *
+ * @return ::NC_NOERR No error.
+*/
+static int
+NC_compare_filters(int ncid1, int varid1, int ncid2, int varid2, int *equalp)
+{
+   int retval = NC_NOERR;
+   size_t nfilters1, nfilters2, nparams1, nparams2, f;
+   unsigned int *ids1 = NULL, *ids2 = NULL;
+   unsigned int *params1 = NULL, *params2 = NULL;
+
+   *equalp = 0;
+   if ((retval = nc_inq_var_filter_ids(ncid1, varid1, &nfilters1, NULL)) ||
+       (retval = nc_inq_var_filter_ids(ncid2, varid2, &nfilters2, NULL)))
+      return retval;
+   if (nfilters1 != nfilters2)
+      return NC_NOERR;
+   if (nfilters1 == 0)
+   {
+      *equalp = 1;
+      return NC_NOERR;
+   }
+   if (!(ids1 = malloc(nfilters1 * sizeof(unsigned int))) ||
+       !(ids2 = malloc(nfilters2 * sizeof(unsigned int))))
+      BAIL(NC_ENOMEM);
+   if ((retval = nc_inq_var_filter_ids(ncid1, varid1, NULL, ids1)) ||
+       (retval = nc_inq_var_filter_ids(ncid2, varid2, NULL, ids2)))
+      BAIL(retval);
+   for (f = 0; f < nfilters1; f++)
+   {
+      if (ids1[f] != ids2[f])
+         BAIL_QUIET(NC_NOERR);
+      /* HDF5 sets the parameter of shuffle, the type size, when the
+         data is written; the types are compared elsewhere. */
+      if (ids1[f] == H5Z_FILTER_SHUFFLE)
+         continue;
+      if ((retval = nc_inq_var_filter_info(ncid1, varid1, ids1[f], &nparams1, NULL)) ||
+          (retval = nc_inq_var_filter_info(ncid2, varid2, ids2[f], &nparams2, NULL)))
+         BAIL(retval);
+      if (nparams1 != nparams2)
+         BAIL_QUIET(NC_NOERR);
+      if (nparams1 == 0)
+         continue;
+      if (!(params1 = malloc(nparams1 * sizeof(unsigned int))) ||
+          !(params2 = malloc(nparams2 * sizeof(unsigned int))))
+         BAIL(NC_ENOMEM);
+      if ((retval = nc_inq_var_filter_info(ncid1, varid1, ids1[f], NULL, params1)) ||
+          (retval = nc_inq_var_filter_info(ncid2, varid2, ids2[f], NULL, params2)))
+         BAIL(retval);
+      if (memcmp(params1, params2, nparams1 * sizeof(unsigned int)))
+         BAIL_QUIET(NC_NOERR);
+      free(params1); params1 = NULL;
+      free(params2); params2 = NULL;
+   }
+   *equalp = 1;
+
+exit:
+   nullfree(ids1);
+   nullfree(ids2);
+   nullfree(params1);
+   nullfree(params2);
+   return retval;
+}
+
+/**
+ * @internal Are two variables stored in the same way, so that the
+ * chunks of one are valid chunks of the other? Both files must be of
+ * the same format that stores chunks (HDF5 or NCZarr), whose chunks
+ * this build can access raw (see nc_get_chunk_raw()), and the
+ * variables must have equal fixed-size types, equal shapes, chunk
+ * sizes, filters, byte order and fill values. Where a dimension of
+ * the output is shorter than that of the input, it must be unlimited,
+ * and the output variable must be extended before its chunks are
+ * written.
+ *
+ * @param ncid_in File ID to copy from.
+ * @param varid_in Variable ID to copy from.
+ * @param ncid_out File ID to copy to.
+ * @param varid_out Variable ID to copy to.
+ * @param equalp Pointer that gets 1 if the storage is the same.
+ * @param ndimsp Pointer that gets the number of dimensions.
+ * @param dimlen Gets the shape of the input variable.
+ * @param chunksizes Gets the chunk sizes.
+ * @param extendp Pointer that gets 1 if the output must be extended.
+ *
+ * @return ::NC_NOERR No error.
+*/
+static int
+NC_compare_var_storage(int ncid_in, int varid_in, int ncid_out, int varid_out,
+                       int *equalp, int *ndimsp, size_t *dimlen,
+                       size_t *chunksizes, int *extendp)
+{
+   int retval = NC_NOERR;
+   int formatx_in, formatx_out;
+   nc_type xtype_in, xtype_out;
+   int ndims, ndims_out, d;
+   int dimids_in[NC_MAX_VAR_DIMS], dimids_out[NC_MAX_VAR_DIMS];
+   size_t chunksizes_out[NC_MAX_VAR_DIMS];
+   size_t len_out, size;
+   int storage_in, storage_out;
+   int endian_in, endian_out;
+   int nofill_in, nofill_out;
+   int equal, fixedsize, unlim;
+   void *fill_in = NULL, *fill_out = NULL;
+
+   *equalp = 0;
+   *extendp = 0;
+   if ((retval = nc_inq_format_extended(ncid_in, &formatx_in, NULL)) ||
+       (retval = nc_inq_format_extended(ncid_out, &formatx_out, NULL)))
+      return retval;
+   if (formatx_in != formatx_out ||
+       (formatx_in != NC_FORMATX_NC_HDF5 && formatx_in != NC_FORMATX_NCZARR))
+      return NC_NOERR;
+#if defined(USE_HDF5) && !defined(HDF5_SUPPORTS_PAR_FILTERS)
+   /* HDF5 before 1.10.3 cannot read and write chunks raw */
+   if (formatx_in == NC_FORMATX_NC_HDF5)
+      return NC_NOERR;
+#endif
+
+   /* Type and shape */
+   if ((retval = nc_inq_var(ncid_in, varid_in, NULL, &xtype_in, &ndims, dimids_in, NULL)) ||
+       (retval = nc_inq_var(ncid_out, varid_out, NULL, &xtype_out, &ndims_out, dimids_out, NULL)))
+      return retval;
+   if (ndims != ndims_out)
+      return NC_NOERR;
+   if ((retval = NC_compare_nc_types(ncid_in, xtype_in, ncid_out, xtype_out, &equal)))
+      return retval;
+   if (!equal)
+      return NC_NOERR;
+   if ((retval = NC4_inq_type_fixed_size(ncid_in, xtype_in, &fixedsize)))
+      return retval;
+   if (!fixedsize)
+      return NC_NOERR;
+   for (d = 0; d < ndims; d++)
+   {
+      if ((retval = nc_inq_dimlen(ncid_in, dimids_in[d], &dimlen[d])) ||
+          (retval = nc_inq_dimlen(ncid_out, dimids_out[d], &len_out)))
+         return retval;
+      if (len_out > dimlen[d])
+         return NC_NOERR;
+      if (len_out < dimlen[d])
+      {
+         if ((retval = NC_is_unlimited(ncid_out, dimids_out[d], &unlim)))
+            return retval;
+         if (!unlim)
+            return NC_NOERR;
+         *extendp = 1;
+      }
+   }
+
+   /* Chunks */
+   if ((retval = nc_inq_var_chunking(ncid_in, varid_in, &storage_in, chunksizes)) ||
+       (retval = nc_inq_var_chunking(ncid_out, varid_out, &storage_out, chunksizes_out)))
+      return retval;
+   if (storage_in != NC_CHUNKED || storage_out != NC_CHUNKED ||
+       memcmp(chunksizes, chunksizes_out, (size_t)ndims * sizeof(size_t)))
+      return NC_NOERR;
+   if ((retval = NC_compare_filters(ncid_in, varid_in, ncid_out, varid_out, &equal)))
+      return retval;
+   if (!equal)
+      return NC_NOERR;
+   if ((retval = nc_inq_var_endian(ncid_in, varid_in, &endian_in)) ||
+       (retval = nc_inq_var_endian(ncid_out, varid_out, &endian_out)))
+      return retval;
+   /* A variable not yet written may still report the native order */
+   if (endian_in == NC_ENDIAN_NATIVE)
+      endian_in = (NC_isLittleEndian() ? NC_ENDIAN_LITTLE : NC_ENDIAN_BIG);
+   if (endian_out == NC_ENDIAN_NATIVE)
+      endian_out = (NC_isLittleEndian() ? NC_ENDIAN_LITTLE : NC_ENDIAN_BIG);
+   if (endian_in != endian_out)
+      return NC_NOERR;
+
+   /* Chunks that are not stored read as fill values. */
+   if ((retval = nc_inq_type(ncid_in, xtype_in, NULL, &size)))
+      return retval;
+   if (!(fill_in = calloc(1, size)) || !(fill_out = calloc(1, size)))
+      BAIL(NC_ENOMEM);
+   if ((retval = nc_inq_var_fill(ncid_in, varid_in, &nofill_in, fill_in)) ||
+       (retval = nc_inq_var_fill(ncid_out, varid_out, &nofill_out, fill_out)))
+      BAIL(retval);
+   if (nofill_in != nofill_out || (!nofill_in && memcmp(fill_in, fill_out, size)))
+      BAIL_QUIET(NC_NOERR);
+
+   *ndimsp = ndims;
+   *equalp = 1;
+
+exit:
+   nullfree(fill_in);
+   nullfree(fill_out);
+   return retval;
+}
+
+#endif /* USE_NETCDF4 */
+
+/**
+ * Copy the data of a variable to a variable that is stored in the
+ * same way, one stored chunk at a time, without decompressing and
+ * recompressing it (see nc_get_chunk_raw()). Both files must be
+ * netCDF-4/HDF5 files or both NCZarr files, and the two variables
+ * must have the same fixed-size type, shape, chunk sizes, filters
+ * (with the same parameters), byte order and fill value. A dimension
+ * of the output variable may be shorter than that of the input only
+ * if it is unlimited; it is extended first. Chunks that were never
+ * written are not copied.
+ *
+ * If the variables are not stored in the same way, or if this build
+ * cannot access their chunks raw (HDF5 before 1.10.3), nothing is
+ * written and ::NC_EINVAL is returned, so that the caller can copy the
+ * values instead, e.g. as nc_copy_var() does.
+ *
+ * @param ncid_in File ID to copy from.
+ * @param varid_in Variable ID to copy.
+ * @param ncid_out File ID to copy to.
+ * @param varid_out Variable ID to copy to.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EINVAL The chunks cannot be copied as they are.
+ * @ingroup variables
+*/
+int
+nc_copy_var_raw(int ncid_in, int varid_in, int ncid_out, int varid_out)
+{
+#ifndef USE_NETCDF4
+   return NC_EINVAL;
+#else
+   int retval = NC_NOERR;
+   int equal = 0, extend = 0;
+   int ndims = 0, real_ndims, d;
+   size_t dimlen[NC_MAX_VAR_DIMS], chunksizes[NC_MAX_VAR_DIMS];
+   size_t nchunks[NC_MAX_VAR_DIMS], chunkindex[NC_MAX_VAR_DIMS];
+   size_t start[NC_MAX_VAR_DIMS], ones[NC_MAX_VAR_DIMS];
+   size_t size;
+   unsigned int filtermask;
+   void *chunk = NULL;
+   void *value = NULL;
+
+   LOG((2, "nc_copy_var_raw: ncid_in 0x%x varid_in %d ncid_out 0x%x varid_out %d",
+        ncid_in, varid_in, ncid_out, varid_out));
+
+   if ((retval = NC_compare_var_storage(ncid_in, varid_in, ncid_out, varid_out,
+                                        &equal, &ndims, dimlen, chunksizes, &extend)))
+      return retval;
+   if (!equal)
+      return NC_EINVAL;
+   for (d = 0; d < ndims; d++)
+      if (dimlen[d] == 0)
+         return NC_NOERR; /* no data */
+
+   /* Extend the unlimited dimensions of the output by writing its
+      last value; the chunk holding it is then overwritten. */
+   if (extend)
+   {
+      nc_type xtype;
+      size_t typesize;
+      for (d = 0; d < ndims; d++)
+      {
+         start[d] = dimlen[d] - 1;
+         ones[d] = 1;
+      }
+      if ((retval = nc_inq_vartype(ncid_in, varid_in, &xtype)) ||
+          (retval = nc_inq_type(ncid_in, xtype, NULL, &typesize)))
+         return retval;
+      if (!(value = malloc(typesize)))
+         return NC_ENOMEM;
+      if ((retval = nc_get_vara(ncid_in, varid_in, start, ones, value)) ||
+          (retval = nc_put_vara(ncid_out, varid_out, start, ones, value)))
+         BAIL(retval);
+   }
+
+   /* Visit every chunk; a scalar is one chunk. */
+   real_ndims = ndims ? ndims : 1;
+   for (d = 0; d < real_ndims; d++)
+   {
+      nchunks[d] = ndims ? (dimlen[d] + chunksizes[d] - 1) / chunksizes[d] : 1;
+      chunkindex[d] = 0;
+      start[d] = 0;
+   }
+   for (;;)
+   {
+      retval = NC_get_chunk_raw(ncid_in, varid_in, start, &filtermask, &size, &chunk);
+      if (retval == NC_NOERR)
+      {
+         retval = nc_put_chunk_raw(ncid_out, varid_out, start, filtermask, size, chunk);
+         free(chunk);
+         chunk = NULL;
+         if (retval)
+            BAIL(retval);
+      }
+      else if (retval != NC_EEMPTY)
+         BAIL(retval);
+      retval = NC_NOERR;
+      /* Next chunk, last dimension fastest */
+      for (d = real_ndims - 1; d >= 0; d--)
+      {
+         if (++chunkindex[d] < nchunks[d])
+            break;
+         chunkindex[d] = 0;
+      }
+      if (d < 0)
+         break;
+      for (; d < real_ndims; d++)
+         start[d] = chunkindex[d] * (ndims ? chunksizes[d] : 0);
+   }
+
+exit:
+   nullfree(value);
+   return retval;
+#endif /* USE_NETCDF4 */
+}
+
 /**
  * This will copy a variable that is an array of primitive type and
  * its attributes from one file to another, assuming dimensions in the
@@ -271,6 +634,13 @@ NC_find_equal_type(int ncid1, nc_type xtype1, int ncid2, nc_type *xtype2)
  * is not a problem for netCDF-4 files, which support efficient
  * addition of variables without moving data for other variables.
  *
+ * The new variable is defined with the default storage of the output
+ * file. If that happens to be the storage of the input variable (see
+ * nc_copy_var_raw()), the stored chunks are copied without being
+ * decompressed and recompressed. To copy compressed chunks as they
+ * are, define the output variable with the storage of the input and
+ * call nc_copy_var_raw(), as nccopy does.
+ *
  * @param ncid_in File ID to copy from.
  * @param varid_in Variable ID to copy.
  * @param ncid_out File ID to copy to.
@@ -355,6 +725,12 @@ nc_copy_var(int ncid_in, int varid_in, int ncid_out)
    nc_enddef(ncid_out);
    nc_sync(ncid_out);
 
+   /* If the default storage is that of the input, copy the stored chunks. */
+   retval = nc_copy_var_raw(ncid_in, varid_in, ncid_out, varid_out);
+   if (retval != NC_EINVAL)
+      goto exit;
+   retval = NC_NOERR;
+
    /* Allocate memory for our start and count arrays. If ndims = 0
       this is a scalar, which I will treat as a 1-D array with one
       element. */
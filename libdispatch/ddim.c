@@ -124,7 +124,10 @@ nc_def_dim(int ncid, const char *name, size_t len, int *idp)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_def_dim);
-    return ncp->dispatch->def_dim(ncid, name, len, idp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_dim(ncid, name, len, idp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -155,7 +158,10 @@ nc_inq_dimid(int ncid, const char *name, int *idp)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_inq_dimid);
-    return ncp->dispatch->inq_dimid(ncid,name,idp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_dimid(ncid,name,idp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -219,7 +225,10 @@ nc_inq_dim(int ncid, int dimid, char *name, size_t *lenp)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_inq_dim);
-    return ncp->dispatch->inq_dim(ncid,dimid,name,lenp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_dim(ncid,dimid,name,lenp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -288,7 +297,10 @@ nc_rename_dim(int ncid, int dimid, const char *name)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_rename_dim);
-    return ncp->dispatch->rename_dim(ncid,dimid,name);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->rename_dim(ncid,dimid,name);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -321,7 +333,10 @@ nc_inq_ndims(int ncid, int *ndimsp)
     if(stat != NC_NOERR) return stat;
     if(ndimsp == NULL) return NC_NOERR;
     TRACE(nc_inq_ndims);
-    return ncp->dispatch->inq(ncid,ndimsp,NULL,NULL,NULL);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq(ncid,ndimsp,NULL,NULL,NULL);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -353,7 +368,10 @@ nc_inq_unlimdim(int ncid, int *unlimdimidp)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_inq_unlimdim);
-    return ncp->dispatch->inq_unlimdim(ncid,unlimdimidp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_unlimdim(ncid,unlimdimidp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -413,7 +431,10 @@ nc_inq_dimname(int ncid, int dimid, char *name)
     if(stat != NC_NOERR) return stat;
     if(name == NULL) return NC_NOERR;
     TRACE(nc_inq_dimname);
-    return ncp->dispatch->inq_dim(ncid,dimid,name,NULL);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_dim(ncid,dimid,name,NULL);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -471,7 +492,10 @@ nc_inq_dimlen(int ncid, int dimid, size_t *lenp)
     if(stat != NC_NOERR) return stat;
     if(lenp == NULL) return NC_NOERR;
     TRACE(nc_inq_dimlen);
-    return ncp->dispatch->inq_dim(ncid,dimid,NULL,lenp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_dim(ncid,dimid,NULL,lenp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** @} */
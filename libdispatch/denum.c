@@ -45,7 +45,10 @@ nc_def_enum(int ncid, nc_type base_typeid, const char *name, nc_type *typeidp)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_enum(ncid,base_typeid,name,typeidp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_enum(ncid,base_typeid,name,typeidp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup user_types
@@ -74,8 +77,11 @@ nc_insert_enum(int ncid, nc_type xtype, const char *name,
     NC *ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->insert_enum(ncid, xtype, name,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->insert_enum(ncid, xtype, name,
 				      value);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup user_types
@@ -143,7 +149,10 @@ nc_inq_enum_member(int ncid, nc_type xtype, int idx, char *name,
     NC *ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_enum_member(ncid, xtype, idx, name, value);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_enum_member(ncid, xtype, idx, name, value);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup user_types
@@ -167,6 +176,9 @@ nc_inq_enum_ident(int ncid, nc_type xtype, long long value,
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_enum_ident(ncid,xtype,value,identifier);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_enum_ident(ncid,xtype,value,identifier);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 /*! \} */  /* End of named group ...*/
@@ -139,6 +139,7 @@ nc_def_user_format(int mode_flag, NC_Dispatch *dispatch_table, char *magic_numbe
         return NC_EINVAL;
     /* Retain a pointer to the dispatch_table and a copy of the magic
      * number, if one was provided. */
+    NCLOCK();
     if (fIsSet(mode_flag,NC_UDF0))
     {
         UDF0_dispatch_table = dispatch_table;
@@ -153,8 +154,10 @@ nc_def_user_format(int mode_flag, NC_Dispatch *dispatch_table, char *magic_numbe
     }
     else
     {
+        NCUNLOCK();
         return NC_EINVAL;
     }
+    NCUNLOCK();
 
     return NC_NOERR;
 }
@@ -179,6 +182,7 @@ int
 nc_inq_user_format(int mode_flag, NC_Dispatch **dispatch_table, char *magic_number)
 {
     /* Check inputs. */
+    NCLOCK();
     if (fIsSet(mode_flag,NC_UDF0))
     {
         if (dispatch_table)
@@ -195,8 +199,10 @@ nc_inq_user_format(int mode_flag, NC_Dispatch **dispatch_table, char *magic_numb
     }
     else
     {
+        NCUNLOCK();
         return NC_EINVAL;
     }
+    NCUNLOCK();
 
     return NC_NOERR;
 }
@@ -621,6 +627,19 @@ nc__create_mp(const char *path, int cmode, size_t initialsz,
  * If a the path is a DAP URL, then the open mode is read-only.
  * Setting NC_WRITE will be ignored.
  *
+ * For a netCDF-4/HDF5 file opened read-only, the NC_LAZYGROUPS flag
+ * (or the NETCDF_LAZYGROUPS environment variable, or the
+ * NETCDF.LAZYGROUPS .rc key, set to 1) reads only the root group at
+ * open. Each other group is read the first time it is used, for
+ * example by nc_inq_varid() with its ncid; nc_inq_grps() and
+ * nc_inq_ncid() on its parent return its ncid without reading
+ * it. This makes opening a file with a deep or wide group tree much
+ * faster when only some of the groups are used. The IDs of groups
+ * depend on the order the groups are used in. Dimensions keep the IDs
+ * stored in the file; those it does not store (e.g. phony dimensions)
+ * are numbered after the largest stored ID, and in the order the
+ * groups are used in.
+ *
  * As of version 4.3.1.2, multiple calls to nc_open with the same
  * path will return the same ncid value.
  *
@@ -965,7 +984,10 @@ nc_redef(int ncid)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->redef(ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->redef(ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup datasets
@@ -1030,7 +1052,10 @@ nc_enddef(int ncid)
     NC *ncp;
     status = NC_check_id(ncid, &ncp);
     if(status != NC_NOERR) return status;
-    return ncp->dispatch->_enddef(ncid,0,1,0,1);
+    NCLOCKFILE(ncp);
+    status = ncp->dispatch->_enddef(ncid,0,1,0,1);
+    NCUNLOCKFILE(ncp);
+    return status;
 }
 
 /** \ingroup datasets
@@ -1121,7 +1146,10 @@ nc__enddef(int ncid, size_t h_minfree, size_t v_align, size_t v_minfree,
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->_enddef(ncid,h_minfree,v_align,v_minfree,r_align);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->_enddef(ncid,h_minfree,v_align,v_minfree,r_align);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup datasets
@@ -1197,7 +1225,10 @@ nc_sync(int ncid)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->sync(ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->sync(ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup datasets
@@ -1250,8 +1281,12 @@ nc_abort(int ncid)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
 
+    NCLOCKFILE(ncp);
+    NCLOCK();
     stat = ncp->dispatch->abort(ncid);
     del_from_NCList(ncp);
+    NCUNLOCK();
+    NCUNLOCKFILE(ncp);
     free_NC(ncp);
     return stat;
 }
@@ -1266,6 +1301,10 @@ nc_abort(int ncid)
     closed, its netCDF ID may be reassigned to the next netCDF dataset
     that is opened or created.
 
+    Any nonblocking requests still pending (see nc_iput_vara()) are
+    completed before the dataset is closed; if one of them fails, its
+    error is returned, but the dataset is closed all the same.
+
     \param ncid NetCDF ID, from a previous call to nc_open() or nc_create().
 
     \returns ::NC_NOERR No error.
@@ -1300,17 +1339,23 @@ int
 nc_close(int ncid)
 {
     NC* ncp;
+    int nbstat;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
 
+    NCLOCKFILE(ncp);
+    NCLOCK();
+    /* Complete any pending nonblocking requests */
+    nbstat = NC_nbcomplete(ncp);
     stat = ncp->dispatch->close(ncid,NULL);
     /* Remove from the nc list */
     if (!stat)
-    {
         del_from_NCList(ncp);
+    NCUNLOCK();
+    NCUNLOCKFILE(ncp);
+    if (!stat)
         free_NC(ncp);
-    }
-    return stat;
+    return (stat ? stat : nbstat);
 }
 
 /** \ingroup datasets
@@ -1359,17 +1404,23 @@ int
 nc_close_memio(int ncid, NC_memio* memio)
 {
     NC* ncp;
+    int nbstat;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
 
+    NCLOCKFILE(ncp);
+    NCLOCK();
+    /* Complete any pending nonblocking requests */
+    nbstat = NC_nbcomplete(ncp);
     stat = ncp->dispatch->close(ncid,memio);
     /* Remove from the nc list */
     if (!stat)
-    {
         del_from_NCList(ncp);
+    NCUNLOCK();
+    NCUNLOCKFILE(ncp);
+    if (!stat)
         free_NC(ncp);
-    }
-    return stat;
+    return (stat ? stat : nbstat);
 }
 
 /** \ingroup datasets
@@ -1476,7 +1527,10 @@ nc_set_fill(int ncid, int fillmode, int *old_modep)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->set_fill(ncid,fillmode,old_modep);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->set_fill(ncid,fillmode,old_modep);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -1549,7 +1603,10 @@ nc_inq_format(int ncid, int *formatp)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_format(ncid,formatp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_format(ncid,formatp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup datasets
@@ -1584,7 +1641,10 @@ nc_inq_format_extended(int ncid, int *formatp, int *modep)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_format_extended(ncid,formatp,modep);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_format_extended(ncid,formatp,modep);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**\ingroup datasets
@@ -1637,7 +1697,10 @@ nc_inq(int ncid, int *ndimsp, int *nvarsp, int *nattsp, int *unlimdimidp)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq(ncid,ndimsp,nvarsp,nattsp,unlimdimidp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq(ncid,ndimsp,nvarsp,nattsp,unlimdimidp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -1656,7 +1719,10 @@ nc_inq_nvars(int ncid, int *nvarsp)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq(ncid, NULL, nvarsp, NULL, NULL);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq(ncid, NULL, nvarsp, NULL, NULL);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**\ingroup datasets
@@ -1745,7 +1811,10 @@ nc_inq_type(int ncid, nc_type xtype, char *name, size_t *size)
     if(stat != NC_NOERR) /* bad ncid */
         return NC_EBADTYPE;
     /* have good ncid */
-    return ncp->dispatch->inq_type(ncid,xtype,name,size);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_type(ncid,xtype,name,size);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \defgroup dispatch dispatch functions. */
@@ -1848,6 +1917,7 @@ NC_create(const char *path0, int cmode, size_t initialsz,
     NCmodel model;
     char* newpath = NULL;
 
+    NCLOCK();
     TRACE(nc_create);
     if(path0 == NULL)
         {stat = NC_EINVAL; goto done;}
@@ -1943,6 +2013,7 @@ NC_create(const char *path0, int cmode, size_t initialsz,
 done:
     nullfree(path);
     nullfree(newpath);
+    NCUNLOCK();
     return stat;
 }
 
@@ -1983,6 +2054,7 @@ NC_open(const char *path0, int omode, int basepe, size_t *chunksizehintp,
     NCmodel model;
     char* newpath = NULL;
 
+    NCLOCK();
     TRACE(nc_open);
     if(!NC_initialized) {
         stat = nc_initialize();
@@ -2186,6 +2258,7 @@ NC_open(const char *path0, int omode, int basepe, size_t *chunksizehintp,
 done:
     nullfree(path);
     nullfree(newpath);
+    NCUNLOCK();
     return stat;
 }
 
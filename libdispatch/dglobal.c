@@ -7,8 +7,12 @@ See LICENSE.txt for license information.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef NETCDF_ENABLE_THREADSAFE
+#include <pthread.h>
+#endif
 
 #include "netcdf.h"
+#include "nc.h"
 #include "ncglobal.h"
 #include "nclist.h"
 #include "ncuri.h"
@@ -21,6 +25,12 @@ See LICENSE.txt for license information.
 /* The singleton global state object */
 static NCglobalstate* nc_globalstate = NULL;
 
+#ifdef NETCDF_ENABLE_THREADSAFE
+/* The global lock; recursive because e.g. an open may re-enter the API */
+static pthread_mutex_t nc_globallock;
+static pthread_once_t nc_globallock_once = PTHREAD_ONCE_INIT;
+#endif
+
 /* Forward */
 static int NC_createglobalstate(void);
 
@@ -70,8 +80,12 @@ done:
 NCglobalstate*
 NC_getglobalstate(void)
 {
-    if(nc_globalstate == NULL)
-        NC_createglobalstate();
+    if(nc_globalstate == NULL) {
+        NCLOCK();
+        if(nc_globalstate == NULL)
+            NC_createglobalstate();
+        NCUNLOCK();
+    }
     return nc_globalstate;
 }
 
@@ -97,6 +111,35 @@ NC_freeglobalstate(void)
 
 /** \} */
 
+#ifdef NETCDF_ENABLE_THREADSAFE
+
+static void
+NC_initgloballock(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&nc_globallock,&attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/* Acquire the global lock */
+void
+NC_lock(void)
+{
+    pthread_once(&nc_globallock_once,NC_initgloballock);
+    pthread_mutex_lock(&nc_globallock);
+}
+
+/* Release the global lock */
+void
+NC_unlock(void)
+{
+    pthread_mutex_unlock(&nc_globallock);
+}
+
+#endif /*NETCDF_ENABLE_THREADSAFE*/
+
 void
 NC_clearawsparams(struct GlobalAWS* aws)
 {
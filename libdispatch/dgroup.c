@@ -58,7 +58,10 @@ int nc_inq_ncid(int ncid, const char *name, int *grp_ncid)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_ncid(ncid,name,grp_ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_ncid(ncid,name,grp_ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Get a list of groups or subgroups from a file or groupID.
@@ -75,7 +78,10 @@ int nc_inq_grps(int ncid, int *numgrps, int *ncids)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_grps(ncid,numgrps,ncids);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_grps(ncid,numgrps,ncids);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Get the name of a group given an ID.
@@ -90,7 +96,10 @@ int nc_inq_grpname(int ncid, char *name)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_grpname(ncid,name);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_grpname(ncid,name);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Get the full path/groupname of a group/subgroup given an ID.
@@ -108,7 +117,10 @@ int nc_inq_grpname_full(int ncid, size_t *lenp, char *full_name)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_grpname_full(ncid,lenp,full_name);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_grpname_full(ncid,lenp,full_name);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Get the length of a group name given an ID.
@@ -138,7 +150,10 @@ int nc_inq_grp_parent(int ncid, int *parent_ncid)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_grp_parent(ncid,parent_ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_grp_parent(ncid,parent_ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Get a group ncid given the group name.
@@ -171,7 +186,10 @@ int nc_inq_grp_full_ncid(int ncid, const char *full_name, int *grp_ncid)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_grp_full_ncid(ncid,full_name,grp_ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_grp_full_ncid(ncid,full_name,grp_ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 
@@ -189,7 +207,10 @@ int nc_inq_varids(int ncid, int *nvars, int *varids)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_varids(ncid,nvars,varids);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_varids(ncid,nvars,varids);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Retrieve a list of dimension ids associated with a group.
@@ -207,7 +228,10 @@ int nc_inq_dimids(int ncid, int *ndims, int *dimids, int include_parents)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_dimids(ncid,ndims,dimids,include_parents);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_dimids(ncid,ndims,dimids,include_parents);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Retrieve a list of types associated with a group
@@ -225,7 +249,10 @@ int nc_inq_typeids(int ncid, int *ntypes, int *typeids)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_typeids(ncid,ntypes,typeids);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_typeids(ncid,ntypes,typeids);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Define a new group.
@@ -270,7 +297,10 @@ int nc_def_grp(int parent_ncid, const char *name, int *new_ncid)
     NC* ncp;
     int stat = NC_check_id(parent_ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_grp(parent_ncid,name,new_ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_grp(parent_ncid,name,new_ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Rename a group.
@@ -286,7 +316,10 @@ int nc_rename_grp(int grpid, const char *name)
     NC* ncp;
     int stat = NC_check_id(grpid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->rename_grp(grpid,name);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->rename_grp(grpid,name);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /*! Print the metadata for a file.
@@ -301,7 +334,10 @@ int nc_show_metadata(int ncid)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->show_metadata(ncid);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->show_metadata(ncid);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \} */
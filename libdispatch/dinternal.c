@@ -26,7 +26,8 @@ NCDISPATCH_inq_var_all(int ncid, int varid, char *name, nc_type *xtypep,
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_var_all(
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(
       ncid, varid, name, xtypep,
       ndimsp, dimidsp, nattsp,
       shufflep, deflatep, deflate_levelp, fletcher32p,
@@ -34,6 +35,8 @@ NCDISPATCH_inq_var_all(int ncid, int varid, char *name, nc_type *xtypep,
       no_fill, fill_valuep,
       endiannessp,
       idp, nparamsp, params);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 int
@@ -42,7 +45,10 @@ NCDISPATCH_get_att(int ncid, int varid, const char* name, void* value, nc_type t
    NC* ncp;
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->get_att(ncid,varid,name,value,t);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->get_att(ncid,varid,name,value,t);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /*! \} */  /* End of named group ...*/
@@ -0,0 +1,511 @@
+/* Copyright 2018 University Corporation for Atmospheric
+   Research/Unidata. See COPYRIGHT file for more info. */
+/*! \file
+Nonblocking reading and writing of variables.
+
+A call to nc_iput_vara() or nc_iget_vara() only records a request
+against the file; the data is transferred when the request is
+completed by nc_wait_all(). Completing many requests together lets
+the dispatcher reorder and combine them: for netCDF-3 files the
+requests are sorted by file offset and adjacent ones are read or
+written with one I/O operation (see NC3_wait()). For all other
+formats each request is executed as an ordinary nc_put_vara() or
+nc_get_vara().
+
+The interface follows that of PnetCDF: the caller's buffer is not
+copied, so it must not be modified (iput) or used (iget) until the
+request has been completed or cancelled.
+*/
+
+#include "config.h"
+#include <limits.h>
+#include "netcdf.h"
+#include "ncdispatch.h"
+#include "nc3dispatch.h"
+#include "nclist.h"
+
+/* The pending requests of a file */
+typedef struct NCnbqueue {
+    NClist* pending; /* NClist<NCnbreq*>, in order of posting */
+    unsigned int nextid; /* next request id, taken modulo INT_MAX+1 */
+} NCnbqueue;
+
+static void
+freereq(NCnbreq* req)
+{
+    if(req == NULL) return;
+    free(req->start);
+    free(req->count);
+    free(req);
+}
+
+/** \internal
+Record a nonblocking request.
+
+\param ncid NetCDF or group ID.
+\param varid Variable ID.
+\param startp Start index vector.
+\param countp Count vector.
+\param value The caller's buffer.
+\param memtype Type of the data in memory; NC_NAT for the
+variable's type.
+\param isput Nonzero for a write.
+\param reqidp Pointer to location for the request id.
+
+\returns ::NC_NOERR No error.
+\returns ::NC_EBADID Bad ncid.
+\returns ::NC_ENOTVAR Invalid variable ID.
+\returns ::NC_EINVAL Missing start or count.
+\returns ::NC_ENOMEM Out of memory.
+\ingroup variables
+*/
+static int
+NC_ivara(int ncid, int varid, const size_t *startp, const size_t *countp,
+         void *value, nc_type memtype, int isput, int *reqidp)
+{
+    NC* ncp;
+    NCnbreq* req = NULL;
+    int ndims;
+    int stat = NC_check_id(ncid, &ncp);
+    if(stat != NC_NOERR) return stat;
+
+    if((stat = nc_inq_varndims(ncid, varid, &ndims))) return stat;
+    /* Unlike nc_put_vara, a NULL start or count is not defaulted */
+    if(ndims > 0 && (startp == NULL || countp == NULL)) return NC_EINVAL;
+
+    if((req = calloc(1, sizeof(NCnbreq))) == NULL) return NC_ENOMEM;
+    req->isput = isput;
+    req->ncid = ncid;
+    req->varid = varid;
+    req->memtype = memtype;
+    req->value = value;
+    req->stat = NC_NOERR;
+    if(ndims > 0) {
+        req->start = malloc(sizeof(size_t) * (size_t)ndims);
+        req->count = malloc(sizeof(size_t) * (size_t)ndims);
+        if(req->start == NULL || req->count == NULL)
+            {stat = NC_ENOMEM; goto done;}
+        memcpy(req->start, startp, sizeof(size_t) * (size_t)ndims);
+        memcpy(req->count, countp, sizeof(size_t) * (size_t)ndims);
+    }
+
+    NCLOCKFILE(ncp);
+    if(ncp->nbqueue == NULL) {
+        if((ncp->nbqueue = calloc(1, sizeof(NCnbqueue))) == NULL
+           || (ncp->nbqueue->pending = nclistnew()) == NULL) {
+            free(ncp->nbqueue);
+            ncp->nbqueue = NULL;
+            stat = NC_ENOMEM;
+        }
+    }
+    if(stat == NC_NOERR) {
+        req->reqid = (int)(ncp->nbqueue->nextid++ & INT_MAX);
+        nclistpush(ncp->nbqueue->pending, req);
+        if(reqidp) *reqidp = req->reqid;
+        req = NULL;
+    }
+    NCUNLOCKFILE(ncp);
+
+done:
+    freereq(req);
+    return stat;
+}
+
+/** \internal
+Transfer the data of a set of requests.
+
+\param ncp File.
+\param nreqs Number of requests.
+\param reqs The requests; each one's stat is set.
+
+\returns ::NC_NOERR No error, or the first error of a fatal kind.
+\ingroup variables
+*/
+static int
+NC_nbexecute(NC* ncp, size_t nreqs, NCnbreq** reqs)
+{
+    size_t i;
+
+    if(nreqs == 0) return NC_NOERR;
+    if(ncp->dispatch->model == NC_FORMATX_NC3)
+        return NC3_wait(ncp, nreqs, reqs);
+    for(i = 0; i < nreqs; i++) {
+        NCnbreq* req = reqs[i];
+        const size_t* start = (req->start ? req->start : NC_coord_zero);
+        const size_t* count = (req->count ? req->count : NC_coord_one);
+        if(req->isput)
+            req->stat = ncp->dispatch->put_vara(req->ncid, req->varid, start, count,
+                                                req->value, req->memtype);
+        else
+            req->stat = ncp->dispatch->get_vara(req->ncid, req->varid, start, count,
+                                                req->value, req->memtype);
+    }
+    return NC_NOERR;
+}
+
+/** \internal
+Complete all the pending requests of a file; used by nc_close().
+
+\param ncp File.
+
+\returns ::NC_NOERR No error.
+\returns The first error of any request.
+\ingroup variables
+*/
+int
+NC_nbcomplete(NC* ncp)
+{
+    int stat = NC_NOERR;
+    NClist* pending;
+    size_t i;
+
+    if(ncp->nbqueue == NULL || nclistlength(ncp->nbqueue->pending) == 0)
+        return NC_NOERR;
+    pending = ncp->nbqueue->pending;
+    stat = NC_nbexecute(ncp, nclistlength(pending), (NCnbreq**)nclistcontents(pending));
+    for(i = 0; i < nclistlength(pending); i++) {
+        NCnbreq* req = (NCnbreq*)nclistget(pending, i);
+        if(stat == NC_NOERR) stat = req->stat;
+        freereq(req);
+    }
+    nclistclear(pending);
+    return stat;
+}
+
+/** \internal
+Discard all the pending requests of a file; used by nc_abort()
+and free_NC().
+
+\param ncp File.
+\ingroup variables
+*/
+void
+NC_nbdiscard(NC* ncp)
+{
+    size_t i;
+
+    if(ncp->nbqueue == NULL) return;
+    for(i = 0; i < nclistlength(ncp->nbqueue->pending); i++)
+        freereq((NCnbreq*)nclistget(ncp->nbqueue->pending, i));
+    nclistfree(ncp->nbqueue->pending);
+    free(ncp->nbqueue);
+    ncp->nbqueue = NULL;
+}
+
+/* Distance from id base to id, modulo INT_MAX+1 */
+#define IDDIST(base,id) (((unsigned int)(id) - (unsigned int)(base)) & INT_MAX)
+
+/* Find a pending request by id; return its index or -1. The
+ * pending list is in order of posting; the ids wrap to 0 after
+ * INT_MAX, so they increase with their distance from the id of the
+ * oldest pending request rather than with their value. */
+static long
+findreq(NCnbqueue* q, int reqid)
+{
+    size_t lo = 0, hi;
+    unsigned int dist;
+    int base;
+    if(q == NULL || reqid < 0 || nclistlength(q->pending) == 0) return -1;
+    hi = nclistlength(q->pending);
+    base = ((NCnbreq*)nclistget(q->pending, 0))->reqid;
+    dist = IDDIST(base, reqid);
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        NCnbreq* req = (NCnbreq*)nclistget(q->pending, mid);
+        unsigned int middist = IDDIST(base, req->reqid);
+        if(middist == dist) return (long)mid;
+        if(middist < dist) lo = mid + 1; else hi = mid;
+    }
+    return -1;
+}
+
+/** \internal
+Move the requested ids from the queue of a file into a list, in
+the order of \p reqids.
+
+\param ncp File.
+\param nreqs Number of request ids, or ::NC_REQ_ALL.
+\param reqids The ids.
+\param statuses Per-id status; NC_EINVAL for an id which is not
+pending (or is repeated).
+\param selected List into which the requests are moved.
+
+\ingroup variables
+*/
+static void
+NC_nbselect(NC* ncp, int nreqs, const int* reqids, int* statuses, NClist* selected)
+{
+    NCnbqueue* q = ncp->nbqueue;
+    size_t j, k;
+    int i;
+
+    if(q == NULL && nreqs == NC_REQ_ALL) return;
+    if(nreqs == NC_REQ_ALL) {
+        for(j = 0; j < nclistlength(q->pending); j++)
+            nclistpush(selected, nclistget(q->pending, j));
+        nclistclear(q->pending);
+        return;
+    }
+    for(i = 0; i < nreqs; i++) {
+        long pos;
+        NCnbreq* req;
+        if(statuses) statuses[i] = NC_NOERR;
+        if(reqids[i] == NC_REQ_NULL) continue;
+        if((pos = findreq(q, reqids[i])) < 0
+           || (req = (NCnbreq*)nclistget(q->pending, (size_t)pos))->selected) {
+            if(statuses) statuses[i] = NC_EINVAL;
+            continue;
+        }
+        req->selected = 1;
+        nclistpush(selected, req);
+    }
+    /* Squeeze the selected requests out of the queue in one pass */
+    if(q == NULL) return;
+    for(j = 0, k = 0; j < nclistlength(q->pending); j++) {
+        NCnbreq* req = (NCnbreq*)nclistget(q->pending, j);
+        if(!req->selected) nclistset(q->pending, k++, req);
+    }
+    nclistsetlength(q->pending, k);
+}
+
+/** \internal
+Report the status of each request of a list back to the caller,
+and free the requests.
+
+\param nreqs Number of request ids, or ::NC_REQ_ALL.
+\param reqids The ids, as given to NC_nbselect(); each one found
+is set to ::NC_REQ_NULL.
+\param statuses Per-id status.
+\param selected The requests, as built by NC_nbselect().
+
+\returns The first error of any request or id.
+\ingroup variables
+*/
+static int
+NC_nbreport(int nreqs, int* reqids, int* statuses, NClist* selected)
+{
+    int stat = NC_NOERR;
+    size_t j;
+    int i;
+
+    if(nreqs == NC_REQ_ALL) {
+        for(j = 0; j < nclistlength(selected); j++) {
+            NCnbreq* req = (NCnbreq*)nclistget(selected, j);
+            if(stat == NC_NOERR) stat = req->stat;
+        }
+    } else {
+        /* selected is in the order of reqids */
+        for(i = 0, j = 0; i < nreqs; i++) {
+            NCnbreq* req = (NCnbreq*)nclistget(selected, j);
+            int rstat = (statuses ? statuses[i] : NC_NOERR);
+            if(req != NULL && reqids[i] == req->reqid) {
+                rstat = req->stat;
+                reqids[i] = NC_REQ_NULL;
+                j++;
+            } else if(reqids[i] != NC_REQ_NULL)
+                rstat = NC_EINVAL;
+            if(statuses) statuses[i] = rstat;
+            if(stat == NC_NOERR) stat = rstat;
+        }
+    }
+    for(j = 0; j < nclistlength(selected); j++)
+        freereq((NCnbreq*)nclistget(selected, j));
+    return stat;
+}
+
+/** \name Nonblocking Reading and Writing of Variables
+
+Functions to post reads and writes of array sections, and to
+complete them together. */
+/*! \{ */ /* All these functions are part of this named group... */
+
+/**
+\ingroup variables
+Post a nonblocking write of an array of values.
+
+The values are not written until the request is completed by
+nc_wait_all(), or by nc_close(); until then the buffer \p op must
+not be modified. Requests on the same file are completed together,
+so there is no point in waiting for each one separately: post all
+the writes (and reads) of a time step, then wait once.
+
+For netCDF-3 files the requests are sorted by their position in
+the file and adjacent ones are written with one I/O operation, so
+a set of small writes (e.g. one record of many record variables)
+costs about as much as one large write. If two requests in the same
+set write overlapping data, the result is undefined.
+
+\param ncid NetCDF or group ID, from a previous call to nc_open(),
+nc_create(), nc_def_grp(), or associated inquiry functions such as
+nc_inq_ncid().
+\param varid Variable ID
+\param startp Start vector with one element for each dimension. Unlike
+nc_put_vara(), it may not be NULL unless the variable is a scalar.
+\param countp Count vector with one element for each dimension. Unlike
+nc_put_vara(), it may not be NULL unless the variable is a scalar.
+\param op Pointer where the data will be found. The elements of this
+array must be of the type of the variable.
+\param reqidp Pointer to location for the id of the request. \ref
+ignored_if_null.
+
+\returns ::NC_NOERR No error.
+\returns ::NC_EBADID Bad ncid.
+\returns ::NC_ENOTVAR Bad var id.
+\returns ::NC_EINVAL NULL start or count for a non-scalar variable.
+\returns ::NC_ENOMEM Out of memory.
+
+Errors in the request itself (e.g. ::NC_EEDGE) are only reported
+by nc_wait_all().
+*/
+int
+nc_iput_vara(int ncid, int varid, const size_t *startp,
+             const size_t *countp, const void *op, int *reqidp)
+{
+    return NC_ivara(ncid, varid, startp, countp, (void*)op, NC_NAT, 1, reqidp);
+}
+
+/**
+\ingroup variables
+Post a nonblocking read of an array of values.
+
+The values are not read until the request is completed by
+nc_wait_all(); until then the contents of \p ip are undefined.
+See nc_iput_vara() for the arguments.
+
+\param ncid NetCDF or group ID.
+\param varid Variable ID
+\param startp Start vector with one element for each dimension.
+\param countp Count vector with one element for each dimension.
+\param ip Pointer where the data will be stored.
+\param reqidp Pointer to location for the id of the request. \ref
+ignored_if_null.
+
+\returns ::NC_NOERR No error.
+\returns ::NC_EBADID Bad ncid.
+\returns ::NC_ENOTVAR Bad var id.
+\returns ::NC_EINVAL NULL start or count for a non-scalar variable.
+\returns ::NC_ENOMEM Out of memory.
+*/
+int
+nc_iget_vara(int ncid, int varid, const size_t *startp,
+             const size_t *countp, void *ip, int *reqidp)
+{
+    return NC_ivara(ncid, varid, startp, countp, ip, NC_NAT, 0, reqidp);
+}
+
+/**
+\ingroup variables
+Complete a set of nonblocking requests.
+
+All the selected requests are carried out, in an order chosen by
+the library, and then their buffers may be reused. Each completed
+or unknown id in \p reqids is set to ::NC_REQ_NULL.
+
+\param ncid NetCDF or group ID.
+\param nreqs Number of ids in \p reqids, or ::NC_REQ_ALL to complete
+all the pending requests of the file, in which case \p reqids and
+\p statuses are ignored.
+\param reqids Ids returned by nc_iput_vara() and nc_iget_vara(); an
+id of ::NC_REQ_NULL is skipped.
+\param statuses If not NULL, receives the status of each request;
+an id which is not pending gets ::NC_EINVAL.
+
+\returns ::NC_NOERR No error.
+\returns ::NC_EBADID Bad ncid.
+\returns ::NC_EINVAL Negative \p nreqs, or NULL \p reqids.
+\returns The first error of any request.
+*/
+int
+nc_wait_all(int ncid, int nreqs, int *reqids, int *statuses)
+{
+    NC* ncp;
+    NClist* selected = NULL;
+    int rstat;
+    int stat = NC_check_id(ncid, &ncp);
+    if(stat != NC_NOERR) return stat;
+    if(nreqs != NC_REQ_ALL && (nreqs < 0 || (nreqs > 0 && reqids == NULL)))
+        return NC_EINVAL;
+
+    if((selected = nclistnew()) == NULL) return NC_ENOMEM;
+    NCLOCKFILE(ncp);
+    NC_nbselect(ncp, nreqs, reqids, statuses, selected);
+    stat = NC_nbexecute(ncp, nclistlength(selected), (NCnbreq**)nclistcontents(selected));
+    NCUNLOCKFILE(ncp);
+    rstat = NC_nbreport(nreqs, reqids, statuses, selected);
+    if(stat == NC_NOERR) stat = rstat;
+    nclistfree(selected);
+    return stat;
+}
+
+/**
+\ingroup variables
+Cancel a set of nonblocking requests without carrying them out.
+
+\param ncid NetCDF or group ID.
+\param nreqs Number of ids in \p reqids, or ::NC_REQ_ALL to cancel all
+the pending requests of the file.
+\param reqids Ids returned by nc_iput_vara() and nc_iget_vara(); each
+cancelled id is set to ::NC_REQ_NULL.
+\param statuses If not NULL, receives the status of each
+cancellation; an id which is not pending gets ::NC_EINVAL.
+
+\returns ::NC_NOERR No error.
+\returns ::NC_EBADID Bad ncid.
+\returns ::NC_EINVAL Bad arguments, or an id which is not pending.
+*/
+int
+nc_cancel(int ncid, int nreqs, int *reqids, int *statuses)
+{
+    NC* ncp;
+    NClist* selected = NULL;
+    int stat = NC_check_id(ncid, &ncp);
+    if(stat != NC_NOERR) return stat;
+    if(nreqs != NC_REQ_ALL && (nreqs < 0 || (nreqs > 0 && reqids == NULL)))
+        return NC_EINVAL;
+
+    if((selected = nclistnew()) == NULL) return NC_ENOMEM;
+    NCLOCKFILE(ncp);
+    NC_nbselect(ncp, nreqs, reqids, statuses, selected);
+    NCUNLOCKFILE(ncp);
+    stat = NC_nbreport(nreqs, reqids, statuses, selected);
+    nclistfree(selected);
+    return stat;
+}
+
+/*! \} */ /* End of named group ...*/
+
+/** \name Typed Nonblocking Writes and Reads
+
+The nc_iput_vara_TYPE() and nc_iget_vara_TYPE() functions convert
+between the type of the variable and the TYPE of the buffer, like
+nc_put_vara_TYPE() and nc_get_vara_TYPE(). */
+/*! \{ */
+
+#define NCIVARA(Abbrv, Type, Memtype) \
+int \
+nc_iput_vara_##Abbrv(int ncid, int varid, const size_t *startp, \
+                     const size_t *countp, const Type *op, int *reqidp) \
+{ \
+    return NC_ivara(ncid, varid, startp, countp, (void*)op, Memtype, 1, reqidp); \
+} \
+int \
+nc_iget_vara_##Abbrv(int ncid, int varid, const size_t *startp, \
+                     const size_t *countp, Type *ip, int *reqidp) \
+{ \
+    return NC_ivara(ncid, varid, startp, countp, (void*)ip, Memtype, 0, reqidp); \
+}
+
+NCIVARA(text, char, NC_CHAR)
+NCIVARA(uchar, unsigned char, T_uchar)
+NCIVARA(schar, signed char, T_schar)
+NCIVARA(short, short, T_short)
+NCIVARA(int, int, T_int)
+NCIVARA(long, long, T_long)
+NCIVARA(float, float, T_float)
+NCIVARA(double, double, T_double)
+NCIVARA(ushort, unsigned short, T_ushort)
+NCIVARA(uint, unsigned int, T_uint)
+NCIVARA(longlong, long long, T_longlong)
+NCIVARA(ulonglong, unsigned long long, T_ulonglong)
+
+/*! \} */ /* End of named group ...*/
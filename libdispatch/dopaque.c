@@ -35,7 +35,10 @@ nc_def_opaque(int ncid, size_t size, const char *name, nc_type *xtypep)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_opaque(ncid,size,name,xtypep);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_opaque(ncid,size,name,xtypep);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup user_types
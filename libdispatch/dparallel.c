@@ -392,7 +392,10 @@ nc_var_par_access(int ncid, int varid, int par_access)
     if ((stat = NC_check_id(ncid, &ncp)))
        return stat;
 
-    return ncp->dispatch->var_par_access(ncid,varid,par_access);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->var_par_access(ncid,varid,par_access);
+    NCUNLOCKFILE(ncp);
+    return stat;
 #endif
 }
 
@@ -165,6 +165,7 @@ nc_plugin_path_ndirs(size_t* ndirsp)
     size_t ndirs = 0;
     struct NCglobalstate* gs = NC_getglobalstate();
 
+    NCLOCK();
     if(gs->pluginpaths == NULL) gs->pluginpaths = nclistnew(); /* suspenders and belt */
     ndirs = nclistlength(gs->pluginpaths);
 
@@ -187,6 +188,7 @@ nc_plugin_path_ndirs(size_t* ndirsp)
     }
     if(ndirsp) *ndirsp = ndirs;
 done:
+    NCUNLOCK();
     return NCTHROW(stat);
 }
 
@@ -212,6 +214,7 @@ nc_plugin_path_get(NCPluginList* dirs)
     struct NCglobalstate* gs = NC_getglobalstate();
     size_t i;
 
+    NCLOCK();
     if(gs->pluginpaths == NULL) gs->pluginpaths = nclistnew(); /* suspenders and belt */
     if(dirs == NULL) goto done;
     dirs->ndirs = nclistlength(gs->pluginpaths);
@@ -254,6 +257,7 @@ nc_plugin_path_get(NCPluginList* dirs)
 #endif /*NETCDF_ENABLE_NCZARR_FILTERS*/
     }
 done:
+    NCUNLOCK();
     return NCTHROW(stat);
 }
 
@@ -273,6 +277,7 @@ nc_plugin_path_set(NCPluginList* dirs)
     int stat = NC_NOERR;
     struct NCglobalstate* gs = NC_getglobalstate();
 
+    NCLOCK();
     if(dirs == NULL) {stat = NC_EINVAL; goto done;}
 
     /* Clear the current dir list */
@@ -296,6 +301,7 @@ nc_plugin_path_set(NCPluginList* dirs)
 #endif
 
 done:
+    NCUNLOCK();
     return NCTHROW(stat);
 }
 
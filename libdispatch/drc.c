@@ -82,6 +82,7 @@ nc_rc_get(const char* key)
     NCglobalstate* ncg = NULL;
     char* value = NULL;
 
+    NCLOCK();
     if(!NC_initialized) nc_initialize();
 
     ncg = NC_getglobalstate();
@@ -90,6 +91,7 @@ nc_rc_get(const char* key)
     value = NC_rclookup(key,NULL,NULL);
 done:
     value = nulldup(value);   
+    NCUNLOCK();
     return value;
 }
 
@@ -108,6 +110,7 @@ nc_rc_set(const char* key, const char* value)
     int stat = NC_NOERR;
     NCglobalstate* ncg = NULL;
 
+    NCLOCK();
     if(!NC_initialized) nc_initialize();
 
     ncg = NC_getglobalstate();
@@ -115,6 +118,7 @@ nc_rc_set(const char* key, const char* value)
     if(ncg->rcinfo->ignore) goto done;;
     stat = NC_rcfile_insert(key,NULL,NULL,value);
 done:
+    NCUNLOCK();
     return stat;
 }
 
@@ -301,6 +305,49 @@ NC_rclookupx(NCURI* uri, const char* key)
     return result;
 }
 
+/**
+ * Look up a parameter that may be set either by an environment
+ * variable or by an .rc key; a non-empty environment variable
+ * takes precedence.
+ * @param uri to match the .rc key against; may be NULL
+ * @param envkey name of the environment variable
+ * @param rckey .rc key to lookup
+ * @return the value, or NULL if neither is set to a non-empty value.
+ */
+const char*
+NC_rclookupenv(NCURI* uri, const char* envkey, const char* rckey)
+{
+    const char* val = getenv(envkey);
+    if(val == NULL || strlen(val) == 0)
+        val = (uri == NULL ? NC_rclookup(rckey,NULL,NULL) : NC_rclookupx(uri,rckey));
+    if(val == NULL || strlen(val) == 0)
+        return NULL;
+    return val;
+}
+
+/**
+ * Look up a non-negative integer parameter as NC_rclookupenv() does.
+ * @param uri to match the .rc key against; may be NULL
+ * @param envkey name of the environment variable
+ * @param rckey .rc key to lookup
+ * @param dfalt value if the parameter is not set or not a number
+ * @return the value of the parameter or dfalt.
+ */
+size_t
+NC_rclookupsize(NCURI* uri, const char* envkey, const char* rckey, size_t dfalt)
+{
+    const char* val = NC_rclookupenv(uri,envkey,rckey);
+    char* endp = NULL;
+    unsigned long long n;
+
+    if(val == NULL)
+        return dfalt;
+    n = strtoull(val,&endp,10);
+    if(endp == val || *endp != '\0')
+        return dfalt;
+    return (size_t)n;
+}
+
 #if 0
 /*!
 Set the absolute path to use for the rc file.
@@ -70,9 +70,15 @@ nc_inq_type_equal(int ncid1, nc_type typeid1, int ncid2,
 		  nc_type typeid2, int *equal)
 {
     NC* ncp1;
+    NC* ncp2 = NULL;
     int stat = NC_check_id(ncid1,&ncp1);
     if(stat != NC_NOERR) return stat;
-    return ncp1->dispatch->inq_type_equal(ncid1,typeid1,ncid2,typeid2,equal);
+    /* Both files are inspected; a bad ncid2 is reported by the dispatcher */
+    if(NC_check_id(ncid2,&ncp2) != NC_NOERR) ncp2 = NULL;
+    NCLOCKFILES(ncp1,ncp2);
+    stat = ncp1->dispatch->inq_type_equal(ncid1,typeid1,ncid2,typeid2,equal);
+    NCUNLOCKFILES(ncp1,ncp2);
+    return stat;
 }
 
 /** \name Learning about User-Defined Types
@@ -104,7 +110,10 @@ nc_inq_typeid(int ncid, const char *name, nc_type *typeidp)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_typeid(ncid,name,typeidp);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_typeid(ncid,name,typeidp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup user_types
@@ -149,8 +158,11 @@ nc_inq_user_type(int ncid, nc_type xtype, char *name, size_t *size,
     NC *ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->inq_user_type(ncid, xtype, name, size,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_user_type(ncid, xtype, name, size,
 					base_nc_typep, nfieldsp, classp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 /*! \} */  /* End of named group ...*/
 
@@ -220,8 +220,11 @@ nc_def_var(int ncid, const char *name, nc_type xtype,
     if ((stat = NC_check_id(ncid, &ncp)))
         return stat;
     TRACE(nc_def_var);
-    return ncp->dispatch->def_var(ncid, name, xtype, ndims,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var(ncid, name, xtype, ndims,
                                   dimidsp, varidp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -318,7 +321,10 @@ nc_def_var_fill(int ncid, int varid, int no_fill, const void *fill_value)
      * fill_value argument. */
     if (varid == NC_GLOBAL) return NC_EGLOBAL;
 
-    return ncp->dispatch->def_var_fill(ncid,varid,no_fill,fill_value);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var_fill(ncid,varid,no_fill,fill_value);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -463,7 +469,10 @@ nc_def_var_deflate(int ncid, int varid, int shuffle, int deflate, int deflate_le
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_var_deflate(ncid,varid,shuffle,deflate,deflate_level);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var_deflate(ncid,varid,shuffle,deflate,deflate_level);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -565,7 +574,10 @@ nc_def_var_quantize(int ncid, int varid, int quantize_mode, int nsd)
 
     /* Using NC_GLOBAL is illegal. */
     if (varid == NC_GLOBAL) return NC_EGLOBAL;
-    return ncp->dispatch->def_var_quantize(ncid,varid,quantize_mode,nsd);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var_quantize(ncid,varid,quantize_mode,nsd);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -611,7 +623,10 @@ nc_def_var_fletcher32(int ncid, int varid, int fletcher32)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_var_fletcher32(ncid,varid,fletcher32);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var_fletcher32(ncid,varid,fletcher32);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -731,8 +746,11 @@ nc_def_var_chunking(int ncid, int varid, int storage, const size_t *chunksizesp)
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_var_chunking(ncid, varid, storage,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var_chunking(ncid, varid, storage,
                                            chunksizesp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -809,7 +827,10 @@ nc_def_var_endian(int ncid, int varid, int endian)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_var_endian(ncid,varid,endian);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_var_endian(ncid,varid,endian);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -947,7 +968,10 @@ nc_rename_var(int ncid, int varid, const char *name)
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_rename_var);
-    return ncp->dispatch->rename_var(ncid, varid, name);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->rename_var(ncid, varid, name);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 /** @} */
 
@@ -1397,8 +1421,11 @@ nc_set_var_chunk_cache(int ncid, int varid, size_t size, size_t nelems,
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->set_var_chunk_cache(ncid, varid, size,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->set_var_chunk_cache(ncid, varid, size,
                                               nelems, preemption);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /**
@@ -1438,8 +1465,11 @@ nc_get_var_chunk_cache(int ncid, int varid, size_t *sizep, size_t *nelemsp,
     NC* ncp;
     int stat = NC_check_id(ncid, &ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->get_var_chunk_cache(ncid, varid, sizep,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->get_var_chunk_cache(ncid, varid, sizep,
                                               nelemsp, preemptionp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 #ifndef USE_NETCDF4
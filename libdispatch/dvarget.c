@@ -101,7 +101,9 @@ NC_get_vara(int ncid, int varid,
       stat = NC_check_nulls(ncid, varid, start, &my_count, NULL);
       if(stat != NC_NOERR) return stat;
    }
+   NCLOCKFILE(ncp);
    stat =  ncp->dispatch->get_vara(ncid,varid,start,my_count,value,memtype);
+   NCUNLOCKFILE(ncp);
    if(edges == NULL) free(my_count);
    return stat;
 }
@@ -138,6 +140,218 @@ NC_get_var(int ncid, int varid, void *value, nc_type memtype)
    return NC_get_vara(ncid, varid, NC_coord_zero, NULL, value, memtype);
 }
 
+/* Upper bound (in bytes) of the temporary buffer used by
+   NCDEFAULT_get_vars to read a bounding block of a strided request. */
+#define NC_VARS_BLOCKSIZE ((size_t)(4*1024*1024))
+
+/* Bounding blocks are only used while they hold at most this many
+   elements per requested element; otherwise reading single elements
+   is cheaper than converting and discarding the rest of the block. */
+#define NC_VARS_MAXSTRIDE 16
+
+/**
+ * @internal Copy every stride'th element of a block into memory.
+ *
+ * The block has shape bcount[0..rank-1] (C order); the elements
+ * to extract are at (k[i]*stride[i]) for 0 <= k[i] < edges[i].
+ *
+ * @param rank Number of dimensions in the block.
+ * @param bcount Shape of the block.
+ * @param edges Number of elements to extract in each dimension.
+ * @param stride Distance between extracted elements.
+ * @param elemsize Size in bytes of one element.
+ * @param block Block read from the file.
+ * @param memptr Where to store the extracted elements.
+ *
+ * @return Pointer just past the last stored element.
+ */
+static char*
+vars_gather(int rank, const size_t* bcount, const size_t* edges,
+            const ptrdiff_t* stride, size_t elemsize,
+            const char* block, char* memptr)
+{
+    int i;
+    size_t k;
+    size_t index[NC_MAX_VAR_DIMS];
+    size_t boxstride[NC_MAX_VAR_DIMS]; /* in bytes */
+    size_t last = (size_t)(rank-1);
+    size_t step;
+
+    boxstride[last] = elemsize;
+    for(i=rank-2;i>=0;i--)
+        boxstride[i] = boxstride[i+1] * bcount[i+1];
+    step = boxstride[last] * (size_t)stride[last];
+    memset(index,0,sizeof(index));
+
+    for(;;) {
+	const char* src = block;
+	for(i=0;i<(int)last;i++)
+	    src += index[i] * (size_t)stride[i] * boxstride[i];
+	/* Innermost dimension */
+	switch (elemsize) {
+	case 1:
+	    for(k=0;k<edges[last];k++,src+=step,memptr+=1)
+	        *memptr = *src;
+	    break;
+	case 2:
+	    for(k=0;k<edges[last];k++,src+=step,memptr+=2)
+	        memcpy(memptr,src,2);
+	    break;
+	case 4:
+	    for(k=0;k<edges[last];k++,src+=step,memptr+=4)
+	        memcpy(memptr,src,4);
+	    break;
+	case 8:
+	    for(k=0;k<edges[last];k++,src+=step,memptr+=8)
+	        memcpy(memptr,src,8);
+	    break;
+	default:
+	    for(k=0;k<edges[last];k++,src+=step,memptr+=elemsize)
+	        memcpy(memptr,src,elemsize);
+	    break;
+	}
+	/* Advance the outer dimensions */
+	for(i=(int)last-1;i>=0;i--) {
+	    if(++index[i] < edges[i]) break;
+	    index[i] = 0;
+	}
+	if(i < 0) break;
+    }
+    return memptr;
+}
+
+/**
+ * @internal Read the strided elements of a block one at a time.
+ *
+ * Used to recompute the exact status of a block whose bulk read
+ * reported NC_ERANGE, since the range error may have come from
+ * an element that was not requested.
+ *
+ * @return The combined status of the single element reads.
+ */
+static int
+vars_get_elements(int ncid, int varid, int rank, const size_t* start,
+                  const size_t* edges, const ptrdiff_t* stride,
+                  char* memptr, size_t memtypelen, nc_type memtype)
+{
+    int status = NC_NOERR;
+    struct GETodometer odom;
+
+    odom_init(&odom,rank,start,edges,stride);
+    while(odom_more(&odom)) {
+	int localstatus = NC_get_vara(ncid,varid,odom.index,NC_coord_one,memptr,memtype);
+	if(localstatus != NC_NOERR) {
+	    if(status == NC_NOERR || localstatus != NC_ERANGE)
+	        status = localstatus;
+	}
+	memptr += memtypelen;
+	odom_next(&odom);
+    }
+    return status;
+}
+
+/**
+ * @internal Read a strided hyperslab by reading bounding blocks.
+ *
+ * Instead of one NC_get_vara per element, the bounding box of the
+ * innermost dimensions (at most NC_VARS_BLOCKSIZE bytes) is read in
+ * a single call and the strided elements are then gathered in
+ * memory. When even one row does not fit, the fastest dimension is
+ * split into several blocks. The caller guarantees that the
+ * bounding box of the whole request lies inside the variable and
+ * that memtype is a fixed size atomic type.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_ENOMEM Out of memory.
+ */
+static int
+vars_get_blocked(int ncid, int varid, int rank, const size_t* start,
+                 const size_t* edges, const ptrdiff_t* stride,
+                 char* memptr, size_t memtypelen, nc_type memtype)
+{
+    int status = NC_NOERR;
+    int i, blockdim;
+    int last = rank - 1;
+    size_t boxlen, per, done;
+    size_t span[NC_MAX_VAR_DIMS];
+    size_t bstart[NC_MAX_VAR_DIMS];
+    size_t bcount[NC_MAX_VAR_DIMS];
+    size_t bedges[NC_MAX_VAR_DIMS];
+    struct GETodometer odom;
+    char* block = NULL;
+
+    for(i=0;i<rank;i++)
+	span[i] = (edges[i]-1)*(size_t)stride[i] + 1;
+
+    /* Choose the outermost dimension of the bounding block */
+    blockdim = last;
+    boxlen = span[last];
+    if(boxlen * memtypelen > NC_VARS_BLOCKSIZE) {
+	/* Split the fastest dimension */
+	per = NC_VARS_BLOCKSIZE / ((size_t)stride[last] * memtypelen);
+	if(per == 0) per = 1;
+    } else {
+	size_t nelems = edges[last];
+	per = edges[last];
+	for(i=last-1;i>=0;i--) {
+	    if(boxlen * span[i] > nelems * edges[i] * NC_VARS_MAXSTRIDE) break;
+	    if(boxlen * span[i] * memtypelen > NC_VARS_BLOCKSIZE) break;
+	    boxlen *= span[i];
+	    nelems *= edges[i];
+	    blockdim = i;
+	}
+    }
+    if((block = (char*)malloc((boxlen/span[last])
+			       * ((per-1)*(size_t)stride[last]+1)
+			       * memtypelen)) == NULL)
+	return NC_ENOMEM;
+
+    /* Walk the dimensions outside the block */
+    odom_init(&odom,blockdim,start,edges,stride);
+    do {
+	for(done=0;done<edges[last];done+=bedges[last]) {
+	    int localstatus;
+	    char* next;
+	    for(i=0;i<rank;i++) {
+		if(i < blockdim) {
+		    bstart[i] = odom.index[i];
+		    bcount[i] = 1;
+		    bedges[i] = 1;
+		} else {
+		    bstart[i] = start[i];
+		    bcount[i] = span[i];
+		    bedges[i] = edges[i];
+		}
+	    }
+	    bedges[last] = edges[last] - done;
+	    if(bedges[last] > per) bedges[last] = per;
+	    bstart[last] = start[last] + done*(size_t)stride[last];
+	    bcount[last] = (bedges[last]-1)*(size_t)stride[last] + 1;
+
+	    localstatus = NC_get_vara(ncid,varid,bstart,bcount,block,memtype);
+	    if(localstatus != NC_NOERR && localstatus != NC_ERANGE)
+		{status = localstatus; goto done;}
+	    next = vars_gather(rank-blockdim,bcount+blockdim,bedges+blockdim,
+			       stride+blockdim,memtypelen,block,memptr);
+	    if(localstatus == NC_ERANGE) {
+		/* The range error may come from an element that
+		   was not requested; only the requested ones count */
+		localstatus = vars_get_elements(ncid,varid,rank,bstart,bedges,stride,
+						memptr,memtypelen,memtype);
+		if(localstatus != NC_NOERR) {
+		    if(status == NC_NOERR || localstatus != NC_ERANGE)
+			status = localstatus;
+		}
+	    }
+	    memptr = next;
+	}
+    } while(blockdim > 0 && odom_next(&odom));
+
+done:
+    nullfree(block);
+    return status;
+}
+
 /** \internal
 \ingroup variables
  Most dispatch tables will use the default procedures
@@ -256,6 +470,21 @@ NCDEFAULT_get_vars(int ncid, int varid, const size_t * start,
       return NC_get_vara(ncid, varid, mystart, myedges, value, memtype);
    }
 
+   /* Read bounding blocks and gather in memory when the strides are
+      small enough and the bounding box lies inside the variable */
+   if(memtype <= NC_MAX_ATOMIC_TYPE && memtype != NC_STRING
+      && mystride[rank-1] <= NC_VARS_MAXSTRIDE) {
+      int inside = 1;
+      for(i=0;i<rank;i++) {
+	 size_t dimlen = (i == 0 && isrecvar ? numrecs : varshape[i]);
+	 if(mystart[i] + (myedges[i]-1)*(size_t)mystride[i] >= dimlen)
+	    inside = 0;
+      }
+      if(inside)
+	 return vars_get_blocked(ncid,varid,rank,mystart,myedges,mystride,
+				 value,(size_t)memtypelen,memtype);
+   }
+
    /* memptr indicates where to store the next value */
    memptr = value;
 
@@ -591,8 +820,10 @@ NC_get_vars(int ncid, int varid, const size_t *start,
       if(stat != NC_NOERR) return stat;
    }
 
+   NCLOCKFILE(ncp);
    stat = ncp->dispatch->get_vars(ncid,varid,start,my_count,my_stride,
                                   value,memtype);
+   NCUNLOCKFILE(ncp);
    if(edges == NULL) free(my_count);
    if(stride == NULL) free(my_stride);
    return stat;
@@ -653,8 +884,10 @@ NC_get_varm(int ncid, int varid, const size_t *start,
       if(stat != NC_NOERR) return stat;
    }
 
+   NCLOCKFILE(ncp);
    stat = ncp->dispatch->get_varm(ncid, varid, start, my_count, my_stride,
                                   map, value, memtype);
+   NCUNLOCKFILE(ncp);
    if(edges == NULL) free(my_count);
    if(stride == NULL) free(my_stride);
    return stat;
@@ -62,7 +62,10 @@ nc_inq_varid(int ncid, const char *name, int *varidp)
    NC* ncp;
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
-   return ncp->dispatch->inq_varid(ncid, name, varidp);
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_varid(ncid, name, varidp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -128,10 +131,13 @@ nc_inq_var(int ncid, int varid, char *name, nc_type *xtypep,
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_inq_var);
-   return ncp->dispatch->inq_var_all(ncid, varid, name, xtypep, ndimsp,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(ncid, varid, name, xtypep, ndimsp,
 				     dimidsp, nattsp, NULL, NULL, NULL,
 				     NULL, NULL, NULL, NULL, NULL, NULL,
 				     NULL,NULL,NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -334,7 +340,8 @@ nc_inq_var_deflate(int ncid, int varid, int *shufflep, int *deflatep, int *defla
    /* also get the shuffle state */
    if(!shufflep)
        return NC_NOERR;
-   return ncp->dispatch->inq_var_all(
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(
       ncid, varid,
       NULL, /*name*/
       NULL, /*xtypep*/
@@ -352,6 +359,8 @@ nc_inq_var_deflate(int ncid, int varid, int *shufflep, int *deflatep, int *defla
       NULL, /*endianp*/
       NULL, NULL, NULL
       );
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /** \ingroup variables
@@ -381,7 +390,8 @@ nc_inq_var_fletcher32(int ncid, int varid, int *fletcher32p)
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_inq_var_fletcher32);
-   return ncp->dispatch->inq_var_all(
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(
       ncid, varid,
       NULL, /*name*/
       NULL, /*xtypep*/
@@ -399,6 +409,8 @@ nc_inq_var_fletcher32(int ncid, int varid, int *fletcher32p)
       NULL, /*endianp*/
       NULL, NULL, NULL
       );
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -469,10 +481,13 @@ nc_inq_var_chunking(int ncid, int varid, int *storagep, size_t *chunksizesp)
    int stat = NC_check_id(ncid, &ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_inq_var_chunking);
-   return ncp->dispatch->inq_var_all(ncid, varid, NULL, NULL, NULL, NULL,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(ncid, varid, NULL, NULL, NULL, NULL,
 				     NULL, NULL, NULL, NULL, NULL, storagep,
 				     chunksizesp, NULL, NULL, NULL,
                                      NULL, NULL, NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /** \ingroup variables
@@ -507,7 +522,8 @@ nc_inq_var_fill(int ncid, int varid, int *no_fill, void *fill_valuep)
    if(stat != NC_NOERR) return stat;
    TRACE(nc_inq_var_fill);
 
-   return ncp->dispatch->inq_var_all(
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(
       ncid,varid,
       NULL, /*name*/
       NULL, /*xtypep*/
@@ -525,6 +541,8 @@ nc_inq_var_fill(int ncid, int varid, int *no_fill, void *fill_valuep)
       NULL, /*endianp*/
       NULL, NULL, NULL
       );
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /** @ingroup variables
@@ -553,8 +571,11 @@ nc_inq_var_quantize(int ncid, int varid, int *quantize_modep, int *nsdp)
    /* Using NC_GLOBAL is illegal. */
    if (varid == NC_GLOBAL) return NC_EGLOBAL;
 
-   return ncp->dispatch->inq_var_quantize(ncid, varid,
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_quantize(ncid, varid,
 					  quantize_modep, nsdp);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /** \ingroup variables
@@ -585,7 +606,8 @@ nc_inq_var_endian(int ncid, int varid, int *endianp)
    int stat = NC_check_id(ncid,&ncp);
    if(stat != NC_NOERR) return stat;
    TRACE(nc_inq_var_endian);
-   return ncp->dispatch->inq_var_all(
+   NCLOCKFILE(ncp);
+   stat = ncp->dispatch->inq_var_all(
       ncid, varid,
       NULL, /*name*/
       NULL, /*xtypep*/
@@ -602,6 +624,8 @@ nc_inq_var_endian(int ncid, int varid, int *endianp)
       NULL, /*fillvaluep*/
       endianp, /*endianp*/
       NULL, NULL, NULL);
+   NCUNLOCKFILE(ncp);
+   return stat;
 }
 
 /**
@@ -678,8 +702,11 @@ nc_inq_unlimdims(int ncid, int *nunlimdimsp, int *unlimdimidsp)
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
     TRACE(nc_inq_unlimdims);
-    return ncp->dispatch->inq_unlimdims(ncid, nunlimdimsp,
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->inq_unlimdims(ncid, nunlimdimsp,
 					unlimdimidsp);
+    NCUNLOCKFILE(ncp);
+    return stat;
 #endif
 }
 
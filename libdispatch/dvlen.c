@@ -95,7 +95,10 @@ nc_def_vlen(int ncid, const char *name, nc_type base_typeid, nc_type *xtypep)
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->def_vlen(ncid,name,base_typeid,xtypep);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->def_vlen(ncid,name,base_typeid,xtypep);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** \ingroup user_types
@@ -153,7 +156,10 @@ nc_put_vlen_element(int ncid, int typeid1, void *vlen_element, size_t len, const
     NC* ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->put_vlen_element(ncid,typeid1,vlen_element,len,data);
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->put_vlen_element(ncid,typeid1,vlen_element,len,data);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
 
 /** 
@@ -182,6 +188,9 @@ nc_get_vlen_element(int ncid, int typeid1, const void *vlen_element,
     NC *ncp;
     int stat = NC_check_id(ncid,&ncp);
     if(stat != NC_NOERR) return stat;
-    return ncp->dispatch->get_vlen_element(ncid, typeid1, vlen_element, 
+    NCLOCKFILE(ncp);
+    stat = ncp->dispatch->get_vlen_element(ncid, typeid1, vlen_element, 
 					   len, data);
+    NCUNLOCKFILE(ncp);
+    return stat;
 }
@@ -19,6 +19,9 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef NETCDF_ENABLE_THREADSAFE
+#include <pthread.h>
+#endif
 #include "ncdispatch.h"
 
 #ifndef nulldup
@@ -64,9 +67,111 @@ free_NC(NC *ncp)
     if(ncp->path)
         free(ncp->path);
     /* We assume caller has already cleaned up ncp->dispatchdata */
+    NC_nbdiscard(ncp);
+#ifdef NETCDF_ENABLE_THREADSAFE
+    if(ncp->lock != NULL) {
+        pthread_mutex_destroy((pthread_mutex_t*)ncp->lock);
+        free(ncp->lock);
+    }
+#endif
     free(ncp);
 }
 
+#ifdef NETCDF_ENABLE_THREADSAFE
+/**
+ * Decide if calls on a file may run concurrently with calls on
+ * other files. This holds only for dispatchers known to keep all
+ * their mutable state in the file itself; the others (HDF5, NCZarr,
+ * whose filter registry, S3 setup and chunk walker are shared by all
+ * files, DAP, user-defined formats, ...) are serialized on the
+ * global lock.
+ *
+ * @param dispatcher The NC_Dispatch table of the file.
+ *
+ * @return 1 if the file gets its own lock, 0 otherwise.
+ */
+static int
+NC_reentrant(const NC_Dispatch* dispatcher)
+{
+    if(dispatcher == NULL) return 0;
+    switch (dispatcher->model) {
+    case NC_FORMATX_NC3:
+        return 1;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/**
+ * Acquire the lock of a file: the per-file mutex if it has one,
+ * the global lock otherwise. The lock is recursive, so a
+ * dispatcher may call back into the API for the same file.
+ *
+ * @param ncp Pointer to the NC struct.
+ */
+void
+NC_lockfile(NC* ncp)
+{
+    if(ncp->lock != NULL)
+        pthread_mutex_lock((pthread_mutex_t*)ncp->lock);
+    else
+        NC_lock();
+}
+
+/**
+ * Release the lock acquired by NC_lockfile().
+ *
+ * @param ncp Pointer to the NC struct.
+ */
+void
+NC_unlockfile(NC* ncp)
+{
+    if(ncp->lock != NULL)
+        pthread_mutex_unlock((pthread_mutex_t*)ncp->lock);
+    else
+        NC_unlock();
+}
+
+/**
+ * Acquire the locks of two files, in an order that cannot
+ * deadlock against any other thread: the per-file mutexes first,
+ * by address, then the global lock. The second file may be NULL
+ * or the same as the first.
+ *
+ * @param ncp1 Pointer to the first NC struct.
+ * @param ncp2 Pointer to the second NC struct, or NULL.
+ */
+void
+NC_lockfiles(NC* ncp1, NC* ncp2)
+{
+    if(ncp2 == NULL || ncp2 == ncp1) {NC_lockfile(ncp1); return;}
+    if(ncp1->lock != NULL && ncp2->lock != NULL) {
+        if(ncp1 < ncp2)
+            {NC_lockfile(ncp1); NC_lockfile(ncp2);}
+        else
+            {NC_lockfile(ncp2); NC_lockfile(ncp1);}
+    } else if(ncp1->lock != NULL) {
+        NC_lockfile(ncp1); NC_lockfile(ncp2);
+    } else {
+        NC_lockfile(ncp2); NC_lockfile(ncp1);
+    }
+}
+
+/**
+ * Release the locks acquired by NC_lockfiles().
+ *
+ * @param ncp1 Pointer to the first NC struct.
+ * @param ncp2 Pointer to the second NC struct, or NULL.
+ */
+void
+NC_unlockfiles(NC* ncp1, NC* ncp2)
+{
+    NC_unlockfile(ncp1);
+    if(ncp2 != NULL && ncp2 != ncp1) NC_unlockfile(ncp2);
+}
+#endif /*NETCDF_ENABLE_THREADSAFE*/
+
 /**
  * Create and initialize a new NC struct. The ncid is assigned later.
  *
@@ -94,6 +199,17 @@ new_NC(const NC_Dispatch* dispatcher, const char* path, int mode, NC** ncpp)
         free_NC(ncp);
         return NC_ENOMEM;
     }
+#ifdef NETCDF_ENABLE_THREADSAFE
+    if(NC_reentrant(dispatcher)) {
+        pthread_mutexattr_t attr;
+        if((ncp->lock = malloc(sizeof(pthread_mutex_t))) == NULL)
+            {free_NC(ncp); return NC_ENOMEM;}
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init((pthread_mutex_t*)ncp->lock,&attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+#endif
     if(ncpp) {
         *ncpp = ncp;
     } else {
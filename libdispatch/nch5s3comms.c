@@ -285,9 +285,10 @@ static size_t curlwritecallback(char *ptr, size_t size, size_t nmemb, void *user
 static size_t curlheadercallback(char *ptr, size_t size, size_t nmemb, void *userdata);
 static int curl_reset(s3r_t* handle);
 static int perform_request(s3r_t* handle, long* httpcode);
-static int build_request(s3r_t* handle, NCURI* purl, const char* byterange, const char** otherheaders, VString* payload, HTTPVerb verb);
+static int build_request(s3r_t* handle, CURL* curlh, struct curl_slist** curlheadersp, NCURI* purl, const char* byterange, const char** otherheaders, VString* payload, HTTPVerb verb);
 static int request_setup(s3r_t* handle, const char* url, HTTPVerb verb, struct s3r_cbstruct*);
 static int validate_handle(s3r_t* handle, const char* url);
+static void pool_free(struct s3r_pool_t* pool);
 static int validate_url(NCURI* purl);
 static int build_range(size_t offset, size_t len, char** rangep);
 static const char* verbtext(HTTPVerb verb);
@@ -748,6 +749,8 @@ NCH5_s3comms_s3r_close(s3r_t *handle)
     if (handle->magic != S3COMMS_S3R_MAGIC)
         HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "handle has invalid magic.");
 
+    pool_free(handle->pool);
+    handle->pool = NULL;
     if(handle->curlheaders != NULL) {
         curl_slist_free_all(handle->curlheaders);
         handle->curlheaders = NULL;
@@ -1003,7 +1006,7 @@ NCH5_s3comms_s3r_execute(s3r_t *handle, const char* url,
      * COMPILE REQUEST *
      *******************/
 
-    if((ret_value = build_request(handle,purl,range,otherheaders,data,verb)))
+    if((ret_value = build_request(handle,handle->curlhandle,&handle->curlheaders,purl,range,otherheaders,data,verb)))
         HGOTO_ERROR(H5E_ARGS, ret_value, FAIL, "unable to build request.");
 
     /*********************
@@ -1082,6 +1085,7 @@ NCH5_s3comms_s3r_open(const char* root, NCS3SVC svc, const char *region, const c
 	HGOTO_ERROR(H5E_ARGS, NC_ENOMEM, NULL, "could not malloc space for handle.");
 
     handle->magic	= S3COMMS_S3R_MAGIC;
+    handle->maxconns = NCS3_DEFAULT_CONNECTIONS;
 
     /*************************************
      * RECORD THE ROOT PATH
@@ -1255,6 +1259,45 @@ done:
     return UNTRACE(ret_value);;
 } /* NCH5_s3comms_s3r_read */
 
+/*----------------------------------------------------------------------------
+ * Function: NCH5_s3comms_s3r_readall()
+ * Purpose:
+ *     Read the whole of the object pointed to by the url with a single
+ *     unranged GET. The body is returned in `dest`, which is filled in
+ *     with malloc'd memory that the caller must free; its size is the
+ *     size of the object.
+ * Return:
+ *     - SUCCESS: `SUCCEED`
+ *     - FAILURE: `FAIL`
+ *----------------------------------------------------------------------------
+ */
+int
+NCH5_s3comms_s3r_readall(s3r_t *handle, const char* url, s3r_buf_t* dest, long* httpcodep)
+{
+    int ret_value = SUCCEED;
+    long httpcode = 0;
+    VString* content = vsnew();
+
+    TRACE(0,"handle=%p url=%s dest=%p",handle,url,dest);
+
+#if S3COMMS_DEBUG_TRACE
+    fprintf(stdout, "called NCH5_s3comms_s3r_readall.\n");
+#endif
+
+    if((ret_value = NCH5_s3comms_s3r_execute(handle, url, HTTPGET, NULL, NULL, NULL, &httpcode, content)))
+        HGOTO_ERROR(H5E_ARGS, ret_value, FAIL, "execute failed.");
+    if(dest) {
+	dest->count = vslength(content);
+	dest->content = vsextract(content);
+    }
+
+done:
+    if(httpcodep) *httpcodep = httpcode;
+    vsfree(content);
+    curl_reset(handle);
+    return UNTRACE(ret_value);
+} /* NCH5_s3comms_s3r_readall */
+
 /*----------------------------------------------------------------------------
  * Function: NCH5_s3comms_s3r_write()
  * Return:
@@ -1347,6 +1390,448 @@ done:
     return UNTRACEX(ret_value,"response=[%d]",ncbyteslength(response));
 } /* NCH5_s3comms_s3r_getkeys */
 
+/****************************************************************************
+ * ASYNCHRONOUS REQUESTS
+ *
+ * Requests given to NCH5_s3comms_s3r_submit() are queued on the handle
+ * and performed by a pool of up to `maxconns` curl easy handles driven
+ * by a single curl multi handle. The multi handle owns the connection
+ * cache, so a connection left open by one request is reused by the
+ * next request to the same host, whichever easy handle performs it.
+ * Transfers progress only inside NCH5_s3comms_s3r_submit() and
+ * NCH5_s3comms_s3r_wait(); the latter returns when every submitted
+ * request has completed.
+ ****************************************************************************/
+
+/* Milliseconds to wait for activity on the connections before calling
+   curl_multi_perform() again */
+#define S3COMMS_POOL_WAIT_MS 1000
+
+/* One connection of the pool */
+typedef struct s3r_conn_t {
+    CURL              *curlh;
+    struct curl_slist *curlheaders;
+    s3r_request_t     *request; /* in flight, or NULL if idle */
+    VString           *body;    /* GET of a whole object: the response body */
+    size_t             pos;     /* PUT: no. of bytes of the body sent so far */
+} s3r_conn_t;
+
+typedef struct s3r_pool_t {
+    CURLM         *multi;
+    size_t         nconns;
+    s3r_conn_t    *conns;
+    size_t         active; /* no. of requests in flight */
+    s3r_request_t *first;  /* queue of requests waiting for a connection */
+    s3r_request_t *last;
+} s3r_pool_t;
+
+static size_t
+poolwritecallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    s3r_conn_t    *conn    = (s3r_conn_t *)userdata;
+    s3r_request_t *request = conn->request;
+    size_t         product = (size * nmemb);
+
+    if (product == 0)
+        return 0;
+    if (request->len == 0) {
+        vsappendn(conn->body, ptr, product);
+    } else {
+        /* More than was asked for; fail the transfer */
+        if (request->data.count + product > request->len)
+            return 0;
+        memcpy((char *)request->data.content + request->data.count, ptr, product);
+        request->data.count += product;
+    }
+    return product;
+}
+
+static size_t
+poolreadcallback(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    s3r_conn_t    *conn    = (s3r_conn_t *)userdata;
+    s3r_request_t *request = conn->request;
+    size_t         avail   = (size_t)request->data.count - conn->pos;
+    size_t         towrite = (size * nmemb);
+
+    if (towrite > avail)
+        towrite = avail;
+    if (towrite > 0)
+        memcpy(ptr, (const char *)request->data.content + conn->pos, towrite);
+    conn->pos += towrite;
+    return towrite;
+}
+
+/* Free the pool; requests still in flight or queued are abandoned */
+static void
+pool_free(s3r_pool_t *pool)
+{
+    size_t i;
+
+    if (pool == NULL)
+        return;
+    for (i = 0; i < pool->nconns && pool->conns != NULL; i++) {
+        s3r_conn_t *conn = &pool->conns[i];
+        if (conn->curlh != NULL) {
+            if (conn->request != NULL)
+                (void)curl_multi_remove_handle(pool->multi, conn->curlh);
+            curl_easy_cleanup(conn->curlh);
+        }
+        if (conn->curlheaders != NULL)
+            curl_slist_free_all(conn->curlheaders);
+        vsfree(conn->body);
+    }
+    if (pool->multi != NULL)
+        curl_multi_cleanup(pool->multi);
+    nullfree(pool->conns);
+    free(pool);
+}
+
+static int
+pool_new(s3r_t *handle)
+{
+    int         ret_value = SUCCEED;
+    s3r_pool_t *pool      = NULL;
+    size_t      i;
+
+    if ((pool = (s3r_pool_t *)calloc(1, sizeof(s3r_pool_t))) == NULL)
+        HGOTO_ERROR(H5E_ARGS, NC_ENOMEM, FAIL, "could not malloc space for connection pool.");
+    pool->nconns = (handle->maxconns > 0 ? handle->maxconns : 1);
+    if ((pool->conns = (s3r_conn_t *)calloc(pool->nconns, sizeof(s3r_conn_t))) == NULL)
+        HGOTO_ERROR(H5E_ARGS, NC_ENOMEM, FAIL, "could not malloc space for connections.");
+    if ((pool->multi = curl_multi_init()) == NULL)
+        HGOTO_ERROR(H5E_ARGS, NC_ECURL, FAIL, "problem creating curl multi handle!");
+    /* Keep an idle connection open for every member of the pool */
+    if (CURLM_OK != curl_multi_setopt(pool->multi, CURLMOPT_MAXCONNECTS, (long)pool->nconns))
+        HGOTO_ERROR(H5E_ARGS, NC_ECURL, FAIL, "error while setting CURL option (CURLMOPT_MAXCONNECTS).");
+    for (i = 0; i < pool->nconns; i++) {
+        if ((pool->conns[i].curlh = curl_easy_init()) == NULL)
+            HGOTO_ERROR(H5E_ARGS, NC_ECURL, FAIL, "problem creating curl easy handle!");
+        pool->conns[i].body = vsnew();
+    }
+    handle->pool = pool;
+    pool = NULL;
+
+done:
+    pool_free(pool);
+    return (ret_value);
+}
+
+/* Set up conn to perform request and hand it to the multi handle */
+static int
+conn_start(s3r_t *handle, s3r_conn_t *conn, s3r_request_t *request)
+{
+    int         ret_value = SUCCEED;
+    CURL       *curlh     = conn->curlh;
+    NCURI      *purl      = NULL;
+    char       *range     = NULL;
+    VString    *payload   = NULL;
+    char        digits[64];
+    const char *putheaders[5] = {"Content-Length", digits, "Content-Type", "binary/octet-stream", NULL};
+
+    ncuriparse(request->url, &purl);
+    if ((ret_value = validate_url(purl)))
+        HGOTO_ERRORVA(H5E_ARGS, NC_EINVAL, FAIL, "unparsable url: %s", request->url);
+
+    /* Clear the options of the previous request; this keeps the connection */
+    curl_easy_reset(curlh);
+    (void)trace(curlh, 1);
+    if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_HTTP_VERSION).");
+    if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_FAILONERROR, 1L))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_FAILONERROR).");
+    if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_TCP_KEEPALIVE, 1L))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_TCP_KEEPALIVE).");
+    if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_PRIVATE, (void *)conn))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_PRIVATE).");
+    if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_URL, request->url))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_URL).");
+
+    switch (request->verb) {
+    case HTTPGET:
+        if (request->len > 0 && (ret_value = build_range(request->offset, request->len, &range)))
+            HGOTO_ERROR(H5E_ARGS, ret_value, FAIL, "build_range failed.");
+        if ((ret_value = build_request(handle, curlh, &conn->curlheaders, purl, range, NULL, NULL, HTTPGET)))
+            HGOTO_ERROR(H5E_ARGS, ret_value, FAIL, "unable to build request.");
+        if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_WRITEFUNCTION, poolwritecallback))
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_WRITEFUNCTION).");
+        if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_WRITEDATA, (void *)conn))
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_WRITEDATA).");
+        vsclear(conn->body);
+        break;
+    case HTTPPUT:
+        snprintf(digits, sizeof(digits), "%llu", (unsigned long long)request->data.count);
+        if (request->data.count > 0) {
+            payload = vsnew();
+            vssetcontents(payload, (char *)request->data.content, (size_t)request->data.count);
+        }
+        if ((ret_value = build_request(handle, curlh, &conn->curlheaders, purl, NULL, putheaders, payload, HTTPPUT)))
+            HGOTO_ERROR(H5E_ARGS, ret_value, FAIL, "unable to build request.");
+        if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_UPLOAD, 1L))
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_UPLOAD).");
+        if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_INFILESIZE_LARGE, (curl_off_t)request->data.count))
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_INFILESIZE_LARGE).");
+        if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_READFUNCTION, poolreadcallback))
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_READFUNCTION).");
+        if (CURLE_OK != curl_easy_setopt(curlh, CURLOPT_READDATA, (void *)conn))
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "error while setting CURL option (CURLOPT_READDATA).");
+        conn->pos = 0;
+        break;
+    default:
+        HGOTO_ERRORVA(H5E_ARGS, NC_EINVAL, FAIL, "Illegal verb: %d.", (int)request->verb);
+        break;
+    }
+
+    conn->request = request;
+    if (CURLM_OK != curl_multi_add_handle(handle->pool->multi, curlh)) {
+        conn->request = NULL;
+        HGOTO_ERROR(H5E_ARGS, NC_ECURL, FAIL, "could not add request to curl multi handle.");
+    }
+    handle->pool->active++;
+
+done:
+    if (ret_value != SUCCEED && conn->curlheaders != NULL) {
+        curl_slist_free_all(conn->curlheaders);
+        conn->curlheaders = NULL;
+    }
+    if (payload != NULL) {
+        (void)vsextract(payload);
+        vsfree(payload);
+    }
+    nullfree(range);
+    ncurifree(purl);
+    return (ret_value);
+}
+
+/* Retire the request of conn, which curl has finished with result */
+static void
+conn_done(s3r_pool_t *pool, s3r_conn_t *conn, CURLcode result)
+{
+    s3r_request_t *request  = conn->request;
+    long           httpcode = 0;
+
+    (void)curl_multi_remove_handle(pool->multi, conn->curlh);
+    (void)curl_easy_getinfo(conn->curlh, CURLINFO_RESPONSE_CODE, &httpcode);
+    request->httpcode = httpcode;
+    /* As in perform_request(), an HTTP error is returned as the response code */
+    if (result == CURLE_OK || result == CURLE_HTTP_RETURNED_ERROR)
+        request->stat = NC_NOERR;
+    else
+        request->stat = NC_EACCESS;
+    if (request->verb == HTTPGET && request->len == 0) {
+        if (request->stat == NC_NOERR && result == CURLE_OK) {
+            request->data.count   = vslength(conn->body);
+            request->data.content = vsextract(conn->body);
+        }
+        vsclear(conn->body);
+    }
+    if (conn->curlheaders != NULL) {
+        curl_slist_free_all(conn->curlheaders);
+        conn->curlheaders = NULL;
+    }
+    conn->request = NULL;
+    pool->active--;
+}
+
+/* Fail every outstanding request with stat */
+static void
+pool_abort(s3r_pool_t *pool, int stat)
+{
+    size_t i;
+
+    for (i = 0; i < pool->nconns; i++) {
+        s3r_conn_t *conn = &pool->conns[i];
+        if (conn->request != NULL) {
+            (void)curl_multi_remove_handle(pool->multi, conn->curlh);
+            conn->request->stat = stat;
+            conn->request = NULL;
+            if (conn->curlheaders != NULL) {
+                curl_slist_free_all(conn->curlheaders);
+                conn->curlheaders = NULL;
+            }
+        }
+    }
+    while (pool->first != NULL) {
+        s3r_request_t *request = pool->first;
+        pool->first = request->next;
+        request->next = NULL;
+        request->stat = stat;
+    }
+    pool->last   = NULL;
+    pool->active = 0;
+}
+
+/* Start queued requests on the idle connections */
+static void
+pool_start(s3r_t *handle)
+{
+    s3r_pool_t *pool = handle->pool;
+    size_t      i;
+
+    for (i = 0; i < pool->nconns && pool->first != NULL; i++) {
+        s3r_conn_t *conn = &pool->conns[i];
+        while (conn->request == NULL && pool->first != NULL) {
+            s3r_request_t *request = pool->first;
+            pool->first = request->next;
+            if (pool->first == NULL)
+                pool->last = NULL;
+            request->next = NULL;
+            request->stat = conn_start(handle, conn, request);
+        }
+    }
+}
+
+/* Let the transfers progress without blocking; retire the completed
+   requests and give their connections to queued ones */
+static int
+pool_perform(s3r_t *handle)
+{
+    s3r_pool_t *pool    = handle->pool;
+    int         running = 0;
+    int         nmsgs   = 0;
+    CURLMsg    *msg     = NULL;
+
+    pool_start(handle);
+    if (CURLM_OK != curl_multi_perform(pool->multi, &running))
+        return NC_ECURL;
+    while ((msg = curl_multi_info_read(pool->multi, &nmsgs)) != NULL) {
+        if (msg->msg == CURLMSG_DONE) {
+            CURL       *curlh  = msg->easy_handle;
+            CURLcode    result = msg->data.result;
+            s3r_conn_t *conn   = NULL;
+            if (CURLE_OK == curl_easy_getinfo(curlh, CURLINFO_PRIVATE, (char **)&conn) && conn != NULL)
+                conn_done(pool, conn, result);
+        }
+    }
+    pool_start(handle);
+    return NC_NOERR;
+}
+
+/*----------------------------------------------------------------------------
+ * Function: NCH5_s3comms_s3r_setconnections()
+ * Purpose:
+ *     Set the maximum number of submitted requests performed at once.
+ *     Fails if requests are outstanding.
+ * Return:
+ *     - SUCCESS: `SUCCEED`
+ *     - FAILURE: `FAIL`
+ *----------------------------------------------------------------------------
+ */
+int
+NCH5_s3comms_s3r_setconnections(s3r_t *handle, size_t maxconns)
+{
+    int ret_value = SUCCEED;
+
+    TRACE(0,"handle=%p maxconns=%u",handle,(unsigned)maxconns);
+
+    if ((ret_value = validate_handle(handle, NULL)))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "invalid handle.");
+    if (handle->pool != NULL) {
+        if (handle->pool->active > 0 || handle->pool->first != NULL)
+            HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "requests are outstanding.");
+        /* Rebuilt at the next submit */
+        pool_free(handle->pool);
+        handle->pool = NULL;
+    }
+    handle->maxconns = (maxconns > 0 ? maxconns : 1);
+
+done:
+    return UNTRACE(ret_value);
+} /* NCH5_s3comms_s3r_setconnections */
+
+/*----------------------------------------------------------------------------
+ * Function: NCH5_s3comms_s3r_submit()
+ * Purpose:
+ *     Queue a GET or PUT request (see `s3r_request_t`) and start it if a
+ *     connection of the pool is free. The request completes, successfully
+ *     or not, by the time `NCH5_s3comms_s3r_wait()` returns.
+ * Return:
+ *     - SUCCESS: `SUCCEED`
+ *     - FAILURE: `FAIL`; the request was not queued
+ *----------------------------------------------------------------------------
+ */
+int
+NCH5_s3comms_s3r_submit(s3r_t *handle, s3r_request_t *request)
+{
+    int ret_value = SUCCEED;
+
+    TRACE(0,"handle=%p request=%p",handle,request);
+
+    if ((ret_value = validate_handle(handle, NULL)))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "invalid handle.");
+    if (request == NULL || request->url == NULL)
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "request must have a url.");
+    if (request->verb != HTTPGET && request->verb != HTTPPUT)
+        HGOTO_ERRORVA(H5E_ARGS, NC_EINVAL, FAIL, "Illegal verb: %d.", (int)request->verb);
+    if (request->verb == HTTPGET && request->len > 0 && request->data.content == NULL)
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "ranged read needs a buffer.");
+    if (request->verb == HTTPPUT && request->data.count > 0 && request->data.content == NULL)
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "write needs data.");
+    if (handle->pool == NULL && (ret_value = pool_new(handle)))
+        HGOTO_ERROR(H5E_ARGS, ret_value, FAIL, "could not create connection pool.");
+
+    request->httpcode = 0;
+    request->stat     = NC_NOERR;
+    request->next     = NULL;
+    if (request->verb == HTTPGET) {
+        request->data.count = 0;
+        if (request->len == 0)
+            request->data.content = NULL;
+    }
+    if (handle->pool->last == NULL)
+        handle->pool->first = request;
+    else
+        handle->pool->last->next = request;
+    handle->pool->last = request;
+
+    if ((ret_value = pool_perform(handle)))
+        pool_abort(handle->pool, ret_value);
+    ret_value = SUCCEED; /* the failure is reported by the requests */
+
+done:
+    return UNTRACE(ret_value);
+} /* NCH5_s3comms_s3r_submit */
+
+/*----------------------------------------------------------------------------
+ * Function: NCH5_s3comms_s3r_wait()
+ * Purpose:
+ *     Perform the submitted requests until all have completed.
+ *     The outcome of each is in its `stat` and `httpcode`.
+ * Return:
+ *     - SUCCESS: `SUCCEED`
+ *     - FAILURE: `FAIL`; curl itself failed and the outstanding requests
+ *       were abandoned
+ *----------------------------------------------------------------------------
+ */
+int
+NCH5_s3comms_s3r_wait(s3r_t *handle)
+{
+    int         ret_value = SUCCEED;
+    s3r_pool_t *pool      = NULL;
+
+    TRACE(0,"handle=%p",handle);
+
+    if ((ret_value = validate_handle(handle, NULL)))
+        HGOTO_ERROR(H5E_ARGS, NC_EINVAL, FAIL, "invalid handle.");
+    if ((pool = handle->pool) == NULL)
+        goto done;
+    for (;;) {
+        if ((ret_value = pool_perform(handle)))
+            break;
+        if (pool->active == 0 && pool->first == NULL)
+            break;
+        if (CURLM_OK != curl_multi_wait(pool->multi, NULL, 0, S3COMMS_POOL_WAIT_MS, NULL)) {
+            ret_value = NC_ECURL;
+            break;
+        }
+    }
+    if (ret_value != SUCCEED)
+        pool_abort(pool, ret_value);
+
+done:
+    return UNTRACE(ret_value);
+} /* NCH5_s3comms_s3r_wait */
+
 /****************************************************************************
  * MISCELLANEOUS FUNCTIONS
  ****************************************************************************/
@@ -2378,7 +2863,8 @@ done:
   otherheaders is a vector of (header,value) pairs
  */
 static int
-build_request(s3r_t* handle, NCURI* purl,
+build_request(s3r_t* handle, CURL* curlh, struct curl_slist** curlheadersp,
+              NCURI* purl,
               const char* byterange,
               const char** otherheaders,
               VString* payload,
@@ -2390,7 +2876,6 @@ build_request(s3r_t* handle, NCURI* purl,
     hrb_node_t        *node          = NULL;
     hrb_t             *request       = NULL;
     struct tm         *now           = NULL;
-    CURL              *curlh         = handle->curlhandle;
     VString           *authorization = vsnew();
     VString           *signed_headers = vsnew();
     VString*           creds = vsnew();
@@ -2573,12 +3058,11 @@ build_request(s3r_t* handle, NCURI* purl,
 
     /* We need to save the curlheaders so we can release them after the transfer
        (see https://curl.se/libcurl/c/CURLOPT_HTTPHEADER.html). */
-    if(handle->curlheaders != NULL) {
-        curl_slist_free_all(handle->curlheaders);
-        handle->curlheaders = NULL;
+    if(*curlheadersp != NULL) {
+        curl_slist_free_all(*curlheadersp);
+        *curlheadersp = NULL;
     }
-    assert(handle->curlheaders == NULL);
-    handle->curlheaders = curlheaders;
+    *curlheadersp = curlheaders;
     curlheaders = NULL;
 
 done:
@@ -74,6 +74,7 @@
 /* Opaque Handles */
 struct CURL;
 struct NCURI;
+struct s3r_pool_t;
 struct VString;
 
 /*****************
@@ -451,6 +452,17 @@ typedef struct {
  *
  *     Required to authenticate.
  *
+ * `pool` (s3r_pool_t *)
+ *
+ *     Connections used by requests submitted with `NCH5_s3comms_s3r_submit()`;
+ *     created on first use. Their curl handles share one curl multi handle,
+ *     whose connection cache keeps the connections alive between requests.
+ *
+ * `maxconns` (size_t)
+ *
+ *     Maximum number of submitted requests performed at once, i.e. the
+ *     size of the pool. See `NCH5_s3comms_s3r_setconnections()`.
+ *
  *----------------------------------------------------------------------------
  */
 typedef struct {
@@ -465,6 +477,8 @@ typedef struct {
     char          iso8601now[ISO8601_SIZE];
     char         *reply;
     struct curl_slist *curlheaders;
+    struct s3r_pool_t *pool;
+    size_t         maxconns;
 } s3r_t;
 
 /* Combined storage for space + size */
@@ -480,6 +494,34 @@ typedef enum HTTPVerb {
 HTTPNONE=0, HTTPGET=1, HTTPPUT=2, HTTPPOST=3, HTTPHEAD=4, HTTPDELETE=5
 } HTTPVerb;
 
+/*----------------------------------------------------------------------------
+ * Structure: s3r_request_t
+ * A GET or PUT performed asynchronously by `NCH5_s3comms_s3r_submit()`.
+ * The structure, `url` and the data buffer belong to the caller and must
+ * stay valid until `NCH5_s3comms_s3r_wait()` returns.
+ *
+ * `verb`          HTTPGET or HTTPPUT
+ * `url`           full url of the object
+ * `offset`, `len` GET: the byte range to read; `len` == 0 reads the whole object
+ * `data`          GET with `len` > 0: `content` holds `len` bytes and `count`
+ *                 receives the number of bytes read; GET with `len` == 0:
+ *                 receives the object in malloc'd memory owned by the caller;
+ *                 PUT: the body
+ * `httpcode`      the response code
+ * `stat`          NC_NOERR unless the transfer itself failed
+ *----------------------------------------------------------------------------
+ */
+typedef struct s3r_request_t {
+    HTTPVerb       verb;
+    const char    *url;
+    size_t         offset;
+    size_t         len;
+    s3r_buf_t      data;
+    long           httpcode;
+    int            stat;
+    struct s3r_request_t *next; /* private: queue of requests waiting for a connection */
+} s3r_request_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -508,6 +550,8 @@ EXTERNL int NCH5_s3comms_s3r_close(s3r_t *handle);
 
 EXTERNL int NCH5_s3comms_s3r_read(s3r_t *handle, const char* url, size_t offset, size_t len, s3r_buf_t* data, long* httpcodep);
 
+EXTERNL int NCH5_s3comms_s3r_readall(s3r_t *handle, const char* url, s3r_buf_t* data, long* httpcodep);
+
 EXTERNL int NCH5_s3comms_s3r_write(s3r_t *handle, const char* url, const s3r_buf_t* data, long* httpcodep);
 
 EXTERNL int NCH5_s3comms_s3r_getkeys(s3r_t *handle, const char* url, s3r_buf_t* response, long* httpcodep);
@@ -518,6 +562,12 @@ EXTERNL int NCH5_s3comms_s3r_deletekey(s3r_t *handle, const char* url, long* htt
 
 EXTERNL int NCH5_s3comms_s3r_head(s3r_t *handle, const char* url, const char* header, const char* query, long* httpcodep, char** valuep);
 
+EXTERNL int NCH5_s3comms_s3r_setconnections(s3r_t *handle, size_t maxconns);
+
+EXTERNL int NCH5_s3comms_s3r_submit(s3r_t *handle, s3r_request_t* request);
+
+EXTERNL int NCH5_s3comms_s3r_wait(s3r_t *handle);
+
 /*********************************
  * DECLARATION OF OTHER ROUTINES *
  *********************************/
@@ -58,6 +58,9 @@ static int ncjbreakpoint(int err) {return err;}
 
 #define NCJ_DEFAULTALLOC 16
 
+/* Dicts with at least this many pairs get a hash index of their keys */
+#define NCJ_INDEXMIN 16
+
 /**************************************************/
 typedef struct NCJparser {
     char* text;
@@ -75,8 +78,25 @@ typedef struct NCJparser {
 typedef struct NCJbuf {
     size_t len; /* |text|; does not include nul terminator */
     char* text; /* NULL || nul terminated */
+    size_t alloc; /* space allocated for text */
 } NCJbuf;
 
+/* Hash index of the keys of a dict, so that looking up a key in the
+   large dicts of consolidated metadata does not scan all the pairs.
+   It uses open addressing with linear probing; each slot holds a
+   pair number + 1, and 0 marks an empty slot. The index is built by
+   the first lookup once the dict is large enough, and each later
+   lookup adds the pairs appended since, so parsing and building
+   dicts cost nothing extra. It assumes that the keys of the pairs
+   already indexed are not changed or moved in place; NCJdictsort()
+   drops it. As with a linear search, the first of duplicate keys
+   wins. */
+struct NCjindex {
+    size_t nslots; /* a power of 2 */
+    size_t npairs; /* pairs [0,npairs) are indexed */
+    size_t* slots;
+};
+
 /**************************************************/
 
 #if defined(_WIN32) && !defined(__MINGW32__)
@@ -116,6 +136,8 @@ static char unescape1(char c);
 static int listappend(struct NCjlist* list, NCjson* element);
 static int listsetalloc(struct NCjlist* list, size_t sz);
 static int listlookup(const struct NCjlist* list, const char* key, size_t* indexp);
+static int listfind(const struct NCjlist* list, const char* key);
+static void listunindex(struct NCjlist* list);
 
 static int NCJcloneArray(const NCjson* array, NCjson** clonep);
 static int NCJcloneDict(const NCjson* dict, NCjson** clonep);
@@ -221,20 +243,10 @@ NCJparseR(NCJparser* parser, NCjson** jsonp)
         if((stat = NCJnew(NCJ_NULL,&json))==NCJ_ERR) goto done;
 	break;
     case NCJ_BOOLEAN:
-        if((stat = NCJnew(NCJ_BOOLEAN,&json))==NCJ_ERR) goto done;
-	json->string = strdup(parser->yytext);
-	break;
     case NCJ_INT:
-        if((stat = NCJnew(NCJ_INT,&json))==NCJ_ERR) goto done;
-	json->string = strdup(parser->yytext);
-	break;
     case NCJ_DOUBLE:
-        if((stat = NCJnew(NCJ_DOUBLE,&json))==NCJ_ERR) goto done;
-	json->string = strdup(parser->yytext);
-	break;
     case NCJ_STRING:
-        if((stat = NCJnew(NCJ_STRING,&json))==NCJ_ERR) goto done;
-	json->string = strdup(parser->yytext);
+        if((stat = NCJnewstring(token,parser->yytext,&json))==NCJ_ERR) goto done;
 	break;
     case NCJ_LBRACE:
         if((stat = NCJnew(NCJ_DICT,&json))==NCJ_ERR) goto done;
@@ -531,7 +543,9 @@ NCJreclaim(NCjson* json)
     case NCJ_DOUBLE:
     case NCJ_BOOLEAN:
     case NCJ_STRING: 
-	nullfree(json->string);
+	/* The text of a node made by NCJnewstringn() is part of the node */
+	if(json->string != (char*)(json+1))
+	    nullfree(json->string);
 	break;
     case NCJ_DICT:
 	NCJreclaimDict(&json->list);
@@ -559,6 +573,7 @@ NCJreclaimArray(struct NCjlist* array)
 static void
 NCJreclaimDict(struct NCjlist* dict)
 {
+   listunindex(dict);
    NCJreclaimArray(dict);
 }
 
@@ -608,11 +623,13 @@ NCJnewstringn(int sort, size_t len, const char* value, NCjson** jsonp)
     NCjson* json = NULL;
 
     if(jsonp) *jsonp = NULL;
-    if(value == NULL)
+    if(value == NULL || sort <= NCJ_UNDEF || sort >= NCJ_NSORTS)
         {stat = NCJTHROW(NCJ_ERR); goto done;}
-    if((stat = NCJnew(sort,&json))==NCJ_ERR) goto done;
-    if((json->string = (char*)malloc(len+1))==NULL)
+    /* One allocation holds both the node and its text */
+    if((json = (NCjson*)calloc(1,sizeof(NCjson)+len+1)) == NULL)
         {stat = NCJTHROW(NCJ_ERR); goto done;}
+    NCJsetsort(json,sort);
+    json->string = (char*)(json+1);
     memcpy(json->string,value,len);
     json->string[len] = '\0';
     if(jsonp) *jsonp = json;
@@ -626,19 +643,14 @@ OPTSTATIC int
 NCJdictget(const NCjson* dict, const char* key, const NCjson** jvaluep)
 {
     int stat = NCJ_OK;
-    size_t i;
+    int match;
 
     if(dict == NULL || dict->sort != NCJ_DICT)
         {stat = NCJTHROW(NCJ_ERR); goto done;}
     if(jvaluep) {*jvaluep = NULL;}
-    for(i=0;i<NCJdictlength(dict);i++) {
-	NCjson* jkey = NCJdictkey(dict,i);
-	NCjson* jvalue  = NCJdictvalue(dict,i);
-	if(jkey->string != NULL && strcmp(jkey->string,key)==0) {
-	    if(jvaluep) {*jvaluep = jvalue;}
-	    break;
-	}	    
-    }
+    if(key == NULL) goto done;
+    if((match = listfind(&dict->list,key)) >= 0 && jvaluep)
+	*jvaluep = dict->list.contents[match+1];
 
 done:
     return NCJTHROW(stat);
@@ -829,20 +841,113 @@ static int
 listlookup(const struct NCjlist* list, const char* key, size_t* indexp)
 {
     int stat = NCJ_OK;
-    int i,len,match = -1;
+    int match = -1;
 
     if(list == NULL || key == NULL || strlen(key) == 0 || list->len %2 == 1)
 	{stat = NCJTHROW(NCJ_ERR); goto done;}
-    len = (int)list->len; /* => |list| < 2 billion or do */
-    for(i=0;i<len;i+=2) {
-	const NCjson* jkey = list->contents[i];
-	if(jkey != NULL && jkey->string != NULL && strcmp(jkey->string,key)==0) {match = i;break;}	    
-    }
+    match = listfind(list,key);
     if(match < 0) {stat = NCJ_EOF;}  else {if(indexp) *indexp = (size_t)match;}
 done:
     return NCJTHROW(stat);
 }
 
+/* FNV-1a */
+static size_t
+keyhash(const char* key)
+{
+    size_t h = (size_t)2166136261U;
+    for(;*key;key++) {
+	h ^= (unsigned char)*key;
+	h *= (size_t)16777619U;
+    }
+    return h;
+}
+
+/* Add pair p of a dict to its index */
+static void
+indexadd(struct NCjindex* index, const struct NCjlist* list, size_t p)
+{
+    const NCjson* jkey = list->contents[2*p];
+    size_t mask = index->nslots - 1;
+    size_t slot;
+
+    if(jkey == NULL || jkey->string == NULL) return;
+    for(slot=keyhash(jkey->string) & mask;index->slots[slot] != 0;slot=(slot+1) & mask) {
+	const NCjson* other = list->contents[2*(index->slots[slot]-1)];
+	if(strcmp(other->string,jkey->string)==0) return; /* keep the first */
+    }
+    index->slots[slot] = p+1;
+}
+
+/* Bring the index of a dict up to date with its pairs.
+@param list pointer to the (key,value) list; the index is a cache, so it is updated even though the list is const
+@return the index, or NULL if the dict is too small to need one or the index cannot be allocated
+*/
+static struct NCjindex*
+listindex(const struct NCjlist* list)
+{
+    struct NCjlist* mlist = (struct NCjlist*)list;
+    struct NCjindex* index = list->index;
+    size_t npairs = list->len / 2;
+    size_t nslots, p;
+
+    if(npairs < NCJ_INDEXMIN) return NULL;
+    /* Rebuild if pairs were removed or the table is half full */
+    if(index != NULL && (index->npairs > npairs || 2*npairs >= index->nslots)) {
+	listunindex(mlist);
+	index = NULL;
+    }
+    if(index == NULL) {
+	for(nslots=4*NCJ_INDEXMIN;nslots < 4*npairs;nslots*=2);
+	if((index = (struct NCjindex*)calloc(1,sizeof(struct NCjindex))) == NULL)
+	    return NULL;
+	if((index->slots = (size_t*)calloc(nslots,sizeof(size_t))) == NULL)
+	    {free(index); return NULL;}
+	index->nslots = nslots;
+	mlist->index = index;
+    }
+    for(p=index->npairs;p<npairs;p++)
+	indexadd(index,list,p);
+    index->npairs = npairs;
+    return index;
+}
+
+static void
+listunindex(struct NCjlist* list)
+{
+    if(list->index == NULL) return;
+    nullfree(list->index->slots);
+    free(list->index);
+    list->index = NULL;
+}
+
+/* Locate a key in a list of (key,value) pairs.
+@param list pointer to the list
+@param key  for which to search
+@return the position of the key in the list, or -1 if not found
+*/
+static int
+listfind(const struct NCjlist* list, const char* key)
+{
+    struct NCjindex* index = listindex(list);
+    size_t i, len = list->len - (list->len % 2);
+
+    if(index != NULL) {
+	size_t mask = index->nslots - 1;
+	size_t slot;
+	for(slot=keyhash(key) & mask;index->slots[slot] != 0;slot=(slot+1) & mask) {
+	    i = 2*(index->slots[slot]-1);
+	    if(strcmp(list->contents[i]->string,key)==0) return (int)i;
+	}
+	return -1;
+    }
+    for(i=0;i<len;i+=2) {
+	const NCjson* jkey = list->contents[i];
+	if(jkey != NULL && jkey->string != NULL && strcmp(jkey->string,key)==0) return (int)i;
+    }
+    return -1;
+}
+
 /* Increase the space available to dict/array.
    Even if alloc is zero, ensure that the object's list alloc is >= 1.
 @param list pointer to the list
@@ -859,20 +964,14 @@ listsetalloc(struct NCjlist* list, size_t alloc)
     assert(list->alloc == 0 || list->contents != NULL);
     if(alloc == 0) alloc = 1; /* Guarantee that the list->content is not NULL */
     if(list->alloc >= alloc) goto done;
-    /* Since alloc > list->alloc > 0, we need to allocate space */
-    if((newcontents=(NCjson**)calloc(alloc,sizeof(NCjson*))) == NULL) {stat = NCJTHROW(NCJ_ERR); goto done;}
+    /* Grow at least geometrically so that appending is amortized constant time */
+    if(alloc < 2*list->alloc) alloc = 2*list->alloc;
+    if((newcontents=(NCjson**)realloc(list->contents,alloc*sizeof(NCjson*))) == NULL) {stat = NCJTHROW(NCJ_ERR); goto done;}
+    memset((void*)(newcontents+list->alloc),0,sizeof(NCjson*)*(alloc - list->alloc));
     list->alloc = alloc;
-    if(list->contents != NULL && list->len > 0) {
-	/* Preserve any existing contents */
-	memcpy((void*)newcontents,
-		(void*)list->contents,
-		sizeof(NCjson*)*list->len);
-    }
-    free(list->contents);
-    list->contents = newcontents; newcontents = NULL;
+    list->contents = newcontents;
     assert(list->alloc > 0 && list->contents != NULL);
 done:
-    if(newcontents != NULL) free(newcontents);
     return NCJTHROW(stat);
 }
 
@@ -891,10 +990,9 @@ NCJclone(const NCjson* json, NCjson** clonep)
     case NCJ_DOUBLE:
     case NCJ_BOOLEAN:
     case NCJ_STRING:
-	if((stat=NCJnew(NCJsort(json),&clone))==NCJ_ERR) goto done;
-	NCJsetstring(clone,strdup(NCJstring(json)));
-	if(NCJstring(clone)==NULL)
+	if(NCJstring(json)==NULL)
 	    {stat = NCJTHROW(NCJ_ERR); goto done;}
+	if((stat=NCJnewstring(NCJsort(json),NCJstring(json),&clone))==NCJ_ERR) goto done;
 	break;
     case NCJ_NULL:
 	if((stat=NCJnew(NCJsort(json),&clone))==NCJ_ERR) goto done;
@@ -977,7 +1075,6 @@ OPTSTATIC int
 NCJinsert(NCjson* jdict, const char* key, NCjson* jvalue)
 {
     int stat = NCJ_OK;
-    size_t i;
     NCjson* jkey = NULL;
     NCjson* jprev = NULL;
     int found;
@@ -986,19 +1083,12 @@ NCJinsert(NCjson* jdict, const char* key, NCjson* jvalue)
 	|| NCJsort(jdict) != NCJ_DICT
 	|| key == NULL
 	|| jvalue == NULL) {stat = NCJTHROW(NCJ_ERR); goto done;}
-    for(found=(-1),i=0;i < NCJdictlength(jdict); i++) {
-	jkey = NCJdictkey(jdict,i);
-	if (jkey != NULL && strcmp(NCJstring(jkey), key) == 0) {
-	    found = (int)i;
-	    break;
-	}
-    }
+    found = listfind(&jdict->list,key);
     if(found >= 0) {
-	jprev = NCJdictvalue(jdict,found);
+	jprev = jdict->list.contents[found+1];
 	// replace existing values for new key
 	NCJreclaim(jprev); // free old value
-	NCJdictvalue(jdict,found) = jvalue; jvalue = NULL;
-	jkey = NULL; /* avoid reclamation */
+	jdict->list.contents[found+1] = jvalue; jvalue = NULL;
     } else { /* not found */
         if((stat=listsetalloc(&jdict->list,jdict->list.len+2))<0) goto done;
 	NCJcheck(NCJnewstring(NCJ_STRING, key, (NCjson**)&jkey));
@@ -1119,20 +1209,23 @@ NCJoverwrite(NCjson* dict, const char* key, NCjson* jvalue)
     /* See if key already exists */
     switch(stat=listlookup(&dict->list,key,&index)) {
     case NCJ_OK:
-	/* Overwrite value part */
-	oldvalue = dict->list.contents[index];
-	dict->list.contents[index] = jvalue;
+	/* Overwrite value part, which follows the key */
+	oldvalue = dict->list.contents[index+1];
+	dict->list.contents[index+1] = jvalue;
 	NCJreclaim(oldvalue);
 	break;
     case NCJ_EOF: /* Not found */
 	if((stat=listsetalloc(&dict->list,dict->list.len+2))<0) goto done;
+	if((stat = NCJnewstring(NCJ_STRING,key,&jkey))==NCJ_ERR) goto done;
 	if((stat = NCJappend(dict,jkey))==NCJ_ERR) goto done;
+	jkey = NULL;
 	if((stat = NCJappend(dict,jvalue))==NCJ_ERR) goto done;
 	break;
     case NCJ_ERR:
     default: goto done;
     }
 done:
+    NCJreclaim(jkey);
     return NCJTHROW(stat);
 }
 
@@ -1143,7 +1236,7 @@ OPTSTATIC int
 NCJunparse(const NCjson* json, unsigned flags, char** textp)
 {
     int stat = NCJ_OK;
-    NCJbuf buf = {0,NULL};
+    NCJbuf buf = {0,NULL,0};
     if((stat = NCJunparseR(json,&buf,flags))==NCJ_ERR)
 	goto done;
     if(textp) {*textp = buf.text; buf.text = NULL; buf.len = 0;}
@@ -1247,30 +1340,25 @@ static int
 bytesappend(NCJbuf* buf, const char* s)
 {
     int stat = NCJ_OK;
-    char* newtext = NULL;
+    size_t slen;
     if(buf == NULL)
         {stat = NCJTHROW(NCJ_ERR); goto done;}
     if(s == NULL) s = "";
-    if(buf->len == 0) {
-	assert(buf->text == NULL);
-	buf->text = strdup(s);
-	if(buf->text == NULL)
-	    {stat = NCJTHROW(NCJ_ERR); goto done;}
-	buf->len = strlen(s);
-    } else {
-	size_t slen = strlen(s);
-	size_t newlen = buf->len + slen + 1;
-        if((newtext = (char*)malloc(newlen))==NULL)
+    slen = strlen(s);
+    if(buf->len + slen + 1 > buf->alloc) {
+	/* Grow geometrically; unparsing large metadata appends many short pieces */
+	size_t newalloc = (buf->alloc == 0 ? NCJ_DEFAULTALLOC : buf->alloc);
+	char* newtext = NULL;
+	while(newalloc < buf->len + slen + 1) newalloc *= 2;
+        if((newtext = (char*)realloc(buf->text,newalloc))==NULL)
             {stat = NCJTHROW(NCJ_ERR); goto done;}
-        strcpy(newtext,buf->text);
-	strcat(newtext,s);	
-	free(buf->text); buf->text = NULL;
-	buf->text = newtext; newtext = NULL;
-	buf->len = newlen;
+	buf->text = newtext;
+	buf->alloc = newalloc;
     }
+    memcpy(buf->text+buf->len,s,slen+1);
+    buf->len += slen;
 
 done:
-    nullfree(newtext);
     return NCJTHROW(stat);
 }
 
@@ -1318,6 +1406,7 @@ OPTSTATIC void
 NCJdictsort(NCjson* jdict)
 {
     assert(NCJsort(jdict) == NCJ_DICT);
+    listunindex(&jdict->list); /* the pairs move */
     qsort((void*)NCJcontents(jdict),NCJdictlength(jdict),2*sizeof(NCjson*),pairsort);
 }
 
@@ -15,6 +15,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#ifdef NETCDF_ENABLE_THREADSAFE
+#include <pthread.h>
+#endif
 #include "ncdispatch.h"
 
 /** This shift is applied to the ext_ncid in order to get the index in
@@ -33,6 +36,23 @@ static NC** nc_filelist = NULL;
 /** The number of files currently open. */
 static int numfiles = 0;
 
+#ifdef NETCDF_ENABLE_THREADSAFE
+/** Protects nc_filelist and numfiles. This lock is taken on every
+ * API call, so it is a reader/writer lock that never has any
+ * other lock acquired while it is held. */
+static pthread_rwlock_t nc_filelistlock = PTHREAD_RWLOCK_INITIALIZER;
+#define RDLOCK() pthread_rwlock_rdlock(&nc_filelistlock)
+#define WRLOCK() pthread_rwlock_wrlock(&nc_filelistlock)
+#define UNLOCK() pthread_rwlock_unlock(&nc_filelistlock)
+#else
+#define RDLOCK()
+#define WRLOCK()
+#define UNLOCK()
+#endif
+
+/* Forward */
+static void free_NCList_locked(void);
+
 /**
  * How many files are currently open?
  *
@@ -42,7 +62,11 @@ static int numfiles = 0;
 int
 count_NCList(void)
 {
-    return numfiles;
+    int n;
+    RDLOCK();
+    n = numfiles;
+    UNLOCK();
+    return n;
 }
 
 /**
@@ -53,6 +77,15 @@ count_NCList(void)
  */
 void
 free_NCList(void)
+{
+    WRLOCK();
+    free_NCList_locked();
+    UNLOCK();
+}
+
+/* Free an empty NCList; the write lock must be held */
+static void
+free_NCList_locked(void)
 {
     if(numfiles > 0) return; /* not empty */
     if(nc_filelist != NULL) free(nc_filelist);
@@ -83,9 +116,12 @@ add_to_NCList(NC* ncp)
 {
     unsigned int i;
     unsigned int new_id;
+    int stat = NC_NOERR;
+
+    WRLOCK();
     if(nc_filelist == NULL) {
         if (!(nc_filelist = calloc(1, sizeof(NC*)*NCFILELISTLENGTH)))
-            return NC_ENOMEM;
+            {stat = NC_ENOMEM; goto done;}
         numfiles = 0;
     }
 
@@ -93,11 +129,13 @@ add_to_NCList(NC* ncp)
     for(i=1; i < NCFILELISTLENGTH; i++) {
         if(nc_filelist[i] == NULL) {new_id = i; break;}
     }
-    if(new_id == 0) return NC_ENOMEM; /* no more slots */
+    if(new_id == 0) {stat = NC_ENOMEM; goto done;} /* no more slots */
     nc_filelist[new_id] = ncp;
     numfiles++;
     ncp->ext_ncid = (int)(new_id << ID_SHIFT);
-    return NC_NOERR;
+done:
+    UNLOCK();
+    return stat;
 }
 
 /**
@@ -113,20 +151,24 @@ add_to_NCList(NC* ncp)
 int
 move_in_NCList(NC *ncp, int new_id)
 {
+    int stat = NC_NOERR;
+
+    WRLOCK();
     /* If no files in list, error. */
     if (!nc_filelist)
-        return NC_EINVAL;
+        {stat = NC_EINVAL; goto done;}
 
     /* If new slot is already taken, error. */
     if (nc_filelist[new_id])
-        return NC_EINVAL;
+        {stat = NC_EINVAL; goto done;}
 
     /* Move the file. */
     nc_filelist[ncp->ext_ncid >> ID_SHIFT] = NULL;
     nc_filelist[new_id] = ncp;
     ncp->ext_ncid = (new_id << ID_SHIFT);
-
-    return NC_NOERR;
+done:
+    UNLOCK();
+    return stat;
 }
 
 /**
@@ -145,15 +187,18 @@ void
 del_from_NCList(NC* ncp)
 {
     unsigned int ncid = ((unsigned int)ncp->ext_ncid) >> ID_SHIFT;
-    if(numfiles == 0 || ncid == 0 || nc_filelist == NULL) return;
-    if(nc_filelist[ncid] != ncp) return;
+    WRLOCK();
+    if(numfiles == 0 || ncid == 0 || nc_filelist == NULL) goto done;
+    if(nc_filelist[ncid] != ncp) goto done;
 
     nc_filelist[ncid] = NULL;
     numfiles--;
 
     /* If all files have been closed, release the filelist memory. */
     if (numfiles == 0)
-        free_NCList();
+        free_NCList_locked();
+done:
+    UNLOCK();
 }
 
 /**
@@ -176,11 +221,13 @@ find_in_NCList(int ext_ncid)
 
     /* If we have a filelist, there will be an entry, possibly NULL,
      * for this ncid. */
+    RDLOCK();
     if (nc_filelist)
     {
         assert(numfiles);
         f = nc_filelist[ncid];
     }
+    UNLOCK();
 
     /* For classic files, ext_ncid must be a multiple of
      * (1<<ID_SHIFT). That is, the group part of the ext_ncid (the
@@ -207,8 +254,9 @@ find_in_NCList_by_name(const char* path)
 {
     int i;
     NC* f = NULL;
+    RDLOCK();
     if(nc_filelist == NULL)
-        return NULL;
+        goto done;
     for(i=1; i < NCFILELISTLENGTH; i++) {
         if(nc_filelist[i] != NULL) {
             if(strcmp(nc_filelist[i]->path,path)==0) {
@@ -217,6 +265,8 @@ find_in_NCList_by_name(const char* path)
             }
         }
     }
+done:
+    UNLOCK();
     return f;
 }
 
@@ -240,6 +290,8 @@ iterate_NCList(int index, NC** ncp)
     /* Walk from 0 ...; 0 return => stop */
     if(index < 0 || index >= NCFILELISTLENGTH)
         return NC_ERANGE;
+    RDLOCK();
     if(ncp) *ncp = nc_filelist[index];
+    UNLOCK();
     return NC_NOERR;
 }
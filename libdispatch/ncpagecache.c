@@ -0,0 +1,247 @@
+/*
+Copyright (c) 1998-2018 University Corporation for Atmospheric Research/Unidata
+See COPYRIGHT for license information.
+*/
+
+/*
+Page cache for the byte-range readers; see ncpagecache.h.
+
+The pages are kept in an NCxcache, which provides both the hash
+index and the LRU order. A read first makes the cached pages it
+covers most recently used, so fetching the missing ones cannot evict
+them, then walks the pages in order: cached pages are copied out,
+and each run of missing pages (plus the readahead window, if the run
+ends the read and the read continues the previous one) is fetched
+with one request into a scratch buffer and inserted.
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "netcdf.h"
+#include "ncrc.h"
+#include "ncxcache.h"
+#include "ncpagecache.h"
+
+#define NOPAGE ((size64_t)-1)
+
+/* A cached page of the remote object */
+typedef struct NCpage {
+    NCxnode lru;          /* must be first; see NCXUSER in ncxcache.h */
+    size64_t pageno;
+    ncexhashkey_t hkey;
+    size_t len;           /* < pagesize only for the last page of the object */
+    unsigned char* data;  /* allocated right after this struct */
+} NCpage;
+
+struct NCpagecache {
+    size64_t objsize;
+    size_t pagesize;      /* 0 => no caching */
+    size_t maxpages;      /* max pages held; 0 => no caching */
+    size_t readahead;     /* extra pages fetched by a sequential miss */
+    NCxcache* pages;      /* hash index + LRU list of NCpage */
+    size64_t lastpage;    /* last page touched by the previous read */
+    NCpagefetch* fetch;
+    void* state;
+    unsigned char* scratch; /* receives each fetch */
+    size_t scratchsize;
+    NCpagestats stats;
+};
+
+void
+ncpagecacheparams(NCURI* uri, size_t* pagesizep, size_t* maxpagesp, size_t* readaheadp)
+{
+    if(pagesizep)
+        *pagesizep = NC_rclookupsize(uri,"NC_HTTP_PAGESIZE","HTTP.BYTERANGE.PAGESIZE",NCPAGECACHE_PAGESIZE);
+    if(maxpagesp)
+        *maxpagesp = NC_rclookupsize(uri,"NC_HTTP_CACHEPAGES","HTTP.BYTERANGE.CACHEPAGES",NCPAGECACHE_MAXPAGES);
+    if(readaheadp)
+        *readaheadp = NC_rclookupsize(uri,"NC_HTTP_READAHEAD","HTTP.BYTERANGE.READAHEAD",NCPAGECACHE_READAHEAD);
+}
+
+int
+ncpagecachenew(size64_t objsize, size_t pagesize, size_t maxpages, size_t readahead,
+               NCpagefetch* fetch, void* state, NCpagecache** cachep)
+{
+    NCpagecache* cache = NULL;
+
+    if(fetch == NULL || cachep == NULL) return NC_EINVAL;
+    if((cache = (NCpagecache*)calloc(1,sizeof(NCpagecache))) == NULL)
+        return NC_ENOMEM;
+    cache->objsize = objsize;
+    cache->pagesize = pagesize;
+    cache->maxpages = maxpages;
+    cache->readahead = readahead;
+    cache->fetch = fetch;
+    cache->state = state;
+    cache->lastpage = NOPAGE;
+    if(cache->pagesize == 0 || cache->maxpages == 0
+       || ncxcachenew(cache->maxpages,&cache->pages) != NC_NOERR) {
+        cache->pagesize = 0;
+        cache->maxpages = 0;
+        cache->pages = NULL;
+    }
+    if(cache->readahead >= cache->maxpages)
+        cache->readahead = (cache->maxpages > 0 ? cache->maxpages - 1 : 0);
+    *cachep = cache;
+    return NC_NOERR;
+}
+
+void
+ncpagecachefree(NCpagecache* cache)
+{
+    NCpage* page = NULL;
+
+    if(cache == NULL) return;
+    if(cache->pages != NULL) {
+        while((page = (NCpage*)ncxcachelast(cache->pages)) != NULL) {
+            void* obj = NULL;
+            (void)ncxcacheremove(cache->pages,page->hkey,&obj);
+            free(page);
+        }
+        ncxcachefree(cache->pages);
+    }
+    free(cache->scratch);
+    free(cache);
+}
+
+void
+ncpagecachestats(const NCpagecache* cache, NCpagestats* statsp)
+{
+    if(statsp == NULL) return;
+    if(cache == NULL)
+        memset(statsp,0,sizeof(NCpagestats));
+    else
+        *statsp = cache->stats;
+}
+
+static NCpage*
+pagelookup(NCpagecache* cache, size64_t pageno)
+{
+    void* obj = NULL;
+    ncexhashkey_t hkey = ncxcachekey(&pageno,sizeof(pageno));
+    if(ncxcachelookup(cache->pages,hkey,&obj) != NC_NOERR) return NULL;
+    if(((NCpage*)obj)->pageno != pageno) return NULL; /* hash collision */
+    return (NCpage*)obj;
+}
+
+/* Insert a copy of one page, evicting the least recently used page if full */
+static int
+pageinsert(NCpagecache* cache, size64_t pageno, const unsigned char* data, size_t len)
+{
+    int stat = NC_NOERR;
+    NCpage* page = NULL;
+
+    while(ncxcachecount(cache->pages) >= cache->maxpages) {
+        void* obj = NULL;
+        NCpage* lru = (NCpage*)ncxcachelast(cache->pages);
+        if(lru == NULL) break;
+        if((stat = ncxcacheremove(cache->pages,lru->hkey,&obj))) return stat;
+        free(lru);
+    }
+    if((page = (NCpage*)calloc(1,sizeof(NCpage)+cache->pagesize)) == NULL)
+        return NC_ENOMEM;
+    page->pageno = pageno;
+    page->hkey = ncxcachekey(&pageno,sizeof(pageno));
+    page->len = len;
+    page->data = (unsigned char*)(page+1);
+    memcpy(page->data,data,len);
+    if((stat = ncxcacheinsert(cache->pages,page->hkey,page)))
+        free(page);
+    return stat;
+}
+
+/* Issue one ranged request into dst, counting it */
+static int
+fetch(NCpagecache* cache, size64_t start, size_t count, void* dst)
+{
+    int stat = NC_NOERR;
+    if((stat = cache->fetch(cache->state,start,count,dst))) return stat;
+    cache->stats.requests++;
+    cache->stats.bytes += count;
+    return NC_NOERR;
+}
+
+int
+ncpagecacheread(NCpagecache* cache, size64_t offset, size_t count, void* buf0)
+{
+    int stat = NC_NOERR;
+    unsigned char* buf = (unsigned char*)buf0;
+    size_t pagesize;
+    size64_t first, last, lastpage, p;
+    int sequential;
+
+    if(cache == NULL) return NC_EINVAL;
+    if(count == 0) return NC_NOERR;
+    if(offset + count > cache->objsize) return NC_EINVAL;
+    if(cache->pages == NULL) goto direct;
+    pagesize = cache->pagesize;
+    first = offset / pagesize;
+    last = (offset + count - 1) / pagesize;
+    if(last - first + 1 > cache->maxpages) goto direct; /* would only thrash the cache */
+    lastpage = (cache->objsize - 1) / pagesize;
+    sequential = (cache->lastpage != NOPAGE
+                  && (first == cache->lastpage || first == cache->lastpage + 1));
+    cache->lastpage = last;
+
+    /* Make all the cached pages of the request most recently used,
+       so that fetching the missing ones cannot evict them */
+    for(p=first;p<=last;p++) {
+        NCpage* page = pagelookup(cache,p);
+        if(page != NULL) (void)ncxcachetouch(cache->pages,page->hkey);
+    }
+
+    for(p=first;p<=last;) {
+        NCpage* page = pagelookup(cache,p);
+        size64_t q, end, pstart, pend, lo, hi;
+        size_t need;
+
+        if(page != NULL) {
+            size64_t pbase = p * pagesize;
+            lo = (offset > pbase ? offset : pbase);
+            hi = ((offset + count) < (pbase + page->len) ? (offset + count) : (pbase + page->len));
+            memcpy(buf + (lo - offset), page->data + (lo - pbase), (size_t)(hi - lo));
+            cache->stats.hits++;
+            p++;
+            continue;
+        }
+        /* Coalesce the run of missing pages starting at p */
+        for(q=p+1;q<=last && pagelookup(cache,q) == NULL;q++);
+        cache->stats.misses += (q - p);
+        end = q; /* exclusive */
+        if(q > last && sequential) {
+            /* Read ahead, stopping at a cached page or the end of the object */
+            size_t room = cache->maxpages - (size_t)(last - first + 1);
+            size_t n = (cache->readahead < room ? cache->readahead : room);
+            for(;n > 0 && end <= lastpage && pagelookup(cache,end) == NULL;n--,end++)
+                cache->stats.ahead++;
+        }
+        pstart = p * pagesize;
+        pend = end * pagesize;
+        if(pend > cache->objsize) pend = cache->objsize;
+        need = (size_t)(pend - pstart);
+        if(need > cache->scratchsize) {
+            unsigned char* newscratch = (unsigned char*)realloc(cache->scratch,need);
+            if(newscratch == NULL) return NC_ENOMEM;
+            cache->scratch = newscratch;
+            cache->scratchsize = need;
+        }
+        if((stat = fetch(cache,pstart,need,cache->scratch))) return stat;
+        /* Copy out the requested part */
+        lo = (offset > pstart ? offset : pstart);
+        hi = (pend < offset + count ? pend : offset + count);
+        memcpy(buf + (lo - offset), cache->scratch + (lo - pstart), (size_t)(hi - lo));
+        /* Cache the fetched pages */
+        for(;p<end;p++) {
+            size_t off = (size_t)((p * pagesize) - pstart);
+            size_t len = need - off;
+            if(len > pagesize) len = pagesize;
+            if((stat = pageinsert(cache,p,cache->scratch + off,len))) return stat;
+        }
+    }
+    return NC_NOERR;
+
+direct:
+    return fetch(cache,offset,count,buf);
+}
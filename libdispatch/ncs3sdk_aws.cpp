@@ -494,6 +494,61 @@ NC_s3sdkread(void* s3client0, const char* bucket, const char* pathkey, size64_t
     return NCUNTRACE(stat);
 }
 
+/*
+Read a whole object with a single GET; the size is taken
+from the response rather than from a separate HEAD.
+The content is malloc'd and must be freed by the caller.
+@return NC_NOERR if success
+@return NC_EEMPTY if the object does not exist
+@return NC_EXXX if fail
+*/
+/*EXTERNL*/ int
+NC_s3sdkreadall(void* s3client0, const char* bucket, const char* pathkey, size64_t* sizep, void** contentp, char** errmsgp)
+{
+    int stat = NC_NOERR;
+    const char* key = NULL;
+    void* content = NULL;
+
+    NCTRACE(11,"bucket=%s pathkey=%s",bucket,pathkey);
+
+    AWSS3CLIENT s3client = (AWSS3CLIENT)s3client0;
+
+    if(errmsgp) *errmsgp = NULL;
+    if(*pathkey != '/') return NCUNTRACE(NC_EINTERNAL);
+    if((stat = makes3key(pathkey,&key))) return NCUNTRACE(stat);
+
+    Aws::S3::Model::GetObjectRequest object_request;
+    object_request.SetBucket(bucket);
+    object_request.SetKey(key);
+    auto get_object_result = AWSS3GET(s3client)->GetObject(object_request);
+    if(!get_object_result.IsSuccess()) {
+	switch (get_object_result.GetError().GetErrorType()) {
+	case Aws::S3::S3Errors::NO_SUCH_KEY:
+	case Aws::S3::S3Errors::RESOURCE_NOT_FOUND:
+	    stat = NC_EEMPTY;
+	    break;
+	case Aws::S3::S3Errors::ACCESS_DENIED:
+	    stat = NC_EACCESS;
+	    /* fall thru */
+	default:
+	    if(!stat) stat = NC_ES3;
+	    if(errmsgp) *errmsgp = makeerrmsg(get_object_result.GetError(),key);
+	    break;
+	}
+    } else {
+	Aws::IOStream &result = get_object_result.GetResultWithOwnership().GetBody();
+	std::string str((std::istreambuf_iterator<char>(result)),std::istreambuf_iterator<char>());
+	size_t slen = str.size();
+	if((content = malloc(slen > 0 ? slen : 1)) == NULL)
+	    return NCUNTRACE(NC_ENOMEM);
+	memcpy(content,str.c_str(),slen);
+	if(sizep) *sizep = (size64_t)slen;
+	if(contentp) {*contentp = content; content = NULL;}
+    }
+    if(content) free(content);
+    return NCUNTRACEX(stat,"size=%llu",(sizep?*sizep:0));
+}
+
 /*
 For S3, I can see no way to do a byterange write;
 so we are effectively writing the whole object
@@ -549,6 +604,45 @@ NC_s3sdkwriteobject(void* s3client0, const char* bucket, const char* pathkey,  s
     return NCUNTRACE(stat);
 }
 
+/*
+The AWS SDK client has its own pool of connections, so the
+request is simply performed before returning.
+*/
+/*EXTERNL*/ int
+NC_s3sdksubmit(void* s3client0, const char* bucket, NCS3REQ* req, char** errmsgp)
+{
+    int stat = NC_NOERR;
+    size64_t size = 0;
+
+    NCTRACE(11,"bucket=%s pathkey=%s op=%d start=%llu count=%llu",bucket,req->pathkey,(int)req->op,req->start,req->count);
+
+    switch (req->op) {
+    case NCS3GET:
+        if(req->count == 0) {
+            req->stat = NC_s3sdkreadall(s3client0,bucket,req->pathkey,&req->count,&req->content,errmsgp);
+            break;
+        }
+        if((req->stat = NC_s3sdkinfo(s3client0,bucket,req->pathkey,&size,errmsgp))) break;
+        if(req->start >= size || req->start+req->count > size)
+            {req->stat = NC_EEDGE; break;}
+        req->stat = NC_s3sdkread(s3client0,bucket,req->pathkey,req->start,req->count,req->content,errmsgp);
+        break;
+    case NCS3PUT:
+        req->stat = NC_s3sdkwriteobject(s3client0,bucket,req->pathkey,req->count,req->content,errmsgp);
+        break;
+    default: stat = NC_EINVAL; break;
+    }
+    return NCUNTRACE(stat);
+}
+
+/*EXTERNL*/ int
+NC_s3sdkwait(void* s3client0, char** errmsgp)
+{
+    (void)s3client0;
+    if(errmsgp) *errmsgp = NULL;
+    return NC_NOERR;
+}
+
 /*EXTERNL*/ int
 NC_s3sdkclose(void* s3client0, char** errmsgp)
 {
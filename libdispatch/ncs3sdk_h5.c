@@ -50,8 +50,16 @@ extern char* strdup(const char*);
 typedef struct NCS3CLIENT {
     char*	rooturl;      /* The URL (minus any fragment) for the dataset root path (excludes bucket on down) */ 
     s3r_t*	h5s3client; /* From h5s3comms */  
+    NClist*	pending;    /* NClist<struct S3Pending*>: submitted, not yet waited for */
 } NCS3CLIENT;
 
+/* A request given to NC_s3sdksubmit() */
+struct S3Pending {
+    s3r_request_t request;
+    char* url;
+    NCS3REQ* req;
+};
+
 struct Object {
     NClist* checksumalgorithms; /* NClist<char*> */
     NClist* checksumtypes; /* NClist<char*> */
@@ -105,6 +113,8 @@ static int s3commonprefixes(NClist* list, NClist* keys);
 static int mergekeysets(NClist*,NClist*,NClist*);
 static int rawtokeys(s3r_buf_t* response, NClist* keys, NClist* lengths, struct LISTOBJECTSV2** listv2p);
 static int httptonc(long httpcode);
+static size_t s3connections(const char* rooturl);
+static void freepending(NClist* pending);
 
 static int queryadd(NClist* query, const char* key, const char* value);
 static int queryend(NClist* query, char** querystring);
@@ -193,6 +203,8 @@ NC_s3sdkcreateclient(NCS3INFO* info)
     if((s3client->rooturl = makes3rooturl(info))==NULL) {stat = NC_ENOMEM; goto done;}
     s3client->h5s3client = NCH5_s3comms_s3r_open(s3client->rooturl,info->svc,info->region,accessid,accesskey);
     if(s3client->h5s3client == NULL) {stat = NC_ES3; goto done;}
+    if((stat = NCH5_s3comms_s3r_setconnections(s3client->h5s3client,s3connections(s3client->rooturl)))) goto done;
+    s3client->pending = nclistnew();
 
 done:
     nullfree(urlroot);
@@ -312,6 +324,35 @@ done:
     return NCUNTRACE(stat);
 }
 
+/*
+Read a whole object with a single request; the size is
+taken from the response rather than from a separate HEAD.
+The content is malloc'd and must be freed by the caller.
+@return NC_NOERR if success
+@return NC_EXXX if fail
+*/
+/*EXTERNL*/ int
+NC_s3sdkreadall(void* s3client0, const char* bucket, const char* pathkey, size64_t* sizep, void** contentp, char** errmsgp)
+{
+    int stat = NC_NOERR;
+    NCS3CLIENT* s3client = (NCS3CLIENT*)s3client0;
+    NCbytes* url = ncbytesnew();
+    struct s3r_buf_t data = {0,NULL};
+    long httpcode = 0;
+
+    NCTRACE(11,"bucket=%s pathkey=%s",bucket,pathkey);
+
+    if((stat = makes3fullpath(s3client->rooturl,bucket,pathkey,NULL,url))) goto done;
+    if((stat = NCH5_s3comms_s3r_readall(s3client->h5s3client,ncbytescontents(url),&data,&httpcode))) goto done;
+    if((stat = httptonc(httpcode))) goto done;
+    if(sizep) *sizep = (size64_t)data.count;
+    if(contentp) {*contentp = data.content; data.content = NULL;}
+done:
+    nullfree(data.content);
+    ncbytesfree(url);
+    return NCUNTRACEX(stat,"size=%llu",(sizep?*sizep:0));
+}
+
 /*
 For S3, I can see no way to do a byterange write;
 so we are effectively writing the whole object
@@ -340,6 +381,91 @@ done:
     return NCUNTRACE(stat);
 }
 
+/*
+Queue a GET or PUT on the client's pool of connections; it is
+started at once if a connection is free.
+@return NC_NOERR if the request was queued
+@return NC_EXXX if fail
+*/
+/*EXTERNL*/ int
+NC_s3sdksubmit(void* s3client0, const char* bucket, NCS3REQ* req, char** errmsgp)
+{
+    int stat = NC_NOERR;
+    NCS3CLIENT* s3client = (NCS3CLIENT*)s3client0;
+    NCbytes* url = ncbytesnew();
+    struct S3Pending* p = NULL;
+
+    NCTRACE(11,"bucket=%s pathkey=%s op=%d start=%llu count=%llu",bucket,req->pathkey,(int)req->op,req->start,req->count);
+    if(errmsgp) *errmsgp = NULL;
+
+    if((p = (struct S3Pending*)calloc(1,sizeof(struct S3Pending)))==NULL) {stat = NC_ENOMEM; goto done;}
+    if((stat = makes3fullpath(s3client->rooturl,bucket,req->pathkey,NULL,url))) goto done;
+    p->url = ncbytesextract(url);
+    p->req = req;
+    p->request.url = p->url;
+    switch (req->op) {
+    case NCS3GET:
+        p->request.verb = HTTPGET;
+        p->request.offset = (size_t)req->start;
+        p->request.len = (size_t)req->count;
+        if(req->count > 0) p->request.data.content = req->content;
+        break;
+    case NCS3PUT:
+        p->request.verb = HTTPPUT;
+        p->request.data.count = req->count;
+        p->request.data.content = req->content;
+        break;
+    default: stat = NC_EINVAL; goto done;
+    }
+    req->stat = NC_NOERR;
+    if((stat = NCH5_s3comms_s3r_submit(s3client->h5s3client,&p->request))) goto done;
+    nclistpush(s3client->pending,p);
+    p = NULL;
+done:
+    if(p) {nullfree(p->url); free(p);}
+    ncbytesfree(url);
+    return NCUNTRACE(stat);
+}
+
+/*
+Wait for all the submitted requests and set their stat.
+@return NC_NOERR if success
+@return NC_EXXX if the requests could not be performed
+*/
+/*EXTERNL*/ int
+NC_s3sdkwait(void* s3client0, char** errmsgp)
+{
+    int stat = NC_NOERR;
+    NCS3CLIENT* s3client = (NCS3CLIENT*)s3client0;
+    size_t i;
+
+    NCTRACE(11,"pending=%u",(unsigned)nclistlength(s3client->pending));
+    if(errmsgp) *errmsgp = NULL;
+
+    stat = NCH5_s3comms_s3r_wait(s3client->h5s3client);
+    for(i=0;i<nclistlength(s3client->pending);i++) {
+        struct S3Pending* p = (struct S3Pending*)nclistget(s3client->pending,i);
+        s3r_request_t* request = &p->request;
+        NCS3REQ* req = p->req;
+        if(request->stat != NC_NOERR)
+            req->stat = request->stat;
+        else if(request->httpcode == 416) /* Range Not Satisfiable */
+            req->stat = NC_EEDGE;
+        else
+            req->stat = httptonc(request->httpcode);
+        if(req->op == NCS3GET && req->stat == NC_NOERR) {
+            if(req->count == 0) {
+                req->count = request->data.count;
+                req->content = request->data.content;
+                request->data.content = NULL;
+            } else if(request->data.count != req->count)
+                req->stat = NC_EEDGE; /* short read: the object ends inside the range */
+        }
+    }
+    freepending(s3client->pending);
+    return NCUNTRACE(stat);
+}
+
 /*EXTERNL*/ int
 NC_s3sdkclose(void* s3client0, char** errmsgp)
 {
@@ -626,10 +752,47 @@ s3client_destroy(NCS3CLIENT* s3client)
     if(s3client) {
 	nullfree(s3client->rooturl);
         (void)NCH5_s3comms_s3r_close(s3client->h5s3client);
+	freepending(s3client->pending); /* abandoned by the close */
+	nclistfree(s3client->pending);
         free(s3client);
     }
 }
 
+/* Reclaim the entries of a pending list, leaving it empty */
+static void
+freepending(NClist* pending)
+{
+    while(nclistlength(pending) > 0) {
+        struct S3Pending* p = (struct S3Pending*)nclistpop(pending);
+	if(p->request.verb == HTTPGET && p->request.len == 0)
+	    nullfree(p->request.data.content);
+	nullfree(p->url);
+	free(p);
+    }
+}
+
+/* Get the maximum no. of concurrent requests per client:
+   NC_S3_CONNECTIONS, else the S3.CONNECTIONS .rc key, else the default */
+static size_t
+s3connections(const char* rooturl)
+{
+    const char* val = getenv("NC_S3_CONNECTIONS");
+    NCURI* uri = NULL;
+    char* endp = NULL;
+    unsigned long n = NCS3_DEFAULT_CONNECTIONS;
+
+    if(val == NULL || strlen(val) == 0) {
+        ncuriparse(rooturl,&uri);
+        if(uri != NULL) val = NC_rclookupx(uri,"S3.CONNECTIONS");
+    }
+    if(val != NULL && strlen(val) > 0) {
+        n = strtoul(val,&endp,10);
+        if(endp == val || *endp != '\0' || n == 0) n = NCS3_DEFAULT_CONNECTIONS;
+    }
+    ncurifree(uri);
+    return (size_t)n;
+}
+
 /**************************************************/
 /* XML Response Parser(s) */
 
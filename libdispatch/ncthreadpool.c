@@ -0,0 +1,306 @@
+/*
+  Copyright (c) 1998-2018 University Corporation for Atmospheric Research/Unidata
+  See LICENSE.txt for license information.
+*/
+
+/** \file \internal
+    Internal netcdf functions.
+
+    This file contains a minimal fixed-size pool of worker
+    threads; see ncthreadpool.h for the contract.
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#ifdef NETCDF_ENABLE_THREADPOOL
+#include <pthread.h>
+#endif
+
+#include "netcdf.h"
+#include "ncthreadpool.h"
+
+#ifdef NETCDF_ENABLE_THREADPOOL
+
+typedef struct NCtask {
+    struct NCtask* next;
+    NCtaskfcn fcn;
+    void* arg;
+    NCtaskgroup* group;
+} NCtask;
+
+struct NCthreadpool {
+    size_t nworkers;
+    size_t nstarted; /* |workers| actually created */
+    pthread_t* workers;
+    pthread_mutex_t lock; /* protects everything below and all the groups */
+    pthread_cond_t ready; /* signalled when a task is queued or at shutdown */
+    NCtask* head;
+    NCtask* tail;
+    int shutdown;
+};
+
+struct NCtaskgroup {
+    NCthreadpool* pool;
+    size_t pending; /* submitted but not yet completed */
+    int stat; /* first error */
+    pthread_cond_t done; /* signalled when pending drops to zero */
+};
+
+/* Remove the first queued task; lock must be held */
+static NCtask*
+dequeue(NCthreadpool* pool)
+{
+    NCtask* task = pool->head;
+    if(task != NULL) {
+        pool->head = task->next;
+        if(pool->head == NULL) pool->tail = NULL;
+    }
+    return task;
+}
+
+/* Execute a task with the lock released; lock must be held on entry and is held on exit */
+static void
+runtask(NCthreadpool* pool, NCtask* task)
+{
+    int stat;
+    NCtaskgroup* group = task->group;
+
+    pthread_mutex_unlock(&pool->lock);
+    stat = task->fcn(task->arg);
+    free(task);
+    pthread_mutex_lock(&pool->lock);
+    if(stat != NC_NOERR && group->stat == NC_NOERR) group->stat = stat;
+    assert(group->pending > 0);
+    if(--group->pending == 0)
+        pthread_cond_broadcast(&group->done);
+}
+
+static void*
+worker(void* arg)
+{
+    NCthreadpool* pool = (NCthreadpool*)arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for(;;) {
+        NCtask* task;
+        while(pool->head == NULL && !pool->shutdown)
+            pthread_cond_wait(&pool->ready,&pool->lock);
+        if((task = dequeue(pool)) == NULL) break; /* shutdown and queue drained */
+        runtask(pool,task);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int
+ncthreadpoolnew(size_t nworkers, NCthreadpool** poolp)
+{
+    int stat = NC_NOERR;
+    NCthreadpool* pool = NULL;
+
+    if(poolp == NULL) {stat = NC_EINVAL; goto done;}
+    if((pool = calloc(1,sizeof(NCthreadpool))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    pool->nworkers = nworkers;
+    if(pthread_mutex_init(&pool->lock,NULL))
+        {free(pool); pool = NULL; stat = NC_EINTERNAL; goto done;}
+    if(pthread_cond_init(&pool->ready,NULL)) {
+        pthread_mutex_destroy(&pool->lock);
+        free(pool); pool = NULL;
+        stat = NC_EINTERNAL;
+        goto done;
+    }
+    if(nworkers > 0) {
+        if((pool->workers = calloc(nworkers,sizeof(pthread_t))) == NULL)
+            {stat = NC_ENOMEM; goto done;}
+        for(;pool->nstarted < nworkers;pool->nstarted++) {
+            if(pthread_create(&pool->workers[pool->nstarted],NULL,worker,pool))
+                {stat = NC_EINTERNAL; goto done;}
+        }
+    }
+    *poolp = pool; pool = NULL;
+done:
+    ncthreadpoolfree(pool);
+    return stat;
+}
+
+void
+ncthreadpoolfree(NCthreadpool* pool)
+{
+    size_t i;
+    NCtask* task;
+
+    if(pool == NULL) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    for(i=0;i<pool->nstarted;i++)
+        pthread_join(pool->workers[i],NULL);
+    /* With no workers, anything still queued must be run here */
+    pthread_mutex_lock(&pool->lock);
+    while((task = dequeue(pool)) != NULL)
+        runtask(pool,task);
+    pthread_mutex_unlock(&pool->lock);
+    pthread_cond_destroy(&pool->ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+size_t
+ncthreadpoolsize(const NCthreadpool* pool)
+{
+    return (pool == NULL ? 0 : pool->nstarted);
+}
+
+int
+nctaskgroupnew(NCthreadpool* pool, NCtaskgroup** groupp)
+{
+    NCtaskgroup* group = NULL;
+
+    if(pool == NULL || groupp == NULL) return NC_EINVAL;
+    if((group = calloc(1,sizeof(NCtaskgroup))) == NULL)
+        return NC_ENOMEM;
+    group->pool = pool;
+    group->stat = NC_NOERR;
+    if(pthread_cond_init(&group->done,NULL))
+        {free(group); return NC_EINTERNAL;}
+    *groupp = group;
+    return NC_NOERR;
+}
+
+void
+nctaskgroupfree(NCtaskgroup* group)
+{
+    if(group == NULL) return;
+    (void)nctaskwait(group);
+    pthread_cond_destroy(&group->done);
+    free(group);
+}
+
+int
+nctasksubmit(NCtaskgroup* group, NCtaskfcn fcn, void* arg)
+{
+    NCthreadpool* pool;
+    NCtask* task = NULL;
+
+    if(group == NULL || fcn == NULL) return NC_EINVAL;
+    pool = group->pool;
+    if((task = calloc(1,sizeof(NCtask))) == NULL)
+        return NC_ENOMEM;
+    task->fcn = fcn;
+    task->arg = arg;
+    task->group = group;
+    pthread_mutex_lock(&pool->lock);
+    if(pool->tail == NULL) pool->head = task; else pool->tail->next = task;
+    pool->tail = task;
+    group->pending++;
+    pthread_cond_signal(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    return NC_NOERR;
+}
+
+int
+nctaskwait(NCtaskgroup* group)
+{
+    int stat;
+    NCthreadpool* pool;
+
+    if(group == NULL) return NC_EINVAL;
+    pool = group->pool;
+    pthread_mutex_lock(&pool->lock);
+    while(group->pending > 0) {
+        /* Help out rather than just block */
+        NCtask* task = dequeue(pool);
+        if(task != NULL)
+            runtask(pool,task);
+        else
+            pthread_cond_wait(&group->done,&pool->lock);
+    }
+    stat = group->stat;
+    group->stat = NC_NOERR;
+    pthread_mutex_unlock(&pool->lock);
+    return stat;
+}
+
+#else /*!NETCDF_ENABLE_THREADPOOL*/
+
+/* Sequential fallback: tasks are executed at submission */
+
+struct NCthreadpool {
+    size_t nworkers;
+};
+
+struct NCtaskgroup {
+    NCthreadpool* pool;
+    int stat; /* first error */
+};
+
+int
+ncthreadpoolnew(size_t nworkers, NCthreadpool** poolp)
+{
+    NCthreadpool* pool = NULL;
+    (void)nworkers;
+    if(poolp == NULL) return NC_EINVAL;
+    if((pool = calloc(1,sizeof(NCthreadpool))) == NULL)
+        return NC_ENOMEM;
+    *poolp = pool;
+    return NC_NOERR;
+}
+
+void
+ncthreadpoolfree(NCthreadpool* pool)
+{
+    free(pool);
+}
+
+size_t
+ncthreadpoolsize(const NCthreadpool* pool)
+{
+    (void)pool;
+    return 0;
+}
+
+int
+nctaskgroupnew(NCthreadpool* pool, NCtaskgroup** groupp)
+{
+    NCtaskgroup* group = NULL;
+    if(pool == NULL || groupp == NULL) return NC_EINVAL;
+    if((group = calloc(1,sizeof(NCtaskgroup))) == NULL)
+        return NC_ENOMEM;
+    group->pool = pool;
+    group->stat = NC_NOERR;
+    *groupp = group;
+    return NC_NOERR;
+}
+
+void
+nctaskgroupfree(NCtaskgroup* group)
+{
+    free(group);
+}
+
+int
+nctasksubmit(NCtaskgroup* group, NCtaskfcn fcn, void* arg)
+{
+    int stat;
+    if(group == NULL || fcn == NULL) return NC_EINVAL;
+    stat = fcn(arg);
+    if(stat != NC_NOERR && group->stat == NC_NOERR) group->stat = stat;
+    return NC_NOERR;
+}
+
+int
+nctaskwait(NCtaskgroup* group)
+{
+    int stat;
+    if(group == NULL) return NC_EINVAL;
+    stat = group->stat;
+    group->stat = NC_NOERR;
+    return stat;
+}
+
+#endif /*NETCDF_ENABLE_THREADPOOL*/
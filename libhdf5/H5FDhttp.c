@@ -59,6 +59,10 @@
 #include "ncbytes.h"
 #include "nclist.h"
 #include "nchttp.h"
+#include "ncuri.h"
+#include "ncrc.h"
+#include "nclog.h"
+#include "ncpagecache.h"
 
 #include "H5FDhttp.h"
 
@@ -95,9 +99,10 @@ typedef struct H5FD_http_t {
     H5FD_http_file_op op;	/* last operation */
     NC_HTTP_STATE*  state;       /* Curl handle + extra */
     char*           url;        /* The URL (minus any fragment) for the dataset */ 
+    NCbytes*        buf;        /* Reused for every byte-range request */
+    NCpagecache*    cache;      /* Page cache; see H5FD_http_read */
 } H5FD_http_t;
 
-
 /* These macros check for overflow of various quantities.  These macros
  * assume that file_offset_t is signed and haddr_t and size_t are unsigned.
  *
@@ -141,6 +146,10 @@ static herr_t H5FD_http_flush(H5FD_t *_file, hid_t dxpl_id, hbool_t closing);
 static herr_t H5FD_http_lock(H5FD_t *_file, hbool_t rw);
 static herr_t H5FD_http_unlock(H5FD_t *_file);
 
+static int http_cache_init(H5FD_http_t* file);
+static void http_cache_free(H5FD_http_t* file);
+static int http_fetch(void* state, size64_t start, size_t count, void* dst);
+
 /* Beware, not same as H5FD_HTTP_g */
 static const H5FD_class_t H5FD_http_g = {
 #if H5FD_CLASS_VERSION > 0
@@ -371,6 +380,14 @@ H5FD_http_open( const char *name, unsigned flags, hid_t /*UNUSED*/ fapl_id,
         H5Epush_ret(func, H5E_ERR_CLS, H5E_RESOURCE, H5E_NOSPACE, "memory allocation failed", NULL);
     }
     memcpy(file->url,name,strlen(name)+1);
+    file->buf = ncbytesnew();
+    if(http_cache_init(file) != NC_NOERR) {
+	ncbytesfree(file->buf);
+	nc_http_close(file->state);
+	H5free_memory(file->url);
+	H5free_memory(file);
+        H5Epush_ret(func, H5E_ERR_CLS, H5E_RESOURCE, H5E_NOSPACE, "memory allocation failed", NULL);
+    }
 
     return((H5FD_t*)file);
 } /* end H5FD_HTTP_OPen() */
@@ -401,6 +418,8 @@ H5FD_http_close(H5FD_t *_file)
     /* Clear the error stack */
     H5Eclear2(H5E_DEFAULT);
 
+    http_cache_free(file);
+    ncbytesfree(file->buf);
     /* Close the underlying curl handle*/
     if(file->state) nc_http_close(file->state);
     if(file->url) H5free_memory(file->url);
@@ -717,25 +736,13 @@ H5FD_http_read(H5FD_t *_file, H5FD_mem_t /*UNUSED*/ type, hid_t /*UNUSED*/ dxpl_
         size -= nbytes;
     }
 
-    {
-	NCbytes* bbuf = ncbytesnew();
-        if((ncstat = nc_http_read(file->state,addr,size,bbuf))) {
-            file->op = H5FD_HTTP_OP_UNKNOWN;
-            file->pos = HADDR_UNDEF;
-	    ncbytesfree(bbuf); bbuf = NULL;
-            H5Epush_ret(func, H5E_ERR_CLS, H5E_IO, H5E_READERROR, "HTTP byte-range read failed", -1);
-        } /* end if */
-
-	/* Check that proper number of bytes was read */
-	if(ncbyteslength(bbuf) != size) {
-	    ncbytesfree(bbuf); bbuf = NULL;
+    if((ncstat = ncpagecacheread(file->cache,(size64_t)addr,size,buf))) {
+        file->op = H5FD_HTTP_OP_UNKNOWN;
+        file->pos = HADDR_UNDEF;
+	if(ncstat == NC_EINVAL)
             H5Epush_ret(func, H5E_ERR_CLS, H5E_IO, H5E_READERROR, "HTTP byte-range read mismatch ", -1);
-	}	
-
-	/* Extract the data from buf */
-	memcpy(buf,ncbytescontents(bbuf),size);	        
-	ncbytesfree(bbuf);
-    }
+        H5Epush_ret(func, H5E_ERR_CLS, H5E_IO, H5E_READERROR, "HTTP byte-range read failed", -1);
+    } /* end if */
 
     /* Update the file position data. */
     file->op = H5FD_HTTP_OP_READ;
@@ -865,3 +872,59 @@ H5FD_http_unlock(H5FD_t *file)
  */
 #error "Do not use HDF5 private definitions"
 #endif
+
+/*-------------------------------------------------------------------------
+ * Page cache
+ *
+ * HDF5 issues many small reads (superblock, object headers, B-tree
+ * nodes), so each read goes through the shared byte-range page cache
+ * (see ncpagecache.h), whose fetch callback is http_fetch.
+ *
+ * The parameters come from the environment or from the .rc file:
+ *   NC_HTTP_PAGESIZE   / HTTP.BYTERANGE.PAGESIZE   (bytes)
+ *   NC_HTTP_CACHEPAGES / HTTP.BYTERANGE.CACHEPAGES (0 disables the cache)
+ *   NC_HTTP_READAHEAD  / HTTP.BYTERANGE.READAHEAD  (pages)
+ * The statistics are logged at close at the NOTE log level.
+ *-------------------------------------------------------------------------
+ */
+
+static int
+http_cache_init(H5FD_http_t* file)
+{
+    NCURI* uri = NULL;
+    size_t pagesize, maxpages, readahead;
+
+    ncuriparse(file->url,&uri);
+    ncpagecacheparams(uri,&pagesize,&maxpages,&readahead);
+    ncurifree(uri);
+    return ncpagecachenew((size64_t)file->eof,pagesize,maxpages,readahead,
+                          http_fetch,file,&file->cache);
+}
+
+static void
+http_cache_free(H5FD_http_t* file)
+{
+    NCpagestats stats;
+
+    if(file->cache == NULL) return;
+    ncpagecachestats(file->cache,&stats);
+    nclog(NCLOGNOTE,"http cache: url=%s hits=%llu misses=%llu readahead=%llu requests=%llu bytes=%llu",
+          file->url,stats.hits,stats.misses,stats.ahead,stats.requests,stats.bytes);
+    ncpagecachefree(file->cache);
+    file->cache = NULL;
+}
+
+/* Page cache callback: issue one byte-range request into dst */
+static int
+http_fetch(void* state, size64_t start, size_t count, void* dst)
+{
+    int stat = NC_NOERR;
+    H5FD_http_t* file = (H5FD_http_t*)state;
+
+    ncbytesclear(file->buf);
+    if((stat = nc_http_read(file->state,start,count,file->buf))) return stat;
+    /* Check that proper number of bytes was read */
+    if(ncbyteslength(file->buf) != count) return NC_EINVAL;
+    memcpy(dst,ncbytescontents(file->buf),count);
+    return NC_NOERR;
+}
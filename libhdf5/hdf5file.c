@@ -15,6 +15,7 @@
 #include "hdf5internal.h"
 #include "ncrc.h"
 #include "ncauth.h"
+#include "nclog.h"
 #include <sys/types.h>
 
 extern int NC4_extract_file_image(NC_FILE_INFO_T* h5, int abort); /* In nc4memcb.c */
@@ -287,6 +288,7 @@ nc4_close_netcdf4_file(NC_FILE_INFO_T *h5, int abort, NC_memio *memio)
 int
 nc4_close_hdf5_file(NC_FILE_INFO_T *h5, int abort,  NC_memio *memio)
 {
+    NC_HDF5_DSSTATS *stats;
     int retval;
 
     assert(h5 && h5->root_grp && h5->format_file_info);
@@ -302,6 +304,12 @@ nc4_close_hdf5_file(NC_FILE_INFO_T *h5, int abort,  NC_memio *memio)
         if ((retval = sync_netcdf4_file(h5)))
             return retval;
 
+    stats = &((NC_HDF5_FILE_INFO_T *)h5->format_file_info)->dscache.stats;
+    if (stats->maxopen)
+        nclog(NCLOGNOTE, "dataset cache: path=%s max=%zu open=%zu hits=%llu opens=%llu reopens=%llu evictions=%llu",
+              h5->controller->path, stats->maxopen, stats->nopen, stats->hits,
+              stats->opens, stats->reopens, stats->evictions);
+
     /* Close all open HDF5 objects within the file. */
     if ((retval = nc4_rec_grp_HDF5_del(h5->root_grp)))
         return retval;
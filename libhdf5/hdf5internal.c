@@ -121,7 +121,7 @@ find_var_dim_max_length(NC_GRP_INFO_T *grp, int varid, int dimid,
     hid_t datasetid = 0, spaceid = 0;
     NC_VAR_INFO_T *var;
     hsize_t *h5dimlen = NULL, *h5dimlenmax = NULL;
-    int d, dataset_ndims = 0;
+    int d, dataset_ndims = 0, transient = 0;
     int retval = NC_NOERR;
 
     *maxlen = 0;
@@ -140,9 +140,15 @@ find_var_dim_max_length(NC_GRP_INFO_T *grp, int varid, int dimid,
     }
     else
     {
-        /* Get the number of records in the dataset. */
-        if ((retval = nc4_open_var_grp2(grp, var->hdr.id, &datasetid)))
-            BAIL(retval);
+        /* Get the number of records in the dataset. A dataset closed
+         * by the dataset cache is opened just for this, so that the
+         * datasets in use by the caller are not evicted. */
+        if (!(datasetid = ((NC_HDF5_VAR_INFO_T *)var->format_var_info)->hdf_datasetid))
+        {
+            if ((retval = nc4_hdf5_open_dataset(var, &datasetid)))
+                BAIL(retval);
+            transient = 1;
+        }
         if ((spaceid = H5Dget_space(datasetid)) < 0)
             BAIL(NC_EHDFERR);
 
@@ -195,6 +201,8 @@ find_var_dim_max_length(NC_GRP_INFO_T *grp, int varid, int dimid,
 exit:
     if (spaceid > 0 && H5Sclose(spaceid) < 0)
         BAIL2(NC_EHDFERR);
+    if (transient && H5Dclose(datasetid) < 0)
+        BAIL2(NC_EHDFERR);
     if (h5dimlen) free(h5dimlen);
     if (h5dimlenmax) free(h5dimlenmax);
     return retval;
@@ -265,11 +273,15 @@ nc4_find_dim_len(NC_GRP_INFO_T *grp, int dimid, size_t **len)
     LOG((3, "%s: grp->name %s dimid %d", __func__, grp->hdr.name, dimid));
 
     /* If there are any groups, call this function recursively on
-     * them. */
+     * them. With NC_LAZYGROUPS, they are read first. */
     for (size_t i = 0; i < ncindexsize(grp->children); i++)
-        if ((retval = nc4_find_dim_len((NC_GRP_INFO_T*)ncindexith(grp->children, i),
-                                       dimid, len)))
+    {
+        NC_GRP_INFO_T *child = (NC_GRP_INFO_T*)ncindexith(grp->children, i);
+        if ((retval = nc4_read_lazy_grp(child)))
+            return retval;
+        if ((retval = nc4_find_dim_len(child, dimid, len)))
             return retval;
+    }
 
     /* For all variables in this group, find the ones that use this
      * dimension, and remember the max length. */
@@ -610,6 +622,7 @@ close_vars(NC_GRP_INFO_T *grp)
         if (hdf5_var->hdf_datasetid)
         {
             LOG((3, "closing HDF5 dataset %lld", hdf5_var->hdf_datasetid));
+            nc4_hdf5_forget_dataset(var);
             if (H5Dclose(hdf5_var->hdf_datasetid) < 0)
                 return NC_EHDFERR;
 
@@ -1000,6 +1013,29 @@ nc4_hdf5_get_chunk_cache(int ncid, size_t *sizep, size_t *nelemsp,
     return NC_NOERR;
 }
 
+/**
+ * @internal Get the counters of the open dataset cache of a file.
+ *
+ * @param ncid File ID of a NetCDF/HDF5 file.
+ * @param statsp Pointer that gets the counters.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EBADID Bad ncid.
+ */
+int
+nc4_hdf5_get_dataset_stats(int ncid, NC_HDF5_DSSTATS *statsp)
+{
+    NC_FILE_INFO_T *h5;
+    int retval;
+
+    assert(statsp);
+    if ((retval = nc4_find_nc_grp_h5(ncid, NULL, NULL, &h5)))
+        return retval;
+    assert(h5 && h5->format_file_info);
+    *statsp = ((NC_HDF5_FILE_INFO_T *)h5->format_file_info)->dscache.stats;
+    return NC_NOERR;
+}
+
 #ifdef LOGGING
 /* We will need to check against nc log level from nc4internal.c. */
 extern int nc_log_level;
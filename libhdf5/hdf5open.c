@@ -68,6 +68,8 @@ extern int NC4_open_image_file(NC_FILE_INFO_T* h5);
 /* Defined later in this file. */
 static int rec_read_metadata(NC_GRP_INFO_T *grp);
 static int read_type(NC_GRP_INFO_T *grp, hid_t hdf_typeid, char *type_name);
+static void read_lazy_subtree(NC_GRP_INFO_T *grp);
+static void read_preceding_grps(NC_GRP_INFO_T *grp);
 
 /**
  * @internal Struct to track HDF5 object info, for
@@ -243,6 +245,15 @@ get_type_info2(NC_GRP_INFO_T *h5_grp, hid_t datasetid, NC_TYPE_INFO_T **type_inf
         if((type = nc4_rec_find_hdf_type(h5, native_typeid)))
             *type_info = type;
 
+        /* With NC_LAZYGROUPS, the type may be in a group that an
+         * eager open would have read before this one. */
+        if (type == NULL && h5->read_grp)
+        {
+            read_preceding_grps(h5_grp);
+            if((type = nc4_rec_find_hdf_type(h5, native_typeid)))
+                *type_info = type;
+        }
+
         /* If we didn't find the type, then it's probably a transient
          * type, stored in the dataset itself, so let's read it now */
         if (type == NULL) {
@@ -397,6 +408,92 @@ dimscale_visitor(hid_t did, unsigned dim, hid_t dsid,
     return 0;
 }
 
+/**
+ * @internal Callback function called by H5Lvisit() for every HDF5
+ * object in the file, to find the largest dimid stored in the file.
+ *
+ * @note This function is called by HDF5 so does not return a netCDF
+ * error code.
+ *
+ * @param grpid HDF5 group ID of the root group.
+ * @param name Path of the object from the root group.
+ * @param info Info struct for the link.
+ * @param op_data Pointer to the largest dimid found so far.
+ *
+ * @return H5_ITER_CONT No error, continue iteration.
+ * @return H5_ITER_ERROR HDF5 error, stop iteration.
+ */
+static int
+max_stored_dimid(hid_t grpid, const char *name,
+#if (defined(H5Lget_info_vers) && H5Lget_info_vers == 2) || defined(HAVE_H5LITERATE2)
+                 const H5L_info2_t *info,
+#else
+                 const H5L_info_t *info,
+#endif
+                 void *op_data)
+{
+    int *maxp = (int *)op_data;
+    htri_t attr_exists;
+    hid_t attid;
+    int dimid;
+
+    if (info->type != H5L_TYPE_HARD)
+        return H5_ITER_CONT;
+    if ((attr_exists = H5Aexists_by_name(grpid, name, NC_DIMID_ATT_NAME, H5P_DEFAULT)) < 0)
+        return H5_ITER_ERROR;
+    if (!attr_exists)
+        return H5_ITER_CONT;
+    if ((attid = H5Aopen_by_name(grpid, name, NC_DIMID_ATT_NAME, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        return H5_ITER_ERROR;
+    if (H5Aread(attid, H5T_NATIVE_INT, &dimid) < 0)
+    {
+        H5Aclose(attid);
+        return H5_ITER_ERROR;
+    }
+    if (H5Aclose(attid) < 0)
+        return H5_ITER_ERROR;
+    if (dimid > *maxp)
+        *maxp = dimid;
+    return H5_ITER_CONT;
+}
+
+/**
+ * @internal With NC_LAZYGROUPS, make sure that a dimid the file does
+ * not store (for a phony dimension, or a dimscale without
+ * _Netcdf4Dimid) cannot be taken later by a dimension of a group not
+ * read yet, whose stored dimid it would be. The first time such a
+ * dimid is needed, the file is searched for the largest stored dimid,
+ * and dimids are handed out above it from then on.
+ *
+ * @param h5 Pointer to file info.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EHDFERR HDF5 returned an error.
+ */
+static int
+reserve_stored_dimids(NC_FILE_INFO_T *h5)
+{
+    NC_HDF5_FILE_INFO_T *hdf5_info = (NC_HDF5_FILE_INFO_T *)h5->format_file_info;
+    NC_HDF5_GRP_INFO_T *hdf5_grp = (NC_HDF5_GRP_INFO_T *)h5->root_grp->format_grp_info;
+    int maxid = -1;
+
+    if (!h5->read_grp || hdf5_info->stored_dimids_reserved)
+        return NC_NOERR;
+#ifdef HAVE_H5LITERATE2
+    if (H5Lvisit2(hdf5_grp->hdf_grpid, H5_INDEX_NAME, H5_ITER_INC,
+                  max_stored_dimid, &maxid) < 0)
+        return NC_EHDFERR;
+#else
+    if (H5Lvisit(hdf5_grp->hdf_grpid, H5_INDEX_NAME, H5_ITER_INC,
+                 max_stored_dimid, &maxid) < 0)
+        return NC_EHDFERR;
+#endif
+    hdf5_info->stored_dimids_reserved = NC_TRUE;
+    if (maxid >= h5->next_dimid)
+        h5->next_dimid = maxid + 1;
+    return NC_NOERR;
+}
+
 /**
  * @internal For files without any netCDF-4 dimensions defined, create
  * phony dimension to match the available datasets. Each new dimension
@@ -485,6 +582,8 @@ create_phony_dims(NC_GRP_INFO_T *grp, hid_t hdf_datasetid, NC_VAR_INFO_T *var)
         if (!match)
         {
             char phony_dim_name[NC_MAX_NAME + 1];
+            if ((retval = reserve_stored_dimids(grp->nc4_info)))
+                BAIL(retval);
             snprintf(phony_dim_name, sizeof(phony_dim_name), "phony_dim_%d", grp->nc4_info->next_dimid);
             LOG((3, "%s: creating phony dim for var %s", __func__, var->hdr.name));
 
@@ -517,7 +616,7 @@ exit:
 }
 
 /**
- * @internal Iterate through the vars in this file and make sure we've
+ * @internal Iterate through the vars in this group and make sure we've
  * got a dimid and a pointer to a dim for each dimension. This may
  * already have been done using the COORDINATES hidden attribute, in
  * which case this function will not have to do anything. This is
@@ -532,7 +631,7 @@ exit:
  * @author Ed Hartnett
  */
 static int
-rec_match_dimscales(NC_GRP_INFO_T *grp)
+match_dimscales(NC_GRP_INFO_T *grp)
 {
     NC_VAR_INFO_T *var;
     NC_DIM_INFO_T *dim;
@@ -541,11 +640,6 @@ rec_match_dimscales(NC_GRP_INFO_T *grp)
     assert(grp && grp->hdr.name);
     LOG((4, "%s: grp->hdr.name %s", __func__, grp->hdr.name));
 
-    /* Perform var dimscale match for child groups. */
-    for (size_t i = 0; i < ncindexsize(grp->children); i++)
-        if ((retval = rec_match_dimscales((NC_GRP_INFO_T *)ncindexith(grp->children, i))))
-            return retval;
-
     /* Check all the vars in this group. If they have dimscale info,
      * try and find a dimension for them. */
     for (size_t i = 0; i < ncindexsize(grp->vars); i++)
@@ -612,7 +706,7 @@ rec_match_dimscales(NC_GRP_INFO_T *grp)
                              * to find identical objects in HDF5 file. */
 #if H5_VERSION_GE(1,12,0)
                             int token_cmp;
-                            if (H5Otoken_cmp(hdf5_var->hdf_datasetid,
+                            if (H5Otoken_cmp(((NC_HDF5_GRP_INFO_T *)grp->format_grp_info)->hdf_grpid,
                                              &hdf5_var->dimscale_hdf5_objids[d].token,
                                              &hdf5_dim->hdf5_objid.token, &token_cmp) < 0)
                                 return NC_EHDFERR;
@@ -639,6 +733,8 @@ rec_match_dimscales(NC_GRP_INFO_T *grp)
             else
             {
                 /* No dimscales for this var! Invent phony dimensions. */
+                if ((retval = nc4_hdf5_use_dataset(var)))
+                    return retval;
                 if ((retval = create_phony_dims(grp, hdf5_var->hdf_datasetid, var)))
                     return retval;
             }
@@ -648,6 +744,36 @@ rec_match_dimscales(NC_GRP_INFO_T *grp)
     return retval;
 }
 
+/**
+ * @internal Match the dimscales of the vars in this group and the
+ * groups below it. A lazy group is matched when it is read.
+ *
+ * @param grp Pointer to group info struct.
+ *
+ * @returns NC_NOERR No error.
+ * @returns NC_EHDFERR HDF5 returned an error.
+ * @returns NC_ENOMEM Out of memory.
+ * @author Ed Hartnett
+ */
+static int
+rec_match_dimscales(NC_GRP_INFO_T *grp)
+{
+    NC_GRP_INFO_T *child;
+    int retval;
+
+    /* Perform var dimscale match for child groups. */
+    for (size_t i = 0; i < ncindexsize(grp->children); i++)
+    {
+        child = (NC_GRP_INFO_T *)ncindexith(grp->children, i);
+        if (child->lazy)
+            continue;
+        if ((retval = rec_match_dimscales(child)))
+            return retval;
+    }
+
+    return match_dimscales(grp);
+}
+
 /**
  * @internal Check for the attribute that indicates that netcdf
  * classic model is in use.
@@ -681,6 +807,128 @@ check_for_classic_model(NC_GRP_INFO_T *root_grp, int *is_classic)
     return NC_NOERR;
 }
 
+/**
+ * @internal Find out if the groups below the root are to be read when
+ * they are first used. This is asked for by the NC_LAZYGROUPS mode
+ * flag, the NETCDF_LAZYGROUPS environment variable or the
+ * NETCDF.LAZYGROUPS .rc key, and only honored for read-only,
+ * non-parallel opens.
+ *
+ * @param h5 Pointer to file info.
+ * @param mode The open mode flag.
+ *
+ * @return 1 if groups are read lazily, 0 otherwise.
+ */
+static int
+lazygroupstest(NC_FILE_INFO_T *h5, int mode)
+{
+    const char* value;
+    if (!h5->no_write || h5->parallel)
+        return 0;
+    if (mode & NC_LAZYGROUPS)
+        return 1;
+    if ((value = getenv("NETCDF_LAZYGROUPS")) == NULL)
+        value = NC_rclookup("NETCDF.LAZYGROUPS",NULL,NULL);
+    return (value != NULL && (strcmp(value,"1") == 0 || strcmp(value,"true") == 0));
+}
+
+/**
+ * @internal Get the cap on the no. of datasets of a file kept open
+ * at once, from NETCDF_MAXDATASETS or NETCDF.MAXDATASETS. Only files
+ * opened read-only, and not for parallel I/O, are capped.
+ *
+ * @param h5 Pointer to file info struct.
+ *
+ * @return The cap; 0 if there is none.
+ */
+static size_t
+maxdatasetstest(NC_FILE_INFO_T *h5)
+{
+    const char* value;
+    unsigned long long n = 0;
+    if (!h5->no_write || h5->parallel)
+        return 0;
+    if ((value = getenv("NETCDF_MAXDATASETS")) == NULL)
+        value = NC_rclookup("NETCDF.MAXDATASETS",NULL,NULL);
+    if (value == NULL || sscanf(value,"%llu",&n) != 1)
+        return 0;
+    return (size_t)n;
+}
+
+/**
+ * @internal Read the contents of a lazy group, when it is first
+ * used. This is the read_grp of a file opened with NC_LAZYGROUPS. The
+ * child groups are added, but are lazy themselves. If the group
+ * cannot be read, it stays lazy and the error is returned on every
+ * use.
+ *
+ * @param grp Pointer to group info struct.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EHDFERR HDF5 error.
+ * @return ::NC_ENOMEM Out of memory.
+ */
+static int
+read_lazy_grp(NC_GRP_INFO_T *grp)
+{
+    NC_HDF5_GRP_INFO_T *hdf5_grp;
+    int retval;
+
+    assert(grp && grp->parent && grp->format_grp_info);
+    hdf5_grp = (NC_HDF5_GRP_INFO_T *)grp->format_grp_info;
+    if (hdf5_grp->readstat)
+        return hdf5_grp->readstat;
+    LOG((3, "%s: grp->hdr.name %s", __func__, grp->hdr.name));
+
+    /* Cleared first, so that lookups made while reading the group
+     * do not read it again. */
+    grp->lazy = NC_FALSE;
+    if ((retval = rec_read_metadata(grp)) ||
+        (retval = match_dimscales(grp)))
+    {
+        hdf5_grp->readstat = retval;
+        grp->lazy = NC_TRUE;
+    }
+    return retval;
+}
+
+/**
+ * @internal Read a group and all groups below it, skipping the
+ * groups that cannot be read.
+ *
+ * @param grp Pointer to group info struct.
+ */
+static void
+read_lazy_subtree(NC_GRP_INFO_T *grp)
+{
+    if (nc4_read_lazy_grp(grp))
+        return;
+    for (size_t i = 0; i < ncindexsize(grp->children); i++)
+        read_lazy_subtree((NC_GRP_INFO_T *)ncindexith(grp->children, i));
+}
+
+/**
+ * @internal Read the groups that an eager open reads before this
+ * one: for the group and each of its ancestors, the earlier siblings
+ * and all groups below them.
+ *
+ * @param grp Pointer to group info struct.
+ */
+static void
+read_preceding_grps(NC_GRP_INFO_T *grp)
+{
+    for (NC_GRP_INFO_T *g = grp; g->parent; g = g->parent)
+    {
+        for (size_t i = 0; i < ncindexsize(g->parent->children); i++)
+        {
+            NC_GRP_INFO_T *sib = (NC_GRP_INFO_T *)ncindexith(g->parent->children, i);
+            if (sib == g)
+                break;
+            read_lazy_subtree(sib);
+        }
+    }
+}
+
 /**
  * @internal Open a netcdf-4 file. Things have already been kicked off
  * in ncfunc.c in nc_open, but here the netCDF-4 part of opening a
@@ -965,6 +1213,11 @@ nc4_open_file(const char *path, int mode, void* parameters, int ncid)
 	  BAIL(NC_EHDFERR);
     }
 
+    /* With NC_LAZYGROUPS, only the root group is read now. */
+    if (lazygroupstest(nc4_info, mode))
+        nc4_info->read_grp = read_lazy_grp;
+    h5->dscache.stats.maxopen = maxdatasetstest(nc4_info);
+
     /* Now read in all the metadata. Some types and dimscale
      * information may be difficult to resolve here, if, for example, a
      * dataset of user-defined type is encountered before the
@@ -1473,6 +1726,8 @@ nc4_get_var_meta(NC_VAR_INFO_T *var)
 
     /* Get pointer to the HDF5-specific var info struct. */
     hdf5_var = (NC_HDF5_VAR_INFO_T *)var->format_var_info;
+    if ((retval = nc4_hdf5_use_dataset(var)))
+        return retval;
 
     /* Get the current chunk cache settings. */
     if ((access_pid = H5Dget_access_plist(hdf5_var->hdf_datasetid)) < 0)
@@ -1552,6 +1807,7 @@ read_var(NC_GRP_INFO_T *grp, hid_t datasetid, const char *obj_name,
     NC_VAR_INFO_T *var = NULL;
     NC_HDF5_VAR_INFO_T *hdf5_var;
     int incr_id_rc = 0; /* Whether dataset ID's ref count has been incremented */
+    int added = 0;      /* Whether the dataset is counted by the dataset cache */
     char *finalname = NULL;
     int retval = NC_NOERR;
 
@@ -1576,6 +1832,10 @@ read_var(NC_GRP_INFO_T *grp, hid_t datasetid, const char *obj_name,
     if ((retval = nc4_var_list_add(grp, finalname, (int)ndims, &var)))
         BAIL(retval);
 
+    /* Keep the HDF5 name, to open the dataset again. */
+    if (strcmp(finalname, obj_name) && !(var->alt_name = strdup(obj_name)))
+        BAIL(NC_ENOMEM);
+
     /* Add storage for HDF5-specific var info. */
     if (!(var->format_var_info = calloc(1, sizeof(NC_HDF5_VAR_INFO_T))))
         BAIL(NC_ENOMEM);
@@ -1616,6 +1876,11 @@ read_var(NC_GRP_INFO_T *grp, hid_t datasetid, const char *obj_name,
     /* Transfer endianness */
     var->endianness = var->type_info->endianness; 
 
+    /* This may close the datasets of other vars. */
+    added++;
+    if ((retval = nc4_hdf5_add_dataset(var)))
+        BAIL(retval);
+
 exit:
     if (finalname)
         free(finalname);
@@ -1623,6 +1888,8 @@ exit:
     {
         /* If there was an error, decrement the dataset ref counter, and
          * delete the var info struct we just created. */
+        if (added)
+            nc4_hdf5_forget_dataset(var);
         if (incr_id_rc && H5Idec_ref(datasetid) < 0)
             BAIL2(NC_EHDFERR);
 	if(var && var->format_var_info)
@@ -1758,6 +2025,17 @@ get_netcdf_type(NC_FILE_INFO_T *h5, hid_t native_typeid,
             return NC_NOERR;
         }
 
+    /* With NC_LAZYGROUPS, the type may be in a group not read yet. */
+    if (!equal && h5->read_grp)
+    {
+        read_lazy_subtree(h5->root_grp);
+        if((type = nc4_rec_find_hdf_type(h5, native_typeid)))
+        {
+            *xtype = type->hdr.id;
+            return NC_NOERR;
+        }
+    }
+
     *xtype = NC_NAT;
     return NC_EBADTYPID;
 }
@@ -2381,6 +2659,8 @@ nc4_read_atts(NC_GRP_INFO_T *grp, NC_VAR_INFO_T *var)
 {
     att_iter_info att_info;         /* Custom iteration information */
     hid_t locid; /* HDF5 location to read atts from. */
+    herr_t status;
+    int retval = NC_NOERR;
 
     /* Check inputs. */
     assert(grp);
@@ -2389,15 +2669,29 @@ nc4_read_atts(NC_GRP_INFO_T *grp, NC_VAR_INFO_T *var)
     att_info.var = var;
     att_info.grp = grp;
 
-    /* Determine where to read from in the HDF5 file. */
-    locid = var ? ((NC_HDF5_VAR_INFO_T *)(var->format_var_info))->hdf_datasetid :
-        ((NC_HDF5_GRP_INFO_T *)(grp->format_grp_info))->hdf_grpid;
+    /* Determine where to read from in the HDF5 file. The dataset is
+     * pinned: reading the type of an att may read lazy groups, and
+     * so open other datasets. */
+    if (var)
+    {
+        if ((retval = nc4_hdf5_use_dataset(var)))
+            return retval;
+        locid = ((NC_HDF5_VAR_INFO_T *)(var->format_var_info))->hdf_datasetid;
+        nc4_hdf5_pin_dataset(var);
+    }
+    else
+        locid = ((NC_HDF5_GRP_INFO_T *)(grp->format_grp_info))->hdf_grpid;
 
     /* Now read all the attributes at this location, ignoring special
      * netCDF hidden attributes. */
-    if ((H5Aiterate2(locid, H5_INDEX_CRT_ORDER, H5_ITER_INC, NULL,
-                     att_read_callbk, &att_info)) < 0)
+    status = H5Aiterate2(locid, H5_INDEX_CRT_ORDER, H5_ITER_INC, NULL,
+                         att_read_callbk, &att_info);
+    if (var)
+        retval = nc4_hdf5_unpin_dataset(var);
+    if (status < 0)
         return NC_EATTMETA;
+    if (retval)
+        return retval;
 
     /* Remember that we have read the atts for this var or group. */
     if (var)
@@ -2444,7 +2738,7 @@ read_scale(NC_GRP_INFO_T *grp, hid_t datasetid, const char *obj_name,
     htri_t attr_exists = -1; /* Flag indicating hidden attribute exists */
     hid_t attid = -1; /* ID of hidden attribute (to store dim ID) */
     int dimscale_created = 0; /* Remember if a dimension was created (for error recovery) */
-    int initial_next_dimid = grp->nc4_info->next_dimid;/* Retain for error recovery */
+    int initial_next_dimid = grp->nc4_info->next_dimid; /* Retain for error recovery */
     size_t len = 0;
     int too_long = NC_FALSE;
     int assigned_id = -1;
@@ -2465,11 +2759,21 @@ read_scale(NC_GRP_INFO_T *grp, hid_t datasetid, const char *obj_name,
         if (H5Aread(attid, H5T_NATIVE_INT, &assigned_id) < 0)
             BAIL(NC_EHDFERR);
 
+        /* Only a broken file stores the same dimid twice; the
+         * second dim then gets a new id. */
+        if (assigned_id >= 0 && nclistget(grp->nc4_info->alldims, (size_t)assigned_id))
+            assigned_id = -1;
+
         /* Check if scale's dimid should impact the group's next dimid */
         if (assigned_id >= grp->nc4_info->next_dimid)
             grp->nc4_info->next_dimid = assigned_id + 1;
     }
 
+    /* A new id must not be the stored id of a group not read yet */
+    if (assigned_id < 0 && (retval = reserve_stored_dimids(grp->nc4_info)))
+        BAIL(retval);
+    initial_next_dimid = grp->nc4_info->next_dimid;
+
     /* Get dim size. On machines with a size_t of less than 8 bytes, it
      * is possible for a dimension to be too long. */
     if (SIZEOF_SIZE_T < 8 && scale_size > NC_MAX_UINT)
@@ -2887,6 +3191,14 @@ rec_read_metadata(NC_GRP_INFO_T *grp)
         if (!(child_grp->format_grp_info = calloc(1, sizeof(NC_HDF5_GRP_INFO_T))))
             return NC_ENOMEM;
 
+        /* With NC_LAZYGROUPS, the child group is read when it is
+         * first used. */
+        if (grp->nc4_info->read_grp)
+        {
+            child_grp->lazy = NC_TRUE;
+            continue;
+        }
+
         /* Recursively read the child group's metadata. */
         if ((retval = rec_read_metadata(child_grp)))
             BAIL(retval);
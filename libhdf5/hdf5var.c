@@ -91,7 +91,8 @@ nc4_reopen_dataset(NC_GRP_INFO_T *grp, NC_VAR_INFO_T *var)
             return NC_EHDFERR;
         if (H5Dclose(hdf5_var->hdf_datasetid) < 0)
             return NC_EHDFERR;
-        if ((hdf5_var->hdf_datasetid = H5Dopen2(grpid, var->hdr.name, access_pid)) < 0)
+        if ((hdf5_var->hdf_datasetid = H5Dopen2(grpid, var->alt_name ? var->alt_name : var->hdr.name,
+                                                access_pid)) < 0)
             return NC_EHDFERR;
         if (H5Pclose(access_pid) < 0)
             return NC_EHDFERR;
@@ -123,6 +124,7 @@ give_var_secret_name(NC_VAR_INFO_T *var, const char *name)
         return NC_EMAXNAME;
     size_t alt_name_size = (strlen(NON_COORD_PREPEND) + strlen(name) + 1) *
                            sizeof(char);
+    nullfree(var->alt_name);
     if (!(var->alt_name = malloc(alt_name_size)))
         return NC_ENOMEM;
 
@@ -1581,6 +1583,8 @@ NC4_put_vars(int ncid, int varid, const size_t *startp, const size_t *countp,
      * be switched from define mode, it happens here. */
     if ((retval = check_for_vara(&mem_nc_type, var, h5)))
         return retval;
+    if ((retval = nc4_hdf5_use_dataset(var)))
+        return retval;
     assert(hdf5_var->hdf_datasetid && (!var->ndims || (startp && countp)));
 
     /* Verify that all the variable's filters are available */
@@ -1922,6 +1926,8 @@ NC4_get_vars(int ncid, int varid, const size_t *startp, const size_t *countp,
      * mode, if needed. */
     if ((retval = check_for_vara(&mem_nc_type, var, h5)))
         return retval;
+    if ((retval = nc4_hdf5_use_dataset(var)))
+        return retval;
     assert(hdf5_var->hdf_datasetid && (!var->ndims || (startp && countp)));
 
     /* Verify that all the variable's filters are available */
@@ -1950,6 +1956,10 @@ NC4_get_vars(int ncid, int varid, const size_t *startp, const size_t *countp,
             no_read++;
     }
 
+    /* The dataset stays open, even if the length of an unlimited dim
+     * is found by reading lazy groups. */
+    nc4_hdf5_pin_dataset(var);
+
     /* Get file space of data. */
     if ((file_spaceid = H5Dget_space(hdf5_var->hdf_datasetid)) < 0)
         BAIL(NC_EHDFERR);
@@ -2239,6 +2249,8 @@ NC4_get_vars(int ncid, int varid, const size_t *startp, const size_t *countp,
     }
     
 exit:
+    if (nc4_hdf5_unpin_dataset(var))
+        BAIL2(NC_EHDFERR);
     if(fixedlengthstring && bufr) free(bufr);
     if (file_spaceid > 0)
         if (H5Sclose(file_spaceid) < 0)
@@ -2366,15 +2378,13 @@ NC4_HDF5_set_var_chunk_cache(int ncid, int varid, size_t size, size_t nelems,
     if (preemption < 0 || preemption > 1)
         return NC_EINVAL;
 
-    /* Find info for this file and group, and set pointer to each. */
-    if ((retval = nc4_find_nc_grp_h5(ncid, NULL, &grp, &h5)))
+    /* Find info for this file, group, and var. The var metadata is
+     * read first, so that it does not replace these settings, and so
+     * that the dataset is opened again with them if the dataset cache
+     * closes it. */
+    if ((retval = nc4_hdf5_find_grp_h5_var(ncid, varid, &h5, &grp, &var)))
         return retval;
-    assert(grp && h5);
-
-    /* Find the var. */
-    if (!(var = (NC_VAR_INFO_T *)ncindexith(grp->vars, (size_t)varid)))
-        return NC_ENOTVAR;
-    assert(var && var->hdr.id == varid);
+    assert(grp && h5 && var && var->hdr.id == varid);
 
     /* Set the values. */
     var->chunkcache.size = size;
@@ -2424,3 +2434,167 @@ nc_set_var_chunk_cache_ints(int ncid, int varid, int size, int nelems,
     return NC4_HDF5_set_var_chunk_cache(ncid, varid, real_size, real_nelems,
                                         real_preemption);
 }
+
+/* H5Dread_chunk() and H5Dwrite_chunk() are what
+ * HDF5_SUPPORTS_PAR_FILTERS detects. */
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+/**
+ * @internal Find the var and its dataset for raw chunk access. The
+ * chunk is identified by the coordinates of its first element.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk.
+ * @param h5p Pointer that gets the file info.
+ * @param varp Pointer that gets the var info.
+ * @param offset Gets the HDF5 form of startp.
+ *
+ * @returns ::NC_NOERR No error.
+ * @returns ::NC_EINVAL Not a chunked variable, or parallel I/O.
+ */
+static int
+chunk_raw_var(int ncid, int varid, const size_t *startp, NC_FILE_INFO_T **h5p,
+              NC_VAR_INFO_T **varp, hsize_t *offset)
+{
+    NC_VAR_INFO_T *var;
+    size_t d;
+    int retval;
+
+    if ((retval = nc4_hdf5_find_grp_h5_var(ncid, varid, h5p, NULL, &var)))
+        return retval;
+    /* Direct chunk I/O is not supported by parallel HDF5. */
+    if (var->storage != NC_CHUNKED || (*h5p)->parallel)
+        return NC_EINVAL;
+    for (d = 0; d < var->ndims; d++)
+        offset[d] = (hsize_t)startp[d];
+    *varp = var;
+    return NC_NOERR;
+}
+
+/**
+ * @internal Read one chunk as it is stored in the file, that is,
+ * after the filters have been applied.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk.
+ * @param filtermaskp If datap is not NULL, gets the mask of the
+ * filters that were skipped for this chunk. Ignored if NULL.
+ * @param sizep Gets the size of the stored chunk.
+ * @param datap If not NULL, gets a malloc'd copy of the stored
+ * chunk.
+ *
+ * @returns ::NC_NOERR No error.
+ * @returns ::NC_EEMPTY The chunk has never been written.
+ * @returns ::NC_EHDFERR HDF5 error.
+ */
+int
+NC4_HDF5_get_chunk_raw(int ncid, int varid, const size_t *startp,
+                       unsigned int *filtermaskp, size_t *sizep, void **datap)
+{
+    NC_FILE_INFO_T *h5;
+    NC_VAR_INFO_T *var;
+    hid_t datasetid;
+    hsize_t offset[NC_MAX_VAR_DIMS];
+    hsize_t nbytes = 0;
+    uint32_t mask = 0;
+    void *data = NULL;
+    int retval;
+
+    if ((retval = chunk_raw_var(ncid, varid, startp, &h5, &var, offset)))
+        return retval;
+    if ((retval = nc4_hdf5_use_dataset(var)))
+        return retval;
+    datasetid = ((NC_HDF5_VAR_INFO_T *)var->format_var_info)->hdf_datasetid;
+
+    /* A chunk that is only in the HDF5 cache has no storage yet. */
+    if (!h5->no_write && H5Dflush(datasetid) < 0)
+        return NC_EHDFERR;
+    /* A chunk that has never been written has no storage. */
+#if H5_VERSION_GE(1,10,5)
+    {
+        haddr_t addr = HADDR_UNDEF;
+        if (H5Dget_chunk_info_by_coord(datasetid, offset, NULL, &addr, &nbytes) < 0)
+            return NC_EHDFERR;
+        if (addr == HADDR_UNDEF)
+            nbytes = 0;
+    }
+#else
+    /* Older versions fail for such chunks. */
+    if (H5Dget_chunk_storage_size(datasetid, offset, &nbytes) < 0)
+        nbytes = 0;
+#endif
+    if (nbytes == 0)
+        return NC_EEMPTY;
+    if (datap)
+    {
+        if (!(data = malloc((size_t)nbytes)))
+            return NC_ENOMEM;
+#if H5_VERSION_GE(2,0,0)
+        {
+            size_t bufsize = (size_t)nbytes;
+            if (H5Dread_chunk2(datasetid, H5P_DEFAULT, offset, &mask, data, &bufsize) < 0)
+                {free(data); return NC_EHDFERR;}
+        }
+#else
+        if (H5Dread_chunk(datasetid, H5P_DEFAULT, offset, &mask, data) < 0)
+            {free(data); return NC_EHDFERR;}
+#endif
+        *datap = data;
+        if (filtermaskp) *filtermaskp = (unsigned int)mask;
+    }
+    if (sizep) *sizep = (size_t)nbytes;
+    return NC_NOERR;
+}
+
+/**
+ * @internal Write one chunk as it is to be stored in the file, that
+ * is, already filtered. The chunk must lie within the current extent
+ * of the variable.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk.
+ * @param filtermask Mask of the filters that were skipped for this
+ * chunk; 0 if the data went through all of them.
+ * @param size Size of the stored chunk.
+ * @param data The stored chunk.
+ *
+ * @returns ::NC_NOERR No error.
+ * @returns ::NC_EPERM File is read-only.
+ * @returns ::NC_EHDFERR HDF5 error.
+ */
+int
+NC4_HDF5_put_chunk_raw(int ncid, int varid, const size_t *startp,
+                       unsigned int filtermask, size_t size, const void *data)
+{
+    NC_FILE_INFO_T *h5;
+    NC_VAR_INFO_T *var;
+    hid_t datasetid;
+    hsize_t offset[NC_MAX_VAR_DIMS];
+    int retval;
+
+    if ((retval = chunk_raw_var(ncid, varid, startp, &h5, &var, offset)))
+        return retval;
+    if (h5->no_write)
+        return NC_EPERM;
+    /* As for nc_put_vara: leave define mode, so that the dataset exists. */
+    if (h5->flags & NC_INDEF)
+    {
+        if (h5->cmode & NC_CLASSIC_MODEL)
+            return NC_EINDEFINE;
+        if ((retval = nc4_enddef_netcdf4_file(h5)))
+            return retval;
+    }
+    if ((retval = nc4_hdf5_use_dataset(var)))
+        return retval;
+    datasetid = ((NC_HDF5_VAR_INFO_T *)var->format_var_info)->hdf_datasetid;
+
+    /* Any cached copy of the chunk is discarded by HDF5. */
+    if (H5Dwrite_chunk(datasetid, H5P_DEFAULT, (uint32_t)filtermask, offset, size, data) < 0)
+        return NC_EHDFERR;
+    if (!var->written_to)
+        var->written_to = NC_TRUE;
+    return NC_NOERR;
+}
+#endif /* HDF5_SUPPORTS_PAR_FILTERS */
@@ -213,21 +213,268 @@ nc4_open_var_grp2(NC_GRP_INFO_T *grp, int varid, hid_t *dataset)
     hdf5_var = (NC_HDF5_VAR_INFO_T *)var->format_var_info;
 
     /* Open this dataset if necessary. */
-    if (!hdf5_var->hdf_datasetid)
-    {
-        NC_HDF5_GRP_INFO_T *hdf5_grp;
-        hdf5_grp = (NC_HDF5_GRP_INFO_T *)grp->format_grp_info;
+    if (nc4_hdf5_use_dataset(var) || !hdf5_var->hdf_datasetid)
+        return NC_ENOTVAR;
 
-        if ((hdf5_var->hdf_datasetid = H5Dopen2(hdf5_grp->hdf_grpid,
-                                                var->hdr.name, H5P_DEFAULT)) < 0)
-            return NC_ENOTVAR;
+    *dataset = hdf5_var->hdf_datasetid;
+
+    return NC_NOERR;
+}
+
+/**
+ * @internal Open a new handle to the dataset of a var, with the chunk
+ * cache settings of the var once they are known. The caller closes
+ * the handle.
+ *
+ * @param var Pointer to var info struct.
+ * @param datasetidp Pointer that gets the HDF5 dataset ID.
+ *
+ * @returns NC_NOERR No error.
+ * @returns NC_EHDFERR HDF5 returned an error.
+ */
+int
+nc4_hdf5_open_dataset(NC_VAR_INFO_T *var, hid_t *datasetidp)
+{
+    NC_HDF5_GRP_INFO_T *hdf5_grp;
+    hid_t access_pid = H5P_DEFAULT;
+    hid_t datasetid;
+    int retval = NC_NOERR;
+
+    assert(var && var->container && var->container->format_grp_info && datasetidp);
+    hdf5_grp = (NC_HDF5_GRP_INFO_T *)var->container->format_grp_info;
+
+    if (var->meta_read)
+    {
+        if ((access_pid = H5Pcreate(H5P_DATASET_ACCESS)) < 0)
+            return NC_EHDFERR;
+        if (H5Pset_chunk_cache(access_pid, var->chunkcache.nelems,
+                               var->chunkcache.size,
+                               var->chunkcache.preemption) < 0)
+            BAIL(NC_EHDFERR);
     }
 
-    *dataset = hdf5_var->hdf_datasetid;
+    /* A var with the name of a dim it does not use has a secret
+     * HDF5 name. */
+    if ((datasetid = H5Dopen2(hdf5_grp->hdf_grpid,
+                              var->alt_name ? var->alt_name : var->hdr.name,
+                              access_pid)) < 0)
+        BAIL(NC_EHDFERR);
+    *datasetidp = datasetid;
+
+exit:
+    if (access_pid != H5P_DEFAULT && H5Pclose(access_pid) < 0)
+        BAIL2(NC_EHDFERR);
+    return retval;
+}
+
+/* The dataset cache of the file of a var */
+#define DSCACHE(var) \
+    (&((NC_HDF5_FILE_INFO_T *)(var)->container->nc4_info->format_file_info)->dscache)
+#define DSVAR(var) ((NC_HDF5_VAR_INFO_T *)(var)->format_var_info)
+
+/* Is var in the LRU list? */
+static int
+dscache_listed(struct NC_HDF5_DSCACHE *cache, NC_VAR_INFO_T *var)
+{
+    return cache->mru == var || DSVAR(var)->dsprev != NULL;
+}
+
+static void
+dscache_unlink(struct NC_HDF5_DSCACHE *cache, NC_VAR_INFO_T *var)
+{
+    NC_HDF5_VAR_INFO_T *hdf5_var = DSVAR(var);
+
+    if (hdf5_var->dsprev)
+        DSVAR(hdf5_var->dsprev)->dsnext = hdf5_var->dsnext;
+    else
+        cache->mru = hdf5_var->dsnext;
+    if (hdf5_var->dsnext)
+        DSVAR(hdf5_var->dsnext)->dsprev = hdf5_var->dsprev;
+    else
+        cache->lru = hdf5_var->dsprev;
+    hdf5_var->dsprev = hdf5_var->dsnext = NULL;
+}
 
+static void
+dscache_push(struct NC_HDF5_DSCACHE *cache, NC_VAR_INFO_T *var)
+{
+    NC_HDF5_VAR_INFO_T *hdf5_var = DSVAR(var);
+
+    hdf5_var->dsprev = NULL;
+    hdf5_var->dsnext = cache->mru;
+    if (cache->mru)
+        DSVAR(cache->mru)->dsprev = var;
+    else
+        cache->lru = var;
+    cache->mru = var;
+}
+
+/* Close the least recently used datasets that are not pinned, until
+ * no more than the cap are open. */
+static int
+dscache_evict(struct NC_HDF5_DSCACHE *cache)
+{
+    NC_VAR_INFO_T *var, *prev;
+
+    for (var = cache->lru; var && cache->stats.nopen > cache->stats.maxopen; var = prev)
+    {
+        NC_HDF5_VAR_INFO_T *hdf5_var = DSVAR(var);
+
+        prev = hdf5_var->dsprev;
+        if (hdf5_var->dspins > 0)
+            continue;
+        LOG((4, "%s: closing dataset of var %s", __func__, var->hdr.name));
+        dscache_unlink(cache, var);
+        cache->stats.nopen--;
+        cache->stats.evictions++;
+        hdf5_var->dsevicted = NC_TRUE;
+        if (H5Dclose(hdf5_var->hdf_datasetid) < 0)
+            return NC_EHDFERR;
+        hdf5_var->hdf_datasetid = 0;
+    }
     return NC_NOERR;
 }
 
+/* Count the newly opened dataset of var, evicting others if needed */
+static int
+dscache_insert(struct NC_HDF5_DSCACHE *cache, NC_VAR_INFO_T *var)
+{
+    cache->stats.opens++;
+    cache->stats.nopen++;
+    if (!cache->stats.maxopen)
+        return NC_NOERR;
+    dscache_push(cache, var);
+    return dscache_evict(cache);
+}
+
+/**
+ * @internal Make sure the dataset of a var is open, before its
+ * hdf_datasetid is used. In a file opened read-only, the no. of open
+ * datasets may be capped (see NETCDF_MAXDATASETS): the dataset of
+ * the var becomes the most recently used, and the least recently used
+ * datasets are closed as needed. They are opened again, with the same
+ * chunk cache settings, when next used. A caller that keeps using the
+ * dataset while other vars are used pins it with
+ * nc4_hdf5_pin_dataset().
+ *
+ * @param var Pointer to var info struct.
+ *
+ * @returns NC_NOERR No error.
+ * @returns NC_EHDFERR HDF5 returned an error.
+ */
+int
+nc4_hdf5_use_dataset(NC_VAR_INFO_T *var)
+{
+    struct NC_HDF5_DSCACHE *cache;
+    NC_HDF5_VAR_INFO_T *hdf5_var;
+    int retval;
+
+    assert(var && var->format_var_info && var->container);
+    cache = DSCACHE(var);
+    hdf5_var = DSVAR(var);
+
+    /* There is no dataset before the var is created. */
+    if (!var->created)
+        return NC_NOERR;
+
+    if (hdf5_var->hdf_datasetid)
+    {
+        cache->stats.hits++;
+        if (cache->mru != var && dscache_listed(cache, var))
+        {
+            dscache_unlink(cache, var);
+            dscache_push(cache, var);
+        }
+        return NC_NOERR;
+    }
+
+    if ((retval = nc4_hdf5_open_dataset(var, &hdf5_var->hdf_datasetid)))
+        return retval;
+    if (hdf5_var->dsevicted)
+    {
+        cache->stats.reopens++;
+        hdf5_var->dsevicted = NC_FALSE;
+    }
+    return dscache_insert(cache, var);
+}
+
+/**
+ * @internal Count the dataset of a var that was opened while reading
+ * the metadata of the file; it may evict the datasets of other vars.
+ *
+ * @param var Pointer to var info struct.
+ *
+ * @returns NC_NOERR No error.
+ * @returns NC_EHDFERR HDF5 returned an error.
+ */
+int
+nc4_hdf5_add_dataset(NC_VAR_INFO_T *var)
+{
+    assert(var && var->format_var_info && DSVAR(var)->hdf_datasetid);
+    return dscache_insert(DSCACHE(var), var);
+}
+
+/**
+ * @internal Keep the dataset of a var open until it is unpinned, even
+ * if the datasets of other vars are used meanwhile.
+ *
+ * @param var Pointer to var info struct.
+ */
+void
+nc4_hdf5_pin_dataset(NC_VAR_INFO_T *var)
+{
+    assert(var && var->format_var_info && DSVAR(var)->hdf_datasetid);
+    DSVAR(var)->dspins++;
+}
+
+/**
+ * @internal Undo nc4_hdf5_pin_dataset(). The dataset of the var, in
+ * use until now, becomes the most recently used, and the datasets
+ * kept open over the cap while it was pinned are closed.
+ *
+ * @param var Pointer to var info struct.
+ *
+ * @returns NC_NOERR No error.
+ * @returns NC_EHDFERR HDF5 returned an error.
+ */
+int
+nc4_hdf5_unpin_dataset(NC_VAR_INFO_T *var)
+{
+    struct NC_HDF5_DSCACHE *cache;
+
+    assert(var && var->format_var_info && DSVAR(var)->dspins > 0);
+    cache = DSCACHE(var);
+    if (--DSVAR(var)->dspins > 0 || !cache->stats.maxopen)
+        return NC_NOERR;
+    if (cache->mru != var && dscache_listed(cache, var))
+    {
+        dscache_unlink(cache, var);
+        dscache_push(cache, var);
+    }
+    return dscache_evict(cache);
+}
+
+/**
+ * @internal Stop counting the dataset of a var, before its owner
+ * closes it.
+ *
+ * @param var Pointer to var info struct.
+ */
+void
+nc4_hdf5_forget_dataset(NC_VAR_INFO_T *var)
+{
+    struct NC_HDF5_DSCACHE *cache;
+
+    assert(var && var->format_var_info);
+    if (!DSVAR(var)->hdf_datasetid)
+        return;
+    cache = DSCACHE(var);
+    if (dscache_listed(cache, var))
+        dscache_unlink(cache, var);
+    if (cache->stats.nopen > 0)
+        cache->stats.nopen--;
+}
+
 /**
  * @internal Given a netcdf type, return appropriate HDF typeid.  (All
  * hdf_typeid's returned from this routine must be H5Tclosed by the
@@ -1687,6 +1934,7 @@ write_var(NC_VAR_INFO_T *var, NC_GRP_INFO_T *grp, nc_bool_t write_dimid)
     if (replace_existing_var)
     {
         /* Free the HDF5 dataset id. */
+        nc4_hdf5_forget_dataset(var);
         if (hdf5_var->hdf_datasetid && H5Dclose(hdf5_var->hdf_datasetid) < 0)
             return NC_EHDFERR;
         hdf5_var->hdf_datasetid = 0;
@@ -78,7 +78,8 @@ nc_initialize()
 {
     int stat = NC_NOERR;
 
-    if(NC_initialized) return NC_NOERR;
+    NCLOCK();
+    if(NC_initialized) goto done;
     NC_initialized = 1;
     NC_finalized = 0;
 
@@ -119,6 +120,7 @@ nc_initialize()
 #endif
 
 done:
+    NCUNLOCK();
     return stat;
 }
 
@@ -137,6 +139,7 @@ nc_finalize(void)
     int stat = NC_NOERR;
     int failed = stat;
 
+    NCLOCK();
     if(NC_finalized) goto done;
     NC_initialized = 0;
     NC_finalized = 1;
@@ -180,6 +183,7 @@ nc_finalize(void)
     if((stat = NCDISPATCH_finalize())) failed = stat;
 
 done:
+    NCUNLOCK();
     if(failed) fprintf(stderr,"nc_finalize failed: %d\n",failed);
     return failed;
 }
@@ -5,6 +5,7 @@
 
 #include "zincludes.h"
 #include <stddef.h>
+#include <errno.h>
 
 /**************************************************/
 /* Forwards */
@@ -303,6 +304,22 @@ applycontrols(NCZ_FILE_INFO_T* zinfo)
     if((value = controllookup(zinfo->controllist,"show")) != NULL) {
 	if(strcasecmp(value,"fetch")==0)
 	    zinfo->controls.flags |= FLAG_SHOWFETCH;
+	else if(strcasecmp(value,"cache")==0)
+	    zinfo->controls.flags |= FLAG_SHOWCACHE;
+    }
+    /* One chunk cache budget for all variables? */
+    {
+	unsigned long long sharedsize = NC_getglobalstate()->zarr.sharedcache;
+	if((value = controllookup(zinfo->controllist,"sharedcache")) != NULL) {
+	    char* endp = NULL;
+	    errno = 0;
+	    sharedsize = strtoull(value,&endp,10);
+	    if(endp == value || *endp != '\0' || errno == ERANGE || strchr(value,'-') != NULL)
+	        {stat = NC_EINVAL; goto done;}
+	}
+	if(sharedsize > 0) {
+	    if((stat = NCZ_create_shared_cache((size64_t)sharedsize,&zinfo->sharedcache))) goto done;
+	}
     }
 done:
     nclistfreeall(modelist);
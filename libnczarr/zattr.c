@@ -55,6 +55,11 @@ ncz_getattlist(NC_GRP_INFO_T *grp, int varid, NC_VAR_INFO_T **varp, NCindex **at
             return NC_ENOTVAR;
         assert(var->hdr.id == varid);
 
+        /* Do we need to read var metadata? */
+        if (!var->meta_read && var->created)
+            if ((retval = ncz_get_var_meta(file, var)))
+                return retval;
+
         /* Do we need to read the atts? */
         if (!var->atts_read)
             if ((retval = ncz_read_atts(file, (NC_OBJ*)var)))
@@ -11,6 +11,13 @@
 */
 
 struct NCxcache;
+struct NCtaskgroup;
+struct NCexhashmap;
+struct NCZChunkCache;
+struct NCZMAPIO;
+
+/* The shard store of a sharded variable; see zshard.c */
+typedef struct NCZShards NCZShards;
 
 /* Note in the following: the term "real"
    refers to the unfiltered/uncompressed data
@@ -23,9 +30,9 @@ struct NCxcache;
 */
 
 typedef struct NCZCacheEntry {
-    struct List {void* next; void* prev; void* unused;} list;
+    struct List {void* next; void* prev; void* unused;} list; /* LRU links; must be first (see ncxcache.h) */
     int modified;
-    size64_t indices[NC_MAX_VAR_DIMS];
+    size64_t* indices; /* [cache->ndims]; allocated with the entry */
     struct ChunkKey {
 	char* varkey; /* key to the containing variable */
         char* chunkkey; /* name of the chunk */
@@ -35,8 +42,23 @@ typedef struct NCZCacheEntry {
     int isfixedstring; /* 1 => data contains the fixed strings, 0 => data contains pointers to strings */
     size64_t size; /* |data| */
     void* data; /* contains either filtered or real data */
+    struct SharedList { /* links in the file-wide LRU list; unused if there is no shared cache */
+	struct NCZCacheEntry* next; /* towards least recently used */
+	struct NCZCacheEntry* prev;
+    } shared;
+    struct NCZChunkCache* cache; /* containing cache */
 } NCZCacheEntry;
 
+/* A single byte budget shared by the chunk caches
+   of all the variables of a file. Eviction picks the least
+   recently used chunk of any variable. */
+typedef struct NCZSharedCache {
+    size64_t size; /* budget for all variables */
+    size64_t used;
+    NCZCacheEntry* mru; /* head of the file-wide LRU list */
+    NCZCacheEntry* lru; /* tail of the file-wide LRU list */
+} NCZSharedCache;
+
 typedef struct NCZChunkCache {
     int valid; /* 0 => following fields need to be re-calculated */
     NC_VAR_INFO_T* var; /* backlink */
@@ -46,9 +68,20 @@ typedef struct NCZChunkCache {
     void* fillchunk; /* enough fillvalues to fill a real chunk */
     struct ChunkCache params;
     size_t used; /* How much total space is being used */
-    NClist* mru; /* NClist<NCZCacheEntry> all cache entries in mru order */
-    struct NCxcache* xcache;
+    struct NCxcache* xcache; /* hash index plus LRU list of all cache entries */
     char dimension_separator;
+    NCZSharedCache* shared; /* NULL => constrained by params alone */
+    struct CacheStats {
+	size64_t hits; size64_t misses; size64_t evictions;
+	size64_t maxwrites; /* most evicted chunks written in the background at once */
+    } stats;
+    struct WriteBehind { /* evicted modified chunks being written by the thread pool */
+	struct NCtaskgroup* group; /* NULL => none submitted yet */
+	size64_t pending; /* bytes submitted since the last drain */
+	size64_t count; /* chunks submitted since the last drain */
+	struct NCexhashmap* keys; /* hashkeys of the chunks being written */
+    } writebehind;
+    NCZShards* shards; /* NULL => each chunk is its own object */
 } NCZChunkCache;
 
 /**************************************************/
@@ -56,10 +89,13 @@ typedef struct NCZChunkCache {
 #define FILTERED(cache) (nclistlength((NClist*)(cache)->var->filters))
 
 extern int NCZ_set_var_chunk_cache(int ncid, int varid, size_t size, size_t nelems, float preemption);
+extern int NCZ_get_var_chunk_cache(int ncid, int varid, size_t *sizep, size_t *nelemsp, float *preemptionp);
 extern int NCZ_adjust_var_cache(NC_VAR_INFO_T *var);
 extern int NCZ_create_chunk_cache(NC_VAR_INFO_T* var, size64_t, char dimsep, NCZChunkCache** cachep);
 extern void NCZ_free_chunk_cache(NCZChunkCache* cache);
 extern int NCZ_read_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void** datap);
+extern size_t NCZ_prefetch_limit(NCZChunkCache* cache);
+extern int NCZ_prefetch_cache_chunks(NCZChunkCache* cache, size_t nchunks, const size64_t* indices);
 extern int NCZ_flush_chunk_cache(NCZChunkCache* cache);
 extern size64_t NCZ_cache_entrysize(NCZChunkCache* cache);
 extern NCZCacheEntry* NCZ_cache_entry(NCZChunkCache* cache, const size64_t* indices);
@@ -68,5 +104,15 @@ extern int NCZ_buildchunkpath(NCZChunkCache* cache, const size64_t* chunkindices
 extern int NCZ_ensure_fill_chunk(NCZChunkCache* cache);
 extern int NCZ_reclaim_fill_chunk(NCZChunkCache* cache);
 extern int NCZ_chunk_cache_modify(NCZChunkCache* cache, const size64_t* indices);
+extern int NCZ_create_shared_cache(size64_t size, NCZSharedCache** sharedp);
+extern void NCZ_free_shared_cache(NCZSharedCache* shared);
+
+/* zshard.c */
+extern int NCZ_shard_create(NCZChunkCache* cache, const size64_t* shardchunks, NCZShards** shardsp);
+extern void NCZ_shard_free(NCZShards* shards);
+extern int NCZ_shard_read(NCZShards* shards, const size64_t* indices, size64_t* sizep, void** datap);
+extern int NCZ_shard_readv(NCZShards* shards, size_t n, const size64_t* indices, struct NCZMAPIO* ios);
+extern int NCZ_shard_write(NCZShards* shards, const size64_t* indices, size64_t size, const void* data);
+extern int NCZ_shard_flush(NCZShards* shards);
 
 #endif /*ZCACHE_H*/
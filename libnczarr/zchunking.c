@@ -105,7 +105,9 @@ NCZ_compute_projections(struct Common* common,  int r, size64_t chunkindex, cons
 	if(prev == NULL) {stat = NC_ENCZARR; goto done;}
     }
 
+    NCLOCK(); /* pcounter is shared by all files */
     projection->id = ++pcounter;
+    NCUNLOCK();
     projection->chunkindex = chunkindex;
 
     projection->offset = chunklen * chunkindex; /* with respect to dimension (WRD) */
@@ -47,6 +47,11 @@ ncz_close_file(NC_FILE_INFO_T* file, int abort)
 
     zinfo = file->format_file_info;
 
+    /* All the variable caches are gone; release their shared cache
+       before the map, whose close may fail */
+    NCZ_free_shared_cache(zinfo->sharedcache);
+    zinfo->sharedcache = NULL;
+
     if((stat = nczmap_close(zinfo->map,(abort && zinfo->creating)?1:0)))
 	goto done;
     nclistfreeall(zinfo->controllist);
@@ -176,6 +181,7 @@ NCZ_zclose_var1(NC_VAR_INFO_T* var)
     /* reclaim dispatch info */
     zvar = var->format_var_info;;
     if(zvar->cache) NCZ_free_chunk_cache(zvar->cache);
+    nullfree(zvar->shardchunks);
     /* reclaim xarray */
     if(zvar->xarray) nclistfreeall(zvar->xarray);
     nullfree(zvar->zarray.prefix);
@@ -259,6 +259,10 @@ NCZ_rename_dim(int ncid, int dimid, const char *name)
     if (ncindexlookup(grp->dim, norm_name))
         return NC_ENAMEINUSE;
 
+    /* The vars that use the dim refer to it by name */
+    if ((stat = ncz_read_grp_var_meta(h5, grp)))
+        return stat;
+
     /* Give the dimension its new name in metadata. UTF8 normalization
      * has been done. */
     assert(dim->hdr.name);
@@ -102,7 +102,7 @@ static const NC_Dispatch NCZ_dispatcher = {
     NCZ_def_var_endian,
     NCZ_def_var_filter,
     NCZ_set_var_chunk_cache,
-    NC4_get_var_chunk_cache,
+    NCZ_get_var_chunk_cache,
     NCZ_inq_var_filter_ids,
     NCZ_inq_var_filter_info,
     NCZ_def_var_quantize,
@@ -177,6 +177,14 @@ EXTERNL int NCZ_inq_filter_avail(int ncid, unsigned id);
 EXTERNL int NCZ_def_var_quantize(int ncid, int varid, int quantize_mode, int nsd);
 EXTERNL int NCZ_inq_var_quantize(int ncid, int varid, int *quantize_modep, int *nsdp);
 
+/* Raw chunk access; see nc_get_chunk_raw() */
+EXTERNL int NCZ_get_chunk_raw(int ncid, int varid, const size_t* startp, size_t* sizep, void** datap);
+EXTERNL int NCZ_put_chunk_raw(int ncid, int varid, const size_t* startp, size_t size, const void* data);
+
+/* Sharding; see nc_def_var_shard() */
+EXTERNL int NCZ_def_var_shard(int ncid, int varid, const size_t* shardp);
+EXTERNL int NCZ_inq_var_shard(int ncid, int varid, int* shardedp, size_t* shardp);
+
 /**************************************************/
 /* Following functions wrap libsrc4 */
 EXTERNL int NCZ_inq_type(int ncid, nc_type xtype, char *name, size_t *size);
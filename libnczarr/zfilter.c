@@ -689,16 +689,15 @@ NCZ_filter_finalize(void)
 done:
     return ZUNTRACE(stat);
 }
+/* Make sure all the filters in a chain are loaded && setup.
+   Once this succeeds, applying the chain does not modify it,
+   so it can then be applied by several threads at once. */
 int
-NCZ_applyfilterchain(const NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, NClist* chain, size_t inlen, void* indata, size_t* outlenp, void** outdatap, int encode)
+NCZ_ensure_filterchain(NC_VAR_INFO_T* var, NClist* chain)
 {
     size_t i;
     int stat = NC_NOERR;
-    void* lastbuffer = NULL; /* if not null, then last allocated buffer */
-    
-    ZTRACE(6,"|chain|=%u inlen=%u indata=%p encode=%d", (unsigned)nclistlength(chain), (unsigned)inlen, indata, encode);
 
-    /* Make sure all the filters are loaded && setup */
     for(i=0;i<nclistlength(chain);i++) {
 	struct NCZ_Filter* f = (struct NCZ_Filter*)nclistget(chain,i);
 	assert(f != NULL);
@@ -708,6 +707,21 @@ NCZ_applyfilterchain(const NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, NClist* cha
 	    if((stat = ensure_working(var,f))) goto done;
 	}
     }
+done:
+    return stat;
+}
+
+int
+NCZ_applyfilterchain(const NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, NClist* chain, size_t inlen, void* indata, size_t* outlenp, void** outdatap, int encode)
+{
+    size_t i;
+    int stat = NC_NOERR;
+    void* lastbuffer = NULL; /* if not null, then last allocated buffer */
+    
+    ZTRACE(6,"|chain|=%u inlen=%u indata=%p encode=%d", (unsigned)nclistlength(chain), (unsigned)inlen, indata, encode);
+
+    /* Make sure all the filters are loaded && setup */
+    if((stat = NCZ_ensure_filterchain(var,chain))) goto done;
 
     {
 	struct NCZ_Filter* f = NULL;
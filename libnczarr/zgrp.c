@@ -125,6 +125,10 @@ NCZ_rename_grp(int grpid, const char *name)
     if ((stat = nc4_check_dup_name(grp->parent, norm_name)))
         return stat;
 
+    /* The vars of the group are rewritten under the new name */
+    if ((stat = ncz_read_grp_var_meta(h5, grp)))
+        return stat;
+
     /* If it's not in define mode, switch to define mode. */
     if (!(h5->flags & NC_INDEF))
         if ((stat = NCZ_redef(grpid)))
@@ -17,6 +17,7 @@
 
 #include "zincludes.h"
 #include "zfilter.h"
+#include "ncthreadpool.h"
 
 /* Forward */
 
@@ -68,6 +69,13 @@ NCZ_initialize_internal(void)
 	    if(dimsep != NULL && strlen(dimsep) == 1 && islegaldimsep(dimsep[0]))
 		ngs->zarr.dimension_separator = dimsep[0];
         }    
+	/* Concurrent chunk read parameters */
+	ngs->zarr.threads = NC_rclookupsize(NULL,"NCZARR_THREADS","ZARR.THREADS",DFALT_ZARR_THREADS);
+	ngs->zarr.maxinflight = NC_rclookupsize(NULL,"NCZARR_MAXINFLIGHT","ZARR.MAXINFLIGHT",DFALT_ZARR_MAXINFLIGHT);
+	/* File-wide chunk cache */
+	ngs->zarr.sharedcache = NC_rclookupsize(NULL,"NCZARR_SHAREDCACHE","ZARR.SHAREDCACHE",DFALT_ZARR_SHAREDCACHE);
+	/* Metadata read-ahead at open */
+	ngs->zarr.metaprefetch = NC_rclookupsize(NULL,"NCZARR_METAPREFETCH","ZARR.METAPREFETCH",DFALT_ZARR_METAPREFETCH);
     }
 
     return stat;
@@ -80,8 +88,14 @@ NCZ_initialize_internal(void)
 int
 NCZ_finalize_internal(void)
 {
+    NCglobalstate* ngs = NC_getglobalstate();
+
     /* Reclaim global resources */
     ncz_initialized = 0;
+    if(ngs != NULL) {
+        ncthreadpoolfree(ngs->zarr.threadpool);
+        ngs->zarr.threadpool = NULL;
+    }
 #ifdef NETCDF_ENABLE_NCZARR_FILTERS
     NCZ_filter_finalize();
 #endif
@@ -91,6 +105,32 @@ NCZ_finalize_internal(void)
     return NC_NOERR;
 }
 
+/**
+ * @internal Return the worker pool used for concurrent chunk reads,
+ * creating it on first use.
+ *
+ * @return the pool, or NULL if chunks should be read serially.
+ */
+NCthreadpool*
+NCZ_threadpool(void)
+{
+    NCglobalstate* ngs = NC_getglobalstate();
+
+    if(ngs == NULL || ngs->zarr.threads == 0) return NULL;
+    if(ngs->zarr.threadpool == NULL) {
+        /* Files using separate locks may get here at the same time */
+        NCLOCK();
+        if(ngs->zarr.threadpool == NULL
+           && ncthreadpoolnew(ngs->zarr.threads,&ngs->zarr.threadpool))
+            ngs->zarr.threadpool = NULL;
+        NCUNLOCK();
+        if(ngs->zarr.threadpool == NULL) return NULL;
+    }
+    /* A pool without workers (e.g. built without thread support) gains nothing */
+    if(ncthreadpoolsize(ngs->zarr.threadpool) == 0) return NULL;
+    return ngs->zarr.threadpool;
+}
+
 /**
  * @internal Given a varid, return the maximum length of a dimension
  * using dimid.
@@ -532,6 +572,34 @@ ncz_find_grp_file_var(int ncid, int varid, NC_FILE_INFO_T **h5,
     return NC_NOERR;
 }
 
+/**
+ * @internal Do the lazy var metadata read for every var in a group
+ * and its subgroups. Needed before a change, such as a rename, that
+ * must be written into the metadata of vars which were never used.
+ *
+ * @param file Pointer to file info struct.
+ * @param grp Pointer to group info struct.
+ *
+ * @return ::NC_NOERR No error.
+ */
+int
+ncz_read_grp_var_meta(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp)
+{
+    size_t i;
+    int retval;
+
+    for (i = 0; i < ncindexsize(grp->vars); i++) {
+        NC_VAR_INFO_T* var = (NC_VAR_INFO_T*)ncindexith(grp->vars, i);
+        if (!var->meta_read && var->created)
+            if ((retval = ncz_get_var_meta(file, var)))
+                return retval;
+    }
+    for (i = 0; i < ncindexsize(grp->children); i++)
+        if ((retval = ncz_read_grp_var_meta(file, (NC_GRP_INFO_T*)ncindexith(grp->children, i))))
+            return retval;
+    return NC_NOERR;
+}
+
 /**
  * @internal Given an ncid, varid, and attribute name, return
  * normalized name and (optionally) pointers to the file, group,
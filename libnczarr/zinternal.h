@@ -87,6 +87,14 @@ Inserted into any .zattrs
 #define LEGAL_DIM_SEPARATORS "./"
 #define DFALT_DIM_SEPARATOR '.'
 
+/* Defaults for concurrent chunk reads; overridden by the
+   NCZARR_THREADS/NCZARR_MAXINFLIGHT environment variables
+   or the ZARR.THREADS/ZARR.MAXINFLIGHT .ncrc keys */
+#define DFALT_ZARR_THREADS 0
+#define DFALT_ZARR_MAXINFLIGHT ((size_t)(64*1024*1024))
+#define DFALT_ZARR_SHAREDCACHE 0
+#define DFALT_ZARR_METAPREFETCH 256
+
 #define islegaldimsep(c) ((c) != '\0' && strchr(LEGAL_DIM_SEPARATORS,(c)) != NULL)
 
 /* Default max string length for fixed length strings */
@@ -108,6 +116,7 @@ struct NCjson;
 struct NCauth;
 struct NCZMAP;
 struct NCZChunkCache;
+struct NCZSharedCache;
 
 /**************************************************/
 /* Define annotation data for NCZ objects */
@@ -142,9 +151,11 @@ typedef struct NCZ_FILE_INFO {
 #		define FLAG_XARRAYDIMS  8
 #		define FLAG_NCZARR_KEY  16 /* _nczarr_xxx keys are stored in object and not in _nczarr_attrs */
 #		define FLAG_CONSOLIDATED 32
+#		define FLAG_SHOWCACHE   64 /* report chunk cache statistics at close */
 	NCZM_IMPL mapimpl;
     } controls;
     int default_maxstrlen; /* default max str size for variables of type string */
+    struct NCZSharedCache* sharedcache; /* NULL => each variable has its own chunk cache budget */
 } NCZ_FILE_INFO_T;
 
 /* This is a struct to handle the dim metadata. */
@@ -181,6 +192,8 @@ typedef struct NCZ_VAR_INFO {
     char dimension_separator; /* '.' | '/' */
     NClist* incompletefilters;
     int maxstrlen; /* max length of strings for this variable */
+    size64_t* shardchunks; /* [ndims] chunks per shard along each dimension; NULL => not sharded */
+    int metastat; /* error from reading the metadata lazily; returned on every later use */
     /* Read .zarray and .zattrs once */
     struct ZARROBJ zarray;
     struct ZARROBJ zattrs;
@@ -224,6 +237,7 @@ int NCZ_initialize(void);
 int NCZ_finalize(void);
 int NCZ_initialize_internal(void);
 int NCZ_finalize_internal(void);
+struct NCthreadpool* NCZ_threadpool(void);
 int NCZ_ensure_fill_value(NC_VAR_INFO_T* var);
 int ncz_find_grp_var_att(int ncid, int varid, const char *name, int attnum,
                               int use_name, char *norm_name, NC_FILE_INFO_T** file,
@@ -257,6 +271,8 @@ int NCZ_ensure_quantizer(int ncid, NC_VAR_INFO_T* var);
 /* Find var, doing lazy var metadata read if needed. */
 int ncz_find_grp_file_var(int ncid, int varid, NC_FILE_INFO_T** file,
                              NC_GRP_INFO_T** grp, NC_VAR_INFO_T** var);
+/* Do the lazy var metadata read for all vars in a group tree. */
+int ncz_read_grp_var_meta(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp);
 
 #endif /* ZINTERNAL_H */
 
@@ -8,6 +8,7 @@
 #include <stddef.h>
 #include "ncpathmgr.h"
 #include "ncutil.h"
+#include "ncthreadpool.h"
 
 /**************************************************/
 /* Import the current implementations */
@@ -170,12 +171,125 @@ nczmap_read(NCZMAP* map, const char* key, size64_t start, size64_t count, void*
     return map->api->read(map, key, start, count, content);
 }
 
+int
+nczmap_readall(NCZMAP* map, const char* key, size64_t* sizep, void** contentp)
+{
+    int stat = NC_NOERR;
+    size64_t size = 0;
+    void* content = NULL;
+
+    if(map->api->readall != NULL)
+        return map->api->readall(map, key, sizep, contentp);
+    /* Fall back to len + read */
+    if((stat = map->api->len(map, key, &size))) goto done;
+    if((content = malloc(size > 0 ? size : 1)) == NULL) {stat = NC_ENOMEM; goto done;}
+    if(size > 0 && (stat = map->api->read(map, key, 0, size, content))) goto done;
+    if(sizep) *sizep = size;
+    if(contentp) {*contentp = content; content = NULL;}
+done:
+    nullfree(content);
+    return stat;
+}
+
 int
 nczmap_write(NCZMAP* map, const char* key, size64_t count, const void* content)
 {
     return map->api->write(map, key, count, content);
 }
 
+int
+nczmap_readv(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    if(n == 0) return NC_NOERR;
+    if(map->api->readv != NULL)
+        return map->api->readv(map, n, ios);
+    return nczm_iov(map, n, ios, nczm_readio, 0);
+}
+
+int
+nczmap_writev(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    if(n == 0) return NC_NOERR;
+    if(map->api->writev != NULL)
+        return map->api->writev(map, n, ios);
+    return nczm_iov(map, n, ios, nczm_writeio, 0);
+}
+
+/**************************************************/
+/* Support for implementing readv/writev */
+
+/* Perform one element of a readv using the single object operations */
+int
+nczm_readio(NCZMAP* map, NCZMAPIO* io)
+{
+    if(io->content == NULL)
+        io->stat = nczmap_readall(map, io->key, &io->count, &io->content);
+    else
+        io->stat = nczmap_read(map, io->key, io->start, io->count, io->content);
+    return NC_NOERR;
+}
+
+/* Perform one element of a writev using the single object operations */
+int
+nczm_writeio(NCZMAP* map, NCZMAPIO* io)
+{
+    io->stat = nczmap_write(map, io->key, io->count, io->content);
+    return NC_NOERR;
+}
+
+struct IOTask {
+    NCZMAP* map;
+    NCZMAPIO* io;
+    int (*fcn)(NCZMAP*, NCZMAPIO*);
+};
+
+static int
+io_task(void* arg)
+{
+    struct IOTask* task = (struct IOTask*)arg;
+    return task->fcn(task->map, task->io);
+}
+
+/**
+Apply fcn to each element of a batch; if concurrent is set and the
+NCZarr thread pool is enabled, the elements are performed on the pool.
+fcn must leave the outcome of the element in io->stat; its own return
+value is reserved for failures of the batch as a whole.
+*/
+int
+nczm_iov(NCZMAP* map, size_t n, NCZMAPIO* ios, int (*fcn)(NCZMAP*, NCZMAPIO*), int concurrent)
+{
+    int stat = NC_NOERR;
+    size_t i;
+    NCthreadpool* pool = NULL;
+    NCtaskgroup* group = NULL;
+    struct IOTask* tasks = NULL;
+
+    if(concurrent && n > 1) pool = NCZ_threadpool();
+    if(pool == NULL) {
+        for(i=0;i<n;i++)
+            if((stat = fcn(map, &ios[i]))) goto done;
+        goto done;
+    }
+    if((tasks = calloc(n,sizeof(struct IOTask))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    if((stat = nctaskgroupnew(pool,&group))) goto done;
+    for(i=0;i<n;i++) {
+        tasks[i].map = map;
+        tasks[i].io = &ios[i];
+        tasks[i].fcn = fcn;
+        if((stat = nctasksubmit(group,io_task,&tasks[i]))) break;
+    }
+    {
+        int wstat = nctaskwait(group); /* must always wait */
+        if(stat == NC_NOERR) stat = wstat;
+    }
+done:
+    nctaskgroupfree(group);
+    nullfree(tasks);
+    return THROW(stat);
+}
+
 /* Define a static qsort comparator for strings for use with qsort */
 static int
 cmp_strings(const void* a1, const void* a2)
@@ -164,6 +164,8 @@ typedef size64_t NCZM_FEATURES;
 /* powers of 2 */
 #define NCZM_UNIMPLEMENTED 1 /* Unknown/ unimplemented */
 #define NCZM_WRITEONCE 2     /* Objects can only be written once */
+#define NCZM_CONCURRENTREAD 4 /* len/read may be called concurrently from several threads */
+#define NCZM_CONCURRENTWRITE 8 /* write may be called concurrently for distinct keys */
 
 /*
 For each dataset, we create what amounts to a class
@@ -190,6 +192,23 @@ typedef struct NCZMAP {
 /* Forward */
 struct NClist;
 
+/*
+One element of a batched read (readv) or write (writev).
+For a read, if content is NULL on entry then the whole object
+is read: content is set to malloc'd memory (caller frees) and
+count to the object's size, as with nczmap_readall. Otherwise
+count bytes starting at start are read into content.
+For a write, start is ignored and the whole object is written.
+The outcome of each element is left in stat.
+*/
+typedef struct NCZMAPIO {
+    const char* key;
+    size64_t start;
+    size64_t count;
+    void* content;
+    int stat; /* NC_NOERR, NC_EEMPTY or another error */
+} NCZMAPIO;
+
 /* Define the object-level API */
 
 struct NCZMAP_API {
@@ -200,8 +219,12 @@ struct NCZMAP_API {
 	int (*exists)(NCZMAP* map, const char* key);
 	int (*len)(NCZMAP* map, const char* key, size64_t* sizep);
 	int (*read)(NCZMAP* map, const char* key, size64_t start, size64_t count, void* content);
+	int (*readall)(NCZMAP* map, const char* key, size64_t* sizep, void** contentp);
 	int (*write)(NCZMAP* map, const char* key, size64_t count, const void* content);
         int (*search)(NCZMAP* map, const char* prefix, struct NClist* matches);
+    /* Batched Operations; NULL => performed one element at a time */
+	int (*readv)(NCZMAP* map, size_t n, NCZMAPIO* ios);
+	int (*writev)(NCZMAP* map, size_t n, NCZMAPIO* ios);
 };
 
 /* Define the Dataset level API */
@@ -275,6 +298,20 @@ Read the content of a specified content-bearing object.
 */
 EXTERNL int nczmap_read(NCZMAP* map, const char* key, size64_t start, size64_t count, void* content);
 
+/**
+Read the whole content of a specified content-bearing object
+and return its size, in a single operation where the
+implementation allows it (e.g. one GET instead of HEAD+GET).
+@param map -- the containing map
+@param key -- the key specifying the content-bearing object
+@param sizep -- the object's size is returned thru this pointer.
+@param contentp -- return the content in malloc'd memory; caller frees.
+@return NC_NOERR if the operation succeeded
+@return NC_EEMPTY if the object is not content-bearing.
+@return NC_EXXX if the operation failed for one of several possible reasons
+*/
+EXTERNL int nczmap_readall(NCZMAP* map, const char* key, size64_t* sizep, void** contentp);
+
 /**
 Write the content of a specified content-bearing object.
 This assumes that it is not possible to write a subset of an object.
@@ -290,6 +327,28 @@ Note that this makes the key a content-bearing object.
 */
 EXTERNL int nczmap_write(NCZMAP* map, const char* key, size64_t count, const void* content);
 
+/**
+Read a batch of objects or byte ranges of objects.
+The implementation is free to perform the reads in any order
+and concurrently; see NCZMAPIO for the semantics of each element.
+@param map -- the containing map
+@param n -- number of elements
+@param ios -- the elements; the outcome of each is left in ios[i].stat
+@return NC_NOERR if the batch was performed, even if some elements failed
+@return NC_EXXX if the batch as a whole failed (e.g. NC_ENOMEM)
+*/
+EXTERNL int nczmap_readv(NCZMAP* map, size_t n, NCZMAPIO* ios);
+
+/**
+Write a batch of whole objects; the keys must be distinct.
+@param map -- the containing map
+@param n -- number of elements
+@param ios -- the elements; the outcome of each is left in ios[i].stat
+@return NC_NOERR if the batch was performed, even if some elements failed
+@return NC_EXXX if the batch as a whole failed (e.g. NC_ENOMEM)
+*/
+EXTERNL int nczmap_writev(NCZMAP* map, size_t n, NCZMAPIO* ios);
+
 /**
 Return a vector of names (not keys) representing the
 next segment of legal objects that are immediately contained by the prefix key.
@@ -362,6 +421,11 @@ EXTERNL int nczm_basename(const char* path, char** basep);
 EXTERNL int nczm_segment1(const char* path, char** seg1p);
 EXTERNL int nczm_lastsegment(const char* path, char** lastp);
 
+/* Support for implementing readv/writev */
+EXTERNL int nczm_readio(NCZMAP* map, NCZMAPIO* io);
+EXTERNL int nczm_writeio(NCZMAP* map, NCZMAPIO* io);
+EXTERNL int nczm_iov(NCZMAP* map, size_t n, NCZMAPIO* ios, int (*fcn)(NCZMAP*, NCZMAPIO*), int concurrent);
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,10 +44,19 @@
 #endif
 #endif
 
+#ifdef NETCDF_ENABLE_THREADPOOL
+#include <pthread.h>
+#endif
+
 #include "fbits.h"
 #include "ncpathmgr.h"
+#include "ncrc.h"
+#include "ncxcache.h"
 
+/* Checks of each object accessed; costs an access()+stat() per access */
+#ifdef ZDEBUG
 #define VERIFY
+#endif
 
 #ifndef O_DIRECTORY
 # define O_DIRECTORY  0200000
@@ -61,6 +70,11 @@
 
 #define NCZM_FILE_V1 1
 
+/* Descriptors are shared thru the refcounted ZFentry descriptor cache,
+   but all I/O is positioned (pread/pwrite), so objects may be read
+   and written concurrently */
+#define ZFILE_PROPERTIES (NCZM_CONCURRENTREAD|NCZM_CONCURRENTWRITE)
+
 #ifdef S_IRUSR
 static int NC_DEFAULT_CREATE_PERMS =
            (S_IRUSR|S_IWUSR        |S_IRGRP|S_IWGRP);
@@ -78,6 +92,20 @@ static int NC_DEFAULT_ROPEN_PERMS = 0660;
 static int NC_DEFAULT_DIR_PERMS = 0770;
 #endif
 
+/* Max # of open descriptors kept per map; see ZFMAP.fdcache */
+#define DFALT_ZFILE_MAXFDS 64
+
+/* Access pattern hints passed to posix_fadvise() */
+typedef enum ZFadvice {
+ZFADV_NONE=0,
+ZFADV_SEQUENTIAL=1, /* at open: POSIX_FADV_SEQUENTIAL */
+ZFADV_RANDOM=2,     /* at open: POSIX_FADV_RANDOM */
+ZFADV_DONTNEED=3,   /* after each read or write: POSIX_FADV_DONTNEED */
+} ZFadvice;
+
+static size_t zfmaxfds = DFALT_ZFILE_MAXFDS;
+static ZFadvice zfadvice = ZFADV_NONE;
+
 /*
 Do a simple mapping of our simplified map model
 to a file system.
@@ -106,18 +134,48 @@ For the object API, the mapping is as follows:
 /* define the var name containing an objects content */
 #define ZCONTENT "data"
 
+/* A cached open descriptor */
+typedef struct ZFentry {
+    NCxnode lru;        /* must be first; see NCXUSER in ncxcache.h */
+    ncexhashkey_t hkey;
+    char* key;
+    int fd;
+    size_t refs;        /* # of FDs currently using fd */
+    int evicted;        /* no longer in the cache; close at last release */
+} ZFentry;
+
 typedef struct FD {
   int fd;
+  ZFentry* entry;       /* non-NULL if fd belongs to the descriptor cache */
 } FD;
 
-static FD FDNUL = {-1};
+static FD FDNUL = {-1,NULL};
 
 /* Define the "subclass" of NCZMAP */
 typedef struct ZFMAP {
     NCZMAP map;
     char* root;
+    /* Descriptors of recently used objects, keyed by object key, so
+       repeated access to an object skips the stat+open+close. All
+       I/O is positioned (pread/pwrite), so one descriptor may be
+       used by several threads at once. */
+    struct ZFfdcache {
+	size_t maxfds;  /* 0 => no caching */
+	NCxcache* fds;  /* hash index + LRU list of ZFentry */
+#ifdef NETCDF_ENABLE_THREADPOOL
+	pthread_mutex_t lock;
+#endif
+    } fdcache;
 } ZFMAP;
 
+#ifdef NETCDF_ENABLE_THREADPOOL
+#define ZFLOCK(zfmap) pthread_mutex_lock(&(zfmap)->fdcache.lock)
+#define ZFUNLOCK(zfmap) pthread_mutex_unlock(&(zfmap)->fdcache.lock)
+#else
+#define ZFLOCK(zfmap)
+#define ZFUNLOCK(zfmap)
+#endif
+
 /* Forward */
 static NCZMAP_API zapi;
 static int zfileclose(NCZMAP* map, int delete);
@@ -127,6 +185,9 @@ static int zfparseurl(const char* path0, NCURI** urip);
 static int zffullpath(ZFMAP* zfmap, const char* key, char**);
 static void zfrelease(ZFMAP* zfmap, FD* fd);
 static void zfunlink(const char* canonpath);
+static void zfcacheinit(ZFMAP* zfmap);
+static void zfcachefree(ZFMAP* zfmap);
+static void zfcacheadd(ZFMAP* zfmap, const char* key, FD* fd);
 
 static int platformerr(int err);
 static int platformcreatefile(int mode, const char* truepath,FD*);
@@ -135,9 +196,16 @@ static int platformopenfile(int mode, const char* truepath, FD* fd);
 static int platformopendir(int mode, const char* truepath);
 static int platformdircontent(const char* path, NClist* contents);
 static int platformdelete(const char* path, int delroot);
+#ifdef _WIN32
 static int platformseek(FD* fd, int pos, size64_t* offset);
 static int platformread(FD* fd, size64_t count, void* content);
 static int platformwrite(FD* fd, size64_t count, const void* content);
+#endif
+static int platformpread(FD* fd, size64_t offset, size64_t count, void* content);
+static int platformpwrite(FD* fd, size64_t offset, size64_t count, const void* content);
+static int platformtruncate(FD* fd, size64_t size);
+static int platformsize(FD* fd, size64_t* sizep);
+static void platformadvise(FD* fd, size64_t offset, size64_t count);
 static void platformrelease(FD* fd);
 static int platformtestcontentbearing(const char* truepath);
 
@@ -162,6 +230,14 @@ zfileinitialize(void)
 	if(env != NULL && strlen(env) > 0) {
 	    if(sscanf(env,"%d",&perms) == 1) NC_DEFAULT_DIR_PERMS = perms;
 	}
+	zfmaxfds = NC_rclookupsize(NULL,"NCZARR_MAXFDS","ZARR.MAXFDS",zfmaxfds);
+	env = NC_rclookupenv(NULL,"NCZARR_FADVISE","ZARR.FADVISE");
+	if(env != NULL) {
+	    if(strcasecmp(env,"sequential")==0) zfadvice = ZFADV_SEQUENTIAL;
+	    else if(strcasecmp(env,"random")==0) zfadvice = ZFADV_RANDOM;
+	    else if(strcasecmp(env,"dontneed")==0) zfadvice = ZFADV_DONTNEED;
+	    else zfadvice = ZFADV_NONE;
+	}
         zfinitialized = 1;
 	(void)ZUNTRACE(NC_NOERR);
     }
@@ -216,6 +292,8 @@ zfilecreate(const char *path, int mode, size64_t flags, void* parameters, NCZMAP
     if((zfmap = calloc(1,sizeof(ZFMAP))) == NULL)
 	{stat = NC_ENOMEM; goto done;}
 
+    zfcacheinit(zfmap);
+
     zfmap->map.format = NCZM_FILE;
     zfmap->map.url = ncuribuild(url,NULL,NULL,NCURIALL);
     zfmap->map.flags = flags;
@@ -290,6 +368,8 @@ zfileopen(const char *path, int mode, size64_t flags, void* parameters, NCZMAP**
     if((zfmap = calloc(1,sizeof(ZFMAP))) == NULL)
 	{stat = NC_ENOMEM; goto done;}
 
+    zfcacheinit(zfmap);
+
     zfmap->map.format = NCZM_FILE;
     zfmap->map.url = ncuribuild(url,NULL,NULL,NCURIALL);
     zfmap->map.flags = flags;
@@ -363,16 +443,16 @@ zfilelen(NCZMAP* map, const char* key, size64_t* lenp)
     switch (stat=zflookupobj(zfmap,key,&fd)) {
     case NC_NOERR:
         /* Get file size */
-        if((stat=platformseek(&fd, SEEK_END, &len))) goto done;
+        if((stat=platformsize(&fd, &len))) goto done;
 	break;
     case NC_ENOOBJECT: stat = NC_EEMPTY;
     case NC_EEMPTY: break;
     default: break;
     }
-    zfrelease(zfmap,&fd);
     if(lenp) *lenp = len;
 
 done:
+    zfrelease(zfmap,&fd);
     return ZUNTRACEX(stat,"len=%llu",(lenp?*lenp:777777777777));
 }
 
@@ -392,8 +472,7 @@ zfileread(NCZMAP* map, const char* key, size64_t start, size64_t count, void* co
 
     switch (stat = zflookupobj(zfmap,key,&fd)) {
     case NC_NOERR:
-        if((stat = platformseek(&fd, SEEK_SET, &start))) goto done;
-        if((stat = platformread(&fd, count, content))) goto done;
+        if((stat = platformpread(&fd, start, count, content))) goto done;
 	break;
     case NC_ENOOBJECT: stat = NC_EEMPTY;
     case NC_EEMPTY: break;
@@ -405,6 +484,90 @@ done:
     return ZUNTRACE(stat);
 }
 
+static int
+zfilereadall(NCZMAP* map, const char* key, size64_t* sizep, void** contentp)
+{
+    int stat = NC_NOERR;
+    FD fd = FDNUL;
+    ZFMAP* zfmap = (ZFMAP*)map; /* cast to true type */
+    size64_t size = 0;
+    void* content = NULL;
+
+    ZTRACE(5,"map=%s key=%s",map->url,key);
+
+    /* One lookup serves for both the size and the content */
+    switch (stat = zflookupobj(zfmap,key,&fd)) {
+    case NC_NOERR:
+        if((stat = platformsize(&fd, &size))) goto done;
+        if((content = malloc(size > 0 ? size : 1)) == NULL)
+            {stat = NC_ENOMEM; goto done;}
+        if((stat = platformpread(&fd, 0, size, content))) goto done;
+        if(sizep) *sizep = size;
+        if(contentp) {*contentp = content; content = NULL;}
+	break;
+    case NC_ENOOBJECT: stat = NC_EEMPTY; /* fall through */
+    case NC_EEMPTY: break;
+    default: break;
+    }
+
+done:
+    nullfree(content);
+    zfrelease(zfmap,&fd);
+    return ZUNTRACEX(stat,"size=%llu",size);
+}
+
+/* Perform one element of a readv; descriptors are shared thru the
+   descriptor cache, but all reads are positioned, so calls may run
+   concurrently */
+static int
+zfilereadio(NCZMAP* map, NCZMAPIO* io)
+{
+    int stat = NC_NOERR;
+    FD fd = FDNUL;
+    ZFMAP* zfmap = (ZFMAP*)map; /* cast to true type */
+    void* content = NULL;
+    size64_t size = 0;
+
+    ZTRACE(5,"map=%s key=%s start=%llu count=%llu",map->url,io->key,io->start,io->count);
+
+    switch (stat = zflookupobj(zfmap,io->key,&fd)) {
+    case NC_NOERR:
+        if(io->content != NULL) {
+            if((stat = platformpread(&fd, io->start, io->count, io->content))) goto done;
+        } else {
+            if((stat = platformsize(&fd, &size))) goto done;
+            if((content = malloc(size > 0 ? size : 1)) == NULL)
+                {stat = NC_ENOMEM; goto done;}
+            if((stat = platformpread(&fd, 0, size, content))) goto done;
+            io->count = size;
+            io->content = content; content = NULL;
+        }
+	break;
+    case NC_ENOOBJECT: stat = NC_EEMPTY; /* fall through */
+    case NC_EEMPTY: break;
+    default: break;
+    }
+
+done:
+    nullfree(content);
+    zfrelease(zfmap,&fd);
+    io->stat = stat;
+    return ZUNTRACE(NC_NOERR);
+}
+
+static int
+zfilereadv(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    return nczm_iov(map,n,ios,zfilereadio,1);
+}
+
+static int
+zfilewritev(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    /* Writes of distinct keys may proceed concurrently */
+    return nczm_iov(map,n,ios,nczm_writeio,1);
+}
+
 static int
 zfilewrite(NCZMAP* map, const char* key, size64_t count, const void* content)
 {
@@ -412,9 +575,8 @@ zfilewrite(NCZMAP* map, const char* key, size64_t count, const void* content)
     FD fd = FDNUL;
     ZFMAP* zfmap = (ZFMAP*)map; /* cast to true type */
     char* truepath = NULL;
-    size64_t start = 0;
 
-    ZTRACE(5,"map=%s key=%s start=%llu count=%llu",map->url,key,start,count);
+    ZTRACE(5,"map=%s key=%s count=%llu",map->url,key,count);
 
 #ifdef VERIFY
     if(!verifykey(key,!FLAG_ISDIR))
@@ -431,10 +593,12 @@ zfilewrite(NCZMAP* map, const char* key, size64_t count, const void* content)
         if((stat = zffullpath(zfmap,key,&truepath))) goto done;
 	/* Create file */
 	if((stat = platformcreatefile(zfmap->map.mode,truepath,&fd))) goto done;
+	zfcacheadd(zfmap,key,&fd);
 	/* Fall thru to write the object */
     case NC_NOERR:
-        if((stat = platformseek(&fd, SEEK_SET, &start))) goto done;
-        if((stat = platformwrite(&fd, count, content))) goto done;
+        if((stat = platformpwrite(&fd, 0, count, content))) goto done;
+	/* Drop the tail of a longer previous content */
+        if((stat = platformtruncate(&fd, count))) goto done;
 	break;
     default: break;
     }
@@ -453,7 +617,10 @@ zfileclose(NCZMAP* map, int delete)
 
     ZTRACE(5,"map=%s delete=%d",map->url,delete);
     if(zfmap == NULL) return NC_NOERR;
-    
+
+    /* Close the cached descriptors first; an open file cannot be deleted on Windows */
+    zfcachefree(zfmap);
+
     /* Delete the subtree below the root and the root */
     if(delete) {
 	stat = platformdelete(zfmap->root,1);
@@ -573,6 +740,23 @@ zflookupobj(ZFMAP* zfmap, const char* key, FD* fd)
 
     ZTRACE(5,"map=%s key=%s",zfmap->map.url,key);
 
+    /* A cached descriptor implies a content-bearing object */
+    if(zfmap->fdcache.fds != NULL) {
+	void* obj = NULL;
+	ncexhashkey_t hkey = ncxcachekey(key,strlen(key));
+	ZFLOCK(zfmap);
+	if(ncxcachelookup(zfmap->fdcache.fds,hkey,&obj) == NC_NOERR
+	   && strcmp(((ZFentry*)obj)->key,key) == 0) {
+	    ZFentry* entry = (ZFentry*)obj;
+	    (void)ncxcachetouch(zfmap->fdcache.fds,hkey);
+	    entry->refs++;
+	    fd->fd = entry->fd;
+	    fd->entry = entry;
+	}
+	ZFUNLOCK(zfmap);
+	if(fd->entry != NULL) goto done;
+    }
+
     if((stat = zffullpath(zfmap,key,&path)))
 	{goto done;}    
 
@@ -583,6 +767,7 @@ zflookupobj(ZFMAP* zfmap, const char* key, FD* fd)
     /* Open the file */
     if((stat = platformopenfile(zfmap->map.mode,path,fd)))
         goto done;
+    zfcacheadd(zfmap,key,fd);
 
 done:
     errno = 0;
@@ -595,16 +780,130 @@ static void
 zfrelease(ZFMAP* zfmap, FD* fd)
 {
     ZTRACE(5,"map=%s fd=%d",zfmap->map.url,(fd?fd->fd:-1));
-    platformrelease(fd);
+    if(fd->entry != NULL) {
+	ZFentry* entry = fd->entry;
+	int last = 0;
+	ZFLOCK(zfmap);
+	assert(entry->refs > 0);
+	entry->refs--;
+	last = (entry->evicted && entry->refs == 0);
+	ZFUNLOCK(zfmap);
+	if(last) {
+	    NCclose(entry->fd);
+	    nullfree(entry->key);
+	    free(entry);
+	}
+	*fd = FDNUL;
+    } else
+	platformrelease(fd);
     (void)ZUNTRACE(NC_NOERR);
 }
 
+/**************************************************/
+/* Descriptor cache */
+
+static void
+zfcacheinit(ZFMAP* zfmap)
+{
+    zfmap->fdcache.maxfds = zfmaxfds;
+    zfmap->fdcache.fds = NULL;
+    if(zfmap->fdcache.maxfds > 0
+       && ncxcachenew(zfmap->fdcache.maxfds,&zfmap->fdcache.fds) != NC_NOERR)
+	zfmap->fdcache.fds = NULL; /* run without the cache */
+#ifdef NETCDF_ENABLE_THREADPOOL
+    pthread_mutex_init(&zfmap->fdcache.lock,NULL);
+#endif
+}
+
+/* Remove an entry from the cache; lock must be held.
+   Return 1 if the caller must close and free it. */
+static int
+zfcacheevict(ZFMAP* zfmap, ZFentry* entry)
+{
+    void* obj = NULL;
+    (void)ncxcacheremove(zfmap->fdcache.fds,entry->hkey,&obj);
+    entry->evicted = 1;
+    return (entry->refs == 0);
+}
+
+static void
+zfcachefree(ZFMAP* zfmap)
+{
+    ZFentry* entry = NULL;
+
+    if(zfmap->fdcache.fds != NULL) {
+	while((entry = (ZFentry*)ncxcachelast(zfmap->fdcache.fds)) != NULL) {
+	    /* Nothing can be in use once the map is being closed */
+	    assert(entry->refs == 0);
+	    (void)zfcacheevict(zfmap,entry);
+	    NCclose(entry->fd);
+	    nullfree(entry->key);
+	    free(entry);
+	}
+	ncxcachefree(zfmap->fdcache.fds);
+	zfmap->fdcache.fds = NULL;
+    }
+#ifdef NETCDF_ENABLE_THREADPOOL
+    pthread_mutex_destroy(&zfmap->fdcache.lock);
+#endif
+}
+
+/* Hand a freshly opened descriptor for key over to the cache. If
+   another thread got there first, the new descriptor is closed and
+   the cached one used instead; if the cache cannot take it, fd is
+   left uncached and is closed by zfrelease as before. */
+static void
+zfcacheadd(ZFMAP* zfmap, const char* key, FD* fd)
+{
+    ZFentry* entry = NULL;
+    ZFentry* victim = NULL;
+    ncexhashkey_t hkey;
+    void* obj = NULL;
+
+    if(zfmap->fdcache.fds == NULL || fd->fd < 0) return;
+    hkey = ncxcachekey(key,strlen(key));
+    ZFLOCK(zfmap);
+    if(ncxcachelookup(zfmap->fdcache.fds,hkey,&obj) == NC_NOERR) {
+	entry = (ZFentry*)obj;
+	if(strcmp(entry->key,key) == 0) {
+	    NCclose(fd->fd);
+	    entry->refs++;
+	    fd->fd = entry->fd;
+	    fd->entry = entry;
+	}
+	/* else a hash collision: leave fd uncached */
+	goto done;
+    }
+    if((entry = (ZFentry*)calloc(1,sizeof(ZFentry))) == NULL) goto done;
+    if((entry->key = strdup(key)) == NULL) {free(entry); goto done;}
+    /* Make room; in-use victims are closed by their last zfrelease */
+    while(ncxcachecount(zfmap->fdcache.fds) >= zfmap->fdcache.maxfds
+          && (victim = (ZFentry*)ncxcachelast(zfmap->fdcache.fds)) != NULL) {
+	if(zfcacheevict(zfmap,victim)) {
+	    NCclose(victim->fd);
+	    nullfree(victim->key);
+	    free(victim);
+	}
+    }
+    entry->hkey = hkey;
+    entry->fd = fd->fd;
+    entry->refs = 1;
+    if(ncxcacheinsert(zfmap->fdcache.fds,hkey,entry) != NC_NOERR) {
+	nullfree(entry->key);
+	free(entry);
+	goto done;
+    }
+    fd->entry = entry;
+done:
+    ZFUNLOCK(zfmap);
+}
+
 /**************************************************/
 /* External API objects */
 
 NCZMAP_DS_API zmap_file = {
     NCZM_FILE_V1,
-    0,
+    ZFILE_PROPERTIES,
     zfilecreate,
     zfileopen,
     zfiletruncate,
@@ -616,8 +915,11 @@ static NCZMAP_API zapi = {
     zfileexists,
     zfilelen,
     zfileread,
+    zfilereadall,
     zfilewrite,
     zfilesearch,
+    zfilereadv,
+    zfilewritev,
 };
 
 static int
@@ -745,6 +1047,7 @@ platformcreatefile(int mode, const char* canonpath, FD* fd)
 	stat = platformerr(errno);
         goto done; /* could not open */
     }
+    platformadvise(fd,0,0);
 done:
     errno = 0;
     return ZUNTRACEX(stat,"fd=%d",(fd?fd->fd:-1));
@@ -781,6 +1084,7 @@ platformopenfile(int mode, const char* canonpath, FD* fd)
     fd->fd = NCopen3(canonpath, ioflags, permissions);
     if(fd->fd < 0)
         {stat = platformerr(errno); goto done;} /* could not open */
+    platformadvise(fd,0,0);
 done:
     errno = 0;
     return ZUNTRACEX(stat,"fd=%d",(fd?fd->fd:-1));
@@ -801,7 +1105,8 @@ platformcreatedir(int mode, const char* canonpath)
 	if(fIsSet(mode,NC_WRITE)) {
 	    /* Try to create it */
             /* Create the directory using mkdir */
-   	    if(NCmkdir(canonpath,(mode_t)NC_DEFAULT_DIR_PERMS) < 0)
+   	    if(NCmkdir(canonpath,(mode_t)NC_DEFAULT_DIR_PERMS) < 0
+	       && errno != EEXIST) /* may have been created concurrently */
 	        {ret = platformerr(errno); goto done;}
 	    /* try to access again */
 	    ret = NCaccess(canonpath,ACCESS_MODE_EXISTS);
@@ -1058,6 +1363,8 @@ done:
     return ZUNTRACE(stat);
 }
 
+#ifdef _WIN32
+/* Windows has no pread/pwrite; see platformpread */
 static int
 platformseek(FD* fd, int pos, size64_t* sizep)
 {
@@ -1125,6 +1432,127 @@ platformwrite(FD* fd, size64_t count, const void* content)
 done:
     return ZUNTRACE(ret);
 }
+#endif /*_WIN32*/
+
+static int
+platformpread(FD* fd, size64_t offset, size64_t count, void* content)
+{
+    int stat = NC_NOERR;
+
+    assert(fd && fd->fd >= 0);
+
+    ZTRACE(6,"fd=%d offset=%llu count=%llu",(fd?fd->fd:-1),offset,count);
+
+#ifdef _WIN32
+    /* No pread(); seek+read is only safe because the thread pool,
+       and so concurrent use of a descriptor, requires pthreads */
+    if((stat = platformseek(fd, SEEK_SET, &offset))) goto done;
+    if((stat = platformread(fd, count, content))) goto done;
+#else
+    size_t need = count;
+    unsigned char* readpoint = content;
+    while(need > 0) {
+        ssize_t red;
+        if((red = pread(fd->fd,readpoint,need,(off_t)offset)) <= 0)
+	    {stat = (red == 0 ? NC_EINTERNAL : platformerr(errno)); goto done;}
+        need -= (size_t)red;
+	readpoint += red;
+	offset += (size64_t)red;
+    }
+    if(zfadvice == ZFADV_DONTNEED) platformadvise(fd, offset - count, count);
+#endif
+done:
+    errno = 0;
+    return ZUNTRACE(stat);
+}
+
+static int
+platformtruncate(FD* fd, size64_t size)
+{
+    int stat = NC_NOERR;
+
+    assert(fd && fd->fd >= 0);
+
+    ZTRACE(6,"fd=%d size=%llu",(fd?fd->fd:-1),size);
+
+#ifdef _WIN32
+    if(_chsize_s(fd->fd,(__int64)size) != 0)
+#else
+    if(ftruncate(fd->fd,(off_t)size) < 0)
+#endif
+	stat = platformerr(errno);
+    errno = 0;
+    return ZUNTRACE(stat);
+}
+
+static int
+platformpwrite(FD* fd, size64_t offset, size64_t count, const void* content)
+{
+    int stat = NC_NOERR;
+
+    assert(fd && fd->fd >= 0);
+
+    ZTRACE(6,"fd=%d offset=%llu count=%llu",(fd?fd->fd:-1),offset,count);
+
+#ifdef _WIN32
+    if((stat = platformseek(fd, SEEK_SET, &offset))) goto done;
+    if((stat = platformwrite(fd, count, content))) goto done;
+#else
+    size_t need = count;
+    const unsigned char* writepoint = content;
+    while(need > 0) {
+        ssize_t red;
+        if((red = pwrite(fd->fd,writepoint,need,(off_t)offset)) <= 0)
+	    {stat = NC_EACCESS; goto done;}
+        need -= (size_t)red;
+	writepoint += red;
+	offset += (size64_t)red;
+    }
+    if(zfadvice == ZFADV_DONTNEED) platformadvise(fd, offset - count, count);
+#endif
+done:
+    errno = 0;
+    return ZUNTRACE(stat);
+}
+
+/* Pass the configured access pattern hint to the kernel: the
+   open-time hints when count == 0, else DONTNEED for the range */
+static void
+platformadvise(FD* fd, size64_t offset, size64_t count)
+{
+#ifdef HAVE_POSIX_FADVISE
+    int advice;
+    switch (zfadvice) {
+    case ZFADV_SEQUENTIAL: advice = POSIX_FADV_SEQUENTIAL; break;
+    case ZFADV_RANDOM: advice = POSIX_FADV_RANDOM; break;
+    case ZFADV_DONTNEED: advice = POSIX_FADV_DONTNEED; break;
+    default: return;
+    }
+    if((count == 0) != (zfadvice != ZFADV_DONTNEED)) return;
+    (void)posix_fadvise(fd->fd,(off_t)offset,(off_t)count,advice);
+#else
+    NC_UNUSED(fd);
+    NC_UNUSED(offset);
+    NC_UNUSED(count);
+#endif
+}
+
+static int
+platformsize(FD* fd, size64_t* sizep)
+{
+    int ret = NC_NOERR;
+    struct stat statbuf;
+
+    assert(fd && fd->fd >= 0);
+
+    errno = 0;
+    if(NCfstat(fd->fd, &statbuf) < 0)
+	{ret = platformerr(errno); goto done;}
+    if(sizep) *sizep = (size64_t)statbuf.st_size;
+done:
+    errno = 0;
+    return ret;
+}
 
 #if 0
 static int
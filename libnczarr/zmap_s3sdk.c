@@ -352,6 +352,127 @@ done:
     return ZUNTRACE(stat);
 }
 
+/*
+Read the whole object with a single request instead of HEAD+GET.
+@return NC_NOERR if object at key was read
+@return NC_EEMPTY if object at key has no content.
+@return NC_EXXX return true error
+*/
+static int
+zs3readall(NCZMAP* map, const char* key, size64_t* sizep, void** contentp)
+{
+    int stat = NC_NOERR;
+    ZS3MAP* z3map = (ZS3MAP*)map; /* cast to true type */
+    char* truekey = NULL;
+
+    ZTRACE(6,"map=%s key=%s",map->url,key);
+
+    if((stat = maketruekey(z3map->s3.rootkey,key,&truekey))) goto done;
+
+    switch (stat=NC_s3sdkreadall(z3map->s3client, z3map->s3.bucket, truekey, sizep, contentp, &z3map->errmsg)) {
+    case NC_NOERR: break;
+    case NC_EEMPTY: case NC_ENOOBJECT: stat = NC_EEMPTY; goto done;
+    default: goto done;
+    }
+done:
+    nullfree(truekey);
+    reporterr(z3map);
+    return ZUNTRACE(stat);
+}
+
+/**************************************************/
+/* Batched operations
+
+All the requests of a batch are submitted to the map's S3 client and
+then waited for together; the client performs them concurrently over
+its pool of persistent connections (see NC_s3sdksubmit()). A ranged
+read is a single ranged GET; a range past the end of the object is
+reported by the GET itself, so no HEAD is needed.
+*/
+
+static void
+batchreport(char** errmsgp)
+{
+    if(*errmsgp != NULL) {
+#ifdef DEBUGERRORS
+        nclog(NCLOGERR,*errmsgp);
+#endif
+        free(*errmsgp);
+        *errmsgp = NULL;
+    }
+}
+
+static int
+zs3iov(ZS3MAP* z3map, size_t n, NCZMAPIO* ios, int writing)
+{
+    int stat = NC_NOERR;
+    NCS3REQ* reqs = NULL;
+    char** truekeys = NULL;
+    char* errmsg = NULL;
+    size_t i;
+
+    if(n == 0) goto done;
+    if((reqs = (NCS3REQ*)calloc(n,sizeof(NCS3REQ))) == NULL
+       || (truekeys = (char**)calloc(n,sizeof(char*))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    for(i=0;i<n;i++) {
+        NCZMAPIO* io = &ios[i];
+        NCS3REQ* req = &reqs[i];
+        if(!writing && io->content != NULL && io->count == 0) {
+            /* Nothing to transfer; only check the object */
+            io->stat = zs3read((NCZMAP*)z3map,io->key,io->start,0,io->content);
+            continue;
+        }
+        if((io->stat = maketruekey(z3map->s3.rootkey,io->key,&truekeys[i]))) continue;
+        req->op = (writing ? NCS3PUT : NCS3GET);
+        req->pathkey = truekeys[i];
+        req->start = io->start;
+        req->count = (!writing && io->content == NULL ? 0 : io->count);
+        req->content = io->content;
+        if((io->stat = NC_s3sdksubmit(z3map->s3client,z3map->s3.bucket,req,&errmsg)))
+            req->pathkey = NULL; /* not submitted */
+        batchreport(&errmsg);
+    }
+    stat = NC_s3sdkwait(z3map->s3client,&errmsg);
+    batchreport(&errmsg);
+    for(i=0;i<n;i++) {
+        NCZMAPIO* io = &ios[i];
+        NCS3REQ* req = &reqs[i];
+        if(req->pathkey == NULL) continue; /* not submitted */
+        io->stat = req->stat;
+        if(io->stat == NC_ENOOBJECT) io->stat = NC_EEMPTY;
+        if(!writing && io->content == NULL && io->stat == NC_NOERR) {
+            io->count = req->count;
+            io->content = req->content;
+        }
+    }
+done:
+    if(truekeys != NULL) {
+        for(i=0;i<n;i++) nullfree(truekeys[i]);
+        free(truekeys);
+    }
+    nullfree(reqs);
+    return stat;
+}
+
+static int
+zs3readv(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    int stat = NC_NOERR;
+    ZTRACE(6,"map=%s n=%llu",map->url,(unsigned long long)n);
+    stat = zs3iov((ZS3MAP*)map,n,ios,0);
+    return ZUNTRACE(stat);
+}
+
+static int
+zs3writev(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    int stat = NC_NOERR;
+    ZTRACE(6,"map=%s n=%llu",map->url,(unsigned long long)n);
+    stat = zs3iov((ZS3MAP*)map,n,ios,1);
+    return ZUNTRACE(stat);
+}
+
 /*
 @return NC_NOERR if key content was written
 @return NC_EEMPTY if object at key has no content.
@@ -591,6 +712,9 @@ nczs3sdkapi = {
     zs3exists,
     zs3len,
     zs3read,
+    zs3readall,
     zs3write,
     zs3search,
+    zs3readv,
+    zs3writev,
 };
@@ -69,6 +69,7 @@ static int zipclose(NCZMAP* map, int delete);
 static int zzcreategroup(ZZMAP*, const char* key, int nskip);
 static int zzlookupobj(ZZMAP*, const char* key, ZINDEX* fd);
 static int zzlen(ZZMAP* zzmap, ZINDEX zindex, size64_t* lenp);
+static int zzreadindex(ZZMAP* zzmap, ZINDEX zindex, size64_t start, size64_t count, size64_t* sizep, void** contentp);
 static int zipmaperr(ZZMAP* zzmap);
 static int ziperr(zip_error_t* zerror);
 static int ziperrno(int zerror);
@@ -426,6 +427,82 @@ done:
     return ZUNTRACE(stat);
 }
 
+static int
+zipreadall(NCZMAP* map, const char* key, size64_t* sizep, void** contentp)
+{
+    int stat = NC_NOERR;
+    ZZMAP* zzmap = (ZZMAP*)map; /* cast to true type */
+    ZINDEX zindex = -1;
+    void* content = NULL;
+
+    ZTRACE(6,"map=%s key=%s",map->url,key);
+
+    switch(stat = zzlookupobj(zzmap,key,&zindex)) {
+    case NC_NOERR: break;
+    case NC_ENOOBJECT: stat = NC_EEMPTY; /* fall thru */
+    case NC_EEMPTY: /* its a dir; fall thru*/
+    default: goto done;
+    }
+    /* The index from the lookup gives both the size and the entry */
+    if((stat = zzreadindex(zzmap,zindex,0,0,sizep,&content))) goto done;
+    if(contentp) {*contentp = content; content = NULL;}
+
+done:
+    nullfree(content);
+    return ZUNTRACE(stat);
+}
+
+/* Sort readv elements into archive order */
+struct ZIPIO {
+    ZINDEX zindex;
+    NCZMAPIO* io;
+};
+
+static int
+zipiocompare(const void* a, const void* b)
+{
+    const struct ZIPIO* za = (const struct ZIPIO*)a;
+    const struct ZIPIO* zb = (const struct ZIPIO*)b;
+    return (za->zindex < zb->zindex ? -1 : (za->zindex > zb->zindex ? 1 : 0));
+}
+
+/* libzip does not allow concurrent access to an archive, so instead
+   make a single pass through the archive in index order */
+static int
+zipreadv(NCZMAP* map, size_t n, NCZMAPIO* ios)
+{
+    int stat = NC_NOERR;
+    ZZMAP* zzmap = (ZZMAP*)map; /* cast to true type */
+    struct ZIPIO* order = NULL;
+    size_t i, nfound = 0;
+
+    ZTRACE(6,"map=%s n=%llu",map->url,(unsigned long long)n);
+
+    if((order = calloc(n,sizeof(struct ZIPIO))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    for(i=0;i<n;i++) {
+        ZINDEX zindex = -1;
+        switch(ios[i].stat = zzlookupobj(zzmap,ios[i].key,&zindex)) {
+        case NC_NOERR:
+            order[nfound].zindex = zindex;
+            order[nfound].io = &ios[i];
+            nfound++;
+            break;
+        case NC_ENOOBJECT: ios[i].stat = NC_EEMPTY; break;
+        default: break;
+        }
+    }
+    qsort(order,nfound,sizeof(struct ZIPIO),zipiocompare);
+    for(i=0;i<nfound;i++) {
+        NCZMAPIO* io = order[i].io;
+        io->stat = zzreadindex(zzmap,order[i].zindex,io->start,io->count,&io->count,&io->content);
+    }
+
+done:
+    nullfree(order);
+    return ZUNTRACE(stat);
+}
+
 static int
 zipwrite(NCZMAP* map, const char* key, size64_t count, const void* content)
 {
@@ -746,10 +823,63 @@ static NCZMAP_API zapi = {
     zipexists,
     ziplen,
     zipread,
+    zipreadall,
     zipwrite,
     zipsearch,
+    zipreadv,
+    NULL, /* writev: objects are written one at a time */
 };
 
+/*
+Read from the entry at zindex. If *contentp is NULL, the whole
+entry is read into malloc'd memory returned thru contentp, and its
+size is returned thru sizep; otherwise count bytes from start are
+read into *contentp.
+*/
+static int
+zzreadindex(ZZMAP* zzmap, ZINDEX zindex, size64_t start, size64_t count, size64_t* sizep, void** contentp)
+{
+    int stat = NC_NOERR;
+    zip_file_t* zfile = NULL;
+    int zerrno;
+    int whole = (*contentp == NULL);
+    size64_t endpoint;
+    char* buffer = NULL;
+    char* target = NULL;
+    zip_int64_t red = 0;
+
+    if(whole) {
+        start = 0;
+        if((stat = zzlen(zzmap,zindex,&count))) goto done;
+    }
+    endpoint = start + count;
+    if(whole || start > 0) {
+        if((buffer = malloc(endpoint > 0 ? endpoint : 1)) == NULL)
+            {stat = NC_ENOMEM; goto done;}
+        target = buffer;
+    } else
+        target = (char*)*contentp; /* read directly into content */
+    if(endpoint > 0) {
+        if((zfile = zip_fopen_index(zzmap->archive, (zip_uint64_t)zindex, 0)) == NULL)
+	    {stat = (zipmaperr(zzmap)); goto done;}
+        /* The entry may be compressed, so always read from its beginning */
+        if((red = zip_fread(zfile, target, (zip_uint64_t)endpoint)) < 0)
+	    {stat = (zipmaperr(zzmap)); goto done;}
+	if(red < endpoint) {stat = NC_EINTERNAL; goto done;}
+    }
+    if(whole) {
+        *contentp = buffer; buffer = NULL;
+        if(sizep) *sizep = count;
+    } else if(start > 0)
+        memcpy(*contentp,buffer+start,count);
+
+done:
+    nullfree(buffer);
+    if(zfile != NULL && (zerrno=zip_fclose(zfile)) != 0)
+        {stat = ziperrno(zerrno);}
+    return stat;
+}
+
 static int
 zipmaperr(ZZMAP* zzmap)
 {
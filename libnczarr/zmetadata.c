@@ -4,6 +4,7 @@
  *********************************************************************/
 
 #include "zincludes.h"
+#include "ncthreadpool.h"
 
 static int
 cmpstrings(const void* a1, const void* a2)
@@ -134,6 +135,7 @@ void NCZMD_free_metadata_handler(NCZ_Metadata * zmd){
 	if (zmd == NULL) return;
 	NCJreclaim(zmd->jcsl);
     zmd->jcsl = NULL;
+    NCZMD_prefetch_clear(zmd);
 }
 
 int NCZMD_consolidate(NCZ_FILE_INFO_T *zfile)
@@ -144,3 +146,169 @@ int NCZMD_consolidate(NCZ_FILE_INFO_T *zfile)
 	}
 	return stat;
 }
+
+/**************************************************/
+/* Read-ahead of metadata objects */
+
+struct ParseTask {
+    NCZMAPIO* io;
+    NCjson* json;
+};
+
+static int
+parse_task(void* arg)
+{
+    struct ParseTask* task = (struct ParseTask*)arg;
+    NCZMAPIO* io = task->io;
+    /* A parse failure is left for the normal fetch to report */
+    if(io->stat == NC_NOERR
+       && NCJparsen((size_t)io->count,(const char*)io->content,0,&task->json) < 0)
+        task->json = NULL;
+    return NC_NOERR;
+}
+
+/* Read and parse one batch of keys and add them to jprefetch */
+static int
+prefetch_batch(NCZ_FILE_INFO_T *zfile, size_t n, const char **keys)
+{
+    int stat = NC_NOERR;
+    size_t i;
+    NCthreadpool* pool = NULL;
+    NCtaskgroup* group = NULL;
+    NCZMAPIO* ios = NULL;
+    struct ParseTask* tasks = NULL;
+    NCjson* jmissing = NULL;
+
+    if((ios = calloc(n,sizeof(NCZMAPIO))) == NULL
+       || (tasks = calloc(n,sizeof(struct ParseTask))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    for(i=0;i<n;i++) {
+        ios[i].key = keys[i];
+        tasks[i].io = &ios[i];
+    }
+    if((stat = nczmap_readv(zfile->map,n,ios))) goto done;
+
+    /* Parse concurrently */
+    if(n > 1) pool = NCZ_threadpool();
+    if(pool == NULL) {
+        for(i=0;i<n;i++) (void)parse_task(&tasks[i]);
+    } else {
+        if((stat = nctaskgroupnew(pool,&group))) goto done;
+        for(i=0;i<n;i++) {
+            if((stat = nctasksubmit(group,parse_task,&tasks[i]))) break;
+        }
+        {
+            int wstat = nctaskwait(group); /* must always wait */
+            if(stat == NC_NOERR) stat = wstat;
+        }
+        if(stat) goto done;
+    }
+
+    for(i=0;i<n;i++) {
+        switch (ios[i].stat) {
+        case NC_NOERR:
+            if(tasks[i].json == NULL) continue; /* not parsed */
+            if((stat = NCJinsert(zfile->metadata.jprefetch,keys[i],tasks[i].json))) goto done;
+            tasks[i].json = NULL;
+            break;
+        case NC_ENOOBJECT: case NC_EEMPTY:
+            if((stat = NCJnew(NCJ_NULL,&jmissing))) goto done;
+            if((stat = NCJinsert(zfile->metadata.jprefetch,keys[i],jmissing))) goto done;
+            jmissing = NULL;
+            break;
+        default: /* left for the normal fetch to report */
+            break;
+        }
+    }
+
+done:
+    nctaskgroupfree(group);
+    NCJreclaim(jmissing);
+    if(tasks != NULL) {
+        for(i=0;i<n;i++) NCJreclaim(tasks[i].json);
+        free(tasks);
+    }
+    if(ios != NULL) {
+        for(i=0;i<n;i++) nullfree(ios[i].content);
+        free(ios);
+    }
+    return stat;
+}
+
+int NCZMD_prefetch(NCZ_FILE_INFO_T *zfile, NClist *keys, size_t batch)
+{
+    int stat = NC_NOERR;
+    size_t i, n, nkeys = nclistlength(keys);
+
+    if(nkeys == 0) return NC_NOERR;
+    if(zfile->metadata.jprefetch == NULL
+       && (stat = NCJnew(NCJ_DICT,&zfile->metadata.jprefetch)))
+        return stat;
+    if(batch == 0) batch = nkeys;
+    for(i=0;i<nkeys;i+=n) {
+        n = (nkeys - i < batch ? nkeys - i : batch);
+        if((stat = prefetch_batch(zfile,n,(const char**)nclistcontents(keys)+i))) break;
+    }
+    return stat;
+}
+
+int NCZMD_prefetched(NCZ_FILE_INFO_T *zfile, const char *key, const NCjson **jobj)
+{
+    const NCjson* json = NULL;
+
+    if(zfile->metadata.jprefetch == NULL
+       || NCJdictget(zfile->metadata.jprefetch,key,&json) || json == NULL)
+        return 0;
+    if(jobj) *jobj = (NCJsort(json) == NCJ_NULL ? NULL : json);
+    return 1;
+}
+
+static int
+listing2json(NClist *names, NCjson **jarrayp)
+{
+    int stat = NC_NOERR;
+    size_t i;
+    NCjson* jarray = NULL;
+
+    if((stat = NCJnew(NCJ_ARRAY,&jarray))) goto done;
+    for(i=0;i<nclistlength(names);i++) {
+        if((stat = NCJaddstring(jarray,NCJ_STRING,(const char*)nclistget(names,i)))) goto done;
+    }
+    *jarrayp = jarray; jarray = NULL;
+done:
+    NCJreclaim(jarray);
+    return stat;
+}
+
+int NCZMD_set_listing(NCZ_FILE_INFO_T *zfile, const char *key, NClist *groups, NClist *vars)
+{
+    int stat = NC_NOERR;
+    NCjson* jlisting = NULL;
+    NCjson* jnames = NULL;
+
+    if(zfile->metadata.jlistings == NULL
+       && (stat = NCJnew(NCJ_DICT,&zfile->metadata.jlistings)))
+        goto done;
+    if((stat = NCJnew(NCJ_DICT,&jlisting))) goto done;
+    if((stat = listing2json(groups,&jnames))) goto done;
+    if((stat = NCJinsert(jlisting,"groups",jnames))) goto done;
+    jnames = NULL;
+    if((stat = listing2json(vars,&jnames))) goto done;
+    if((stat = NCJinsert(jlisting,"arrays",jnames))) goto done;
+    jnames = NULL;
+    if((stat = NCJinsert(zfile->metadata.jlistings,key,jlisting))) goto done;
+    jlisting = NULL;
+done:
+    NCJreclaim(jnames);
+    NCJreclaim(jlisting);
+    return stat;
+}
+
+void NCZMD_prefetch_clear(NCZ_Metadata *zmd)
+{
+    if (zmd == NULL) return;
+    NCJreclaim(zmd->jprefetch);
+    zmd->jprefetch = NULL;
+    NCJreclaim(zmd->jlistings);
+    zmd->jlistings = NULL;
+}
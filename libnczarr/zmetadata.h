@@ -62,6 +62,8 @@ typedef struct NCZ_Metadata
 	int dispatch_version;   /* Dispatch table version*/
 	size64_t flags;			/* Metadata handling flags */
 	NCjson *jcsl; // Consolidated JSON view or NULL
+	NCjson *jprefetch; // Objects read ahead by NCZMD_prefetch, by key; NCJ_NULL if missing
+	NCjson *jlistings; // Group listings read ahead, by group key; see NCZMD_set_listing
 	int (*list_nodes)(struct NCZ_FILE_INFO*, const char * key, NClist *groups, NClist *vars);
 	int (*list_groups)(struct NCZ_FILE_INFO*, const char * key, NClist *subgrpnames);
 	int (*list_variables)(struct NCZ_FILE_INFO*, const char * key, NClist *varnames);
@@ -157,6 +159,37 @@ extern int NCZMD_update_json_attrs(struct NCZ_FILE_INFO *zfile, const char *key,
 /// @return NO_ERROR on success, error code on failure
 extern int NCZMD_update_json_array(struct NCZ_FILE_INFO *zfile, const char *key, const NCjson *jarrays);
 
+/// @brief Reads a set of metadata objects ahead of use: the objects are read
+/// 	with batched map reads (nczmap_readv) and parsed concurrently on the
+/// 	NCZarr thread pool. Later fetches of these keys by the non-consolidated
+/// 	handler are served from memory until NCZMD_prefetch_clear.
+/// @param zfile - The zarr file info structure
+/// @param keys - The object keys, e.g. "/g/.zgroup"
+/// @param batch - The max no. of objects per batch; 0 => no limit
+/// @return NO_ERROR on success, error code on failure; an object that cannot
+/// 	be read or parsed is not an error here, it is left to the normal fetch
+extern int NCZMD_prefetch(struct NCZ_FILE_INFO *zfile, NClist *keys, size_t batch);
+
+/// @brief Looks up an object read ahead by NCZMD_prefetch.
+/// @param zfile - The zarr file info structure
+/// @param key - The object key
+/// @param jobj - Pointer to receive the object, NULL if it does not exist; not a copy
+/// @return 1 if the key was read ahead, 0 otherwise
+extern int NCZMD_prefetched(struct NCZ_FILE_INFO *zfile, const char *key, const NCjson **jobj);
+
+/// @brief Records the listing of a group, so that NCZMD_list_nodes on the
+/// 	non-consolidated handler does not search the storage again.
+/// @param zfile - The zarr file info structure
+/// @param key - The group key
+/// @param groups - The names of the subgroups
+/// @param vars - The names of the variables
+/// @return NO_ERROR on success, error code on failure
+extern int NCZMD_set_listing(struct NCZ_FILE_INFO *zfile, const char *key, NClist *groups, NClist *vars);
+
+/// @brief Discards the objects and listings read ahead
+/// @param zmd - Pointer to the metadata handler structure
+extern void NCZMD_prefetch_clear(NCZ_Metadata *zmd);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -129,6 +129,17 @@ static const NCZ_Metadata NCZ_csl_md2_table = {
 
 const NCZ_Metadata *NCZ_csl_metadata_handler2 = &NCZ_csl_md2_table;
 
+static void
+listing_names(const NCjson *jlisting, const char *which, NClist *names)
+{
+	size_t i;
+	const NCjson *jnames = NULL;
+	if (names == NULL || NCJdictget(jlisting, which, &jnames) || jnames == NULL)
+		return;
+	for (i = 0; i < NCJarraylength(jnames); i++)
+		nclistpush(names, strdup(NCJstring(NCJith(jnames, i))));
+}
+
 int NCZMD_v2_list_nodes(NCZ_FILE_INFO_T *zfile, const char * key, NClist *groups, NClist *variables)
 {
 	size_t i;
@@ -137,6 +148,18 @@ int NCZMD_v2_list_nodes(NCZ_FILE_INFO_T *zfile, const char * key, NClist *groups
 	char *zkey = NULL;
 	NClist *matches = nclistnew();
 
+	/* A listing read ahead at open */
+	if (zfile->metadata.jlistings != NULL)
+	{
+		const NCjson *jlisting = NULL;
+		if (NCJdictget(zfile->metadata.jlistings, key, &jlisting) == 0 && jlisting != NULL)
+		{
+			listing_names(jlisting, "groups", groups);
+			listing_names(jlisting, "arrays", variables);
+			goto done;
+		}
+	}
+
 	if ((stat = nczmap_search(zfile->map, key, matches)))
 		goto done;
 	for (i = 0; i < nclistlength(matches); i++)
@@ -267,6 +290,18 @@ int fetch_json_content_v2(NCZ_FILE_INFO_T *zfile, NCZMD_MetadataType zobj, const
 		goto done;
 	}
 
+	/* An object read ahead at open */
+	{
+		const NCjson *jtmp = NULL;
+		if (NCZMD_prefetched(zfile, key, &jtmp))
+		{
+			*jobj = NULL;
+			if (jtmp != NULL)
+				stat = NCJclone(jtmp, jobj);
+			goto done;
+		}
+	}
+
 	stat = NCZ_downloadjson(zfile->map, key, jobj);
 done:
 	nullfree(key);
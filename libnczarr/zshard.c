@@ -0,0 +1,839 @@
+/* Copyright 2018, University Corporation for Atmospheric
+ * Research. See COPYRIGHT file for copying and redistribution
+ * conditions. */
+
+/**
+ * @file @internal Sharded chunk storage.
+ *
+ * A sharded variable packs a block of its (inner) chunks into one
+ * storage object, the shard. The chunk cache still works in units of
+ * inner chunks; only the storage of the encoded chunks changes. The
+ * shard of the inner chunk with indices c is the one with indices
+ * c / chunks_per_shard, and its key is built from the shard indices
+ * exactly as an unsharded chunk key is built from the chunk indices.
+ *
+ * The layout of a shard is that of the Zarr version 3
+ * "sharding_indexed" codec with index_location "start" and no index
+ * checksum: the index, then the encoded inner chunks. The index has
+ * one (offset,nbytes) pair of little-endian uint64 per inner chunk of
+ * the shard, in C order; offsets are from the start of the shard, and
+ * a pair of all ones marks a chunk that was never written. Because the
+ * index is at a known place, a chunk is read with at most two ranged
+ * reads: the index (which is then cached) and the chunk itself.
+ *
+ * Written chunks are buffered per shard and a shard is written as a
+ * whole: as soon as all its chunks have been written, or when the
+ * buffered bytes exceed the max in-flight bytes, or when the chunk
+ * cache is flushed. Writing a shard of which only some chunks were
+ * buffered first reads back the rest of the existing shard.
+ */
+
+#include "zincludes.h"
+#include "zcache.h"
+#include "ncxcache.h"
+#include "ncexhash.h"
+
+#undef DEBUG
+
+/* Number of shard indexes kept loaded per variable */
+#define SHARDINDEXES 64
+
+/* Adjacent chunks of a shard are read with one request if
+   they are separated by no more than this many bytes */
+#define SHARDMAXGAP ((size64_t)64*1024)
+
+#define SHARDMISSING 0xffffffffffffffffULL
+
+/* An encoded chunk claiming more bytes than this is checked against
+   the size of its shard as soon as the index is read */
+#define SHARDMAXNBYTES(shards) (2*(shards)->cache->chunksize + SHARDMAXGAP)
+
+/* The loaded index of one shard */
+typedef struct NCZShardIndex {
+    NCxnode lru; /* must be first; see NCXUSER in ncxcache.h */
+    ncexhashkey_t hkey;
+    size64_t* shard; /* [rank] indices of the shard */
+    int exists; /* 0 => there is no shard object: all chunks are missing */
+    size64_t objsize; /* size of the shard object; 0 => not known */
+    size64_t* entries; /* [2*nchunks] (offset,nbytes) pairs */
+} NCZShardIndex;
+
+/* The chunks of one shard written since it was last stored */
+typedef struct NCZShardBuffer {
+    ncexhashkey_t hkey;
+    size64_t* shard; /* [rank] */
+    size_t nset; /* number of chunks buffered */
+    size64_t* sizes; /* [nchunks] */
+    void** chunks; /* [nchunks]; NULL => not buffered */
+} NCZShardBuffer;
+
+struct NCZShards {
+    NCZChunkCache* cache; /* backlink */
+    size_t rank;
+    size64_t chunks[NC_MAX_VAR_DIMS]; /* inner chunks per shard along each dimension */
+    size_t nchunks; /* inner chunks per shard */
+    size64_t indexsize; /* bytes */
+    NCxcache* indexes; /* LRU of loaded NCZShardIndex */
+    NCexhashmap* pending; /* shard hkey -> NCZShardBuffer* */
+    NClist* buffers; /* the NCZShardBuffers */
+    size64_t pendingbytes;
+    struct ShardStats {size64_t reads; size64_t indexreads; size64_t writes; size64_t readbacks;} stats;
+};
+
+/* A chunk to be read by NCZ_shard_readv */
+struct ShardRead {
+    size_t io; /* position in the caller's ios */
+    NCZShardIndex* index;
+    size64_t offset;
+    size64_t nbytes;
+};
+
+/* Forward */
+static int flushbuffers(NCZShards* shards, NClist* buffers);
+
+/**************************************************/
+/* Utilities */
+
+static void
+putle64(unsigned char* p, size64_t v)
+{
+    int i;
+    for(i=0;i<8;i++) {p[i] = (unsigned char)(v & 0xff); v >>= 8;}
+}
+
+static size64_t
+getle64(const unsigned char* p)
+{
+    int i;
+    size64_t v = 0;
+    for(i=7;i>=0;i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static NCZMAP*
+shardmap(NCZShards* shards)
+{
+    NC_FILE_INFO_T* file = (shards->cache->var->container)->nc4_info;
+    return ((NCZ_FILE_INFO_T*)file->format_file_info)->map;
+}
+
+/* Split chunk indices into the shard indices and the position
+   of the chunk in the shard index */
+static size_t
+locate(NCZShards* shards, const size64_t* indices, size64_t* shard)
+{
+    size_t r;
+    size64_t pos = 0;
+    for(r=0;r<shards->rank;r++) {
+        shard[r] = indices[r] / shards->chunks[r];
+        pos = (pos * shards->chunks[r]) + (indices[r] % shards->chunks[r]);
+    }
+    return (size_t)pos;
+}
+
+static ncexhashkey_t
+shardkey(NCZShards* shards, const size64_t* shard)
+{
+    return ncxcachekey(shard,sizeof(size64_t)*shards->rank);
+}
+
+static int
+sameshard(NCZShards* shards, const size64_t* s1, const size64_t* s2)
+{
+    return memcmp(s1,s2,sizeof(size64_t)*shards->rank) == 0;
+}
+
+/* The map key of a shard */
+static int
+shardpath(NCZShards* shards, const size64_t* shard, char** pathp)
+{
+    int stat = NC_NOERR;
+    struct ChunkKey key = {NULL,NULL};
+    if((stat = NCZ_buildchunkpath(shards->cache,shard,&key))) goto done;
+    if((*pathp = NCZ_chunkpath(key)) == NULL) stat = NC_ENOMEM;
+done:
+    nullfree(key.varkey);
+    nullfree(key.chunkkey);
+    return stat;
+}
+
+/**************************************************/
+/* Shard indexes */
+
+static NCZShardIndex*
+index_new(NCZShards* shards, const size64_t* shard)
+{
+    NCZShardIndex* index = NULL;
+    size_t i;
+    size_t size = sizeof(NCZShardIndex)
+                  + (shards->rank * sizeof(size64_t))
+                  + (2 * shards->nchunks * sizeof(size64_t));
+    if((index = calloc(1,size)) == NULL) return NULL;
+    index->entries = (size64_t*)(index+1);
+    index->shard = index->entries + (2 * shards->nchunks);
+    memcpy(index->shard,shard,shards->rank*sizeof(size64_t));
+    index->hkey = shardkey(shards,shard);
+    for(i=0;i<2*shards->nchunks;i++) index->entries[i] = SHARDMISSING;
+    return index;
+}
+
+/* Decode the index at the start of a shard of objsize bytes; every
+   chunk must lie after the index and, if objsize is known (not 0),
+   before the end of the shard. Otherwise a chunk running past the
+   end is reported by its own read. */
+static int
+index_decode(NCZShards* shards, NCZShardIndex* index, const unsigned char* raw, size64_t objsize)
+{
+    size_t i;
+    for(i=0;i<shards->nchunks;i++) {
+        size64_t offset = getle64(raw + (16*i));
+        size64_t nbytes = getle64(raw + (16*i) + 8);
+        if(offset == SHARDMISSING) nbytes = SHARDMISSING;
+        else if(offset < shards->indexsize || nbytes > SHARDMISSING - offset)
+            return NC_ENCZARR;
+        else if(objsize > 0 && (offset > objsize || nbytes > objsize - offset))
+            return NC_ENCZARR;
+        index->entries[2*i] = offset;
+        index->entries[2*i+1] = nbytes;
+    }
+    index->exists = 1;
+    index->objsize = objsize;
+    return NC_NOERR;
+}
+
+/* Return 1 if some chunk of a decoded index claims more bytes than
+   its encoding could take */
+static int
+index_oversized(NCZShards* shards, const NCZShardIndex* index)
+{
+    size_t i;
+    for(i=0;i<shards->nchunks;i++) {
+        if(index->entries[2*i] != SHARDMISSING && index->entries[2*i+1] > SHARDMAXNBYTES(shards))
+            return 1;
+    }
+    return 0;
+}
+
+static NCZShardIndex*
+index_lookup(NCZShards* shards, const size64_t* shard)
+{
+    void* obj = NULL;
+    if(ncxcachelookup(shards->indexes,shardkey(shards,shard),&obj) != NC_NOERR) return NULL;
+    if(!sameshard(shards,((NCZShardIndex*)obj)->shard,shard)) return NULL; /* hash collision */
+    (void)ncxcachetouch(shards->indexes,((NCZShardIndex*)obj)->hkey);
+    return (NCZShardIndex*)obj;
+}
+
+static void
+index_remove(NCZShards* shards, ncexhashkey_t hkey)
+{
+    void* obj = NULL;
+    if(ncxcacheremove(shards->indexes,hkey,&obj) == NC_NOERR) free(obj);
+}
+
+/* Insert an index, replacing any index with the same hash key
+   and evicting the least recently used ones if full */
+static int
+index_insert(NCZShards* shards, NCZShardIndex* index)
+{
+    index_remove(shards,index->hkey);
+    while(ncxcachecount(shards->indexes) >= SHARDINDEXES) {
+        NCZShardIndex* lru = (NCZShardIndex*)ncxcachelast(shards->indexes);
+        if(lru == NULL) break;
+        index_remove(shards,lru->hkey);
+    }
+    return ncxcacheinsert(shards->indexes,index->hkey,index);
+}
+
+/**************************************************/
+/* Write buffers */
+
+static NCZShardBuffer*
+buffer_lookup(NCZShards* shards, const size64_t* shard)
+{
+    uintptr_t data = 0;
+    if(shards->pending == NULL) return NULL;
+    if(ncexhashget(shards->pending,shardkey(shards,shard),&data) != NC_NOERR) return NULL;
+    return (NCZShardBuffer*)data;
+}
+
+static void
+buffer_free(NCZShards* shards, NCZShardBuffer* buf)
+{
+    size_t i;
+    if(buf == NULL) return;
+    for(i=0;i<shards->nchunks;i++) nullfree(buf->chunks[i]);
+    free(buf);
+}
+
+/* Detach a buffer from the pending set */
+static void
+buffer_detach(NCZShards* shards, NCZShardBuffer* buf)
+{
+    uintptr_t data = 0;
+    size_t i;
+    (void)ncexhashremove(shards->pending,buf->hkey,&data);
+    for(i=0;i<nclistlength(shards->buffers);i++) {
+        if(nclistget(shards->buffers,i) == buf) {nclistremove(shards->buffers,i); break;}
+    }
+    for(i=0;i<shards->nchunks;i++)
+        if(buf->chunks[i] != NULL) shards->pendingbytes -= buf->sizes[i];
+}
+
+static int
+buffer_new(NCZShards* shards, const size64_t* shard, NCZShardBuffer** bufp)
+{
+    int stat = NC_NOERR;
+    NCZShardBuffer* buf = NULL;
+    size_t size = sizeof(NCZShardBuffer)
+                  + (shards->nchunks * (sizeof(void*) + sizeof(size64_t)))
+                  + (shards->rank * sizeof(size64_t));
+
+    if(shards->pending == NULL) {
+        if((shards->pending = ncexhashnew(0)) == NULL) {stat = NC_ENOMEM; goto done;}
+    }
+    if((buf = calloc(1,size)) == NULL) {stat = NC_ENOMEM; goto done;}
+    buf->chunks = (void**)(buf+1);
+    buf->sizes = (size64_t*)(buf->chunks + shards->nchunks);
+    buf->shard = buf->sizes + shards->nchunks;
+    memcpy(buf->shard,shard,shards->rank*sizeof(size64_t));
+    buf->hkey = shardkey(shards,shard);
+    /* A different shard with the same hash key must be stored first */
+    {
+        uintptr_t data = 0;
+        if(ncexhashget(shards->pending,buf->hkey,&data) == NC_NOERR) {
+            NClist* one = nclistnew();
+            buffer_detach(shards,(NCZShardBuffer*)data);
+            nclistpush(one,(void*)data);
+            stat = flushbuffers(shards,one);
+            nclistfree(one);
+            if(stat) goto done;
+        }
+    }
+    if((stat = ncexhashput(shards->pending,buf->hkey,(uintptr_t)buf))) goto done;
+    nclistpush(shards->buffers,buf);
+    *bufp = buf; buf = NULL;
+done:
+    nullfree(buf);
+    return stat;
+}
+
+/* Build the new contents of a shard from its buffer and,
+   if given, the old contents */
+static int
+assemble(NCZShards* shards, NCZShardBuffer* buf, NCZShardIndex* oldindex,
+         const unsigned char* old, size64_t oldsize, NCZShardIndex* newindex,
+         size64_t* sizep, unsigned char** contentp)
+{
+    int stat = NC_NOERR;
+    size_t i;
+    size64_t total = shards->indexsize;
+    size64_t pos;
+    unsigned char* content = NULL;
+
+    for(i=0;i<shards->nchunks;i++) {
+        if(buf->chunks[i] != NULL)
+            total += buf->sizes[i];
+        else if(oldindex != NULL && oldindex->entries[2*i] != SHARDMISSING) {
+            if(oldindex->entries[2*i] + oldindex->entries[2*i+1] > oldsize)
+                {stat = NC_ENCZARR; goto done;}
+            total += oldindex->entries[2*i+1];
+        }
+    }
+    if((content = malloc((size_t)total)) == NULL) {stat = NC_ENOMEM; goto done;}
+    pos = shards->indexsize;
+    for(i=0;i<shards->nchunks;i++) {
+        const unsigned char* src = NULL;
+        size64_t nbytes = 0;
+        if(buf->chunks[i] != NULL) {
+            src = buf->chunks[i]; nbytes = buf->sizes[i];
+        } else if(oldindex != NULL && oldindex->entries[2*i] != SHARDMISSING) {
+            src = old + oldindex->entries[2*i]; nbytes = oldindex->entries[2*i+1];
+        }
+        if(src == NULL) {
+            newindex->entries[2*i] = SHARDMISSING;
+            newindex->entries[2*i+1] = SHARDMISSING;
+        } else {
+            memcpy(content+pos,src,(size_t)nbytes);
+            newindex->entries[2*i] = pos;
+            newindex->entries[2*i+1] = nbytes;
+            pos += nbytes;
+        }
+        putle64(content + (16*i),newindex->entries[2*i]);
+        putle64(content + (16*i) + 8,newindex->entries[2*i+1]);
+    }
+    newindex->exists = 1;
+    newindex->objsize = total;
+    *sizep = total;
+    *contentp = content; content = NULL;
+done:
+    nullfree(content);
+    return stat;
+}
+
+/* Store a set of buffers, which have been detached from the pending
+   set; the buffers are freed. Shards of which only some chunks
+   were buffered are read back first, all in one batch; the shards
+   are then written in one batch. */
+static int
+flushbuffers(NCZShards* shards, NClist* buffers)
+{
+    int stat = NC_NOERR;
+    size_t i, n = nclistlength(buffers);
+    NCZMAP* map = shardmap(shards);
+    NCZMAPIO* olds = NULL;
+    NCZMAPIO* news = NULL;
+    NCZShardIndex** newindexes = NULL;
+    size_t nold = 0;
+
+    if(n == 0) goto done;
+    if((olds = calloc(n,sizeof(NCZMAPIO))) == NULL
+       || (news = calloc(n,sizeof(NCZMAPIO))) == NULL
+       || (newindexes = calloc(n,sizeof(NCZShardIndex*))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+
+    /* Read back the partially rewritten shards, unless known not to exist */
+    for(i=0;i<n;i++) {
+        NCZShardBuffer* buf = nclistget(buffers,i);
+        NCZShardIndex* index = NULL;
+        olds[i].stat = NC_EEMPTY;
+        if(buf->nset == shards->nchunks) continue;
+        if((index = index_lookup(shards,buf->shard)) != NULL && !index->exists) continue;
+        if((stat = shardpath(shards,buf->shard,(char**)&olds[i].key))) goto done;
+        nold++;
+    }
+    if(nold > 0) {
+        /* readv needs a dense array */
+        NCZMAPIO* ios = NULL;
+        size_t k = 0;
+        if((ios = calloc(nold,sizeof(NCZMAPIO))) == NULL) {stat = NC_ENOMEM; goto done;}
+        for(i=0;i<n;i++) if(olds[i].key != NULL) ios[k++].key = olds[i].key;
+        stat = nczmap_readv(map,nold,ios);
+        for(k=0,i=0;i<n;i++) {
+            if(olds[i].key == NULL) continue;
+            olds[i].content = ios[k].content;
+            olds[i].count = ios[k].count;
+            olds[i].stat = ios[k].stat;
+            k++;
+        }
+        free(ios);
+        if(stat) goto done;
+        shards->stats.readbacks += nold;
+    }
+
+    /* Assemble the new shards */
+    for(i=0;i<n;i++) {
+        NCZShardBuffer* buf = nclistget(buffers,i);
+        NCZShardIndex* oldindex = NULL;
+        unsigned char* content = NULL;
+        switch(olds[i].stat) {
+        case NC_NOERR:
+            if(olds[i].count < shards->indexsize) {stat = NC_ENCZARR; goto done;}
+            if((oldindex = index_new(shards,buf->shard)) == NULL) {stat = NC_ENOMEM; goto done;}
+            if((stat = index_decode(shards,oldindex,olds[i].content,olds[i].count))) {free(oldindex); goto done;}
+            break;
+        case NC_EEMPTY: case NC_ENOOBJECT: break;
+        default: stat = olds[i].stat; goto done;
+        }
+        if((newindexes[i] = index_new(shards,buf->shard)) == NULL) {nullfree(oldindex); stat = NC_ENOMEM; goto done;}
+        stat = assemble(shards,buf,oldindex,olds[i].content,olds[i].count,newindexes[i],&news[i].count,&content);
+        nullfree(oldindex);
+        if(stat) goto done;
+        news[i].content = content;
+        if((stat = shardpath(shards,buf->shard,(char**)&news[i].key))) goto done;
+    }
+
+    /* Write them */
+    if((stat = nczmap_writev(map,n,news))) goto done;
+    for(i=0;i<n;i++) {
+        if(news[i].stat) {stat = news[i].stat; break;}
+        shards->stats.writes++;
+    }
+    /* Either way, the cached indexes must go, since the shards may have changed */
+    for(i=0;i<n;i++) {
+        if(stat == NC_NOERR) {
+            if((stat = index_insert(shards,newindexes[i]))) goto done;
+            newindexes[i] = NULL;
+        } else
+            index_remove(shards,newindexes[i]->hkey);
+    }
+
+done:
+    for(i=0;i<n;i++) {
+        if(olds != NULL) {nullfree((char*)olds[i].key); nullfree(olds[i].content);}
+        if(news != NULL) {nullfree((char*)news[i].key); nullfree(news[i].content);}
+        if(newindexes != NULL) nullfree(newindexes[i]);
+        buffer_free(shards,nclistget(buffers,i));
+    }
+    nclistclear(buffers);
+    nullfree(olds);
+    nullfree(news);
+    nullfree(newindexes);
+    return stat;
+}
+
+/**************************************************/
+/* API */
+
+/**
+ * Create the shard store of a chunk cache.
+ *
+ * @param cache the chunk cache of the variable
+ * @param shardchunks [cache->ndims] number of chunks per shard along each dimension
+ * @param shardsp return the shard store
+ * @return NC_NOERR|NC_EXXX
+ */
+int
+NCZ_shard_create(NCZChunkCache* cache, const size64_t* shardchunks, NCZShards** shardsp)
+{
+    int stat = NC_NOERR;
+    NCZShards* shards = NULL;
+    size_t r;
+
+    if(cache->ndims == 0 || cache->ndims > NC_MAX_VAR_DIMS) return NC_EINVAL;
+    if((shards = calloc(1,sizeof(NCZShards))) == NULL) {stat = NC_ENOMEM; goto done;}
+    shards->cache = cache;
+    shards->rank = (size_t)cache->ndims;
+    shards->nchunks = 1;
+    for(r=0;r<shards->rank;r++) {
+        if(shardchunks[r] == 0) {stat = NC_EINVAL; goto done;}
+        shards->chunks[r] = shardchunks[r];
+        shards->nchunks *= (size_t)shardchunks[r];
+    }
+    shards->indexsize = 16 * (size64_t)shards->nchunks;
+    if((stat = ncxcachenew(SHARDINDEXES,&shards->indexes))) goto done;
+    if((shards->buffers = nclistnew()) == NULL) {stat = NC_ENOMEM; goto done;}
+    *shardsp = shards; shards = NULL;
+done:
+    NCZ_shard_free(shards);
+    return stat;
+}
+
+/**
+ * Free a shard store; any buffered chunks are discarded,
+ * so call NCZ_shard_flush first.
+ */
+void
+NCZ_shard_free(NCZShards* shards)
+{
+    size_t i;
+    NCZShardIndex* index = NULL;
+
+    if(shards == NULL) return;
+    {
+	NCZ_FILE_INFO_T* zfile = (NCZ_FILE_INFO_T*)shards->cache->var->container->nc4_info->format_file_info;
+	if(zfile != NULL && (zfile->controls.flags & FLAG_SHOWCACHE)) {
+	    /* Shown whatever the log level, which is left as it was */
+	    int level = ncsetloglevel(NCLOGNOTE);
+	    nclog(NCLOGNOTE,"shards: var=%s reads=%llu indexreads=%llu writes=%llu readbacks=%llu",
+		shards->cache->var->hdr.name,shards->stats.reads,shards->stats.indexreads,
+		shards->stats.writes,shards->stats.readbacks);
+	    ncsetloglevel(level);
+	}
+    }
+    for(i=0;i<nclistlength(shards->buffers);i++)
+        buffer_free(shards,nclistget(shards->buffers,i));
+    nclistfree(shards->buffers);
+    ncexhashmapfree(shards->pending);
+    if(shards->indexes != NULL) {
+        while((index = (NCZShardIndex*)ncxcachelast(shards->indexes)) != NULL)
+            index_remove(shards,index->hkey);
+        ncxcachefree(shards->indexes);
+    }
+    free(shards);
+}
+
+/**
+ * Read a set of encoded inner chunks. Chunks still buffered are
+ * copied from the buffer; the indexes of the shards involved that
+ * are not loaded are read in one batch; then the chunks are read
+ * in one batch, adjacent chunks of a shard with a single ranged read.
+ *
+ * @param shards the shard store
+ * @param n number of chunks
+ * @param indices n*rank chunk indices
+ * @param ios [n] on return, as for a whole-object nczmap_readv:
+ * content (malloc'd), count and stat (NC_EEMPTY if never written)
+ * @return NC_NOERR unless the batch as a whole failed
+ */
+int
+NCZ_shard_readv(NCZShards* shards, size_t n, const size64_t* indices, NCZMAPIO* ios)
+{
+    int stat = NC_NOERR;
+    size_t i, j, nreads = 0, nload = 0, nspans = 0;
+    size_t rank = shards->rank;
+    NCZMAP* map = shardmap(shards);
+    struct ShardRead* reads = NULL;
+    struct ShardRead** order = NULL;
+    NCZShardIndex** loads = NULL; /* indexes read by this call */
+    NCZMAPIO* lios = NULL;
+    NCZMAPIO* spans = NULL;
+    size_t* spanof = NULL;
+    size64_t* shard = NULL;
+    size64_t objsize;
+
+    if(n == 0) goto done;
+    if((reads = calloc(n,sizeof(struct ShardRead))) == NULL
+       || (loads = calloc(n,sizeof(NCZShardIndex*))) == NULL
+       || (shard = calloc(n*rank,sizeof(size64_t))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+
+    /* Serve the buffered chunks and find the indexes to load */
+    for(i=0;i<n;i++) {
+        size64_t* si = shard + (i*rank);
+        size_t pos = locate(shards,indices + (i*rank),si);
+        NCZShardBuffer* buf = buffer_lookup(shards,si);
+        NCZShardIndex* index = NULL;
+
+        ios[i].content = NULL;
+        ios[i].count = 0;
+        ios[i].stat = NC_NOERR;
+        if(buf != NULL && sameshard(shards,buf->shard,si) && buf->chunks[pos] != NULL) {
+            if((ios[i].content = malloc((size_t)buf->sizes[pos])) == NULL) {stat = NC_ENOMEM; goto done;}
+            memcpy(ios[i].content,buf->chunks[pos],(size_t)buf->sizes[pos]);
+            ios[i].count = buf->sizes[pos];
+            continue;
+        }
+        if((index = index_lookup(shards,si)) == NULL) {
+            for(j=0;j<nload;j++)
+                if(sameshard(shards,loads[j]->shard,si)) {index = loads[j]; break;}
+        }
+        if(index == NULL) {
+            if((index = index_new(shards,si)) == NULL) {stat = NC_ENOMEM; goto done;}
+            loads[nload++] = index;
+        }
+        reads[nreads].io = i;
+        reads[nreads].index = index;
+        reads[nreads].offset = pos; /* until the index is loaded */
+        nreads++;
+    }
+
+    /* Load the indexes */
+    if(nload > 0) {
+        if((lios = calloc(nload,sizeof(NCZMAPIO))) == NULL) {stat = NC_ENOMEM; goto done;}
+        for(j=0;j<nload;j++) {
+            if((stat = shardpath(shards,loads[j]->shard,(char**)&lios[j].key))) goto done;
+            lios[j].start = 0;
+            lios[j].count = shards->indexsize;
+            if((lios[j].content = malloc((size_t)shards->indexsize)) == NULL) {stat = NC_ENOMEM; goto done;}
+        }
+        if((stat = nczmap_readv(map,nload,lios))) goto done;
+        shards->stats.indexreads += nload;
+        for(j=0;j<nload;j++) {
+            switch(lios[j].stat) {
+            case NC_NOERR:
+                /* Only the index was read, so the size of the object
+                   is not known; it is only asked for (a HEAD request
+                   on S3) if the index is implausible */
+                if((stat = index_decode(shards,loads[j],lios[j].content,0))) goto done;
+                if(index_oversized(shards,loads[j])) {
+                    if((stat = nczmap_len(map,lios[j].key,&objsize))) goto done;
+                    if((stat = index_decode(shards,loads[j],lios[j].content,objsize))) goto done;
+                }
+                break;
+            case NC_EEMPTY: case NC_ENOOBJECT: loads[j]->exists = 0; break;
+            default: stat = lios[j].stat; goto done;
+            }
+        }
+    }
+
+    /* Locate the chunks; drop the missing ones */
+    for(j=0,i=0;i<nreads;i++) {
+        struct ShardRead* rd = &reads[i];
+        size_t pos = (size_t)rd->offset;
+        if(!rd->index->exists || rd->index->entries[2*pos] == SHARDMISSING) {
+            ios[rd->io].stat = NC_EEMPTY;
+            continue;
+        }
+        rd->offset = rd->index->entries[2*pos];
+        rd->nbytes = rd->index->entries[2*pos+1];
+        reads[j++] = *rd;
+    }
+    nreads = j;
+
+    if(nreads > 0) {
+        /* Order the reads by shard and offset, so adjacent chunks can be coalesced */
+        if((order = calloc(nreads,sizeof(struct ShardRead*))) == NULL
+           || (spanof = calloc(nreads,sizeof(size_t))) == NULL
+           || (spans = calloc(nreads,sizeof(NCZMAPIO))) == NULL)
+            {stat = NC_ENOMEM; goto done;}
+        for(i=0;i<nreads;i++) {
+            /* insertion sort: batches are small and mostly in order already */
+            struct ShardRead* rd = &reads[i];
+            for(j=i;j>0;j--) {
+                struct ShardRead* prev = order[j-1];
+                int c = memcmp(prev->index->shard,rd->index->shard,sizeof(size64_t)*rank);
+                if(c < 0 || (c == 0 && prev->offset <= rd->offset)) break;
+                order[j] = prev;
+            }
+            order[j] = rd;
+        }
+        for(i=0;i<nreads;i++) {
+            struct ShardRead* rd = order[i];
+            NCZMAPIO* span = (nspans > 0 ? &spans[nspans-1] : NULL);
+            if(span != NULL && order[i-1]->index == rd->index
+               && rd->offset >= span->start
+               && rd->offset <= span->start + span->count + SHARDMAXGAP) {
+                size64_t end = rd->offset + rd->nbytes;
+                if(end > span->start + span->count) span->count = end - span->start;
+            } else {
+                span = &spans[nspans++];
+                if((stat = shardpath(shards,rd->index->shard,(char**)&span->key))) goto done;
+                span->start = rd->offset;
+                span->count = rd->nbytes;
+            }
+            spanof[i] = nspans-1;
+        }
+        for(i=0;i<nspans;i++) {
+            if((spans[i].content = malloc(spans[i].count > 0 ? (size_t)spans[i].count : 1)) == NULL)
+                {stat = NC_ENOMEM; goto done;}
+        }
+        if((stat = nczmap_readv(map,nspans,spans))) goto done;
+        shards->stats.reads += nspans;
+        for(i=0;i<nreads;i++) {
+            struct ShardRead* rd = order[i];
+            NCZMAPIO* span = &spans[spanof[i]];
+            NCZMAPIO* io = &ios[rd->io];
+            if(span->stat) {
+                /* A range past the end of the shard: its index is wrong */
+                switch(span->stat) {
+                case NC_EEMPTY: case NC_EEDGE: case NC_EINTERNAL: io->stat = NC_ENCZARR; break;
+                default: io->stat = span->stat; break;
+                }
+                continue;
+            }
+            if((io->content = malloc(rd->nbytes > 0 ? (size_t)rd->nbytes : 1)) == NULL) {stat = NC_ENOMEM; goto done;}
+            memcpy(io->content,(unsigned char*)span->content + (rd->offset - span->start),(size_t)rd->nbytes);
+            io->count = rd->nbytes;
+        }
+    }
+
+    /* Keep the loaded indexes */
+    for(j=0;j<nload;j++) {
+        if((stat = index_insert(shards,loads[j]))) goto done;
+        loads[j] = NULL;
+    }
+
+done:
+    if(stat) {
+        for(i=0;i<n;i++) {nullfree(ios[i].content); ios[i].content = NULL;}
+    }
+    if(lios != NULL) {
+        for(j=0;j<nload;j++) {nullfree((char*)lios[j].key); nullfree(lios[j].content);}
+        free(lios);
+    }
+    if(spans != NULL) {
+        for(i=0;i<nspans;i++) {nullfree((char*)spans[i].key); nullfree(spans[i].content);}
+        free(spans);
+    }
+    if(loads != NULL) {
+        for(j=0;j<nload;j++) nullfree(loads[j]);
+        free(loads);
+    }
+    nullfree(reads);
+    nullfree(order);
+    nullfree(spanof);
+    nullfree(shard);
+    return stat;
+}
+
+/**
+ * Read one encoded inner chunk.
+ *
+ * @param shards the shard store
+ * @param indices the chunk indices
+ * @param sizep return the size of the chunk
+ * @param datap return the chunk (malloc'd)
+ * @return NC_NOERR|NC_EEMPTY|NC_EXXX
+ */
+int
+NCZ_shard_read(NCZShards* shards, const size64_t* indices, size64_t* sizep, void** datap)
+{
+    int stat = NC_NOERR;
+    NCZMAPIO io;
+
+    memset(&io,0,sizeof(io));
+    if((stat = NCZ_shard_readv(shards,1,indices,&io))) return stat;
+    if((stat = io.stat)) return stat;
+    if(sizep) *sizep = io.count;
+    if(datap) *datap = io.content; else free(io.content);
+    return NC_NOERR;
+}
+
+/**
+ * Buffer one encoded inner chunk for writing; the data is copied.
+ * A shard is written as soon as all its chunks are buffered; all
+ * the buffered shards are written when the buffered bytes exceed
+ * the max in-flight bytes.
+ *
+ * @param shards the shard store
+ * @param indices the chunk indices
+ * @param size size of the chunk
+ * @param data the chunk
+ * @return NC_NOERR|NC_EXXX
+ */
+int
+NCZ_shard_write(NCZShards* shards, const size64_t* indices, size64_t size, const void* data)
+{
+    int stat = NC_NOERR;
+    NCglobalstate* ngs = NC_getglobalstate();
+    size64_t shard[NC_MAX_VAR_DIMS];
+    size_t pos = locate(shards,indices,shard);
+    NCZShardBuffer* buf = buffer_lookup(shards,shard);
+    void* copy = NULL;
+
+    if(buf != NULL && !sameshard(shards,buf->shard,shard)) buf = NULL; /* buffer_new deals with it */
+    if(buf == NULL) {
+        if((stat = buffer_new(shards,shard,&buf))) goto done;
+    }
+    if((copy = malloc(size > 0 ? (size_t)size : 1)) == NULL) {stat = NC_ENOMEM; goto done;}
+    memcpy(copy,data,(size_t)size);
+    if(buf->chunks[pos] != NULL) {
+        shards->pendingbytes -= buf->sizes[pos];
+        free(buf->chunks[pos]);
+    } else
+        buf->nset++;
+    buf->chunks[pos] = copy; copy = NULL;
+    buf->sizes[pos] = size;
+    shards->pendingbytes += size;
+
+    if(buf->nset == shards->nchunks) {
+        /* complete: nothing to read back */
+        NClist* one = nclistnew();
+        buffer_detach(shards,buf);
+        nclistpush(one,buf);
+        stat = flushbuffers(shards,one);
+        nclistfree(one);
+    } else if(ngs->zarr.maxinflight > 0 && shards->pendingbytes > ngs->zarr.maxinflight)
+        stat = NCZ_shard_flush(shards);
+done:
+    nullfree(copy);
+    return stat;
+}
+
+/**
+ * Write all the buffered shards.
+ *
+ * @param shards the shard store
+ * @return NC_NOERR|NC_EXXX
+ */
+int
+NCZ_shard_flush(NCZShards* shards)
+{
+    int stat = NC_NOERR;
+    NClist* buffers = NULL;
+    size_t i;
+
+    if(shards == NULL || nclistlength(shards->buffers) == 0) return NC_NOERR;
+    buffers = shards->buffers;
+    if((shards->buffers = nclistnew()) == NULL) {shards->buffers = buffers; return NC_ENOMEM;}
+    for(i=0;i<nclistlength(buffers);i++) {
+        uintptr_t data = 0;
+        NCZShardBuffer* buf = nclistget(buffers,i);
+        (void)ncexhashremove(shards->pending,buf->hkey,&data);
+    }
+    shards->pendingbytes = 0;
+    stat = flushbuffers(shards,buffers);
+    nclistfree(buffers);
+    return stat;
+}
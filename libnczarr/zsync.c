@@ -30,8 +30,9 @@ static int parse_group_content(const NCjson* jcontent, NClist* dimdefs, NClist*
 static int parse_group_content_pure(NCZ_FILE_INFO_T*  zinfo, NC_GRP_INFO_T* grp, NClist* varnames, NClist* subgrps);
 static int define_grp(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp);
 static int define_dims(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, NClist* diminfo);
-static int define_vars(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, NClist* varnames);
-static int define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname);
+static int define_vars(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, NClist* varnames, int lazy);
+static int define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname, int lazy);
+static int define_var_meta(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, int* suppressp);
 static int define_subgrps(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, NClist* subgrpnames);
 static int searchvars(NCZ_FILE_INFO_T*, NC_GRP_INFO_T*, NClist*);
 static int searchsubgrps(NCZ_FILE_INFO_T*, NC_GRP_INFO_T*, NClist*);
@@ -49,6 +50,7 @@ static int upload_attrs(NC_FILE_INFO_T* file, NC_OBJ* container, NCjson* jatts);
 static int getnczarrkey(NC_OBJ* container, const char* name, const NCjson** jncxxxp);
 static int downloadzarrobj(NC_FILE_INFO_T*, struct ZARROBJ* zobj, const char* fullpath, const char* objname);
 static int dictgetalt(const NCjson* jdict, const char* name, const char* alt, const NCjson** jvaluep);
+static int prefetch_tree(NC_FILE_INFO_T* file);
 
 /**************************************************/
 /**************************************************/
@@ -310,6 +312,7 @@ ncz_sync_var_meta(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, int isclose)
     NCjson* jfill = NULL;
     NCjson* jatts = NULL;
     NCjson* jtypes = NULL;
+    NCjson* jshard = NULL;
     char* dtypename = NULL;
     int purezarr = 0;
     size64_t shape[NC_MAX_VAR_DIMS];
@@ -524,6 +527,22 @@ ncz_sync_var_meta(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, int isclose)
 	NCJnewstring(NCJ_STRING,"chunked",&jtmp);
 	if((stat = NCJinsert(jncvar,"storage",jtmp))<0) {stat = NC_EINVAL; goto done;}
 	jtmp = NULL;
+	/* Record the sharding; see zshard.c */
+	if(zvar->shardchunks != NULL) {
+	    NCJnew(NCJ_DICT,&jshard);
+	    NCJnew(NCJ_ARRAY,&jtmp);
+	    for(i=0;i<var->ndims;i++) {
+		snprintf(number,sizeof(number),"%llu",zvar->shardchunks[i]);
+		NCJaddstring(jtmp,NCJ_INT,number);
+	    }
+	    if((stat = NCJinsert(jshard,"chunks_per_shard",jtmp))<0) {stat = NC_EINVAL; goto done;}
+	    jtmp = NULL;
+	    NCJnewstring(NCJ_STRING,"start",&jtmp);
+	    if((stat = NCJinsert(jshard,"index_location",jtmp))<0) {stat = NC_EINVAL; goto done;}
+	    jtmp = NULL;
+	    if((stat = NCJinsert(jncvar,"sharding",jshard))<0) {stat = NC_EINVAL; goto done;}
+	    jshard = NULL;
+	}
     }
 
     /* Build .zattrs object */
@@ -563,6 +582,7 @@ done:
     NCJreclaim(jfill);
     NCJreclaim(jatts);
     NCJreclaim(jtypes);
+    NCJreclaim(jshard);
     return ZUNTRACE(THROW(stat));
 }
 
@@ -584,7 +604,13 @@ ncz_sync_var(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, int isclose)
 
     ZTRACE(3,"file=%s var=%s isclose=%d",file->controller->path,var->hdr.name,isclose);
 
+    /* A var whose metadata was never read has not changed */
+    if(!var->meta_read) goto done;
+
     if(isclose) {
+	/* The .zattrs is rewritten from var->att */
+	if(!var->atts_read)
+	    {if((stat = ncz_read_atts(file,(NC_OBJ*)var))) goto done;}
 	if((stat = ncz_sync_var_meta(file,var,isclose))) goto done;
     }
 
@@ -1081,15 +1107,219 @@ ncz_read_file(NC_FILE_INFO_T* file)
     
     /* _nczarr should already have been read in ncz_open_dataset */
 
+    /* Without consolidated metadata, read the metadata of the
+       tree ahead, a level at a time */
+    if((stat = prefetch_tree(file)))
+	goto done;
+
     /* Now load the groups starting with root */
     if((stat = define_grp(file,file->root_grp)))
 	goto done;
 
 done:
+    NCZMD_prefetch_clear(&((NCZ_FILE_INFO_T*)file->format_file_info)->metadata);
     NCJreclaim(json);
     return ZUNTRACE(stat);
 }
 
+/* A group, or a child of a group found by a search that
+   may be a group or an array */
+struct PrefetchNode {
+    char* key;
+    char* name;
+    struct PrefetchNode* parent; /* set if found by a search of the parent */
+    int searched; /* the children were found by a search */
+    int incomplete; /* some children could not be classified */
+    NClist* groups; /* if searched, names of the subgroups */
+    NClist* arrays; /* if searched, names of the arrays */
+};
+
+static void
+prefetch_freelevel(NClist* level)
+{
+    size_t i;
+    for(i=0;i<nclistlength(level);i++) {
+	struct PrefetchNode* node = (struct PrefetchNode*)nclistget(level,i);
+	nullfree(node->key);
+	nullfree(node->name);
+	nclistfreeall(node->groups);
+	nclistfreeall(node->arrays);
+	free(node);
+    }
+    nclistfree(level);
+}
+
+static int
+prefetch_addnode(NClist* level, struct PrefetchNode* parent, const char* parentkey, const char* name)
+{
+    int stat = NC_NOERR;
+    struct PrefetchNode* node = NULL;
+
+    if((node = calloc(1,sizeof(struct PrefetchNode))) == NULL) {stat = NC_ENOMEM; goto done;}
+    if(parentkey == NULL)
+	node->key = strdup(name);
+    else if((stat = nczm_concat(parentkey,name,&node->key))) goto done;
+    if(node->key == NULL || (node->name = strdup(name)) == NULL) {stat = NC_ENOMEM; goto done;}
+    node->parent = parent;
+    nclistpush(level,node);
+    node = NULL;
+done:
+    if(node != NULL) {nullfree(node->key); free(node);}
+    return stat;
+}
+
+/* Look up .zxxx of a node in the objects read ahead;
+   return 0 if it was not read (e.g. it failed to parse) */
+static int
+prefetch_lookup(NCZ_FILE_INFO_T* zinfo, const char* prefix, const char* suffix, const NCjson** jsonp)
+{
+    char* key = NULL;
+    int found = 0;
+    *jsonp = NULL;
+    if(nczm_concat(prefix,suffix,&key) == NC_NOERR)
+	found = NCZMD_prefetched(zinfo,key,jsonp);
+    nullfree(key);
+    return found;
+}
+
+/* Push .zxxx of a node onto a list of keys */
+static int
+prefetch_pushkey(NClist* keys, const char* prefix, const char* suffix)
+{
+    int stat = NC_NOERR;
+    char* key = NULL;
+    if((stat = nczm_concat(prefix,suffix,&key))) return stat;
+    nclistpush(keys,key);
+    return stat;
+}
+
+/**
+ * @internal Read the metadata objects of the group tree ahead of
+ * define_grp. The tree is walked breadth first: the .zgroup and
+ * .zattrs (and .zarray, for the children found by a search) of all
+ * the nodes of a level are read with one batched map read
+ * (NCZMD_prefetch), so the number of round trips grows with the depth
+ * of the tree rather than with the number of groups. The children of
+ * an NCZarr group come from its _nczarr_group attribute; those of a
+ * pure Zarr group come from a search of the storage, and the listing
+ * is recorded so that define_grp does not repeat it. The arrays of an
+ * NCZarr group are read lazily and are not read ahead. Everything read
+ * ahead is discarded once the tree is built; an object that cannot be
+ * read or parsed is read again by define_grp, which reports the error.
+ *
+ * @param file Pointer to file info struct.
+ *
+ * @return ::NC_NOERR No error.
+ */
+static int
+prefetch_tree(NC_FILE_INFO_T* file)
+{
+    int stat = NC_NOERR;
+    size_t i,j;
+    NCZ_FILE_INFO_T* zinfo = (NCZ_FILE_INFO_T*)file->format_file_info;
+    NCglobalstate* ngs = NC_getglobalstate();
+    int purezarr = (zinfo->controls.flags & FLAG_PUREZARR)?1:0;
+    char* rootkey = NULL;
+    NClist* prev = NULL;
+    NClist* level = nclistnew();
+    NClist* keys = nclistnew();
+    NClist* matches = nclistnew();
+
+    ZTRACE(3,"file=%s",file->controller->path);
+
+    if(zinfo->metadata.jcsl != NULL || zinfo->metadata.zarr_format != ZARRFORMAT2
+       || ngs->zarr.metaprefetch == 0)
+	goto done;
+
+    if((stat = NCZ_grpkey(file->root_grp,&rootkey))) goto done;
+    if((stat = prefetch_addnode(level,NULL,NULL,rootkey))) goto done;
+
+    while(nclistlength(level) > 0) {
+	NClist* next = nclistnew();
+	/* Read the objects of this level */
+	nclistclearall(keys);
+	for(i=0;i<nclistlength(level);i++) {
+	    struct PrefetchNode* node = (struct PrefetchNode*)nclistget(level,i);
+	    if((stat = prefetch_pushkey(keys,node->key,Z2GROUP))
+	       || (stat = prefetch_pushkey(keys,node->key,Z2ATTRS))) break;
+	    if(node->parent != NULL
+	       && (stat = prefetch_pushkey(keys,node->key,Z2ARRAY))) break;
+	}
+	if(stat == NC_NOERR)
+	    stat = NCZMD_prefetch(zinfo,keys,ngs->zarr.metaprefetch);
+	/* Find the children of the groups of this level */
+	for(i=0;stat == NC_NOERR && i<nclistlength(level);i++) {
+	    struct PrefetchNode* node = (struct PrefetchNode*)nclistget(level,i);
+	    const NCjson* jgroup = NULL;
+	    const NCjson* jattrs = NULL;
+	    const NCjson* jarray = NULL;
+	    const NCjson* jnczgrp = NULL;
+	    const NCjson* jsubgrps = NULL;
+	    int known = prefetch_lookup(zinfo,node->key,Z2GROUP,&jgroup);
+	    known = prefetch_lookup(zinfo,node->key,Z2ATTRS,&jattrs) && known;
+	    if(node->parent != NULL) { /* found by a search */
+		if(!prefetch_lookup(zinfo,node->key,Z2ARRAY,&jarray)
+		   || !prefetch_lookup(zinfo,node->key,Z2GROUP,&jgroup))
+		    {node->parent->incomplete = 1; continue;}
+		if(jarray != NULL)
+		    nclistpush(node->parent->arrays,strdup(node->name));
+		if(jgroup == NULL) continue; /* not a group */
+		nclistpush(node->parent->groups,strdup(node->name));
+	    }
+	    if(!known) continue; /* left to define_grp */
+	    if(purezarr || jgroup == NULL || jattrs == NULL) {
+		/* As in parse_group_content_pure */
+		node->searched = 1;
+		node->groups = nclistnew();
+		node->arrays = nclistnew();
+		nclistclearall(matches);
+		if((stat = nczmap_search(zinfo->map,node->key,matches))) break;
+		for(j=0;j<nclistlength(matches);j++) {
+		    const char* name = (const char*)nclistget(matches,j);
+		    if(name[0] == NCZM_DOT) continue;
+		    if((stat = prefetch_addnode(next,node,node->key,name))) break;
+		}
+	    } else {
+		/* As in getnczarrkey and parse_group_content */
+		if(NCJdictget(jattrs,NCZ_V2_GROUP,&jnczgrp) || jnczgrp == NULL)
+		    (void)NCJdictget(jgroup,NCZ_V2_GROUP,&jnczgrp);
+		if(NCJsort(jnczgrp) != NCJ_DICT
+		   || NCJdictget(jnczgrp,"groups",&jsubgrps) || NCJsort(jsubgrps) != NCJ_ARRAY)
+		    continue;
+		for(j=0;j<NCJarraylength(jsubgrps);j++) {
+		    const NCjson* jname = NCJith(jsubgrps,j);
+		    if(NCJsort(jname) != NCJ_STRING) continue;
+		    if((stat = prefetch_addnode(next,NULL,node->key,NCJstring(jname)))) break;
+		}
+	    }
+	}
+	/* The listings of the searched groups of the previous level are complete */
+	for(i=0;stat == NC_NOERR && i<nclistlength(prev);i++) {
+	    struct PrefetchNode* node = (struct PrefetchNode*)nclistget(prev,i);
+	    if(node->searched && !node->incomplete)
+		stat = NCZMD_set_listing(zinfo,node->key,node->groups,node->arrays);
+	}
+	prefetch_freelevel(prev);
+	prev = level;
+	level = next;
+	if(stat) goto done;
+    }
+    /* The searches of the last level found nothing */
+    for(i=0;i<nclistlength(prev);i++) {
+	struct PrefetchNode* node = (struct PrefetchNode*)nclistget(prev,i);
+	if(node->searched && !node->incomplete
+	   && (stat = NCZMD_set_listing(zinfo,node->key,node->groups,node->arrays))) goto done;
+    }
+
+done:
+    nullfree(rootkey);
+    prefetch_freelevel(prev);
+    prefetch_freelevel(level);
+    nclistfreeall(keys);
+    nclistfreeall(matches);
+    return ZUNTRACE(THROW(stat));
+}
+
 /**
  * @internal Read group data from map to memory
  *
@@ -1166,8 +1396,9 @@ define_grp(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp)
 	if((stat = define_dims(file,grp,dimdefs))) goto done;
     }
 
-    /* Define vars taking xarray into account */
-    if((stat = define_vars(file,grp,varnames))) goto done;
+    /* Define vars taking xarray into account; the dimensions of an
+       NCZarr group are already known, so its vars can be read lazily */
+    if((stat = define_vars(file,grp,varnames,!purezarr))) goto done;
 
     /* Define sub-groups */
     if((stat = define_subgrps(file,grp,subgrps))) goto done;
@@ -1371,30 +1602,87 @@ done:
 /**
  * @internal Materialize single var into memory;
  * Take xarray and purezarr into account.
+ * If lazy, only the name is defined and the rest of the
+ * metadata is read by ncz_get_var_meta on first use.
  *
  * @param file Pointer to file info struct.
  * @param grp Pointer to grp info struct.
  * @param varname name of variable in this group
+ * @param lazy 1 => defer reading the .zarray and .zattrs
  *
  * @return ::NC_NOERR No error.
  * @author Dennis Heimbigner
  */
 static int
-define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname)
+define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname, int lazy)
+{
+    int stat = NC_NOERR;
+    NC_VAR_INFO_T* var = NULL;
+    NCZ_VAR_INFO_T* zvar = NULL;
+    int suppress = 0; /* Abort processing of this variable */
+
+    ZTRACE(3,"file=%s grp=%s varname=%s lazy=%d",file->controller->path,grp->hdr.name,varname,lazy);
+
+    if((stat = nc4_var_list_add2(grp, varname, &var)))
+	goto done;
+
+    /* And its annotation */
+    if((zvar = calloc(1,sizeof(NCZ_VAR_INFO_T)))==NULL)
+	{stat = NC_ENOMEM; goto done;}
+    var->format_var_info = zvar;
+    zvar->common.file = file;
+
+    /* pretend it was created */
+    var->created = 1;
+
+    /* Indicate we do not have quantizer yet */
+    var->quantize_mode = -1;
+
+    if(lazy) goto done; /* leave var->meta_read false */
+
+    /* Filter plugins inquire about the var while it is set up */
+    var->meta_read = NC_TRUE;
+    if((stat = define_var_meta(file,var,&suppress))) goto done;
+
+    if(suppress) {
+	/* Reclaim NCZarr variable specific info */
+	(void)NCZ_zclose_var1(var);
+	/* Remove from list of variables and reclaim the top level var object */
+	(void)nc4_var_list_del(grp, var);
+	var = NULL;
+    }
+
+done:
+    return ZUNTRACE(stat);
+}
+
+/**
+ * @internal Read the .zarray and .zattrs of a var and fill in
+ * its type, shape, chunking, fill value and filters.
+ *
+ * @param file Pointer to file info struct.
+ * @param var Pointer to var info struct; its name and annotation are set.
+ * @param suppressp Set to 1 if the variable cannot be represented
+ *
+ * @return ::NC_NOERR No error.
+ */
+static int
+define_var_meta(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var, int* suppressp)
 {
     int stat = NC_NOERR;
     size_t j;
     NCZ_FILE_INFO_T* zinfo = NULL;
+    NC_GRP_INFO_T* grp = var->container;
     int purezarr = 0;
     int xarray = 0;
     /* per-variable info */
-    NC_VAR_INFO_T* var = NULL;
-    NCZ_VAR_INFO_T* zvar = NULL;
+    NCZ_VAR_INFO_T* zvar = var->format_var_info;
     const NCjson* jvar = NULL;
     const NCjson* jatts = NULL; /* corresponding to jvar */
     const NCjson* jncvar = NULL;
     const NCjson* jdimrefs = NULL;
     const NCjson* jvalue = NULL;
+    const NCjson* jshard = NULL;
     char* key = NULL;
     size64_t* shapes = NULL;
     NClist* dimnames = NULL;
@@ -1409,7 +1697,7 @@ define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname)
     int chainindex = 0;
 #endif
 
-    ZTRACE(3,"file=%s grp=%s varname=%s",file->controller->path,grp->hdr.name,varname);
+    ZTRACE(3,"file=%s var=%s",file->controller->path,var->hdr.name);
 
     zinfo = file->format_file_info;
 
@@ -1418,21 +1706,6 @@ define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname)
 
     dimnames = nclistnew();
 
-    if((stat = nc4_var_list_add2(grp, varname, &var)))
-	goto done;
-
-    /* And its annotation */
-    if((zvar = calloc(1,sizeof(NCZ_VAR_INFO_T)))==NULL)
-	{stat = NC_ENOMEM; goto done;}
-    var->format_var_info = zvar;
-    zvar->common.file = file;
-
-    /* pretend it was created */
-    var->created = 1;
-
-    /* Indicate we do not have quantizer yet */
-    var->quantize_mode = -1;
-
     /* Construct var path */
     if((stat = NCZ_varkey(var,&key)))
 	goto done;
@@ -1504,6 +1777,8 @@ define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname)
 	if((stat = NCJdictget(jncvar,"storage",&jvalue))<0) {stat = NC_EINVAL; goto done;}
 	if(jvalue != NULL)
 	    var->storage = NC_CHUNKED;
+	/* Extract the sharding; decoded once the rank is known */
+	if((stat = NCJdictget(jncvar,"sharding",&jshard))<0) {stat = NC_EINVAL; goto done;}
 	/* Extract dimrefs list	 */
 	if((stat = dictgetalt(jncvar,"dimension_references","dimrefs",&jdimrefs))) goto done;
 	if(jdimrefs != NULL) { /* Extract the dimref names */
@@ -1622,6 +1897,22 @@ define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname)
 	    /* Create the cache */
 	    if((stat = NCZ_create_chunk_cache(var,var->type_info->size*zvar->chunkproduct,zvar->dimension_separator,&zvar->cache)))
 		goto done;
+	    /* sharding; must precede the cache adjustment */
+	    if(jshard != NULL) {
+		const NCjson* jloc = NULL;
+		if(NCJsort(jshard) != NCJ_DICT) {stat = (THROW(NC_ENCZARR)); goto done;}
+		if((stat = NCJdictget(jshard,"index_location",&jloc))<0) {stat = NC_EINVAL; goto done;}
+		if(jloc != NULL && (NCJsort(jloc) != NCJ_STRING || strcmp(NCJstring(jloc),"start") != 0))
+		    {stat = (THROW(NC_ENCZARR)); goto done;} /* only layout supported */
+		if((stat = NCJdictget(jshard,"chunks_per_shard",&jvalue))<0) {stat = NC_EINVAL; goto done;}
+		if(jvalue == NULL || NCJsort(jvalue) != NCJ_ARRAY || NCJarraylength(jvalue) != rank)
+		    {stat = (THROW(NC_ENCZARR)); goto done;}
+		if((zvar->shardchunks = malloc(sizeof(size64_t)*rank)) == NULL)
+		    {stat = NC_ENOMEM; goto done;}
+		if((stat = decodeints(jvalue, zvar->shardchunks))) goto done;
+		for(j=0;j<rank;j++)
+		    if(zvar->shardchunks[j] == 0) {stat = (THROW(NC_ENCZARR)); goto done;}
+	    }
 	}
 	if((stat = NCZ_adjust_var_cache(var))) goto done;
     }
@@ -1693,13 +1984,7 @@ define_var1(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, const char* varname)
 #endif
 
 suppressvar:
-    if(suppress) {
-	/* Reclaim NCZarr variable specific info */
-	(void)NCZ_zclose_var1(var);
-	/* Remove from list of variables and reclaim the top level var object */
-	(void)nc4_var_list_del(grp, var);
-	var = NULL;
-    }
+    *suppressp = suppress;
 
 done:
     nclistfreeall(dimnames); dimnames = NULL;
@@ -1715,22 +2000,23 @@ done:
  * @param file Pointer to file info struct.
  * @param grp Pointer to grp info struct.
  * @param varnames List of names of variables in this group
+ * @param lazy 1 => define only the names of the vars
  *
  * @return ::NC_NOERR No error.
  * @author Dennis Heimbigner
  */
 static int
-define_vars(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, NClist* varnames)
+define_vars(NC_FILE_INFO_T* file, NC_GRP_INFO_T* grp, NClist* varnames, int lazy)
 {
     int stat = NC_NOERR;
     size_t i;
 
-    ZTRACE(3,"file=%s grp=%s |varnames|=%u",file->controller->path,grp->hdr.name,nclistlength(varnames));
+    ZTRACE(3,"file=%s grp=%s |varnames|=%u lazy=%d",file->controller->path,grp->hdr.name,nclistlength(varnames),lazy);
 
     /* Load each var in turn */
     for(i = 0; i < nclistlength(varnames); i++) {
 	const char* varname = (const char*)nclistget(varnames,i);
-        if((stat = define_var1(file,grp,varname))) goto done;
+        if((stat = define_var1(file,grp,varname,lazy))) goto done;
 	varname = nclistget(varnames,i);
     }
 
@@ -2081,8 +2367,9 @@ parsedimrefs(NC_FILE_INFO_T* file, NClist* dimnames, size64_t* shape, NC_DIM_INF
 	    if((stat = createdim(file, g, dimname, shape[i], &dims[i])))
 	        goto done;
 	} else {
-	    /* Verify consistency */
-	    if(dims[i]->len != shape[i])
+	    /* Verify consistency; a var read lazily may not have been
+	       rewritten since an unlimited dim grew */
+	    if(dims[i]->unlimited ? shape[i] > dims[i]->len : dims[i]->len != shape[i])
 	        {stat = NC_EDIMSIZE; goto done;}
 	}
 	assert(dims[i] != NULL);
@@ -2093,21 +2380,24 @@ done:
 }
 
 /**
- * @internal Get the metadata for a variable.
+ * @internal Get the metadata for a variable. The vars of an
+ * NCZarr group are defined by name only when the file is opened;
+ * the .zarray and .zattrs are read here on first use.
  *
+ * @param file Pointer to file info struct.
  * @param var Pointer to var info struct.
  *
  * @return ::NC_NOERR No error.
- * @return ::NC_EBADID Bad ncid.
- * @return ::NC_ENOMEM Out of memory.
- * @return ::NC_EHDFERR HDF5 returned error.
- * @return ::NC_EVARMETA Error with var metadata.
+ * @return ::NC_ENCZARR Malformed var metadata.
+ * @return ::NC_EVARMETA Var cannot be represented.
  * @author Ed Hartnett
  */
 int
 ncz_get_var_meta(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var)
 {
-    int retval = NC_NOERR;
+    int stat = NC_NOERR;
+    NCZ_VAR_INFO_T* zvar = NULL;
+    int suppress = 0;
 
     assert(file && var && var->format_var_info);
     LOG((3, "%s: var %s", __func__, var->hdr.name));
@@ -2116,52 +2406,28 @@ ncz_get_var_meta(NC_FILE_INFO_T* file, NC_VAR_INFO_T* var)
     /* Have we already read the var metadata? */
     if (var->meta_read)
 	goto done;
+    zvar = var->format_var_info;
+    /* A var whose metadata could not be read stays unusable */
+    if((stat = zvar->metastat)) goto done;
 
-#ifdef LOOK
-    /* Get the current chunk cache settings. */
-    if ((access_pid = H5Dget_access_plist(hdf5_var->hdf_datasetid)) < 0)
-	BAIL(NC_EVARMETA);
-
-    /* Learn about current chunk cache settings. */
-    if ((H5Pget_chunk_cache(access_pid, &(var->chunk_cache_nelems),
-			    &(var->chunk_cache_size), &rdcc_w0)) < 0)
-	BAIL(NC_EHDFERR);
-    var->chunk_cache_preemption = rdcc_w0;
-
-    /* Get the dataset creation properties. */
-    if ((propid = H5Dget_create_plist(hdf5_var->hdf_datasetid)) < 0)
-	BAIL(NC_EHDFERR);
-
-    /* Get var chunking info. */
-    if ((retval = get_chunking_info(propid, var)))
-	BAIL(retval);
-
-    /* Get filter info for a var. */
-    if ((retval = get_filter_info(propid, var)))
-	BAIL(retval);
-
-    /* Get fill value, if defined. */
-    if ((retval = get_fill_info(propid, var)))
-	BAIL(retval);
-
-    /* Is this a deflated variable with a chunksize greater than the
-     * current cache size? */
-    if ((retval = nc4_adjust_var_cache(var)))
-	BAIL(retval);
-
-    /* Is there an attribute which means quantization was used? */
-    if ((retval = get_quantize_info(var)))
-	BAIL(retval);
-
-    if (var->coords_read && !var->dimscale)
-	if ((retval = get_attached_info(var, hdf5_var, var->ndims, hdf5_var->hdf_datasetid)))
-	    goto done;;
-#endif
-
-    /* Remember that we have read the metadata for this var. */
+    /* Remember that we have read the metadata for this var; do it
+       first because filter plugins inquire about the var while it
+       is set up, and its type and shape are known by then */
     var->meta_read = NC_TRUE;
+    if((stat = define_var_meta(file,var,&suppress))) goto done;
+    if(suppress) {
+	/* Too late to remove it without renumbering the vars */
+	ZLOG(NCLOGWARN,"Variable %s cannot be represented",var->hdr.name);
+	stat = NC_EVARMETA;
+	goto done;
+    }
+
 done:
-    return ZUNTRACE(retval);
+    if(stat && zvar != NULL) {
+	zvar->metastat = stat;
+	var->meta_read = NC_FALSE;
+    }
+    return ZUNTRACE(stat);
 }
 
 /* Compute the set of dim refs for this variable, taking purezarr and xarray into account */
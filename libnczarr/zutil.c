@@ -239,19 +239,14 @@ NCZ_downloadjson(NCZMAP* zmap, const char* key, NCjson** jsonp)
     char* content = NULL;
     NCjson* json = NULL;
 
-    switch(stat = nczmap_len(zmap, key, &len)) {
+    switch(stat = nczmap_readall(zmap, key, &len, (void**)&content)) {
     case NC_NOERR: break;
     case NC_ENOOBJECT: case NC_EEMPTY:
         stat = NC_NOERR;
         goto exit;
     default: goto done;
     }
-    if((content = malloc(len+1)) == NULL)
-	{stat = NC_ENOMEM; goto done;}
-    if((stat = nczmap_read(zmap, key, 0, len, (void*)content)))
-	goto done;
-    content[len] = '\0';
-    if((stat = NCJparse(content,0,&json)) < 0)
+    if((stat = NCJparsen((size_t)len,content,0,&json)) < 0)
 	{stat = NC_ENCZARR; goto done;}
 
 exit:
@@ -552,6 +552,11 @@ ncz_def_var_extra(int ncid, int varid, int *shuffle, int *unused1,
 	{retval = NC_ENOTVAR; goto done;}
     assert(var && var->hdr.id == varid);
 
+    /* Do we need to read var metadata? */
+    if (!var->meta_read && var->created)
+	if ((retval = ncz_get_var_meta(h5, var)))
+	    goto done;
+
     zvar = var->format_var_info;
 
     ZTRACEMORE(1,"\tstoragep=%d chunksizes=%s",(storagep?*storagep:-1),(chunksizes?nczprint_sizevector(var->ndims,chunksizes):"null"));
@@ -952,7 +957,7 @@ ncz_def_var_chunking_ints(int ncid, int varid, int contiguous, int *chunksizesp)
     int i, retval;
 
     /* Get pointer to the var. */
-    if ((retval = nc4_find_grp_h5_var(ncid, varid, NULL, NULL, &var)))
+    if ((retval = ncz_find_grp_file_var(ncid, varid, NULL, NULL, &var)))
 	return THROW(retval);
     assert(var);
 
@@ -1173,7 +1178,7 @@ NCZ_inq_var_quantize(int ncid, int varid, int *quantize_modep,
 
     /* Find info for this file and group, and set pointer to each. */
     /* Get pointer to the var. */
-    if ((retval = nc4_find_grp_h5_var(ncid, varid, NULL, NULL, &var)))
+    if ((retval = ncz_find_grp_file_var(ncid, varid, NULL, NULL, &var)))
         return retval;
     if (!var)
         return NC_ENOTVAR;	
@@ -1188,6 +1193,95 @@ NCZ_inq_var_quantize(int ncid, int varid, int *quantize_modep,
     return NC_NOERR;
  }
 
+/**
+ * @internal Store the chunks of a variable in shards, each holding
+ * a block of chunks; see nc_def_var_shard() and zshard.c.
+ *
+ * @param ncid File ID.
+ * @param varid Variable ID.
+ * @param shardp Number of chunks per shard along each dimension;
+ * NULL turns sharding off.
+ *
+ * @returns ::NC_NOERR No error.
+ * @returns ::NC_EBADID Bad ncid.
+ * @returns ::NC_ENOTVAR Invalid variable ID.
+ * @returns ::NC_EPERM File is read only.
+ * @returns ::NC_ELATEDEF Too late to change settings for this variable.
+ * @returns ::NC_EINVAL A scalar variable, a zero count, or a pure
+ * Zarr file, which cannot record the sharding.
+ */
+int
+NCZ_def_var_shard(int ncid, int varid, const size_t *shardp)
+{
+    NC_FILE_INFO_T *h5;
+    NC_VAR_INFO_T *var;
+    NCZ_VAR_INFO_T *zvar;
+    size64_t* shardchunks = NULL;
+    size_t d;
+    int retval = NC_NOERR;
+
+    if ((retval = nc4_find_grp_h5_var(ncid, varid, &h5, NULL, &var)))
+        goto done;
+    if (h5->no_write)
+        {retval = NC_EPERM; goto done;}
+    if (var->created)
+        {retval = NC_ELATEDEF; goto done;}
+    if (((NCZ_FILE_INFO_T*)h5->format_file_info)->controls.flags & FLAG_PUREZARR)
+        {retval = NC_EINVAL; goto done;}
+    zvar = var->format_var_info;
+    if (shardp != NULL) {
+        if (var->ndims == 0)
+            {retval = NC_EINVAL; goto done;}
+        if ((shardchunks = malloc(var->ndims * sizeof(size64_t))) == NULL)
+            {retval = NC_ENOMEM; goto done;}
+        for (d = 0; d < var->ndims; d++) {
+            if (shardp[d] == 0)
+                {retval = NC_EINVAL; goto done;}
+            shardchunks[d] = shardp[d];
+        }
+    }
+    nullfree(zvar->shardchunks);
+    zvar->shardchunks = shardchunks; shardchunks = NULL;
+    /* The shard store is rebuilt with the cache */
+    zvar->cache->valid = 0;
+    retval = NCZ_adjust_var_cache(var);
+done:
+    nullfree(shardchunks);
+    return retval;
+}
+
+/**
+ * @internal Get the sharding of a variable; see nc_inq_var_shard().
+ *
+ * @param ncid File ID.
+ * @param varid Variable ID.
+ * @param shardedp Gets 1 if the variable is sharded, else 0. Ignored if NULL.
+ * @param shardp Gets the number of chunks per shard along each
+ * dimension if the variable is sharded. Ignored if NULL.
+ *
+ * @returns ::NC_NOERR No error.
+ * @returns ::NC_EBADID Bad ncid.
+ * @returns ::NC_ENOTVAR Invalid variable ID.
+ */
+int
+NCZ_inq_var_shard(int ncid, int varid, int *shardedp, size_t *shardp)
+{
+    NC_VAR_INFO_T *var;
+    NCZ_VAR_INFO_T *zvar;
+    size_t d;
+    int retval;
+
+    if ((retval = ncz_find_grp_file_var(ncid, varid, NULL, NULL, &var)))
+        return retval;
+    zvar = var->format_var_info;
+    if (shardedp)
+        *shardedp = (zvar->shardchunks != NULL);
+    if (shardp && zvar->shardchunks != NULL)
+        for (d = 0; d < var->ndims; d++)
+            shardp[d] = (size_t)zvar->shardchunks[d];
+    return NC_NOERR;
+}
+
 /**
  * @internal Rename a var to "bubba," for example. This is called by
  * nc_rename_var() for netCDF-4 files. This results in complexities
@@ -1257,6 +1351,11 @@ NCZ_rename_var(int ncid, int varid, const char *name)
     if (!(var = (NC_VAR_INFO_T *)ncindexith(grp->vars, varid)))
 	return NC_ENOTVAR;
 
+    /* The var is rewritten under its new name, so read it first */
+    if (!var->meta_read && var->created)
+	if ((retval = ncz_get_var_meta(h5, var)))
+	    return THROW(retval);
+
     /* Check if new name is in use; note that renaming to same name is
        still an error according to the nc_test/test_write.c
        code. Why?*/
@@ -1563,7 +1662,7 @@ NCZ_put_vars(int ncid, int varid, const size_t *startp, const size_t *countp,
 #endif
     
     /* Find info for this file, group, and var. */
-    if ((retval = nc4_find_grp_h5_var(ncid, varid, &h5, &grp, &var)))
+    if ((retval = ncz_find_grp_file_var(ncid, varid, &h5, &grp, &var)))
 	return THROW(retval);
     assert(h5 && grp && var && var->hdr.id == varid && var->format_var_info);
 
@@ -1863,7 +1962,7 @@ NCZ_get_vars(int ncid, int varid, const size_t *startp, const size_t *countp,
     NCZ_VAR_INFO_T* zvar = NULL;
 
     /* Find info for this file, group, and var. */
-    if ((retval = nc4_find_grp_h5_var(ncid, varid, &h5, &grp, &var)))
+    if ((retval = ncz_find_grp_file_var(ncid, varid, &h5, &grp, &var)))
 	return THROW(retval);
     assert(h5 && grp && var && var->hdr.id == varid && var->format_var_info &&
 	   var->type_info && var->type_info->size &&
@@ -2191,6 +2290,17 @@ NCZ_inq_var_all(int ncid, int varid, char *name, nc_type *xtypep,
 
     LOG((2, "%s: ncid 0x%x varid %d", __func__, ncid, varid));
 
+    /* The name alone does not need the lazy reads; nc_inq_varname
+     * over all the vars of a file should not read their metadata. */
+    if (!xtypep && !ndimsp && !dimidsp && !nattsp && !shufflep && !unused4 &&
+        !unused5 && !fletcher32p && !storagep && !chunksizesp && !no_fill &&
+        !fill_valuep && !endiannessp && !unused1 && !unused2 && !unused3) {
+	retval = NC4_inq_var_all(ncid, varid, name, NULL, NULL, NULL, NULL,
+			       NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+			       NULL, NULL, NULL, NULL);
+	goto done;
+    }
+
     /* Find the file, group, and var info, and do lazy att read if
      * needed. */
     if ((retval = ncz_find_grp_var_att(ncid, varid, NULL, 0, 0, NULL,
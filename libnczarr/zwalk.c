@@ -22,6 +22,8 @@ static unsigned int wdebug = 1;
 static int NCZ_walk(NCZProjection** projv, NCZOdometer* chunkodom, NCZOdometer* slpodom, NCZOdometer* memodom, const struct Common* common, void* chunkdata);
 static int rangecount(NCZChunkRange range);
 static int readfromcache(void* source, size64_t* chunkindices, void** chunkdata);
+static int skipchunk(const struct Common* common, const size64_t* chunkindices);
+static int prefetchchunks(const struct Common* common, NCZOdometer* aheadodom, size_t maxbatch, size64_t* batch, size_t* countp);
 static int iswholechunk(struct Common* common,NCZSlice*);
 static int wholechunk_indices(struct Common* common, NCZSlice* slices, size64_t* chunkindices);
 #ifdef TRANSFERN
@@ -198,6 +200,10 @@ NCZ_transfer(struct Common* common, NCZSlice* slices)
     NCZOdometer* chunkodom =  NULL;
     NCZOdometer* slpodom = NULL;
     NCZOdometer* memodom = NULL;
+    NCZOdometer* aheadodom = NULL; /* look-ahead for concurrent prefetch */
+    size64_t* batch = NULL; /* chunk indices of the current prefetch batch */
+    size_t maxbatch = 0;
+    size_t unread = 0; /* # chunks of the current batch not yet walked */
     void* chunkdata = NULL;
     int wholechunk = 0;
 
@@ -268,6 +274,18 @@ NCZ_transfer(struct Common* common, NCZSlice* slices)
 	goto done;
     }
 
+    /* When reading through the cache, fetch and decode
+       batches of chunks concurrently ahead of the walk */
+    if(common->reading && common->reader.read == readfromcache)
+        maxbatch = NCZ_prefetch_limit(common->cache);
+    if(maxbatch > 1) {
+        NCZOdometer* co = chunkodom;
+	if((aheadodom = nczodom_new(co->rank,co->start,co->stop,co->stride,co->len))==NULL)
+	    {stat = NC_ENOMEM; goto done;}
+	if((batch = malloc(maxbatch*sizeof(size64_t)*(size_t)common->rank))==NULL)
+	    {stat = NC_ENOMEM; goto done;}
+    }
+
     /* iterate over the odometer: all combination of chunk
        indices in the projections */
     for(;nczodom_more(chunkodom);) {
@@ -309,6 +327,13 @@ NCZ_transfer(struct Common* common, NCZSlice* slices)
 	    if(proj[r]->skip) goto next;
 	}
 
+	if(aheadodom != NULL) {
+	    if(unread == 0) {
+	        if((stat = prefetchchunks(common,aheadodom,maxbatch,batch,&unread))) goto done;
+	    }
+	    if(unread > 0) unread--;
+	}
+
 	for(r=0;r<common->rank;r++) {
 	    slpslices[r] = proj[r]->chunkslice;
 	    memslices[r] = proj[r]->memslice;
@@ -348,6 +373,8 @@ done:
     nczodom_free(slpodom);
     nczodom_free(memodom);
     nczodom_free(chunkodom);
+    nczodom_free(aheadodom);
+    nullfree(batch);
     return stat;
 }
 
@@ -717,6 +744,52 @@ readfromcache(void* source, size64_t* chunkindices, void** chunkdatap)
     return NCZ_read_cache_chunk((struct NCZChunkCache*)source, chunkindices, chunkdatap);
 }
 
+/* Does any projection for these chunk indices select nothing? */
+static int
+skipchunk(const struct Common* common, const size64_t* chunkindices)
+{
+    int r;
+    for(r=0;r<common->rank;r++) {
+	NCZSliceProjections* slp = &common->allprojections[r];
+	if(slp->projections[chunkindices[r] - slp->range.start].skip) return 1;
+    }
+    return 0;
+}
+
+/*
+Advance the look-ahead odometer to collect the indices of
+the next (at most maxbatch) chunks that the walk will read,
+and have the cache fetch them concurrently.
+The walk visits chunks in the same order, so the look-ahead
+is exhausted exactly when the walk has consumed the batch.
+
+@param common
+@param aheadodom look-ahead chunk odometer
+@param maxbatch max # of chunks in a batch
+@param batch space for maxbatch*rank indices
+@param countp return # of chunks in the batch
+@return NC_NOERR|NC_EXXX
+*/
+static int
+prefetchchunks(const struct Common* common, NCZOdometer* aheadodom, size_t maxbatch, size64_t* batch, size_t* countp)
+{
+    size_t n = 0;
+    size_t rank = (size_t)common->rank;
+
+    while(n < maxbatch && nczodom_more(aheadodom)) {
+	size64_t* chunkindices = nczodom_indices(aheadodom);
+	if(!skipchunk(common,chunkindices)) {
+	    memcpy(&batch[n*rank],chunkindices,sizeof(size64_t)*rank);
+	    n++;
+	}
+	nczodom_next(aheadodom);
+    }
+    *countp = n;
+    if(wdebug >= 1)
+	fprintf(stderr,"prefetch: %u chunks\n",(unsigned)n);
+    return NCZ_prefetch_cache_chunks(common->cache,n,batch);
+}
+
 void
 NCZ_clearcommon(struct Common* common)
 {
@@ -803,7 +876,7 @@ NCZ_read_chunk(int ncid, int varid, size64_t* zindices, void* chunkdata)
     struct NCZChunkCache* cache = NULL;
     void* cachedata = NULL;
 
-    if ((stat = nc4_find_grp_h5_var(ncid, varid, &h5, NULL, &var)))
+    if ((stat = ncz_find_grp_file_var(ncid, varid, &h5, NULL, &var)))
 	return THROW(stat);
     zvar = (NCZ_VAR_INFO_T*)var->format_var_info;
     cache = zvar->cache;
@@ -14,6 +14,7 @@
 #include "zcache.h"
 #include "ncxcache.h"
 #include "zfilter.h"
+#include "ncthreadpool.h"
 #include <stddef.h>
 
 #undef DEBUG
@@ -24,12 +25,32 @@
 
 #define USEPARAMSIZE 0xffffffffffffffff
 
+/* Argument to a concurrent chunk fetch or write */
+struct ChunkTask {
+    NCZChunkCache* cache;
+    NCZCacheEntry* entry;
+    int readstat; /* outcome of reading the raw chunk */
+};
+
 /* Forward */
 static int get_chunk(NCZChunkCache* cache, NCZCacheEntry* entry);
+static int fetch_chunk(NCZChunkCache* cache, NCZCacheEntry* entry);
+static int decode_chunk(NCZChunkCache* cache, NCZCacheEntry* entry, int readstat);
+static int prepare_fetch(NCZChunkCache* cache);
+static int prepare_write(NCZChunkCache* cache);
+static int evict_chunk(NCZChunkCache* cache, NCZCacheEntry* e);
+static int drain_writes(NCZChunkCache* cache);
+static int write_pending(NCZChunkCache* cache, ncexhashkey_t hkey);
+static NCZCacheEntry* new_cache_entry(NCZChunkCache* cache, const size64_t* indices);
+static void remove_entry(NCZChunkCache* cache, NCZCacheEntry* e);
+static void shared_link(NCZChunkCache* cache, NCZCacheEntry* e);
+static void shared_unlink(NCZChunkCache* cache, NCZCacheEntry* e);
+static void addused(NCZChunkCache* cache, size64_t size);
 static int put_chunk(NCZChunkCache* cache, NCZCacheEntry*);
 static int verifycache(NCZChunkCache* cache);
 static int flushcache(NCZChunkCache* cache);
 static int constraincache(NCZChunkCache* cache, size64_t needed);
+static int constrainshared(NCZSharedCache* shared, size64_t needed);
 
 static void
 setmodified(NCZCacheEntry* e, int tf)
@@ -82,6 +103,11 @@ NCZ_set_var_chunk_cache(int ncid, int varid, size_t cachesize, size_t nelems, fl
         {retval = NC_ENOTVAR; goto done;}
     assert(var && var->hdr.id == varid);
 
+    /* Do we need to read var metadata? */
+    if (!var->meta_read && var->created)
+        if ((retval = ncz_get_var_meta(h5, var)))
+            goto done;
+
     zvar = (NCZ_VAR_INFO_T*)var->format_var_info;
     assert(zvar != NULL && zvar->cache != NULL);
 
@@ -96,6 +122,31 @@ done:
     return retval;
 }
 
+/**
+ * @internal Get chunk cache size for a variable. This is the internal
+ * function called by nc_get_var_chunk_cache(); the settings are
+ * adjusted when the var metadata is read, so do that first.
+ *
+ * @param ncid File ID.
+ * @param varid Variable ID.
+ * @param sizep Gets size in bytes of cache.
+ * @param nelemsp Gets # of entries in cache.
+ * @param preemptionp Gets preemption.
+ *
+ * @returns ::NC_NOERR No error.
+ * @returns ::NC_EBADID Bad ncid.
+ * @returns ::NC_ENOTVAR Invalid variable ID.
+ */
+int
+NCZ_get_var_chunk_cache(int ncid, int varid, size_t *sizep, size_t *nelemsp, float *preemptionp)
+{
+    int retval;
+
+    if((retval = ncz_find_grp_file_var(ncid, varid, NULL, NULL, NULL)))
+        return retval;
+    return NC4_get_var_chunk_cache(ncid, varid, sizep, nelemsp, preemptionp);
+}
+
 /**
  * @internal Adjust the chunk cache of a var for better
  * performance.
@@ -125,6 +176,12 @@ fprintf(stderr,"xxx: adjusting cache for: %s\n",var->hdr.name);
 
     /* completely empty the cache */
     flushcache(zcache);
+    /* background writes still refer to the old chunk layout */
+    if((stat = drain_writes(zcache))) goto done;
+    /* and so do the shards */
+    if((stat = NCZ_shard_flush(zcache->shards))) goto done;
+    NCZ_shard_free(zcache->shards);
+    zcache->shards = NULL;
 
     /* Reclaim any existing fill_chunk */
     if((stat = NCZ_reclaim_fill_chunk(zcache))) goto done;
@@ -145,6 +202,9 @@ fprintf(stderr,"xxx: adjusting cache for: %s\n",var->hdr.name);
 	    zcache->chunkcount *= var->chunksizes[i];
         }
     }
+    if(zvar->shardchunks != NULL && var->ndims > 0) {
+        if((stat = NCZ_shard_create(zcache,zvar->shardchunks,&zcache->shards))) goto done;
+    }
     zcache->valid = 1;
 done:
     return stat;
@@ -180,6 +240,7 @@ NCZ_create_chunk_cache(NC_VAR_INFO_T* var, size64_t chunksize, char dimsep, NCZC
     cache->fillchunk = NULL;
     cache->chunksize = chunksize;
     cache->dimension_separator = dimsep;
+    cache->shared = ((NCZ_FILE_INFO_T*)var->container->nc4_info->format_file_info)->sharedcache;
     zvar->cache = cache;
 
     cache->chunkcount = 1;
@@ -202,9 +263,6 @@ NCZ_create_chunk_cache(NC_VAR_INFO_T* var, size64_t chunksize, char dimsep, NCZC
         var->hdr.name,(unsigned long)cache->maxentries,(unsigned long)cache->maxsize);
 #endif
     if((stat = ncxcachenew(LEAFLEN,&cache->xcache))) goto done;
-    if((cache->mru = nclistnew()) == NULL)
-	{stat = NC_ENOMEM; goto done;}
-    nclistsetalloc(cache->mru,cache->params.nelems);
 
     if(cachep) {*cachep = cache; cache = NULL;}
 done:
@@ -213,6 +271,35 @@ done:
     return THROW(stat);
 }
 
+/* The entries are linked into the LRU list of cache->xcache
+   through their list field; the list header terminates a walk. */
+static NCZCacheEntry*
+lrunext(NCZChunkCache* cache, NCZCacheEntry* entry)
+{
+    NCxnode* next = (NCxnode*)entry->list.next;
+    return (next == &cache->xcache->lru ? NULL : (NCZCacheEntry*)next);
+}
+
+static NCZCacheEntry*
+lruprev(NCZChunkCache* cache, NCZCacheEntry* entry)
+{
+    NCxnode* prev = (NCxnode*)entry->list.prev;
+    return (prev == &cache->xcache->lru ? NULL : (NCZCacheEntry*)prev);
+}
+
+/* Allocate an entry together with space for its indices */
+static NCZCacheEntry*
+new_cache_entry(NCZChunkCache* cache, const size64_t* indices)
+{
+    size_t rank = (size_t)cache->ndims;
+    NCZCacheEntry* entry = calloc(1,sizeof(NCZCacheEntry)+(rank*sizeof(size64_t)));
+    if(entry == NULL) return NULL;
+    entry->indices = (size64_t*)(entry+1);
+    memcpy(entry->indices,indices,rank*sizeof(size64_t));
+    entry->cache = cache;
+    return entry;
+}
+
 static void
 free_cache_entry(NCZChunkCache* cache, NCZCacheEntry* entry)
 {
@@ -228,6 +315,79 @@ free_cache_entry(NCZChunkCache* cache, NCZCacheEntry* entry)
     }
 }
 
+/* Remove an entry from its cache and from the shared LRU list, if any */
+static void
+remove_entry(NCZChunkCache* cache, NCZCacheEntry* e)
+{
+    void* ptr = NULL;
+    (void)ncxcacheremove(cache->xcache,e->hashkey,&ptr);
+    assert(ptr == e);
+    shared_unlink(cache,e);
+    assert(cache->used >= e->size);
+    cache->used -= e->size;
+    if(cache->shared != NULL) {
+        assert(cache->shared->used >= e->size);
+        cache->shared->used -= e->size;
+    }
+}
+
+static void
+addused(NCZChunkCache* cache, size64_t size)
+{
+    cache->used += size;
+    if(cache->shared != NULL) cache->shared->used += size;
+}
+
+/* Make e the most recently used entry of the shared cache */
+static void
+shared_link(NCZChunkCache* cache, NCZCacheEntry* e)
+{
+    NCZSharedCache* shared = cache->shared;
+    if(shared == NULL) return;
+    e->shared.prev = NULL;
+    e->shared.next = shared->mru;
+    if(shared->mru != NULL) shared->mru->shared.prev = e; else shared->lru = e;
+    shared->mru = e;
+}
+
+static void
+shared_unlink(NCZChunkCache* cache, NCZCacheEntry* e)
+{
+    NCZSharedCache* shared = cache->shared;
+    if(shared == NULL) return;
+    if(e->shared.prev != NULL) e->shared.prev->shared.next = e->shared.next; else shared->mru = e->shared.next;
+    if(e->shared.next != NULL) e->shared.next->shared.prev = e->shared.prev; else shared->lru = e->shared.prev;
+    e->shared.next = e->shared.prev = NULL;
+}
+
+/**
+ * Create a chunk cache budget to be shared by all
+ * the variables of a file.
+ *
+ * @param size the budget in bytes
+ * @param sharedp return the shared cache
+ * @return NC_NOERR or NC_ENOMEM
+ */
+int
+NCZ_create_shared_cache(size64_t size, NCZSharedCache** sharedp)
+{
+    NCZSharedCache* shared = NULL;
+    if((shared = calloc(1,sizeof(NCZSharedCache))) == NULL)
+        return NC_ENOMEM;
+    shared->size = size;
+    if(sharedp) *sharedp = shared; else free(shared);
+    return NC_NOERR;
+}
+
+/* All the variable caches using it must have been freed already */
+void
+NCZ_free_shared_cache(NCZSharedCache* shared)
+{
+    if(shared == NULL) return;
+    assert(shared->mru == NULL && shared->used == 0);
+    free(shared);
+}
+
 void
 NCZ_free_chunk_cache(NCZChunkCache* cache)
 {
@@ -235,20 +395,34 @@ NCZ_free_chunk_cache(NCZChunkCache* cache)
 
     ZTRACE(4,"cache.var=%s",cache->var->hdr.name);
 
+    {
+	NCZ_FILE_INFO_T* zfile = (NCZ_FILE_INFO_T*)cache->var->container->nc4_info->format_file_info;
+	if(zfile != NULL && (zfile->controls.flags & FLAG_SHOWCACHE)) {
+	    /* Shown whatever the log level, which is left as it was */
+	    int level = ncsetloglevel(NCLOGNOTE);
+	    nclog(NCLOGNOTE,"chunk cache: var=%s hits=%llu misses=%llu evictions=%llu maxwrites=%llu",
+		cache->var->hdr.name,cache->stats.hits,cache->stats.misses,cache->stats.evictions,
+		cache->stats.maxwrites);
+	    ncsetloglevel(level);
+	}
+    }
+
+    /* Background writes refer to the cache; errors were reported by any prior flush */
+    (void)drain_writes(cache);
+    nctaskgroupfree(cache->writebehind.group);
+    cache->writebehind.group = NULL;
+    NCZ_shard_free(cache->shards);
+    cache->shards = NULL;
+
     /* Iterate over the entries */
-    while(nclistlength(cache->mru) > 0) {
-	void* ptr;
-        NCZCacheEntry* entry = nclistremove(cache->mru,0);
-	(void)ncxcacheremove(cache->xcache,entry->hashkey,&ptr);
-	assert(ptr == entry);
-        free_cache_entry(cache,entry);
+    if(cache->xcache != NULL) {
+        NCZCacheEntry* entry;
+        while((entry = ncxcachelast(cache->xcache)) != NULL) {
+	    remove_entry(cache,entry);
+            free_cache_entry(cache,entry);
+        }
     }
-#ifdef DEBUG
-fprintf(stderr,"|cache.free|=%ld\n",nclistlength(cache->mru));
-#endif
     ncxcachefree(cache->xcache);
-    nclistfree(cache->mru);
-    cache->mru = NULL;
     (void)NCZ_reclaim_fill_chunk(cache);
     nullfree(cache);
     (void)ZUNTRACE(NC_NOERR);
@@ -266,14 +440,13 @@ size64_t
 NCZ_cache_size(NCZChunkCache* cache)
 {
     assert(cache);
-    return nclistlength(cache->mru);
+    return (size64_t)ncxcachecount(cache->xcache);
 }
 
 int
 NCZ_read_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void** datap)
 {
     int stat = NC_NOERR;
-    int rank = cache->ndims;
     NCZCacheEntry* entry = NULL;
     ncexhashkey_t hkey = 0;
     int created = 0;
@@ -286,6 +459,9 @@ NCZ_read_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void** datap
     case NC_NOERR:
         /* Move to front of the lru */
         (void)ncxcachetouch(cache->xcache,hkey);
+        shared_unlink(cache,entry);
+        shared_link(cache,entry);
+        cache->stats.hits++;
         break;
     case NC_ENOOBJECT: case NC_EEMPTY:
         entry = NULL; /* not found; */
@@ -294,10 +470,14 @@ NCZ_read_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void** datap
     }
 
     if(entry == NULL) { /*!found*/
+        cache->stats.misses++;
+	/* An evicted version may still be on its way to storage */
+	if(write_pending(cache,hkey)) {
+	    if((stat = drain_writes(cache))) goto done;
+	}
 	/* Create a new entry */
-	if((entry = calloc(1,sizeof(NCZCacheEntry)))==NULL)
+	if((entry = new_cache_entry(cache,indices))==NULL)
 	    {stat = NC_ENOMEM; goto done;}
-	memcpy(entry->indices,indices,(size_t)rank*sizeof(size64_t));
         /* Create the key for this cache */
         if((stat = NCZ_buildchunkpath(cache,indices,&entry->key))) goto done;
         entry->hashkey = hkey;
@@ -307,12 +487,12 @@ NCZ_read_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void** datap
 	assert(entry->data != NULL);
 	/* Ensure cache constraints not violated; but do it before entry is added */
 	if((stat=verifycache(cache))) goto done;
-        nclistpush(cache->mru,entry);
 	if((stat = ncxcacheinsert(cache->xcache,entry->hashkey,entry))) goto done;
+	shared_link(cache,entry);
     }
 
 #ifdef DEBUG
-fprintf(stderr,"|cache.read.lru|=%ld\n",nclistlength(cache->mru));
+fprintf(stderr,"|cache.read.lru|=%ld\n",(long)NCZ_cache_size(cache));
 #endif
     if(datap) *datap = entry->data;
     entry = NULL;
@@ -323,6 +503,175 @@ done:
     return THROW(stat);
 }
 
+/**
+ * Return the maximum number of chunks that NCZ_prefetch_cache_chunks
+ * should be given at once: all of them must be able to live in the
+ * cache simultaneously, and their total size must not exceed the
+ * max in-flight bytes.
+ *
+ * @param cache the chunk cache
+ * @return max batch size; < 2 => concurrent prefetch is not useful
+ */
+size_t
+NCZ_prefetch_limit(NCZChunkCache* cache)
+{
+    NCglobalstate* ngs = NC_getglobalstate();
+    NC_FILE_INFO_T* file = (cache->var->container)->nc4_info;
+    NCZ_FILE_INFO_T* zfile = file->format_file_info;
+    size_t limit;
+
+    /* The decoding is done on the pool; nczmap_readv decides how to read the batch.
+       Batches of a sharded variable are worth reading even without the pool,
+       since the chunks of a shard are read together. */
+    if(NCZ_threadpool() == NULL && cache->shards == NULL) return 0;
+    if(zfile->map == NULL) return 0;
+    if(cache->chunksize == 0) return 0;
+    if(cache->shared != NULL)
+        limit = (size_t)(cache->shared->size / cache->chunksize);
+    else {
+        limit = cache->params.nelems;
+        if(limit > cache->params.size / cache->chunksize)
+            limit = (size_t)(cache->params.size / cache->chunksize);
+    }
+    if(ngs->zarr.maxinflight > 0 && limit > ngs->zarr.maxinflight / cache->chunksize)
+        limit = (size_t)(ngs->zarr.maxinflight / cache->chunksize);
+    return limit;
+}
+
+static int
+decode_task(void* arg)
+{
+    struct ChunkTask* fetch = (struct ChunkTask*)arg;
+    return decode_chunk(fetch->cache,fetch->entry,fetch->readstat);
+}
+
+/**
+ * Read a set of chunks into the cache: the raw chunks are read
+ * with a single batched map operation (nczmap_readv), and then
+ * decoded concurrently on the NCZarr thread pool. Chunks already
+ * in the cache are skipped. Afterwards, NCZ_read_cache_chunk
+ * will find the chunks in the cache.
+ *
+ * @param cache the chunk cache
+ * @param nchunks number of chunks
+ * @param indices nchunks*cache->ndims chunk indices; each set must be distinct
+ * @return NC_NOERR or the first error from any of the reads
+ */
+int
+NCZ_prefetch_cache_chunks(NCZChunkCache* cache, size_t nchunks, const size64_t* indices)
+{
+    int stat = NC_NOERR;
+    size_t i, nfetch = 0;
+    size_t rank = cache->ndims;
+    NCthreadpool* pool = NULL;
+    NCtaskgroup* group = NULL;
+    struct ChunkTask* fetches = NULL;
+    NCZMAPIO* ios = NULL;
+    NC_FILE_INFO_T* file = (cache->var->container)->nc4_info;
+    NCZ_FILE_INFO_T* zfile = file->format_file_info;
+
+    if(nchunks < 2) goto done;
+    if((pool = NCZ_threadpool()) == NULL && cache->shards == NULL) goto done;
+
+    /* Anything that could modify shared state must happen before going concurrent;
+       if that fails, leave it to NCZ_read_cache_chunk to report the error. */
+    if(prepare_fetch(cache) != NC_NOERR) goto done;
+
+    if((fetches = calloc(nchunks,sizeof(struct ChunkTask))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    for(i=0;i<nchunks;i++) {
+        const size64_t* chunkindices = indices + (i * rank);
+        ncexhashkey_t hkey = ncxcachekey(chunkindices,sizeof(size64_t)*rank);
+        NCZCacheEntry* entry = NULL;
+        void* obj = NULL;
+
+        if(ncxcachelookup(cache->xcache,hkey,&obj) == NC_NOERR) continue; /* already cached */
+        if(write_pending(cache,hkey)) {
+            if((stat = drain_writes(cache))) goto done;
+        }
+        if((entry = new_cache_entry(cache,chunkindices))==NULL)
+            {stat = NC_ENOMEM; goto done;}
+        fetches[nfetch].cache = cache;
+        fetches[nfetch].entry = entry;
+        nfetch++;
+        if((stat = NCZ_buildchunkpath(cache,chunkindices,&entry->key))) goto done;
+        entry->hashkey = hkey;
+    }
+    if(nfetch == 0) goto done;
+
+    /* Read all the raw chunks in one batch */
+    if((ios = calloc(nfetch,sizeof(NCZMAPIO))) == NULL)
+        {stat = NC_ENOMEM; goto done;}
+    if(cache->shards != NULL) {
+        size64_t* fetchindices = NULL;
+        if((fetchindices = malloc(nfetch*rank*sizeof(size64_t))) == NULL)
+            {stat = NC_ENOMEM; goto done;}
+        for(i=0;i<nfetch;i++)
+            memcpy(fetchindices+(i*rank),fetches[i].entry->indices,rank*sizeof(size64_t));
+        stat = NCZ_shard_readv(cache->shards,nfetch,fetchindices,ios);
+        free(fetchindices);
+        if(stat) goto done;
+    } else {
+        for(i=0;i<nfetch;i++) {
+            if((ios[i].key = NCZ_chunkpath(fetches[i].entry->key)) == NULL)
+                {stat = NC_ENOMEM; goto done;}
+        }
+        if((stat = nczmap_readv(zfile->map,nfetch,ios))) goto done;
+    }
+    for(i=0;i<nfetch;i++) {
+        NCZCacheEntry* entry = fetches[i].entry;
+        fetches[i].readstat = ios[i].stat;
+        entry->data = ios[i].content; ios[i].content = NULL;
+        if(ios[i].stat == NC_NOERR) entry->size = ios[i].count;
+        /* Until decoded, string data is still in char[maxstrlen] form */
+        entry->isfixedstring = (cache->var->type_info->hdr.id == NC_STRING);
+    }
+
+    /* Decode concurrently */
+    if(pool == NULL) {
+        for(i=0;i<nfetch;i++)
+            if((stat = decode_task(&fetches[i]))) goto done;
+    } else {
+        if((stat = nctaskgroupnew(pool,&group))) goto done;
+        for(i=0;i<nfetch;i++) {
+            if((stat = nctasksubmit(group,decode_task,&fetches[i]))) break;
+        }
+        {
+            int wstat = nctaskwait(group); /* must always wait */
+            if(stat == NC_NOERR) stat = wstat;
+        }
+        if(stat) goto done;
+    }
+
+    /* Add to the cache serially */
+    for(i=0;i<nfetch;i++) {
+        NCZCacheEntry* entry = fetches[i].entry;
+        if((stat = constraincache(cache,entry->size))) goto done;
+        addused(cache,entry->size);
+        cache->stats.misses++;
+        if((stat=verifycache(cache))) goto done;
+        fetches[i].entry = NULL;
+        if((stat = ncxcacheinsert(cache->xcache,entry->hashkey,entry))) goto done;
+        shared_link(cache,entry);
+    }
+
+done:
+    nctaskgroupfree(group);
+    if(ios != NULL) {
+        for(i=0;i<nfetch;i++) {
+            nullfree((char*)ios[i].key);
+            nullfree(ios[i].content);
+        }
+        free(ios);
+    }
+    if(fetches != NULL) {
+        for(i=0;i<nfetch;i++)
+            free_cache_entry(cache,fetches[i].entry);
+        free(fetches);
+    }
+    return THROW(stat);
+}
+
 #if 0
 int
 NCZ_write_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void* content)
@@ -337,9 +686,8 @@ NCZ_write_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void* conte
 
     if(entry == NULL) { /*!found*/
 	/* Create a new entry */
-	if((entry = calloc(1,sizeof(NCZCacheEntry)))==NULL)
+	if((entry = new_cache_entry(cache,indices))==NULL)
 	    {stat = NC_ENOMEM; goto done;}
-	memcpy(entry->indices,indices,rank*sizeof(size64_t));
         if((stat = NCZ_buildchunkpath(cache,indices,&entry->key))) goto done;
         entry->hashkey = hkey;
 	/* Create the local copy space */
@@ -349,9 +697,9 @@ NCZ_write_cache_chunk(NCZChunkCache* cache, const size64_t* indices, void* conte
 	memcpy(entry->data,content,cache->chunksize);
     }
     setmodified(entry,1);
-    nclistpush(cache->mru,entry); /* MRU order */
+    if((stat = ncxcacheinsert(cache->xcache,entry->hashkey,entry))) goto done;
 #ifdef DEBUG
-fprintf(stderr,"|cache.write|=%ld\n",nclistlength(cache->mru));
+fprintf(stderr,"|cache.write|=%ld\n",(long)NCZ_cache_size(cache));
 #endif
     entry = NULL;
 
@@ -372,7 +720,7 @@ verifycache(NCZChunkCache* cache)
 
 #if 0
     /* Sanity check; make sure at least one entry is always allowed */
-    if(nclistlength(cache->mru) == 1)
+    if(NCZ_cache_size(cache) == 1)
 	goto done;
 #endif
     if((stat = constraincache(cache,USEPARAMSIZE))) goto done;
@@ -386,14 +734,12 @@ static int
 flushcache(NCZChunkCache* cache)
 {
     int stat = NC_NOERR;
-#if 0
-    size_t oldsize = cache->params.size;
-    cache->params.size = 0;
-    stat = constraincache(cache,USEPARAMSIZE);
-    cache->params.size = oldsize;
-#else
-    stat = constraincache(cache,USEPARAMSIZE);
-#endif
+    NCZCacheEntry* e = NULL;
+    while((e = ncxcachelast(cache->xcache)) != NULL) {
+	int estat;
+	remove_entry(cache,e);
+	if((estat = evict_chunk(cache,e)) && stat == NC_NOERR) stat = estat;
+    }
     return stat;
 }
 
@@ -406,47 +752,65 @@ flushcache(NCZChunkCache* cache)
 @param needed make sure there is room for this much space; USEPARAMSIZE => ensure no more than  cache params is used.
 */
 
+static int
+constrainshared(NCZSharedCache* shared, size64_t needed)
+{
+    int stat = NC_NOERR;
+    size64_t final_size;
+
+    if(needed == USEPARAMSIZE)
+        final_size = shared->size;
+    else /* leave room for one more entry of the needed size */
+        final_size = (shared->size > needed ? shared->size - needed : 0);
+
+    /* Flush the least recently used chunks of any variable */
+    while(shared->used > final_size && shared->lru != NULL) {
+	NCZCacheEntry* e = shared->lru;
+	NCZChunkCache* owner = e->cache;
+	remove_entry(owner,e);
+	owner->stats.evictions++;
+	if((stat = evict_chunk(owner,e))) goto done;
+    }
+done:
+    return stat;
+}
+
 static int
 constraincache(NCZChunkCache* cache, size64_t needed)
 {
     int stat = NC_NOERR;
     size64_t final_size;
+    size64_t final_count;
+
+    /* A shared budget is constrained across all the variables */
+    if(cache->shared != NULL) {
+        stat = constrainshared(cache->shared,needed);
+        goto done;
+    }
 
     /* If the cache is empty then do nothing */
-    if(cache->used == 0) goto done;
+    if(cache->used == 0 && NCZ_cache_size(cache) == 0) goto done;
 
-    if(needed == USEPARAMSIZE)
+    if(needed == USEPARAMSIZE) {
         final_size = cache->params.size;
-    else if(cache->used > needed)
-        final_size = cache->used - needed;
-    else
-        final_size = 0;
+        final_count = cache->params.nelems;
+    } else { /* leave room for one more entry of the needed size */
+        final_size = (cache->params.size > needed ? cache->params.size - needed : 0);
+        final_count = (cache->params.nelems > 0 ? cache->params.nelems - 1 : 0);
+    }
 
     /* Flush from LRU end if we are at capacity */
-    while(nclistlength(cache->mru) > cache->params.nelems || cache->used > final_size) {
-	size_t i;
-	void* ptr;
+    while(NCZ_cache_size(cache) > final_count || cache->used > final_size) {
 	NCZCacheEntry* e = ncxcachelast(cache->xcache); /* last entry is the least recently used */
 	if(e == NULL) break;
-        if((stat = ncxcacheremove(cache->xcache,e->hashkey,&ptr))) goto done;
-   	assert(e == ptr);
-        for(i=0;i<nclistlength(cache->mru);i++) {
-	    e = nclistget(cache->mru,i);
-	    if(ptr == e) break;
-	}
-  	assert(e != NULL);
-	assert(i >= 0 && i < nclistlength(cache->mru));
-	nclistremove(cache->mru,i);
-	assert(cache->used >= e->size);
 	/* Note that |old chunk data| may not be same as |new chunk data| because of filters */
-	cache->used -= e->size; /* old size */
-	if(e->modified) /* flush to file */
-	    stat=put_chunk(cache,e);
-	/* reclaim */
-        nullfree(e->data); nullfree(e->key.varkey); nullfree(e->key.chunkkey); nullfree(e);
+	remove_entry(cache,e);
+	cache->stats.evictions++;
+	/* flush to file (maybe in the background) and reclaim */
+	if((stat = evict_chunk(cache,e))) goto done;
     }
 #ifdef DEBUG
-fprintf(stderr,"|cache.makeroom|=%ld\n",nclistlength(cache->mru));
+fprintf(stderr,"|cache.makeroom|=%ld\n",(long)NCZ_cache_size(cache));
 #endif
 done:
     return stat;
@@ -462,15 +826,17 @@ int
 NCZ_flush_chunk_cache(NCZChunkCache* cache)
 {
     int stat = NC_NOERR;
-    size_t i;
+    NCZCacheEntry* entry = NULL;
 
-    ZTRACE(4,"cache.var=%s |cache|=%d",cache->var->hdr.name,(int)nclistlength(cache->mru));
+    ZTRACE(4,"cache.var=%s |cache|=%d",cache->var->hdr.name,(int)NCZ_cache_size(cache));
+
+    /* Report any failure of the evicted chunks written in the background */
+    if((stat = drain_writes(cache))) goto done;
 
     if(NCZ_cache_size(cache) == 0) goto done;
     
-    /* Iterate over the entries in hashmap */
-    for(i=0;i<nclistlength(cache->mru);i++) {
-        NCZCacheEntry* entry = nclistget(cache->mru,i);
+    /* Iterate over the entries, least recently used first */
+    for(entry=ncxcachelast(cache->xcache);entry != NULL;entry=lruprev(cache,entry)) {
         if(entry->modified) {
 	    /* Write out this chunk in toto*/
   	    if((stat=put_chunk(cache,entry)))
@@ -479,19 +845,134 @@ NCZ_flush_chunk_cache(NCZChunkCache* cache)
         setmodified(entry,0);
     }
     /* Re-compute space used */
-    cache->used = 0;
-    for(i=0;i<nclistlength(cache->mru);i++) {
-        NCZCacheEntry* entry = nclistget(cache->mru,i);
-        cache->used += entry->size;
+    if(cache->shared != NULL) {
+        assert(cache->shared->used >= cache->used);
+        cache->shared->used -= cache->used;
     }
+    cache->used = 0;
+    for(entry=ncxcachelast(cache->xcache);entry != NULL;entry=lruprev(cache,entry))
+        addused(cache,entry->size);
     /* Make sure cache size and nelems are correct */
     if((stat=verifycache(cache))) goto done;
-
+    /* which may have evicted more chunks */
+    if((stat = drain_writes(cache))) goto done;
+    /* Store the chunks buffered in partly written shards */
+    if((stat = NCZ_shard_flush(cache->shards))) goto done;
 
 done:
     return ZUNTRACE(stat);
 }
 
+/**************************************************/
+/* Write-behind of evicted chunks */
+
+static int
+write_task(void* arg)
+{
+    struct ChunkTask* task = (struct ChunkTask*)arg;
+    NCZCacheEntry* e = task->entry;
+    int stat = put_chunk(task->cache,e);
+    nullfree(e->data); nullfree(e->key.varkey); nullfree(e->key.chunkkey); nullfree(e);
+    free(task);
+    return stat;
+}
+
+/* Is the chunk with this hashkey being written in the background? */
+static int
+write_pending(NCZChunkCache* cache, ncexhashkey_t hkey)
+{
+    uintptr_t data;
+    if(cache->writebehind.keys == NULL) return 0;
+    return (ncexhashget(cache->writebehind.keys,hkey,&data) == NC_NOERR);
+}
+
+/* Wait for all background writes of this cache;
+   return the first error any of them encountered. */
+static int
+drain_writes(NCZChunkCache* cache)
+{
+    int stat = NC_NOERR;
+    if(cache->writebehind.group != NULL)
+        stat = nctaskwait(cache->writebehind.group);
+    cache->writebehind.pending = 0;
+    cache->writebehind.count = 0;
+    ncexhashmapfree(cache->writebehind.keys);
+    cache->writebehind.keys = NULL;
+    return stat;
+}
+
+/* Make sure that put_chunk will not modify anything shared */
+static int
+prepare_write(NCZChunkCache* cache)
+{
+    int stat = NC_NOERR;
+    NC_VAR_INFO_T* var = cache->var;
+
+#ifdef NETCDF_ENABLE_NCZARR_FILTERS
+    if(nclistlength((NClist*)var->filters) > 0) {
+        if((stat = NCZ_ensure_filterchain(var,(NClist*)var->filters))) goto done;
+    }
+#endif
+    if(var->type_info->hdr.id == NC_STRING)
+        (void)NCZ_get_maxstrlen((NC_OBJ*)var); /* caches the value */
+#ifdef NETCDF_ENABLE_NCZARR_FILTERS
+done:
+#endif
+    return stat;
+}
+
+/* Write out (if modified) and reclaim an entry that has been
+   removed from the cache. If possible, the encoding and writing
+   is handed to the thread pool; the amount of data being written
+   in the background is bounded by the max in-flight bytes, if any. */
+static int
+evict_chunk(NCZChunkCache* cache, NCZCacheEntry* e)
+{
+    int stat = NC_NOERR;
+    NCglobalstate* ngs = NC_getglobalstate();
+    NC_FILE_INFO_T* file = (cache->var->container)->nc4_info;
+    NCZ_FILE_INFO_T* zfile = file->format_file_info;
+    NCthreadpool* pool = NULL;
+    struct ChunkTask* task = NULL;
+
+    if(!e->modified) goto reclaim;
+    /* The shard buffers are not shared with the pool */
+    if(cache->shards != NULL
+       || (pool = NCZ_threadpool()) == NULL
+       || !(nczmap_features(zfile->map->format) & NCZM_CONCURRENTWRITE)
+       || prepare_write(cache) != NC_NOERR) /* let put_chunk report it */
+        goto sync;
+    if(ngs->zarr.maxinflight > 0 /* 0 => unlimited */
+       && cache->writebehind.pending > 0
+       && cache->writebehind.pending + e->size > ngs->zarr.maxinflight) {
+        if((stat = drain_writes(cache))) goto sync;
+    }
+    if(cache->writebehind.group == NULL) {
+        if(nctaskgroupnew(pool,&cache->writebehind.group) != NC_NOERR)
+            {cache->writebehind.group = NULL; goto sync;}
+    }
+    if(cache->writebehind.keys == NULL) {
+        if((cache->writebehind.keys = ncexhashnew(0)) == NULL) goto sync;
+    }
+    if((task = calloc(1,sizeof(struct ChunkTask))) == NULL) goto sync;
+    task->cache = cache;
+    task->entry = e;
+    if(ncexhashput(cache->writebehind.keys,e->hashkey,(uintptr_t)0) != NC_NOERR)
+        {free(task); goto sync;}
+    cache->writebehind.pending += e->size;
+    if(++cache->writebehind.count > cache->stats.maxwrites)
+        cache->stats.maxwrites = cache->writebehind.count;
+    if(nctasksubmit(cache->writebehind.group,write_task,task) != NC_NOERR)
+        {free(task); goto sync;}
+    return NC_NOERR; /* e now belongs to the task */
+
+sync:
+    {int wstat = put_chunk(cache,e); if(stat == NC_NOERR) stat = wstat;}
+reclaim:
+    nullfree(e->data); nullfree(e->key.varkey); nullfree(e->key.chunkkey); nullfree(e);
+    return stat;
+}
+
 /* Ensure existence of some kind of fill chunk */
 int
 NCZ_ensure_fill_chunk(NCZChunkCache* cache)
@@ -579,6 +1060,156 @@ done:
     return THROW(stat);
 }
 
+/**************************************************/
+/* Raw chunk access: the chunk object as it is stored in the map,
+   i.e. after the filters, bypassing the cache (see nc_get_chunk_raw) */
+
+/* Locate the var, its cache and the indices of the chunk
+   whose first element is at startp. */
+static int
+chunk_raw_var(int ncid, int varid, const size_t* startp, NC_FILE_INFO_T** filep,
+              NCZChunkCache** cachep, size64_t* indices)
+{
+    int stat = NC_NOERR;
+    NC_VAR_INFO_T* var = NULL;
+    NCZ_VAR_INFO_T* zvar = NULL;
+    size_t r;
+
+    if((stat = ncz_find_grp_file_var(ncid,varid,filep,NULL,&var))) goto done;
+    zvar = (NCZ_VAR_INFO_T*)var->format_var_info;
+    if(zvar->cache == NULL) {stat = NC_EINTERNAL; goto done;}
+    if(var->ndims == 0)
+        indices[0] = 0; /* a scalar is one chunk */
+    for(r=0;r<var->ndims;r++)
+        indices[r] = (size64_t)(startp[r] / var->chunksizes[r]);
+    *cachep = zvar->cache;
+done:
+    return THROW(stat);
+}
+
+/* Keep the cache consistent with raw I/O of one chunk: before a read,
+   write out the cached copy if it is modified; before a write, drop the
+   cached copy. Either way, wait for a background write of the chunk. */
+static int
+chunk_raw_sync(NCZChunkCache* cache, const size64_t* indices, int reading)
+{
+    int stat = NC_NOERR;
+    ncexhashkey_t hkey = ncxcachekey(indices,sizeof(size64_t)*cache->ndims);
+    NCZCacheEntry* entry = NULL;
+
+    if(ncxcachelookup(cache->xcache,hkey,(void**)&entry) == NC_NOERR) {
+        if(!reading) {
+            remove_entry(cache,entry);
+            free_cache_entry(cache,entry);
+        } else if(entry->modified) {
+            remove_entry(cache,entry);
+            if((stat = evict_chunk(cache,entry))) goto done;
+        }
+    }
+    if(write_pending(cache,hkey)) {
+        if((stat = drain_writes(cache))) goto done;
+    }
+done:
+    return THROW(stat);
+}
+
+/**
+ * @internal Read one chunk as it is stored, i.e. after the filters.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk.
+ * @param sizep Gets the size of the stored chunk.
+ * @param datap If not NULL, gets a malloc'd copy of the stored chunk.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EEMPTY The chunk has never been written.
+ */
+int
+NCZ_get_chunk_raw(int ncid, int varid, const size_t* startp, size_t* sizep, void** datap)
+{
+    int stat = NC_NOERR;
+    NC_FILE_INFO_T* file = NULL;
+    NCZChunkCache* cache = NULL;
+    size64_t indices[NC_MAX_VAR_DIMS];
+    struct ChunkKey key = {NULL,NULL};
+    char* path = NULL;
+    size64_t size = 0;
+    NCZMAP* map = NULL;
+
+    if((stat = chunk_raw_var(ncid,varid,startp,&file,&cache,indices))) goto done;
+    map = ((NCZ_FILE_INFO_T*)file->format_file_info)->map;
+    if((stat = chunk_raw_sync(cache,indices,1))) goto done;
+    if(cache->shards != NULL) {
+        void* data = NULL;
+        stat = NCZ_shard_read(cache->shards,indices,&size,&data);
+        if(datap) *datap = data; else nullfree(data);
+        goto empty;
+    }
+    if((stat = NCZ_buildchunkpath(cache,indices,&key))) goto done;
+    path = NCZ_chunkpath(key);
+    if(datap)
+        stat = nczmap_readall(map,path,&size,datap);
+    else
+        stat = nczmap_len(map,path,&size);
+empty:
+    if(stat == NC_ENOOBJECT) stat = NC_EEMPTY;
+    if(stat) goto done;
+    if(sizep) *sizep = (size_t)size;
+done:
+    nullfree(path);
+    nullfree(key.varkey);
+    nullfree(key.chunkkey);
+    return stat;
+}
+
+/**
+ * @internal Write one chunk as it is to be stored, i.e. already
+ * filtered.
+ *
+ * @param ncid File or group ID.
+ * @param varid Variable ID.
+ * @param startp Coordinates of the first element of the chunk.
+ * @param size Size of the stored chunk.
+ * @param data The stored chunk.
+ *
+ * @return ::NC_NOERR No error.
+ * @return ::NC_EPERM File is read-only.
+ */
+int
+NCZ_put_chunk_raw(int ncid, int varid, const size_t* startp, size_t size, const void* data)
+{
+    int stat = NC_NOERR;
+    NC_FILE_INFO_T* file = NULL;
+    NCZChunkCache* cache = NULL;
+    size64_t indices[NC_MAX_VAR_DIMS];
+    struct ChunkKey key = {NULL,NULL};
+    char* path = NULL;
+    NCZMAP* map = NULL;
+
+    if((stat = chunk_raw_var(ncid,varid,startp,&file,&cache,indices))) goto done;
+    if(file->no_write) {stat = NC_EPERM; goto done;}
+    /* As for nc_put_vara: leave define mode */
+    if(file->flags & NC_INDEF) {
+	if(file->cmode & NC_CLASSIC_MODEL) {stat = NC_EINDEFINE; goto done;}
+	if((stat = ncz_enddef_netcdf4_file(file))) goto done;
+    }
+    map = ((NCZ_FILE_INFO_T*)file->format_file_info)->map;
+    if((stat = chunk_raw_sync(cache,indices,0))) goto done;
+    if(cache->shards != NULL) {
+        stat = NCZ_shard_write(cache->shards,indices,(size64_t)size,data);
+        goto done;
+    }
+    if((stat = NCZ_buildchunkpath(cache,indices,&key))) goto done;
+    path = NCZ_chunkpath(key);
+    if((stat = nczmap_write(map,path,(size64_t)size,data))) goto done;
+done:
+    nullfree(path);
+    nullfree(key.varkey);
+    nullfree(key.chunkkey);
+    return THROW(stat);
+}
+
 /**************************************************/
 /*
 From Zarr V2 Specification:
@@ -696,9 +1327,13 @@ put_chunk(NCZChunkCache* cache, NCZCacheEntry* entry)
     }
 #endif
 
-    path = NCZ_chunkpath(entry->key);
-    stat = nczmap_write(map,path,entry->size,entry->data);
-    nullfree(path); path = NULL;
+    if(cache->shards != NULL)
+        stat = NCZ_shard_write(cache->shards,entry->indices,entry->size,entry->data);
+    else {
+        path = NCZ_chunkpath(entry->key);
+        stat = nczmap_write(map,path,entry->size,entry->data);
+        nullfree(path); path = NULL;
+    }
 
     switch(stat) {
     case NC_NOERR:
@@ -713,10 +1348,9 @@ done:
 }
 
 /**
- * @internal Push data from memory to file.
+ * @internal Pull data from file into a new cache entry.
  *
  * @param cache Pointer to parent cache
- * @param key chunk key
  * @param entry cache entry to read into
  *
  * @return ::NC_NOERR No error.
@@ -724,17 +1358,60 @@ done:
  */
 static int
 get_chunk(NCZChunkCache* cache, NCZCacheEntry* entry)
+{
+    int stat = NC_NOERR;
+
+    if((stat = fetch_chunk(cache,entry))) goto done;
+
+    /* make room in the cache */
+    if((stat = constraincache(cache,entry->size))) goto done;
+
+    /* track new chunk */
+    addused(cache,entry->size);
+
+done:
+    return stat;
+}
+
+/* Make sure that fetch_chunk will not modify anything shared,
+   so that it can be called concurrently for different entries. */
+static int
+prepare_fetch(NCZChunkCache* cache)
+{
+    int stat = NC_NOERR;
+    NC_VAR_INFO_T* var = cache->var;
+
+    if((stat = NCZ_ensure_fill_chunk(cache))) goto done;
+#ifdef NETCDF_ENABLE_NCZARR_FILTERS
+    if(nclistlength((NClist*)var->filters) > 0) {
+        if((stat = NCZ_ensure_filterchain(var,(NClist*)var->filters))) goto done;
+    }
+#endif
+    if(var->type_info->hdr.id == NC_STRING)
+        (void)NCZ_get_maxstrlen((NC_OBJ*)var); /* caches the value */
+done:
+    return stat;
+}
+
+/**
+ * @internal Read a chunk from the map, fill it if it does not exist,
+ * and convert it to its in-memory form (unfiltered, char* strings).
+ * Only the entry is modified; the cache itself is left alone.
+ *
+ * @param cache Pointer to parent cache
+ * @param entry cache entry to read into
+ *
+ * @return ::NC_NOERR No error.
+ */
+static int
+fetch_chunk(NCZChunkCache* cache, NCZCacheEntry* entry)
 {
     int stat = NC_NOERR;
     NCZMAP* map = NULL;
     NC_FILE_INFO_T* file = NULL;
     NCZ_FILE_INFO_T* zfile = NULL;
-    NC_TYPE_INFO_T* xtype = NULL;
-    char** strchunk = NULL;
     size64_t size;
-    int empty = 0;
     char* path = NULL;
-    int tid;
 
     ZTRACE(5,"cache.var=%s entry.key=%s sep=%d",cache->var->hdr.name,entry->key,cache->dimension_separator);
     
@@ -745,36 +1422,55 @@ get_chunk(NCZChunkCache* cache, NCZCacheEntry* entry)
     map = zfile->map;
     assert(map);
 
+    /* Read the "raw" data on "disk" and its size in one map operation */
+    if(cache->shards != NULL)
+        stat = NCZ_shard_read(cache->shards,entry->indices,&size,&entry->data);
+    else {
+        path = NCZ_chunkpath(entry->key);
+        stat = nczmap_readall(map,path,&size,&entry->data);
+        nullfree(path); path = NULL;
+    }
+    if(stat == NC_NOERR) entry->size = size;
+    stat = decode_chunk(cache,entry,stat);
+    return ZUNTRACE(stat);
+}
+
+/**
+ * @internal Complete a chunk read from the map: fill it if it does
+ * not exist, and convert it to its in-memory form (unfiltered,
+ * char* strings). Only the entry is modified; the cache itself is
+ * left alone.
+ *
+ * @param cache Pointer to parent cache
+ * @param entry cache entry; if readstat is NC_NOERR, its data and
+ * size hold the raw chunk
+ * @param readstat outcome of reading the raw chunk from the map
+ *
+ * @return ::NC_NOERR No error.
+ */
+static int
+decode_chunk(NCZChunkCache* cache, NCZCacheEntry* entry, int readstat)
+{
+    int stat = NC_NOERR;
+    NC_FILE_INFO_T* file = NULL;
+    NC_TYPE_INFO_T* xtype = NULL;
+    char** strchunk = NULL;
+    int empty = 0;
+    int tid;
+
+    file = (cache->var->container)->nc4_info;
+
     /* Collect some info */
     xtype = cache->var->type_info;
     tid = xtype->hdr.id;
 
-    /* get size of the "raw" data on "disk" */
-    path = NCZ_chunkpath(entry->key);
-    stat = nczmap_len(map,path,&size);
-    nullfree(path); path = NULL;
-    switch(stat) {
-    case NC_NOERR: entry->size = size; break;
-    case NC_ENOOBJECT: case NC_EEMPTY: empty = 1; stat = NC_NOERR; break;
-    default: goto done;
+    switch(readstat) {
+    case NC_NOERR: break;
+    case NC_ENOOBJECT: case NC_EEMPTY: empty = 1; break;
+    default: stat = readstat; goto done;
     }
 
-    /* make room in the cache */
-    if((stat = constraincache(cache,size))) goto done;    
-
     if(!empty) {
-        /* Make sure we have a place to read it */
-        if((entry->data = (void*)calloc(1,entry->size)) == NULL)
-	    {stat = NC_ENOMEM; goto done;}
-	/* Read the raw data */
-        path = NCZ_chunkpath(entry->key);
-        stat = nczmap_read(map,path,0,entry->size,(char*)entry->data);
-        nullfree(path); path = NULL;
-        switch (stat) {
-        case NC_NOERR: break;
-        case NC_ENOOBJECT: case NC_EEMPTY: empty = 1; stat = NC_NOERR;break;
-	default: goto done;
-	}
         entry->isfiltered = (int)FILTERED(cache); /* Is the data being read filtered? */
 	if(tid == NC_STRING)
 	    entry->isfixedstring = 1; /* fill cache is in char[maxstrlen] format */
@@ -831,13 +1527,9 @@ get_chunk(NCZChunkCache* cache, NCZCacheEntry* entry)
 	entry->isfixedstring = 0;
     }
 
-    /* track new chunk */
-    cache->used += entry->size;
-
 done:
     nullfree(strchunk);
-    nullfree(path);
-    return ZUNTRACE(stat);
+    return stat;
 }
 
 int
@@ -893,6 +1585,7 @@ NCZ_printxcache(NCZChunkCache* cache)
     NCbytes* buf = ncbytesnew();
     char s[8192];
     size_t i;
+    NCZCacheEntry* e = NULL;
 
     ncbytescat(buf,"NCZChunkCache:\n");
     snprintf(s,sizeof(s),"\tvar=%s\n\tndims=%u\n\tchunksize=%u\n\tchunkcount=%u\n\tfillchunk=%p\n",
@@ -912,12 +1605,11 @@ NCZ_printxcache(NCZChunkCache* cache)
 	);
     ncbytescat(buf,s);
     
-    snprintf(s,sizeof(s),"\tmru: (%u)\n",(unsigned)nclistlength(cache->mru));
+    snprintf(s,sizeof(s),"\tlru: (%u)\n",(unsigned)NCZ_cache_size(cache));
     ncbytescat(buf,s);
-    if(nclistlength(cache->mru)==0)    
+    if(NCZ_cache_size(cache)==0)    
         ncbytescat(buf,"\t\t<empty>\n");
-    for(i=0;i<nclistlength(cache->mru);i++) {
-	NCZCacheEntry* e = (NCZCacheEntry*)nclistget(cache->mru,i);
+    for(i=0,e=ncxcachefirst(cache->xcache);e != NULL;i++,e=lrunext(cache,e)) {
 	snprintf(s,sizeof(s),"\t\t[%zu] ", i);
 	ncbytescat(buf,s);
 	if(e == NULL)
@@ -38,6 +38,8 @@
 #include "rnd.h"
 #include "ncbytes.h"
 #include "nchttp.h"
+#include "nclog.h"
+#include "ncpagecache.h"
 
 #define DEFAULTPAGESIZE 16384
 
@@ -46,7 +48,9 @@
 typedef struct NCHTTP {
     NC_HTTP_STATE* state;
     long long size; /* of the object */
-    NCbytes* interval;
+    NCbytes* interval; /* region handed out by httpio_get, reused */
+    NCbytes* fetched;  /* result of each byte-range request, reused */
+    NCpagecache* cache;
     int verbose;
 } NCHTTP;
 
@@ -58,6 +62,8 @@ static int httpio_sync(ncio *const nciop);
 static int httpio_filesize(ncio* nciop, off_t* filesizep);
 static int httpio_pad_length(ncio* nciop, off_t length);
 static int httpio_close(ncio* nciop, int);
+static int httpio_stats(ncio* nciop, NCpagestats* statsp);
+static int httpio_fetch(void* state, size64_t offset, size_t count, void* buf);
 
 static size_t pagesize = 0;
 
@@ -88,12 +94,15 @@ httpio_new(const char* path, int ioflags, ncio** nciopp, NCHTTP** hpp)
     *((ncio_filesizefunc**)&nciop->filesize) = httpio_filesize;
     *((ncio_pad_lengthfunc**)&nciop->pad_length) = httpio_pad_length;
     *((ncio_closefunc**)&nciop->close) = httpio_close;
+    *((ncio_statsfunc**)&nciop->stats) = httpio_stats;
 
     http = (NCHTTP*)calloc(1,sizeof(NCHTTP));
     if(http == NULL) {status = NC_ENOMEM; goto fail;}
     *((void* *)&nciop->pvt) = http;
 
     http->verbose = (getenv("CURLOPT_VERBOSE") == NULL ? 0 : 1);
+    http->interval = ncbytesnew();
+    http->fetched = ncbytesnew();
 
     if(nciopp) *nciopp = nciop;
     if(hpp) *hpp = http;
@@ -103,8 +112,8 @@ done:
 
 fail:
     if(http != NULL) {
-	if(http->interval)
-	    ncbytesfree(http->interval);
+	ncbytesfree(http->interval);
+	ncbytesfree(http->fetched);
 	free(http);
     }
     if(nciop != NULL) {
@@ -160,7 +169,7 @@ httpio_open(const char* path,
     ncio* *nciopp,
     /* ignored */ void** const mempp)
 {
-    ncio* nciop;
+    ncio* nciop = NULL;
     int status;
     NCHTTP* http = NULL;
     size_t sizehint;
@@ -177,6 +186,12 @@ httpio_open(const char* path,
     /* Open the path and get curl handle and object size */
     if((status = nc_http_open_verbose(path,http->verbose,&http->state))) goto done;
     if((status = nc_http_size(http->state,&http->size))) goto done;
+    {
+	size_t cpagesize, maxpages, readahead;
+	ncpagecacheparams(uri,&cpagesize,&maxpages,&readahead);
+	if((status = ncpagecachenew((size64_t)http->size,cpagesize,maxpages,readahead,
+				    httpio_fetch,http,&http->cache))) goto done;
+    }
 
     sizehint = pagesize;
 
@@ -187,6 +202,7 @@ httpio_open(const char* path,
     *sizehintp = sizehint;
     *nciopp = nciop;
 done:
+    ncurifree(uri);
     if(status)
         httpio_close(nciop,0);
     return status;
@@ -236,11 +252,13 @@ httpio_close(ncio* nciop, int doUnlink)
     http = (NCHTTP*)nciop->pvt;
     assert(http != NULL);
 
+    ncpagecachefree(http->cache); /* ncio_close reported its counters */
     status = nc_http_close(http->state);
 
     /* do cleanup  */
     if(http != NULL) {
 	ncbytesfree(http->interval);
+	ncbytesfree(http->fetched);
 	free(http);
     }
     if(nciop->path != NULL) free((char*)nciop->path);
@@ -261,17 +279,48 @@ httpio_get(ncio* const nciop, off_t offset, size_t extent, int rflags, void** co
     if(nciop == NULL || nciop->pvt == NULL) {status = NC_EINVAL; goto done;}
     http = (NCHTTP*)nciop->pvt;
 
-    assert(http->interval == NULL);
-    http->interval = ncbytesnew();
     ncbytessetalloc(http->interval,(unsigned long)extent);
-    if((status = nc_http_read(http->state,(size64_t)offset,extent,http->interval)))
-	goto done;
-    assert(ncbyteslength(http->interval) == extent);
-    if(vpp) *vpp = ncbytescontents(http->interval);
+    ncbytessetlength(http->interval,(unsigned long)extent);
+    {
+	/* As for a local file, the part past the end reads as zeros */
+	char* region = ncbytescontents(http->interval);
+	size_t avail = 0;
+	if(offset < http->size)
+	    avail = ((long long)offset + (long long)extent <= http->size ? extent : (size_t)(http->size - offset));
+	if((status = ncpagecacheread(http->cache,(size64_t)offset,avail,region)))
+	    goto done;
+	if(avail < extent)
+	    memset(region + avail,0,extent - avail);
+	if(vpp) *vpp = region;
+    }
 done:
     return status;
 }
 
+/* Page cache callback: one byte-range request */
+static int
+httpio_fetch(void* state, size64_t offset, size_t count, void* buf)
+{
+    int status = NC_NOERR;
+    NCHTTP* http = (NCHTTP*)state;
+
+    ncbytesclear(http->fetched);
+    if((status = nc_http_read(http->state,offset,count,http->fetched)))
+	return status;
+    if(ncbyteslength(http->fetched) != count)
+	return NC_EIO;
+    memcpy(buf,ncbytescontents(http->fetched),count);
+    return NC_NOERR;
+}
+
+static int
+httpio_stats(ncio* nciop, NCpagestats* statsp)
+{
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    ncpagecachestats(((NCHTTP*)nciop->pvt)->cache,statsp);
+    return NC_NOERR;
+}
+
 /*
  * Like memmove(), safely move possibly overlapping data.
  */
@@ -284,15 +333,9 @@ httpio_move(ncio* const nciop, off_t to, off_t from, size_t nbytes, int ignored)
 static int
 httpio_rel(ncio* const nciop, off_t offset, int rflags)
 {
-    int status = NC_NOERR;
-    NCHTTP* http;
-
-    if(nciop == NULL || nciop->pvt == NULL) {status = NC_EINVAL; goto done;}
-    http = (NCHTTP*)nciop->pvt;
-    ncbytesfree(http->interval);
-    http->interval = NULL;
-done:
-    return status;
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    /* the region buffer is kept for reuse by the next get */
+    return NC_NOERR;
 }
 
 /*
@@ -8,6 +8,8 @@
 #endif
 
 #include <stdlib.h>
+#include <errno.h>
+#include <string.h>
 
 #include "netcdf.h"
 #include "ncio.h"
@@ -15,6 +17,7 @@
 #include "ncuri.h"
 #include "ncrc.h"
 #include "ncutil.h"
+#include "nclog.h"
 
 /* With the advent of diskless io, we need to provide
    for multiple ncio packages at the same time,
@@ -49,10 +52,18 @@ extern int ffio_open(const char*,int,off_t,size_t,size_t*,void*,ncio**,void** co
      extern int memio_create(const char*,int,size_t,off_t,size_t,size_t*,void*,ncio**,void** const);
      extern int memio_open(const char*,int,off_t,size_t,size_t*,void*,ncio**,void** const);
 
+#ifdef NETCDF_ENABLE_IOURING
+    extern int uringio_create(const char*,int,size_t,off_t,size_t,size_t*,void*,ncio**,void** const);
+    extern int uringio_open(const char*,int,off_t,size_t,size_t*,void*,ncio**,void** const);
+#endif
+
 /* Forward */
 #ifdef NETCDF_ENABLE_BYTERANGE
 static int urlmodetest(const char* path);
 #endif
+#ifdef NETCDF_ENABLE_IOURING
+static int uringmodetest(int ioflags);
+#endif
 
 int
 ncio_create(const char *path, int ioflags, size_t initialsz,
@@ -70,6 +81,13 @@ ncio_create(const char *path, int ioflags, size_t initialsz,
         return mmapio_create(path,ioflags,initialsz,igeto,igetsz,sizehintp,parameters,iopp,mempp);
     }
 #  endif /*USE_MMAP*/
+#ifdef NETCDF_ENABLE_IOURING
+    if(uringmodetest(ioflags)) {
+        /* Fall back to posixio if the kernel has no io_uring */
+        int stat = uringio_create(path,ioflags,initialsz,igeto,igetsz,sizehintp,parameters,iopp,mempp);
+        if(stat != ENOSYS) return stat;
+    }
+#endif
 
 #ifdef USE_STDIO
     return stdio_create(path,ioflags,initialsz,igeto,igetsz,sizehintp,parameters,iopp,mempp);
@@ -114,6 +132,13 @@ ncio_open(const char *path, int ioflags,
    }
 #  endif
 #  endif /*NETCDF_ENABLE_BYTERANGE*/
+#ifdef NETCDF_ENABLE_IOURING
+    if(uringmodetest(ioflags)) {
+        /* Fall back to posixio if the kernel has no io_uring */
+        int stat = uringio_open(path,ioflags,igeto,igetsz,sizehintp,parameters,iopp,mempp);
+        if(stat != ENOSYS) return stat;
+    }
+#endif
 
 #ifdef USE_STDIO
     return stdio_open(path,ioflags,igeto,igetsz,sizehintp,parameters,iopp,mempp);
@@ -167,13 +192,32 @@ ncio_pad_length(ncio* const nciop, off_t length)
 int
 ncio_close(ncio* const nciop, int doUnlink)
 {
+    NCpagestats stats;
+    int status;
+
+    /* Report the read cache of remote files */
+    if(ncio_stats(nciop,&stats) == NC_NOERR && stats.requests > 0)
+        nclog(NCLOGNOTE,"page cache: path=%s hits=%llu misses=%llu readahead=%llu requests=%llu bytes=%llu",
+              nciop->path,stats.hits,stats.misses,stats.ahead,stats.requests,stats.bytes);
+
     /* close and release all resources associated
        with nciop, including nciop
     */
-    int status = nciop->close(nciop,doUnlink);
+    status = nciop->close(nciop,doUnlink);
     return status;
 }
 
+/* Counters are all zero for packages that keep none */
+int
+ncio_stats(ncio* const nciop, NCpagestats* statsp)
+{
+    if(nciop->stats == NULL) {
+        memset(statsp,0,sizeof(NCpagestats));
+        return NC_NOERR;
+    }
+    return nciop->stats(nciop,statsp);
+}
+
 /* URL utilities */
 
 /*
@@ -200,3 +244,21 @@ urlmodetest(const char* path)
     return kind;
 }
 #endif
+
+#ifdef NETCDF_ENABLE_IOURING
+/*
+Use io_uring if asked for by the NC_URING mode flag,
+the NETCDF_URING environment variable or the NETCDF.URING .rc key.
+Shared files are always left to posixio.
+*/
+static int
+uringmodetest(int ioflags)
+{
+    const char* value;
+    if(fIsSet(ioflags,NC_SHARE)) return 0;
+    if(fIsSet(ioflags,NC_URING)) return 1;
+    if((value = getenv("NETCDF_URING")) == NULL)
+        value = NC_rclookup("NETCDF.URING",NULL,NULL);
+    return (value != NULL && (strcmp(value,"1") == 0 || strcmp(value,"true") == 0));
+}
+#endif
@@ -10,6 +10,7 @@
 #include <stddef.h>	/* size_t */
 #include <sys/types.h>	/* off_t */
 #include "netcdf.h"
+#include "ncpagecache.h"
 
 /* Define internal use only flags to signal use of byte ranges and S3. */
 #define NC_HTTP  1
@@ -95,6 +96,12 @@ typedef int ncio_filesizefunc(ncio *nciop, off_t *filesizep);
 */
 typedef int ncio_closefunc(ncio *nciop, int doUnlink);
 
+/*
+ * Get the read cache counters of a remote (byte-range or S3) file.
+ * Optional: NULL for packages that keep none.
+ */
+typedef int ncio_statsfunc(ncio *nciop, NCpagestats *statsp);
+
 /* Get around cplusplus "const xxx in class ncio without constructor" error */
 #if defined(__cplusplus)
 #define NCIO_CONST
@@ -143,6 +150,8 @@ struct ncio {
 
 	/* implementation private stuff */
 	void *pvt;
+
+	ncio_statsfunc *NCIO_CONST stats;
 };
 
 #undef NCIO_CONST
@@ -156,6 +165,7 @@ extern int ncio_sync(ncio* const);
 extern int ncio_filesize(ncio* const, off_t*);
 extern int ncio_pad_length(ncio* const, off_t);
 extern int ncio_close(ncio* const, int);
+extern int ncio_stats(ncio* const, NCpagestats*);
 
 extern int ncio_create(const char *path, int ioflags, size_t initialsz,
                        off_t igeto, size_t igetsz, size_t *sizehintp,
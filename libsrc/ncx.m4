@@ -50,7 +50,8 @@ ifdef(`PNETCDF',`
 `#'include "macro.h"',`
 `#'pragma GCC diagnostic ignored "-Wdeprecated"
 `#'include "ncx.h"
-`#'include "nc3dispatch.h"')
+`#'include "nc3dispatch.h"
+`#'include "ncxsimd.h"')
 
 define(`IntType',  `ifdef(`PNETCDF', `MPI_Offset', `size_t')')dnl
 define(`APIPrefix',`ifdef(`PNETCDF', `ncmpi', `nc')')dnl
@@ -308,7 +309,12 @@ swapn2b(void *dst, const void *src, IntType nn)
     uint16_t *op = (uint16_t*) dst;
     uint16_t *ip = (uint16_t*) src;
     uint16_t tmp;
-    for (i=0; i<nn; i++) {
+#ifdef NCX_SIMD
+    i = (IntType)ncx_simd_swapn2b(dst, src, (size_t)nn);
+#else
+    i = 0;
+#endif
+    for (; i<nn; i++) {
         /* memcpy is used to handle the case of unaligned memory */
         memcpy(&tmp, &ip[i], sizeof(tmp));
         tmp = SWAP2(tmp);
@@ -335,7 +341,12 @@ swapn4b(void *dst, const void *src, IntType nn)
     uint32_t *op = (uint32_t*) dst;
     uint32_t *ip = (uint32_t*) src;
     uint32_t tmp;
-    for (i=0; i<nn; i++) {
+#ifdef NCX_SIMD
+    i = (IntType)ncx_simd_swapn4b(dst, src, (size_t)nn);
+#else
+    i = 0;
+#endif
+    for (; i<nn; i++) {
         /* memcpy is used to handle the case of unaligned memory */
         memcpy(&tmp, &ip[i], sizeof(tmp));
         tmp = SWAP4(tmp);
@@ -363,7 +374,12 @@ swapn8b(void *dst, const void *src, IntType nn)
     uint64_t *op = (uint64_t*) dst;
     uint64_t *ip = (uint64_t*) src;
     uint64_t tmp;
-    for (i=0; i<nn; i++) {
+#ifdef NCX_SIMD
+    i = (IntType)ncx_simd_swapn8b(dst, src, (size_t)nn);
+#else
+    i = 0;
+#endif
+    for (; i<nn; i++) {
         /* memcpy is used to handle the case of unaligned memory */
         memcpy(&tmp, &ip[i], sizeof(tmp));
         tmp = SWAP8(tmp);
@@ -2344,6 +2360,42 @@ APIPrefix`x_pad_getn_'NC_TYPE($1)_$2(const void **xpp, IntType nelems, $2 *tp)
 ')dnl
 dnl dnl dnl
 dnl
+dnl The (xtype, itype) pairs with a vector kernel in ncxsimd.c
+dnl
+define(`SIMD_GETN_short_float')dnl
+define(`SIMD_GETN_short_double')dnl
+define(`SIMD_GETN_int_short')dnl
+define(`SIMD_GETN_int_float')dnl
+define(`SIMD_GETN_int_double')dnl
+define(`SIMD_GETN_float_double')dnl
+define(`SIMD_GETN_double_float')dnl
+define(`SIMD_PUTN_float_double')dnl
+define(`SIMD_PUTN_double_float')dnl
+dnl
+dnl NCX_SIMD_GETN(xtype, itype)
+dnl
+define(`NCX_SIMD_GETN',dnl
+`dnl
+`#'ifdef NCX_SIMD
+	/* The kernel stops in front of any element needing the checks
+	 * of the scalar code, which then takes over for one block */
+	while (nelems >= NCX_SIMD_MIN && ncx_simd_level() != NCX_SIMD_NONE)
+	{
+		IntType n = (IntType)ncx_simd_getn_$1_$2(xp, (size_t)nelems, tp);
+		xp += n * Xsizeof($1);
+		tp += n;
+		nelems -= n;
+		for (n = Min(nelems, NCX_SIMD_BLOCK); n != 0; n--, nelems--, xp += Xsizeof($1), tp++)
+		{
+			const int lstatus = APIPrefix`x_get_'NC_TYPE($1)_$2(xp, tp);
+			if (status == NC_NOERR) /* report the first encountered error */
+				status = lstatus;
+		}
+	}
+`#'endif
+')dnl
+dnl dnl dnl
+dnl
 dnl NCX_GETN(xtype, itype)
 dnl
 define(`NCX_GETN',dnl
@@ -2401,6 +2453,7 @@ APIPrefix`x_getn_'NC_TYPE($1)_$2(const void **xpp, IntType nelems, $2 *tp)
 	const char *xp = (const char *) *xpp;
 	int status = NC_NOERR;
 
+ifdef(`SIMD_GETN_$1_$2', `NCX_SIMD_GETN($1, $2)')dnl
 	for( ; nelems != 0; nelems--, xp += Xsizeof($1), tp++)
 	{
 		const int lstatus = APIPrefix`x_get_'NC_TYPE($1)_$2(xp, tp);
@@ -2535,6 +2588,29 @@ APIPrefix`x_pad_putn_'NC_TYPE($1)_$2(void **xpp, IntType nelems, const $2 *tp, v
 ')dnl
 dnl dnl dnl
 dnl
+dnl NCX_SIMD_PUTN(xtype, itype)
+dnl
+define(`NCX_SIMD_PUTN',dnl
+`dnl
+`#'ifdef NCX_SIMD
+	/* The kernel stops like the one of the get */
+	while (nelems >= NCX_SIMD_MIN && ncx_simd_level() != NCX_SIMD_NONE)
+	{
+		IntType n = (IntType)ncx_simd_putn_$1_$2(xp, (size_t)nelems, tp);
+		xp += n * Xsizeof($1);
+		tp += n;
+		nelems -= n;
+		for (n = Min(nelems, NCX_SIMD_BLOCK); n != 0; n--, nelems--, xp += Xsizeof($1), tp++)
+		{
+			int lstatus = APIPrefix`x_put_'NC_TYPE($1)_$2(xp, tp, fillp);
+			if (status == NC_NOERR) /* report the first encountered error */
+				status = lstatus;
+		}
+	}
+`#'endif
+')dnl
+dnl dnl dnl
+dnl
 dnl NCX_PUTN(xtype, itype)
 dnl
 define(`NCX_PUTN',dnl
@@ -2610,6 +2686,7 @@ ifelse( $1$2, intfloat,dnl
 	char *xp = (char *) *xpp;
 	int status = NC_NOERR;
 
+ifdef(`SIMD_PUTN_$1_$2', `NCX_SIMD_PUTN($1, $2)')dnl
 	for( ; nelems != 0; nelems--, xp += Xsizeof($1), tp++)
 	{
 		int lstatus = APIPrefix`x_put_'NC_TYPE($1)_$2(xp, tp, fillp);
@@ -0,0 +1,832 @@
+/*
+ *	Copyright 2018, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+
+/*
+ * Vector kernels for ncx.c: byte swaps fused with the conversions
+ * used most when reading and writing classic files. The external
+ * representation is big endian, so on the hosts served here every
+ * element must be swapped; doing that a vector at a time, together
+ * with the conversion, keeps up with memory where the scalar loops
+ * of ncx.c do not.
+ *
+ * On x86-64 the kernels are compiled for SSE2 (always present), AVX2
+ * and AVX-512 (F+BW) with function target attributes, and the best
+ * one the cpu supports is chosen at run time. On AArch64 there is
+ * one NEON version. Setting NETCDF_SIMD to none, sse2, avx2, avx512
+ * or neon caps the level, e.g. to compare them.
+ *
+ * All loads and stores are unaligned; xp and tp need not be aligned.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include "ncxsimd.h"
+
+#ifdef NCX_SIMD
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
+static int simdlevel = -1; /* not yet known */
+
+/* Best level this cpu supports */
+static int
+cpulevel(void)
+{
+#if defined(NCX_SIMD) && defined(__x86_64__)
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return NCX_SIMD_AVX512;
+    if(__builtin_cpu_supports("avx2"))
+        return NCX_SIMD_AVX2;
+    return NCX_SIMD_SSE2;
+#elif defined(NCX_SIMD)
+    return NCX_SIMD_NEON;
+#else
+    return NCX_SIMD_NONE;
+#endif
+}
+
+const char*
+ncx_simd_name(int level)
+{
+    switch (level) {
+#if defined(__aarch64__)
+    case NCX_SIMD_NEON: return "neon";
+#else
+    case NCX_SIMD_SSE2: return "sse2";
+    case NCX_SIMD_AVX2: return "avx2";
+    case NCX_SIMD_AVX512: return "avx512";
+#endif
+    default: break;
+    }
+    return "none";
+}
+
+int
+ncx_simd_set_level(int level)
+{
+    int max = cpulevel();
+    if(level < NCX_SIMD_NONE) level = NCX_SIMD_NONE;
+    if(level > max) level = max;
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&simdlevel, level, __ATOMIC_RELAXED);
+#else
+    simdlevel = level;
+#endif
+    return level;
+}
+
+int
+ncx_simd_level(void)
+{
+    int level;
+#if defined(__GNUC__) || defined(__clang__)
+    level = __atomic_load_n(&simdlevel, __ATOMIC_RELAXED);
+#else
+    level = simdlevel;
+#endif
+    if(level < 0) {
+        const char* cap = getenv("NETCDF_SIMD");
+        level = cpulevel();
+        if(cap != NULL) {
+            int i;
+            for(i = NCX_SIMD_NONE; i <= level; i++)
+                if(strcmp(cap, ncx_simd_name(i)) == 0) break;
+            if(i <= level) level = i;
+        }
+        level = ncx_simd_set_level(level);
+    }
+    return level;
+}
+
+#ifdef NCX_SIMD
+
+#if defined(__x86_64__)
+/**************************************************/
+/* x86-64 */
+
+/* pshufb masks reversing the bytes of 2, 4 and 8 byte elements */
+#define SHUF16 _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14)
+#define SHUF32 _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12)
+#define SHUF64 _mm_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8)
+
+#define LOAD128(p) _mm_loadu_si128((const __m128i*)(const void*)(p))
+#define STORE128(p,v) _mm_storeu_si128((__m128i*)(void*)(p),(v))
+#define LOAD256(p) _mm256_loadu_si256((const __m256i*)(const void*)(p))
+#define STORE256(p,v) _mm256_storeu_si256((__m256i*)(void*)(p),(v))
+#define LOAD512(p) _mm512_loadu_si512((const void*)(p))
+#define STORE512(p,v) _mm512_storeu_si512((void*)(p),(v))
+
+/* SSE2 has no pshufb: swap the bytes of each 16 bit word,
+   then, for wider elements, the words */
+static inline __m128i
+bswap16_sse2(__m128i x)
+{
+    return _mm_or_si128(_mm_slli_epi16(x,8), _mm_srli_epi16(x,8));
+}
+
+static inline __m128i
+bswap32_sse2(__m128i x)
+{
+    x = bswap16_sse2(x);
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x,0xB1),0xB1);
+}
+
+static inline __m128i
+bswap64_sse2(__m128i x)
+{
+    x = bswap16_sse2(x);
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x,0x1B),0x1B);
+}
+
+/* Byte swaps, one per element size; return the number of bytes done */
+
+static size_t
+swap_sse2(unsigned char* d, const unsigned char* s, size_t nbytes, int size)
+{
+    size_t i = 0;
+    switch (size) {
+    case 2:
+        for(; i + 16 <= nbytes; i += 16) STORE128(d+i, bswap16_sse2(LOAD128(s+i)));
+        break;
+    case 4:
+        for(; i + 16 <= nbytes; i += 16) STORE128(d+i, bswap32_sse2(LOAD128(s+i)));
+        break;
+    default:
+        for(; i + 16 <= nbytes; i += 16) STORE128(d+i, bswap64_sse2(LOAD128(s+i)));
+        break;
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+swap_avx2(unsigned char* d, const unsigned char* s, size_t nbytes, int size)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(size == 2 ? SHUF16 : size == 4 ? SHUF32 : SHUF64);
+    size_t i;
+    for(i = 0; i + 64 <= nbytes; i += 64) {
+        __m256i a = LOAD256(s+i);
+        __m256i b = LOAD256(s+i+32);
+        STORE256(d+i, _mm256_shuffle_epi8(a,m));
+        STORE256(d+i+32, _mm256_shuffle_epi8(b,m));
+    }
+    for(; i + 32 <= nbytes; i += 32)
+        STORE256(d+i, _mm256_shuffle_epi8(LOAD256(s+i),m));
+    return i;
+}
+
+TARGET_AVX512 static size_t
+swap_avx512(unsigned char* d, const unsigned char* s, size_t nbytes, int size)
+{
+    const __m512i m = _mm512_broadcast_i32x4(size == 2 ? SHUF16 : size == 4 ? SHUF32 : SHUF64);
+    size_t i;
+    for(i = 0; i + 128 <= nbytes; i += 128) {
+        __m512i a = LOAD512(s+i);
+        __m512i b = LOAD512(s+i+64);
+        STORE512(d+i, _mm512_shuffle_epi8(a,m));
+        STORE512(d+i+64, _mm512_shuffle_epi8(b,m));
+    }
+    for(; i + 64 <= nbytes; i += 64)
+        STORE512(d+i, _mm512_shuffle_epi8(LOAD512(s+i),m));
+    return i;
+}
+
+static size_t
+swapn(void* dst, const void* src, size_t n, int size)
+{
+    unsigned char* d = (unsigned char*)dst;
+    const unsigned char* s = (const unsigned char*)src;
+    if(n < NCX_SIMD_MIN) return 0;
+    switch (ncx_simd_level()) {
+    case NCX_SIMD_AVX512: return swap_avx512(d,s,n*(size_t)size,size) / (size_t)size;
+    case NCX_SIMD_AVX2: return swap_avx2(d,s,n*(size_t)size,size) / (size_t)size;
+    case NCX_SIMD_SSE2: return swap_sse2(d,s,n*(size_t)size,size) / (size_t)size;
+    default: break;
+    }
+    return 0;
+}
+
+/* short -> float, double */
+
+static size_t
+short_float_sse2(const unsigned char* s, size_t n, float* tp)
+{
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m128i v = bswap16_sse2(LOAD128(s+2*i));
+        /* sign extend by shifting down from the top half */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v,v),16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v,v),16);
+        _mm_storeu_ps(tp+i, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(tp+i+4, _mm_cvtepi32_ps(hi));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+short_float_avx2(const unsigned char* s, size_t n, float* tp)
+{
+    const __m128i m = SHUF16;
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_cvtepi16_epi32(_mm_shuffle_epi8(LOAD128(s+2*i),m));
+        _mm256_storeu_ps(tp+i, _mm256_cvtepi32_ps(w));
+    }
+    return i;
+}
+
+TARGET_AVX512 static size_t
+short_float_avx512(const unsigned char* s, size_t n, float* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF16);
+    size_t i;
+    for(i = 0; i + 16 <= n; i += 16) {
+        __m512i w = _mm512_cvtepi16_epi32(_mm256_shuffle_epi8(LOAD256(s+2*i),m));
+        _mm512_storeu_ps(tp+i, _mm512_cvtepi32_ps(w));
+    }
+    return i;
+}
+
+static size_t
+short_double_sse2(const unsigned char* s, size_t n, double* tp)
+{
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m128i v = bswap16_sse2(LOAD128(s+2*i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v,v),16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v,v),16);
+        _mm_storeu_pd(tp+i, _mm_cvtepi32_pd(lo));
+        _mm_storeu_pd(tp+i+2, _mm_cvtepi32_pd(_mm_srli_si128(lo,8)));
+        _mm_storeu_pd(tp+i+4, _mm_cvtepi32_pd(hi));
+        _mm_storeu_pd(tp+i+6, _mm_cvtepi32_pd(_mm_srli_si128(hi,8)));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+short_double_avx2(const unsigned char* s, size_t n, double* tp)
+{
+    const __m128i m = SHUF16;
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_cvtepi16_epi32(_mm_shuffle_epi8(LOAD128(s+2*i),m));
+        _mm256_storeu_pd(tp+i, _mm256_cvtepi32_pd(_mm256_castsi256_si128(w)));
+        _mm256_storeu_pd(tp+i+4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(w,1)));
+    }
+    return i;
+}
+
+TARGET_AVX512 static size_t
+short_double_avx512(const unsigned char* s, size_t n, double* tp)
+{
+    const __m128i m = SHUF16;
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_cvtepi16_epi32(_mm_shuffle_epi8(LOAD128(s+2*i),m));
+        _mm512_storeu_pd(tp+i, _mm512_cvtepi32_pd(w));
+    }
+    return i;
+}
+
+/* int -> float, double */
+
+static size_t
+int_float_sse2(const unsigned char* s, size_t n, float* tp)
+{
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4)
+        _mm_storeu_ps(tp+i, _mm_cvtepi32_ps(bswap32_sse2(LOAD128(s+4*i))));
+    return i;
+}
+
+TARGET_AVX2 static size_t
+int_float_avx2(const unsigned char* s, size_t n, float* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF32);
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(tp+i, _mm256_cvtepi32_ps(_mm256_shuffle_epi8(LOAD256(s+4*i),m)));
+    return i;
+}
+
+TARGET_AVX512 static size_t
+int_float_avx512(const unsigned char* s, size_t n, float* tp)
+{
+    const __m512i m = _mm512_broadcast_i32x4(SHUF32);
+    size_t i;
+    for(i = 0; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(tp+i, _mm512_cvtepi32_ps(_mm512_shuffle_epi8(LOAD512(s+4*i),m)));
+    return i;
+}
+
+static size_t
+int_double_sse2(const unsigned char* s, size_t n, double* tp)
+{
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m128i v = bswap32_sse2(LOAD128(s+4*i));
+        _mm_storeu_pd(tp+i, _mm_cvtepi32_pd(v));
+        _mm_storeu_pd(tp+i+2, _mm_cvtepi32_pd(_mm_srli_si128(v,8)));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+int_double_avx2(const unsigned char* s, size_t n, double* tp)
+{
+    const __m128i m = SHUF32;
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(tp+i, _mm256_cvtepi32_pd(_mm_shuffle_epi8(LOAD128(s+4*i),m)));
+    return i;
+}
+
+TARGET_AVX512 static size_t
+int_double_avx512(const unsigned char* s, size_t n, double* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF32);
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(tp+i, _mm512_cvtepi32_pd(_mm256_shuffle_epi8(LOAD256(s+4*i),m)));
+    return i;
+}
+
+/* float -> double */
+
+static size_t
+float_double_sse2(const unsigned char* s, size_t n, double* tp)
+{
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m128 v = _mm_castsi128_ps(bswap32_sse2(LOAD128(s+4*i)));
+        _mm_storeu_pd(tp+i, _mm_cvtps_pd(v));
+        _mm_storeu_pd(tp+i+2, _mm_cvtps_pd(_mm_movehl_ps(v,v)));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+float_double_avx2(const unsigned char* s, size_t n, double* tp)
+{
+    const __m128i m = SHUF32;
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(tp+i, _mm256_cvtps_pd(_mm_castsi128_ps(_mm_shuffle_epi8(LOAD128(s+4*i),m))));
+    return i;
+}
+
+TARGET_AVX512 static size_t
+float_double_avx512(const unsigned char* s, size_t n, double* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF32);
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(tp+i, _mm512_cvtps_pd(_mm256_castsi256_ps(_mm256_shuffle_epi8(LOAD256(s+4*i),m))));
+    return i;
+}
+
+/* int -> short, stopping at a value out of range. A value fits in a
+   short if bits 15 to 31 are all equal, i.e. if shifting right by 15
+   and by 31 give the same result. */
+
+static size_t
+int_short_sse2(const unsigned char* s, size_t n, short* tp)
+{
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m128i a = bswap32_sse2(LOAD128(s+4*i));
+        __m128i b = bswap32_sse2(LOAD128(s+4*i+16));
+        __m128i oka = _mm_cmpeq_epi32(_mm_srai_epi32(a,15), _mm_srai_epi32(a,31));
+        __m128i okb = _mm_cmpeq_epi32(_mm_srai_epi32(b,15), _mm_srai_epi32(b,31));
+        if(_mm_movemask_epi8(_mm_and_si128(oka,okb)) != 0xFFFF) break;
+        STORE128(tp+i, _mm_packs_epi32(a,b));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+int_short_avx2(const unsigned char* s, size_t n, short* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF32);
+    size_t i;
+    for(i = 0; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_shuffle_epi8(LOAD256(s+4*i),m);
+        __m256i b = _mm256_shuffle_epi8(LOAD256(s+4*i+32),m);
+        __m256i oka = _mm256_cmpeq_epi32(_mm256_srai_epi32(a,15), _mm256_srai_epi32(a,31));
+        __m256i okb = _mm256_cmpeq_epi32(_mm256_srai_epi32(b,15), _mm256_srai_epi32(b,31));
+        if(_mm256_movemask_epi8(_mm256_and_si256(oka,okb)) != -1) break;
+        /* packs works within 128 bit lanes; put the quarters back in order */
+        STORE256(tp+i, _mm256_permute4x64_epi64(_mm256_packs_epi32(a,b),0xD8));
+    }
+    return i;
+}
+
+TARGET_AVX512 static size_t
+int_short_avx512(const unsigned char* s, size_t n, short* tp)
+{
+    const __m512i m = _mm512_broadcast_i32x4(SHUF32);
+    size_t i;
+    for(i = 0; i + 16 <= n; i += 16) {
+        __m512i a = _mm512_shuffle_epi8(LOAD512(s+4*i),m);
+        if(_mm512_cmpneq_epi32_mask(_mm512_srai_epi32(a,15), _mm512_srai_epi32(a,31))) break;
+        STORE256(tp+i, _mm512_cvtepi32_epi16(a));
+    }
+    return i;
+}
+
+/* double -> float, stopping at a value beyond FLT_MAX in magnitude
+   (including infinity); NaN converts like in the scalar code */
+
+static size_t
+double_float_sse2(const unsigned char* s, size_t n, float* tp)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d max = _mm_set1_pd((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m128d a = _mm_castsi128_pd(bswap64_sse2(LOAD128(s+8*i)));
+        __m128d b = _mm_castsi128_pd(bswap64_sse2(LOAD128(s+8*i+16)));
+        __m128d out = _mm_or_pd(_mm_cmpgt_pd(_mm_andnot_pd(sign,a),max),
+                                _mm_cmpgt_pd(_mm_andnot_pd(sign,b),max));
+        if(_mm_movemask_pd(out)) break;
+        _mm_storeu_ps(tp+i, _mm_movelh_ps(_mm_cvtpd_ps(a),_mm_cvtpd_ps(b)));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+double_float_avx2(const unsigned char* s, size_t n, float* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF64);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d max = _mm256_set1_pd((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m256d a = _mm256_castsi256_pd(_mm256_shuffle_epi8(LOAD256(s+8*i),m));
+        if(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign,a),max,_CMP_GT_OQ))) break;
+        _mm_storeu_ps(tp+i, _mm256_cvtpd_ps(a));
+    }
+    return i;
+}
+
+TARGET_AVX512 static size_t
+double_float_avx512(const unsigned char* s, size_t n, float* tp)
+{
+    const __m512i m = _mm512_broadcast_i32x4(SHUF64);
+    const __m512d max = _mm512_set1_pd((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m512d a = _mm512_castsi512_pd(_mm512_shuffle_epi8(LOAD512(s+8*i),m));
+        if(_mm512_cmp_pd_mask(_mm512_abs_pd(a),max,_CMP_GT_OQ)) break;
+        _mm256_storeu_ps(tp+i, _mm512_cvtpd_ps(a));
+    }
+    return i;
+}
+
+/* put: double -> external float, stopping like double_float */
+
+static size_t
+put_double_float_sse2(unsigned char* d, size_t n, const double* tp)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d max = _mm_set1_pd((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m128d a = _mm_loadu_pd(tp+i);
+        __m128d b = _mm_loadu_pd(tp+i+2);
+        __m128d out = _mm_or_pd(_mm_cmpgt_pd(_mm_andnot_pd(sign,a),max),
+                                _mm_cmpgt_pd(_mm_andnot_pd(sign,b),max));
+        if(_mm_movemask_pd(out)) break;
+        STORE128(d+4*i, bswap32_sse2(_mm_castps_si128(_mm_movelh_ps(_mm_cvtpd_ps(a),_mm_cvtpd_ps(b)))));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+put_double_float_avx2(unsigned char* d, size_t n, const double* tp)
+{
+    const __m128i m = SHUF32;
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d max = _mm256_set1_pd((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m256d a = _mm256_loadu_pd(tp+i);
+        if(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign,a),max,_CMP_GT_OQ))) break;
+        STORE128(d+4*i, _mm_shuffle_epi8(_mm_castps_si128(_mm256_cvtpd_ps(a)),m));
+    }
+    return i;
+}
+
+TARGET_AVX512 static size_t
+put_double_float_avx512(unsigned char* d, size_t n, const double* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF32);
+    const __m512d max = _mm512_set1_pd((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m512d a = _mm512_loadu_pd(tp+i);
+        if(_mm512_cmp_pd_mask(_mm512_abs_pd(a),max,_CMP_GT_OQ)) break;
+        STORE256(d+4*i, _mm256_shuffle_epi8(_mm256_castps_si256(_mm512_cvtpd_ps(a)),m));
+    }
+    return i;
+}
+
+/* put: float -> external double, stopping at an infinity */
+
+static size_t
+put_float_double_sse2(unsigned char* d, size_t n, const float* tp)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 max = _mm_set1_ps(FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(tp+i);
+        if(_mm_movemask_ps(_mm_cmpgt_ps(_mm_andnot_ps(sign,a),max))) break;
+        STORE128(d+8*i, bswap64_sse2(_mm_castpd_si128(_mm_cvtps_pd(a))));
+        STORE128(d+8*i+16, bswap64_sse2(_mm_castpd_si128(_mm_cvtps_pd(_mm_movehl_ps(a,a)))));
+    }
+    return i;
+}
+
+TARGET_AVX2 static size_t
+put_float_double_avx2(unsigned char* d, size_t n, const float* tp)
+{
+    const __m256i m = _mm256_broadcastsi128_si256(SHUF64);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 max = _mm_set1_ps(FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(tp+i);
+        if(_mm_movemask_ps(_mm_cmpgt_ps(_mm_andnot_ps(sign,a),max))) break;
+        STORE256(d+8*i, _mm256_shuffle_epi8(_mm256_castpd_si256(_mm256_cvtps_pd(a)),m));
+    }
+    return i;
+}
+
+TARGET_AVX512 static size_t
+put_float_double_avx512(unsigned char* d, size_t n, const float* tp)
+{
+    const __m512i m = _mm512_broadcast_i32x4(SHUF64);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 max = _mm256_set1_ps(FLT_MAX);
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        __m256 a = _mm256_loadu_ps(tp+i);
+        if(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign,a),max,_CMP_GT_OQ))) break;
+        STORE512(d+8*i, _mm512_shuffle_epi8(_mm512_castpd_si512(_mm512_cvtps_pd(a)),m));
+    }
+    return i;
+}
+
+/* Dispatch to the kernel of the current level */
+#define DISPATCH(kernel,xp,n,tp) \
+    if((n) < NCX_SIMD_MIN) return 0; \
+    switch (ncx_simd_level()) { \
+    case NCX_SIMD_AVX512: return kernel##_avx512((xp),(n),(tp)); \
+    case NCX_SIMD_AVX2: return kernel##_avx2((xp),(n),(tp)); \
+    case NCX_SIMD_SSE2: return kernel##_sse2((xp),(n),(tp)); \
+    default: break; \
+    } \
+    return 0;
+
+#else /*!__x86_64__*/
+/**************************************************/
+/* AArch64 */
+
+static size_t
+swapn(void* dst, const void* src, size_t n, int size)
+{
+    unsigned char* d = (unsigned char*)dst;
+    const unsigned char* s = (const unsigned char*)src;
+    size_t i = 0, nbytes = n * (size_t)size;
+    if(n < NCX_SIMD_MIN || ncx_simd_level() == NCX_SIMD_NONE) return 0;
+    switch (size) {
+    case 2:
+        for(; i + 16 <= nbytes; i += 16) vst1q_u8(d+i, vrev16q_u8(vld1q_u8(s+i)));
+        break;
+    case 4:
+        for(; i + 16 <= nbytes; i += 16) vst1q_u8(d+i, vrev32q_u8(vld1q_u8(s+i)));
+        break;
+    default:
+        for(; i + 16 <= nbytes; i += 16) vst1q_u8(d+i, vrev64q_u8(vld1q_u8(s+i)));
+        break;
+    }
+    return i / (size_t)size;
+}
+
+static size_t
+short_float_neon(const unsigned char* s, size_t n, float* tp)
+{
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        int16x8_t v = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(s+2*i)));
+        vst1q_f32(tp+i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+        vst1q_f32(tp+i+4, vcvtq_f32_s32(vmovl_high_s16(v)));
+    }
+    return i;
+}
+
+static size_t
+short_double_neon(const unsigned char* s, size_t n, double* tp)
+{
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        int16x8_t v = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(s+2*i)));
+        int32x4_t lo = vmovl_s16(vget_low_s16(v));
+        int32x4_t hi = vmovl_high_s16(v);
+        vst1q_f64(tp+i, vcvtq_f64_s64(vmovl_s32(vget_low_s32(lo))));
+        vst1q_f64(tp+i+2, vcvtq_f64_s64(vmovl_high_s32(lo)));
+        vst1q_f64(tp+i+4, vcvtq_f64_s64(vmovl_s32(vget_low_s32(hi))));
+        vst1q_f64(tp+i+6, vcvtq_f64_s64(vmovl_high_s32(hi)));
+    }
+    return i;
+}
+
+static size_t
+int_float_neon(const unsigned char* s, size_t n, float* tp)
+{
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4)
+        vst1q_f32(tp+i, vcvtq_f32_s32(vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(s+4*i)))));
+    return i;
+}
+
+static size_t
+int_double_neon(const unsigned char* s, size_t n, double* tp)
+{
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        int32x4_t v = vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(s+4*i)));
+        vst1q_f64(tp+i, vcvtq_f64_s64(vmovl_s32(vget_low_s32(v))));
+        vst1q_f64(tp+i+2, vcvtq_f64_s64(vmovl_high_s32(v)));
+    }
+    return i;
+}
+
+static size_t
+float_double_neon(const unsigned char* s, size_t n, double* tp)
+{
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        float32x4_t v = vreinterpretq_f32_u8(vrev32q_u8(vld1q_u8(s+4*i)));
+        vst1q_f64(tp+i, vcvt_f64_f32(vget_low_f32(v)));
+        vst1q_f64(tp+i+2, vcvt_high_f64_f32(v));
+    }
+    return i;
+}
+
+static size_t
+int_short_neon(const unsigned char* s, size_t n, short* tp)
+{
+    size_t i;
+    for(i = 0; i + 8 <= n; i += 8) {
+        int32x4_t a = vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(s+4*i)));
+        int32x4_t b = vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(s+4*i+16)));
+        int16x4_t na = vqmovn_s32(a);
+        int16x4_t nb = vqmovn_s32(b);
+        /* saturation changed some value iff one is out of range */
+        uint32x4_t ok = vandq_u32(vceqq_s32(vmovl_s16(na),a), vceqq_s32(vmovl_s16(nb),b));
+        if(vminvq_u32(ok) == 0) break;
+        vst1q_s16(tp+i, vcombine_s16(na,nb));
+    }
+    return i;
+}
+
+static size_t
+double_float_neon(const unsigned char* s, size_t n, float* tp)
+{
+    const float64x2_t max = vdupq_n_f64((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        float64x2_t a = vreinterpretq_f64_u8(vrev64q_u8(vld1q_u8(s+8*i)));
+        float64x2_t b = vreinterpretq_f64_u8(vrev64q_u8(vld1q_u8(s+8*i+16)));
+        uint64x2_t out = vorrq_u64(vcagtq_f64(a,max), vcagtq_f64(b,max));
+        if(vmaxvq_u32(vreinterpretq_u32_u64(out)) != 0) break;
+        vst1q_f32(tp+i, vcvt_high_f32_f64(vcvt_f32_f64(a),b));
+    }
+    return i;
+}
+
+static size_t
+put_double_float_neon(unsigned char* d, size_t n, const double* tp)
+{
+    const float64x2_t max = vdupq_n_f64((double)FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        float64x2_t a = vld1q_f64(tp+i);
+        float64x2_t b = vld1q_f64(tp+i+2);
+        uint64x2_t out = vorrq_u64(vcagtq_f64(a,max), vcagtq_f64(b,max));
+        if(vmaxvq_u32(vreinterpretq_u32_u64(out)) != 0) break;
+        vst1q_u8(d+4*i, vrev32q_u8(vreinterpretq_u8_f32(vcvt_high_f32_f64(vcvt_f32_f64(a),b))));
+    }
+    return i;
+}
+
+static size_t
+put_float_double_neon(unsigned char* d, size_t n, const float* tp)
+{
+    const float32x4_t max = vdupq_n_f32(FLT_MAX);
+    size_t i;
+    for(i = 0; i + 4 <= n; i += 4) {
+        float32x4_t a = vld1q_f32(tp+i);
+        if(vmaxvq_u32(vcagtq_f32(a,max)) != 0) break;
+        vst1q_u8(d+8*i, vrev64q_u8(vreinterpretq_u8_f64(vcvt_f64_f32(vget_low_f32(a)))));
+        vst1q_u8(d+8*i+16, vrev64q_u8(vreinterpretq_u8_f64(vcvt_high_f64_f32(a))));
+    }
+    return i;
+}
+
+#define DISPATCH(kernel,xp,n,tp) \
+    if((n) < NCX_SIMD_MIN || ncx_simd_level() == NCX_SIMD_NONE) return 0; \
+    return kernel##_neon((xp),(n),(tp));
+
+#endif /*__x86_64__*/
+
+/**************************************************/
+/* Entry points */
+
+size_t
+ncx_simd_swapn2b(void* dst, const void* src, size_t n)
+{
+    return swapn(dst,src,n,2);
+}
+
+size_t
+ncx_simd_swapn4b(void* dst, const void* src, size_t n)
+{
+    return swapn(dst,src,n,4);
+}
+
+size_t
+ncx_simd_swapn8b(void* dst, const void* src, size_t n)
+{
+    return swapn(dst,src,n,8);
+}
+
+size_t
+ncx_simd_getn_short_float(const void* xp, size_t n, float* tp)
+{
+    DISPATCH(short_float,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_getn_short_double(const void* xp, size_t n, double* tp)
+{
+    DISPATCH(short_double,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_getn_int_float(const void* xp, size_t n, float* tp)
+{
+    DISPATCH(int_float,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_getn_int_double(const void* xp, size_t n, double* tp)
+{
+    DISPATCH(int_double,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_getn_float_double(const void* xp, size_t n, double* tp)
+{
+    DISPATCH(float_double,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_getn_int_short(const void* xp, size_t n, short* tp)
+{
+    DISPATCH(int_short,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_getn_double_float(const void* xp, size_t n, float* tp)
+{
+    DISPATCH(double_float,(const unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_putn_float_double(void* xp, size_t n, const double* tp)
+{
+    DISPATCH(put_double_float,(unsigned char*)xp,n,tp)
+}
+
+size_t
+ncx_simd_putn_double_float(void* xp, size_t n, const float* tp)
+{
+    DISPATCH(put_float_double,(unsigned char*)xp,n,tp)
+}
+
+#endif /*NCX_SIMD*/
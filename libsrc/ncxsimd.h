@@ -0,0 +1,80 @@
+/*
+ *	Copyright 2018, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+
+#ifndef _NCXSIMD_H_
+#define _NCXSIMD_H_
+
+#include <stddef.h> /* size_t */
+
+/*
+ * Vector kernels for the most used external <-> internal conversions
+ * of ncx.c; see ncxsimd.c.
+ *
+ * NCX_SIMD is defined where kernels exist: little endian x86-64
+ * (SSE2, AVX2, AVX-512, selected at run time) and AArch64 (NEON),
+ * with gcc or clang. Elsewhere ncx.c uses only its scalar code.
+ *
+ * A kernel converts a prefix of its input and returns the number of
+ * elements done. The range checked kernels stop in front of the
+ * first vector holding a value that is out of range (or infinite),
+ * so that ncx.c can deal with it with the scalar code, which owns
+ * the NC_ERANGE and fill value rules.
+ */
+
+#if !defined(WORDS_BIGENDIAN) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || (defined(__aarch64__) && defined(__ARM_NEON)))
+#define NCX_SIMD 1
+#endif
+
+/* Instruction set levels */
+#define NCX_SIMD_NONE   0
+#define NCX_SIMD_SSE2   1
+#define NCX_SIMD_NEON   1
+#define NCX_SIMD_AVX2   2
+#define NCX_SIMD_AVX512 3
+
+/* Shorter arrays are left to the scalar code */
+#define NCX_SIMD_MIN 32
+/* Number of elements left to the scalar code when a kernel stops short */
+#define NCX_SIMD_BLOCK 16
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* Level in use: the best the cpu has, capped by $NETCDF_SIMD
+   (none, sse2, avx2, avx512 or neon) */
+extern int ncx_simd_level(void);
+/* Change the level, e.g. to benchmark; returns the level in use,
+   which is never above what the cpu has */
+extern int ncx_simd_set_level(int level);
+extern const char* ncx_simd_name(int level);
+
+#ifdef NCX_SIMD
+/* Byte swaps; dst may be src */
+extern size_t ncx_simd_swapn2b(void* dst, const void* src, size_t n);
+extern size_t ncx_simd_swapn4b(void* dst, const void* src, size_t n);
+extern size_t ncx_simd_swapn8b(void* dst, const void* src, size_t n);
+
+/* external -> internal */
+extern size_t ncx_simd_getn_short_float(const void* xp, size_t n, float* tp);
+extern size_t ncx_simd_getn_short_double(const void* xp, size_t n, double* tp);
+extern size_t ncx_simd_getn_int_float(const void* xp, size_t n, float* tp);
+extern size_t ncx_simd_getn_int_double(const void* xp, size_t n, double* tp);
+extern size_t ncx_simd_getn_float_double(const void* xp, size_t n, double* tp);
+/* range checked */
+extern size_t ncx_simd_getn_int_short(const void* xp, size_t n, short* tp);
+extern size_t ncx_simd_getn_double_float(const void* xp, size_t n, float* tp);
+
+/* internal -> external, range checked */
+extern size_t ncx_simd_putn_float_double(void* xp, size_t n, const double* tp);
+extern size_t ncx_simd_putn_double_float(void* xp, size_t n, const float* tp);
+#endif /*NCX_SIMD*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /*_NCXSIMD_H_*/
@@ -1549,6 +1549,7 @@ ncio_px_new(const char *path, int ioflags)
 
 				/* cast away const */
 	*((void **)&nciop->pvt) = (void *)(nciop->path + sz_path);
+	*((ncio_statsfunc **)&nciop->stats) = NULL; /* no read cache */
 
 	if(fIsSet(ioflags, NC_SHARE))
 		ncio_spx_init(nciop);
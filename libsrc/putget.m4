@@ -34,10 +34,12 @@ dnl
 
 static int
 readNCv(const NC3_INFO* ncp, const NC_var* varp, const size_t* start,
-        const size_t nelems, void* value, const nc_type memtype);
+        const size_t nelems, const off_t xstep, void* value,
+        const nc_type memtype);
 static int
 writeNCv(NC3_INFO* ncp, const NC_var* varp, const size_t* start,
-         const size_t nelems, const void* value, const nc_type memtype);
+         const size_t nelems, const off_t xstep, const void* value,
+         const nc_type memtype);
 
 
 /* #define ODEBUG 1 */
@@ -624,6 +626,79 @@ NC_varoffset(const NC3_INFO* ncp, const NC_var *varp, const size_t *coord)
 }
 
 
+/*
+ * Copy 'n' external items of 'xsz' bytes that lie 'step' bytes
+ * apart at 'src' into contiguous storage at 'dst', so that they can
+ * be converted with a single ncx_getn_* call.
+ */
+static void
+NCgather(void *dst, const void *src, size_t n, size_t step, size_t xsz)
+{
+	char *dp = (char *)dst;
+	const char *sp = (const char *)src;
+	size_t i;
+
+	switch(xsz) {
+	case 1:
+		for(i = 0; i < n; i++, sp += step)
+			dp[i] = *sp;
+		break;
+	case 2:
+		for(i = 0; i < n; i++, dp += 2, sp += step)
+			memcpy(dp, sp, 2);
+		break;
+	case 4:
+		for(i = 0; i < n; i++, dp += 4, sp += step)
+			memcpy(dp, sp, 4);
+		break;
+	case 8:
+		for(i = 0; i < n; i++, dp += 8, sp += step)
+			memcpy(dp, sp, 8);
+		break;
+	default:
+		for(i = 0; i < n; i++, dp += xsz, sp += step)
+			memcpy(dp, sp, xsz);
+		break;
+	}
+}
+
+/*
+ * The reverse of NCgather: spread 'n' contiguous external items
+ * of 'xsz' bytes at 'src' so that they lie 'step' bytes apart at
+ * 'dst', leaving the bytes in between alone.
+ */
+static void
+NCscatter(void *dst, const void *src, size_t n, size_t step, size_t xsz)
+{
+	char *dp = (char *)dst;
+	const char *sp = (const char *)src;
+	size_t i;
+
+	switch(xsz) {
+	case 1:
+		for(i = 0; i < n; i++, dp += step)
+			*dp = sp[i];
+		break;
+	case 2:
+		for(i = 0; i < n; i++, dp += step, sp += 2)
+			memcpy(dp, sp, 2);
+		break;
+	case 4:
+		for(i = 0; i < n; i++, dp += step, sp += 4)
+			memcpy(dp, sp, 4);
+		break;
+	case 8:
+		for(i = 0; i < n; i++, dp += step, sp += 8)
+			memcpy(dp, sp, 8);
+		break;
+	default:
+		for(i = 0; i < n; i++, dp += step, sp += xsz)
+			memcpy(dp, sp, xsz);
+		break;
+	}
+}
+
+
 dnl
 dnl Output 'nelems' items of contiguous data of type "Type"
 dnl for variable 'varp' at 'start'.
@@ -632,11 +707,90 @@ dnl---
 dnl
 dnl PUTNCVX(Xtype, Type)
 dnl
+dnl The putNCvsx_* variants write 'nelems' items that lie 'xstep'
+dnl bytes apart in the file, packing as many of them as fit into
+dnl one ncio region. Each region's worth is converted with a single
+dnl ncx_putn_* call into a contiguous buffer and then scattered into
+dnl the region. A zero 'xstep' means the data is contiguous.
+dnl
 define(`PUTNCVX',dnl
 `dnl
+static int
+putNCvsx_$1_$2(NC3_INFO* ncp, const NC_var *varp,
+		 const size_t *start, size_t nelems, off_t xstep,
+		 const $2 *value)
+{
+	off_t offset = NC_varoffset(ncp, varp, start);
+	size_t step = (size_t)xstep;
+	size_t per = 1; /* items per ncio region */
+	int status = NC_NOERR;
+	void *xp;
+	void *buf = NULL;
+        void *fillp=NULL;
+
+	NC_UNUSED(fillp);
+
+	if(nelems == 0)
+		return NC_NOERR;
+
+	assert(value != NULL);
+
+	if(step < ncp->chunk && varp->xsz <= ncp->chunk)
+		per = (ncp->chunk - varp->xsz) / step + 1;
+
+	buf = malloc(MIN(nelems, per) * varp->xsz);
+	if(buf == NULL)
+		return NC_ENOMEM;
+
+#ifdef ERANGE_FILL
+        fillp = malloc(varp->xsz);
+        status = NC3_inq_var_fill(varp, fillp);
+#endif
+
+	for(;;)
+	{
+		void *bp = buf;
+		size_t nput = MIN(nelems, per);
+		size_t extent = step * (nput - 1) + varp->xsz;
+
+		int lstatus = ncio_get(ncp->nciop, offset, extent,
+				 RGN_WRITE, &xp);
+		if(lstatus != NC_NOERR)
+		{
+			status = lstatus;
+			break; /* free fillp */
+		}
+
+		lstatus = ncx_putn_$1_$2(&bp, nput, value ifelse(`$1',`char',,`,fillp'));
+		if(lstatus != NC_NOERR && status == NC_NOERR)
+		{
+			/* not fatal to the loop */
+			status = lstatus;
+		}
+		NCscatter(xp, buf, nput, step, varp->xsz);
+
+		(void) ncio_rel(ncp->nciop, offset,
+				 RGN_MODIFIED);
+
+		nelems -= nput;
+		if(nelems == 0)
+			break; /* normal loop exit */
+		offset += (off_t)(step * nput);
+		value += nput;
+
+	}
+#ifdef ERANGE_FILL
+        free(fillp);
+#endif
+	free(buf);
+
+	return status;
+}
+
 static int
 putNCvx_$1_$2(NC3_INFO* ncp, const NC_var *varp,
-		 const size_t *start, size_t nelems, const $2 *value)
+		 const size_t *start, size_t nelems, off_t xstep,
+		 const $2 *value)
 {
 	off_t offset = NC_varoffset(ncp, varp, start);
 	size_t remaining = varp->xsz * nelems;
@@ -646,6 +800,9 @@ putNCvx_$1_$2(NC3_INFO* ncp, const NC_var *varp,
 
 	NC_UNUSED(fillp);
 
+	if(xstep != 0)
+		return putNCvsx_$1_$2(ncp, varp, start, nelems, xstep, value);
+
 	if(nelems == 0)
 		return NC_NOERR;
 
@@ -664,7 +821,10 @@ putNCvx_$1_$2(NC3_INFO* ncp, const NC_var *varp,
 		int lstatus = ncio_get(ncp->nciop, offset, extent,
 				 RGN_WRITE, &xp);
 		if(lstatus != NC_NOERR)
-			return lstatus;
+		{
+			status = lstatus;
+			break; /* free fillp */
+		}
 
 		lstatus = ncx_putn_$1_$2(&xp, nput, value ifelse(`$1',`char',,`,fillp'));
 		if(lstatus != NC_NOERR && status == NC_NOERR)
@@ -806,17 +966,82 @@ PUTNCVX(ulonglong, ulonglong)
 dnl
 dnl GETNCVX(XType, Type)
 dnl
+dnl The getNCvsx_* variants read 'nelems' items that lie 'xstep'
+dnl bytes apart in the file, so one ncio region serves many of them.
+dnl The items of a region are gathered into a contiguous buffer and
+dnl converted with a single ncx_getn_* call. A zero 'xstep' means the
+dnl data is contiguous.
+dnl
 define(`GETNCVX',dnl
 `dnl
+static int
+getNCvsx_$1_$2(const NC3_INFO* ncp, const NC_var *varp,
+		 const size_t *start, size_t nelems, off_t xstep, $2 *value)
+{
+	off_t offset = NC_varoffset(ncp, varp, start);
+	size_t step = (size_t)xstep;
+	size_t per = 1; /* items per ncio region */
+	int status = NC_NOERR;
+	const void *xp;
+	void *buf = NULL;
+
+	if(nelems == 0)
+		return NC_NOERR;
+
+	assert(value != NULL);
+
+	if(step < ncp->chunk && varp->xsz <= ncp->chunk)
+		per = (ncp->chunk - varp->xsz) / step + 1;
+
+	buf = malloc(MIN(nelems, per) * varp->xsz);
+	if(buf == NULL)
+		return NC_ENOMEM;
+
+	for(;;)
+	{
+		const void *bp = buf;
+		size_t nget = MIN(nelems, per);
+		size_t extent = step * (nget - 1) + varp->xsz;
+
+		int lstatus = ncio_get(ncp->nciop, offset, extent,
+				 0, (void **)&xp);	/* cast away const */
+		if(lstatus != NC_NOERR)
+		{
+			status = lstatus;
+			break; /* free buf */
+		}
+
+		NCgather(buf, xp, nget, step, varp->xsz);
+
+		(void) ncio_rel(ncp->nciop, offset, 0);
+
+		lstatus = ncx_getn_$1_$2(&bp, nget, value);
+		if(lstatus != NC_NOERR && status == NC_NOERR)
+			status = lstatus;
+
+		nelems -= nget;
+		if(nelems == 0)
+			break; /* normal loop exit */
+		offset += (off_t)(step * nget);
+		value += nget;
+	}
+	free(buf);
+
+	return status;
+}
+
 static int
 getNCvx_$1_$2(const NC3_INFO* ncp, const NC_var *varp,
-		 const size_t *start, size_t nelems, $2 *value)
+		 const size_t *start, size_t nelems, off_t xstep, $2 *value)
 {
 	off_t offset = NC_varoffset(ncp, varp, start);
 	size_t remaining = varp->xsz * nelems;
 	int status = NC_NOERR;
 	const void *xp;
 
+	if(xstep != 0)
+		return getNCvsx_$1_$2(ncp, varp, start, nelems, xstep, value);
+
 	if(nelems == 0)
 		return NC_NOERR;
 
@@ -1133,326 +1358,327 @@ ifelse($1, text,dnl
 
 static int
 readNCv(const NC3_INFO* ncp, const NC_var* varp, const size_t* start,
-        const size_t nelems, void* value, const nc_type memtype)
+        const size_t nelems, const off_t xstep, void* value,
+        const nc_type memtype)
 {
     int status = NC_NOERR;
     switch (CASE(varp->type,memtype)) {
 
     case CASE(NC_CHAR,NC_CHAR):
     case CASE(NC_CHAR,NC_UBYTE):
-    return getNCvx_schar_schar(ncp,varp,start,nelems,(signed char*)value);
+    return getNCvx_schar_schar(ncp,varp,start,nelems,xstep,(signed char*)value);
     break;
     case CASE(NC_BYTE,NC_BYTE):
-        return getNCvx_schar_schar(ncp,varp,start,nelems, (schar*)value);
+        return getNCvx_schar_schar(ncp,varp,start,nelems,xstep, (schar*)value);
 	break;
     case CASE(NC_BYTE,NC_UBYTE):
         if (fIsSet(ncp->flags,NC_64BIT_DATA))
-            return getNCvx_schar_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+            return getNCvx_schar_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
         else
             /* for CDF-1 and CDF-2, NC_BYTE is treated the same type as uchar memtype */
-            return getNCvx_uchar_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+            return getNCvx_uchar_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_BYTE,NC_SHORT):
-        return getNCvx_schar_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_schar_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_BYTE,NC_INT):
-        return getNCvx_schar_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_schar_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_BYTE,NC_FLOAT):
-        return getNCvx_schar_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_schar_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_BYTE,NC_DOUBLE):
-        return getNCvx_schar_double(ncp,varp,start,nelems,(double *)value);
+        return getNCvx_schar_double(ncp,varp,start,nelems,xstep,(double *)value);
 	break;
     case CASE(NC_BYTE,NC_INT64):
-        return getNCvx_schar_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_schar_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_BYTE,NC_UINT):
-        return getNCvx_schar_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_schar_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_BYTE,NC_UINT64):
-        return getNCvx_schar_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_schar_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
     	break;
     case CASE(NC_BYTE,NC_USHORT):
-        return getNCvx_schar_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_schar_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_SHORT,NC_BYTE):
-        return getNCvx_short_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_short_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_SHORT,NC_UBYTE):
-        return getNCvx_short_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_short_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_SHORT,NC_SHORT):
-        return getNCvx_short_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_short_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_SHORT,NC_INT):
-        return getNCvx_short_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_short_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
    case CASE(NC_SHORT,NC_FLOAT):
-        return getNCvx_short_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_short_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_SHORT,NC_DOUBLE):
-        return getNCvx_short_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_short_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_SHORT,NC_INT64):
-        return getNCvx_short_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_short_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
    	break;
     case CASE(NC_SHORT,NC_UINT):
-        return getNCvx_short_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_short_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
     	break;
     case CASE(NC_SHORT,NC_UINT64):
-        return getNCvx_short_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_short_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_SHORT,NC_USHORT):
-        return getNCvx_short_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_short_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_INT,NC_BYTE):
-        return getNCvx_int_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_int_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_INT,NC_UBYTE):
-        return getNCvx_int_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_int_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_INT,NC_SHORT):
-        return getNCvx_int_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_int_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_INT,NC_INT):
-        return getNCvx_int_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_int_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_INT,NC_FLOAT):
-        return getNCvx_int_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_int_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_INT,NC_DOUBLE):
-        return getNCvx_int_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_int_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_INT,NC_INT64):
-        return getNCvx_int_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_int_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_INT,NC_UINT):
-        return getNCvx_int_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_int_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_INT,NC_UINT64):
-        return getNCvx_int_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_int_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_INT,NC_USHORT):
-        return getNCvx_int_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_int_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_FLOAT,NC_BYTE):
-        return getNCvx_float_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_float_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_FLOAT,NC_UBYTE):
-        return getNCvx_float_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_float_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_FLOAT,NC_SHORT):
-        return getNCvx_float_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_float_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_FLOAT,NC_INT):
-        return getNCvx_float_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_float_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_FLOAT,NC_FLOAT):
-        return getNCvx_float_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_float_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_FLOAT,NC_DOUBLE):
-        return getNCvx_float_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_float_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_FLOAT,NC_INT64):
-        return getNCvx_float_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_float_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_FLOAT,NC_UINT):
-        return getNCvx_float_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_float_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_FLOAT,NC_UINT64):
-        return getNCvx_float_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_float_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_FLOAT,NC_USHORT):
-        return getNCvx_float_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_float_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_DOUBLE,NC_BYTE):
-        return getNCvx_double_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_double_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_DOUBLE,NC_UBYTE):
-        return getNCvx_double_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_double_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_DOUBLE,NC_SHORT):
-        return getNCvx_double_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_double_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_DOUBLE,NC_INT):
-        return getNCvx_double_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_double_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_DOUBLE,NC_FLOAT):
-        return getNCvx_double_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_double_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_DOUBLE,NC_DOUBLE):
-        return getNCvx_double_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_double_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_DOUBLE,NC_INT64):
-        return getNCvx_double_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_double_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_DOUBLE,NC_UINT):
-        return getNCvx_double_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_double_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_DOUBLE,NC_UINT64):
-        return getNCvx_double_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_double_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_DOUBLE,NC_USHORT):
-        return getNCvx_double_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_double_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_UBYTE,NC_UBYTE):
-        return getNCvx_uchar_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_uchar_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_UBYTE,NC_BYTE):
-        return getNCvx_uchar_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_uchar_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_UBYTE,NC_SHORT):
-        return getNCvx_uchar_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_uchar_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_UBYTE,NC_INT):
-        return getNCvx_uchar_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_uchar_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_UBYTE,NC_FLOAT):
-        return getNCvx_uchar_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_uchar_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_UBYTE,NC_DOUBLE):
-        return getNCvx_uchar_double(ncp,varp,start,nelems,(double *)value);
+        return getNCvx_uchar_double(ncp,varp,start,nelems,xstep,(double *)value);
 	break;
     case CASE(NC_UBYTE,NC_INT64):
-        return getNCvx_uchar_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_uchar_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_UBYTE,NC_UINT):
-        return getNCvx_uchar_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_uchar_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_UBYTE,NC_UINT64):
-        return getNCvx_uchar_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_uchar_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_UBYTE,NC_USHORT):
-        return getNCvx_uchar_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_uchar_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_USHORT,NC_BYTE):
-        return getNCvx_ushort_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_ushort_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_USHORT,NC_UBYTE):
-        return getNCvx_ushort_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_ushort_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_USHORT,NC_SHORT):
-        return getNCvx_ushort_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_ushort_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_USHORT,NC_INT):
-        return getNCvx_ushort_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_ushort_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_USHORT,NC_FLOAT):
-        return getNCvx_ushort_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_ushort_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_USHORT,NC_DOUBLE):
-        return getNCvx_ushort_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_ushort_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_USHORT,NC_INT64):
-        return getNCvx_ushort_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_ushort_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_USHORT,NC_UINT):
-        return getNCvx_ushort_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_ushort_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_USHORT,NC_UINT64):
-        return getNCvx_ushort_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_ushort_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_USHORT,NC_USHORT):
-        return getNCvx_ushort_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_ushort_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_UINT,NC_BYTE):
-        return getNCvx_uint_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_uint_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_UINT,NC_UBYTE):
-        return getNCvx_uint_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_uint_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_UINT,NC_SHORT):
-        return getNCvx_uint_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_uint_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_UINT,NC_INT):
-        return getNCvx_uint_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_uint_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_UINT,NC_FLOAT):
-        return getNCvx_uint_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_uint_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_UINT,NC_DOUBLE):
-        return getNCvx_uint_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_uint_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_UINT,NC_INT64):
-        return getNCvx_uint_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_uint_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_UINT,NC_UINT):
-        return getNCvx_uint_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_uint_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_UINT,NC_UINT64):
-        return getNCvx_uint_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_uint_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_UINT,NC_USHORT):
-        return getNCvx_uint_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_uint_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_INT64,NC_BYTE):
-        return getNCvx_longlong_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_longlong_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_INT64,NC_UBYTE):
-        return getNCvx_longlong_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_longlong_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_INT64,NC_SHORT):
-        return getNCvx_longlong_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_longlong_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_INT64,NC_INT):
-        return getNCvx_longlong_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_longlong_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_INT64,NC_FLOAT):
-        return getNCvx_longlong_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_longlong_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_INT64,NC_DOUBLE):
-        return getNCvx_longlong_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_longlong_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_INT64,NC_INT64):
-        return getNCvx_longlong_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_longlong_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_INT64,NC_UINT):
-        return getNCvx_longlong_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_longlong_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_INT64,NC_UINT64):
-        return getNCvx_longlong_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_longlong_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_INT64,NC_USHORT):
-        return getNCvx_longlong_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_longlong_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     case CASE(NC_UINT64,NC_BYTE):
-        return getNCvx_ulonglong_schar(ncp,varp,start,nelems,(schar*)value);
+        return getNCvx_ulonglong_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_UINT64,NC_UBYTE):
-        return getNCvx_ulonglong_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return getNCvx_ulonglong_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_UINT64,NC_SHORT):
-        return getNCvx_ulonglong_short(ncp,varp,start,nelems,(short*)value);
+        return getNCvx_ulonglong_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_UINT64,NC_INT):
-        return getNCvx_ulonglong_int(ncp,varp,start,nelems,(int*)value);
+        return getNCvx_ulonglong_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_UINT64,NC_FLOAT):
-        return getNCvx_ulonglong_float(ncp,varp,start,nelems,(float*)value);
+        return getNCvx_ulonglong_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_UINT64,NC_DOUBLE):
-        return getNCvx_ulonglong_double(ncp,varp,start,nelems,(double*)value);
+        return getNCvx_ulonglong_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_UINT64,NC_INT64):
-        return getNCvx_ulonglong_longlong(ncp,varp,start,nelems,(long long*)value);
+        return getNCvx_ulonglong_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_UINT64,NC_UINT):
-        return getNCvx_ulonglong_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return getNCvx_ulonglong_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_UINT64,NC_UINT64):
-        return getNCvx_ulonglong_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return getNCvx_ulonglong_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_UINT64,NC_USHORT):
-        return getNCvx_ulonglong_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return getNCvx_ulonglong_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     default:
@@ -1465,318 +1691,319 @@ readNCv(const NC3_INFO* ncp, const NC_var* varp, const size_t* start,
 
 static int
 writeNCv(NC3_INFO* ncp, const NC_var* varp, const size_t* start,
-         const size_t nelems, const void* value, const nc_type memtype)
+         const size_t nelems, const off_t xstep, const void* value,
+         const nc_type memtype)
 {
     int status = NC_NOERR;
     switch (CASE(varp->type,memtype)) {
 
     case CASE(NC_CHAR,NC_CHAR):
     case CASE(NC_CHAR,NC_UBYTE):
-        return putNCvx_char_char(ncp,varp,start,nelems,(char*)value);
+        return putNCvx_char_char(ncp,varp,start,nelems,xstep,(char*)value);
 	break;
     case CASE(NC_BYTE,NC_BYTE):
-        return putNCvx_schar_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_schar_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_BYTE,NC_UBYTE):
         if (fIsSet(ncp->flags,NC_64BIT_DATA))
-            return putNCvx_schar_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+            return putNCvx_schar_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
         else
             /* for CDF-1 and CDF-2, NC_BYTE is treated the same type as uchar memtype */
-            return putNCvx_uchar_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+            return putNCvx_uchar_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_BYTE,NC_SHORT):
-        return putNCvx_schar_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_schar_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_BYTE,NC_INT):
-        return putNCvx_schar_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_schar_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_BYTE,NC_FLOAT):
-        return putNCvx_schar_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_schar_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_BYTE,NC_DOUBLE):
-        return putNCvx_schar_double(ncp,varp,start,nelems,(double *)value);
+        return putNCvx_schar_double(ncp,varp,start,nelems,xstep,(double *)value);
 	break;
     case CASE(NC_BYTE,NC_INT64):
-        return putNCvx_schar_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_schar_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_BYTE,NC_UINT):
-        return putNCvx_schar_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_schar_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_BYTE,NC_UINT64):
-        return putNCvx_schar_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_schar_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_BYTE,NC_USHORT):
-        return putNCvx_schar_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_schar_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_SHORT,NC_BYTE):
-        return putNCvx_short_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_short_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_SHORT,NC_UBYTE):
-        return putNCvx_short_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_short_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_SHORT,NC_SHORT):
-        return putNCvx_short_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_short_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_SHORT,NC_INT):
-        return putNCvx_short_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_short_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_SHORT,NC_FLOAT):
-        return putNCvx_short_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_short_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_SHORT,NC_DOUBLE):
-        return putNCvx_short_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_short_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_SHORT,NC_INT64):
-        return putNCvx_short_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_short_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_SHORT,NC_UINT):
-        return putNCvx_short_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_short_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_SHORT,NC_UINT64):
-        return putNCvx_short_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_short_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_SHORT,NC_USHORT):
-        return putNCvx_short_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_short_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_INT,NC_BYTE):
-        return putNCvx_int_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_int_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_INT,NC_UBYTE):
-        return putNCvx_int_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_int_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_INT,NC_SHORT):
-        return putNCvx_int_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_int_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_INT,NC_INT):
-        return putNCvx_int_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_int_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_INT,NC_FLOAT):
-        return putNCvx_int_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_int_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_INT,NC_DOUBLE):
-        return putNCvx_int_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_int_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_INT,NC_INT64):
-        return putNCvx_int_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_int_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_INT,NC_UINT):
-        return putNCvx_int_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_int_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_INT,NC_UINT64):
-        return putNCvx_int_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_int_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_INT,NC_USHORT):
-        return putNCvx_int_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_int_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_FLOAT,NC_BYTE):
-        return putNCvx_float_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_float_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_FLOAT,NC_UBYTE):
-        return putNCvx_float_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_float_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_FLOAT,NC_SHORT):
-        return putNCvx_float_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_float_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_FLOAT,NC_INT):
-        return putNCvx_float_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_float_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_FLOAT,NC_FLOAT):
-        return putNCvx_float_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_float_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_FLOAT,NC_DOUBLE):
-        return putNCvx_float_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_float_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_FLOAT,NC_INT64):
-        return putNCvx_float_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_float_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_FLOAT,NC_UINT):
-        return putNCvx_float_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_float_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_FLOAT,NC_UINT64):
-        return putNCvx_float_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_float_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_FLOAT,NC_USHORT):
-        return putNCvx_float_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_float_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_DOUBLE,NC_BYTE):
-        return putNCvx_double_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_double_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_DOUBLE,NC_UBYTE):
-        return putNCvx_double_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_double_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_DOUBLE,NC_SHORT):
-        return putNCvx_double_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_double_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_DOUBLE,NC_INT):
-        return putNCvx_double_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_double_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_DOUBLE,NC_FLOAT):
-        return putNCvx_double_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_double_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_DOUBLE,NC_DOUBLE):
-        return putNCvx_double_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_double_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_DOUBLE,NC_INT64):
-        return putNCvx_double_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_double_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_DOUBLE,NC_UINT):
-        return putNCvx_double_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_double_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_DOUBLE,NC_UINT64):
-        return putNCvx_double_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_double_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_DOUBLE,NC_USHORT):
-        return putNCvx_double_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_double_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_UBYTE,NC_UBYTE):
-        return putNCvx_uchar_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_uchar_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_UBYTE,NC_BYTE):
-        return putNCvx_uchar_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_uchar_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_UBYTE,NC_SHORT):
-        return putNCvx_uchar_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_uchar_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_UBYTE,NC_INT):
-        return putNCvx_uchar_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_uchar_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_UBYTE,NC_FLOAT):
-        return putNCvx_uchar_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_uchar_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_UBYTE,NC_DOUBLE):
-        return putNCvx_uchar_double(ncp,varp,start,nelems,(double *)value);
+        return putNCvx_uchar_double(ncp,varp,start,nelems,xstep,(double *)value);
 	break;
     case CASE(NC_UBYTE,NC_INT64):
-        return putNCvx_uchar_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_uchar_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_UBYTE,NC_UINT):
-        return putNCvx_uchar_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_uchar_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_UBYTE,NC_UINT64):
-        return putNCvx_uchar_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_uchar_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_UBYTE,NC_USHORT):
-        return putNCvx_uchar_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_uchar_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_USHORT,NC_BYTE):
-        return putNCvx_ushort_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_ushort_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_USHORT,NC_UBYTE):
-        return putNCvx_ushort_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_ushort_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_USHORT,NC_SHORT):
-        return putNCvx_ushort_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_ushort_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_USHORT,NC_INT):
-        return putNCvx_ushort_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_ushort_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_USHORT,NC_FLOAT):
-        return putNCvx_ushort_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_ushort_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_USHORT,NC_DOUBLE):
-        return putNCvx_ushort_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_ushort_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_USHORT,NC_INT64):
-        return putNCvx_ushort_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_ushort_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_USHORT,NC_UINT):
-        return putNCvx_ushort_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_ushort_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_USHORT,NC_UINT64):
-        return putNCvx_ushort_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_ushort_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_USHORT,NC_USHORT):
-        return putNCvx_ushort_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_ushort_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_UINT,NC_BYTE):
-        return putNCvx_uint_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_uint_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_UINT,NC_UBYTE):
-        return putNCvx_uint_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_uint_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_UINT,NC_SHORT):
-        return putNCvx_uint_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_uint_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_UINT,NC_INT):
-        return putNCvx_uint_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_uint_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_UINT,NC_FLOAT):
-        return putNCvx_uint_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_uint_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_UINT,NC_DOUBLE):
-        return putNCvx_uint_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_uint_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_UINT,NC_INT64):
-        return putNCvx_uint_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_uint_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_UINT,NC_UINT):
-        return putNCvx_uint_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_uint_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_UINT,NC_UINT64):
-        return putNCvx_uint_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_uint_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_UINT,NC_USHORT):
-        return putNCvx_uint_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_uint_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_INT64,NC_BYTE):
-        return putNCvx_longlong_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_longlong_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_INT64,NC_UBYTE):
-        return putNCvx_longlong_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_longlong_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_INT64,NC_SHORT):
-        return putNCvx_longlong_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_longlong_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_INT64,NC_INT):
-        return putNCvx_longlong_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_longlong_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_INT64,NC_FLOAT):
-        return putNCvx_longlong_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_longlong_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_INT64,NC_DOUBLE):
-        return putNCvx_longlong_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_longlong_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_INT64,NC_INT64):
-        return putNCvx_longlong_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_longlong_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_INT64,NC_UINT):
-        return putNCvx_longlong_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_longlong_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_INT64,NC_UINT64):
-        return putNCvx_longlong_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_longlong_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_INT64,NC_USHORT):
-        return putNCvx_longlong_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_longlong_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
     case CASE(NC_UINT64,NC_BYTE):
-        return putNCvx_ulonglong_schar(ncp,varp,start,nelems,(schar*)value);
+        return putNCvx_ulonglong_schar(ncp,varp,start,nelems,xstep,(schar*)value);
 	break;
     case CASE(NC_UINT64,NC_UBYTE):
-        return putNCvx_ulonglong_uchar(ncp,varp,start,nelems,(unsigned char*)value);
+        return putNCvx_ulonglong_uchar(ncp,varp,start,nelems,xstep,(unsigned char*)value);
 	break;
     case CASE(NC_UINT64,NC_SHORT):
-        return putNCvx_ulonglong_short(ncp,varp,start,nelems,(short*)value);
+        return putNCvx_ulonglong_short(ncp,varp,start,nelems,xstep,(short*)value);
 	break;
     case CASE(NC_UINT64,NC_INT):
-        return putNCvx_ulonglong_int(ncp,varp,start,nelems,(int*)value);
+        return putNCvx_ulonglong_int(ncp,varp,start,nelems,xstep,(int*)value);
 	break;
     case CASE(NC_UINT64,NC_FLOAT):
-        return putNCvx_ulonglong_float(ncp,varp,start,nelems,(float*)value);
+        return putNCvx_ulonglong_float(ncp,varp,start,nelems,xstep,(float*)value);
 	break;
     case CASE(NC_UINT64,NC_DOUBLE):
-        return putNCvx_ulonglong_double(ncp,varp,start,nelems,(double*)value);
+        return putNCvx_ulonglong_double(ncp,varp,start,nelems,xstep,(double*)value);
 	break;
     case CASE(NC_UINT64,NC_INT64):
-        return putNCvx_ulonglong_longlong(ncp,varp,start,nelems,(long long*)value);
+        return putNCvx_ulonglong_longlong(ncp,varp,start,nelems,xstep,(long long*)value);
 	break;
     case CASE(NC_UINT64,NC_UINT):
-        return putNCvx_ulonglong_uint(ncp,varp,start,nelems,(unsigned int*)value);
+        return putNCvx_ulonglong_uint(ncp,varp,start,nelems,xstep,(unsigned int*)value);
 	break;
     case CASE(NC_UINT64,NC_UINT64):
-        return putNCvx_ulonglong_ulonglong(ncp,varp,start,nelems,(unsigned long long*)value);
+        return putNCvx_ulonglong_ulonglong(ncp,varp,start,nelems,xstep,(unsigned long long*)value);
 	break;
     case CASE(NC_UINT64,NC_USHORT):
-        return putNCvx_ulonglong_ushort(ncp,varp,start,nelems,(unsigned short*)value);
+        return putNCvx_ulonglong_ushort(ncp,varp,start,nelems,xstep,(unsigned short*)value);
 	break;
 
     default:
@@ -1850,7 +2077,7 @@ NC3_get_vara(int ncid, int varid,
 
     if(varp->ndims == 0) /* scalar variable */
     {
-        return( readNCv(nc3, varp, start, 1, (void*)value, memtype) );
+        return( readNCv(nc3, varp, start, 1, 0, (void*)value, memtype) );
     }
 
     if(IS_RECVAR(varp))
@@ -1860,7 +2087,7 @@ NC3_get_vara(int ncid, int varid,
         if(varp->ndims == 1 && nc3->recsize <= varp->len)
         {
             /* one dimensional && the only record variable  */
-            return( readNCv(nc3, varp, start, *edges, (void*)value, memtype) );
+            return( readNCv(nc3, varp, start, *edges, 0, (void*)value, memtype) );
         }
     }
 
@@ -1872,7 +2099,7 @@ NC3_get_vara(int ncid, int varid,
 
     if(ii == -1)
     {
-        return( readNCv(nc3, varp, start, iocount, (void*)value, memtype) );
+        return( readNCv(nc3, varp, start, iocount, 0, (void*)value, memtype) );
     }
 
     assert(ii >= 0);
@@ -1891,7 +2118,7 @@ NC3_get_vara(int ncid, int varid,
     /* ripple counter */
     while(*coord < *upper)
     {
-        const int lstatus = readNCv(nc3, varp, coord, iocount, (void*)value, memtype);
+        const int lstatus = readNCv(nc3, varp, coord, iocount, 0, (void*)value, memtype);
 	if(lstatus != NC_NOERR)
         {
             if(lstatus != NC_ERANGE)
@@ -1980,7 +2207,7 @@ NC3_put_vara(int ncid, int varid,
 
     if(varp->ndims == 0) /* scalar variable */
     {
-        return( writeNCv(nc3, varp, start, 1, (void*)value, memtype) );
+        return( writeNCv(nc3, varp, start, 1, 0, (void*)value, memtype) );
     }
 
     if(IS_RECVAR(varp))
@@ -1993,7 +2220,7 @@ NC3_put_vara(int ncid, int varid,
             && nc3->recsize <= varp->len)
         {
             /* one dimensional && the only record variable  */
-            return( writeNCv(nc3, varp, start, *edges, (void*)value, memtype) );
+            return( writeNCv(nc3, varp, start, *edges, 0, (void*)value, memtype) );
         }
     }
 
@@ -2005,7 +2232,7 @@ NC3_put_vara(int ncid, int varid,
 
     if(ii == -1)
     {
-        return( writeNCv(nc3, varp, start, iocount, (void*)value, memtype) );
+        return( writeNCv(nc3, varp, start, iocount, 0, (void*)value, memtype) );
     }
 
     assert(ii >= 0);
@@ -2024,7 +2251,7 @@ NC3_put_vara(int ncid, int varid,
     /* ripple counter */
     while(*coord < *upper)
     {
-        const int lstatus = writeNCv(nc3, varp, coord, iocount, (void*)value, memtype);
+        const int lstatus = writeNCv(nc3, varp, coord, iocount, 0, (void*)value, memtype);
         if(lstatus != NC_NOERR)
         {
             if(lstatus != NC_ERANGE)
@@ -2047,3 +2274,696 @@ NC3_put_vara(int ncid, int varid,
 
     return status;
 }
+
+/**************************************************/
+/* Nonblocking requests */
+
+/*
+ * One contiguous run of a nonblocking request in the file:
+ * 'nelems' elements of 'varp' from the coordinate at index
+ * 'coord' of the coordinate pool, to or from 'value'.
+ */
+typedef struct NCseg {
+	off_t offset;
+	size_t extent; /* bytes in the file */
+	size_t seq; /* order of creation; keeps the sort stable */
+	NCnbreq* req;
+	const NC_var* varp;
+	size_t coord;
+	size_t nelems;
+	char* value;
+} NCseg;
+
+typedef struct NCsegs {
+	size_t nsegs;
+	size_t nalloc;
+	NCseg* segs;
+	size_t ncoords;
+	size_t ncalloc;
+	size_t* coords; /* pool of the segment coordinates */
+} NCsegs;
+
+/*
+ * The region of the file obtained from the real ncio for a
+ * group of segments, presented as an ncio of its own, so that
+ * the usual conversion code (writeNCv, readNCv) can run on one
+ * segment after the other without any further I/O.
+ */
+typedef struct NCregion {
+	off_t offset;
+	size_t extent;
+	char* base;
+} NCregion;
+
+static int
+ncregion_rel(ncio *const nciop, off_t offset, int rflags)
+{
+	NC_UNUSED(nciop);
+	NC_UNUSED(offset);
+	NC_UNUSED(rflags);
+	return NC_NOERR;
+}
+
+static int
+ncregion_get(ncio *const nciop, off_t offset, size_t extent, int rflags,
+	void **const vpp)
+{
+	NCregion* region = (NCregion*)nciop->pvt;
+
+	NC_UNUSED(rflags);
+	if(offset < region->offset
+	   || (size_t)(offset - region->offset) + extent > region->extent)
+		return NC_EINTERNAL;
+	*vpp = region->base + (offset - region->offset);
+	return NC_NOERR;
+}
+
+static int
+NCaddseg(NCsegs* segs, const NC3_INFO* nc3, NCnbreq* req,
+	const NC_var* varp, const size_t* coord, size_t nelems, char* value)
+{
+	NCseg* seg;
+	size_t ncoord = (varp->ndims > 0 ? varp->ndims : 1);
+
+	if(nelems == 0)
+		return NC_NOERR;
+	if(segs->nsegs == segs->nalloc) {
+		size_t nalloc = (segs->nalloc == 0 ? 64 : 2 * segs->nalloc);
+		NCseg* newsegs = (NCseg*)realloc(segs->segs, nalloc * sizeof(NCseg));
+		if(newsegs == NULL)
+			return NC_ENOMEM;
+		segs->segs = newsegs;
+		segs->nalloc = nalloc;
+	}
+	if(segs->ncoords + ncoord > segs->ncalloc) {
+		size_t ncalloc = (segs->ncalloc == 0 ? 256 : 2 * segs->ncalloc);
+		size_t* newcoords;
+		while(ncalloc < segs->ncoords + ncoord)
+			ncalloc *= 2;
+		newcoords = (size_t*)realloc(segs->coords, ncalloc * sizeof(size_t));
+		if(newcoords == NULL)
+			return NC_ENOMEM;
+		segs->coords = newcoords;
+		segs->ncalloc = ncalloc;
+	}
+	seg = &segs->segs[segs->nsegs];
+	seg->offset = NC_varoffset(nc3, varp, coord);
+	seg->extent = nelems * varp->xsz;
+	seg->seq = segs->nsegs;
+	seg->req = req;
+	seg->varp = varp;
+	seg->coord = segs->ncoords;
+	seg->nelems = nelems;
+	seg->value = value;
+	if(varp->ndims > 0)
+		(void) memcpy(&segs->coords[segs->ncoords], coord, varp->ndims * sizeof(size_t));
+	else
+		segs->coords[segs->ncoords] = 0;
+	segs->ncoords += ncoord;
+	segs->nsegs++;
+	return NC_NOERR;
+}
+
+/*
+ * Check a nonblocking request as NC3_put_vara or NC3_get_vara
+ * would, and resolve its memory type.
+ */
+static int
+NCnbcheck(NC3_INFO* nc3, NCnbreq* req, NC_var** varpp)
+{
+	int status;
+	NC_var *varp;
+
+	if(req->isput && NC_readonly(nc3))
+		return NC_EPERM;
+	if(NC_indef(nc3))
+		return NC_EINDEFINE;
+	status = NC_lookupvar(nc3, req->varid, &varp);
+	if(status != NC_NOERR)
+		return status;
+	if(req->memtype == NC_NAT) req->memtype = varp->type;
+	if(req->memtype == NC_CHAR && varp->type != NC_CHAR)
+		return NC_ECHAR;
+	else if(req->memtype != NC_CHAR && varp->type == NC_CHAR)
+		return NC_ECHAR;
+	status = NCcoordck(nc3, varp, req->start);
+	if(status != NC_NOERR)
+		return status;
+	status = NCedgeck(nc3, varp, req->start, req->count);
+	if(status != NC_NOERR)
+		return status;
+	*varpp = varp;
+	return NC_NOERR;
+}
+
+/*
+ * Cut a checked request into the same contiguous pieces that
+ * NC3_put_vara and NC3_get_vara would transfer one at a time.
+ */
+static int
+NCnbsegments(NC3_INFO* nc3, NCnbreq* req, const NC_var* varp, NCsegs* segs)
+{
+	int status = NC_NOERR;
+	char* value = (char*)req->value;
+	const size_t* start = req->start;
+	const size_t* edges = req->count;
+	size_t memtypelen = (size_t)nctypelen(req->memtype);
+	size_t iocount;
+	int ii;
+
+	if(varp->ndims == 0) /* scalar variable */
+		return NCaddseg(segs, nc3, req, varp, NULL, 1, value);
+
+	if(IS_RECVAR(varp) && varp->ndims == 1 && nc3->recsize <= varp->len)
+	{
+		/* one dimensional && the only record variable  */
+		return NCaddseg(segs, nc3, req, varp, start, *edges, value);
+	}
+
+	ii = NCiocount(nc3, varp, edges, &iocount);
+	if(iocount == 0)
+		return NC_NOERR;
+	if(ii == -1)
+		return NCaddseg(segs, nc3, req, varp, start, iocount, value);
+
+	{ /* inline */
+	ALLOC_ONSTACK(coord, size_t, varp->ndims);
+	ALLOC_ONSTACK(upper, size_t, varp->ndims);
+	const size_t index = (size_t)ii;
+
+	(void) memcpy(coord, start, varp->ndims * sizeof(size_t));
+	set_upper(upper, start, edges, &upper[varp->ndims]);
+	while(*coord < *upper)
+	{
+		status = NCaddseg(segs, nc3, req, varp, coord, iocount, value);
+		if(status != NC_NOERR)
+			break;
+		value += (iocount * memtypelen);
+		odo1(start, upper, coord, &upper[index], &coord[index]);
+	}
+	FREE_ONSTACK(upper);
+	FREE_ONSTACK(coord);
+	} /* end inline */
+
+	return status;
+}
+
+static int
+NCsegcmp(const void* a, const void* b)
+{
+	const NCseg* sa = (const NCseg*)a;
+	const NCseg* sb = (const NCseg*)b;
+
+	if(sa->offset != sb->offset)
+		return (sa->offset < sb->offset ? -1 : 1);
+	return (sa->seq < sb->seq ? -1 : (sa->seq > sb->seq ? 1 : 0));
+}
+
+/* Record the status of one segment in its request: the first
+ * error wins, except that a fatal error replaces NC_ERANGE */
+static void
+NCnbstatus(NCnbreq* req, int lstatus)
+{
+	if(lstatus == NC_NOERR)
+		return;
+	if(req->stat == NC_NOERR
+	   || (req->stat == NC_ERANGE && lstatus != NC_ERANGE))
+		req->stat = lstatus;
+}
+
+static void
+NCrunseg(NC3_INFO* nc3, const NCsegs* segs, const NCseg* seg)
+{
+	NCnbreq* req = seg->req;
+	const size_t* coord = &segs->coords[seg->coord];
+	int lstatus;
+
+	if(req->isput)
+		lstatus = writeNCv(nc3, seg->varp, coord, seg->nelems, 0,
+				   (void*)seg->value, req->memtype);
+	else
+		lstatus = readNCv(nc3, seg->varp, coord, seg->nelems, 0,
+				  (void*)seg->value, req->memtype);
+	NCnbstatus(req, lstatus);
+}
+
+/*
+ * Complete a set of nonblocking requests. The requests are cut
+ * into contiguous segments, which are sorted by file offset;
+ * runs of segments that fit in one ncio request (ncp->chunk bytes)
+ * are then transferred with a single ncio_get/ncio_rel, and only
+ * converted one by one. Each request gets its own status.
+ */
+int
+NC3_wait(NC* nc, size_t nreqs, NCnbreq** reqs)
+{
+	int status = NC_NOERR;
+	NC3_INFO* nc3 = NC3_DATA(nc);
+	NCsegs segs;
+	size_t i, j, k, maxrecs = 0;
+
+	memset(&segs, 0, sizeof(segs));
+
+	/* Check the requests and grow the record dimension for the puts */
+	for(i = 0; i < nreqs; i++)
+	{
+		NCnbreq* req = reqs[i];
+		NC_var* varp = NULL;
+
+		req->stat = NCnbcheck(nc3, req, &varp);
+		if(req->stat == NC_NOERR && req->isput && IS_RECVAR(varp)
+		   && req->start[0] + req->count[0] > maxrecs)
+			maxrecs = req->start[0] + req->count[0];
+	}
+	if(maxrecs > 0)
+	{
+		int lstatus = NCvnrecs(nc3, maxrecs);
+		if(lstatus != NC_NOERR)
+			for(i = 0; i < nreqs; i++)
+				if(reqs[i]->isput && reqs[i]->stat == NC_NOERR)
+					reqs[i]->stat = lstatus;
+	}
+
+	/* Cut the requests into segments */
+	for(i = 0; i < nreqs; i++)
+	{
+		NCnbreq* req = reqs[i];
+		NC_var* varp = NULL;
+
+		if(req->stat != NC_NOERR)
+			continue;
+		(void) NC_lookupvar(nc3, req->varid, &varp);
+		if(!req->isput && IS_RECVAR(varp)
+		   && req->start[0] + req->count[0] > NC_get_numrecs(nc3))
+		{
+			req->stat = NC_EEDGE;
+			continue;
+		}
+		status = NCnbsegments(nc3, req, varp, &segs);
+		if(status != NC_NOERR)
+			goto done;
+	}
+
+	if(segs.nsegs > 1)
+		qsort(segs.segs, segs.nsegs, sizeof(NCseg), NCsegcmp);
+
+	/* Transfer runs of nearby segments together */
+	for(i = 0; i < segs.nsegs; i = j)
+	{
+		off_t begin = segs.segs[i].offset;
+		off_t end = begin;
+		int rflags = 0;
+
+		for(j = i; j < segs.nsegs; j++)
+		{
+			const NCseg* seg = &segs.segs[j];
+			off_t segend = seg->offset + (off_t)seg->extent;
+			if(segend < end)
+				segend = end;
+			if(j > i && (size_t)(segend - begin) > nc3->chunk)
+				break;
+			end = segend;
+			if(seg->req->isput)
+				rflags = RGN_WRITE;
+		}
+
+		if((size_t)(end - begin) > nc3->chunk)
+		{
+			/* A single large segment: no point in a region */
+			assert(j == i + 1);
+			NCrunseg(nc3, &segs, &segs.segs[i]);
+		}
+		else
+		{
+			void* xp = NULL;
+			int lstatus = ncio_get(nc3->nciop, begin, (size_t)(end - begin),
+					       rflags, &xp);
+			if(lstatus != NC_NOERR)
+			{
+				for(k = i; k < j; k++)
+					NCnbstatus(segs.segs[k].req, lstatus);
+				continue;
+			}
+			{
+				ncio* nciop = nc3->nciop;
+				NCregion region;
+				ncio regionio = {
+					.ioflags = nciop->ioflags,
+					.fd = nciop->fd,
+					.rel = ncregion_rel,
+					.get = ncregion_get,
+					.path = nciop->path,
+				};
+
+				region.offset = begin;
+				region.extent = (size_t)(end - begin);
+				region.base = (char*)xp;
+				regionio.pvt = &region;
+				nc3->nciop = &regionio;
+				for(k = i; k < j; k++)
+					NCrunseg(nc3, &segs, &segs.segs[k]);
+				nc3->nciop = nciop;
+			}
+			(void) ncio_rel(nc3->nciop, begin, (rflags ? RGN_MODIFIED : 0));
+		}
+	}
+
+done:
+	free(segs.segs);
+	free(segs.coords);
+	return status;
+}
+
+/**************************************************/
+/* Strided and mapped access */
+
+/*
+ * Check the stride vector and make sure the last item of
+ * the hyperslab is inside the variable. Set 'nelemsp' to
+ * the number of items in the hyperslab. For writes the
+ * record dimension may grow, so it is not bounded.
+ */
+static int
+NCstrideck(NC3_INFO* ncp, const NC_var *varp, const size_t *start,
+	const size_t *edges, const ptrdiff_t *stride, int forwrite,
+	size_t *nelemsp)
+{
+	size_t i;
+	size_t nelems = 1;
+
+	for(i = 0; i < varp->ndims; i++)
+	{
+		size_t bound = varp->shape[i];
+		if(stride[i] <= 0
+		   /* cast needed for braindead systems with signed size_t */
+		   || ((unsigned long) stride[i] >= X_INT_MAX))
+			return NC_ESTRIDE;
+		nelems *= edges[i];
+		if(edges[i] == 0)
+			continue;
+		if(i == 0 && IS_RECVAR(varp))
+		{
+			if(forwrite)
+				continue;
+			bound = NC_get_numrecs(ncp);
+		}
+		if(start[i] + (edges[i] - 1) * (size_t)stride[i] >= bound)
+			return NC_EINVALCOORDS;
+	}
+	*nelemsp = nelems;
+	return NC_NOERR;
+}
+
+/*
+ * Walk a strided, and possibly mapped, hyperslab one row of the
+ * fastest varying dimension at a time. Each row is handed to
+ * readNCv/writeNCv along with the distance in bytes between its
+ * items in the file, so the offset is computed once per row and
+ * each ncio region serves many items. Rows that are not contiguous
+ * in memory are moved through a bounce buffer.
+ */
+static int
+NCstridedio(NC3_INFO* ncp, const NC_var *varp, const size_t *start,
+	const size_t *edges, const ptrdiff_t *stride, const ptrdiff_t *imap,
+	char *value, nc_type memtype, int forwrite)
+{
+	int status = NC_NOERR;
+	int i;
+	const int last = (int)varp->ndims - 1;
+	const size_t memtypelen = (size_t)nctypelen(memtype);
+	const size_t rowlen = edges[last];
+	off_t xstep;
+	size_t index[NC_MAX_VAR_DIMS];
+	size_t coord[NC_MAX_VAR_DIMS];
+	char *bounce = NULL;
+
+	/* File distance between the items of one row */
+	if(IS_RECVAR(varp) && varp->ndims == 1)
+		xstep = (off_t)(ncp->recsize * (size_t)stride[last]);
+	else
+		xstep = (off_t)(varp->xsz * (size_t)stride[last]);
+	if(xstep == (off_t)varp->xsz)
+		xstep = 0; /* contiguous */
+
+	if(imap != NULL && imap[last] != 1)
+	{
+		bounce = (char*)malloc(rowlen * memtypelen);
+		if(bounce == NULL)
+			return NC_ENOMEM;
+	}
+
+	memset(index, 0, sizeof(index));
+	for(;;)
+	{
+		int lstatus;
+		char *mem = value;
+		char *row;
+		size_t k;
+
+		for(i = 0; i < last; i++)
+		{
+			coord[i] = start[i] + index[i] * (size_t)stride[i];
+			if(imap != NULL)
+				mem += (ptrdiff_t)index[i] * imap[i] * (ptrdiff_t)memtypelen;
+		}
+		coord[last] = start[last];
+		row = (bounce != NULL ? bounce : mem);
+
+		if(forwrite)
+		{
+			if(bounce != NULL)
+			{
+				for(k = 0; k < rowlen; k++)
+					memcpy(bounce + k * memtypelen,
+					       mem + (ptrdiff_t)k * imap[last] * (ptrdiff_t)memtypelen,
+					       memtypelen);
+			}
+			lstatus = writeNCv(ncp, varp, coord, rowlen, xstep, row, memtype);
+		}
+		else
+		{
+			lstatus = readNCv(ncp, varp, coord, rowlen, xstep, row, memtype);
+			if(bounce != NULL && (lstatus == NC_NOERR || lstatus == NC_ERANGE))
+			{
+				for(k = 0; k < rowlen; k++)
+					memcpy(mem + (ptrdiff_t)k * imap[last] * (ptrdiff_t)memtypelen,
+					       bounce + k * memtypelen,
+					       memtypelen);
+			}
+		}
+		if(lstatus != NC_NOERR)
+		{
+			if(lstatus != NC_ERANGE)
+			{
+				status = lstatus;
+				/* fatal for the loop */
+				break;
+			}
+			/* else NC_ERANGE, not fatal for the loop */
+			if(status == NC_NOERR)
+				status = lstatus;
+		}
+		if(imap == NULL)
+			value += rowlen * memtypelen;
+
+		/* ripple counter over all but the fastest dimension */
+		for(i = last - 1; i >= 0; i--)
+		{
+			if(++index[i] < edges[i])
+				break;
+			index[i] = 0;
+		}
+		if(i < 0)
+			break;
+	}
+
+	if(bounce != NULL)
+		free(bounce);
+	return status;
+}
+
+int
+NC3_get_varm(int ncid, int varid,
+	    const size_t *start, const size_t *edges0,
+	    const ptrdiff_t *stride, const ptrdiff_t *imap,
+            void *value0,
+	    nc_type memtype)
+{
+    int status = NC_NOERR;
+    NC* nc;
+    NC3_INFO* nc3;
+    NC_var *varp;
+    size_t i, nelems;
+    const size_t* edges = edges0; /* so we can modify for special cases */
+    size_t modedges[NC_MAX_VAR_DIMS];
+    ptrdiff_t ones[NC_MAX_VAR_DIMS];
+    int simple;
+
+    status = NC_check_id(ncid, &nc);
+    if(status != NC_NOERR)
+        return status;
+    nc3 = NC3_DATA(nc);
+
+    if(NC_indef(nc3))
+        return NC_EINDEFINE;
+
+    status = NC_lookupvar(nc3, varid, &varp);
+    if(status != NC_NOERR)
+        return status;
+
+    if(memtype == NC_NAT) memtype=varp->type;
+
+    if(memtype == NC_CHAR && varp->type != NC_CHAR)
+        return NC_ECHAR;
+    else if(memtype != NC_CHAR && varp->type == NC_CHAR)
+        return NC_ECHAR;
+
+    if(varp->ndims == 0) /* scalar variable */
+        return NC3_get_vara(ncid, varid, start, edges0, value0, memtype);
+
+    if(edges == NULL) {
+	(void)memcpy((void*)modedges,(void*)varp->shape,
+                      sizeof(size_t)*varp->ndims);
+	if(IS_RECVAR(varp))
+	    modedges[0] = NC_get_numrecs(nc3);
+	edges = modedges;
+    }
+    if(stride == NULL) {
+	for(i = 0; i < varp->ndims; i++)
+	    ones[i] = 1;
+	stride = ones;
+    }
+
+    /* Use the contiguous code when there is nothing to gain */
+    simple = 1;
+    for(i = 0; i < varp->ndims; i++) {
+        if(stride[i] != 1)
+	    simple = 0;
+    }
+    if(simple && imap == NULL)
+        return NC3_get_vara(ncid, varid, start, edges, value0, memtype);
+
+    status = NCcoordck(nc3, varp, start);
+    if(status != NC_NOERR)
+        return status;
+
+    status = NCedgeck(nc3, varp, start, edges);
+    if(status != NC_NOERR)
+        return status;
+
+    if(IS_RECVAR(varp) && *start + *edges > NC_get_numrecs(nc3))
+        return NC_EEDGE;
+
+    status = NCstrideck(nc3, varp, start, edges, stride, 0, &nelems);
+    if(status != NC_NOERR || nelems == 0)
+        return status;
+
+    return NCstridedio(nc3, varp, start, edges, stride, imap,
+		       (char*)value0, memtype, 0);
+}
+
+int
+NC3_get_vars(int ncid, int varid,
+	    const size_t *start, const size_t *edges,
+	    const ptrdiff_t *stride,
+            void *value,
+	    nc_type memtype)
+{
+    return NC3_get_varm(ncid, varid, start, edges, stride, NULL, value, memtype);
+}
+
+int
+NC3_put_varm(int ncid, int varid,
+	    const size_t *start, const size_t *edges0,
+	    const ptrdiff_t *stride, const ptrdiff_t *imap,
+            const void *value0,
+	    nc_type memtype)
+{
+    int status = NC_NOERR;
+    NC *nc;
+    NC3_INFO* nc3;
+    NC_var *varp;
+    size_t i, nelems;
+    const size_t* edges = edges0; /* so we can modify for special cases */
+    size_t modedges[NC_MAX_VAR_DIMS];
+    ptrdiff_t ones[NC_MAX_VAR_DIMS];
+    int simple;
+
+    status = NC_check_id(ncid, &nc);
+    if(status != NC_NOERR)
+        return status;
+    nc3 = NC3_DATA(nc);
+
+    if(NC_readonly(nc3))
+        return NC_EPERM;
+
+    if(NC_indef(nc3))
+        return NC_EINDEFINE;
+
+    status = NC_lookupvar(nc3, varid, &varp);
+    if(status != NC_NOERR)
+       return status; /*invalid varid */
+
+    if(memtype == NC_NAT) memtype=varp->type;
+
+    if(memtype == NC_CHAR && varp->type != NC_CHAR)
+        return NC_ECHAR;
+    else if(memtype != NC_CHAR && varp->type == NC_CHAR)
+        return NC_ECHAR;
+
+    if(varp->ndims == 0) /* scalar variable */
+        return NC3_put_vara(ncid, varid, start, edges0, value0, memtype);
+
+    if(edges == NULL) {
+	(void)memcpy((void*)modedges,(void*)varp->shape,
+                      sizeof(size_t)*varp->ndims);
+	if(IS_RECVAR(varp))
+	    modedges[0] = NC_get_numrecs(nc3);
+	edges = modedges;
+    }
+    if(stride == NULL) {
+	for(i = 0; i < varp->ndims; i++)
+	    ones[i] = 1;
+	stride = ones;
+    }
+
+    /* Use the contiguous code when there is nothing to gain */
+    simple = 1;
+    for(i = 0; i < varp->ndims; i++) {
+        if(stride[i] != 1)
+	    simple = 0;
+    }
+    if(simple && imap == NULL)
+        return NC3_put_vara(ncid, varid, start, edges, value0, memtype);
+
+    status = NCcoordck(nc3, varp, start);
+    if(status != NC_NOERR)
+        return status;
+    status = NCedgeck(nc3, varp, start, edges);
+    if(status != NC_NOERR)
+        return status;
+
+    status = NCstrideck(nc3, varp, start, edges, stride, 1, &nelems);
+    if(status != NC_NOERR || nelems == 0)
+        return status;
+
+    if(IS_RECVAR(varp))
+    {
+        status = NCvnrecs(nc3, *start + (*edges - 1) * (size_t)*stride + 1);
+        if(status != NC_NOERR)
+            return status;
+    }
+
+    return NCstridedio(nc3, varp, start, edges, stride, imap,
+		       (char*)value0, memtype, 1);
+}
+
+int
+NC3_put_vars(int ncid, int varid,
+	    const size_t *start, const size_t *edges,
+	    const ptrdiff_t *stride,
+            const void *value,
+	    nc_type memtype)
+{
+    return NC3_put_varm(ncid, varid, start, edges, stride, NULL, value, memtype);
+}
@@ -37,6 +37,7 @@
 #include "rnd.h"
 #include "ncs3sdk.h"
 #include "ncuri.h"
+#include "ncpagecache.h"
 
 #define DEFAULTPAGESIZE 16384
 
@@ -49,7 +50,9 @@ typedef struct NCS3IO {
     NCS3INFO s3;
     void* s3client;
     char* errmsg;
-    void* buffer;
+    void* buffer;      /* region handed out by s3io_get, reused */
+    size_t buffersize;
+    NCpagecache* cache;
 } NCS3IO;
 
 /* Forward */
@@ -60,6 +63,8 @@ static int s3io_sync(ncio *const nciop);
 static int s3io_filesize(ncio* nciop, off_t* filesizep);
 static int s3io_pad_length(ncio* nciop, off_t length);
 static int s3io_close(ncio* nciop, int);
+static int s3io_stats(ncio* nciop, NCpagestats* statsp);
+static int s3io_fetch(void* state, size64_t offset, size_t count, void* buf);
 
 #define reporterr(s3io) {if((s3io) && (s3io)->errmsg) {nclog(NCLOGERR,(s3io)->errmsg);} nullfree((s3io)->errmsg); (s3io)->errmsg = NULL;}
 
@@ -92,6 +97,7 @@ s3io_new(const char* path, int ioflags, ncio** nciopp, NCS3IO** hpp)
     *((ncio_filesizefunc**)&nciop->filesize) = s3io_filesize;
     *((ncio_pad_lengthfunc**)&nciop->pad_length) = s3io_pad_length;
     *((ncio_closefunc**)&nciop->close) = s3io_close;
+    *((ncio_statsfunc**)&nciop->stats) = s3io_stats;
 
     s3io = (NCS3IO*)calloc(1,sizeof(NCS3IO));
     if(s3io == NULL) {status = NC_ENOMEM; goto fail;}
@@ -190,6 +196,12 @@ s3io_open(const char* path,
     default:
         goto done;
     }
+    {
+	size_t cpagesize, maxpages, readahead;
+	ncpagecacheparams(url,&cpagesize,&maxpages,&readahead);
+	if((status = ncpagecachenew((size64_t)s3io->size,cpagesize,maxpages,readahead,
+				    s3io_fetch,s3io,&s3io->cache))) goto done;
+    }
 
     sizehint = pagesize;
 
@@ -252,6 +264,7 @@ s3io_close(ncio* nciop, int deleteit)
     s3io = (NCS3IO*)nciop->pvt;
     assert(s3io != NULL);
 
+    ncpagecachefree(s3io->cache); /* ncio_close reported its counters */
 
     if(s3io->s3client && s3io->s3.bucket && s3io->s3.rootkey) {
 
@@ -286,17 +299,48 @@ s3io_get(ncio* const nciop, off_t offset, size_t extent, int rflags, void** cons
     if(nciop == NULL || nciop->pvt == NULL) {status = NC_EINVAL; goto done;}
     s3io = (NCS3IO*)nciop->pvt;
 
-    assert(s3io->buffer == NULL);
-    if((s3io->buffer = (unsigned char*)malloc(extent))==NULL)
-        {status = NC_ENOMEM; goto done;}
-    status = NC_s3sdkread(s3io->s3client, s3io->s3.bucket, s3io->s3.rootkey, offset, extent, s3io->buffer, &s3io->errmsg);
-    if(status) {reporterr(s3io); goto done;}
+    if(extent > s3io->buffersize) {
+	void* newbuffer = realloc(s3io->buffer,extent);
+	if(newbuffer == NULL) {status = NC_ENOMEM; goto done;}
+	s3io->buffer = newbuffer;
+	s3io->buffersize = extent;
+    }
+    {
+	/* As for a local file, the part past the end reads as zeros */
+	size_t avail = 0;
+	if(offset < s3io->size)
+	    avail = ((long long)offset + (long long)extent <= s3io->size ? extent : (size_t)(s3io->size - offset));
+	if((status = ncpagecacheread(s3io->cache,(size64_t)offset,avail,s3io->buffer)))
+	    goto done;
+	if(avail < extent)
+	    memset((char*)s3io->buffer + avail,0,extent - avail);
+    }
 
     if(vpp) *vpp = s3io->buffer;
 done:
     return status;
 }
 
+/* Page cache callback: one ranged GET */
+static int
+s3io_fetch(void* state, size64_t offset, size_t count, void* buf)
+{
+    int status = NC_NOERR;
+    NCS3IO* s3io = (NCS3IO*)state;
+
+    status = NC_s3sdkread(s3io->s3client, s3io->s3.bucket, s3io->s3.rootkey, offset, count, buf, &s3io->errmsg);
+    if(status) reporterr(s3io);
+    return status;
+}
+
+static int
+s3io_stats(ncio* nciop, NCpagestats* statsp)
+{
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    ncpagecachestats(((NCS3IO*)nciop->pvt)->cache,statsp);
+    return NC_NOERR;
+}
+
 /*
  * Like memmove(), safely move possibly overlapping data.
  */
@@ -309,15 +353,9 @@ s3io_move(ncio* const nciop, off_t to, off_t from, size_t nbytes, int ignored)
 static int
 s3io_rel(ncio* const nciop, off_t offset, int rflags)
 {
-    int status = NC_NOERR;
-    NCS3IO* s3io;
-
-    if(nciop == NULL || nciop->pvt == NULL) {status = NC_EINVAL; goto done;}
-    s3io = (NCS3IO*)nciop->pvt;
-    nullfree(s3io->buffer);
-    s3io->buffer = NULL;
-done:
-    return status;
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    /* the region buffer is kept for reuse by the next get */
+    return NC_NOERR;
 }
 
 /*
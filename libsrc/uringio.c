@@ -0,0 +1,1047 @@
+/*
+ *	Copyright 2018, University Corporation for Atmospheric Research
+ *	See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ */
+
+/*
+ * An ncio implementation for Linux built on io_uring.
+ *
+ * The file is cached in fixed size blocks. A region handed out by
+ * get() that lies in one block points directly into the cache; a
+ * region spanning blocks is assembled in a separate buffer and
+ * scattered back by rel(). All the blocks missing for one get(),
+ * plus a readahead window when the accesses are sequential, are
+ * submitted to the ring together, so several reads are in flight
+ * at once instead of one at a time as in posixio. Modified blocks
+ * are written back in batches when they are evicted, behind a
+ * sequential write stream, and at sync/close.
+ *
+ * The ring is set up with the raw system calls, so only the kernel
+ * header is needed. If the kernel refuses to create a ring, the
+ * open or create fails with ENOSYS and ncio.c falls back to posixio.
+ *
+ * Tunables (environment variable, else .ncrc key):
+ *   NETCDF_URING_BLOCKSIZE   NETCDF.URING.BLOCKSIZE   bytes per block
+ *   NETCDF_URING_CACHEBLOCKS NETCDF.URING.CACHEBLOCKS blocks cached
+ *   NETCDF_URING_READAHEAD   NETCDF.URING.READAHEAD   blocks read ahead
+ *   NETCDF_URING_DIRECT      NETCDF.URING.DIRECT      1 => O_DIRECT
+ * NC_SHARE files always use posixio.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "netcdf.h"
+#include "ncio.h"
+#include "fbits.h"
+#include "ncrc.h"
+#include "ncpathmgr.h"
+
+#undef MIN  /* system may define MIN somewhere and complain */
+#define MIN(mm,nn) (((mm) < (nn)) ? (mm) : (nn))
+#undef MAX
+#define MAX(mm,nn) (((mm) > (nn)) ? (mm) : (nn))
+
+#ifndef NCIO_MINBLOCKSIZE
+#define NCIO_MINBLOCKSIZE 256
+#endif
+#ifndef NCIO_MAXBLOCKSIZE
+#define NCIO_MAXBLOCKSIZE 268435456 /* sanity check, about X_SIZE_T_MAX/8 */
+#endif
+
+#define URING_ALIGN 4096 /* buffer and block alignment, enough for O_DIRECT */
+#define DFALT_URING_BLOCKSIZE (256*1024)
+#define DFALT_URING_CACHEBLOCKS 64
+#define DFALT_URING_READAHEAD 16
+#define URING_MINBLOCKS 8
+
+#define OPENMODE 0666
+
+/**************************************************/
+/* The ring */
+
+typedef struct NCuring {
+    int fd;
+    unsigned entries;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe* cqes;
+    void* sqmap;
+    size_t sqmapsize;
+    void* cqmap;
+    size_t cqmapsize;
+    size_t sqesize;
+    unsigned queued; /* in the SQ, not yet submitted */
+    unsigned inflight; /* submitted, not yet reaped */
+} NCuring;
+
+static int
+uring_setup(NCuring* ring, unsigned entries)
+{
+    struct io_uring_params p;
+    int fd;
+
+    memset(ring,0,sizeof(NCuring));
+    ring->fd = -1;
+    memset(&p,0,sizeof(p));
+    fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if(fd < 0) return ENOSYS;
+    ring->fd = fd;
+    ring->entries = p.sq_entries;
+    ring->sqmapsize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cqmapsize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sqmapsize = ring->cqmapsize = MAX(ring->sqmapsize,ring->cqmapsize);
+    ring->sqmap = mmap(NULL, ring->sqmapsize, PROT_READ|PROT_WRITE,
+                       MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(ring->sqmap == MAP_FAILED) {ring->sqmap = NULL; goto fail;}
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cqmap = ring->sqmap;
+    else {
+        ring->cqmap = mmap(NULL, ring->cqmapsize, PROT_READ|PROT_WRITE,
+                           MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if(ring->cqmap == MAP_FAILED) {ring->cqmap = NULL; goto fail;}
+    }
+    ring->sqesize = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqesize, PROT_READ|PROT_WRITE,
+                       MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(ring->sqes == MAP_FAILED) {ring->sqes = NULL; goto fail;}
+    ring->sq_head = (unsigned*)((char*)ring->sqmap + p.sq_off.head);
+    ring->sq_tail = (unsigned*)((char*)ring->sqmap + p.sq_off.tail);
+    ring->sq_mask = (unsigned*)((char*)ring->sqmap + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)((char*)ring->sqmap + p.sq_off.array);
+    ring->cq_head = (unsigned*)((char*)ring->cqmap + p.cq_off.head);
+    ring->cq_tail = (unsigned*)((char*)ring->cqmap + p.cq_off.tail);
+    ring->cq_mask = (unsigned*)((char*)ring->cqmap + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)((char*)ring->cqmap + p.cq_off.cqes);
+    return NC_NOERR;
+fail:
+    if(ring->sqes) munmap(ring->sqes, ring->sqesize);
+    if(ring->cqmap && ring->cqmap != ring->sqmap) munmap(ring->cqmap, ring->cqmapsize);
+    if(ring->sqmap) munmap(ring->sqmap, ring->sqmapsize);
+    close(fd);
+    ring->fd = -1;
+    return ENOSYS;
+}
+
+static void
+uring_teardown(NCuring* ring)
+{
+    if(ring->fd < 0) return;
+    munmap(ring->sqes, ring->sqesize);
+    if(ring->cqmap != ring->sqmap) munmap(ring->cqmap, ring->cqmapsize);
+    munmap(ring->sqmap, ring->sqmapsize);
+    close(ring->fd);
+    ring->fd = -1;
+}
+
+/* Submit the queued entries and optionally wait for one completion */
+static int
+uring_enter(NCuring* ring, unsigned waitnr)
+{
+    for(;;) {
+        int ret = (int)syscall(__NR_io_uring_enter, ring->fd, ring->queued, waitnr,
+                               (waitnr ? IORING_ENTER_GETEVENTS : 0), NULL, 0);
+        if(ret >= 0) {
+            ring->queued -= (unsigned)ret;
+            ring->inflight += (unsigned)ret;
+            if(ring->queued == 0 || waitnr) return NC_NOERR;
+            continue;
+        }
+        if(errno == EINTR) continue;
+        return errno;
+    }
+}
+
+/* Queue one read or write; the caller guarantees there is room */
+static void
+uring_queue(NCuring* ring, int op, int fd, void* buf, size_t len, off_t offset,
+            unsigned long long userdata)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned idx = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[idx];
+
+    memset(sqe,0,sizeof(*sqe));
+    sqe->opcode = (unsigned char)op;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long)(uintptr_t)buf;
+    sqe->len = (unsigned)len;
+    sqe->off = (unsigned long long)offset;
+    sqe->user_data = userdata;
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->queued++;
+}
+
+/**************************************************/
+/* The block cache */
+
+#define UB_EMPTY   0
+#define UB_READING 1
+#define UB_VALID   2
+#define UB_WRITING 3
+
+typedef struct NCublock {
+    off_t blkno; /* -1 => none */
+    int state;
+    int dirty;
+    int pins; /* regions pointing into this block */
+    int err; /* failed read */
+    unsigned long long tick; /* last use, for LRU */
+    long next; /* hash chain */
+    char* data;
+} NCublock;
+
+/* An outstanding region handed out by get() */
+typedef struct NCuregion {
+    off_t offset;
+    size_t extent;
+    int rflags;
+    long slot; /* the block, or -1 if the region is in span */
+    char* span;
+} NCuregion;
+
+typedef struct NCURINGIO {
+    NCuring ring;
+    int direct; /* opened with O_DIRECT */
+    size_t blksz;
+    size_t nblocks;
+    NCublock* blocks;
+    char* pool;
+    long* hash; /* hashsize heads of chains of slots */
+    size_t hashsize; /* a power of 2 */
+    size_t readahead;
+    off_t size; /* logical size of the file */
+    off_t disksize; /* size of the file on disk */
+    off_t lastend; /* end of the previous get */
+    int sequential; /* consecutive sequential gets */
+    unsigned long long tick;
+    NCuregion* regions;
+    size_t nregions;
+    size_t allocregions;
+    int werr; /* first write error, reported by sync/close */
+} NCURINGIO;
+
+#define UD_WRITE 1ULL
+#define USERDATA(slot,iswrite) ((((unsigned long long)(slot)) << 1) | ((iswrite) ? UD_WRITE : 0))
+
+/* Forward */
+static int uringio_rel(ncio *const nciop, off_t offset, int rflags);
+static int uringio_get(ncio *const nciop, off_t offset, size_t extent, int rflags, void **const vpp);
+static int uringio_move(ncio *const nciop, off_t to, off_t from, size_t nbytes, int rflags);
+static int uringio_sync(ncio *const nciop);
+static int uringio_filesize(ncio* nciop, off_t* filesizep);
+static int uringio_pad_length(ncio* nciop, off_t length);
+static int uringio_close(ncio* nciop, int);
+
+static long
+hashfind(NCURINGIO* u, off_t blkno)
+{
+    long slot = u->hash[(size_t)blkno & (u->hashsize - 1)];
+    while(slot >= 0 && u->blocks[slot].blkno != blkno)
+        slot = u->blocks[slot].next;
+    return slot;
+}
+
+static void
+hashremove(NCURINGIO* u, long slot)
+{
+    NCublock* b = &u->blocks[slot];
+    long* linkp;
+    if(b->blkno < 0) return;
+    linkp = &u->hash[(size_t)b->blkno & (u->hashsize - 1)];
+    while(*linkp != slot) linkp = &u->blocks[*linkp].next;
+    *linkp = b->next;
+    b->next = -1;
+    b->blkno = -1;
+}
+
+static void
+hashinsert(NCURINGIO* u, long slot, off_t blkno)
+{
+    NCublock* b = &u->blocks[slot];
+    size_t h = (size_t)blkno & (u->hashsize - 1);
+    b->blkno = blkno;
+    b->next = u->hash[h];
+    u->hash[h] = slot;
+}
+
+/* Number of bytes of block b that belong to the file */
+static size_t
+writelen(NCURINGIO* u, NCublock* b)
+{
+    off_t start = b->blkno * (off_t)u->blksz;
+    if(start >= u->size) return 0;
+    if(u->direct) return u->blksz; /* trimmed by ftruncate at sync */
+    return (size_t)MIN((off_t)u->blksz, u->size - start);
+}
+
+/* Handle one completion */
+static void
+complete(ncio* nciop, unsigned long long userdata, int res)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    long slot = (long)(userdata >> 1);
+    NCublock* b = &u->blocks[slot];
+    off_t start = b->blkno * (off_t)u->blksz;
+
+    if(userdata & UD_WRITE) {
+        size_t len = writelen(u, b);
+        if(res < 0) {
+            if(u->werr == NC_NOERR) u->werr = -res;
+        } else if((size_t)res < len) {
+            /* Finish a short write synchronously */
+            ssize_t n = pwrite(nciop->fd, b->data + res, len - (size_t)res, start + res);
+            if(n != (ssize_t)(len - (size_t)res) && u->werr == NC_NOERR)
+                u->werr = (n < 0 ? errno : EIO);
+        }
+        if(start + (off_t)len > u->disksize) u->disksize = start + (off_t)len;
+        b->state = UB_VALID;
+    } else {
+        size_t got = (res < 0 ? 0 : (size_t)res);
+        b->err = (res < 0 ? -res : NC_NOERR);
+        /* Finish a short read short of the end of the file */
+        while(b->err == NC_NOERR && !u->direct && got < u->blksz
+              && start + (off_t)got < u->disksize) {
+            ssize_t n = pread(nciop->fd, b->data + got, u->blksz - got, start + (off_t)got);
+            if(n < 0) b->err = errno;
+            if(n <= 0) break;
+            got += (size_t)n;
+        }
+        if(got < u->blksz) memset(b->data + got, 0, u->blksz - got);
+        b->state = UB_VALID;
+    }
+}
+
+/* Reap completions; wait for at least one if wait is set */
+static int
+reap(ncio* nciop, int wait)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    NCuring* ring = &u->ring;
+    int status = NC_NOERR;
+
+    if(wait && ring->inflight + ring->queued > 0) {
+        unsigned head = *ring->cq_head;
+        if(head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+            if((status = uring_enter(ring, 1))) return status;
+    }
+    for(;;) {
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        if(head == tail) break;
+        while(head != tail) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+            unsigned long long userdata = cqe->user_data;
+            int res = cqe->res;
+            head++;
+            __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+            ring->inflight--;
+            complete(nciop, userdata, res);
+        }
+    }
+    return status;
+}
+
+/* Make room in the submission queue for one more entry */
+static int
+reserve(ncio* nciop)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    NCuring* ring = &u->ring;
+    int status = NC_NOERR;
+
+    /* Never have more in flight than the completion queue can hold */
+    while(ring->queued + ring->inflight >= ring->entries) {
+        if(ring->queued > 0 && (status = uring_enter(ring, 0))) return status;
+        if(ring->queued + ring->inflight >= ring->entries
+           && (status = reap(nciop, 1))) return status;
+    }
+    return status;
+}
+
+/* Queue the write back of a dirty block */
+static int
+writeback(ncio* nciop, long slot)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    NCublock* b = &u->blocks[slot];
+    size_t len;
+    int status;
+
+    assert(b->state == UB_VALID && b->dirty);
+    b->dirty = 0;
+    if((len = writelen(u, b)) == 0) return NC_NOERR;
+    if((status = reserve(nciop))) return status;
+    b->state = UB_WRITING;
+    uring_queue(&u->ring, IORING_OP_WRITE, nciop->fd, b->data, len,
+                b->blkno * (off_t)u->blksz, USERDATA(slot,1));
+    return NC_NOERR;
+}
+
+/* Queue the write back of every dirty block not in use */
+static int
+writeall(ncio* nciop)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    size_t i;
+    int status = NC_NOERR;
+
+    for(i = 0; i < u->nblocks; i++) {
+        NCublock* b = &u->blocks[i];
+        if(b->state == UB_VALID && b->dirty && b->pins == 0)
+            if((status = writeback(nciop, (long)i))) break;
+    }
+    return status;
+}
+
+/* Wait until nothing is in flight */
+static int
+drain(ncio* nciop)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    int status = NC_NOERR;
+
+    if(u->ring.queued > 0 && (status = uring_enter(&u->ring, 0))) return status;
+    while(u->ring.inflight > 0)
+        if((status = reap(nciop, 1))) break;
+    return status;
+}
+
+/* Find a free slot, evicting the least recently used clean block */
+static int
+allocslot(ncio* nciop, long* slotp)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    int status = NC_NOERR;
+
+    for(;;) {
+        long victim = -1;
+        int ndirty = 0;
+        size_t i;
+        for(i = 0; i < u->nblocks; i++) {
+            NCublock* b = &u->blocks[i];
+            if(b->pins > 0 || b->state == UB_READING || b->state == UB_WRITING)
+                continue;
+            if(b->dirty) {ndirty++; continue;}
+            if(b->blkno < 0) {victim = (long)i; break;}
+            if(victim < 0 || b->tick < u->blocks[victim].tick)
+                victim = (long)i;
+        }
+        if(victim >= 0) {
+            hashremove(u, victim);
+            u->blocks[victim].state = UB_EMPTY;
+            u->blocks[victim].err = NC_NOERR;
+            *slotp = victim;
+            return NC_NOERR;
+        }
+        /* Clean some blocks in one batch, or wait for I/O to finish */
+        if(ndirty > 0)
+            status = writeall(nciop);
+        else if(u->ring.queued + u->ring.inflight == 0)
+            return NC_EINTERNAL; /* every block is pinned */
+        if(status == NC_NOERR && u->ring.queued > 0)
+            status = uring_enter(&u->ring, 0);
+        if(status == NC_NOERR)
+            status = reap(nciop, 1);
+        if(status != NC_NOERR) return status;
+    }
+}
+
+/* Start reading a block unless it is cached or in flight */
+static int
+prefetch(ncio* nciop, off_t blkno)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    long slot;
+    int status;
+    off_t start = blkno * (off_t)u->blksz;
+
+    if(hashfind(u, blkno) >= 0) return NC_NOERR;
+    if((status = allocslot(nciop, &slot))) return status;
+    hashinsert(u, slot, blkno);
+    u->blocks[slot].tick = ++u->tick;
+    if(start >= u->disksize) {
+        /* Nothing on disk yet */
+        memset(u->blocks[slot].data, 0, u->blksz);
+        u->blocks[slot].state = UB_VALID;
+        return NC_NOERR;
+    }
+    if((status = reserve(nciop))) {
+        hashremove(u, slot);
+        return status;
+    }
+    u->blocks[slot].state = UB_READING;
+    uring_queue(&u->ring, IORING_OP_READ, nciop->fd, u->blocks[slot].data, u->blksz,
+                start, USERDATA(slot,0));
+    return NC_NOERR;
+}
+
+/* Return the slot of a valid block, pinned */
+static int
+pinblock(ncio* nciop, off_t blkno, long* slotp)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    long slot;
+    int status;
+
+    if((slot = hashfind(u, blkno)) < 0) {
+        if((status = prefetch(nciop, blkno))) return status;
+        slot = hashfind(u, blkno);
+        assert(slot >= 0);
+    }
+    u->blocks[slot].pins++;
+    if(u->ring.queued > 0 && (status = uring_enter(&u->ring, 0)))
+        goto fail;
+    /* The block may be being read, or written back */
+    while(u->blocks[slot].state == UB_READING || u->blocks[slot].state == UB_WRITING)
+        if((status = reap(nciop, 1))) goto fail;
+    if((status = u->blocks[slot].err)) {
+        /* Forget the failed read so that it is retried */
+        u->blocks[slot].pins--;
+        if(u->blocks[slot].pins == 0) hashremove(u, slot);
+        return status;
+    }
+    u->blocks[slot].tick = ++u->tick;
+    *slotp = slot;
+    return NC_NOERR;
+fail:
+    u->blocks[slot].pins--;
+    return status;
+}
+
+/* Queue the reads of blocks [first,last] that are not cached */
+static int
+prefetchrange(ncio* nciop, off_t first, off_t last)
+{
+    NCURINGIO* u = (NCURINGIO*)nciop->pvt;
+    off_t blkno;
+    int status = NC_NOERR;
+    off_t maxblocks = (off_t)(u->nblocks / 2); /* leave room for the caller */
+
+    if(last - first + 1 > maxblocks) last = first + maxblocks - 1;
+    for(blkno = first; blkno <= last && status == NC_NOERR; blkno++)
+        status = prefetch(nciop, blkno);
+    return status;
+}
+
+/**************************************************/
+
+/* Create a new ncio struct to hold info about the file. */
+static int
+uringio_new(const char* path, int ioflags, size_t* sizehintp, ncio** nciopp)
+{
+    int status = NC_NOERR;
+    ncio* nciop = NULL;
+    NCURINGIO* u = NULL;
+    size_t blksz, nblocks, i;
+    unsigned entries;
+
+    nciop = (ncio*)calloc(1,sizeof(ncio));
+    if(nciop == NULL) {status = ENOMEM; goto fail;}
+    nciop->ioflags = ioflags;
+    *((int*)&nciop->fd) = -1; /* caller will fix */
+    *((char**)&nciop->path) = strdup(path);
+    if(nciop->path == NULL) {status = ENOMEM; goto fail;}
+
+    *((ncio_relfunc**)&nciop->rel) = uringio_rel;
+    *((ncio_getfunc**)&nciop->get) = uringio_get;
+    *((ncio_movefunc**)&nciop->move) = uringio_move;
+    *((ncio_syncfunc**)&nciop->sync) = uringio_sync;
+    *((ncio_filesizefunc**)&nciop->filesize) = uringio_filesize;
+    *((ncio_pad_lengthfunc**)&nciop->pad_length) = uringio_pad_length;
+    *((ncio_closefunc**)&nciop->close) = uringio_close;
+
+    u = (NCURINGIO*)calloc(1,sizeof(NCURINGIO));
+    if(u == NULL) {status = ENOMEM; goto fail;}
+    *((void**)&nciop->pvt) = u;
+    u->ring.fd = -1;
+
+    /* An explicit chunk size hint wins over the configured block size */
+    blksz = *sizehintp;
+    if(blksz < NCIO_MINBLOCKSIZE)
+        blksz = NC_rclookupsize(NULL,"NETCDF_URING_BLOCKSIZE","NETCDF.URING.BLOCKSIZE",DFALT_URING_BLOCKSIZE);
+    if(blksz > NCIO_MAXBLOCKSIZE) blksz = NCIO_MAXBLOCKSIZE;
+    blksz = ((blksz + URING_ALIGN - 1) / URING_ALIGN) * URING_ALIGN;
+    u->blksz = blksz;
+    u->readahead = NC_rclookupsize(NULL,"NETCDF_URING_READAHEAD","NETCDF.URING.READAHEAD",DFALT_URING_READAHEAD);
+    nblocks = NC_rclookupsize(NULL,"NETCDF_URING_CACHEBLOCKS","NETCDF.URING.CACHEBLOCKS",DFALT_URING_CACHEBLOCKS);
+    if(nblocks < URING_MINBLOCKS) nblocks = URING_MINBLOCKS;
+    /* The readahead window must leave room for the blocks in use */
+    if(u->readahead > nblocks / 2) u->readahead = nblocks / 2;
+    u->nblocks = nblocks;
+
+    for(entries = 32; entries < 2 * nblocks && entries < 4096; entries *= 2);
+    if((status = uring_setup(&u->ring, entries))) goto fail;
+
+    if(posix_memalign((void**)&u->pool, URING_ALIGN, nblocks * blksz))
+        {u->pool = NULL; status = ENOMEM; goto fail;}
+    if((u->blocks = (NCublock*)calloc(nblocks,sizeof(NCublock))) == NULL)
+        {status = ENOMEM; goto fail;}
+    for(u->hashsize = 16; u->hashsize < 2 * nblocks; u->hashsize *= 2);
+    if((u->hash = (long*)malloc(u->hashsize * sizeof(long))) == NULL)
+        {status = ENOMEM; goto fail;}
+    for(i = 0; i < u->hashsize; i++) u->hash[i] = -1;
+    for(i = 0; i < nblocks; i++) {
+        u->blocks[i].blkno = -1;
+        u->blocks[i].next = -1;
+        u->blocks[i].data = u->pool + i * blksz;
+    }
+    u->lastend = -1;
+
+    *sizehintp = blksz;
+    *nciopp = nciop;
+    return NC_NOERR;
+
+fail:
+    if(u != NULL) {
+        uring_teardown(&u->ring);
+        free(u->pool);
+        free(u->blocks);
+        free(u->hash);
+        free(u);
+    }
+    if(nciop != NULL) {
+        free((char*)nciop->path);
+        free(nciop);
+    }
+    return status;
+}
+
+static void
+uringio_free(ncio* nciop)
+{
+    NCURINGIO* u;
+    size_t i;
+
+    if(nciop == NULL) return;
+    u = (NCURINGIO*)nciop->pvt;
+    if(u != NULL) {
+        uring_teardown(&u->ring);
+        for(i = 0; i < u->nregions; i++) free(u->regions[i].span);
+        free(u->regions);
+        free(u->pool);
+        free(u->blocks);
+        free(u->hash);
+        free(u);
+    }
+    free((char*)nciop->path);
+    free(nciop);
+}
+
+/* Open the file, with O_DIRECT if configured and supported */
+static int
+uringio_openfd(ncio* nciop, const char* path, int oflags, int* directp)
+{
+    int fd = -1;
+    *directp = 0;
+#ifdef O_DIRECT
+    if(NC_rclookupsize(NULL,"NETCDF_URING_DIRECT","NETCDF.URING.DIRECT",0) != 0) {
+        fd = NCopen3(path, oflags|O_DIRECT, OPENMODE);
+        if(fd >= 0) *directp = 1;
+        else if(errno != EINVAL) return -1;
+    }
+#endif
+    if(fd < 0)
+        fd = NCopen3(path, oflags, OPENMODE);
+    if(fd >= 0)
+        *((int*)&nciop->fd) = fd; /* cast away const */
+    return fd;
+}
+
+/* Create a file, and the ncio struct to go with it; see posixio_create */
+int
+uringio_create(const char* path, int ioflags,
+    size_t initialsz,
+    off_t igeto, size_t igetsz, size_t* sizehintp,
+    void* parameters,
+    ncio** nciopp, void** const mempp)
+{
+    ncio* nciop = NULL;
+    NCURINGIO* u;
+    int oflags = (O_RDWR|O_CREAT);
+    int status;
+    NC_UNUSED(parameters);
+
+    if(path == NULL || *path == 0)
+        return EINVAL;
+    if(initialsz < (size_t)igeto + igetsz)
+        initialsz = (size_t)igeto + igetsz;
+    fSet(ioflags, NC_WRITE);
+
+    if((status = uringio_new(path, ioflags, sizehintp, &nciop)))
+        return status;
+    u = (NCURINGIO*)nciop->pvt;
+
+    if(fIsSet(ioflags, NC_NOCLOBBER))
+        fSet(oflags, O_EXCL);
+    else
+        fSet(oflags, O_TRUNC);
+    if(uringio_openfd(nciop, path, oflags, &u->direct) < 0) {
+        status = errno ? errno : ENOENT;
+        uringio_free(nciop);
+        return status;
+    }
+
+    if(initialsz != 0) {
+        u->size = (off_t)initialsz;
+        if(ftruncate(nciop->fd, (off_t)initialsz) < 0)
+            {status = errno; goto unwind_open;}
+        u->disksize = (off_t)initialsz;
+    }
+
+    if(igetsz != 0) {
+        status = nciop->get(nciop, igeto, igetsz, RGN_WRITE, mempp);
+        if(status != NC_NOERR)
+            goto unwind_open;
+    }
+
+    *nciopp = nciop;
+    return NC_NOERR;
+
+unwind_open:
+    uringio_close(nciop, !fIsSet(ioflags, NC_NOCLOBBER));
+    return status;
+}
+
+/* Open a file, and the ncio struct to go with it; see posixio_open */
+int
+uringio_open(const char* path,
+    int ioflags,
+    off_t igeto, size_t igetsz, size_t* sizehintp,
+    void* parameters,
+    ncio** nciopp, void** const mempp)
+{
+    ncio* nciop = NULL;
+    NCURINGIO* u;
+    int oflags = (fIsSet(ioflags, NC_WRITE) ? O_RDWR : O_RDONLY);
+    struct stat st;
+    int status;
+    NC_UNUSED(parameters);
+
+    if(path == NULL || *path == 0)
+        return EINVAL;
+
+    if((status = uringio_new(path, ioflags, sizehintp, &nciop)))
+        return status;
+    u = (NCURINGIO*)nciop->pvt;
+
+    if(uringio_openfd(nciop, path, oflags, &u->direct) < 0) {
+        status = errno ? errno : ENOENT;
+        uringio_free(nciop);
+        return status;
+    }
+    if(fstat(nciop->fd, &st) < 0) {status = errno; goto unwind_open;}
+    u->size = u->disksize = st.st_size;
+
+    if(igetsz != 0) {
+        status = nciop->get(nciop, igeto, igetsz, 0, mempp);
+        if(status != NC_NOERR)
+            goto unwind_open;
+    }
+
+    *nciopp = nciop;
+    return NC_NOERR;
+
+unwind_open:
+    uringio_close(nciop, 0);
+    return status;
+}
+
+/*
+ * Request that the region (offset, extent)
+ * be made available through *vpp.
+ */
+static int
+uringio_get(ncio* const nciop, off_t offset, size_t extent, int rflags, void** const vpp)
+{
+    NCURINGIO* u;
+    NCuregion* region;
+    off_t first, last, blkno;
+    int status = NC_NOERR;
+
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    u = (NCURINGIO*)nciop->pvt;
+    if(fIsSet(rflags, RGN_WRITE) && !fIsSet(nciop->ioflags, NC_WRITE))
+        return EPERM; /* attempt to write readonly file */
+
+    if(u->nregions == u->allocregions) {
+        size_t n = (u->allocregions == 0 ? 4 : 2 * u->allocregions);
+        NCuregion* r = (NCuregion*)realloc(u->regions, n * sizeof(NCuregion));
+        if(r == NULL) return ENOMEM;
+        u->regions = r;
+        u->allocregions = n;
+    }
+    region = &u->regions[u->nregions];
+    region->offset = offset;
+    region->extent = extent;
+    region->rflags = rflags;
+    region->slot = -1;
+    region->span = NULL;
+
+    /* Track sequential streams for readahead and write-behind */
+    if(u->lastend >= 0 && offset >= u->lastend - (off_t)u->blksz
+       && offset <= u->lastend + (off_t)u->blksz)
+        u->sequential++;
+    else
+        u->sequential = 0;
+    u->lastend = offset + (off_t)extent;
+
+    first = offset / (off_t)u->blksz;
+    last = (extent == 0 ? first : (offset + (off_t)extent - 1) / (off_t)u->blksz);
+
+    if(first == last) {
+        if((status = pinblock(nciop, first, &region->slot))) return status;
+        *vpp = u->blocks[region->slot].data + (offset - first * (off_t)u->blksz);
+    } else {
+        /* Submit all the missing blocks at once, then assemble them */
+        char* p;
+        if((region->span = (char*)malloc(extent)) == NULL) return ENOMEM;
+        if((status = prefetchrange(nciop, first, last))) goto fail;
+        for(p = region->span, blkno = first; blkno <= last; blkno++) {
+            long slot;
+            off_t bstart = blkno * (off_t)u->blksz;
+            off_t lo = MAX(offset, bstart);
+            off_t hi = MIN(offset + (off_t)extent, bstart + (off_t)u->blksz);
+            if((status = pinblock(nciop, blkno, &slot))) goto fail;
+            memcpy(p, u->blocks[slot].data + (lo - bstart), (size_t)(hi - lo));
+            u->blocks[slot].pins--;
+            p += hi - lo;
+        }
+        *vpp = region->span;
+    }
+
+    /* Read ahead of a sequential stream of reads */
+    if(u->sequential >= 2 && u->readahead > 0 && !fIsSet(rflags, RGN_WRITE)) {
+        off_t ra = last + 1;
+        off_t ralast = MIN(last + (off_t)u->readahead,
+                           (u->disksize - 1) / (off_t)u->blksz);
+        if(ra <= ralast) (void)prefetchrange(nciop, ra, ralast);
+        if(u->ring.queued > 0) (void)uring_enter(&u->ring, 0);
+    }
+    u->nregions++;
+    return NC_NOERR;
+
+fail:
+    free(region->span);
+    region->span = NULL;
+    return status;
+}
+
+static int
+uringio_rel(ncio* const nciop, off_t offset, int rflags)
+{
+    NCURINGIO* u;
+    NCuregion region;
+    size_t i;
+    int status = NC_NOERR;
+
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    u = (NCURINGIO*)nciop->pvt;
+
+    /* Find the most recent region holding this offset; like posixio,
+       callers may release a region by any offset within it */
+    for(i = u->nregions; i-- > 0;) {
+        NCuregion* r = &u->regions[i];
+        if(offset >= r->offset && offset <= r->offset + (off_t)r->extent) break;
+    }
+    if(i == (size_t)-1) return NC_EINVAL;
+    region = u->regions[i];
+    offset = region.offset;
+    memmove(&u->regions[i], &u->regions[i+1], (u->nregions - i - 1) * sizeof(NCuregion));
+    u->nregions--;
+
+    if(fIsSet(rflags, RGN_MODIFIED)) {
+        if(!fIsSet(region.rflags, RGN_WRITE)) status = EPERM;
+        else if(region.span == NULL)
+            u->blocks[region.slot].dirty = 1;
+        else {
+            /* Scatter the span back into its blocks */
+            off_t first = offset / (off_t)u->blksz;
+            off_t last = (offset + (off_t)region.extent - 1) / (off_t)u->blksz;
+            off_t blkno;
+            char* p = region.span;
+            for(blkno = first; blkno <= last && status == NC_NOERR; blkno++) {
+                long slot;
+                off_t bstart = blkno * (off_t)u->blksz;
+                off_t lo = MAX(offset, bstart);
+                off_t hi = MIN(offset + (off_t)region.extent, bstart + (off_t)u->blksz);
+                if((status = pinblock(nciop, blkno, &slot))) break;
+                memcpy(u->blocks[slot].data + (lo - bstart), p, (size_t)(hi - lo));
+                u->blocks[slot].dirty = 1;
+                u->blocks[slot].pins--;
+                p += hi - lo;
+            }
+        }
+        if(status == NC_NOERR && offset + (off_t)region.extent > u->size)
+            u->size = offset + (off_t)region.extent;
+    }
+    if(region.slot >= 0) {
+        NCublock* b = &u->blocks[region.slot];
+        b->pins--;
+        /* Write behind a sequential stream once a block is complete */
+        if(status == NC_NOERR && b->dirty && b->pins == 0 && u->sequential >= 2
+           && (offset + (off_t)region.extent) % (off_t)u->blksz == 0) {
+            status = writeback(nciop, region.slot);
+            if(status == NC_NOERR && u->ring.queued > 0)
+                status = uring_enter(&u->ring, 0);
+        }
+    }
+    free(region.span);
+    return status;
+}
+
+/*
+ * Like memmove(), safely move possibly overlapping data,
+ * one block at a time.
+ */
+static int
+uringio_move(ncio* const nciop, off_t to, off_t from, size_t nbytes, int rflags)
+{
+    NCURINGIO* u;
+    char* tmp = NULL;
+    size_t done = 0;
+    int status = NC_NOERR;
+    NC_UNUSED(rflags);
+
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    u = (NCURINGIO*)nciop->pvt;
+    if(to == from || nbytes == 0) return NC_NOERR;
+    if((tmp = (char*)malloc(u->blksz)) == NULL) return ENOMEM;
+    while(done < nbytes && status == NC_NOERR) {
+        size_t n = MIN(u->blksz, nbytes - done);
+        /* Moving up: copy from the end, so that nothing is overwritten before it is read */
+        off_t delta = (to > from ? (off_t)(nbytes - done - n) : (off_t)done);
+        void* vp = NULL;
+        if((status = uringio_get(nciop, from + delta, n, 0, &vp))) break;
+        memcpy(tmp, vp, n);
+        (void)uringio_rel(nciop, from + delta, 0);
+        if((status = uringio_get(nciop, to + delta, n, RGN_WRITE, &vp))) break;
+        memcpy(vp, tmp, n);
+        status = uringio_rel(nciop, to + delta, RGN_MODIFIED);
+        done += n;
+    }
+    free(tmp);
+    return status;
+}
+
+/*
+ * Write out any dirty buffers to disk and
+ * ensure that next read will get data from disk.
+ */
+static int
+uringio_sync(ncio* const nciop)
+{
+    NCURINGIO* u;
+    size_t i;
+    int status;
+
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    u = (NCURINGIO*)nciop->pvt;
+    status = writeall(nciop);
+    if(status == NC_NOERR) status = drain(nciop);
+    else (void)drain(nciop);
+    if(status == NC_NOERR && u->direct && u->disksize > u->size) {
+        if(ftruncate(nciop->fd, u->size) < 0) status = errno;
+        else u->disksize = u->size;
+    }
+    if(status == NC_NOERR && u->werr != NC_NOERR) {
+        status = u->werr;
+        u->werr = NC_NOERR;
+    }
+    /* Forget the clean blocks */
+    for(i = 0; i < u->nblocks; i++) {
+        NCublock* b = &u->blocks[i];
+        if(b->pins == 0 && !b->dirty && b->state == UB_VALID) {
+            hashremove(u, (long)i);
+            b->state = UB_EMPTY;
+        }
+    }
+    u->lastend = -1;
+    u->sequential = 0;
+    return status;
+}
+
+/*
+ * Get file size in bytes.
+ */
+static int
+uringio_filesize(ncio* nciop, off_t* filesizep)
+{
+    NCURINGIO* u;
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    u = (NCURINGIO*)nciop->pvt;
+    if(filesizep != NULL) *filesizep = u->size;
+    return NC_NOERR;
+}
+
+/*
+ *  Sync any changes to disk, then truncate or extend file so its size
+ *  is length.  This is only intended to be called before close, if the
+ *  file is open for writing and the actual size does not match the
+ *  calculated size, perhaps as the result of having been previously
+ *  written in NOFILL mode.
+ */
+static int
+uringio_pad_length(ncio* nciop, off_t length)
+{
+    NCURINGIO* u;
+    int status;
+
+    if(nciop == NULL || nciop->pvt == NULL) return NC_EINVAL;
+    u = (NCURINGIO*)nciop->pvt;
+    if(!fIsSet(nciop->ioflags, NC_WRITE))
+        return EPERM; /* attempt to write readonly file */
+    if((status = uringio_sync(nciop))) return status;
+    if(ftruncate(nciop->fd, length) < 0) return errno;
+    u->size = u->disksize = length;
+    return NC_NOERR;
+}
+
+/* Write out any dirty buffers and
+   ensure that next read will not get cached data.
+   Sync any changes, then close the open file associated with the ncio
+   struct, and free its memory.
+   nciop - pointer to ncio to close.
+   doUnlink - if true, unlink file
+*/
+static int
+uringio_close(ncio* nciop, int doUnlink)
+{
+    int status = NC_NOERR;
+
+    if(nciop == NULL) return NC_NOERR;
+    if(nciop->pvt != NULL && nciop->fd >= 0) {
+        if(fIsSet(nciop->ioflags, NC_WRITE) && !doUnlink)
+            status = uringio_sync(nciop);
+        else
+            (void)drain(nciop);
+    }
+    if(nciop->fd >= 0) {
+        (void)close(nciop->fd);
+        if(doUnlink)
+            (void)unlink(nciop->path);
+    }
+    uringio_free(nciop);
+    return status;
+}
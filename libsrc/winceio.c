@@ -464,6 +464,7 @@ ncio_new(const char *path, int ioflags)
 
 				/* cast away const */
 	*((void **)&nciop->pvt) = (void *)(nciop->path + sz_path);
+	*((ncio_statsfunc **)&nciop->stats) = NULL; /* no read cache */
 
 	ncio_fileio_init(nciop);
 
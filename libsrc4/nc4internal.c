@@ -446,6 +446,10 @@ nc4_find_nc_grp_h5(int ncid, NC **nc, NC_GRP_INFO_T **grp, NC_FILE_INFO_T **h5)
     if (!(my_grp = nclistget(my_h5->allgroups,index)))
         return NC_EBADID;
 
+    /* Read the group, if the file was opened with lazy groups. */
+    if ((retval = nc4_read_lazy_grp(my_grp)))
+        return retval;
+
     /* Return pointers to caller, if desired. */
     if (nc)
         *nc = my_nc;
@@ -457,6 +461,27 @@ nc4_find_nc_grp_h5(int ncid, NC **nc, NC_GRP_INFO_T **grp, NC_FILE_INFO_T **h5)
     return NC_NOERR;
 }
 
+/**
+ * @internal Read the contents of a group that has not been read
+ * yet. When a file is opened with NC_LAZYGROUPS, the groups below the
+ * root are only added to their parent at open, and the format reads
+ * one when it is first used.
+ *
+ * @param grp Pointer to group info.
+ *
+ * @return ::NC_NOERR No error.
+ * @return Error from the format, which is returned again by every
+ * later call.
+ */
+int
+nc4_read_lazy_grp(NC_GRP_INFO_T *grp)
+{
+    assert(grp && grp->nc4_info);
+    if (!grp->lazy || grp->nc4_info->read_grp == NULL)
+        return NC_NOERR;
+    return grp->nc4_info->read_grp(grp);
+}
+
 /**
  * @internal Given an ncid and varid, get pointers to the group and var
  * metadata.
@@ -579,6 +604,8 @@ nc4_rec_find_named_type(NC_GRP_INFO_T *start_grp, char *name)
     for(size_t i=0;i<ncindexsize(start_grp->children);i++) {
         g = (NC_GRP_INFO_T*)ncindexith(start_grp->children,i);
         if(g == NULL) continue;
+        /* A group that cannot be read has no types. */
+        if (nc4_read_lazy_grp(g)) continue;
         if ((res = nc4_rec_find_named_type(g, name)))
             return res;
     }
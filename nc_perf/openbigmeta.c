@@ -9,35 +9,62 @@ See \ref copyright file for more info.
 
 */
 /*
-Open a netcdf-4 file with horrendously large metadata.
+Open a netcdf-4 file with horrendously large metadata, as created by
+bigmeta: eagerly, and with NC_LAZYGROUPS, both alone and followed by
+a walk down the first group of every level to the deepest one.
 */
 
 #include <config.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <time.h>
+#include <sys/time.h>
 #include <assert.h>
 #include <netcdf.h>
 
 #define FILE "bigmeta.nc"
 
-int
-main(int argc, char **argv)
+/* Return the time in msec since t0 */
+static double
+elapsed(struct timeval* t0)
+{
+    struct timeval t1;
+    gettimeofday(&t1,NULL);
+    return (double)(t1.tv_sec - t0->tv_sec) * 1000.0 + (double)(t1.tv_usec - t0->tv_usec) / 1000.0;
+}
+
+/* Open the file; if walk, go down the first groups and inquire about the deepest */
+static double
+timeopen(int mode, int walk)
 {
-    int ncid;
-    time_t starttime, endtime;
-    long long delta;
-
-    starttime = 0;
-    endtime = 0;
-    time(&starttime);
-    assert(nc_open(FILE,NC_NETCDF4,&ncid) == NC_NOERR);
-    time(&endtime);
+    int ncid, grpid, ngrps, nvars;
+    struct timeval t0;
+    double delta;
+
+    gettimeofday(&t0,NULL);
+    assert(nc_open(FILE,mode,&ncid) == NC_NOERR);
+    grpid = ncid;
+    while(walk) {
+        int* grpids;
+        assert(nc_inq_grps(grpid,&ngrps,NULL) == NC_NOERR);
+        if(ngrps == 0) break;
+        grpids = (int*)malloc(sizeof(int)*(size_t)ngrps);
+        assert(nc_inq_grps(grpid,NULL,grpids) == NC_NOERR);
+        grpid = grpids[0];
+        free(grpids);
+    }
+    if(walk)
+        assert(nc_inq_nvars(grpid,&nvars) == NC_NOERR);
+    delta = elapsed(&t0);
     assert(nc_close(ncid) == NC_NOERR);
+    return delta;
+}
 
-    /* Compute the delta 1 second resolution is fine for this */
-    delta = (long long)(endtime - starttime);
-    printf("open delta=%lld\n",delta);
+int
+main(int argc, char **argv)
+{
+    printf("open eager: %.1f msec\n",timeopen(NC_NOWRITE,0));
+    printf("open lazy: %.1f msec\n",timeopen(NC_NOWRITE|NC_LAZYGROUPS,0));
+    printf("open lazy + one path: %.1f msec\n",timeopen(NC_NOWRITE|NC_LAZYGROUPS,1));
     return 0;
 }
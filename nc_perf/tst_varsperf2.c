@@ -0,0 +1,129 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   This program times strided reads (nc_get_vars) of classic and CDF5
+   files, which are serviced by NC3_get_vars. They are compared
+   against the old one-element-at-a-time loop of NCDEFAULT_get_vars
+   used as the baseline in nc_test4/tst_varsperf.c, which is emulated
+   here with nc_get_vara calls.
+*/
+
+#include <nc_tests.h>
+#include "err_macros.h"
+#include <time.h>
+#include <sys/time.h>
+
+#define FILE_NAME "tst_varsperf2.nc"
+#define VAR "bigvar"
+#define NDIMS 2
+#define DIMSIZE0 512
+#define DIMSIZE1 512
+#define TOTALSIZE (DIMSIZE0*DIMSIZE1)
+#define NSTRIDES 3
+
+/* Prototype from tst_utils.c. */
+int nc4_timeval_subtract(struct timeval *result, struct timeval *x,
+                         struct timeval *y);
+
+static int data[TOTALSIZE];
+static double vars_read[TOTALSIZE];
+static double elem_read[TOTALSIZE];
+
+static int
+buildfile(int cmode)
+{
+   int ncid, varid, dimids[NDIMS];
+   int i;
+
+   if (nc_create(FILE_NAME, cmode|NC_CLOBBER, &ncid)) ERR;
+   if (nc_def_dim(ncid, "d0", DIMSIZE0, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "d1", DIMSIZE1, &dimids[1])) ERR;
+   if (nc_def_var(ncid, VAR, NC_INT, NDIMS, dimids, &varid)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   for (i = 0; i < TOTALSIZE; i++)
+      data[i] = i;
+   if (nc_put_var_int(ncid, varid, data)) ERR;
+   if (nc_close(ncid)) ERR;
+   return 0;
+}
+
+/* Read every stride'th element into buf, either with nc_get_vars or
+ * with one nc_get_vara call per element, and store the elapsed time
+ * in usec. */
+static int
+readfile(ptrdiff_t stride, int per_element, double *buf, long long *usec)
+{
+   int ncid, varid;
+   size_t start[NDIMS] = {0, 0}, count[NDIMS], one[NDIMS] = {1, 1};
+   ptrdiff_t strides[NDIMS] = {stride, stride};
+   struct timeval start_time, end_time, diff_time;
+
+   count[0] = (DIMSIZE0 + stride - 1) / stride;
+   count[1] = (DIMSIZE1 + stride - 1) / stride;
+
+   if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+   if (nc_inq_varid(ncid, VAR, &varid)) ERR;
+   if (gettimeofday(&start_time, NULL)) ERR;
+   if (per_element)
+   {
+      size_t index[NDIMS], i0, i1;
+      double *p = buf;
+      for (i0 = 0; i0 < count[0]; i0++)
+         for (i1 = 0; i1 < count[1]; i1++)
+         {
+            index[0] = i0 * stride;
+            index[1] = i1 * stride;
+            if (nc_get_vara_double(ncid, varid, index, one, p++)) ERR;
+         }
+   }
+   else
+   {
+      if (nc_get_vars_double(ncid, varid, start, count, strides, buf)) ERR;
+   }
+   if (gettimeofday(&end_time, NULL)) ERR;
+   if (nc_close(ncid)) ERR;
+   if (nc4_timeval_subtract(&diff_time, &end_time, &start_time)) ERR;
+   *usec = (long long)diff_time.tv_sec * MILLION + diff_time.tv_usec;
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   int formats[] = {NC_FORMAT_CLASSIC, NC_FORMAT_CDF5};
+   int cmodes[] = {0, NC_64BIT_DATA};
+   ptrdiff_t strides[NSTRIDES] = {2, 3, 17};
+   int f, s;
+
+   printf("\n*** Testing speed of strided reads of classic files.\n");
+   for (f = 0; f < 2; f++)
+   {
+      printf("*** format %d...\n", formats[f]);
+      if (buildfile(cmodes[f])) ERR;
+      for (s = 0; s < NSTRIDES; s++)
+      {
+         long long elem_us, vars_us;
+         size_t n0 = (DIMSIZE0 + strides[s] - 1) / strides[s];
+         size_t n1 = (DIMSIZE1 + strides[s] - 1) / strides[s];
+         size_t i0, i1;
+
+         if (readfile(strides[s], 1, elem_read, &elem_us)) ERR;
+         if (readfile(strides[s], 0, vars_read, &vars_us)) ERR;
+
+         /* Both methods must return the same values. */
+         for (i0 = 0; i0 < n0; i0++)
+            for (i1 = 0; i1 < n1; i1++)
+            {
+               double expected = data[i0 * strides[s] * DIMSIZE1 + i1 * strides[s]];
+               if (elem_read[i0 * n1 + i1] != expected) ERR;
+               if (vars_read[i0 * n1 + i1] != expected) ERR;
+            }
+         printf("stride %d: per-element %lld us, nc_get_vars %lld us, speedup %.1f\n",
+                (int)strides[s], elem_us, vars_us,
+                vars_us ? (double)elem_us / vars_us : 0.0);
+      }
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
@@ -0,0 +1,262 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test and benchmark the vector kernels of the ncx conversions
+   (libsrc/ncxsimd.c). For each converted pair and each instruction
+   set level the cpu has, the results of ncx_getn_ and ncx_putn_,
+   including the NC_ERANGE status and the fill values, must be the
+   same as those of the scalar code, for data mixing ordinary values
+   with random bit patterns (out of range values, infinities, NaNs),
+   at odd lengths and alignments. Then the throughput of each pair
+   is reported in GB/s (external plus internal bytes) at each level;
+   only the data is checked, since the speeds depend on the machine.
+
+   Usage: tst_ncxsimd [nelems]
+*/
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "ncx.h"
+#include "ncxsimd.h"
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define DFALTELEMS (1024 * 1024)
+#define NCHECK 1000
+#define MAXSIZE 8
+#define BADADVANCE 1 /* not a netCDF status */
+
+typedef struct Pair {
+   const char* name;
+   size_t xsize; /* external size */
+   size_t isize; /* internal size */
+   int (*get)(const void* xp, size_t n, void* tp);
+   int (*put)(void* xp, size_t n, const void* tp);
+} Pair;
+
+#define GETN(xtype, itype) \
+static int get_##xtype##_##itype(const void* xp, size_t n, void* tp) \
+{ \
+   const void* p = xp; \
+   int stat = ncx_getn_##xtype##_##itype(&p, n, (itype*)tp); \
+   return ((const char*)p - (const char*)xp == (ptrdiff_t)(n * sizeof(xtype)) ? stat : BADADVANCE); \
+}
+#define PUTN(xtype, itype) \
+static int put_##xtype##_##itype(void* xp, size_t n, const void* tp) \
+{ \
+   void* p = xp; \
+   int stat = ncx_putn_##xtype##_##itype(&p, n, (const itype*)tp, NULL); \
+   return ((char*)p - (char*)xp == (ptrdiff_t)(n * sizeof(xtype)) ? stat : BADADVANCE); \
+}
+
+GETN(short, short)
+GETN(int, int)
+GETN(float, float)
+GETN(double, double)
+GETN(short, float)
+GETN(short, double)
+GETN(int, float)
+GETN(int, double)
+GETN(float, double)
+GETN(int, short)
+GETN(double, float)
+PUTN(short, short)
+PUTN(int, int)
+PUTN(float, float)
+PUTN(double, double)
+PUTN(float, double)
+PUTN(double, float)
+
+#define GETPAIR(x, i) {"get " #x " -> " #i, sizeof(x), sizeof(i), get_##x##_##i, NULL}
+#define PUTPAIR(x, i) {"put " #i " -> " #x, sizeof(x), sizeof(i), NULL, put_##x##_##i}
+
+static Pair pairs[] = {
+   GETPAIR(short, short),
+   GETPAIR(int, int),
+   GETPAIR(float, float),
+   GETPAIR(double, double),
+   GETPAIR(short, float),
+   GETPAIR(short, double),
+   GETPAIR(int, float),
+   GETPAIR(int, double),
+   GETPAIR(float, double),
+   GETPAIR(int, short),
+   GETPAIR(double, float),
+   PUTPAIR(short, short),
+   PUTPAIR(int, int),
+   PUTPAIR(float, float),
+   PUTPAIR(double, double),
+   PUTPAIR(float, double),
+   PUTPAIR(double, float),
+   {NULL, 0, 0, NULL, NULL}
+};
+
+static double
+elapsed(struct timeval* t0)
+{
+   struct timeval t1;
+   gettimeofday(&t1, NULL);
+   return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_usec - t0->tv_usec) / 1e6;
+}
+
+/* Store v in the n bytes at p in the byte order of the host (put)
+   or big endian (get) */
+static void
+store(unsigned char* p, size_t n, long long v, double d, int isfloat, int bigendian)
+{
+   unsigned char tmp[MAXSIZE];
+   size_t i;
+   if (isfloat && n == 4) {float f = (float)d; memcpy(tmp, &f, 4);}
+   else if (isfloat) memcpy(tmp, &d, 8);
+   else if (n == 2) {short s = (short)v; memcpy(tmp, &s, 2);}
+   else if (n == 4) {int k = (int)v; memcpy(tmp, &k, 4);}
+   else memcpy(tmp, &v, 8);
+   for (i = 0; i < n; i++)
+      p[i] = (bigendian ? tmp[n - 1 - i] : tmp[i]);
+}
+
+/* Mostly representable values, some random bit patterns */
+static void
+fill(unsigned char* p, size_t nelems, size_t size, int isfloat, int bigendian)
+{
+   size_t i, j;
+   for (i = 0; i < nelems; i++, p += size)
+   {
+      if (rand() % 8 == 0)
+         for (j = 0; j < size; j++)
+            p[j] = (unsigned char)rand();
+      else
+      {
+         long long v = rand() % 60000 - 30000;
+         store(p, size, v, (double)v / 7.0, isfloat, bigendian);
+      }
+   }
+}
+
+static int
+isfloattype(const char* name, int which)
+{
+   /* which: 0 => external type, 1 => internal type */
+   char x[16], in[16], dir[4];
+   if (sscanf(name, "%3s %15s -> %15s", dir, x, in) != 3) return 0;
+   if (strcmp(dir, "put") == 0)
+      return strstr(which ? x : in, "float") || strstr(which ? x : in, "double");
+   return strstr(which ? in : x, "float") || strstr(which ? in : x, "double");
+}
+
+/* Compare every level with the scalar code */
+static int
+check(Pair* pair, int maxlevel)
+{
+   size_t n, off, srcsize, dstsize;
+   unsigned char *src, *ref, *out;
+   int level;
+   int floatsrc = isfloattype(pair->name, 0);
+
+   srcsize = (pair->get ? pair->xsize : pair->isize);
+   dstsize = (pair->get ? pair->isize : pair->xsize);
+   if (!(src = malloc(NCHECK * MAXSIZE + MAXSIZE))) ERR;
+   if (!(ref = malloc(NCHECK * MAXSIZE + MAXSIZE))) ERR;
+   if (!(out = malloc(NCHECK * MAXSIZE + MAXSIZE))) ERR;
+   for (n = 1; n <= NCHECK; n += (n < 80 ? 1 : 97))
+      for (off = 0; off < 2; off++)
+      {
+         /* external data unaligned when off is set */
+         unsigned char* xs = (pair->get ? src + off : src);
+         int refstat;
+         fill(xs, n, srcsize, floatsrc, pair->get != NULL);
+         ncx_simd_set_level(NCX_SIMD_NONE);
+         memset(ref, 0xA5, n * dstsize + off);
+         refstat = (pair->get ? pair->get(xs, n, ref) : pair->put(ref + off, n, xs));
+         if (refstat == BADADVANCE) ERR;
+         for (level = NCX_SIMD_NONE + 1; level <= maxlevel; level++)
+         {
+            int stat;
+            if (ncx_simd_set_level(level) != level) ERR;
+            memset(out, 0xA5, n * dstsize + off);
+            stat = (pair->get ? pair->get(xs, n, out) : pair->put(out + off, n, xs));
+            if (stat != refstat) ERR;
+            if (memcmp(out, ref, n * dstsize + off))
+            {
+               printf("\n      %s at %s differs for %zu elements", pair->name,
+                      ncx_simd_name(level), n);
+               ERR;
+            }
+         }
+      }
+   free(src);
+   free(ref);
+   free(out);
+   return 0;
+}
+
+/* Throughput of one pair at every level, in GB/s */
+static int
+bench(Pair* pair, int maxlevel, size_t nelems)
+{
+   unsigned char *src, *dst;
+   size_t srcsize = (pair->get ? pair->xsize : pair->isize);
+   size_t dstsize = (pair->get ? pair->isize : pair->xsize);
+   int level, reps;
+
+   if (!(src = malloc(nelems * srcsize))) ERR;
+   if (!(dst = malloc(nelems * dstsize))) ERR;
+   /* In range, so that the kernels never stop */
+   {
+      size_t i;
+      for (i = 0; i < nelems; i++)
+      {
+         long long v = (long long)(i % 20000) - 10000;
+         store(src + i * srcsize, srcsize, v, (double)v / 3.0, isfloattype(pair->name, 0),
+               pair->get != NULL);
+      }
+   }
+   printf("\n      %-24s", pair->name);
+   for (level = NCX_SIMD_NONE; level <= maxlevel; level++)
+   {
+      struct timeval t0;
+      double t;
+      ncx_simd_set_level(level);
+      gettimeofday(&t0, NULL);
+      reps = 0;
+      do {
+         if ((pair->get ? pair->get(src, nelems, dst) : pair->put(dst, nelems, src))) ERR;
+         reps++;
+      } while ((t = elapsed(&t0)) < 0.05);
+      printf(" %s %6.2f", ncx_simd_name(level),
+             (double)reps * (double)nelems * (double)(srcsize + dstsize) / t / 1e9);
+   }
+   free(src);
+   free(dst);
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   size_t nelems = DFALTELEMS;
+   int maxlevel;
+   Pair* pair;
+
+   if (argc > 1)
+      nelems = (size_t)atol(argv[1]);
+   if (nelems == 0) nelems = DFALTELEMS;
+   maxlevel = ncx_simd_set_level(NCX_SIMD_AVX512);
+   srand(12345);
+
+   printf("\n*** Testing the ncx vector kernels, up to %s.\n", ncx_simd_name(maxlevel));
+   printf("*** testing against the scalar code...");
+   for (pair = pairs; pair->name != NULL; pair++)
+      if (check(pair, maxlevel)) ERR;
+   SUMMARIZE_ERR;
+   printf("*** timing %zu elements (GB/s)...", nelems);
+   for (pair = pairs; pair->name != NULL; pair++)
+      if (bench(pair, maxlevel, nelems)) ERR;
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
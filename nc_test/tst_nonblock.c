@@ -0,0 +1,198 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test the nonblocking nc_iput_vara/nc_iget_vara/nc_wait_all
+   interface. Every record of several record variables is posted
+   as a separate request, in an order unrelated to the layout of
+   the file, so that for netCDF-3 files the requests must be sorted
+   and combined by nc_wait_all; a large fixed size variable is
+   transferred past the aggregation limit. Errors, cancellation and
+   completion at close are also checked.
+*/
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define FILE_NAME "tst_nonblock.nc"
+#define NVARS 8
+#define NREC 16
+#define NX 10
+#define NBIG (1024 * 1024)
+
+static float
+value(int v, size_t rec, size_t x)
+{
+   return (float)(v * 10000 + (int)(rec * NX + x));
+}
+
+static int
+test_format(int cmode)
+{
+   int ncid, dimids[2], bigdim, varids[NVARS], bigvar, scalar, v;
+   size_t rec, x, i;
+   size_t start[2] = {0, 0}, count[2] = {1, NX};
+   static float data[NVARS][NREC][NX];
+   static float back[NVARS][NREC][NX];
+   int reqids[NVARS * NREC + 1], statuses[NVARS * NREC + 1];
+   int nreqs = 0;
+   int *big = NULL, *bigback = NULL;
+   double dscalar = 0.0;
+
+   if (!(big = malloc(NBIG * sizeof(int)))) ERR;
+   if (!(bigback = malloc(NBIG * sizeof(int)))) ERR;
+   for (i = 0; i < NBIG; i++)
+      big[i] = (int)i - NBIG / 2;
+   for (v = 0; v < NVARS; v++)
+      for (rec = 0; rec < NREC; rec++)
+         for (x = 0; x < NX; x++)
+            data[v][rec][x] = value(v, rec, x);
+
+   if (nc_create(FILE_NAME, cmode, &ncid)) ERR;
+   if (nc_def_dim(ncid, "rec", NC_UNLIMITED, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "x", NX, &dimids[1])) ERR;
+   if (nc_def_dim(ncid, "big", NBIG, &bigdim)) ERR;
+   for (v = 0; v < NVARS; v++)
+   {
+      char name[16];
+      snprintf(name, sizeof(name), "v%d", v);
+      if (nc_def_var(ncid, name, NC_FLOAT, 2, dimids, &varids[v])) ERR;
+   }
+   if (nc_def_var(ncid, "big", NC_INT, 1, &bigdim, &bigvar)) ERR;
+   if (nc_def_var(ncid, "scalar", NC_DOUBLE, 0, NULL, &scalar)) ERR;
+   if (nc_enddef(ncid)) ERR;
+
+   /* Posting does not transfer anything */
+   start[0] = 0;
+   if (nc_iput_vara_float(ncid, varids[0], start, count, data[0][0], &reqids[0])) ERR;
+   if (nc_cancel(ncid, 1, reqids, statuses)) ERR;
+   if (reqids[0] != NC_REQ_NULL || statuses[0] != NC_NOERR) ERR;
+   /* A cancelled request is no longer pending */
+   reqids[0] = 0;
+   if (nc_cancel(ncid, 1, reqids, statuses) != NC_EINVAL) ERR;
+   if (statuses[0] != NC_EINVAL) ERR;
+
+   /* Last record first, last variable first */
+   for (rec = NREC; rec-- > 0;)
+      for (v = NVARS - 1; v >= 0; v--)
+      {
+         start[0] = rec;
+         if (nc_iput_vara_float(ncid, varids[v], start, count, data[v][rec],
+                                &reqids[nreqs++])) ERR;
+      }
+   reqids[nreqs++] = NC_REQ_NULL;
+   if (nc_iput_vara_int(ncid, bigvar, NULL, NULL, big, NULL) != NC_EINVAL) ERR;
+   start[0] = 0;
+   count[0] = NBIG;
+   if (nc_iput_vara_int(ncid, bigvar, start, count, big, NULL)) ERR;
+   count[0] = 1;
+   dscalar = 3.25;
+   if (nc_iput_vara_double(ncid, scalar, NULL, NULL, &dscalar, NULL)) ERR;
+   if (nc_wait_all(ncid, nreqs, reqids, statuses)) ERR;
+   for (i = 0; i < (size_t)nreqs; i++)
+      if (reqids[i] != NC_REQ_NULL || statuses[i] != NC_NOERR) ERR;
+   /* The requests without an id are still pending */
+   if (nc_wait_all(ncid, NC_REQ_ALL, NULL, NULL)) ERR;
+
+   /* Check with the blocking interface */
+   for (v = 0; v < NVARS; v++)
+   {
+      size_t all[2] = {NREC, NX};
+      float vdata[NREC][NX];
+      start[0] = 0;
+      if (nc_get_vara_float(ncid, varids[v], start, all, &vdata[0][0])) ERR;
+      if (memcmp(vdata, data[v], sizeof(vdata))) ERR;
+   }
+   if (nc_get_var_int(ncid, bigvar, bigback)) ERR;
+   if (memcmp(big, bigback, NBIG * sizeof(int))) ERR;
+   if (nc_get_var_double(ncid, scalar, &dscalar)) ERR;
+   if (dscalar != 3.25) ERR;
+
+   /* Reads, including one past the last record and an unknown id */
+   memset(back, 0, sizeof(back));
+   nreqs = 0;
+   for (v = 0; v < NVARS; v++)
+      for (rec = 0; rec < NREC; rec += 2)
+      {
+         start[0] = rec;
+         if (nc_iget_vara_float(ncid, varids[v], start, count, back[v][rec],
+                                &reqids[nreqs++])) ERR;
+      }
+   start[0] = NREC;
+   if (nc_iget_vara_float(ncid, varids[0], start, count, back[0][1], &reqids[nreqs++])) ERR;
+   reqids[nreqs++] = 12345;
+   if (nc_wait_all(ncid, nreqs, reqids, statuses) == NC_NOERR) ERR;
+   for (i = 0; i < (size_t)nreqs - 2; i++)
+      if (statuses[i] != NC_NOERR) ERR;
+   if (statuses[nreqs - 2] != NC_EEDGE && statuses[nreqs - 2] != NC_EINVALCOORDS) ERR;
+   if (statuses[nreqs - 1] != NC_EINVAL) ERR;
+   for (v = 0; v < NVARS; v++)
+      for (rec = 0; rec < NREC; rec += 2)
+         if (memcmp(back[v][rec], data[v][rec], sizeof(back[v][rec]))) ERR;
+
+   /* Reads with conversion, all completed at once */
+   {
+      double dback[NX];
+      int iback[NX];
+      start[0] = 5;
+      if (nc_iget_vara_double(ncid, varids[3], start, count, dback, NULL)) ERR;
+      if (nc_iget_vara_int(ncid, varids[4], start, count, iback, NULL)) ERR;
+      if (nc_iget_vara_text(ncid, varids[4], start, count, (char*)iback, &reqids[0])) ERR;
+      if (nc_wait_all(ncid, 1, reqids, statuses) != NC_ECHAR) ERR;
+      if (nc_wait_all(ncid, NC_REQ_ALL, NULL, NULL)) ERR;
+      for (x = 0; x < NX; x++)
+         if (dback[x] != value(3, 5, x) || iback[x] != (int)value(4, 5, x)) ERR;
+   }
+
+   /* Requests still pending at close are completed */
+   for (x = 0; x < NX; x++)
+      data[1][NREC - 1][x] = -1.0f;
+   start[0] = NREC - 1;
+   if (nc_iput_vara_float(ncid, varids[1], start, count, data[1][NREC - 1], NULL)) ERR;
+   if (nc_close(ncid)) ERR;
+
+   if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+   start[0] = NREC - 1;
+   if (nc_iget_vara_float(ncid, varids[1], start, count, back[1][0], NULL)) ERR;
+   if (nc_iput_vara_float(ncid, varids[1], start, count, data[1][0], &reqids[0])) ERR;
+   /* NC_EPERM for netCDF-3; HDF5 reports its own error */
+   if (nc_wait_all(ncid, 1, reqids, statuses) == NC_NOERR) ERR;
+   if (statuses[0] == NC_NOERR) ERR;
+   if (nc_wait_all(ncid, NC_REQ_ALL, NULL, NULL)) ERR;
+   if (memcmp(back[1][0], data[1][NREC - 1], sizeof(back[1][0]))) ERR;
+   /* ... and discarded by an abort */
+   if (nc_iget_vara_float(ncid, varids[1], start, count, back[1][0], NULL)) ERR;
+   if (nc_abort(ncid)) ERR;
+
+   free(big);
+   free(bigback);
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   printf("\n*** Testing nonblocking reads and writes.\n");
+   printf("*** testing classic file...");
+   if (test_format(NC_CLOBBER)) ERR;
+   SUMMARIZE_ERR;
+   printf("*** testing 64-bit offset file...");
+   if (test_format(NC_CLOBBER|NC_64BIT_OFFSET)) ERR;
+   SUMMARIZE_ERR;
+#ifdef NETCDF_ENABLE_CDF5
+   printf("*** testing CDF5 file...");
+   if (test_format(NC_CLOBBER|NC_64BIT_DATA)) ERR;
+   SUMMARIZE_ERR;
+#endif
+#ifdef USE_HDF5
+   printf("*** testing netCDF-4 file...");
+   if (test_format(NC_CLOBBER|NC_NETCDF4)) ERR;
+   SUMMARIZE_ERR;
+#endif
+   FINAL_RESULTS;
+}
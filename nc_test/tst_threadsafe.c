@@ -0,0 +1,220 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Stress test of the thread-safe library (NETCDF_ENABLE_THREADSAFE).
+   - N threads each create, write, reopen and read back their own
+     file, so that file creation, the file list and the data path
+     of independent ncids are all exercised concurrently;
+   - N threads read disjoint records of the same open file.
+   Each phase is run with 1 and with N threads, and the speedup is
+   reported; only the data is checked, since the speedup depends on
+   the machine.
+
+   Usage: tst_threadsafe [nthreads]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define DFALTTHREADS 4
+#define MAXTHREADS 64
+#define NREC 64
+#define NX 1024
+#define NREADS 8 /* times each file is read back */
+#define VAR "v"
+
+typedef struct Task {
+   int id;
+   const char* format; /* printf format of the file name */
+   int cmode;
+   int ncid; /* shared file; -1 => each task has its own file */
+   int nerrs;
+} Task;
+
+static float
+value(int id, size_t rec, size_t x)
+{
+   return (float)(id * 100000 + (int)(rec * NX + x) % 100000);
+}
+
+static double
+elapsed(struct timeval* t0)
+{
+   struct timeval t1;
+   gettimeofday(&t1, NULL);
+   return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_usec - t0->tv_usec) / 1e6;
+}
+
+/* Check record rec of a variable written for task id */
+static int
+checkrec(int ncid, int varid, int id, size_t rec, float* data)
+{
+   size_t start[2] = {0, 0}, count[2] = {1, NX}, x;
+   start[0] = rec;
+   if (nc_get_vara_float(ncid, varid, start, count, data)) return 1;
+   for (x = 0; x < NX; x++)
+      if (data[x] != value(id, rec, x)) return 1;
+   return 0;
+}
+
+/* Write a whole file, then read it back NREADS times */
+static void*
+ownfile(void* arg)
+{
+   Task* task = (Task*)arg;
+   char path[4096];
+   int ncid, varid, dimids[2], i;
+   size_t start[2] = {0, 0}, count[2] = {1, NX}, rec, x;
+   float* data = NULL;
+
+   snprintf(path, sizeof(path), task->format, task->id);
+   if ((data = malloc(NX * sizeof(float))) == NULL) goto fail;
+   if (nc_create(path, task->cmode, &ncid)) goto fail;
+   if (nc_def_dim(ncid, "rec", NREC, &dimids[0])) goto fail;
+   if (nc_def_dim(ncid, "x", NX, &dimids[1])) goto fail;
+   if (nc_def_var(ncid, VAR, NC_FLOAT, 2, dimids, &varid)) goto fail;
+   if (nc_enddef(ncid)) goto fail;
+   for (rec = 0; rec < NREC; rec++)
+   {
+      for (x = 0; x < NX; x++)
+         data[x] = value(task->id, rec, x);
+      start[0] = rec;
+      if (nc_put_vara_float(ncid, varid, start, count, data)) goto fail;
+   }
+   if (nc_close(ncid)) goto fail;
+
+   if (nc_open(path, NC_NOWRITE, &ncid)) goto fail;
+   if (nc_inq_varid(ncid, VAR, &varid)) goto fail;
+   for (i = 0; i < NREADS; i++)
+      for (rec = 0; rec < NREC; rec++)
+         if (checkrec(ncid, varid, task->id, rec, data)) goto fail;
+   if (nc_close(ncid)) goto fail;
+   free(data);
+   return NULL;
+fail:
+   free(data);
+   task->nerrs++;
+   return NULL;
+}
+
+/* Read every nthreads'th record of a shared file */
+typedef struct Shared {
+   Task task;
+   int nthreads;
+} Shared;
+
+static void*
+sharedfile(void* arg)
+{
+   Shared* shared = (Shared*)arg;
+   Task* task = &shared->task;
+   int varid, i;
+   size_t rec;
+   float* data = NULL;
+
+   if ((data = malloc(NX * sizeof(float))) == NULL) goto fail;
+   if (nc_inq_varid(task->ncid, VAR, &varid)) goto fail;
+   for (i = 0; i < NREADS * shared->nthreads; i++)
+      for (rec = (size_t)task->id; rec < NREC; rec += (size_t)shared->nthreads)
+         if (checkrec(task->ncid, varid, 0, rec, data)) goto fail;
+   free(data);
+   return NULL;
+fail:
+   free(data);
+   task->nerrs++;
+   return NULL;
+}
+
+/* Run nthreads tasks; return the elapsed time, or -1 on error */
+static double
+run(int nthreads, const char* format, int cmode, int ncid)
+{
+   pthread_t threads[MAXTHREADS];
+   Shared tasks[MAXTHREADS];
+   struct timeval t0;
+   int i, nerrs = 0;
+
+   gettimeofday(&t0, NULL);
+   for (i = 0; i < nthreads; i++)
+   {
+      tasks[i].task.id = i;
+      tasks[i].task.format = format;
+      tasks[i].task.cmode = cmode;
+      tasks[i].task.ncid = ncid;
+      tasks[i].task.nerrs = 0;
+      tasks[i].nthreads = nthreads;
+      if (pthread_create(&threads[i], NULL, (ncid < 0 ? ownfile : sharedfile), &tasks[i]))
+         return -1;
+   }
+   for (i = 0; i < nthreads; i++)
+   {
+      pthread_join(threads[i], NULL);
+      nerrs += tasks[i].task.nerrs;
+   }
+   return (nerrs ? -1 : elapsed(&t0));
+}
+
+/* One file per thread, then all threads on one file */
+static int
+stress(int nthreads, const char* format, int cmode)
+{
+   double t1, tn;
+   int ncid;
+
+   /* Every thread does the work of the single thread, so with
+    * perfect scaling the speedup is the number of threads. On a
+    * shared file, the calls are serialized on the file lock. */
+   if ((t1 = run(1, format, cmode, -1)) < 0) ERR;
+   if ((tn = run(nthreads, format, cmode, -1)) < 0) ERR;
+   printf("\n      %d files: 1 thread %.3f s, %d threads %.3f s, speedup %.2f",
+          nthreads, t1 * nthreads, nthreads, tn, (t1 * nthreads) / tn);
+
+   {
+      char path[4096];
+      snprintf(path, sizeof(path), format, 0);
+      if (nc_open(path, NC_NOWRITE, &ncid)) ERR;
+   }
+   if ((t1 = run(1, format, cmode, ncid)) < 0) ERR;
+   if ((tn = run(nthreads, format, cmode, ncid)) < 0) ERR;
+   if (nc_close(ncid)) ERR;
+   printf("\n      1 file: 1 thread %.3f s, %d threads %.3f s, speedup %.2f...",
+          t1 * nthreads, nthreads, tn, (t1 * nthreads) / tn);
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   int nthreads = DFALTTHREADS;
+
+   if (argc > 1)
+      nthreads = atoi(argv[1]);
+   if (nthreads < 1 || nthreads > MAXTHREADS) nthreads = DFALTTHREADS;
+
+   printf("\n*** Testing concurrent use of the library from %d threads.\n", nthreads);
+   printf("*** testing classic files...");
+   if (stress(nthreads, "tmp_threadsafe_%d.nc", NC_CLOBBER)) ERR;
+   SUMMARIZE_ERR;
+   printf("*** testing 64-bit offset files...");
+   if (stress(nthreads, "tmp_threadsafe_%d.nc", NC_CLOBBER|NC_64BIT_OFFSET)) ERR;
+   SUMMARIZE_ERR;
+   /* The other formats are serialized on the global lock, but must
+      still be correct */
+#ifdef NETCDF_ENABLE_NCZARR
+   printf("*** testing NCZarr files...");
+   if (stress(nthreads, "file://tmp_threadsafe_%d.file#mode=nczarr,file", NC_CLOBBER|NC_NETCDF4)) ERR;
+   SUMMARIZE_ERR;
+#endif
+#ifdef USE_HDF5
+   printf("*** testing netCDF-4 files...");
+   if (stress(nthreads, "tmp_threadsafe_%d.nc", NC_CLOBBER|NC_NETCDF4)) ERR;
+   SUMMARIZE_ERR;
+#endif
+   FINAL_RESULTS;
+}
@@ -0,0 +1,234 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test the io_uring I/O layer (NC_URING). Files are written and
+   read with NC_URING and checked with the default I/O layer, and
+   vice versa. A small block size and cache are used, so that
+   regions span blocks, blocks are evicted while dirty and the
+   readahead window wraps the cache; the header is then grown so
+   that the data must be moved. The same is repeated with O_DIRECT
+   where the file system allows it. Finally the time to read a
+   file sequentially is reported for both layers; only the data is
+   checked, since the times depend on the machine.
+*/
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define FILE_NAME "tst_uring.nc"
+#define NREC 50
+#define NX 1000
+#define NFIX 100000
+#define NBIGREC 256
+#define NBIGX (64 * 1024)
+
+static float
+value(int v, size_t rec, size_t x)
+{
+   return (float)(v * 1000000 + (int)(rec * NX + x));
+}
+
+static double
+elapsed(struct timeval* t0)
+{
+   struct timeval t1;
+   gettimeofday(&t1, NULL);
+   return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_usec - t0->tv_usec) / 1e6;
+}
+
+/* Check every value in the file */
+static int
+check(int omode)
+{
+   int ncid, varid, fixid;
+   size_t start[2] = {0, 0}, count[2] = {1, NX}, rec, x;
+   static float data[NX];
+   static int fix[NFIX];
+   char att[8];
+
+   if (nc_open(FILE_NAME, omode, &ncid)) ERR;
+   if (nc_inq_varid(ncid, "fix", &fixid)) ERR;
+   if (nc_get_var_int(ncid, fixid, fix)) ERR;
+   for (x = 0; x < NFIX; x++)
+      if (fix[x] != (x % 7 == 0 ? -(int)x : (int)x)) ERR;
+   /* Backwards, to defeat the readahead */
+   if (nc_inq_varid(ncid, "r1", &varid)) ERR;
+   for (rec = NREC; rec-- > 0;)
+   {
+      start[0] = rec;
+      if (nc_get_vara_float(ncid, varid, start, count, data)) ERR;
+      for (x = 0; x < NX; x++)
+         if (data[x] != value(1, rec, x)) ERR;
+   }
+   if (nc_inq_varid(ncid, "r0", &varid)) ERR;
+   for (rec = 0; rec < NREC; rec++)
+   {
+      start[0] = rec;
+      if (nc_get_vara_float(ncid, varid, start, count, data)) ERR;
+      for (x = 0; x < NX; x++)
+         if (data[x] != value(0, rec, x)) ERR;
+   }
+   if (nc_get_att_text(ncid, NC_GLOBAL, "tag", att)) ERR;
+   if (memcmp(att, "uring", 5)) ERR;
+   if (nc_close(ncid)) ERR;
+   return 0;
+}
+
+/* Write a file with cmode, check it with omode, grow its header */
+static int
+test_format(int cmode, int omode)
+{
+   int ncid, dimids[2], fixdim, varids[2], fixid, v;
+   size_t start[2] = {0, 0}, count[2] = {1, NX}, rec, x;
+   static float data[NX];
+   static int fix[NFIX];
+   char* big = NULL;
+
+   if (nc_create(FILE_NAME, cmode, &ncid)) ERR;
+   if (nc_def_dim(ncid, "rec", NC_UNLIMITED, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "x", NX, &dimids[1])) ERR;
+   if (nc_def_dim(ncid, "fix", NFIX, &fixdim)) ERR;
+   if (nc_def_var(ncid, "fix", NC_INT, 1, &fixdim, &fixid)) ERR;
+   if (nc_def_var(ncid, "r0", NC_FLOAT, 2, dimids, &varids[0])) ERR;
+   if (nc_def_var(ncid, "r1", NC_FLOAT, 2, dimids, &varids[1])) ERR;
+   if (nc_put_att_text(ncid, NC_GLOBAL, "tag", 5, "uring")) ERR;
+   if (nc_enddef(ncid)) ERR;
+
+   /* Sequential, then overwrite every 7th value out of order */
+   for (x = 0; x < NFIX; x++)
+      fix[x] = (int)x;
+   if (nc_put_var_int(ncid, fixid, fix)) ERR;
+   for (x = NFIX; x-- > 0;)
+      if (x % 7 == 0)
+      {
+         int neg = -(int)x;
+         if (nc_put_var1_int(ncid, fixid, &x, &neg)) ERR;
+      }
+   for (rec = 0; rec < NREC; rec++)
+      for (v = 0; v < 2; v++)
+      {
+         for (x = 0; x < NX; x++)
+            data[x] = value(v, rec, x);
+         start[0] = rec;
+         if (nc_put_vara_float(ncid, varids[v], start, count, data)) ERR;
+      }
+   /* Read back through the cache before the file is closed */
+   start[0] = NREC / 2;
+   if (nc_get_vara_float(ncid, varids[1], start, count, data)) ERR;
+   for (x = 0; x < NX; x++)
+      if (data[x] != value(1, NREC / 2, x)) ERR;
+   if (nc_close(ncid)) ERR;
+   if (check(omode)) ERR;
+
+   /* Grow the header, so that all the data moves */
+   if (!(big = calloc(1, 100000))) ERR;
+   if (nc_open(FILE_NAME, omode|NC_WRITE, &ncid)) ERR;
+   if (nc_redef(ncid)) ERR;
+   if (nc_put_att_text(ncid, NC_GLOBAL, "big", 100000, big)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   if (nc_close(ncid)) ERR;
+   free(big);
+   if (check(omode)) ERR;
+   if (check(omode ^ NC_URING)) ERR;
+   return 0;
+}
+
+static int
+test_formats(void)
+{
+   printf("\n      classic...");
+   if (test_format(NC_CLOBBER|NC_URING, NC_NOWRITE)) ERR;
+   if (test_format(NC_CLOBBER, NC_NOWRITE|NC_URING)) ERR;
+   printf("64-bit offset...");
+   if (test_format(NC_CLOBBER|NC_64BIT_OFFSET|NC_URING, NC_NOWRITE)) ERR;
+#ifdef NETCDF_ENABLE_CDF5
+   printf("CDF5...");
+   if (test_format(NC_CLOBBER|NC_64BIT_DATA|NC_URING, NC_NOWRITE|NC_URING)) ERR;
+#endif
+   return 0;
+}
+
+/* Time a sequential read of a large variable */
+static double
+timeread(int omode, float* data)
+{
+   int ncid, varid;
+   size_t start[2] = {0, 0}, count[2] = {1, NBIGX}, rec;
+   struct timeval t0;
+
+   gettimeofday(&t0, NULL);
+   if (nc_open(FILE_NAME, omode, &ncid)) return -1;
+   if (nc_inq_varid(ncid, "v", &varid)) return -1;
+   for (rec = 0; rec < NBIGREC; rec++)
+   {
+      start[0] = rec;
+      if (nc_get_vara_float(ncid, varid, start, count, data)) return -1;
+      if (data[NBIGX - 1] != (float)rec) return -1;
+   }
+   if (nc_close(ncid)) return -1;
+   return elapsed(&t0);
+}
+
+static int
+test_timing(void)
+{
+   int ncid, dimids[2], varid;
+   size_t start[2] = {0, 0}, count[2] = {1, NBIGX}, rec, x;
+   float* data = NULL;
+   double tposix, turing;
+
+   if (!(data = malloc(NBIGX * sizeof(float)))) ERR;
+   if (nc_create(FILE_NAME, NC_CLOBBER|NC_64BIT_OFFSET|NC_URING, &ncid)) ERR;
+   if (nc_def_dim(ncid, "rec", NBIGREC, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "x", NBIGX, &dimids[1])) ERR;
+   if (nc_def_var(ncid, "v", NC_FLOAT, 2, dimids, &varid)) ERR;
+   if (nc_set_fill(ncid, NC_NOFILL, NULL)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   for (rec = 0; rec < NBIGREC; rec++)
+   {
+      for (x = 0; x < NBIGX; x++)
+         data[x] = (float)rec;
+      start[0] = rec;
+      if (nc_put_vara_float(ncid, varid, start, count, data)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   if ((tposix = timeread(NC_NOWRITE, data)) < 0) ERR;
+   if ((turing = timeread(NC_NOWRITE|NC_URING, data)) < 0) ERR;
+   printf("\n      %d MB: posixio %.3f s, io_uring %.3f s...",
+          (int)((NBIGREC * NBIGX * sizeof(float)) >> 20), tposix, turing);
+   free(data);
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   printf("\n*** Testing the io_uring I/O layer.\n");
+   /* Small blocks, so that every path through the cache is taken */
+   setenv("NETCDF_URING_BLOCKSIZE", "8192", 1);
+   setenv("NETCDF_URING_CACHEBLOCKS", "8", 1);
+   printf("*** testing small cache...");
+   if (test_formats()) ERR;
+   SUMMARIZE_ERR;
+   printf("*** testing O_DIRECT...");
+   setenv("NETCDF_URING_DIRECT", "1", 1);
+   if (test_formats()) ERR;
+   unsetenv("NETCDF_URING_DIRECT");
+   SUMMARIZE_ERR;
+   printf("*** testing default cache...");
+   unsetenv("NETCDF_URING_BLOCKSIZE");
+   unsetenv("NETCDF_URING_CACHEBLOCKS");
+   if (test_formats()) ERR;
+   SUMMARIZE_ERR;
+   printf("*** testing sequential read...");
+   if (test_timing()) ERR;
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
@@ -0,0 +1,430 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test raw chunk access: nc_get_chunk_raw(), nc_put_chunk_raw() and
+   nc_copy_var_raw(). A compressed variable with an unlimited
+   dimension, partial edge chunks and chunks that were never written
+   is copied by chunk to a variable defined with the same storage in a
+   new file, which must read back the same values. nc_copy_var() must
+   copy the values but leave the new variable with the default
+   storage. This is done for netCDF-4/HDF5 files and, when it is
+   built, for NCZarr. With an HDF5 older than 1.10.3, which cannot
+   access chunks raw, nc_copy_var() must still copy the HDF5 variable,
+   by value.
+   Finally the time to copy a compressed variable by value and by
+   chunk is reported; only the data is checked, since the times depend
+   on the machine.
+*/
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "netcdf.h"
+#include "netcdf_filter.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define NDIMS 3
+#define NREC 7
+#define NY 40
+#define NX 30
+#define FILLVALUE 7.5f
+#define NBIGREC 64
+#define NBIGY 256
+#define NBIGX 256
+
+static const size_t chunksizes[NDIMS] = {3, 16, 25};
+
+/* NCZarr needs the filter plugins to compress; without them its
+   chunks are stored as they are. */
+static int compress;
+
+static float
+value(size_t rec, size_t y, size_t x)
+{
+   return (float)(rec * 10000 + y * 100 + x) / 4.0f;
+}
+
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+static double
+elapsed(struct timeval* t0)
+{
+   struct timeval t1;
+   gettimeofday(&t1, NULL);
+   return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_usec - t0->tv_usec) / 1e6;
+}
+#endif
+
+/* Define the dimensions rec (unlimited), y and x */
+static int
+defdims(int ncid, int *dimids)
+{
+   if (nc_def_dim(ncid, "rec", NC_UNLIMITED, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "y", NY, &dimids[1])) ERR;
+   if (nc_def_dim(ncid, "x", NX, &dimids[2])) ERR;
+   return 0;
+}
+
+/* A compressed variable; the rows y >= NY/2 of the records < 3 are
+   never written, so that some chunks are not stored. */
+static int
+create_input(const char *path)
+{
+   int ncid, varid, plainid, dimids[NDIMS];
+   size_t start[NDIMS] = {0, 0, 0}, count[NDIMS] = {1, NY, NX};
+   size_t rec, y, x;
+   float fill = FILLVALUE;
+   static float data[NY][NX];
+
+   if (nc_create(path, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   if (defdims(ncid, dimids)) ERR;
+   if (nc_def_var(ncid, "v", NC_FLOAT, NDIMS, dimids, &varid)) ERR;
+   if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunksizes)) ERR;
+   if (compress && nc_def_var_deflate(ncid, varid, 1, 1, 4)) ERR;
+   if (nc_def_var_fill(ncid, varid, NC_FILL, &fill)) ERR;
+   if (nc_put_att_text(ncid, varid, "units", 1, "K")) ERR;
+   /* Contiguous, so copied by value */
+   if (nc_def_var(ncid, "plain", NC_INT, 1, &dimids[2], &plainid)) ERR;
+   if (nc_def_var_chunking(ncid, plainid, NC_CONTIGUOUS, NULL)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   for (rec = 0; rec < NREC; rec++)
+   {
+      for (y = 0; y < NY; y++)
+         for (x = 0; x < NX; x++)
+            data[y][x] = value(rec, y, x);
+      start[0] = rec;
+      count[1] = (rec < 3 ? NY / 2 : NY);
+      if (nc_put_vara_float(ncid, varid, start, count, &data[0][0])) ERR;
+   }
+   {
+      int plain[NX];
+      for (x = 0; x < NX; x++)
+         plain[x] = (int)x * 3;
+      if (nc_put_var_int(ncid, plainid, plain)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   return 0;
+}
+
+/* The values of v in the two files must be equal, and so must their
+   storage if samestorage is set; otherwise the second must have no
+   filters. */
+static int
+compare(const char *path1, const char *path2, int samestorage)
+{
+   int ncid1, ncid2, varid1, varid2, storage;
+   size_t nrec, n, i, sizes[NDIMS], nfilters;
+   int deflate, level, shuffle;
+   float *data1, *data2;
+
+   if (nc_open(path1, NC_NOWRITE, &ncid1)) ERR;
+   if (nc_open(path2, NC_NOWRITE, &ncid2)) ERR;
+   if (nc_inq_dimlen(ncid2, 0, &nrec)) ERR;
+   if (nrec != NREC) ERR;
+   if (nc_inq_varid(ncid1, "v", &varid1)) ERR;
+   if (nc_inq_varid(ncid2, "v", &varid2)) ERR;
+   if (nc_inq_var_chunking(ncid2, varid2, &storage, sizes)) ERR;
+   if (samestorage &&
+       (storage != NC_CHUNKED || memcmp(sizes, chunksizes, sizeof(sizes)))) ERR;
+   if (nc_inq_var_filter_ids(ncid2, varid2, &nfilters, NULL)) ERR;
+   if (nfilters != (samestorage && compress ? 2 : 0)) ERR;
+   if (samestorage && compress)
+   {
+      if (nc_inq_var_deflate(ncid2, varid2, &shuffle, &deflate, &level)) ERR;
+      if (!shuffle || !deflate || level != 4) ERR;
+   }
+   n = NREC * NY * NX;
+   if (!(data1 = malloc(n * sizeof(float)))) ERR;
+   if (!(data2 = malloc(n * sizeof(float)))) ERR;
+   if (nc_get_var_float(ncid1, varid1, data1)) ERR;
+   if (nc_get_var_float(ncid2, varid2, data2)) ERR;
+   for (i = 0; i < n; i++)
+   {
+      size_t rec = i / (NY * NX), y = (i / NX) % NY, x = i % NX;
+      float expected = (rec < 3 && y >= NY / 2 ? FILLVALUE : value(rec, y, x));
+      if (data1[i] != expected || data2[i] != expected) ERR;
+   }
+   free(data1);
+   free(data2);
+   if (nc_close(ncid1)) ERR;
+   if (nc_close(ncid2)) ERR;
+   return 0;
+}
+
+/* The raw chunk functions themselves */
+static int
+test_api(const char *in, const char *out)
+{
+   int ncid, ncid2, varid, varid2, plainid, storage, dimids[NDIMS];
+   size_t start[NDIMS] = {3, 16, 25}, size, size2;
+   size_t bad[NDIMS] = {3, 16, 24}, empty[NDIMS] = {0, 32, 0};
+   size_t coord[NDIMS] = {4, 17, 26};
+   unsigned int mask = 1;
+   void *chunk = NULL, *chunk2 = NULL;
+   float f;
+
+   if (create_input(in)) ERR;
+   if (nc_open(in, NC_NOWRITE, &ncid)) ERR;
+   if (nc_inq_varid(ncid, "v", &varid)) ERR;
+   if (nc_inq_varid(ncid, "plain", &plainid)) ERR;
+   if (nc_get_chunk_raw(ncid, varid, bad, NULL, &size, NULL) != NC_EINVALCOORDS) ERR;
+   if (nc_get_chunk_raw(ncid, varid, empty, NULL, &size, NULL) != NC_EEMPTY) ERR;
+   /* NCZarr chunks every variable */
+   if (nc_inq_var_chunking(ncid, plainid, &storage, NULL)) ERR;
+   if (storage == NC_CONTIGUOUS &&
+       nc_get_chunk_raw(ncid, plainid, start, NULL, &size, NULL) != NC_EINVAL) ERR;
+   if (nc_get_chunk_raw(ncid, varid, start, NULL, &size, NULL)) ERR;
+   if (compress && (size == 0 || size >= 3 * 16 * 25 * sizeof(float))) ERR;
+   if (!compress && size != 3 * 16 * 25 * sizeof(float)) ERR;
+   if (!(chunk = malloc(size))) ERR;
+   if (nc_get_chunk_raw(ncid, varid, start, &mask, &size2, chunk)) ERR;
+   if (size2 != size || mask != 0) ERR;
+
+   /* Write it to the chunk at the same place of an empty variable */
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (defdims(ncid2, dimids)) ERR;
+   if (nc_def_var(ncid2, "v", NC_FLOAT, NDIMS, dimids, &varid2)) ERR;
+   if (nc_def_var_chunking(ncid2, varid2, NC_CHUNKED, chunksizes)) ERR;
+   if (compress && nc_def_var_deflate(ncid2, varid2, 1, 1, 4)) ERR;
+   if (nc_enddef(ncid2)) ERR;
+   /* Beyond the current length of rec */
+   if (nc_put_chunk_raw(ncid2, varid2, start, 0, size, chunk) != NC_EINVALCOORDS) ERR;
+   f = 1.0f;
+   if (nc_put_var1_float(ncid2, varid2, coord, &f)) ERR;
+   if (nc_put_chunk_raw(ncid2, varid2, start, 0, size, chunk)) ERR;
+   /* The cached chunk holding f was replaced */
+   if (nc_get_var1_float(ncid2, varid2, coord, &f)) ERR;
+   if (f != value(4, 17, 26)) ERR;
+   if (nc_get_chunk_raw(ncid2, varid2, start, NULL, &size2, NULL)) ERR;
+   if (size2 != size) ERR;
+   if (!(chunk2 = malloc(size))) ERR;
+   if (nc_get_chunk_raw(ncid2, varid2, start, NULL, &size2, chunk2)) ERR;
+   if (memcmp(chunk, chunk2, size)) ERR;
+   if (nc_close(ncid2)) ERR;
+   if (nc_put_chunk_raw(ncid, varid, start, 0, size, chunk) != NC_EPERM) ERR;
+   if (nc_close(ncid)) ERR;
+   free(chunk);
+   free(chunk2);
+
+   /* Classic files have no chunks */
+   if (nc_create("tst_chunks_raw_classic.nc", NC_CLOBBER, &ncid2)) ERR;
+   if (defdims(ncid2, dimids)) ERR;
+   if (nc_def_var(ncid2, "v", NC_FLOAT, NDIMS, dimids, &varid2)) ERR;
+   if (nc_enddef(ncid2)) ERR;
+   if (nc_get_chunk_raw(ncid2, varid2, empty, NULL, &size, NULL) != NC_ENOTNC4) ERR;
+   if (nc_close(ncid2)) ERR;
+   return 0;
+}
+
+/* Define v in the output with the storage of the input */
+static int
+defsame(int ncid, const int *dimids, int *varidp)
+{
+   float fill = FILLVALUE;
+   if (nc_def_var(ncid, "v", NC_FLOAT, NDIMS, dimids, varidp)) ERR;
+   if (nc_def_var_chunking(ncid, *varidp, NC_CHUNKED, chunksizes)) ERR;
+   if (compress && nc_def_var_deflate(ncid, *varidp, 1, 1, 4)) ERR;
+   if (nc_def_var_fill(ncid, *varidp, NC_FILL, &fill)) ERR;
+   return 0;
+}
+
+/* Copy with nc_copy_var_raw() to a variable stored alike, and with
+   nc_copy_var(), which keeps the default storage, then check that
+   nc_copy_var_raw() refuses variables stored differently. */
+static int
+test_copy(const char *in, const char *out)
+{
+   int ncid, ncid2, varid, varid2, dimids[NDIMS];
+   size_t other[NDIMS] = {1, NY, NX}, nrec;
+
+   if (create_input(in)) ERR;
+   if (nc_open(in, NC_NOWRITE, &ncid)) ERR;
+   if (nc_inq_varid(ncid, "v", &varid)) ERR;
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (defdims(ncid2, dimids)) ERR;
+   if (defsame(ncid2, dimids, &varid2)) ERR;
+   if (nc_enddef(ncid2)) ERR;
+   if (nc_copy_var_raw(ncid, varid, ncid2, varid2)) ERR;
+   if (nc_close(ncid2)) ERR;
+   if (compare(in, out, 1)) ERR;
+
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (defdims(ncid2, dimids)) ERR;
+   if (nc_copy_var(ncid, 0, ncid2)) ERR;
+   if (nc_copy_var(ncid, 1, ncid2)) ERR;
+   if (nc_close(ncid2)) ERR;
+   if (compare(in, out, 0)) ERR;
+
+   /* Different chunks: nothing is written */
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (defdims(ncid2, dimids)) ERR;
+   if (nc_def_var(ncid2, "v", NC_FLOAT, NDIMS, dimids, &varid2)) ERR;
+   if (nc_def_var_chunking(ncid2, varid2, NC_CHUNKED, other)) ERR;
+   if (compress && nc_def_var_deflate(ncid2, varid2, 1, 1, 4)) ERR;
+   if (nc_enddef(ncid2)) ERR;
+   if (nc_inq_varid(ncid, "v", &varid)) ERR;
+   if (nc_copy_var_raw(ncid, varid, ncid2, varid2) != NC_EINVAL) ERR;
+   if (nc_inq_dimlen(ncid2, dimids[0], &nrec)) ERR;
+   if (nrec != 0) ERR;
+   if (nc_close(ncid2)) ERR;
+   if (nc_close(ncid)) ERR;
+   return 0;
+}
+
+/* With an HDF5 that cannot access chunks raw, nc_copy_var_raw()
+   refuses even variables stored in the same way, and nc_copy_var()
+   copies their values instead. */
+static int
+test_fallback(const char *in, const char *out)
+{
+   int ncid, ncid2, varid, stat, dimids[NDIMS];
+   size_t start[NDIMS] = {3, 16, 25}, size;
+
+   if (create_input(in)) ERR;
+   if (nc_open(in, NC_NOWRITE, &ncid)) ERR;
+   if (nc_inq_varid(ncid, "v", &varid)) ERR;
+   stat = nc_get_chunk_raw(ncid, varid, start, NULL, &size, NULL);
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+   if (stat != NC_NOERR) ERR;
+#else
+   if (stat != NC_ENOTBUILT) ERR;
+   {
+      int varid2;
+      size_t nrec;
+
+      /* Stored in the same way: nothing is written */
+      if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+      if (defdims(ncid2, dimids)) ERR;
+      if (defsame(ncid2, dimids, &varid2)) ERR;
+      if (nc_enddef(ncid2)) ERR;
+      if (nc_copy_var_raw(ncid, varid, ncid2, varid2) != NC_EINVAL) ERR;
+      if (nc_inq_dimlen(ncid2, dimids[0], &nrec)) ERR;
+      if (nrec != 0) ERR;
+      if (nc_close(ncid2)) ERR;
+   }
+#endif
+   /* Either way nc_copy_var() copies the data */
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (defdims(ncid2, dimids)) ERR;
+   if (nc_copy_var(ncid, varid, ncid2)) ERR;
+   if (nc_close(ncid2)) ERR;
+   if (nc_close(ncid)) ERR;
+   if (compare(in, out, 0)) ERR;
+   return 0;
+}
+
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+/* Copy a compressed variable by value and by chunk */
+static int
+test_timing(const char *in, const char *out)
+{
+   int ncid, ncid2, varid, varid2, dimids[NDIMS];
+   size_t start[NDIMS] = {0, 0, 0}, count[NDIMS] = {1, NBIGY, NBIGX};
+   size_t chunks[NDIMS] = {1, NBIGY, NBIGX}, rec, i;
+   float *data;
+   struct timeval t0;
+   double tvalue, traw;
+
+   if (!(data = malloc(NBIGY * NBIGX * sizeof(float)))) ERR;
+   if (nc_create(in, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   if (nc_def_dim(ncid, "rec", NBIGREC, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "y", NBIGY, &dimids[1])) ERR;
+   if (nc_def_dim(ncid, "x", NBIGX, &dimids[2])) ERR;
+   if (nc_def_var(ncid, "v", NC_FLOAT, NDIMS, dimids, &varid)) ERR;
+   if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks)) ERR;
+   if (nc_def_var_deflate(ncid, varid, 1, 1, 6)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   for (rec = 0; rec < NBIGREC; rec++)
+   {
+      for (i = 0; i < NBIGY * NBIGX; i++)
+         data[i] = (float)((rec * 7 + i) % 1000) / 8.0f;
+      start[0] = rec;
+      if (nc_put_vara_float(ncid, varid, start, count, data)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+
+   if (nc_open(in, NC_NOWRITE, &ncid)) ERR;
+   /* By value */
+   gettimeofday(&t0, NULL);
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (nc_def_dim(ncid2, "rec", NBIGREC, &dimids[0])) ERR;
+   if (nc_def_dim(ncid2, "y", NBIGY, &dimids[1])) ERR;
+   if (nc_def_dim(ncid2, "x", NBIGX, &dimids[2])) ERR;
+   if (nc_def_var(ncid2, "v", NC_FLOAT, NDIMS, dimids, &varid2)) ERR;
+   if (nc_def_var_chunking(ncid2, varid2, NC_CHUNKED, chunks)) ERR;
+   if (nc_def_var_deflate(ncid2, varid2, 1, 1, 6)) ERR;
+   if (nc_enddef(ncid2)) ERR;
+   for (rec = 0; rec < NBIGREC; rec++)
+   {
+      start[0] = rec;
+      if (nc_get_vara_float(ncid, varid, start, count, data)) ERR;
+      if (nc_put_vara_float(ncid2, varid2, start, count, data)) ERR;
+   }
+   if (nc_close(ncid2)) ERR;
+   tvalue = elapsed(&t0);
+   /* By chunk */
+   gettimeofday(&t0, NULL);
+   if (nc_create(out, NC_CLOBBER|NC_NETCDF4, &ncid2)) ERR;
+   if (nc_def_dim(ncid2, "rec", NBIGREC, &dimids[0])) ERR;
+   if (nc_def_dim(ncid2, "y", NBIGY, &dimids[1])) ERR;
+   if (nc_def_dim(ncid2, "x", NBIGX, &dimids[2])) ERR;
+   if (nc_def_var(ncid2, "v", NC_FLOAT, NDIMS, dimids, &varid2)) ERR;
+   if (nc_def_var_chunking(ncid2, varid2, NC_CHUNKED, chunks)) ERR;
+   if (nc_def_var_deflate(ncid2, varid2, 1, 1, 6)) ERR;
+   if (nc_enddef(ncid2)) ERR;
+   if (nc_copy_var_raw(ncid, varid, ncid2, varid2)) ERR;
+   if (nc_close(ncid2)) ERR;
+   traw = elapsed(&t0);
+   if (nc_close(ncid)) ERR;
+
+   /* Spot check */
+   if (nc_open(out, NC_NOWRITE, &ncid2)) ERR;
+   start[0] = NBIGREC - 1;
+   if (nc_get_vara_float(ncid2, 0, start, count, data)) ERR;
+   for (i = 0; i < NBIGY * NBIGX; i++)
+      if (data[i] != (float)(((NBIGREC - 1) * 7 + i) % 1000) / 8.0f) ERR;
+   if (nc_close(ncid2)) ERR;
+   free(data);
+   printf("\n      %d MB: by value %.3f s, by chunk %.3f s...",
+          (int)((NBIGREC * NBIGY * NBIGX * sizeof(float)) >> 20), tvalue, traw);
+   return 0;
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+   printf("\n*** Testing raw chunk access.\n");
+   compress = 1;
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+   printf("*** testing HDF5 raw chunk functions...");
+   if (test_api("tst_chunks_raw_in.nc", "tst_chunks_raw_out.nc")) ERR;
+   SUMMARIZE_ERR;
+   printf("*** testing HDF5 copies by chunk and by nc_copy_var...");
+   if (test_copy("tst_chunks_raw_in.nc", "tst_chunks_raw_out.nc")) ERR;
+   SUMMARIZE_ERR;
+#endif
+   printf("*** testing HDF5 nc_copy_var without raw chunk access...");
+   if (test_fallback("tst_chunks_raw_in.nc", "tst_chunks_raw_out.nc")) ERR;
+   SUMMARIZE_ERR;
+#ifdef NETCDF_ENABLE_NCZARR
+   compress = 0;
+   printf("*** testing NCZarr raw chunk functions...");
+   if (test_api("file://tmp_chunks_raw_in.file#mode=nczarr,file",
+                "file://tmp_chunks_raw_out.file#mode=nczarr,file")) ERR;
+   SUMMARIZE_ERR;
+   printf("*** testing NCZarr copies by chunk and by nc_copy_var...");
+   if (test_copy("file://tmp_chunks_raw_in.file#mode=nczarr,file",
+                 "file://tmp_chunks_raw_out.file#mode=nczarr,file")) ERR;
+   SUMMARIZE_ERR;
+#endif
+#ifdef HDF5_SUPPORTS_PAR_FILTERS
+   printf("*** timing the copy of a compressed variable...");
+   if (test_timing("tst_chunks_raw_in.nc", "tst_chunks_raw_out.nc")) ERR;
+   SUMMARIZE_ERR;
+#endif
+   FINAL_RESULTS;
+}
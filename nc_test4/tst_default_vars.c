@@ -0,0 +1,194 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test NCDEFAULT_get_vars, the strided read used by the dispatchers
+   without one of their own, on a netCDF-4/HDF5 file. It reads
+   bounding blocks and gathers the requested elements, so the results
+   are compared with reads of one element at a time for strides that
+   use one block, several blocks, blocks reaching the last element of
+   a dimension, and strides too large for blocks. A 1-D variable
+   larger than a block is read with a partial last block. Range
+   errors must only be reported for requested elements, and strides
+   that are not positive must be refused.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "ncdispatch.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define FILE_NAME "tst_default_vars.nc"
+#define NDIMS 3
+#define NREC 5
+#define NY 23
+#define NX 37
+#define NBIG 600000 /* doubles, more than one block */
+#define NRANGE 64
+
+static const size_t shape[NDIMS] = {NREC, NY, NX};
+
+/* Strides of the test cases; 17 is too large for blocks */
+static const ptrdiff_t strides[][NDIMS] = {
+   {1, 1, 2}, {1, 2, 1}, {2, 3, 5}, {1, 1, 16}, {3, 1, 17}, {4, 22, 36}, {1, 5, 3}
+};
+#define NSTRIDES (sizeof(strides) / sizeof(strides[0]))
+
+static int
+create(void)
+{
+   int ncid, dimids[NDIMS], bigdim, rangedim, varid;
+   size_t start[NDIMS] = {0, 0, 0}, count[NDIMS] = {1, NY, NX};
+   size_t r, i;
+   static int data[NY * NX];
+   static int range[NRANGE];
+   double *big;
+
+   if (nc_create(FILE_NAME, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   if (nc_def_dim(ncid, "rec", NC_UNLIMITED, &dimids[0])) ERR;
+   if (nc_def_dim(ncid, "y", NY, &dimids[1])) ERR;
+   if (nc_def_dim(ncid, "x", NX, &dimids[2])) ERR;
+   if (nc_def_dim(ncid, "big", NBIG, &bigdim)) ERR;
+   if (nc_def_dim(ncid, "range", NRANGE, &rangedim)) ERR;
+   if (nc_def_var(ncid, "i", NC_INT, NDIMS, dimids, &varid)) ERR;
+   if (nc_def_var(ncid, "d", NC_DOUBLE, 1, &bigdim, NULL)) ERR;
+   if (nc_def_var(ncid, "r", NC_INT, 1, &rangedim, NULL)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   for (r = 0; r < NREC; r++)
+   {
+      for (i = 0; i < NY * NX; i++)
+         data[i] = (int)(r * NY * NX + i);
+      start[0] = r;
+      if (nc_put_vara_int(ncid, varid, start, count, data)) ERR;
+   }
+   if (!(big = malloc(NBIG * sizeof(double)))) ERR;
+   for (i = 0; i < NBIG; i++)
+      big[i] = (double)i / 2;
+   if (nc_put_var_double(ncid, 1, big)) ERR;
+   free(big);
+   /* The odd elements do not fit in a byte */
+   for (i = 0; i < NRANGE; i++)
+      range[i] = (i % 2 ? 1000 : (int)i);
+   if (nc_put_var_int(ncid, 2, range)) ERR;
+   if (nc_close(ncid)) ERR;
+   return 0;
+}
+
+/* Read a strided hyperslab of i as ints and doubles, and compare
+   with reading its elements one at a time */
+static int
+check(int ncid, const size_t *start, const size_t *edges, const ptrdiff_t *stride)
+{
+   size_t n = edges[0] * edges[1] * edges[2], k;
+   size_t index[NDIMS];
+   int *ivals;
+   double *dvals;
+
+   if (!(ivals = malloc(n * sizeof(int)))) ERR;
+   if (!(dvals = malloc(n * sizeof(double)))) ERR;
+   if (NCDEFAULT_get_vars(ncid, 0, start, edges, stride, ivals, NC_INT)) ERR;
+   if (NCDEFAULT_get_vars(ncid, 0, start, edges, stride, dvals, NC_DOUBLE)) ERR;
+   for (k = 0; k < n; k++)
+   {
+      int iv;
+      double dv;
+      index[0] = start[0] + (k / (edges[1] * edges[2])) * (size_t)stride[0];
+      index[1] = start[1] + ((k / edges[2]) % edges[1]) * (size_t)stride[1];
+      index[2] = start[2] + (k % edges[2]) * (size_t)stride[2];
+      if (nc_get_var1_int(ncid, 0, index, &iv)) ERR;
+      if (nc_get_var1_double(ncid, 0, index, &dv)) ERR;
+      if (ivals[k] != iv || dvals[k] != dv) ERR;
+   }
+   free(ivals);
+   free(dvals);
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid;
+   size_t s, d;
+
+   printf("\n*** Testing NCDEFAULT_get_vars.\n");
+   if (create()) ERR;
+   if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+
+   printf("*** testing strided reads to the last element...");
+   for (s = 0; s < NSTRIDES; s++)
+   {
+      size_t start[NDIMS], edges[NDIMS];
+      size_t first;
+      /* From the first element, then from the one whose stride ends
+         on the last element */
+      for (first = 0; first < 2; first++)
+      {
+         for (d = 0; d < NDIMS; d++)
+         {
+            start[d] = (first * (shape[d] - 1)) % (size_t)strides[s][d];
+            edges[d] = (shape[d] - 1 - start[d]) / (size_t)strides[s][d] + 1;
+         }
+         if (check(ncid, start, edges, strides[s])) ERR;
+      }
+   }
+   SUMMARIZE_ERR;
+
+   printf("*** testing strided reads inside the variable...");
+   for (s = 0; s < NSTRIDES; s++)
+   {
+      size_t start[NDIMS] = {1, 2, 3}, edges[NDIMS];
+      for (d = 0; d < NDIMS; d++)
+      {
+         size_t most = (shape[d] - 1 - start[d]) / (size_t)strides[s][d] + 1;
+         edges[d] = (most > 1 ? most - 1 : 1);
+      }
+      if (check(ncid, start, edges, strides[s])) ERR;
+   }
+   SUMMARIZE_ERR;
+
+   printf("*** testing a read with a partial last block...");
+   {
+      size_t start = 1, edges = (NBIG - 2) / 3 + 1, k;
+      ptrdiff_t stride = 3;
+      double *vals;
+      if (!(vals = malloc(edges * sizeof(double)))) ERR;
+      if (NCDEFAULT_get_vars(ncid, 1, &start, &edges, &stride, vals, NC_DOUBLE)) ERR;
+      for (k = 0; k < edges; k++)
+         if (vals[k] != (double)(start + k * 3) / 2) ERR;
+      free(vals);
+   }
+   SUMMARIZE_ERR;
+
+   printf("*** testing range errors of unrequested elements...");
+   {
+      size_t start = 0, edges = NRANGE / 2, k;
+      ptrdiff_t stride = 2;
+      signed char vals[NRANGE / 2];
+      /* The block holds the odd elements, which are not requested */
+      if (NCDEFAULT_get_vars(ncid, 2, &start, &edges, &stride, vals, NC_BYTE)) ERR;
+      for (k = 0; k < edges; k++)
+         if (vals[k] != (signed char)(k * 2)) ERR;
+      start = 1;
+      if (NCDEFAULT_get_vars(ncid, 2, &start, &edges, &stride, vals, NC_BYTE) != NC_ERANGE) ERR;
+   }
+   SUMMARIZE_ERR;
+
+   printf("*** testing bad strides...");
+   {
+      size_t start[NDIMS] = {0, 0, 0}, edges[NDIMS] = {1, 2, 2};
+      ptrdiff_t zero[NDIMS] = {1, 1, 0}, negative[NDIMS] = {1, -1, 1};
+      ptrdiff_t past[NDIMS] = {1, 1, NX};
+      int vals[4];
+      if (NCDEFAULT_get_vars(ncid, 0, start, edges, zero, vals, NC_INT) != NC_ESTRIDE) ERR;
+      if (NCDEFAULT_get_vars(ncid, 0, start, edges, negative, vals, NC_INT) != NC_ESTRIDE) ERR;
+      /* The second element of a row would be past its end */
+      if (NCDEFAULT_get_vars(ncid, 0, start, edges, past, vals, NC_INT) == NC_NOERR) ERR;
+   }
+   SUMMARIZE_ERR;
+
+   if (nc_close(ncid)) ERR;
+   FINAL_RESULTS;
+}
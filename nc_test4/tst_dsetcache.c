@@ -0,0 +1,213 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test the cap on the no. of open datasets of a file opened
+   read-only, set with NETCDF_MAXDATASETS. Many vars are read in turn
+   and again, so their datasets are closed and opened again. A var
+   with a secret HDF5 name, a chunk cache set by the user, and an
+   unlimited dim and an att type that are only known once lazy groups
+   are read, are checked with a cap of one dataset.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "hdf5internal.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define FILE_NAME "tst_dsetcache.nc"
+#define NVARS 20
+#define NX 4
+#define NREC 3
+#define CACHE_SIZE 1000000
+#define CACHE_NELEMS 1009
+
+typedef struct {int a; double b;} pair;
+
+static int
+create(void)
+{
+   int ncid, g1, g2, xdim, ydim, tdim, varid, v, i, dimids[2];
+   int data[NREC * NX];
+   nc_type ctype;
+   pair p = {7, 3.5};
+   char name[NC_MAX_NAME + 1];
+
+   if (nc_create(FILE_NAME, NC_CLOBBER|NC_NETCDF4, &ncid)) return 1;
+   if (nc_def_dim(ncid, "x", NX, &xdim)) return 1;
+   if (nc_def_dim(ncid, "y", 2, &ydim)) return 1;
+   if (nc_def_dim(ncid, "t", NC_UNLIMITED, &tdim)) return 1;
+   for (v = 0; v < NVARS; v++)
+   {
+      snprintf(name, sizeof(name), "v%d", v);
+      if (nc_def_var(ncid, name, NC_INT, 1, &xdim, &varid)) return 1;
+      for (i = 0; i < NX; i++) data[i] = v * 100 + i;
+      if (nc_put_var_int(ncid, varid, data)) return 1;
+   }
+   /* a var named as a dim it does not use, chunked so that it has
+      a chunk cache */
+   if (nc_def_var(ncid, "x", NC_INT, 1, &ydim, &varid)) return 1;
+   if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, NULL)) return 1;
+   data[0] = 1; data[1] = 2;
+   if (nc_put_var_int(ncid, varid, data)) return 1;
+   /* a var of the unlimited dim; the records are in /g2 */
+   dimids[0] = tdim; dimids[1] = xdim;
+   if (nc_def_var(ncid, "r", NC_INT, 2, dimids, &varid)) return 1;
+
+   /* a type defined in /g1 is the type of an att in /g2 */
+   if (nc_def_grp(ncid, "g1", &g1)) return 1;
+   if (nc_def_compound(g1, sizeof(pair), "pair", &ctype)) return 1;
+   if (nc_insert_compound(g1, ctype, "a", NC_COMPOUND_OFFSET(pair, a), NC_INT)) return 1;
+   if (nc_insert_compound(g1, ctype, "b", NC_COMPOUND_OFFSET(pair, b), NC_DOUBLE)) return 1;
+   for (v = 0; v < NVARS; v++)
+   {
+      snprintf(name, sizeof(name), "w%d", v);
+      if (nc_def_var(g1, name, NC_INT, 1, &xdim, &varid)) return 1;
+   }
+   if (nc_def_grp(ncid, "g2", &g2)) return 1;
+   if (nc_def_var(g2, "s", NC_INT, 2, dimids, &varid)) return 1;
+   if (nc_put_att(g2, varid, "p", ctype, 1, &p)) return 1;
+   for (i = 0; i < NREC * NX; i++) data[i] = i;
+   {
+      size_t start[2] = {0, 0}, count[2] = {NREC, NX};
+      if (nc_put_vara_int(g2, varid, start, count, data)) return 1;
+   }
+   if (nc_close(ncid)) return 1;
+   return 0;
+}
+
+/* Read the vars v0.. of the root group and check them */
+static int
+readvars(int ncid)
+{
+   int v, i, data[NX];
+   for (v = 0; v < NVARS; v++)
+   {
+      if (nc_get_var_int(ncid, v, data)) return 1;
+      for (i = 0; i < NX; i++)
+         if (data[i] != v * 100 + i) return 1;
+   }
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid, grp, varid;
+   NC_HDF5_DSSTATS stats;
+
+   unsetenv("NETCDF_MAXDATASETS");
+   printf("\n*** Testing the cap on open datasets.\n");
+   printf("*** creating file...");
+   {
+      if (create()) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing without a cap...");
+   {
+      if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+      if (readvars(ncid)) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      if (stats.maxopen != 0 || stats.evictions != 0) ERR;
+      /* every var of the file was opened at open */
+      if (stats.nopen != 2 * NVARS + 3 || stats.opens != stats.nopen) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing reads under a cap...");
+   {
+      setenv("NETCDF_MAXDATASETS", "4", 1);
+      if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      if (stats.maxopen != 4 || stats.nopen != 4) ERR;
+      if (readvars(ncid)) ERR;
+      if (readvars(ncid)) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      if (stats.nopen != 4 || stats.reopens < 2 * NVARS) ERR;
+      if (stats.evictions != stats.opens - stats.nopen) ERR;
+      /* the last var read is open, again read without opening */
+      {
+         unsigned long long opens = stats.opens;
+         int data[NX];
+         if (nc_get_var_int(ncid, NVARS - 1, data)) ERR;
+         if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+         if (stats.opens != opens) ERR;
+      }
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing a secret name and a chunk cache under a cap...");
+   {
+      NC_VAR_INFO_T *var;
+      hid_t access_pid;
+      size_t size, nelems;
+      double w0;
+      int data[2];
+
+      setenv("NETCDF_MAXDATASETS", "1", 1);
+      if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+      if (nc_inq_varid(ncid, "x", &varid)) ERR;
+      if (nc_set_var_chunk_cache(ncid, varid, CACHE_SIZE, CACHE_NELEMS, 0.5)) ERR;
+      if (readvars(ncid)) ERR;
+      if (nc_get_var_int(ncid, varid, data)) ERR;
+      if (data[0] != 1 || data[1] != 2) ERR;
+      /* the dataset was opened again with the cache of the var */
+      if (nc4_hdf5_find_grp_h5_var(ncid, varid, NULL, NULL, &var)) ERR;
+      if ((access_pid = H5Dget_access_plist(((NC_HDF5_VAR_INFO_T *)var->format_var_info)->hdf_datasetid)) < 0) ERR;
+      if (H5Pget_chunk_cache(access_pid, &nelems, &size, &w0) < 0) ERR;
+      if (H5Pclose(access_pid) < 0) ERR;
+      if (size != CACHE_SIZE || nelems != CACHE_NELEMS) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      if (stats.nopen != 1) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing lazy groups under a cap...");
+   {
+      int data[NREC * NX], i;
+      unsigned long long opens;
+      size_t len;
+      pair p;
+
+      if (nc_open(FILE_NAME, NC_NOWRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      /* the records of r are in /g2, read while r is in use */
+      if (nc_inq_varid(ncid, "r", &varid)) ERR;
+      if (nc_get_var_int(ncid, varid, data)) ERR;
+      if (nc_inq_dimlen(ncid, 2, &len) || len != NREC) ERR;
+      if (nc_close(ncid)) ERR;
+
+      /* the type of p is in /g1, read while the atts of s are read */
+      if (nc_open(FILE_NAME, NC_NOWRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      if (nc_inq_grp_full_ncid(ncid, "/g2", &grp)) ERR;
+      if (nc_inq_varid(grp, "s", &varid)) ERR;
+      if (nc_get_att(grp, varid, "p", &p)) ERR;
+      if (p.a != 7 || p.b != 3.5) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      /* the dataset of s stayed open */
+      if (stats.nopen != 1 || stats.evictions < NVARS || stats.reopens) ERR;
+      opens = stats.opens;
+      if (nc_get_var_int(grp, varid, data)) ERR;
+      for (i = 0; i < NREC * NX; i++)
+         if (data[i] != i) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      if (stats.nopen != 1 || stats.opens != opens) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing no cap for writing...");
+   {
+      int value = 42;
+      if (nc_open(FILE_NAME, NC_WRITE, &ncid)) ERR;
+      if (readvars(ncid)) ERR;
+      if (nc4_hdf5_get_dataset_stats(ncid, &stats)) ERR;
+      if (stats.maxopen != 0 || stats.evictions != 0) ERR;
+      if (nc_put_att_int(ncid, 0, "new", NC_INT, 1, &value)) ERR;
+      if (nc_close(ncid)) ERR;
+      unsetenv("NETCDF_MAXDATASETS");
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
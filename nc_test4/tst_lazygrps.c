@@ -0,0 +1,313 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test opening a file with NC_LAZYGROUPS, which reads the groups
+   below the root when they are first used. A tree of groups is
+   written with dims in the parents, user-defined types used in other
+   groups, a multi-dimensional coordinate variable and an unlimited
+   dim whose length comes from a deep group. The groups are used out
+   of order, then the tree is described by names and compared with the
+   description from an eager open. Last, a phony dim made in the root
+   group must not take the dimid stored for a dim of a lazy group.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+#include <hdf5.h>
+#include <H5DSpublic.h>
+
+#define FILE_NAME "tst_lazygrps.nc"
+#define PHONY_FILE_NAME "tst_lazygrps_phony.h5"
+#define FANOUT 2
+#define DEPTH 3
+#define NX 3
+#define NREC 5
+#define DESCLEN 65536
+
+typedef struct {int a; double b;} pair;
+
+/* Define the subgroups of grp, depth levels deep */
+static int
+build(int grp, int depth, int id, int xdim, int tdim, nc_type ctype)
+{
+   int i, ydim, varid, dimids[3];
+   int data[NREC * NX * 2];
+   char name[NC_MAX_NAME + 1];
+
+   if (nc_put_att_int(grp, NC_GLOBAL, "id", NC_INT, 1, &id)) return 1;
+   if (nc_def_dim(grp, "y", 2, &ydim)) return 1;
+   /* a multi-dimensional coordinate variable in a later group */
+   if (id == 21)
+   {
+      int zdim, zdata[4 * NX];
+      if (nc_def_dim(grp, "z", 4, &zdim)) return 1;
+      dimids[0] = zdim; dimids[1] = xdim;
+      if (nc_def_var(grp, "z", NC_INT, 2, dimids, &varid)) return 1;
+      for (i = 0; i < 4 * NX; i++) zdata[i] = i;
+      if (nc_put_var_int(grp, varid, zdata)) return 1;
+   }
+   dimids[0] = tdim; dimids[1] = xdim; dimids[2] = ydim;
+   if (nc_def_var(grp, "v", NC_INT, 3, dimids, &varid)) return 1;
+   for (i = 0; i < NREC * NX * 2; i++) data[i] = id * 100 + i;
+   {
+      size_t start[3] = {0, 0, 0}, count[3] = {NREC, NX, 2};
+      /* only the deepest groups write records */
+      if (depth == 0)
+         if (nc_put_vara_int(grp, varid, start, count, data)) return 1;
+   }
+   /* a user-defined type of an earlier group, in the leaves */
+   if (ctype != NC_NAT && depth == 0)
+   {
+      pair p = {id, id / 2.0};
+      if (nc_def_var(grp, "c", ctype, 0, NULL, &varid)) return 1;
+      if (nc_put_var(grp, varid, &p)) return 1;
+   }
+   if (depth == 0) return 0;
+   for (i = 0; i < FANOUT; i++)
+   {
+      int sub;
+      snprintf(name, sizeof(name), "g%d", id * 10 + i + 1);
+      if (nc_def_grp(grp, name, &sub)) return 1;
+      /* the first child defines a type, its later siblings use it */
+      if (i == 0)
+      {
+         if (nc_def_compound(sub, sizeof(pair), "pair", &ctype)) return 1;
+         if (nc_insert_compound(sub, ctype, "a", NC_COMPOUND_OFFSET(pair, a), NC_INT)) return 1;
+         if (nc_insert_compound(sub, ctype, "b", NC_COMPOUND_OFFSET(pair, b), NC_DOUBLE)) return 1;
+         if (build(sub, depth - 1, id * 10 + i + 1, xdim, tdim, NC_NAT)) return 1;
+      }
+      else if (build(sub, depth - 1, id * 10 + i + 1, xdim, tdim, ctype)) return 1;
+   }
+   return 0;
+}
+
+static int
+create(void)
+{
+   int ncid, xdim, tdim;
+
+   if (nc_create(FILE_NAME, NC_CLOBBER|NC_NETCDF4, &ncid)) return 1;
+   if (nc_def_dim(ncid, "x", NX, &xdim)) return 1;
+   if (nc_def_dim(ncid, "t", NC_UNLIMITED, &tdim)) return 1;
+   if (build(ncid, DEPTH, 0, xdim, tdim, NC_NAT)) return 1;
+   if (nc_close(ncid)) return 1;
+   return 0;
+}
+
+/* Describe a group and the groups below it by names */
+static int
+describe(int grp, char *desc)
+{
+   char name[NC_MAX_NAME + 1];
+   int i, ndims, nvars, natts, ngrps, dimids[NC_MAX_DIMS], grps[FANOUT];
+   size_t len;
+
+   if (nc_inq_grpname_full(grp, &len, NULL)) return 1;
+   if (nc_inq_grpname_full(grp, NULL, desc + strlen(desc))) return 1;
+   strcat(desc, "\n");
+   if (nc_inq_dimids(grp, &ndims, dimids, 0)) return 1;
+   for (i = 0; i < ndims; i++)
+   {
+      if (nc_inq_dim(grp, dimids[i], name, &len)) return 1;
+      sprintf(desc + strlen(desc), " dim %s %zu\n", name, len);
+   }
+   if (nc_inq_natts(grp, &natts)) return 1;
+   for (i = 0; i < natts; i++)
+   {
+      int value;
+      if (nc_inq_attname(grp, NC_GLOBAL, i, name)) return 1;
+      if (nc_get_att_int(grp, NC_GLOBAL, name, &value)) return 1;
+      sprintf(desc + strlen(desc), " att %s %d\n", name, value);
+   }
+   if (nc_inq_nvars(grp, &nvars)) return 1;
+   for (i = 0; i < nvars; i++)
+   {
+      nc_type xtype;
+      int vdims, d;
+      if (nc_inq_var(grp, i, name, &xtype, &vdims, dimids, NULL)) return 1;
+      sprintf(desc + strlen(desc), " var %s", name);
+      for (d = 0; d < vdims; d++)
+      {
+         if (nc_inq_dimname(grp, dimids[d], name)) return 1;
+         sprintf(desc + strlen(desc), " %s", name);
+      }
+      if (xtype > NC_MAX_ATOMIC_TYPE)
+      {
+         pair p;
+         if (nc_inq_user_type(grp, xtype, name, NULL, NULL, NULL, NULL)) return 1;
+         if (nc_get_var(grp, i, &p)) return 1;
+         sprintf(desc + strlen(desc), " %s %d %g\n", name, p.a, p.b);
+      }
+      else
+      {
+         int data[NREC * NX * 4];
+         long sum = 0;
+         size_t n = 1;
+         for (d = 0; d < vdims; d++)
+         {
+            if (nc_inq_dimlen(grp, dimids[d], &len)) return 1;
+            n *= len;
+         }
+         if (nc_get_var_int(grp, i, data)) return 1;
+         while (n > 0) sum += data[--n];
+         sprintf(desc + strlen(desc), " sum %ld\n", sum);
+      }
+   }
+   if (nc_inq_grps(grp, &ngrps, grps)) return 1;
+   for (i = 0; i < ngrps; i++)
+      if (describe(grps[i], desc)) return 1;
+   return 0;
+}
+
+/* Write with HDF5 a dataset without dimscales in the root group, and
+   in a group a dimscale that stores dimid 0 and a dataset using it */
+static int
+create_phony(void)
+{
+   hid_t fileid, grpid, spaceid, scaleid, dsid, attspaceid, attid;
+   hsize_t dims[1] = {4}, rawdims[1] = {7};
+   int dimid = 0;
+
+   if ((fileid = H5Fcreate(PHONY_FILE_NAME, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) < 0) return 1;
+   if ((spaceid = H5Screate_simple(1, rawdims, NULL)) < 0) return 1;
+   if ((dsid = H5Dcreate2(fileid, "raw", H5T_NATIVE_INT, spaceid, H5P_DEFAULT,
+                          H5P_DEFAULT, H5P_DEFAULT)) < 0) return 1;
+   if (H5Dclose(dsid) < 0 || H5Sclose(spaceid) < 0) return 1;
+
+   if ((grpid = H5Gcreate2(fileid, "g", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0) return 1;
+   if ((spaceid = H5Screate_simple(1, dims, NULL)) < 0) return 1;
+   if ((scaleid = H5Dcreate2(grpid, "d", H5T_NATIVE_INT, spaceid, H5P_DEFAULT,
+                             H5P_DEFAULT, H5P_DEFAULT)) < 0) return 1;
+   if (H5DSset_scale(scaleid, "d") < 0) return 1;
+   if ((attspaceid = H5Screate(H5S_SCALAR)) < 0) return 1;
+   if ((attid = H5Acreate2(scaleid, "_Netcdf4Dimid", H5T_NATIVE_INT, attspaceid,
+                           H5P_DEFAULT, H5P_DEFAULT)) < 0) return 1;
+   if (H5Awrite(attid, H5T_NATIVE_INT, &dimid) < 0) return 1;
+   if (H5Aclose(attid) < 0 || H5Sclose(attspaceid) < 0) return 1;
+   if ((dsid = H5Dcreate2(grpid, "v", H5T_NATIVE_INT, spaceid, H5P_DEFAULT,
+                          H5P_DEFAULT, H5P_DEFAULT)) < 0) return 1;
+   if (H5DSattach_scale(dsid, scaleid, 0) < 0) return 1;
+   if (H5Dclose(dsid) < 0 || H5Dclose(scaleid) < 0 || H5Sclose(spaceid) < 0) return 1;
+   if (H5Gclose(grpid) < 0 || H5Fclose(fileid) < 0) return 1;
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   char *eager, *lazy;
+   int ncid, grp, varid, dimid, eagerdimid, ndims, dimids[2];
+   nc_type xtype;
+   size_t len;
+   char name[NC_MAX_NAME + 1];
+
+   if (!(eager = calloc(1, DESCLEN)) || !(lazy = calloc(1, DESCLEN))) ERR;
+
+   printf("\n*** Testing NC_LAZYGROUPS.\n");
+   printf("*** creating file...");
+   {
+      if (create()) ERR;
+      if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+      if (describe(ncid, eager)) ERR;
+      if (nc_inq_grp_full_ncid(ncid, "/g1", &grp)) ERR;
+      if (nc_inq_dimid(grp, "y", &eagerdimid)) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing groups used out of order...");
+   {
+      if (nc_open(FILE_NAME, NC_NOWRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      /* the dims of the groups below the root are not read yet */
+      if (nc_inq_dimname(ncid, eagerdimid, name) != NC_EBADDIM) ERR;
+      /* the length of the unlimited dim comes from the deep groups */
+      if (nc_inq_dimid(ncid, "t", &dimid)) ERR;
+      if (nc_inq_dimlen(ncid, dimid, &len)) ERR;
+      if (len != NREC) ERR;
+      if (nc_close(ncid)) ERR;
+
+      if (nc_open(FILE_NAME, NC_NOWRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      /* a later group first: the hidden coordinates of z have the
+       * dim ids of an eager open */
+      if (nc_inq_grp_full_ncid(ncid, "/g2/g21", &grp)) ERR;
+      if (nc_inq_varid(grp, "z", &varid)) ERR;
+      if (nc_inq_var(grp, varid, NULL, NULL, &ndims, dimids, NULL)) ERR;
+      if (ndims != 2) ERR;
+      if (nc_inq_dimname(grp, dimids[0], name) || strcmp(name, "z")) ERR;
+      if (nc_inq_dimname(grp, dimids[1], name) || strcmp(name, "x")) ERR;
+      /* a type defined in an earlier sibling */
+      if (nc_inq_grp_full_ncid(ncid, "/g2/g22/g222", &grp)) ERR;
+      if (nc_inq_varid(grp, "c", &varid)) ERR;
+      if (nc_inq_vartype(grp, varid, &xtype)) ERR;
+      if (nc_inq_user_type(grp, xtype, name, NULL, NULL, NULL, NULL)) ERR;
+      if (strcmp(name, "pair")) ERR;
+      if (describe(ncid, lazy)) ERR;
+      if (strcmp(eager, lazy)) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing groups used in order...");
+   {
+      lazy[0] = '\0';
+      if (nc_open(FILE_NAME, NC_NOWRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      if (describe(ncid, lazy)) ERR;
+      if (strcmp(eager, lazy)) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing NETCDF_LAZYGROUPS...");
+   {
+      setenv("NETCDF_LAZYGROUPS", "1", 1);
+      if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+      if (nc_inq_dimname(ncid, eagerdimid, name) != NC_EBADDIM) ERR;
+      lazy[0] = '\0';
+      if (describe(ncid, lazy)) ERR;
+      if (strcmp(eager, lazy)) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing NC_LAZYGROUPS ignored for writing...");
+   {
+      int value = 42;
+      if (nc_open(FILE_NAME, NC_WRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      if (nc_inq_dimname(ncid, eagerdimid, name)) ERR;
+      if (strcmp(name, "y")) ERR;
+      if (nc_inq_grp_full_ncid(ncid, "/g1/g11", &grp)) ERR;
+      if (nc_put_att_int(grp, NC_GLOBAL, "new", NC_INT, 1, &value)) ERR;
+      if (nc_close(ncid)) ERR;
+      unsetenv("NETCDF_LAZYGROUPS");
+      if (nc_open(FILE_NAME, NC_NOWRITE|NC_LAZYGROUPS, &ncid)) ERR;
+      if (nc_inq_grp_full_ncid(ncid, "/g1/g11", &grp)) ERR;
+      if (nc_get_att_int(grp, NC_GLOBAL, "new", &value)) ERR;
+      if (value != 42) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing dimids of phony dims...");
+   {
+      int mode, eagerids[2], lazyids[2];
+      if (create_phony()) ERR;
+      for (mode = 0; mode < 2; mode++)
+      {
+         int *ids = mode ? lazyids : eagerids;
+         if (nc_open(PHONY_FILE_NAME, NC_NOWRITE|(mode ? NC_LAZYGROUPS : 0), &ncid)) ERR;
+         /* the root group, and its phony dim, are read first */
+         if (nc_inq_varid(ncid, "raw", &varid)) ERR;
+         if (nc_inq_vardimid(ncid, varid, &ids[0])) ERR;
+         if (nc_inq_grp_full_ncid(ncid, "/g", &grp)) ERR;
+         if (nc_inq_dimid(grp, "d", &ids[1])) ERR;
+         if (nc_close(ncid)) ERR;
+      }
+      /* d keeps the dimid stored for it */
+      if (eagerids[1] != 0 || lazyids[1] != 0) ERR;
+      if (lazyids[0] == lazyids[1]) ERR;
+   }
+   SUMMARIZE_ERR;
+   free(eager);
+   free(lazy);
+   FINAL_RESULTS;
+}
@@ -0,0 +1,495 @@
+/*********************************************************************
+ *   Copyright 2018, UCAR/Unidata
+ *   See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ *********************************************************************/
+
+/* Pipelined copy of variable data into chunked, deflated netCDF-4
+ * variables; see chunkpipe.h.
+ *
+ * Chunks are read into batches of jobs.  Each job is handed to the
+ * thread pool as soon as it has been read.  When a batch is full, the
+ * previous batch is waited for and its chunks are written in order,
+ * so that reading one batch overlaps with filtering the other, and
+ * at most two batches of chunks are in memory at once. */
+
+#include "config.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "netcdf_filter.h"
+#include "ncthreadpool.h"
+#include "utils.h"
+#include "chunkpipe.h"
+
+/* H5Dwrite_chunk() is needed by nc_put_chunk_raw() for HDF5 */
+#if defined(USE_HDF5) && defined(HDF5_SUPPORTS_PAR_FILTERS)
+#define CHUNKPIPE
+#include <zlib.h>
+#endif
+
+#ifdef CHUNKPIPE
+
+#define JOBS_PER_THREAD 2	/* jobs per worker thread in a batch */
+#define MAX_PIPE_FILTERS 2	/* at most shuffle and deflate */
+
+/* How the chunks of one output variable are filtered */
+typedef struct pipevar_t {
+    int refcount;		/* jobs using this, plus 1 while queuing */
+    int ogrp;
+    int ovarid;
+    int rank;
+    size_t typesize;
+    size_t chunkbytes;		/* bytes in a whole chunk */
+    size_t chunksizes[NC_MAX_VAR_DIMS];
+    size_t nfilters;
+    unsigned int filters[MAX_PIPE_FILTERS]; /* in pipeline order */
+    int level;			/* deflate level */
+    void *fill;			/* pads edge chunks */
+} pipevar_t;
+
+/* One chunk on its way through the pipeline */
+typedef struct pipejob_t {
+    pipevar_t *var;
+    size_t start[NC_MAX_VAR_DIMS];
+    size_t count[NC_MAX_VAR_DIMS]; /* less than the chunk at edges */
+    void *data;			/* the values read, then the stored chunk */
+    size_t size;		/* bytes in data */
+} pipejob_t;
+
+typedef struct pipebatch_t {
+    NCtaskgroup *group;
+    size_t njobs;
+    pipejob_t *jobs;
+} pipebatch_t;
+
+struct chunkpipe_t {
+    NCthreadpool *pool;
+    size_t maxjobs;		/* jobs per batch */
+    pipebatch_t batches[2];
+    int cur;			/* batch being read into */
+};
+
+static void
+release_var(pipevar_t *var)
+{
+    if(var && --var->refcount == 0) {
+	free(var->fill);
+	free(var);
+    }
+}
+
+/* Copy the count values of a job into a whole chunk, padded with the
+ * fill value.  Both are in C order. */
+static void
+pad_chunk(const pipevar_t *var, const size_t *count, const char *src, char *dst)
+{
+    size_t rowbytes, nrows, row, i;
+    size_t index[NC_MAX_VAR_DIMS];
+    int d, last = var->rank - 1;
+
+    for(i = 0; i < var->chunkbytes; i += var->typesize)
+	memcpy(dst + i, var->fill, var->typesize);
+    rowbytes = count[last] * var->typesize;
+    nrows = 1;
+    for(d = 0; d < last; d++) {
+	nrows *= count[d];
+	index[d] = 0;
+    }
+    for(row = 0; row < nrows; row++) {
+	size_t offset = 0;
+	for(d = 0; d < last; d++)
+	    offset = (offset + index[d]) * var->chunksizes[d + 1];
+	memcpy(dst + offset * var->typesize, src, rowbytes);
+	src += rowbytes;
+	for(d = last - 1; d >= 0; d--) {
+	    if(++index[d] < count[d])
+		break;
+	    index[d] = 0;
+	}
+    }
+}
+
+/* Byte transposition, as done by the HDF5 shuffle filter */
+static void
+shuffle_chunk(size_t typesize, size_t nbytes, const unsigned char *src, unsigned char *dst)
+{
+    size_t nelems = nbytes / typesize;
+    size_t i, j;
+
+    for(j = 0; j < typesize; j++) {
+	unsigned char *out = dst + j * nelems;
+	const unsigned char *in = src + j;
+	for(i = 0; i < nelems; i++, in += typesize)
+	    out[i] = *in;
+    }
+    /* any bytes after the last whole value are not shuffled */
+    memcpy(dst + nelems * typesize, src + nelems * typesize, nbytes - nelems * typesize);
+}
+
+/* Worker task: turn the values read for a job into the stored chunk,
+ * through the same filters, with the same parameters, as HDF5 would
+ * apply when writing the chunk */
+static int
+filter_chunk(void *arg)
+{
+    pipejob_t *job = (pipejob_t *)arg;
+    const pipevar_t *var = job->var;
+    size_t f;
+    int d;
+    void *tmp;
+
+    for(d = 0; d < var->rank; d++)
+	if(job->count[d] != var->chunksizes[d])
+	    break;
+    if(d < var->rank) {		/* edge chunk */
+	if((tmp = malloc(var->chunkbytes)) == NULL)
+	    return NC_ENOMEM;
+	pad_chunk(var, job->count, job->data, tmp);
+	free(job->data);
+	job->data = tmp;
+	job->size = var->chunkbytes;
+    }
+    for(f = 0; f < var->nfilters; f++) {
+	switch(var->filters[f]) {
+	case H5Z_FILTER_SHUFFLE:
+	    if(var->typesize <= 1)
+		continue;	/* HDF5 does not shuffle single bytes either */
+	    if((tmp = malloc(job->size)) == NULL)
+		return NC_ENOMEM;
+	    shuffle_chunk(var->typesize, job->size, job->data, tmp);
+	    break;
+	case H5Z_FILTER_DEFLATE: {
+	    uLongf zsize = compressBound((uLong)job->size);
+	    if((tmp = malloc(zsize)) == NULL)
+		return NC_ENOMEM;
+	    if(compress2(tmp, &zsize, job->data, (uLong)job->size, var->level) != Z_OK) {
+		free(tmp);
+		return NC_EFILTER;
+	    }
+	    job->size = zsize;
+	    } break;
+	default:
+	    return NC_EFILTER;
+	}
+	free(job->data);
+	job->data = tmp;
+    }
+    return NC_NOERR;
+}
+
+/* Wait for the jobs of a batch and write their chunks in order */
+static int
+write_batch(pipebatch_t *batch)
+{
+    int stat = NC_NOERR;
+    size_t i;
+
+    if(batch->njobs == 0)
+	return NC_NOERR;
+    stat = nctaskwait(batch->group);
+    for(i = 0; i < batch->njobs; i++) {
+	pipejob_t *job = &batch->jobs[i];
+	if(stat == NC_NOERR)
+	    stat = nc_put_chunk_raw(job->var->ogrp, job->var->ovarid, job->start,
+				    0, job->size, job->data);
+	free(job->data);
+	job->data = NULL;
+	release_var(job->var);
+	job->var = NULL;
+    }
+    batch->njobs = 0;
+    return stat;
+}
+
+/* Is this host big-endian? */
+static int
+host_bigendian(void)
+{
+    unsigned int one = 1;
+    return (*(unsigned char *)&one == 0);
+}
+
+/* Set up var for ovarid, or return NC_EINVAL if the pipeline cannot
+ * produce its chunks */
+static int
+inq_pipevar(int igrp, int varid, int ogrp, int ovarid, pipevar_t *var)
+{
+    int stat = NC_NOERR;
+    int formatx, storage, endian, nofill, quantize, nsd, d;
+    nc_type itype, otype;
+    int ndims;
+    size_t nfilters, f, nparams;
+    unsigned int ids[MAX_PIPE_FILTERS + 1];
+    unsigned int level;
+
+    NC_CHECK(nc_inq_format_extended(ogrp, &formatx, NULL));
+    if(formatx != NC_FORMATX_NC_HDF5)
+	return NC_EINVAL;
+    NC_CHECK(nc_inq_vartype(igrp, varid, &itype));
+    NC_CHECK(nc_inq_var(ogrp, ovarid, NULL, &otype, &ndims, NULL, NULL));
+    /* Atomic, fixed-size types have the same layout in memory and,
+     * in native byte order, in the file */
+    if(itype != otype || otype < NC_BYTE || otype > NC_UINT64 || otype == NC_STRING)
+	return NC_EINVAL;
+    NC_CHECK(nc_inq_var_chunking(ogrp, ovarid, &storage, var->chunksizes));
+    if(storage != NC_CHUNKED || ndims == 0)
+	return NC_EINVAL;
+    NC_CHECK(nc_inq_var_endian(ogrp, ovarid, &endian));
+    if(endian == (host_bigendian() ? NC_ENDIAN_LITTLE : NC_ENDIAN_BIG))
+	return NC_EINVAL;
+    /* Quantization changes the values before they are filtered */
+    if(nc_inq_var_quantize(ogrp, ovarid, &quantize, &nsd) == NC_NOERR
+       && quantize != NC_NOQUANTIZE)
+	return NC_EINVAL;
+    NC_CHECK(nc_inq_var_filter_ids(ogrp, ovarid, &nfilters, NULL));
+    if(nfilters == 0 || nfilters > MAX_PIPE_FILTERS)
+	return NC_EINVAL;	/* nothing to do in parallel, or unknown filters */
+    NC_CHECK(nc_inq_var_filter_ids(ogrp, ovarid, NULL, ids));
+    var->level = 0;
+    for(f = 0; f < nfilters; f++) {
+	switch(ids[f]) {
+	case H5Z_FILTER_SHUFFLE:
+	    break;
+	case H5Z_FILTER_DEFLATE:
+	    NC_CHECK(nc_inq_var_filter_info(ogrp, ovarid, ids[f], &nparams, NULL));
+	    if(nparams != 1)
+		return NC_EINVAL;
+	    NC_CHECK(nc_inq_var_filter_info(ogrp, ovarid, ids[f], NULL, &level));
+	    var->level = (int)level;
+	    break;
+	default:
+	    return NC_EINVAL;
+	}
+	var->filters[f] = ids[f];
+    }
+    var->nfilters = nfilters;
+
+    var->ogrp = ogrp;
+    var->ovarid = ovarid;
+    var->rank = ndims;
+    NC_CHECK(nc_inq_type(ogrp, otype, NULL, &var->typesize));
+    var->chunkbytes = var->typesize;
+    for(d = 0; d < ndims; d++)
+	var->chunkbytes *= var->chunksizes[d];
+    var->fill = emalloc(var->typesize);
+    NC_CHECK(nc_inq_var_fill(ogrp, ovarid, &nofill, var->fill));
+    if(nofill)
+	memset(var->fill, 0, var->typesize);
+    return stat;
+}
+
+/* Is dimid an unlimited dimension of grp or of one of its ancestors? */
+static int
+is_unlimited(int grp, int dimid)
+{
+    int nunlims, i, found = 0;
+    int *unlimids;
+
+    for(;;) {
+	NC_CHECK(nc_inq_unlimdims(grp, &nunlims, NULL));
+	unlimids = (int *) emalloc((size_t)(nunlims + 1) * sizeof(int));
+	NC_CHECK(nc_inq_unlimdims(grp, NULL, unlimids));
+	for(i = 0; i < nunlims; i++)
+	    if(unlimids[i] == dimid)
+		found = 1;
+	free(unlimids);
+	if(found || nc_inq_grp_parent(grp, &grp) != NC_NOERR)
+	    break;
+    }
+    return found;
+}
+
+/* Make the output variable as long as the input in its unlimited
+ * dimensions, so that its chunks can be written; as for
+ * nc_copy_var_raw(), by copying the last value.  This is needed even
+ * if another variable has already made the dimension long enough,
+ * because HDF5 extends each variable only when it is written. */
+static int
+extend_var(int igrp, int varid, int ogrp, int ovarid, int rank, const size_t *dimlens)
+{
+    int stat = NC_NOERR;
+    int odimids[NC_MAX_VAR_DIMS];
+    size_t start[NC_MAX_VAR_DIMS], ones[NC_MAX_VAR_DIMS];
+    size_t len, typesize;
+    nc_type vartype;
+    int d, extend = 0;
+    void *value;
+
+    NC_CHECK(nc_inq_vardimid(ogrp, ovarid, odimids));
+    for(d = 0; d < rank; d++) {
+	NC_CHECK(nc_inq_dimlen(ogrp, odimids[d], &len));
+	if(len > dimlens[d])
+	    return NC_EINVAL;	/* edge chunks would show their padding */
+	if(len < dimlens[d] || is_unlimited(ogrp, odimids[d]))
+	    extend = 1;
+	start[d] = dimlens[d] - 1;
+	ones[d] = 1;
+    }
+    if(!extend)
+	return NC_NOERR;
+    NC_CHECK(nc_inq_vartype(igrp, varid, &vartype));
+    NC_CHECK(nc_inq_type(igrp, vartype, NULL, &typesize));
+    value = emalloc(typesize);
+    NC_CHECK(nc_get_vara(igrp, varid, start, ones, value));
+    NC_CHECK(nc_put_vara(ogrp, ovarid, start, ones, value));
+    free(value);
+    return stat;
+}
+
+int
+chunkpipe_new(size_t nthreads, chunkpipe_t **pipep)
+{
+    int stat = NC_NOERR;
+    chunkpipe_t *pipe;
+    int b;
+
+    pipe = (chunkpipe_t *) emalloc(sizeof(chunkpipe_t));
+    memset(pipe, 0, sizeof(chunkpipe_t));
+    pipe->maxjobs = JOBS_PER_THREAD * (nthreads > 0 ? nthreads : 1);
+    NC_CHECK(ncthreadpoolnew(nthreads, &pipe->pool));
+    for(b = 0; b < 2; b++) {
+	NC_CHECK(nctaskgroupnew(pipe->pool, &pipe->batches[b].group));
+	pipe->batches[b].jobs = (pipejob_t *) emalloc(pipe->maxjobs * sizeof(pipejob_t));
+	memset(pipe->batches[b].jobs, 0, pipe->maxjobs * sizeof(pipejob_t));
+    }
+    *pipep = pipe;
+    return stat;
+}
+
+int
+chunkpipe_copy_var(chunkpipe_t *pipe, int igrp, int varid, int ogrp, int ovarid)
+{
+    int stat = NC_NOERR;
+    pipevar_t *var;
+    int idimids[NC_MAX_VAR_DIMS];
+    size_t dimlens[NC_MAX_VAR_DIMS];
+    size_t nchunks[NC_MAX_VAR_DIMS], chunkindex[NC_MAX_VAR_DIMS];
+    int d;
+
+    var = (pipevar_t *) emalloc(sizeof(pipevar_t));
+    memset(var, 0, sizeof(pipevar_t));
+    var->refcount = 1;
+    if((stat = inq_pipevar(igrp, varid, ogrp, ovarid, var)))
+	goto done;
+    NC_CHECK(nc_inq_vardimid(igrp, varid, idimids));
+    for(d = 0; d < var->rank; d++) {
+	NC_CHECK(nc_inq_dimlen(igrp, idimids[d], &dimlens[d]));
+	if(dimlens[d] == 0)
+	    goto done;		/* no data */
+	nchunks[d] = (dimlens[d] + var->chunksizes[d] - 1) / var->chunksizes[d];
+	chunkindex[d] = 0;
+    }
+    if((stat = extend_var(igrp, varid, ogrp, ovarid, var->rank, dimlens)))
+	goto done;
+
+    /* Visit the chunks in C order */
+    for(;;) {
+	pipebatch_t *batch = &pipe->batches[pipe->cur];
+	pipejob_t *job;
+	size_t nvals = 1;
+
+	if(batch->njobs == pipe->maxjobs) {
+	    /* Write the other batch while this one is being filtered */
+	    pipe->cur = 1 - pipe->cur;
+	    if((stat = write_batch(&pipe->batches[pipe->cur])))
+		goto done;
+	    batch = &pipe->batches[pipe->cur];
+	}
+	job = &batch->jobs[batch->njobs];
+	for(d = 0; d < var->rank; d++) {
+	    job->start[d] = chunkindex[d] * var->chunksizes[d];
+	    job->count[d] = dimlens[d] - job->start[d];
+	    if(job->count[d] > var->chunksizes[d])
+		job->count[d] = var->chunksizes[d];
+	    nvals *= job->count[d];
+	}
+	job->size = nvals * var->typesize;
+	job->data = emalloc(job->size);
+	job->var = var;
+	var->refcount++;
+	batch->njobs++;
+	NC_CHECK(nc_get_vara(igrp, varid, job->start, job->count, job->data));
+	NC_CHECK(nctasksubmit(batch->group, filter_chunk, job));
+
+	for(d = var->rank - 1; d >= 0; d--) {
+	    if(++chunkindex[d] < nchunks[d])
+		break;
+	    chunkindex[d] = 0;
+	}
+	if(d < 0)
+	    break;
+    }
+done:
+    release_var(var);
+    return stat;
+}
+
+int
+chunkpipe_flush(chunkpipe_t *pipe)
+{
+    int stat = NC_NOERR;
+    /* The batch not being read into was submitted first */
+    NC_CHECK(write_batch(&pipe->batches[1 - pipe->cur]));
+    NC_CHECK(write_batch(&pipe->batches[pipe->cur]));
+    return stat;
+}
+
+int
+chunkpipe_free(chunkpipe_t *pipe)
+{
+    int stat = NC_NOERR;
+    int b;
+
+    if(pipe == NULL)
+	return NC_NOERR;
+    stat = chunkpipe_flush(pipe);
+    for(b = 0; b < 2; b++) {
+	nctaskgroupfree(pipe->batches[b].group);
+	free(pipe->batches[b].jobs);
+    }
+    ncthreadpoolfree(pipe->pool);
+    free(pipe);
+    return stat;
+}
+
+#else /*!CHUNKPIPE*/
+
+/* Without raw chunk writes nothing can be pipelined; nccopy copies
+ * every variable itself. */
+
+struct chunkpipe_t {
+    size_t nthreads;
+};
+
+int
+chunkpipe_new(size_t nthreads, chunkpipe_t **pipep)
+{
+    chunkpipe_t *pipe = (chunkpipe_t *) emalloc(sizeof(chunkpipe_t));
+    pipe->nthreads = nthreads;
+    *pipep = pipe;
+    return NC_NOERR;
+}
+
+int
+chunkpipe_copy_var(chunkpipe_t *pipe, int igrp, int varid, int ogrp, int ovarid)
+{
+    (void)pipe; (void)igrp; (void)varid; (void)ogrp; (void)ovarid;
+    return NC_EINVAL;
+}
+
+int
+chunkpipe_flush(chunkpipe_t *pipe)
+{
+    (void)pipe;
+    return NC_NOERR;
+}
+
+int
+chunkpipe_free(chunkpipe_t *pipe)
+{
+    free(pipe);
+    return NC_NOERR;
+}
+
+#endif /*CHUNKPIPE*/
@@ -0,0 +1,53 @@
+/*********************************************************************
+ *   Copyright 2018, UCAR/Unidata
+ *   See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ *********************************************************************/
+
+#ifndef _CHUNKPIPE_H_
+#define _CHUNKPIPE_H_
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Pipelined copy of variable data into chunked, deflated netCDF-4
+ * variables, used by nccopy -j.
+ *
+ * The calling thread reads the input one output chunk at a time,
+ * worker threads apply the shuffle and deflate filters of the output
+ * variable, and the calling thread writes the filtered chunks with
+ * nc_put_chunk_raw(), in the order in which they were read. Only the
+ * calling thread ever calls the netCDF library, so the library need
+ * not be built thread-safe.
+ */
+typedef struct chunkpipe_t chunkpipe_t;
+
+/* Create a pipeline with nthreads worker threads */
+extern int
+chunkpipe_new(size_t nthreads, chunkpipe_t **pipep);
+
+/* Queue the data of input variable varid in igrp for copying to
+ * output variable ovarid in ogrp.  Returns NC_EINVAL, having done
+ * nothing, if the output variable is not stored in a way the pipeline
+ * can produce (HDF5, chunked, fixed-size atomic type, native byte
+ * order, only shuffle and deflate filters); the caller then copies
+ * the values itself.  Chunks may still be in flight on return. */
+extern int
+chunkpipe_copy_var(chunkpipe_t *pipe, int igrp, int varid, int ogrp, int ovarid);
+
+/* Write all chunks still in flight */
+extern int
+chunkpipe_flush(chunkpipe_t *pipe);
+
+/* Flush and release the pipeline */
+extern int
+chunkpipe_free(chunkpipe_t *pipe);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _CHUNKPIPE_H_ */
@@ -28,6 +28,7 @@
 #include "ncdump.h"
 #include "isnan.h"
 #include "nctime0.h"
+#include "numfmt.h"
 
 static float float_eps;
 static double double_eps;
@@ -212,6 +213,31 @@ sbuf_catb(safebuf_t *s1, const safebuf_t *s2) {
     assert(SAFEBUF_CHECK(s1));
 }
 
+/* Copy first n bytes of s2, which must not contain a null, to safe
+ * buffer, growing if necessary.  Cheaper than sbuf_cpy() when the
+ * length is already known. */
+void
+sbuf_cpyn(safebuf_t *sb, const char *s2, size_t n) {
+    assert(SAFEBUF_CHECK(sb));
+    sbuf_grow(sb, 1 + n);
+    memcpy(sb->buf, s2, n);
+    sb->buf[n] = '\0';
+    sb->cl = n;
+    assert(SAFEBUF_CHECK(sb));
+}
+
+/* Concatenate first n bytes of s2, which must not contain a null, to
+ * end of string in safe buffer, growing if necessary */
+void
+sbuf_catn(safebuf_t *sb, const char *s2, size_t n) {
+    assert(SAFEBUF_CHECK(sb));
+    sbuf_grow(sb, 1 + sb->cl + n);
+    memcpy(sb->buf + sb->cl, s2, n);
+    sb->cl += n;
+    sb->buf[sb->cl] = '\0';
+    assert(SAFEBUF_CHECK(sb));
+}
+
 /* Return length of string in sbuf */
 int
 sbuf_len(const safebuf_t *sb) {
@@ -1215,6 +1241,54 @@ ncdouble_val_tostring(const ncvar_t *varp, safebuf_t *sfbf, const void *valp) {
     return sbuf_len(sfbf);
 }
 
+/* Faster equivalents of the above for variables printed with the
+ * default format for their type, see set_tostring_func() */
+#define DEFINE_INT_VAL_TOSTRING_FAST(name, ctype, conv)			\
+static int								\
+name(const ncvar_t *varp, safebuf_t *sfbf, const void *valp) {	\
+    char sout[NUMFMT_LEN];						\
+    int len = conv(sout, *(const ctype *)valp);			\
+    sbuf_cpyn(sfbf, sout, (size_t)len);				\
+    return len;							\
+}
+
+DEFINE_INT_VAL_TOSTRING_FAST(ncbyte_val_tostring_fast, signed char, numfmt_lld)
+DEFINE_INT_VAL_TOSTRING_FAST(ncshort_val_tostring_fast, short, numfmt_lld)
+DEFINE_INT_VAL_TOSTRING_FAST(ncint_val_tostring_fast, int, numfmt_lld)
+DEFINE_INT_VAL_TOSTRING_FAST(ncubyte_val_tostring_fast, unsigned char, numfmt_llu)
+DEFINE_INT_VAL_TOSTRING_FAST(ncushort_val_tostring_fast, unsigned short, numfmt_llu)
+DEFINE_INT_VAL_TOSTRING_FAST(ncuint_val_tostring_fast, unsigned int, numfmt_llu)
+DEFINE_INT_VAL_TOSTRING_FAST(ncint64_val_tostring_fast, long long, numfmt_lld)
+DEFINE_INT_VAL_TOSTRING_FAST(ncuint64_val_tostring_fast, unsigned long long, numfmt_llu)
+
+static int
+ncfloat_val_tostring_fast(const ncvar_t *varp, safebuf_t *sfbf, const void *valp) {
+    char sout[PRIM_LEN];
+    float vv = *(float *)valp;
+    if(isfinite(vv)) {
+	int len = numfmt_g(sout, vv, numfmt_gprec(varp->fmt));
+	sbuf_cpyn(sfbf, sout, (size_t)len);
+    } else {
+	float_special_tostring(vv, sout);
+	sbuf_cpy(sfbf, sout);
+    }
+    return sbuf_len(sfbf);
+}
+
+static int
+ncdouble_val_tostring_fast(const ncvar_t *varp, safebuf_t *sfbf, const void *valp) {
+    char sout[PRIM_LEN];
+    double vv = *(double *)valp;
+    if(isfinite(vv)) {
+	int len = numfmt_g(sout, vv, numfmt_gprec(varp->fmt));
+	sbuf_cpyn(sfbf, sout, (size_t)len);
+    } else {
+	double_special_tostring(vv, sout);
+	sbuf_cpy(sfbf, sout);
+    }
+    return sbuf_len(sfbf);
+}
+
 /* Convert value of any numeric type to a double.  Beware, this may
  * lose precision for values of type NC_INT64 or NC_UINT64 */
 static
@@ -1417,8 +1491,35 @@ set_tostring_func(ncvar_t *varp) {
 	varp->val_tostring = (val_tostring_func) nctime_val_tostring;
 	return;
     }
+    val_tostring_func fast_tostring_funcs[] = {
+	ncbyte_val_tostring_fast,
+	ncchar_val_tostring,
+	ncshort_val_tostring_fast,
+	ncint_val_tostring_fast,
+	ncfloat_val_tostring_fast,
+	ncdouble_val_tostring_fast,
+	ncubyte_val_tostring_fast,
+	ncushort_val_tostring_fast,
+	ncuint_val_tostring_fast,
+	ncint64_val_tostring_fast,
+	ncuint64_val_tostring_fast,
+	ncstring_val_tostring
+    };
     if( !is_user_defined_type(varp->type) ) {
 	varp->val_tostring = tostring_funcs[varp->type - 1];
+	/* Avoid printf for the formats numfmt reproduces exactly */
+	switch(varp->type) {
+	case NC_FLOAT: case NC_DOUBLE:
+	    if(numfmt_gprec(varp->fmt) > 0)
+		varp->val_tostring = fast_tostring_funcs[varp->type - 1];
+	    break;
+	case NC_CHAR: case NC_STRING:
+	    break;
+	default:
+	    if(varp->fmt && strcmp(varp->fmt, get_default_fmt(varp->type)) == 0)
+		varp->val_tostring = fast_tostring_funcs[varp->type - 1];
+	    break;
+	}
 	return;
     }
 #ifdef USE_NETCDF4
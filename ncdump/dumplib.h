@@ -98,6 +98,12 @@ void sbuf_cat(safebuf_t *sbuf, const char *s2);
 /* Concatenate sbuf s2 to end of sbuf s1, growing if necessary */
 void sbuf_catb(safebuf_t *s1, const safebuf_t *s2);
 
+/* Copy n bytes of s2 to buffer in sbuf, growing if necessary */
+void sbuf_cpyn(safebuf_t *sbuf, const char *s2, size_t n);
+
+/* Concatenate n bytes of s2 to end of buffer in sbuf, growing if necessary */
+void sbuf_catn(safebuf_t *sbuf, const char *s2, size_t n);
+
 /* Return length of the string in sbuf */
 int sbuf_len(const safebuf_t *sbuf);
 
@@ -29,6 +29,7 @@
 #include "utils.h"
 #include "chunkspec.h"
 #include "dimmap.h"
+#include "chunkpipe.h"
 #include "nccomps.h"
 #include "list.h"
 #include "ncpathmgr.h"
@@ -153,6 +154,8 @@ static int option_nlvars = 0; /* Number of variables specified with -v * option
 static char** option_lvars = 0;		/* list of variable names specified with -v
 					 * option on command line */
 static bool_t option_varstruct = false;	  /* if -v set, copy structure for non-selected vars */
+static size_t option_nthreads = 1; /* default, copy on one thread */
+static chunkpipe_t* pipeline = NULL; /* for -j, if output is netCDF-4 */
 static int option_compute_chunkcaches = 0; /* default, don't try still flaky estimate of
 					    * chunk cache for each variable */
 /* get group id in output corresponding to group igrp in input,
@@ -1610,6 +1613,25 @@ copy_var_data(int igrp, int varid, int ogrp)
     /* get corresponding output variable */
     NC_CHECK(nc_inq_varname(igrp, varid, varname));
     NC_CHECK(nc_inq_varid(ogrp, varname, &ovarid));
+#ifdef USE_NETCDF4
+    /* If the output variable is stored like the input variable (same
+     * chunking and filters), copy the stored chunks as they are */
+    stat = nc_copy_var_raw(igrp, varid, ogrp, ovarid);
+    if(stat != NC_EINVAL) {
+	NC_CHECK(stat);
+	return stat;
+    }
+    stat = NC_NOERR;
+#endif
+    /* With -j, let worker threads compress the output chunks */
+    if(pipeline) {
+	stat = chunkpipe_copy_var(pipeline, igrp, varid, ogrp, ovarid);
+	if(stat != NC_EINVAL) {
+	    NC_CHECK(stat);
+	    return stat;
+	}
+	stat = NC_NOERR;
+    }
     NC_CHECK(nc_inq_vartype(igrp, varid, &vartype));
     value_size = val_size(igrp, varid);
     if(value_size > option_copy_buffer_size) {
@@ -2112,11 +2134,22 @@ copy(char* infile, char* outfile)
     NC_CHECK(copy_schema(igrp, ogrp));
     NC_CHECK(nc_enddef(ogrp));
 
+    /* With -j, compress netCDF-4 output chunks in parallel. The
+     * pipeline works a variable at a time, so the record-at-a-time
+     * special case below is not used. */
+    if(option_nthreads > 1 && (outkind == NC_FORMAT_NETCDF4
+			       || outkind == NC_FORMAT_NETCDF4_CLASSIC))
+	NC_CHECK(chunkpipe_new(option_nthreads, &pipeline));
+
     /* For performance, special case netCDF-3 input or output file with record
      * variables, to copy a record-at-a-time instead of a
      * variable-at-a-time. */
     /* TODO: check that these special cases work with -v option */
-    if(nc3_special_case(igrp, inkind)) {
+    if(pipeline) {
+	NC_CHECK(copy_data(igrp, ogrp));
+	NC_CHECK(chunkpipe_free(pipeline));
+	pipeline = NULL;
+    } else if(nc3_special_case(igrp, inkind)) {
 	size_t nfixed_vars, nrec_vars;
 	int *fixed_varids;
 	int *rec_varids;
@@ -2209,6 +2242,7 @@ usage(void)
   [-F filterspec] specify a compression algorithm to apply to an output variable (may be repeated).\n\
   [-Ln]     set log level to n (>= 0); ignored if logging isn't enabled.\n\
   [-Mn]     set minimum chunk size to n bytes (n >= 0)\n\
+  [-j n]    compress netCDF-4 output chunks on n threads\n\
   infile    name of netCDF input file\n\
   outfile   name for netCDF output file\n"
 
@@ -2216,7 +2250,7 @@ usage(void)
     /* [-x]      use experimental computed estimates for variable-specific chunk caches\n\ */
 
 
-    error("%s [-k kind] [-[3|4|6|7]] [-d n] [-s] [-c chunkspec] [-u] [-w] [-[v|V] varlist] [-[g|G] grplist] [-m n] [-h n] [-e n] [-r] [-F filterspec] [-Ln] [-Mn] infile outfile\n%s\nnetCDF library version %s",
+    error("%s [-k kind] [-[3|4|6|7]] [-d n] [-s] [-c chunkspec] [-u] [-w] [-[v|V] varlist] [-[g|G] grplist] [-m n] [-h n] [-e n] [-r] [-F filterspec] [-Ln] [-Mn] [-j n] infile outfile\n%s\nnetCDF library version %s",
 	  progname, USAGE, nc_inq_libvers());
 
 }
@@ -2240,7 +2274,7 @@ main(int argc, char**argv)
     }
 
     opterr = 1;
-    while ((c = getopt(argc, argv, "k:3467d:sum:c:h:e:rwxg:G:v:V:F:L:M:")) != -1) {
+    while ((c = getopt(argc, argv, "k:3467d:sum:c:h:e:rwxg:G:v:V:F:L:M:j:")) != -1) {
 	switch(c) {
         case 'k': /* for specifying variant of netCDF format to be generated
                      Format names:
@@ -2396,6 +2430,15 @@ main(int argc, char**argv)
 	    error("-M requires netcdf-4");
 #endif
 
+	case 'j':		/* number of threads compressing output chunks */
+	{
+	    long n = strtol(optarg, NULL, 10);
+	    if(n < 1)
+		error("invalid number of threads: %s", optarg);
+	    option_nthreads = (size_t)n;
+	    break;
+	}
+
 	default:
 	    usage();
         }
@@ -0,0 +1,294 @@
+/*********************************************************************
+ *   Copyright 2018, UCAR/Unidata
+ *   See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ *********************************************************************/
+
+/*
+ * Fast formatting of integer and floating-point data values for
+ * ncdump.  The output is byte-for-byte what printf() produces for the
+ * default formats ("%d", "%u", "%lld", "%llu", "%.7g", "%.15g", ...),
+ * so CDL output does not change; only the time spent producing it.
+ *
+ * Integers are converted two digits at a time from a table.  Floating
+ * point values are scaled by an exact power of ten to the requested
+ * number of significant digits, with the rounding error of the scaling
+ * recovered by an error-free product, so the digits can be rounded
+ * exactly as printf() does.  Values needing a power of ten that is not
+ * exactly representable, or lying too near a rounding boundary, are
+ * passed to snprintf() instead.
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "numfmt.h"
+
+/* The exact scaling below assumes double arithmetic is done in double
+ * precision, not in an extended precision register. */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0 && FLT_EVAL_METHOD != 1
+#define NUMFMT_NO_FAST_G
+#endif
+
+/* Distance from one half within which a scaled fraction is considered
+ * too close to call; far larger than the error of the computation */
+#define TIE_MARGIN 1e-9
+
+/* Powers of ten exactly representable as doubles */
+#define MAX_EXACT_POW10 22
+static const double pow10tab[MAX_EXACT_POW10 + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+};
+
+static const unsigned long long pow10int[NUMFMT_MAX_PREC + 2] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL
+};
+
+static const char digitpairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int
+numfmt_gprec(const char *fmt)
+{
+    int prec = 0;
+    const char *cp;
+
+    if(fmt == NULL || fmt[0] != '%' || fmt[1] != '.')
+	return -1;
+    for(cp = fmt + 2; *cp >= '0' && *cp <= '9'; cp++) {
+	prec = 10 * prec + (*cp - '0');
+	if(prec > NUMFMT_MAX_PREC)
+	    return -1;
+    }
+    if(cp == fmt + 2 || cp[0] != 'g' || cp[1] != '\0' || prec < 1)
+	return -1;
+    return prec;
+}
+
+/* Write the decimal digits of v, most significant first, into buf
+ * (not null terminated); return the number of digits. */
+static int
+udigits(char *buf, unsigned long long v)
+{
+    char tmp[NUMFMT_LEN];
+    char *cp = tmp + sizeof(tmp);
+    int n;
+
+    while(v >= 100) {
+	unsigned int r = (unsigned int)(v % 100);
+	v /= 100;
+	cp -= 2;
+	memcpy(cp, &digitpairs[2 * r], 2);
+    }
+    if(v >= 10) {
+	cp -= 2;
+	memcpy(cp, &digitpairs[2 * v], 2);
+    } else {
+	*--cp = (char)('0' + v);
+    }
+    n = (int)(tmp + sizeof(tmp) - cp);
+    memcpy(buf, cp, (size_t)n);
+    return n;
+}
+
+int
+numfmt_llu(char *buf, unsigned long long v)
+{
+    int n = udigits(buf, v);
+    buf[n] = '\0';
+    return n;
+}
+
+int
+numfmt_lld(char *buf, long long v)
+{
+    if(v < 0) {
+	/* negate in unsigned arithmetic, so LLONG_MIN is fine */
+	buf[0] = '-';
+	return 1 + numfmt_llu(buf + 1, 0ULL - (unsigned long long)v);
+    }
+    return numfmt_llu(buf, (unsigned long long)v);
+}
+
+#ifndef NUMFMT_NO_FAST_G
+
+/* Error-free product: a * b == *hi + *lo exactly (Dekker) */
+static void
+two_product(double a, double b, double *hi, double *lo)
+{
+#ifdef FP_FAST_FMA
+    *hi = a * b;
+    *lo = fma(a, b, -*hi);
+#else
+    const double split = 134217729.0; /* 2^27 + 1 */
+    double t, ah, al, bh, bl;
+    t = split * a;
+    ah = t - (t - a);
+    al = a - ah;
+    t = split * b;
+    bh = t - (t - b);
+    bl = b - bh;
+    *hi = a * b;
+    *lo = ((ah * bh - *hi) + ah * bl + al * bh) + al * bl;
+#endif
+}
+
+/* Find the prec significant decimal digits of a > 0, correctly
+ * rounded, as an integer *digp in [10^(prec-1), 10^prec), and the
+ * decimal exponent *expp of the leading digit.  Returns 0 if that
+ * cannot be done exactly, in which case the caller uses snprintf(). */
+static int
+scale_digits(double a, int prec, unsigned long long *digp, int *expp)
+{
+    int bexp, e, tries;
+
+    /* With a = m * 2^bexp, 0.5 <= m < 1, the decimal exponent is
+     * floor((bexp - 1) * log10(2)) or one more */
+    (void)frexp(a, &bexp);
+    e = (int)floor((bexp - 1) * 0.30102999566398120);
+    if(e + 1 >= 0 && e + 1 <= MAX_EXACT_POW10 && a >= pow10tab[e + 1])
+	e++;
+
+    /* an estimate still one low is corrected by the loop */
+    for(tries = 0; tries < 3; tries++) {
+	int k = prec - 1 - e;
+	double hi, lo, n, frac;
+	unsigned long long dig;
+
+	if(k > MAX_EXACT_POW10 || k < -MAX_EXACT_POW10)
+	    return 0;
+	if(k >= 0) {
+	    two_product(a, pow10tab[k], &hi, &lo);
+	} else {
+	    /* a / 10^-k == hi + r / 10^-k, with the remainder r exact */
+	    double p = pow10tab[-k], ph, pl, r;
+	    hi = a / p;
+	    two_product(hi, p, &ph, &pl);
+	    r = (a - ph) - pl;
+	    lo = r / p;
+	}
+	n = floor(hi);
+	frac = (hi - n) + lo;
+	if(frac < 0) {
+	    n -= 1;
+	    frac += 1;
+	} else if(frac >= 1) {
+	    n += 1;
+	    frac -= 1;
+	}
+	if(n >= (double)pow10int[prec]) {
+	    e++;
+	    continue;
+	}
+	if(n < (double)pow10int[prec - 1]) {
+	    e--;
+	    continue;
+	}
+	if(fabs(frac - 0.5) < TIE_MARGIN)
+	    return 0;
+	dig = (unsigned long long)n;
+	if(frac > 0.5)
+	    dig++;
+	if(dig == pow10int[prec]) { /* rounded up to the next power */
+	    dig = pow10int[prec - 1];
+	    e++;
+	}
+	*digp = dig;
+	*expp = e;
+	return 1;
+    }
+    return 0;
+}
+
+int
+numfmt_g(char *buf, double v, int prec)
+{
+    char digs[NUMFMT_LEN];
+    unsigned long long dig;
+    int e, nd, pos = 0;
+
+    if(prec < 1 || prec > NUMFMT_MAX_PREC || !isfinite(v))
+	return snprintf(buf, NUMFMT_LEN, "%.*g", prec, v);
+    if(signbit(v)) {
+	buf[pos++] = '-';
+	v = -v;
+    }
+    if(v == 0) {
+	buf[pos++] = '0';
+	buf[pos] = '\0';
+	return pos;
+    }
+    if(!scale_digits(v, prec, &dig, &e))
+	return snprintf(buf, NUMFMT_LEN, "%.*g", prec, pos ? -v : v);
+
+    /* %g drops trailing zeros of the significand */
+    while(dig % 10 == 0)
+	dig /= 10;
+    nd = udigits(digs, dig);
+
+    if(e < -4 || e >= prec) {
+	/* d[.ddd]e+XX, at least two exponent digits */
+	unsigned int ae = (unsigned int)(e < 0 ? -e : e);
+	buf[pos++] = digs[0];
+	if(nd > 1) {
+	    buf[pos++] = '.';
+	    memcpy(buf + pos, digs + 1, (size_t)(nd - 1));
+	    pos += nd - 1;
+	}
+	buf[pos++] = 'e';
+	buf[pos++] = e < 0 ? '-' : '+';
+	if(ae >= 100)
+	    buf[pos++] = (char)('0' + ae / 100);
+	memcpy(buf + pos, &digitpairs[2 * (ae % 100)], 2);
+	pos += 2;
+    } else if(e >= 0) {
+	/* e+1 integer digits, padded with zeros if fewer were kept */
+	int nint = e + 1;
+	if(nd <= nint) {
+	    memcpy(buf + pos, digs, (size_t)nd);
+	    memset(buf + pos + nd, '0', (size_t)(nint - nd));
+	    pos += nint;
+	} else {
+	    memcpy(buf + pos, digs, (size_t)nint);
+	    pos += nint;
+	    buf[pos++] = '.';
+	    memcpy(buf + pos, digs + nint, (size_t)(nd - nint));
+	    pos += nd - nint;
+	}
+    } else {
+	/* 0.000ddd */
+	buf[pos++] = '0';
+	buf[pos++] = '.';
+	memset(buf + pos, '0', (size_t)(-e - 1));
+	pos += -e - 1;
+	memcpy(buf + pos, digs, (size_t)nd);
+	pos += nd;
+    }
+    buf[pos] = '\0';
+    return pos;
+}
+
+#else /* NUMFMT_NO_FAST_G */
+
+int
+numfmt_g(char *buf, double v, int prec)
+{
+    return snprintf(buf, NUMFMT_LEN, "%.*g", prec, v);
+}
+
+#endif /* NUMFMT_NO_FAST_G */
@@ -0,0 +1,49 @@
+/*********************************************************************
+ *   Copyright 2018, UCAR/Unidata
+ *   See netcdf/COPYRIGHT file for copying and redistribution conditions.
+ *********************************************************************/
+
+#ifndef _NUMFMT_H_
+#define _NUMFMT_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * Fast replacements for the snprintf() calls ncdump makes for every
+ * data value printed with one of its default formats.  Each function
+ * writes exactly the characters snprintf() would, followed by a null,
+ * into buf, which must hold at least NUMFMT_LEN bytes, and returns the
+ * number of characters written (not counting the null).
+ */
+#define NUMFMT_LEN 32
+
+/* Largest precision handled by numfmt_g(); larger ones use snprintf() */
+#define NUMFMT_MAX_PREC 15
+
+/* If fmt is exactly "%.Ng" with 1 <= N <= NUMFMT_MAX_PREC, return N,
+ * otherwise return -1. */
+extern int
+numfmt_gprec(const char *fmt);
+
+/* Same as snprintf(buf, NUMFMT_LEN, "%lld", v) */
+extern int
+numfmt_lld(char *buf, long long v);
+
+/* Same as snprintf(buf, NUMFMT_LEN, "%llu", v) */
+extern int
+numfmt_llu(char *buf, unsigned long long v);
+
+/* Same as snprintf(buf, NUMFMT_LEN, "%.*g", prec, v), for finite v
+ * and 1 <= prec <= NUMFMT_MAX_PREC.  The digits are exact and
+ * correctly rounded; the rare values lying too close to a rounding
+ * boundary to decide cheaply are handed to snprintf(). */
+extern int
+numfmt_g(char *buf, double v, int prec);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _NUMFMT_H_ */
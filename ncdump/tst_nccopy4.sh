@@ -85,6 +85,32 @@ for i in $TESTFILES0 ; do
     diff copy_of_$i.cdl tmp_ncc4.cdl
     rm copy_of_$i.nc copy_of_$i.cdl tmp_ncc4.cdl
 done
+
+echo "*** Testing nccopy -j4 -d1 -s on ncdump/*.nc files"
+for i in $TESTFILES0 ; do
+    echo "*** Test nccopy -j4 -d1 -s $i.nc copy_of_$i.nc ..."
+    ${NCCOPY} -j4 -d1 -s $i.nc copy_of_$i.nc
+    ${NCDUMP} -n copy_of_$i $i.nc > tmp_ncc4.cdl
+    ${NCDUMP} copy_of_$i.nc > copy_of_$i.cdl
+    diff copy_of_$i.cdl tmp_ncc4.cdl
+    rm copy_of_$i.nc copy_of_$i.cdl tmp_ncc4.cdl
+done
+echo "*** Test nccopy -j3 with edge chunks matches nccopy without -j"
+${NCGEN} -b -o tst_pipe.nc $srcdir/tst_bug321.cdl
+${NCCOPY} -k nc7 -d1 -s -c"lat/3,lon/3" tst_pipe.nc tmp_pipe1.nc
+${NCCOPY} -j3 -k nc7 -d1 -s -c"lat/3,lon/3" tst_pipe.nc tmp_pipe3.nc
+${NCDUMP} -n tst_pipe tmp_pipe1.nc > tmp_pipe1.cdl
+${NCDUMP} -n tst_pipe tmp_pipe3.nc > tmp_pipe3.cdl
+diff tmp_pipe1.cdl tmp_pipe3.cdl
+rm tst_pipe.nc tmp_pipe1.nc tmp_pipe3.nc tmp_pipe1.cdl tmp_pipe3.cdl
+echo "*** Test HDF5 reads back the values of chunks filtered by nccopy -j"
+${execdir}/tst_pipedata
+${NCCOPY} -j4 tst_pipedata.nc tmp_pipedata.nc
+${execdir}/tst_pipedata tst_pipedata.nc tmp_pipedata.nc
+${NCCOPY} -j3 -d1 -s -c"rec/2,y/10,x/6" tst_pipedata.nc tmp_pipedata.nc
+${execdir}/tst_pipedata tst_pipedata.nc tmp_pipedata.nc
+rm tst_pipedata.nc tmp_pipedata.nc
+
 ${execdir}/tst_chunking
 echo "*** Test that nccopy -c can chunk and unchunk files"
 ${NCCOPY} -M0 tst_chunking.nc tmp_ncc4.nc
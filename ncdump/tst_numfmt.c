@@ -0,0 +1,249 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata. See COPYRIGHT file for
+   conditions of use. See www.unidata.ucar.edu for more info.
+
+   Test that the fast value formatting used by ncdump produces exactly
+   what printf() does for ncdump's default formats, and report how
+   long each takes.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <time.h>
+#include "err_macros.h"
+#include "numfmt.h"
+
+#define NRANDOM 200000		/* random values per precision */
+#define NTIME 2000000		/* values formatted for timing */
+
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ULL;
+
+/* xorshift64*, so the test does the same thing everywhere */
+static unsigned long long
+rng(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+/* A finite double from a random bit pattern */
+static double
+random_bits_double(void)
+{
+    double d;
+    do {
+	unsigned long long u = rng();
+	memcpy(&d, &u, sizeof(d));
+    } while(!isfinite(d));
+    return d;
+}
+
+/* A double of ordinary magnitude, as found in most data */
+static double
+random_data_double(void)
+{
+    double m = (double)(rng() >> 11) / 9007199254740992.0;
+    int e = (int)(rng() % 41) - 20;
+    return (rng() & 1 ? -m : m) * pow(10.0, e);
+}
+
+/* A decimal with few digits, often exactly halfway at some precision */
+static double
+random_short_decimal(void)
+{
+    long long n = (long long)(rng() % 2000001) - 1000000;
+    int e = (int)(rng() % 21) - 10;
+    return (double)n * pow(10.0, e) + (double)(rng() % 2) * 0.5 * pow(10.0, e);
+}
+
+static int
+check_g(double v, int prec)
+{
+    char want[NUMFMT_LEN * 2], got[NUMFMT_LEN];
+    int nwant, ngot;
+    nwant = snprintf(want, sizeof(want), "%.*g", prec, v);
+    ngot = numfmt_g(got, v, prec);
+    if(nwant != ngot || strcmp(want, got) != 0) {
+	printf("\n%.17g with precision %d: expected \"%s\", got \"%s\"\n",
+	       v, prec, want, got);
+	return 1;
+    }
+    return 0;
+}
+
+static int
+check_lld(long long v)
+{
+    char want[NUMFMT_LEN], got[NUMFMT_LEN];
+    int nwant, ngot;
+    nwant = snprintf(want, sizeof(want), "%lld", v);
+    ngot = numfmt_lld(got, v);
+    if(nwant != ngot || strcmp(want, got) != 0) {
+	printf("\n%lld: got \"%s\"\n", v, got);
+	return 1;
+    }
+    return 0;
+}
+
+static int
+check_llu(unsigned long long v)
+{
+    char want[NUMFMT_LEN], got[NUMFMT_LEN];
+    int nwant, ngot;
+    nwant = snprintf(want, sizeof(want), "%llu", v);
+    ngot = numfmt_llu(got, v);
+    if(nwant != ngot || strcmp(want, got) != 0) {
+	printf("\n%llu: got \"%s\"\n", v, got);
+	return 1;
+    }
+    return 0;
+}
+
+static double
+seconds(clock_t t0)
+{
+    return (double)(clock() - t0) / CLOCKS_PER_SEC;
+}
+
+int
+main(int argc, char **argv)
+{
+    printf("\n*** Testing fast numeric formatting for ncdump.\n");
+    printf("*** testing format parsing...");
+    {
+	if(numfmt_gprec("%.7g") != 7) ERR;
+	if(numfmt_gprec("%.15g") != 15) ERR;
+	if(numfmt_gprec("%.1g") != 1) ERR;
+	if(numfmt_gprec("%.0g") != -1) ERR;
+	if(numfmt_gprec("%.16g") != -1) ERR;
+	if(numfmt_gprec("%.7f") != -1) ERR;
+	if(numfmt_gprec("%#.7g") != -1) ERR;
+	if(numfmt_gprec("%.7gf") != -1) ERR;
+	if(numfmt_gprec("%.g") != -1) ERR;
+	if(numfmt_gprec("%d") != -1) ERR;
+	if(numfmt_gprec(NULL) != -1) ERR;
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing integers...");
+    {
+	long long sedge[] = {0, 1, -1, 9, 10, 99, 100, -100, 127, -128,
+			     32767, -32768, INT_MAX, INT_MIN, LLONG_MAX, LLONG_MIN};
+	unsigned long long uedge[] = {0, 1, 9, 10, 99, 100, 255, 65535,
+				      UINT_MAX, ULLONG_MAX};
+	size_t i;
+	int k;
+	for(i = 0; i < sizeof(sedge) / sizeof(sedge[0]); i++)
+	    if(check_lld(sedge[i])) ERR;
+	for(i = 0; i < sizeof(uedge) / sizeof(uedge[0]); i++)
+	    if(check_llu(uedge[i])) ERR;
+	for(k = 0; k < NRANDOM; k++) {
+	    unsigned long long u = rng() >> (rng() % 64);
+	    if(check_llu(u)) ERR;
+	    if(check_lld((long long)u)) ERR;
+	}
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing special floating point values...");
+    {
+	double edge[] = {0.0, -0.0, 1.0, -1.0, 0.5, 0.1, 1e-5, 1e-4,
+			 0.00012345, 9.5, 99.5, 999999.5, 9999999.5, 1e15,
+			 9.999999999999999e14, 1e16, 1e22, 1e23, 1e-22, 1e-23,
+			 123456789012345678.0, 3.141592653589793,
+			 DBL_MAX, -DBL_MAX, DBL_MIN, DBL_MIN / 4, DBL_EPSILON,
+			 FLT_MAX, FLT_MIN, 9.96920996838687e+36, -2147483647.0,
+			 0.15, 0.25, 0.35, 2.5, 1.5e-4, 1.5e-5};
+	size_t i;
+	int prec;
+	for(prec = 1; prec <= NUMFMT_MAX_PREC; prec++)
+	    for(i = 0; i < sizeof(edge) / sizeof(edge[0]); i++) {
+		if(check_g(edge[i], prec)) ERR;
+		if(check_g((float)edge[i], prec)) ERR;
+	    }
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing random doubles at each precision...");
+    {
+	int prec, k;
+	for(prec = 1; prec <= NUMFMT_MAX_PREC; prec++)
+	    for(k = 0; k < NRANDOM / 4; k++) {
+		if(check_g(random_bits_double(), prec)) ERR;
+		if(check_g(random_data_double(), prec)) ERR;
+		if(check_g(random_short_decimal(), prec)) ERR;
+	    }
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing random floats...");
+    {
+	int k;
+	for(k = 0; k < NRANDOM; k++) {
+	    float f;
+	    unsigned int u = (unsigned int)(rng() >> 32);
+	    memcpy(&f, &u, sizeof(f));
+	    if(!isfinite(f))
+		continue;
+	    if(check_g(f, 7)) ERR;
+	    if(check_g(f, 9)) ERR;
+	    if(check_g((float)random_data_double(), 7)) ERR;
+	}
+    }
+    SUMMARIZE_ERR;
+    printf("*** timing ncdump default formats against snprintf...\n");
+    {
+	double *dvals = malloc(NTIME * sizeof(double));
+	int *ivals = malloc(NTIME * sizeof(int));
+	char buf[NUMFMT_LEN * 2];
+	size_t total = 0;
+	clock_t t0;
+	int k;
+	double tsys, tfast;
+
+	if(!dvals || !ivals) ERR;
+	for(k = 0; k < NTIME; k++) {
+	    dvals[k] = random_data_double();
+	    ivals[k] = (int)rng();
+	}
+
+	t0 = clock();
+	for(k = 0; k < NTIME; k++)
+	    total += (size_t)snprintf(buf, sizeof(buf), "%.7g", (float)dvals[k]);
+	tsys = seconds(t0);
+	t0 = clock();
+	for(k = 0; k < NTIME; k++)
+	    total += (size_t)numfmt_g(buf, (float)dvals[k], 7);
+	tfast = seconds(t0);
+	printf("      float  %%.7g:  snprintf %.3fs, numfmt %.3fs\n", tsys, tfast);
+
+	t0 = clock();
+	for(k = 0; k < NTIME; k++)
+	    total += (size_t)snprintf(buf, sizeof(buf), "%.15g", dvals[k]);
+	tsys = seconds(t0);
+	t0 = clock();
+	for(k = 0; k < NTIME; k++)
+	    total += (size_t)numfmt_g(buf, dvals[k], 15);
+	tfast = seconds(t0);
+	printf("      double %%.15g: snprintf %.3fs, numfmt %.3fs\n", tsys, tfast);
+
+	t0 = clock();
+	for(k = 0; k < NTIME; k++)
+	    total += (size_t)snprintf(buf, sizeof(buf), "%d", ivals[k]);
+	tsys = seconds(t0);
+	t0 = clock();
+	for(k = 0; k < NTIME; k++)
+	    total += (size_t)numfmt_lld(buf, ivals[k]);
+	tfast = seconds(t0);
+	printf("      int    %%d:    snprintf %.3fs, numfmt %.3fs\n", tsys, tfast);
+
+	if(total == 0) ERR;
+	free(dvals);
+	free(ivals);
+    }
+    SUMMARIZE_ERR;
+    FINAL_RESULTS;
+}
@@ -0,0 +1,151 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata.  See COPYRIGHT file for
+   conditions of use. See www.unidata.ucar.edu for more info.
+
+   Check the chunks nccopy -j filters itself. Run without arguments,
+   this creates a shuffled and deflated file of variables of several
+   type sizes, with edge chunks and a record dimension. Run with an
+   input and an output file, it reads every variable of both through
+   nc_get_var, so HDF5 decodes the chunks of the output, and requires
+   the values to be identical and the output to be shuffled and
+   deflated. The values use every bit, so a difference cannot be
+   hidden by the precision ncdump prints.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netcdf.h>
+#include <nc_tests.h>
+#include "err_macros.h"
+
+#define FILE_NAME "tst_pipedata.nc"
+#define NDIMS 2
+#define NREC 5
+#define NY 29
+#define NX 31
+#define DEFLATE_LEVEL 3
+
+static const nc_type types[] = {NC_UBYTE, NC_SHORT, NC_INT, NC_FLOAT, NC_DOUBLE, NC_INT64};
+#define NTYPES (sizeof(types) / sizeof(types[0]))
+
+static unsigned int seed = 1;
+
+/* Pseudo-random bytes, so shuffle and deflate have work to do */
+static void
+fill(unsigned char *data, size_t n)
+{
+   size_t i;
+   for (i = 0; i < n; i++)
+   {
+      seed = seed * 1103515245u + 12345u;
+      data[i] = (unsigned char)(seed >> 16);
+   }
+   /* Runs of repeated values, so the chunks also compress */
+   for (i = 0; i < n / 2; i++)
+      data[i] = (unsigned char)(i / 64);
+}
+
+static int
+create(void)
+{
+   int ncid, fixdims[NDIMS], recdims[NDIMS], varid;
+   size_t chunks[NDIMS] = {8, 7};
+   char name[NC_MAX_NAME + 1];
+   unsigned char *data;
+   size_t t;
+
+   if (!(data = malloc(NREC * NY * NX * sizeof(long long)))) ERR;
+   if (nc_create(FILE_NAME, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   if (nc_def_dim(ncid, "rec", NC_UNLIMITED, &recdims[0])) ERR;
+   if (nc_def_dim(ncid, "y", NY, &fixdims[0])) ERR;
+   if (nc_def_dim(ncid, "x", NX, &fixdims[1])) ERR;
+   recdims[1] = fixdims[1];
+   for (t = 0; t < NTYPES; t++)
+   {
+      /* A fixed size and a record variable of each type */
+      snprintf(name, sizeof(name), "fix%d", (int)types[t]);
+      if (nc_def_var(ncid, name, types[t], NDIMS, fixdims, &varid)) ERR;
+      if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks)) ERR;
+      if (nc_def_var_deflate(ncid, varid, 1, 1, DEFLATE_LEVEL)) ERR;
+      snprintf(name, sizeof(name), "rec%d", (int)types[t]);
+      if (nc_def_var(ncid, name, types[t], NDIMS, recdims, &varid)) ERR;
+      if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks)) ERR;
+      if (nc_def_var_deflate(ncid, varid, 1, 1, DEFLATE_LEVEL)) ERR;
+   }
+   if (nc_enddef(ncid)) ERR;
+   for (varid = 0; varid < (int)(2 * NTYPES); varid++)
+   {
+      size_t start[NDIMS] = {0, 0}, count[NDIMS] = {NY, NX};
+      size_t size;
+      if (nc_inq_type(ncid, types[varid / 2], NULL, &size)) ERR;
+      if (varid % 2)
+         count[0] = NREC;
+      fill(data, count[0] * count[1] * size);
+      if (nc_put_vara(ncid, varid, start, count, data)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   free(data);
+   return 0;
+}
+
+/* Compare the values of every variable of two files, and check the
+   filters of the output */
+static int
+compare(const char *inpath, const char *outpath)
+{
+   int incid, outcid, nvars, onvars, varid;
+
+   if (nc_open(inpath, NC_NOWRITE, &incid)) ERR;
+   if (nc_open(outpath, NC_NOWRITE, &outcid)) ERR;
+   if (nc_inq_nvars(incid, &nvars)) ERR;
+   if (nc_inq_nvars(outcid, &onvars)) ERR;
+   if (nvars != onvars) ERR;
+   for (varid = 0; varid < nvars; varid++)
+   {
+      char name[NC_MAX_NAME + 1];
+      int ovarid, ndims, dimids[NC_MAX_VAR_DIMS], shuffle, deflate, level, d;
+      nc_type xtype;
+      size_t size, n = 1;
+      unsigned char *ivals, *ovals;
+
+      if (nc_inq_var(incid, varid, name, &xtype, &ndims, dimids, NULL)) ERR;
+      if (nc_inq_varid(outcid, name, &ovarid)) ERR;
+      if (nc_inq_type(incid, xtype, NULL, &size)) ERR;
+      for (d = 0; d < ndims; d++)
+      {
+         size_t len;
+         if (nc_inq_dimlen(incid, dimids[d], &len)) ERR;
+         n *= len;
+      }
+      if (nc_inq_var_deflate(outcid, ovarid, &shuffle, &deflate, &level)) ERR;
+      if (!shuffle || !deflate) ERR;
+      if (!(ivals = malloc(n * size + 1))) ERR;
+      if (!(ovals = malloc(n * size + 1))) ERR;
+      if (nc_get_var(incid, varid, ivals)) ERR;
+      if (nc_get_var(outcid, ovarid, ovals)) ERR;
+      if (memcmp(ivals, ovals, n * size)) ERR;
+      free(ivals);
+      free(ovals);
+   }
+   if (nc_close(incid)) ERR;
+   if (nc_close(outcid)) ERR;
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   if (argc == 3)
+   {
+      printf("*** checking the data of %s...", argv[2]);
+      if (compare(argv[1], argv[2])) ERR;
+   }
+   else
+   {
+      printf("*** creating %s...", FILE_NAME);
+      if (create()) ERR;
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
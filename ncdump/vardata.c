@@ -82,6 +82,33 @@ lput(const char *cp) {
 }
 
 
+/*
+ * Like lput(), but append the string in sb to the row buffer rb
+ * instead of writing it, so print_rows() can output a whole row of
+ * values with one write.
+ */
+static void
+lput_row(safebuf_t *rb, const safebuf_t *sb) {
+    int nn = sbuf_len(sb);
+    const char *cp = sbuf_str(sb);
+
+    if (nn+linep > max_line_len && nn > 2) {
+	int i;
+	int ind = indent_get();
+	sbuf_catn(rb, "\n", 1);
+	for (i = 0; i < ind; i++)
+	    sbuf_catn(rb, " ", 1);
+	sbuf_catn(rb, LINEPIND, strlen(LINEPIND));
+	linep = (int)strlen(LINEPIND) + ind;
+    }
+    sbuf_catn(rb, cp, (size_t)nn);
+    if (nn > 0 && cp[nn - 1] == '\n') {
+	linep = indent_get();
+    } else
+	linep += nn;
+}
+
+
 /*--------------------------------------------------------------------------*/
 
 /* Support function for print_att_times.
@@ -477,6 +504,10 @@ print_rows(
 	char *valp = vals;
 	bool_t lastrow;
 	int j;
+	safebuf_t *row = sbuf_new(); /* values of row, written at once */
+	/* Converting atomic values cannot fail, so their output can be
+	 * held back without losing any of it to an error exit */
+	bool_t buffer_row = !is_user_defined_type(vp->type);
 	if(formatting_specs.brief_data_cmnts && rank > 1 && ncols > 0) {
 	    annotate_brief(vp, cor, vdims);
 	}
@@ -493,12 +524,18 @@ print_rows(
 		    printf("%s, ", sb->buf);
 		    annotate (vp, cor, i);
 		} else {
-		    sbuf_cat(sb, ", ");
-		    lput(sbuf_str(sb));
+		    sbuf_catn(sb, ", ", 2);
+		    if (buffer_row)
+			lput_row(row, sb);
+		    else
+			lput(sbuf_str(sb));
 		}
 	    }
 	    print_any_val(sb, vp, (void *)valp);
 	}
+	if (sbuf_len(row) > 0)
+	    (void) fwrite(sbuf_str(row), 1, (size_t)sbuf_len(row), stdout);
+	sbuf_free(row);
         /* In case vals has memory hanging off e.g. vlen or string, make sure to reclaim it */
         NC_CHECK(nc_reclaim_data(ncid,vp->type,vals,ncols));
 
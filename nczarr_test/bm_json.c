@@ -0,0 +1,190 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   This program times the JSON code on consolidated metadata. A
+   .zmetadata text with a .zarray and a .zattrs entry per variable is
+   generated, then:
+   - parse: the text is parsed;
+   - lookup: every entry of the "metadata" dict is looked up by key,
+     in an order unrelated to the order of the dict;
+   - linear: a sample of the keys is looked up by scanning the pairs,
+     as every lookup did before dicts were indexed;
+   - insert: new entries are inserted and existing ones replaced;
+   - unparse: the tree is converted back to text.
+   The results of the lookups and inserts are checked.
+
+   Usage: bm_json [megabytes]
+   The size of the generated text, default 4; consolidated metadata
+   of 50 MB is a realistic large case.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "netcdf.h"
+#include "ncjson.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define DFALTMB 4
+#define NVARSPERGROUP 100
+#define NLINEAR 1000
+
+static double
+elapsed(struct timeval* t0)
+{
+   struct timeval t1;
+   gettimeofday(&t1, NULL);
+   return (double)(t1.tv_sec - t0->tv_sec) * 1e6 + (double)(t1.tv_usec - t0->tv_usec);
+}
+
+static void
+varkey(char* key, size_t len, size_t v, const char* object)
+{
+   snprintf(key, len, "g%zu/v%zu/%s", v / NVARSPERGROUP, v, object);
+}
+
+/* Append the entries of variable v to text */
+static size_t
+genvar(char* text, size_t v)
+{
+   char zarray[64], zattrs[64];
+   varkey(zarray, sizeof(zarray), v, ".zarray");
+   varkey(zattrs, sizeof(zattrs), v, ".zattrs");
+   return (size_t)sprintf(text,
+      "\"%s\": {\"chunks\": [10, 20], \"compressor\": null, \"dtype\": \"<f4\","
+      " \"fill_value\": 0, \"filters\": null, \"order\": \"C\", \"shape\": [100, 200],"
+      " \"zarr_format\": 2, \"dimension_separator\": \".\"},\n"
+      "\"%s\": {\"_ARRAY_DIMENSIONS\": [\"x\", \"y\"], \"units\": \"m\","
+      " \"long_name\": \"variable %zu\", \"_nczarr_array\": {\"dimension_references\":"
+      " [\"/x\", \"/y\"], \"storage\": \"chunked\"}},\n",
+      zarray, zattrs, v);
+}
+
+/* Check the .zattrs entry of variable v */
+static int
+checkvar(const NCjson* jmeta, size_t v)
+{
+   char key[64], name[64];
+   const NCjson* jattrs = NULL;
+   const NCjson* jname = NULL;
+   varkey(key, sizeof(key), v, ".zattrs");
+   snprintf(name, sizeof(name), "variable %zu", v);
+   if (NCJdictget(jmeta, key, &jattrs) || NCJsort(jattrs) != NCJ_DICT) return 0;
+   if (NCJdictget(jattrs, "long_name", &jname) || jname == NULL) return 0;
+   return strcmp(NCJstring(jname), name) == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   size_t mb = DFALTMB, nvars, textsize, pos, v, i;
+   char* text = NULL;
+   char* text2 = NULL;
+   NCjson* json = NULL;
+   NCjson* jmeta = NULL;
+   struct timeval t0;
+   double parse, lookup, linear, insert, unparse;
+
+   if (argc > 1) mb = (size_t)atol(argv[1]);
+   /* each variable takes about 430 bytes */
+   nvars = (mb << 20) / 430;
+   textsize = (nvars + 1) * 512;
+   if ((text = malloc(textsize)) == NULL) ERR;
+   pos = (size_t)sprintf(text, "{\"metadata\": {\n\".zgroup\": {\"zarr_format\": 2},\n");
+   for (v = 0; v < nvars; v++)
+      pos += genvar(text + pos, v);
+   pos -= 2; /* the last comma */
+   pos += (size_t)sprintf(text + pos, "\n},\n\"zarr_consolidated_format\": 1}\n");
+
+   printf("\n*** Timing JSON on consolidated metadata: %.1f MB, %zu entries.\n",
+          (double)pos / (1 << 20), 2 * nvars + 1);
+
+   gettimeofday(&t0, NULL);
+   if (NCJparsen(pos, text, 0, &json)) ERR;
+   parse = elapsed(&t0);
+   if (NCJdictget(json, "metadata", (const NCjson**)&jmeta) || NCJsort(jmeta) != NCJ_DICT) ERR;
+   if (NCJdictlength(jmeta) != 2 * nvars + 1) ERR;
+
+   /* Visit the variables in a scattered order: v * step mod nvars
+      with step prime to nvars */
+   gettimeofday(&t0, NULL);
+   {
+      size_t step = 7919;
+      while (nvars % step == 0) step++;
+      for (i = 0, v = 0; i < nvars; i++, v = (v + step) % nvars)
+      {
+         char key[64];
+         const NCjson* jarray = NULL;
+         varkey(key, sizeof(key), v, ".zarray");
+         if (NCJdictget(jmeta, key, &jarray) || NCJsort(jarray) != NCJ_DICT) ERR;
+         if (!checkvar(jmeta, v)) ERR;
+      }
+   }
+   lookup = elapsed(&t0) * 1000.0 / (double)(2 * nvars);
+
+   gettimeofday(&t0, NULL);
+   for (i = 0; i < NLINEAR && i < nvars; i++)
+   {
+      char key[64];
+      size_t p, n = NCJdictlength(jmeta);
+      v = (i * 7919) % nvars;
+      varkey(key, sizeof(key), v, ".zattrs");
+      for (p = 0; p < n; p++)
+         if (strcmp(NCJstring(NCJdictkey(jmeta, p)), key) == 0) break;
+      if (p == n) ERR;
+   }
+   linear = elapsed(&t0) * 1000.0 / (double)(i > 0 ? i : 1);
+
+   /* Insert one new entry per variable and replace every tenth */
+   gettimeofday(&t0, NULL);
+   for (v = 0; v < nvars; v++)
+   {
+      char key[64];
+      NCjson* jvalue = NULL;
+      varkey(key, sizeof(key), v, ".zextra");
+      if (NCJnewstring(NCJ_STRING, key, &jvalue)) ERR;
+      if (NCJinsert(jmeta, key, jvalue)) ERR;
+      if (v % 10 == 0)
+      {
+         varkey(key, sizeof(key), v, ".zarray");
+         if (NCJnew(NCJ_NULL, &jvalue)) ERR;
+         if (NCJinsert(jmeta, key, jvalue)) ERR;
+      }
+   }
+   insert = elapsed(&t0) * 1000.0 / (double)(nvars + nvars / 10);
+   if (NCJdictlength(jmeta) != 3 * nvars + 1) ERR;
+   for (v = 0; v < nvars; v++)
+   {
+      char key[64];
+      const NCjson* jvalue = NULL;
+      varkey(key, sizeof(key), v, ".zextra");
+      if (NCJdictget(jmeta, key, &jvalue) || strcmp(NCJstring(jvalue), key) != 0) ERR;
+      varkey(key, sizeof(key), v, ".zarray");
+      if (NCJdictget(jmeta, key, &jvalue)) ERR;
+      if (NCJsort(jvalue) != (v % 10 == 0 ? NCJ_NULL : NCJ_DICT)) ERR;
+   }
+
+   gettimeofday(&t0, NULL);
+   if (NCJunparse(json, 0, &text2)) ERR;
+   unparse = elapsed(&t0);
+   NCJreclaim(json);
+   json = NULL;
+   /* The text parses back to the same dict */
+   if (NCJparse(text2, 0, &json)) ERR;
+   if (NCJdictget(json, "metadata", (const NCjson**)&jmeta) || NCJdictlength(jmeta) != 3 * nvars + 1) ERR;
+   if (!checkvar(jmeta, nvars - 1)) ERR;
+
+   printf("parse   %10.1f msec (%.1f MB/s)\n", parse / 1000.0, (double)pos / parse);
+   printf("lookup  %10.1f nsec/key\n", lookup);
+   printf("linear  %10.1f nsec/key\n", linear);
+   printf("insert  %10.1f nsec/key\n", insert);
+   printf("unparse %10.1f msec\n", unparse / 1000.0);
+
+   NCJreclaim(json);
+   free(text);
+   free(text2);
+   FINAL_RESULTS;
+}
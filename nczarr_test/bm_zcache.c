@@ -0,0 +1,106 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   This program times the NCZarr chunk cache. A variable with one
+   element per chunk is read through a cache holding n chunks, so
+   that every element read is one cache operation:
+   - miss: the first n chunks are read into an empty cache;
+   - hit: the same n chunks are read again, last block first, so
+     that the recency order no longer matches the insertion order;
+   - evict: the next n chunks are read, each evicting the least
+     recently used chunk.
+   No chunk is ever written, so a miss only costs a failed object
+   lookup in the storage.
+
+   Usage: bm_zcache [maxentries]
+   Cache sizes 10^3, 10^4,... up to maxentries (default 10^4)
+   are timed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define FILE_NAME "file://tmp_bm_zcache.file#mode=nczarr,file"
+#define VAR "v"
+#define BLOCK 1000 /* elements read per nc_get_vara call */
+#define DFALTMAXENTRIES 10000
+
+static int* buf = NULL;
+
+static double
+elapsed(struct timeval* t0)
+{
+   struct timeval t1;
+   gettimeofday(&t1, NULL);
+   return (double)(t1.tv_sec - t0->tv_sec) * 1e6 + (double)(t1.tv_usec - t0->tv_usec);
+}
+
+/* Read elements [first,first+n) in blocks, optionally last block
+ * first, and return the time per element in nsec */
+static double
+readrange(int ncid, int varid, size_t first, size_t n, int backward)
+{
+   struct timeval t0;
+   size_t start, count, i, nblocks = (n + BLOCK - 1) / BLOCK;
+
+   gettimeofday(&t0, NULL);
+   for (i = 0; i < nblocks; i++)
+   {
+      size_t b = (backward ? nblocks - 1 - i : i);
+      start = first + b * BLOCK;
+      count = (n - b * BLOCK < BLOCK ? n - b * BLOCK : BLOCK);
+      if (nc_get_vara_int(ncid, varid, &start, &count, buf)) return -1;
+   }
+   return (elapsed(&t0) * 1000.0) / (double)n;
+}
+
+static int
+bench(size_t nentries)
+{
+   int ncid, varid, dimid;
+   size_t chunk = 1;
+   double miss, hit, evict;
+
+   /* The cache must be set before the variable is read in */
+   if (nc_set_chunk_cache(nentries * sizeof(int), nentries, 0.5)) ERR;
+
+   if (nc_create(FILE_NAME, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   if (nc_def_dim(ncid, "d", 2 * nentries, &dimid)) ERR;
+   if (nc_def_var(ncid, VAR, NC_INT, 1, &dimid, &varid)) ERR;
+   if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, &chunk)) ERR;
+   if (nc_close(ncid)) ERR;
+
+   if (nc_open(FILE_NAME, NC_NOWRITE, &ncid)) ERR;
+   if (nc_inq_varid(ncid, VAR, &varid)) ERR;
+   if ((miss = readrange(ncid, varid, 0, nentries, 0)) < 0) ERR;
+   if ((hit = readrange(ncid, varid, 0, nentries, 1)) < 0) ERR;
+   if ((evict = readrange(ncid, varid, nentries, nentries, 0)) < 0) ERR;
+   if (nc_close(ncid)) ERR;
+
+   printf("%8zu entries: miss %8.0f ns, hit %8.0f ns, evict %8.0f ns\n",
+          nentries, miss, hit, evict);
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   size_t maxentries = DFALTMAXENTRIES;
+   size_t n;
+
+   if (argc > 1)
+      maxentries = (size_t)strtoull(argv[1], NULL, 10);
+
+   printf("\n*** Timing the NCZarr chunk cache.\n");
+   if ((buf = malloc(BLOCK * sizeof(int))) == NULL) ERR;
+   for (n = 1000; n <= maxentries; n *= 10)
+      if (bench(n)) ERR;
+   free(buf);
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
@@ -78,6 +78,28 @@ echo "STORAGE: $STORAGE"
 test "x$STORAGE" = "xtas:_Storage='chunked';" || test "x$STORAGE" = "xtas:_Storage=\"chunked\";"
 CHUNKSIZES=`cat tmp_pds.cdl | sed -e "/tas:_ChunkSizes/p" -ed | tr -d "[:space:]"`
 test "x$CHUNKSIZES" = "xtas:_ChunkSizes=10,15,20;"
+
+echo "*** Test that concurrent chunk reads return the same data"
+fileargs tmp_chunked
+CHUNKED="$fileurl"
+fileargs tmp_deflated
+${NCCOPY} -M0 -d1 -c dim0/,dim1/1,dim2/,dim3/1,dim4/,dim5/1,dim6/ tmp_chunks3.nc "$fileurl"
+${NCDUMP} -n tmp "$CHUNKED" > tmp_serial.cdl
+NCZARR_THREADS=4 NCZARR_MAXINFLIGHT=65536 ${NCDUMP} -n tmp "$CHUNKED" > tmp_concurrent.cdl
+diff tmp_serial.cdl tmp_concurrent.cdl
+NCZARR_THREADS=4 ${NCDUMP} -n tmp "$fileurl" > tmp_concurrent_deflated.cdl
+# Compare only the data, the filter attributes differ
+sed -n -e '/^data:/,$p' < tmp_serial.cdl > tmp_serial_data.cdl
+sed -n -e '/^data:/,$p' < tmp_concurrent_deflated.cdl > tmp_concurrent_deflated_data.cdl
+diff tmp_serial_data.cdl tmp_concurrent_deflated_data.cdl
+
+echo "*** Test that chunks evicted during a concurrent write are all stored"
+fileargs tmp_writebehind
+# A cache of only a few chunks forces evictions during the copy
+NCZARR_THREADS=4 NCZARR_MAXINFLIGHT=4096 ${NCCOPY} -M0 -h 8K -e 2 -d1 -c dim0/,dim1/1,dim2/,dim3/1,dim4/,dim5/1,dim6/ tmp_chunks3.nc "$fileurl"
+${NCDUMP} -n tmp "$fileurl" > tmp_writebehind.cdl
+sed -n -e '/^data:/,$p' < tmp_writebehind.cdl > tmp_writebehind_data.cdl
+diff tmp_serial_data.cdl tmp_writebehind_data.cdl
 }
 
 testcase file
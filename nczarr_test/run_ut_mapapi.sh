@@ -90,6 +90,10 @@ echo ""
 echo "*** Map Unit Testing"
 echo ""; echo "*** Test zmap_file"
 testmapcreate file; testmapmeta file; testmapdata file; testmapsearch file
+echo ""; echo "*** Test zmap_file with a one-descriptor cache"
+NCZARR_MAXFDS=1; NCZARR_FADVISE=dontneed; export NCZARR_MAXFDS NCZARR_FADVISE
+testmapcreate file; testmapmeta file; testmapdata file; testmapsearch file
+unset NCZARR_MAXFDS NCZARR_FADVISE
 if test "x$FEATURE_NCZARR_ZIP" = xyes ; then
     echo ""; echo "*** Test zmap_zip"
     testmapcreate zip; testmapmeta zip; testmapdata zip; testmapsearch zip
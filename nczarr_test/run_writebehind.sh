@@ -0,0 +1,19 @@
+#!/bin/sh
+
+if test "x$srcdir" = x ; then srcdir=`pwd`; fi
+. ../test_common.sh
+
+. "$srcdir/test_nczarr.sh"
+
+set -e
+
+isolate "testdir_writebehind"
+THISDIR=`pwd`
+cd $ISOPATH
+
+echo "*** Test background writes with the default in-flight limit"
+unset NCZARR_MAXINFLIGHT
+NCZARR_THREADS=4 ${execdir}/test_writebehind
+
+echo "*** Test background writes with no in-flight limit"
+NCZARR_THREADS=4 NCZARR_MAXINFLIGHT=0 ${execdir}/test_writebehind
@@ -0,0 +1,126 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test the lazy read of NCZarr variable metadata: opening a file
+   reads only the names of the variables, and the .zarray and .zattrs
+   of a variable are read when it is first used. The .zarray of one
+   variable is damaged, so the open would fail if it were read
+   eagerly; the other variables stay usable and are not rewritten.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define URL "file://tmp_lazyvar.file#mode=nczarr,file"
+#define BADZARRAY "tmp_lazyvar.file/v1/.zarray"
+#define BADTEXT "{\"zarr_format\": 2, damaged"
+#define NVARS 3
+#define NX 10
+
+static int
+readfile(const char* path, char* text, size_t len)
+{
+   FILE* f = fopen(path, "rb");
+   size_t n;
+   if (f == NULL) return -1;
+   n = fread(text, 1, len - 1, f);
+   text[n] = '\0';
+   fclose(f);
+   return 0;
+}
+
+static int
+check(int ncid, int varid, int base)
+{
+   int data[NX];
+   size_t i;
+   if (nc_get_var_int(ncid, varid, data)) return 0;
+   for (i = 0; i < NX; i++)
+      if (data[i] != base + (int)i) return 0;
+   return 1;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid, dimid, varid, v;
+   int data[NX];
+   size_t i;
+
+   printf("\n*** Testing lazy read of NCZarr variable metadata.\n");
+   printf("*** creating...");
+   {
+      if (nc_create(URL, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+      if (nc_def_dim(ncid, "x", NX, &dimid)) ERR;
+      for (v = 0; v < NVARS; v++)
+      {
+         char name[NC_MAX_NAME + 1];
+         snprintf(name, sizeof(name), "v%d", v);
+         if (nc_def_var(ncid, name, NC_INT, 1, &dimid, &varid)) ERR;
+         if (nc_put_att_text(ncid, varid, "units", 1, "m")) ERR;
+      }
+      if (nc_enddef(ncid)) ERR;
+      for (v = 0; v < NVARS; v++)
+      {
+         for (i = 0; i < NX; i++) data[i] = 100 * v + (int)i;
+         if (nc_put_var_int(ncid, v, data)) ERR;
+      }
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing open with a damaged variable...");
+   {
+      FILE* f;
+      char name[NC_MAX_NAME + 1];
+      int nvars;
+      nc_type xtype;
+      if ((f = fopen(BADZARRAY, "wb")) == NULL) ERR;
+      fputs(BADTEXT, f);
+      fclose(f);
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (nc_inq_nvars(ncid, &nvars)) ERR;
+      if (nvars != NVARS) ERR;
+      /* names need no metadata */
+      if (nc_inq_varname(ncid, 1, name)) ERR;
+      if (strcmp(name, "v1")) ERR;
+      if (nc_inq_varid(ncid, "v2", &varid)) ERR;
+      if (varid != 2) ERR;
+      if (!check(ncid, 0, 0)) ERR;
+      if (!check(ncid, 2, 200)) ERR;
+      /* the error is reported on use, every time */
+      if (nc_inq_vartype(ncid, 1, &xtype) == NC_NOERR) ERR;
+      if (nc_get_var_int(ncid, 1, data) == NC_NOERR) ERR;
+      if (nc_inq_vartype(ncid, 2, &xtype)) ERR;
+      if (xtype != NC_INT) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing update with a damaged variable...");
+   {
+      char text[256];
+      int natts;
+      if (nc_open(URL, NC_WRITE, &ncid)) ERR;
+      for (i = 0; i < NX; i++) data[i] = 500 + (int)i;
+      if (nc_put_var_int(ncid, 0, data)) ERR;
+      if (nc_close(ncid)) ERR;
+      /* an unused variable is not rewritten */
+      if (readfile(BADZARRAY, text, sizeof(text))) ERR;
+      if (strcmp(text, BADTEXT)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (!check(ncid, 0, 500)) ERR;
+      if (!check(ncid, 2, 200)) ERR;
+      /* a used variable keeps the attributes that were not read */
+      if (nc_inq_varnatts(ncid, 0, &natts)) ERR;
+      if (natts != 1) ERR;
+      if (nc_inq_varnatts(ncid, 2, &natts)) ERR;
+      if (natts != 1) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
@@ -0,0 +1,124 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test the read-ahead of NCZarr metadata at open: without consolidated
+   metadata, the .zgroup/.zattrs/.zarray objects of a level of the group
+   tree are read together. A tree of groups, each with a variable and
+   attributes, is written as NCZarr and as pure Zarr and then walked.
+   The batch size is set small, so a level takes several batches.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define NCZURL "file://tmp_metaprefetch.file#mode=nczarr,file"
+#define ZARRURL "file://tmp_metaprefetch_zarr.file#mode=zarr,file"
+#define BADGROUP "tmp_metaprefetch.file/g1/g12/.zattrs"
+#define FANOUT 3
+#define DEPTH 3
+#define NX 4
+
+/* Define the subgroups of grp, depth levels deep; every group
+   has an attribute and a variable whose values depend on the path */
+static int
+build(int grp, int dimid, int depth, int id)
+{
+   int i, varid, data[NX];
+   if (nc_put_att_int(grp, NC_GLOBAL, "id", NC_INT, 1, &id)) return 1;
+   if (nc_def_var(grp, "v", NC_INT, 1, &dimid, &varid)) return 1;
+   if (nc_put_att_text(grp, varid, "units", 1, "m")) return 1;
+   for (i = 0; i < NX; i++) data[i] = id * 10 + i;
+   if (nc_put_var_int(grp, varid, data)) return 1;
+   if (depth == 0) return 0;
+   for (i = 0; i < FANOUT; i++)
+   {
+      char name[NC_MAX_NAME + 1];
+      int sub;
+      snprintf(name, sizeof(name), "g%d", id * 10 + i + 1);
+      if (nc_def_grp(grp, name, &sub)) return 1;
+      if (build(sub, dimid, depth - 1, id * 10 + i + 1)) return 1;
+   }
+   return 0;
+}
+
+/* Walk the tree and check it; return the no. of groups or -1 */
+static int
+walk(int grp, int depth, int id)
+{
+   int i, n, varid, got, data[NX];
+   int ngrps, grps[FANOUT];
+   char units[2] = "";
+   if (nc_get_att_int(grp, NC_GLOBAL, "id", &got) || got != id) return -1;
+   if (nc_inq_varid(grp, "v", &varid)) return -1;
+   if (nc_get_att_text(grp, varid, "units", units) || units[0] != 'm') return -1;
+   if (nc_get_var_int(grp, varid, data)) return -1;
+   for (i = 0; i < NX; i++)
+      if (data[i] != id * 10 + i) return -1;
+   if (nc_inq_grps(grp, &ngrps, NULL)) return -1;
+   if (ngrps != (depth == 0 ? 0 : FANOUT)) return -1;
+   if (ngrps == 0) return 1;
+   if (nc_inq_grps(grp, NULL, grps)) return -1;
+   for (n = 1, i = 0; i < ngrps; i++)
+   {
+      int count = walk(grps[i], depth - 1, id * 10 + i + 1);
+      if (count < 0) return -1;
+      n += count;
+   }
+   return n;
+}
+
+static int
+create(const char* url)
+{
+   int ncid, dimid;
+   if (nc_create(url, NC_CLOBBER|NC_NETCDF4, &ncid)) return 1;
+   if (nc_def_dim(ncid, "x", NX, &dimid)) return 1;
+   if (build(ncid, dimid, DEPTH, 0)) return 1;
+   if (nc_close(ncid)) return 1;
+   return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid, ngroups = 1, i;
+
+   for (i = 0; i < DEPTH; i++) ngroups = ngroups * FANOUT + 1;
+   /* a few objects per batch */
+   setenv("NCZARR_METAPREFETCH", "5", 1);
+
+   printf("\n*** Testing read-ahead of NCZarr metadata.\n");
+   printf("*** testing NCZarr tree...");
+   {
+      if (create(NCZURL)) ERR;
+      if (nc_open(NCZURL, NC_NOWRITE, &ncid)) ERR;
+      if (walk(ncid, DEPTH, 0) != ngroups) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing pure Zarr tree...");
+   {
+      if (create(ZARRURL)) ERR;
+      if (nc_open(ZARRURL, NC_NOWRITE, &ncid)) ERR;
+      /* pure Zarr has no dimensions to share, but the same tree */
+      if (walk(ncid, DEPTH, 0) != ngroups) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing open with damaged group metadata...");
+   {
+      FILE* f;
+      if ((f = fopen(BADGROUP, "wb")) == NULL) ERR;
+      fputs("{\"id\": [12], damaged", f);
+      fclose(f);
+      /* the error is still reported by the open */
+      if (nc_open(NCZURL, NC_NOWRITE, &ncid) == NC_NOERR) ERR;
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
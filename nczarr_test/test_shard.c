@@ -0,0 +1,247 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test sharded NCZarr variables: the chunks are stored a block at a
+   time, so the variable takes fewer objects than it has chunks. The
+   shape is not a multiple of the shard, and the shards are written
+   whole, in part, and one element at a time. A shard whose index
+   points past its end is refused, whether the index itself is
+   implausible or the shard was cut short.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "netcdf.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define URL "file://tmp_shard.file#mode=nczarr,file"
+#define VARDIR "tmp_shard.file/v"
+#define NX 20
+#define NY 30
+#define CX 4
+#define CY 5
+#define SX 2
+#define SY 3
+#define FILL -1
+
+static int expected[NX][NY];
+
+/* Count the objects in the directory of the variable */
+static int
+countobjects(const char* dir)
+{
+   DIR* d = opendir(dir);
+   struct dirent* e;
+   int n = 0;
+   if (d == NULL) return -1;
+   while ((e = readdir(d)) != NULL)
+      if (e->d_name[0] != '.') n++;
+   closedir(d);
+   return n;
+}
+
+/* Set the size of the first chunk in the index of a shard */
+static int
+setnbytes(const char* path, unsigned long long nbytes)
+{
+   unsigned char le[8];
+   FILE* f;
+   int i;
+   for (i = 0; i < 8; i++)
+      le[i] = (unsigned char)(nbytes >> (8 * i));
+   if ((f = fopen(path, "r+b")) == NULL) return 1;
+   if (fseek(f, 8, SEEK_SET) || fwrite(le, 1, sizeof(le), f) != sizeof(le))
+      {fclose(f); return 1;}
+   return fclose(f) != 0;
+}
+
+static int
+check(int ncid, int varid)
+{
+   static int data[NX][NY];
+   size_t i, j;
+   if (nc_get_var_int(ncid, varid, &data[0][0])) return 0;
+   for (i = 0; i < NX; i++)
+      for (j = 0; j < NY; j++)
+         if (data[i][j] != expected[i][j]) return 0;
+   return 1;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid, varid, svarid, dimids[2];
+   size_t chunks[2] = {CX, CY};
+   size_t shard[2] = {SX, SY};
+   size_t i, j;
+
+   printf("\n*** Testing sharded NCZarr variables.\n");
+   printf("*** testing definition...");
+   {
+      int fill = FILL, sharded;
+      size_t got[2];
+      if (nc_create(URL, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+      if (nc_def_dim(ncid, "x", NX, &dimids[0])) ERR;
+      if (nc_def_dim(ncid, "y", NY, &dimids[1])) ERR;
+      if (nc_def_var(ncid, "v", NC_INT, 2, dimids, &varid)) ERR;
+      if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks)) ERR;
+      if (nc_def_var_fill(ncid, varid, NC_FILL, &fill)) ERR;
+      if (nc_inq_var_shard(ncid, varid, &sharded, NULL)) ERR;
+      if (sharded) ERR;
+      if (nc_def_var_shard(ncid, varid, shard)) ERR;
+      if (nc_inq_var_shard(ncid, varid, &sharded, got)) ERR;
+      if (!sharded || got[0] != SX || got[1] != SY) ERR;
+      /* scalars have no chunks to group */
+      if (nc_def_var(ncid, "s", NC_INT, 0, NULL, &svarid)) ERR;
+      if (nc_def_var_shard(ncid, svarid, shard) != NC_EINVAL) ERR;
+      {
+         size_t zero[2] = {0, 1};
+         if (nc_def_var_shard(ncid, varid, zero) != NC_EINVAL) ERR;
+      }
+      if (nc_enddef(ncid)) ERR;
+      if (nc_def_var_shard(ncid, varid, shard) != NC_ELATEDEF) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing part of a shard...");
+   {
+      /* the first chunk only; the rest of the shard stays empty */
+      size_t start[2] = {0, 0}, count[2] = {CX, CY};
+      int data[CX][CY];
+      for (i = 0; i < NX; i++)
+         for (j = 0; j < NY; j++)
+            expected[i][j] = FILL;
+      for (i = 0; i < CX; i++)
+         for (j = 0; j < CY; j++)
+            data[i][j] = expected[i][j] = (int)(i * NY + j);
+      if (nc_open(URL, NC_WRITE, &ncid)) ERR;
+      if (nc_inq_varid(ncid, "v", &varid)) ERR;
+      if (nc_put_vara_int(ncid, varid, start, count, &data[0][0])) ERR;
+      if (nc_close(ncid)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (!check(ncid, varid)) ERR;
+      {
+         /* a chunk of the same shard that was never written */
+         size_t cstart[2] = {0, CY};
+         size_t size;
+         if (nc_get_chunk_raw(ncid, varid, cstart, NULL, &size, NULL) != NC_EEMPTY) ERR;
+      }
+      if (nc_close(ncid)) ERR;
+      if (countobjects(VARDIR) != 1) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing a slab across shards...");
+   {
+      /* merged with the chunk already stored */
+      size_t start[2] = {3, 2}, count[2] = {13, 21};
+      int* data = malloc(sizeof(int) * count[0] * count[1]);
+      if (data == NULL) ERR;
+      for (i = 0; i < count[0]; i++)
+         for (j = 0; j < count[1]; j++)
+            data[i * count[1] + j] = expected[start[0] + i][start[1] + j]
+               = (int)(100000 + i * 1000 + j);
+      if (nc_open(URL, NC_WRITE, &ncid)) ERR;
+      if (nc_put_vara_int(ncid, varid, start, count, data)) ERR;
+      /* visible before the shards are written out */
+      if (!check(ncid, varid)) ERR;
+      if (nc_close(ncid)) ERR;
+      free(data);
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (!check(ncid, varid)) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing scattered elements...");
+   {
+      unsigned int seed = 12345;
+      int k;
+      if (nc_open(URL, NC_WRITE, &ncid)) ERR;
+      for (k = 0; k < 500; k++)
+      {
+         size_t index[2];
+         int x = -k - 2;
+         seed = seed * 1103515245u + 12345u;
+         index[0] = (seed >> 8) % NX;
+         seed = seed * 1103515245u + 12345u;
+         index[1] = (seed >> 8) % NY;
+         expected[index[0]][index[1]] = x;
+         if (nc_put_var1_int(ncid, varid, index, &x)) ERR;
+      }
+      if (nc_close(ncid)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (!check(ncid, varid)) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing the whole variable and the stored form...");
+   {
+      int sharded;
+      size_t got[2];
+      int nchunks = ((NX + CX - 1) / CX) * ((NY + CY - 1) / CY);
+      int nshards = ((NX + CX * SX - 1) / (CX * SX)) * ((NY + CY * SY - 1) / (CY * SY));
+      for (i = 0; i < NX; i++)
+         for (j = 0; j < NY; j++)
+            expected[i][j] = (int)(7 * i - 3 * j);
+      if (nc_open(URL, NC_WRITE, &ncid)) ERR;
+      if (nc_put_var_int(ncid, varid, &expected[0][0])) ERR;
+      if (nc_close(ncid)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (nc_inq_var_shard(ncid, varid, &sharded, got)) ERR;
+      if (!sharded || got[0] != SX || got[1] != SY) ERR;
+      if (!check(ncid, varid)) ERR;
+      {
+         /* an edge chunk, read as stored: no filters, so the values */
+         size_t cstart[2] = {NX - CX, NY - CY};
+         int raw[CX * CY];
+         size_t size = 0;
+         if (nc_get_chunk_raw(ncid, varid, cstart, NULL, &size, raw)) ERR;
+         if (size != sizeof(raw)) ERR;
+         for (i = 0; i < CX; i++)
+            for (j = 0; j < CY; j++)
+               if (raw[i * CY + j] != expected[cstart[0] + i][cstart[1] + j]) ERR;
+      }
+      if (nc_close(ncid)) ERR;
+      if (countobjects(VARDIR) != nshards || nshards >= nchunks) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing a shard cut short...");
+   {
+      /* the last chunk of shard 1.1 loses its last bytes */
+      size_t start[2] = {SX * CX, SY * CY}, count[2] = {SX * CX, SY * CY};
+      static int data[SX * CX][SY * CY];
+      struct stat st;
+      if (stat(VARDIR "/1.1", &st)) ERR;
+      if (truncate(VARDIR "/1.1", st.st_size - 4)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (nc_get_vara_int(ncid, varid, start, count, &data[0][0]) != NC_ENCZARR) ERR;
+      /* the other shards are still readable */
+      start[0] = 0;
+      if (nc_get_vara_int(ncid, varid, start, count, &data[0][0])) ERR;
+      for (i = 0; i < count[0]; i++)
+         for (j = 0; j < count[1]; j++)
+            if (data[i][j] != expected[start[0] + i][start[1] + j]) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   printf("*** testing a corrupt shard index...");
+   {
+      static int data[NX][NY];
+      /* past the end of the shard, then wrapping around */
+      if (setnbytes(VARDIR "/0.0", 1ULL << 40)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (nc_get_var_int(ncid, varid, &data[0][0]) != NC_ENCZARR) ERR;
+      if (nc_close(ncid)) ERR;
+      if (setnbytes(VARDIR "/0.0", 0xfffffffffffffff0ULL)) ERR;
+      if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+      if (nc_get_var_int(ncid, varid, &data[0][0]) != NC_ENCZARR) ERR;
+      if (nc_close(ncid)) ERR;
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
@@ -0,0 +1,119 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test a chunk cache budget shared by all the variables of an
+   NCZarr file. The budget holds only a few chunks, so writing the
+   variables in an interleaved order evicts modified chunks of one
+   variable to make room for another. The data must survive. A
+   budget that is not a number of bytes is refused, and showing the
+   cache statistics leaves the log level alone.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "netcdf.h"
+#include "nclog.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define NVARS 4
+#define DIM 64
+#define CHUNK 8
+#define SHARED "file://tmp_sharedcache.file#mode=nczarr,file&sharedcache=96"
+#define PRIVATE "file://tmp_sharedcache.file#mode=nczarr,file"
+#define SHOWCACHE "file://tmp_sharedcache.file#mode=nczarr,file&show=cache"
+
+static const char *bad[] = {
+   "file://tmp_sharedcache.file#mode=nczarr,file&sharedcache=junk",
+   "file://tmp_sharedcache.file#mode=nczarr,file&sharedcache=-1",
+   "file://tmp_sharedcache.file#mode=nczarr,file&sharedcache=96k",
+   "file://tmp_sharedcache.file#mode=nczarr,file&sharedcache=99999999999999999999999",
+   NULL
+};
+
+static int
+value(int v, size_t i)
+{
+   return v * 1000 + (int)i;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid, dimid, varids[NVARS];
+   size_t chunk = CHUNK;
+   int v;
+   size_t i;
+
+   printf("\n*** Testing a chunk cache shared by all variables.\n");
+   printf("*** writing with a shared cache...");
+   if (nc_create(SHARED, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   if (nc_def_dim(ncid, "d", DIM, &dimid)) ERR;
+   for (v = 0; v < NVARS; v++)
+   {
+      char name[16];
+      snprintf(name, sizeof(name), "v%d", v);
+      if (nc_def_var(ncid, name, NC_INT, 1, &dimid, &varids[v])) ERR;
+      if (nc_def_var_chunking(ncid, varids[v], NC_CHUNKED, &chunk)) ERR;
+   }
+   if (nc_enddef(ncid)) ERR;
+   /* Interleave the variables one element at a time */
+   for (i = 0; i < DIM; i++)
+      for (v = 0; v < NVARS; v++)
+      {
+         int x = value(v, i);
+         if (nc_put_var1_int(ncid, varids[v], &i, &x)) ERR;
+      }
+   /* Read some back before closing */
+   for (v = NVARS - 1; v >= 0; v--)
+   {
+      int data[DIM];
+      if (nc_get_var_int(ncid, varids[v], data)) ERR;
+      for (i = 0; i < DIM; i++)
+         if (data[i] != value(v, i)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   SUMMARIZE_ERR;
+
+   printf("*** reading with per-variable caches...");
+   if (nc_open(PRIVATE, NC_NOWRITE, &ncid)) ERR;
+   for (v = 0; v < NVARS; v++)
+   {
+      int data[DIM];
+      if (nc_get_var_int(ncid, varids[v], data)) ERR;
+      for (i = 0; i < DIM; i++)
+         if (data[i] != value(v, i)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   SUMMARIZE_ERR;
+
+   printf("*** reading with a shared cache...");
+   if (nc_open(SHARED, NC_NOWRITE, &ncid)) ERR;
+   for (i = 0; i < DIM; i++)
+      for (v = 0; v < NVARS; v++)
+      {
+         int x;
+         if (nc_get_var1_int(ncid, varids[v], &i, &x)) ERR;
+         if (x != value(v, i)) ERR;
+      }
+   if (nc_close(ncid)) ERR;
+   SUMMARIZE_ERR;
+
+   printf("*** refusing a bad budget...");
+   for (v = 0; bad[v] != NULL; v++)
+      if (nc_open(bad[v], NC_NOWRITE, &ncid) != NC_EINVAL) ERR;
+   SUMMARIZE_ERR;
+
+   printf("*** showing the cache statistics...");
+   {
+      int level = ncsetloglevel(NCLOGWARN);
+      int data[DIM];
+      if (nc_open(SHOWCACHE, NC_NOWRITE, &ncid)) ERR;
+      if (nc_get_var_int(ncid, varids[0], data)) ERR;
+      if (nc_close(ncid)) ERR;
+      if (ncsetloglevel(level) != NCLOGWARN) ERR;
+   }
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
@@ -0,0 +1,104 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata See COPYRIGHT file for
+   conditions of use.
+
+   Test that modified chunks evicted from the chunk cache are
+   written in the background, several at a time. The cache holds
+   only two chunks, so writing the variable a chunk at a time evicts
+   a modified chunk for every chunk written. The most chunks being
+   written at once is taken from the cache statistics that
+   show=cache logs at close; it must be more than one under the
+   ZARR.MAXINFLIGHT setting of the environment, which run_writebehind.sh
+   sets to the default and to 0 (no limit). The data must survive.
+
+   NCZARR_THREADS must be set to a non-zero number of threads.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "nclog.h"
+#include "nc_tests.h"
+#include "err_macros.h"
+
+#define URL "file://tmp_writebehind.file#mode=nczarr,file&show=cache"
+#define NCHUNKS 32
+#define CHUNK 1024
+#define DIM (NCHUNKS * CHUNK)
+
+static int data[CHUNK];
+
+/* Return the largest maxwrites= value logged, or -1 if none */
+static long
+maxwrites(FILE* log)
+{
+   char line[1024];
+   long most = -1;
+   rewind(log);
+   while (fgets(line, sizeof(line), log) != NULL)
+   {
+      const char* p = strstr(line, "maxwrites=");
+      if (p != NULL)
+      {
+         long n = strtol(p + strlen("maxwrites="), NULL, 10);
+         if (n > most) most = n;
+      }
+   }
+   return most;
+}
+
+int
+main(int argc, char **argv)
+{
+   int ncid, dimid, varid;
+   size_t chunk = CHUNK;
+   size_t start, count = CHUNK;
+   FILE* log = NULL;
+   long most;
+   size_t c, i;
+
+   printf("\n*** Testing background writes of evicted chunks.\n");
+   printf("*** writing through a two chunk cache...");
+   if (nc_set_chunk_cache(2 * CHUNK * sizeof(int), 2, 0.75f)) ERR;
+   if (nc_create(URL, NC_CLOBBER|NC_NETCDF4, &ncid)) ERR;
+   /* After the library has set up its own logging */
+   if ((log = tmpfile()) == NULL) ERR;
+   nclogopen(log);
+   if (nc_def_dim(ncid, "d", DIM, &dimid)) ERR;
+   if (nc_def_var(ncid, "v", NC_INT, 1, &dimid, &varid)) ERR;
+   if (nc_def_var_chunking(ncid, varid, NC_CHUNKED, &chunk)) ERR;
+   if (nc_enddef(ncid)) ERR;
+   for (c = 0; c < NCHUNKS; c++)
+   {
+      for (i = 0; i < CHUNK; i++)
+         data[i] = (int)(c * CHUNK + i);
+      start = c * CHUNK;
+      if (nc_put_vara_int(ncid, varid, &start, &count, data)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   nclogopen(NULL);
+   SUMMARIZE_ERR;
+
+   printf("*** checking that the writes overlapped...");
+   most = maxwrites(log);
+   fclose(log);
+   if (most < 0) ERR;
+#ifdef NETCDF_ENABLE_THREADPOOL
+   if (most < 2) ERR;
+#endif
+   SUMMARIZE_ERR;
+
+   printf("*** reading the chunks back...");
+   if (nc_open(URL, NC_NOWRITE, &ncid)) ERR;
+   for (c = 0; c < NCHUNKS; c++)
+   {
+      start = c * CHUNK;
+      if (nc_get_vara_int(ncid, varid, &start, &count, data)) ERR;
+      for (i = 0; i < CHUNK; i++)
+         if (data[i] != (int)(c * CHUNK + i)) ERR;
+   }
+   if (nc_close(ncid)) ERR;
+   SUMMARIZE_ERR;
+   FINAL_RESULTS;
+}
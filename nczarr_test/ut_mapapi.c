@@ -289,6 +289,8 @@ simpledata(void)
     char* truekey = NULL;
     int data1[DATA1LEN];
     int readdata[DATA1LEN];
+    int* alldata = NULL;
+    char* missingkey = NULL;
     int i;
     size64_t totallen, size;
     char* data1p = (char*)&data1[0]; /* byte level version of data1 */
@@ -334,12 +336,50 @@ simpledata(void)
     if(memcmp(data1,readdata,size)!=0)
         report(FAIL,DATA1": content verify",map);
     else report(PASS,DATA1": content verify",map);
+    /* Read it all in one operation */
+    if((stat = nczmap_readall(map, truekey, &size, (void**)&alldata)))
+	goto done;
+    report(PASS,DATA1": readall",map);
+    if(size != totallen)
+        report(FAIL,DATA1": readall len verify",map);
+    if(memcmp(data1,alldata,size)!=0)
+        report(FAIL,DATA1": readall content verify",map);
+    else report(PASS,DATA1": readall content verify",map);
+    /* Read it again as a batch: whole, a byte range, and a missing object */
+    {
+        NCZMAPIO ios[3];
+        memset(ios,0,sizeof(ios));
+        memset(readdata,0,sizeof(readdata));
+        missingkey = makekey("/nosuchobject");
+        ios[0].key = truekey;
+        ios[1].key = truekey;
+        ios[1].start = sizeof(int);
+        ios[1].count = totallen - sizeof(int);
+        ios[1].content = readdata;
+        ios[2].key = missingkey;
+        if((stat = nczmap_readv(map, 3, ios)))
+	    goto done;
+        report(PASS,DATA1": readv",map);
+        if(ios[0].stat != NC_NOERR || ios[0].count != totallen
+           || memcmp(data1,ios[0].content,totallen) != 0)
+            report(FAIL,DATA1": readv whole verify",map);
+        else report(PASS,DATA1": readv whole verify",map);
+        if(ios[1].stat != NC_NOERR || memcmp(&data1[1],readdata,totallen - sizeof(int)) != 0)
+            report(FAIL,DATA1": readv range verify",map);
+        else report(PASS,DATA1": readv range verify",map);
+        if(ios[2].stat != NC_EEMPTY || ios[2].content != NULL)
+            report(FAIL,DATA1": readv missing verify",map);
+        else report(PASS,DATA1": readv missing verify",map);
+        nullfree(ios[0].content);
+    }
     free(truekey); truekey = NULL;
 
 done:
     /* Do not delete so we can look at it with ncdump */
     if(map && (stat = nczmap_close(map,0)))
 	goto done;
+    nullfree(alldata);
+    nullfree(missingkey);
     nullfree(truekey);
     return THROW(stat);
 }
@@ -0,0 +1,35 @@
+#!/bin/sh
+
+if test "x$srcdir" = x ; then srcdir=`pwd`; fi 
+. ../test_common.sh
+
+set -e
+
+# Test the asynchronous S3 requests against a local stand-in server,
+# so no network access or credentials are needed.
+
+if ! command -v python3 >/dev/null 2>&1 ; then
+  echo "python3 not found; skipping S3 connection pool test"
+  exit 0
+fi
+
+isolate "testdir_uts3pool"
+cd $ISOPATH
+
+PORTFILE=`pwd`/s3stub.port
+rm -f $PORTFILE
+python3 ${srcdir}/s3stub.py $PORTFILE &
+STUBPID=$!
+trap "kill $STUBPID 2>/dev/null" EXIT
+
+# Wait for the server to publish its port
+i=0
+while test ! -f $PORTFILE ; do
+  i=`expr $i + 1`
+  if test $i -gt 100 ; then echo "s3stub.py did not start"; exit 1; fi
+  sleep 0.1
+done
+PORT=`cat $PORTFILE`
+
+echo "Running S3 connection pool tests against http://127.0.0.1:$PORT"
+${execdir}/tst_s3pool "http://127.0.0.1:$PORT"
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+#   Copyright 2018, UCAR/Unidata
+#   See netcdf/COPYRIGHT file for copying and redistribution conditions.
+
+"""
+A minimal S3-compatible stand-in for testing the S3 request code
+without network access. Objects are kept in memory; authentication
+is ignored. Supports PUT, GET (with a single byte Range), HEAD and
+DELETE of /<bucket>/<key>, over persistent HTTP/1.1 connections.
+
+GET /_stats returns "connections=N requests=N maxactive=N": the
+number of TCP connections accepted, of requests served and the
+largest number of requests in progress at once.
+
+usage: s3stub.py <portfile> [<delay-seconds>]
+Listens on an ephemeral port of 127.0.0.1 and writes it to <portfile>.
+Every object request is delayed by <delay-seconds> (default 0.02) to
+stand in for network latency.
+"""
+
+import os
+import re
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+objects = {}
+lock = threading.Lock()
+stats = {"connections": 0, "requests": 0, "active": 0, "maxactive": 0}
+delay = 0.02
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def setup(self):
+        super().setup()
+        with lock:
+            stats["connections"] += 1
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def reply(self, code, body=b"", headers=None, sendbody=True):
+        self.send_response(code)
+        for k, v in (headers or {}).items():
+            self.send_header(k, v)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if sendbody and body:
+            self.wfile.write(body)
+
+    def begin(self):
+        with lock:
+            stats["requests"] += 1
+            stats["active"] += 1
+            stats["maxactive"] = max(stats["maxactive"], stats["active"])
+        time.sleep(delay)
+
+    def end(self):
+        with lock:
+            stats["active"] -= 1
+
+    def do_PUT(self):
+        self.begin()
+        try:
+            n = int(self.headers.get("Content-Length", "0"))
+            data = self.rfile.read(n) if n > 0 else b""
+            with lock:
+                objects[self.path] = data
+            self.reply(200)
+        finally:
+            self.end()
+
+    def do_GET(self):
+        if self.path == "/_stats":
+            with lock:
+                text = "connections=%d requests=%d maxactive=%d" % (
+                    stats["connections"], stats["requests"], stats["maxactive"])
+            self.reply(200, text.encode())
+            return
+        self.get(True)
+
+    def do_HEAD(self):
+        self.get(False)
+
+    def get(self, sendbody):
+        self.begin()
+        try:
+            with lock:
+                data = objects.get(self.path)
+            if data is None:
+                self.reply(404)
+                return
+            rng = self.headers.get("Range")
+            if rng is None:
+                self.reply(200, data, sendbody=sendbody)
+                return
+            m = re.match(r"bytes=(\d+)-(\d*)$", rng)
+            if m is None:
+                self.reply(400)
+                return
+            first = int(m.group(1))
+            last = int(m.group(2)) if m.group(2) else len(data) - 1
+            if first >= len(data):
+                self.reply(416, headers={"Content-Range": "bytes */%d" % len(data)})
+                return
+            last = min(last, len(data) - 1)
+            self.reply(206, data[first:last + 1],
+                       {"Content-Range": "bytes %d-%d/%d" % (first, last, len(data))},
+                       sendbody)
+        finally:
+            self.end()
+
+    def do_DELETE(self):
+        self.begin()
+        try:
+            with lock:
+                objects.pop(self.path, None)
+            self.reply(204)
+        finally:
+            self.end()
+
+
+def main():
+    global delay
+    if len(sys.argv) < 2:
+        sys.stderr.write("usage: s3stub.py <portfile> [<delay-seconds>]\n")
+        sys.exit(1)
+    if len(sys.argv) > 2:
+        delay = float(sys.argv[2])
+    server = ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+    server.daemon_threads = True
+    with open(sys.argv[1] + ".tmp", "w") as f:
+        f.write("%d\n" % server.server_address[1])
+    # Publish the port only once it is complete
+    os.replace(sys.argv[1] + ".tmp", sys.argv[1])
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
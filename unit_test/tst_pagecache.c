@@ -0,0 +1,133 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata. See COPYRIGHT file
+   for conditions of use.
+
+   Test the byte-range page cache in ncpagecache.c against an
+   in-memory object, checking both the data returned and the number
+   of ranged requests issued.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "ncpagecache.h"
+#include "err_macros.h"
+
+#define OBJSIZE  ((size_t)100000)
+#define PAGESIZE ((size_t)1000)
+#define MAXPAGES ((size_t)8)
+
+/* The stand-in for the remote object */
+typedef struct Object {
+    unsigned char data[OBJSIZE];
+    int requests;
+} Object;
+
+static int
+memfetch(void* state, size64_t offset, size_t count, void* buf)
+{
+    Object* obj = (Object*)state;
+    if(offset + count > OBJSIZE) return NC_EIO;
+    memcpy(buf,obj->data + offset,count);
+    obj->requests++;
+    return NC_NOERR;
+}
+
+/* Read through the cache and compare with the object */
+static int
+checkread(NCpagecache* cache, Object* obj, size64_t offset, size_t count)
+{
+    unsigned char* buf = malloc(count);
+    int ok;
+    if(buf == NULL) return 0;
+    ok = (ncpagecacheread(cache,offset,count,buf) == NC_NOERR
+          && memcmp(buf,obj->data + offset,count) == 0);
+    free(buf);
+    return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+    static Object obj;
+    NCpagecache* cache = NULL;
+    NCpagestats stats;
+    size_t i;
+
+    for(i=0;i<OBJSIZE;i++) obj.data[i] = (unsigned char)(i * 7 + (i >> 8));
+
+    printf("\n*** Testing byte-range page cache.\n");
+    printf("*** testing hits and coalesced misses...");
+    {
+        obj.requests = 0;
+        if(ncpagecachenew(OBJSIZE,PAGESIZE,MAXPAGES,0,memfetch,&obj,&cache)) ERR;
+        /* pages 2..4 in one request */
+        if(!checkread(cache,&obj,2500,2000)) ERR;
+        if(obj.requests != 1) ERR;
+        /* all cached */
+        if(!checkread(cache,&obj,2000,3000)) ERR;
+        if(obj.requests != 1) ERR;
+        /* pages 1 and 5 missing, 2..4 cached: two requests */
+        if(!checkread(cache,&obj,1500,4000)) ERR;
+        if(obj.requests != 3) ERR;
+        ncpagecachestats(cache,&stats);
+        if(stats.requests != 3 || stats.misses != 5 || stats.hits != 6) ERR;
+        if(stats.bytes != 5 * PAGESIZE) ERR;
+        ncpagecachefree(cache); cache = NULL;
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing sequential readahead...");
+    {
+        obj.requests = 0;
+        if(ncpagecachenew(OBJSIZE,PAGESIZE,MAXPAGES,3,memfetch,&obj,&cache)) ERR;
+        /* first read is not sequential: page 0 only */
+        if(!checkread(cache,&obj,0,100)) ERR;
+        /* continues the previous read: page 1 plus three ahead */
+        if(!checkread(cache,&obj,1000,100)) ERR;
+        if(obj.requests != 2) ERR;
+        for(i=2;i<5;i++)
+            if(!checkread(cache,&obj,i*PAGESIZE+10,500)) ERR;
+        if(obj.requests != 2) ERR;
+        ncpagecachestats(cache,&stats);
+        if(stats.ahead != 3 || stats.hits != 3) ERR;
+        ncpagecachefree(cache); cache = NULL;
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing eviction, the last page and large reads...");
+    {
+        obj.requests = 0;
+        if(ncpagecachenew(OBJSIZE,PAGESIZE,MAXPAGES,2,memfetch,&obj,&cache)) ERR;
+        /* scan the object in odd-sized steps */
+        for(i=0;i<OBJSIZE;i+=777) {
+            size_t n = (OBJSIZE - i < 777 ? OBJSIZE - i : 777);
+            if(!checkread(cache,&obj,i,n)) ERR;
+        }
+        /* the partial last page, then past the end */
+        if(!checkread(cache,&obj,OBJSIZE-10,10)) ERR;
+        {
+            unsigned char b[20];
+            if(ncpagecacheread(cache,OBJSIZE-10,20,b) != NC_EINVAL) ERR;
+        }
+        /* bigger than the cache: one direct request */
+        obj.requests = 0;
+        if(!checkread(cache,&obj,5,(MAXPAGES+1)*PAGESIZE)) ERR;
+        if(obj.requests != 1) ERR;
+        ncpagecachefree(cache); cache = NULL;
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing a disabled cache...");
+    {
+        obj.requests = 0;
+        if(ncpagecachenew(OBJSIZE,PAGESIZE,0,4,memfetch,&obj,&cache)) ERR;
+        if(!checkread(cache,&obj,10,10)) ERR;
+        if(!checkread(cache,&obj,10,10)) ERR;
+        if(obj.requests != 2) ERR;
+        ncpagecachestats(cache,&stats);
+        if(stats.hits != 0 || stats.requests != 2) ERR;
+        ncpagecachefree(cache); cache = NULL;
+    }
+    SUMMARIZE_ERR;
+    FINAL_RESULTS;
+}
@@ -0,0 +1,185 @@
+/* This is part of the netCDF package. Copyright 2018 University
+   Corporation for Atmospheric Research/Unidata. See COPYRIGHT file
+   for conditions of use.
+
+   Test the asynchronous requests of nch5s3comms.c against the local
+   S3 stand-in s3stub.py, checking the data transferred and that the
+   requests of a batch share a few persistent connections.
+
+   usage: tst_s3pool <root url of the stand-in>
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netcdf.h"
+#include "ncrc.h"
+#include "ncs3sdk.h"
+#include "nch5s3comms.h"
+#include "err_macros.h"
+
+#define NOBJECTS 32
+#define NCONNS   4
+#define BASESIZE 1000
+
+static char* urls[NOBJECTS];
+static unsigned char* objects[NOBJECTS];
+static size_t sizes[NOBJECTS];
+
+/* Get the counters of the stand-in */
+static int
+getstats(s3r_t* handle, const char* root, int* connsp, int* requestsp, int* maxactivep)
+{
+    char url[1024];
+    s3r_buf_t reply = {0,NULL};
+    long httpcode = 0;
+    int ok;
+    snprintf(url,sizeof(url),"%s/_stats",root);
+    if(NCH5_s3comms_s3r_readall(handle,url,&reply,&httpcode) || httpcode != 200)
+        return 0;
+    ok = (sscanf((char*)reply.content,"connections=%d requests=%d maxactive=%d",
+                 connsp,requestsp,maxactivep) == 3);
+    free(reply.content);
+    return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char* root;
+    s3r_t* handle = NULL;
+    s3r_request_t reqs[NOBJECTS];
+    int conns0, conns, requests, maxactive;
+    size_t i, j;
+
+    if(argc < 2) {
+        fprintf(stderr,"usage: tst_s3pool <root url>\n");
+        exit(1);
+    }
+    root = argv[1];
+    for(i=0;i<NOBJECTS;i++) {
+        char url[1024];
+        snprintf(url,sizeof(url),"%s/testbucket/tst_s3pool/object%d",root,(int)i);
+        urls[i] = strdup(url);
+        sizes[i] = BASESIZE + 37 * i;
+        objects[i] = malloc(sizes[i]);
+        for(j=0;j<sizes[i];j++) objects[i][j] = (unsigned char)(i * 31 + j * 7 + (j >> 8));
+    }
+
+    printf("\n*** Testing asynchronous S3 requests.\n");
+    if((handle = NCH5_s3comms_s3r_open(root,NCS3UNK,"us-east-1",NULL,NULL)) == NULL) ERR;
+    if(NCH5_s3comms_s3r_setconnections(handle,NCONNS)) ERR;
+    if(!getstats(handle,root,&conns0,&requests,&maxactive)) ERR;
+
+    printf("*** testing concurrent PUTs...");
+    {
+        memset(reqs,0,sizeof(reqs));
+        for(i=0;i<NOBJECTS;i++) {
+            reqs[i].verb = HTTPPUT;
+            reqs[i].url = urls[i];
+            reqs[i].data.count = sizes[i];
+            reqs[i].data.content = objects[i];
+            if(NCH5_s3comms_s3r_submit(handle,&reqs[i])) ERR;
+        }
+        if(NCH5_s3comms_s3r_wait(handle)) ERR;
+        for(i=0;i<NOBJECTS;i++)
+            if(reqs[i].stat != NC_NOERR || reqs[i].httpcode != 200) ERR;
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing concurrent GETs of whole objects...");
+    {
+        memset(reqs,0,sizeof(reqs));
+        for(i=0;i<NOBJECTS;i++) {
+            reqs[i].verb = HTTPGET;
+            reqs[i].url = urls[i];
+            if(NCH5_s3comms_s3r_submit(handle,&reqs[i])) ERR;
+        }
+        if(NCH5_s3comms_s3r_wait(handle)) ERR;
+        for(i=0;i<NOBJECTS;i++) {
+            if(reqs[i].stat != NC_NOERR || reqs[i].httpcode != 200) ERR;
+            if(reqs[i].data.count != sizes[i]) ERR;
+            if(memcmp(reqs[i].data.content,objects[i],sizes[i]) != 0) ERR;
+            free(reqs[i].data.content);
+        }
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing concurrent ranged GETs...");
+    {
+        static unsigned char bufs[NOBJECTS][100];
+        memset(reqs,0,sizeof(reqs));
+        for(i=0;i<NOBJECTS;i++) {
+            reqs[i].verb = HTTPGET;
+            reqs[i].url = urls[i];
+            reqs[i].offset = 10 + i;
+            reqs[i].len = sizeof(bufs[i]);
+            reqs[i].data.content = bufs[i];
+            if(NCH5_s3comms_s3r_submit(handle,&reqs[i])) ERR;
+        }
+        if(NCH5_s3comms_s3r_wait(handle)) ERR;
+        for(i=0;i<NOBJECTS;i++) {
+            if(reqs[i].stat != NC_NOERR || reqs[i].httpcode != 206) ERR;
+            if(reqs[i].data.count != sizeof(bufs[i])) ERR;
+            if(memcmp(bufs[i],objects[i] + 10 + i,sizeof(bufs[i])) != 0) ERR;
+        }
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing missing objects and ranges past the end...");
+    {
+        unsigned char buf[10];
+        char missing[1024];
+        snprintf(missing,sizeof(missing),"%s/testbucket/tst_s3pool/missing",root);
+        memset(reqs,0,sizeof(reqs));
+        /* the range ends past the end: short read */
+        reqs[0].verb = HTTPGET; reqs[0].url = urls[0];
+        reqs[0].offset = sizes[0] - 5; reqs[0].len = 10; reqs[0].data.content = buf;
+        /* the range starts past the end */
+        reqs[1].verb = HTTPGET; reqs[1].url = urls[0];
+        reqs[1].offset = sizes[0] + 5; reqs[1].len = 10; reqs[1].data.content = buf;
+        reqs[2].verb = HTTPGET; reqs[2].url = missing;
+        for(i=0;i<3;i++)
+            if(NCH5_s3comms_s3r_submit(handle,&reqs[i])) ERR;
+        if(NCH5_s3comms_s3r_wait(handle)) ERR;
+        if(reqs[0].stat != NC_NOERR || reqs[0].httpcode != 206 || reqs[0].data.count != 5) ERR;
+        if(reqs[1].stat != NC_NOERR || reqs[1].httpcode != 416) ERR;
+        if(reqs[2].stat != NC_NOERR || reqs[2].httpcode != 404 || reqs[2].data.content != NULL) ERR;
+        /* and the connections are still usable */
+        reqs[0].offset = 0; reqs[0].len = 10;
+        if(NCH5_s3comms_s3r_submit(handle,&reqs[0])) ERR;
+        if(NCH5_s3comms_s3r_wait(handle)) ERR;
+        if(reqs[0].stat != NC_NOERR || memcmp(buf,objects[0],10) != 0) ERR;
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing connection reuse and concurrency...");
+    {
+        if(!getstats(handle,root,&conns,&requests,&maxactive)) ERR;
+        /* about 100 requests over at most NCONNS connections, plus
+           the one used for the statistics */
+        if(conns - conns0 > NCONNS) ERR;
+        if(maxactive < 2 || maxactive > NCONNS) ERR;
+        printf(" (%d connections, %d requests, %d at once)",conns,requests,maxactive);
+    }
+    SUMMARIZE_ERR;
+    printf("*** testing a single connection...");
+    {
+        int maxactive1;
+        if(NCH5_s3comms_s3r_setconnections(handle,1)) ERR;
+        memset(reqs,0,sizeof(reqs));
+        for(i=0;i<8;i++) {
+            reqs[i].verb = HTTPGET;
+            reqs[i].url = urls[i];
+            if(NCH5_s3comms_s3r_submit(handle,&reqs[i])) ERR;
+        }
+        if(NCH5_s3comms_s3r_wait(handle)) ERR;
+        for(i=0;i<8;i++) {
+            if(reqs[i].stat != NC_NOERR || reqs[i].data.count != sizes[i]) ERR;
+            free(reqs[i].data.content);
+        }
+        if(!getstats(handle,root,&conns0,&requests,&maxactive1)) ERR;
+        if(conns0 - conns != 1) ERR;
+    }
+    SUMMARIZE_ERR;
+    if(NCH5_s3comms_s3r_close(handle)) ERR;
+    for(i=0;i<NOBJECTS;i++) {free(urls[i]); free(objects[i]);}
+    FINAL_RESULTS;
+}